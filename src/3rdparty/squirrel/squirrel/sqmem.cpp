@@ -2,8 +2,12 @@
 	see copyright notice in squirrel.h
 */
 #include "sqpcheader.h"
-void *sq_vm_malloc(SQUnsignedInteger size){	return malloc(size); }
 
-void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size){ return realloc(p, size); }
+/* OpenTTD: the memory of the VM that is running is accounted to this counter, when set. */
+SQInteger *_sq_vm_allocated = NULL;
 
-void sq_vm_free(void *p, SQUnsignedInteger size){	free(p); }
+void *sq_vm_malloc(SQUnsignedInteger size){	if (_sq_vm_allocated != NULL) *_sq_vm_allocated += size; return malloc(size); }
+
+void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size){ if (_sq_vm_allocated != NULL) *_sq_vm_allocated += (SQInteger)size - (SQInteger)oldsize; return realloc(p, size); }
+
+void sq_vm_free(void *p, SQUnsignedInteger size){	if (_sq_vm_allocated != NULL) *_sq_vm_allocated -= size; free(p); }
@@ -108,6 +108,9 @@ SQVM::SQVM(SQSharedState *ss)
 	_debughook = _null_;
 	_can_suspend = false;
 	_ops_till_suspend = 0;
+	_profile_hook = NULL;
+	_profile_interval = 0;
+	_profile_countdown = 0;
 	ci = NULL;
 	INIT_CHAIN();ADD_TO_CHAIN(&_ss(this)->_gc_chain,this);
 }
@@ -730,6 +733,10 @@ exception_restore:
 		{
 			DecreaseOps(1);
 			if (ShouldSuspend()) { _suspended = SQTrue; _suspended_traps = traps; return true; }
+			if (_profile_hook != NULL && --_profile_countdown <= 0) {
+				_profile_countdown = _profile_interval;
+				_profile_hook(this);
+			}
 
 			const SQInstruction &_i_ = *ci->_ip++;
 			//dumpstack(_stackbase);
@@ -171,6 +171,11 @@ public:
 	SQBool _can_suspend;
 	SQInteger _ops_till_suspend;
 
+	/* OpenTTD: call _profile_hook every _profile_interval operations, when set. */
+	void (*_profile_hook)(SQVM *v);
+	SQInteger _profile_interval;
+	SQInteger _profile_countdown;
+
 	bool ShouldSuspend()
 	{
 		return _can_suspend && _ops_till_suspend <= 0;
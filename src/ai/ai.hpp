@@ -122,6 +122,38 @@ public:
 	static int GetStartNextTime();
 
 	static char *GetConsoleList(char *p, const char *last);
+
+	/**
+	 * Write the time, operations and memory used by each running AI to a buffer.
+	 * @param p    Where to start writing.
+	 * @param last The last character of the buffer.
+	 * @return The end of the written text.
+	 */
+	static char *GetConsoleUsage(char *p, const char *last);
+
+	/**
+	 * Start recording an opcode profile of the AI of a company.
+	 * @param company  The company of the AI.
+	 * @param interval Number of operations between two samples.
+	 * @return False if the company has no running AI.
+	 */
+	static bool StartProfile(CompanyID company, uint interval);
+
+	/**
+	 * Stop recording the opcode profile of the AI of a company.
+	 * @param company The company of the AI.
+	 */
+	static void StopProfile(CompanyID company);
+
+	/**
+	 * Write the most sampled entries of the opcode profile of the AI of a company to a buffer.
+	 * @param company     The company of the AI.
+	 * @param call_stacks Write the samples per call stack instead of per function and line.
+	 * @param p           Where to start writing.
+	 * @param last        The last character of the buffer.
+	 * @return The end of the written text.
+	 */
+	static char *GetConsoleProfile(CompanyID company, bool call_stacks, char *p, const char *last);
 	static const AIInfoList *GetInfoList();
 	static const AIInfoList *GetUniqueInfoList();
 	static AIInfo *FindInfo(const char *name, int version, bool force_exact_match);
@@ -18,10 +18,14 @@
 #include "../network/network.h"
 #include "../window_func.h"
 #include "../command_func.h"
+#include "../string_func.h"
 #include "ai_scanner.hpp"
 #include "ai_instance.hpp"
+#include "../script/squirrel.hpp"
 #include "ai_config.hpp"
 #include "api/ai_error.hpp"
+#include <algorithm>
+#include <vector>
 
 /* static */ uint AI::frame_counter = 0;
 /* static */ AIScanner *AI::ai_scanner = NULL;
@@ -71,22 +75,47 @@
 	assert(_settings_game.difficulty.competitor_speed <= 4);
 	if ((AI::frame_counter & ((1 << (4 - _settings_game.difficulty.competitor_speed)) - 1)) != 0) return;
 
-	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
+	CompanyID ais[MAX_COMPANIES];
+	uint num_ais = 0;
 	const Company *c;
 	FOR_ALL_COMPANIES(c) {
-		if (c->is_ai) {
-			cur_company.Change(c->index);
+		if (c->is_ai) ais[num_ais++] = c->index;
+	}
+
+	/* When only some AIs may run each tick, take turns: every tick the
+	 * next ones in company order get to run. */
+	uint num_running = _settings_game.ai.ai_max_running_per_tick;
+	uint first = 0;
+	if (num_running == 0 || num_running >= num_ais) {
+		num_running = num_ais;
+	} else {
+		uint ai_frame = AI::frame_counter >> (4 - _settings_game.difficulty.competitor_speed);
+		first = (ai_frame * num_running) % num_ais;
+	}
+
+	/* Occasionally collect garbage; every 255 ticks do one company.
+	 * Effectively collecting garbage once every two months per AI.
+	 * The collection takes the place of that AI's turn, so a big heap
+	 * slows down its own AI instead of adding to the tick. */
+	CompanyID gc_company = INVALID_COMPANY;
+	if ((AI::frame_counter & 255) == 0) gc_company = (CompanyID)GB(AI::frame_counter, 8, 4);
+
+	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
+	for (uint i = 0; i < num_running; i++) {
+		c = Company::GetIfValid(ais[(first + i) % num_ais]);
+		if (c == NULL || !c->is_ai) continue;
+		cur_company.Change(c->index);
+		if (c->index == gc_company) {
+			c->ai_instance->CollectGarbage();
+			gc_company = INVALID_COMPANY;
+		} else {
 			c->ai_instance->GameLoop();
 		}
 	}
 	cur_company.Restore();
 
-	/* Occasionally collect garbage; every 255 ticks do one company.
-	 * Effectively collecting garbage once every two months per AI. */
-	if ((AI::frame_counter & 255) == 0) {
-		CompanyID cid = (CompanyID)GB(AI::frame_counter, 8, 4);
-		if (Company::IsValidAiID(cid)) Company::Get(cid)->ai_instance->CollectGarbage();
-	}
+	/* The AI was not among the ones that ran this tick. */
+	if (Company::IsValidAiID(gc_company)) Company::Get(gc_company)->ai_instance->CollectGarbage();
 }
 
 /* static */ uint AI::GetTick()
@@ -231,6 +260,15 @@
 
 void CcAI(const CommandCost &result, TileIndex tile, uint32 p1, uint32 p2)
 {
+	/* The AI did not wait for commands done in batch mode. They are
+	 * executed in the order they were sent, so this is the oldest one. */
+	uint batched = AIObject::GetBatchedCommands();
+	if (batched != 0) {
+		AIObject::SetBatchedCommands(batched - 1);
+		if (result.Succeeded()) AIObject::IncreaseDoCommandCosts(result.GetCost());
+		return;
+	}
+
 	AIObject::SetLastCommandRes(result.Succeeded());
 
 	if (result.Failed()) {
@@ -288,6 +326,75 @@ void CcAI(const CommandCost &result, TileIndex tile, uint32 p1, uint32 p2)
 	return AI::ai_scanner->GetAIConsoleList(p, last);
 }
 
+/* static */ char *AI::GetConsoleUsage(char *p, const char *last)
+{
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		if (!c->is_ai || c->ai_instance == NULL || c->ai_info == NULL) continue;
+		const AIInstance *instance = c->ai_instance;
+		p += seprintf(p, last, "%2d: %s, %u us/tick (%u%% native), %u ops/tick, %u KiB, %u objects, last garbage collection freed %u in %u ms\n",
+				c->index + 1, c->ai_info->GetName(), instance->GetAverageTickTime(), instance->GetNativeTimeShare(),
+				instance->GetAverageOps(), (uint)(instance->GetAllocatedMemory() >> 10), instance->GetHeapObjects(),
+				instance->GetHeapObjectsFreed(), instance->GetGarbageCollectionTime());
+	}
+	return p;
+}
+
+/* static */ bool AI::StartProfile(CompanyID company, uint interval)
+{
+	if (!Company::IsValidAiID(company) || Company::Get(company)->ai_instance == NULL) return false;
+	return Company::Get(company)->ai_instance->StartProfile(interval);
+}
+
+/* static */ void AI::StopProfile(CompanyID company)
+{
+	if (!Company::IsValidAiID(company) || Company::Get(company)->ai_instance == NULL) return;
+	Company::Get(company)->ai_instance->StopProfile();
+}
+
+/** Sorter for the entries of a profile, the most counted first. */
+static bool ProfileCountSorter(const SquirrelProfile::Counts::const_iterator &a, const SquirrelProfile::Counts::const_iterator &b)
+{
+	return a->second > b->second;
+}
+
+/**
+ * Write the most counted entries of a part of a profile to a buffer.
+ * @param counts The part of the profile.
+ * @param total  The count to compute the share of an entry with.
+ * @param p      Where to start writing.
+ * @param last   The last character of the buffer.
+ * @return The end of the written text.
+ */
+static char *WriteProfileCounts(const SquirrelProfile::Counts &counts, uint total, char *p, const char *last)
+{
+	std::vector<SquirrelProfile::Counts::const_iterator> entries;
+	for (SquirrelProfile::Counts::const_iterator it = counts.begin(); it != counts.end(); it++) entries.push_back(it);
+	std::sort(entries.begin(), entries.end(), ProfileCountSorter);
+
+	for (uint i = 0; i < entries.size() && i < 20; i++) {
+		p += seprintf(p, last, "  %8u %3u%%  %s\n", entries[i]->second, total == 0 ? 0 : entries[i]->second * 100 / total, entries[i]->first.c_str());
+	}
+	if (entries.size() > 20) p += seprintf(p, last, "  ... and %u more\n", (uint)entries.size() - 20);
+	return p;
+}
+
+/* static */ char *AI::GetConsoleProfile(CompanyID company, bool call_stacks, char *p, const char *last)
+{
+	if (!Company::IsValidAiID(company) || Company::Get(company)->ai_instance == NULL) return p;
+	const SquirrelProfile *profile = Company::Get(company)->ai_instance->GetProfile();
+	if (profile == NULL) return p;
+
+	p += seprintf(p, last, "%u samples, one every %u operations\n", profile->samples, profile->interval);
+	p += seprintf(p, last, "%s:\n", call_stacks ? "Samples per call stack" : "Samples per function and line");
+	p = WriteProfileCounts(call_stacks ? profile->call_stacks : profile->functions, profile->samples, p, last);
+
+	uint native_calls = 0;
+	for (SquirrelProfile::Counts::const_iterator it = profile->native_calls.begin(); it != profile->native_calls.end(); it++) native_calls += it->second;
+	p += seprintf(p, last, "Calls per API function (%u in total):\n", native_calls);
+	return WriteProfileCounts(profile->native_calls, native_calls, p, last);
+}
+
 /* static */ const AIInfoList *AI::GetInfoList()
 {
 	return AI::ai_scanner->GetAIInfoList();
@@ -861,9 +861,18 @@ struct AIDebugWindow : public QueryStringBaseWindow {
 				} else {
 					const AIInfo *info = Company::Get(ai_debug_company)->ai_info;
 					assert(info != NULL);
+					const AIInstance *instance = Company::Get(ai_debug_company)->ai_instance;
 					SetDParam(0, STR_AI_DEBUG_NAME_AND_VERSION);
 					SetDParamStr(1, info->GetName());
 					SetDParam(2, info->GetVersion());
+					if (instance != NULL && instance->HasHeapStatistics()) {
+						SetDParam(0, STR_AI_DEBUG_NAME_VERSION_AND_USAGE);
+						SetDParam(3, instance->GetAverageTickTime());
+						SetDParam(4, instance->GetNativeTimeShare());
+						SetDParam(5, instance->GetAverageOps());
+						SetDParam(6, instance->GetAllocatedMemory());
+						SetDParam(7, instance->GetHeapObjects());
+					}
 				}
 				break;
 		}
@@ -13,6 +13,7 @@
 #include "../debug.h"
 #include "../saveload/saveload.h"
 #include "../gui.h"
+#include "../window_func.h"
 
 #include <squirrel.h>
 #include "../script/squirrel.hpp"
@@ -31,6 +32,7 @@
 #include "api/ai_airport.hpp.sq"
 #include "api/ai_base.hpp.sq"
 #include "api/ai_basestation.hpp.sq"
+#include "api/ai_batchmode.hpp.sq"
 #include "api/ai_bridge.hpp.sq"
 #include "api/ai_bridgelist.hpp.sq"
 #include "api/ai_cargo.hpp.sq"
@@ -102,7 +104,11 @@ AIInstance::AIInstance(AIInfo *info) :
 	is_dead(false),
 	is_save_data_on_stack(false),
 	suspend(0),
-	callback(NULL)
+	callback(NULL),
+	heap_objects(0),
+	heap_objects_freed(0),
+	gc_time(0),
+	gc_count(0)
 {
 	/* Set the instance already, so we can use AIObject::Set commands */
 	Company::Get(_current_company)->ai_instance = this;
@@ -112,6 +118,8 @@ AIInstance::AIInstance(AIInfo *info) :
 	this->engine     = new Squirrel();
 	this->engine->SetPrintFunction(&PrintFunc);
 
+	SquirrelAccountingScope accounting(this->engine);
+
 	/* The import method is available at a very early stage */
 	this->engine->AddMethod("import", &AILibrary::Import, 4, ".ssi");
 
@@ -172,6 +180,7 @@ void AIInstance::RegisterAPI()
 	SQAIAirport_Register(this->engine);
 	SQAIBase_Register(this->engine);
 	SQAIBaseStation_Register(this->engine);
+	SQAIBatchMode_Register(this->engine);
 	SQAIBridge_Register(this->engine);
 	SQAIBridgeList_Register(this->engine);
 	SQAIBridgeList_Length_Register(this->engine);
@@ -314,6 +323,14 @@ void AIInstance::GameLoop()
 		this->Died();
 		return;
 	}
+	if (_settings_game.ai.ai_max_memory != 0 && this->engine->GetAllocatedMemory() > (size_t)_settings_game.ai.ai_max_memory << 20) {
+		AILog::Error("This AI uses more memory than is allowed. AI is stopped.");
+		this->Died();
+		return;
+	}
+
+	CPerfStartReal perf(this->run_timer);
+	SquirrelAccountingScope accounting(this->engine);
 	this->controller->ticks++;
 
 	if (this->suspend   < -1) this->suspend++; // Multiplayer suspend, increase up to -1.
@@ -390,9 +407,62 @@ void AIInstance::GameLoop()
 	}
 }
 
-void AIInstance::CollectGarbage() const
+void AIInstance::CollectGarbage()
+{
+	if (!this->is_started || this->IsDead()) return;
+
+	SquirrelAccountingScope accounting(this->engine);
+	CPerformanceTimer timer;
+	timer.Start();
+	int freed = this->engine->CollectGarbage();
+	timer.Stop();
+
+	this->heap_objects_freed = max(freed, 0);
+	this->heap_objects       = this->engine->GetCollectableObjectCount();
+	this->gc_time            = timer.Get(1000);
+	this->gc_count++;
+	SetWindowDirty(WC_AI_DEBUG, 0);
+}
+
+uint AIInstance::GetAverageTickTime() const
+{
+	if (this->controller->ticks == 0) return 0;
+	CPerformanceTimer timer = this->run_timer;
+	return timer.Get(1000000) / this->controller->ticks;
+}
+
+uint AIInstance::GetNativeTimeShare() const
+{
+	if (this->engine == NULL || this->run_timer.m_acc <= 0) return 0;
+	return (uint)min<int64>(this->engine->GetNativeTimer().m_acc * 100 / this->run_timer.m_acc, 100);
+}
+
+uint AIInstance::GetAverageOps() const
+{
+	if (this->engine == NULL || this->controller->ticks == 0) return 0;
+	return (uint)(this->engine->GetOpsExecuted() / this->controller->ticks);
+}
+
+size_t AIInstance::GetAllocatedMemory() const
+{
+	return this->engine == NULL ? 0 : this->engine->GetAllocatedMemory();
+}
+
+bool AIInstance::StartProfile(uint interval)
+{
+	if (this->engine == NULL) return false;
+	this->engine->StartProfile(interval);
+	return true;
+}
+
+void AIInstance::StopProfile()
+{
+	if (this->engine != NULL) this->engine->StopProfile();
+}
+
+const SquirrelProfile *AIInstance::GetProfile() const
 {
-	if (this->is_started && !this->IsDead()) this->engine->CollectGarbage();
+	return this->engine == NULL ? NULL : this->engine->GetProfile();
 }
 
 /* static */ void AIInstance::DoCommandReturn(AIInstance *instance)
@@ -596,6 +666,7 @@ void AIInstance::Save()
 	}
 
 	HSQUIRRELVM vm = this->engine->GetVM();
+	SquirrelAccountingScope accounting(this->engine);
 	if (this->is_save_data_on_stack) {
 		_ai_sl_byte = 1;
 		SlObject(NULL, _ai_byte);
@@ -735,6 +806,7 @@ void AIInstance::Load(int version)
 		return;
 	}
 	HSQUIRRELVM vm = this->engine->GetVM();
+	SquirrelAccountingScope accounting(this->engine);
 
 	SlObject(NULL, _ai_byte);
 	/* Check if there was anything saved at all. */
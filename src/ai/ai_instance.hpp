@@ -13,6 +13,7 @@
 #define AI_INSTANCE_HPP
 
 #include <squirrel.h>
+#include "../pathfinder/pf_performance_timer.hpp"
 
 /**
  * The callback function when an AI suspends.
@@ -70,9 +71,66 @@ public:
 	void GameLoop();
 
 	/**
-	 * Let the VM collect any garbage.
+	 * Let the VM collect any garbage, and update the heap statistics.
 	 */
-	void CollectGarbage() const;
+	void CollectGarbage();
+
+	/**
+	 * Get the number of objects alive after the last garbage collection.
+	 */
+	inline uint GetHeapObjects() const { return this->heap_objects; }
+
+	/**
+	 * Get the number of objects the last garbage collection freed.
+	 */
+	inline uint GetHeapObjectsFreed() const { return this->heap_objects_freed; }
+
+	/**
+	 * Get the time the last garbage collection took, in milliseconds.
+	 */
+	inline uint GetGarbageCollectionTime() const { return this->gc_time; }
+
+	/**
+	 * Whether the garbage of this AI has been collected at least once.
+	 */
+	inline bool HasHeapStatistics() const { return this->gc_count != 0; }
+
+	/**
+	 * Get the average wall time of the ticks this AI ran in, in microseconds.
+	 */
+	uint GetAverageTickTime() const;
+
+	/**
+	 * Get the share of the time this AI ran that was spent in native functions, in percent.
+	 */
+	uint GetNativeTimeShare() const;
+
+	/**
+	 * Get the average number of operations this AI executed per tick.
+	 */
+	uint GetAverageOps() const;
+
+	/**
+	 * Get the number of bytes the VM of this AI has allocated.
+	 */
+	size_t GetAllocatedMemory() const;
+
+	/**
+	 * Start recording an opcode profile of this AI.
+	 * @param interval Number of operations between two samples.
+	 * @return False if the AI is dead.
+	 */
+	bool StartProfile(uint interval);
+
+	/**
+	 * Stop recording the opcode profile of this AI.
+	 */
+	void StopProfile();
+
+	/**
+	 * Get the last opcode profile of this AI, or NULL if there is none.
+	 */
+	const struct SquirrelProfile *GetProfile() const;
 
 	/**
 	 * Get the storage of this AI.
@@ -156,6 +214,12 @@ private:
 	int suspend;
 	AISuspendCallbackProc *callback;
 
+	uint heap_objects;       ///< Number of objects alive after the last garbage collection.
+	uint heap_objects_freed; ///< Number of objects freed by the last garbage collection.
+	uint gc_time;            ///< Milliseconds the last garbage collection took.
+	uint gc_count;           ///< Number of garbage collections done.
+	CPerformanceTimer run_timer; ///< Time spent in GameLoop, including the native functions the AI called.
+
 	/**
 	 * Register all API functions to the VM.
 	 */
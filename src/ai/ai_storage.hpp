@@ -40,6 +40,7 @@ private:
 	class AIObject *mode_instance;   //!< The instance belonging to the current build mode.
 
 	uint delay;                      //!< The ticks of delay each DoCommand has.
+	uint batched_commands;           //!< The commands done in batch mode that are sent, but not yet executed.
 	bool allow_do_command;           //!< Is the usage of DoCommands restricted?
 
 	CommandCost costs;               //!< The costs the AI is tracking.
@@ -65,6 +66,7 @@ public:
 		mode              (NULL),
 		mode_instance     (NULL),
 		delay             (1),
+		batched_commands  (0),
 		allow_do_command  (true),
 		/* costs (can't be set) */
 		last_cost         (0),
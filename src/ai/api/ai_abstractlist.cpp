@@ -50,6 +50,15 @@ public:
 	 * Callback from the list if an item gets removed.
 	 */
 	virtual void Remove(int item) = 0;
+
+protected:
+	/**
+	 * Make sure the buckets of the list can be walked.
+	 */
+	void UpdateBuckets()
+	{
+		this->list->UpdateBuckets();
+	}
 };
 
 /**
@@ -72,6 +81,7 @@ public:
 
 	int32 Begin()
 	{
+		this->UpdateBuckets();
 		if (this->list->buckets.empty()) return 0;
 		this->has_no_more_items = false;
 
@@ -158,6 +168,7 @@ public:
 
 	int32 Begin()
 	{
+		this->UpdateBuckets();
 		if (this->list->buckets.empty()) return 0;
 		this->has_no_more_items = false;
 
@@ -383,6 +394,7 @@ AIAbstractList::AIAbstractList()
 	this->sort_ascending = false;
 	this->initialized    = false;
 	this->modifications  = 0;
+	this->buckets_valid  = true;
 }
 
 AIAbstractList::~AIAbstractList()
@@ -390,9 +402,30 @@ AIAbstractList::~AIAbstractList()
 	delete this->sorter;
 }
 
+void AIAbstractList::UpdateBuckets()
+{
+	if (this->buckets_valid) return;
+
+	for (AIAbstractListMap::iterator iter = this->items.begin(); iter != this->items.end(); iter++) {
+		this->buckets[(*iter).second].insert((*iter).first);
+	}
+	this->buckets_valid = true;
+}
+
+void AIAbstractList::DropUnusedBuckets()
+{
+	if (!this->buckets_valid) return;
+
+	/* The value sorters walk the buckets, so keep them while a walk is going on. */
+	if (this->sorter_type == SORT_BY_VALUE && !this->sorter->IsEnd()) return;
+
+	this->buckets.clear();
+	this->buckets_valid = false;
+}
+
 bool AIAbstractList::HasItem(int32 item)
 {
-	return this->items.count(item) == 1;
+	return this->items.find(item) != this->items.end();
 }
 
 void AIAbstractList::Clear()
@@ -401,6 +434,7 @@ void AIAbstractList::Clear()
 
 	this->items.clear();
 	this->buckets.clear();
+	this->buckets_valid = true;
 	this->sorter->End();
 }
 
@@ -410,22 +444,28 @@ void AIAbstractList::AddItem(int32 item)
 
 	if (this->HasItem(item)) return;
 
+	this->DropUnusedBuckets();
+
 	this->items[item] = 0;
-	this->buckets[0].insert(item);
+	if (this->buckets_valid) this->buckets[0].insert(item);
 }
 
 void AIAbstractList::RemoveItem(int32 item)
 {
 	this->modifications++;
 
-	if (!this->HasItem(item)) return;
+	AIAbstractListMap::iterator item_iter = this->items.find(item);
+	if (item_iter == this->items.end()) return;
 
-	int32 value = this->GetValue(item);
+	int32 value = (*item_iter).second;
 
 	this->sorter->Remove(item);
-	this->buckets[value].erase(item);
-	if (this->buckets[value].empty()) this->buckets.erase(value);
-	this->items.erase(item);
+	if (this->buckets_valid) {
+		AIAbstractListBucket::iterator bucket_iter = this->buckets.find(value);
+		(*bucket_iter).second.erase(item);
+		if ((*bucket_iter).second.empty()) this->buckets.erase(bucket_iter);
+	}
+	this->items.erase(item_iter);
 }
 
 int32 AIAbstractList::Begin()
@@ -464,25 +504,32 @@ int32 AIAbstractList::Count()
 
 int32 AIAbstractList::GetValue(int32 item)
 {
-	if (!this->HasItem(item)) return 0;
+	AIAbstractListMap::const_iterator item_iter = this->items.find(item);
+	if (item_iter == this->items.end()) return 0;
 
-	return this->items[item];
+	return (*item_iter).second;
 }
 
 bool AIAbstractList::SetValue(int32 item, int32 value)
 {
 	this->modifications++;
 
-	if (!this->HasItem(item)) return false;
+	AIAbstractListMap::iterator item_iter = this->items.find(item);
+	if (item_iter == this->items.end()) return false;
 
-	int32 value_old = this->GetValue(item);
+	int32 value_old = (*item_iter).second;
 	if (value_old == value) return true;
 
+	this->DropUnusedBuckets();
+
 	this->sorter->Remove(item);
-	this->buckets[value_old].erase(item);
-	if (this->buckets[value_old].empty()) this->buckets.erase(value_old);
-	this->items[item] = value;
-	this->buckets[value].insert(item);
+	if (this->buckets_valid) {
+		AIAbstractListBucket::iterator bucket_iter = this->buckets.find(value_old);
+		(*bucket_iter).second.erase(item);
+		if ((*bucket_iter).second.empty()) this->buckets.erase(bucket_iter);
+		this->buckets[value].insert(item);
+	}
+	(*item_iter).second = value;
 
 	return true;
 }
@@ -584,6 +631,7 @@ void AIAbstractList::RemoveTop(int32 count)
 	switch (this->sorter_type) {
 		default: NOT_REACHED();
 		case SORT_BY_VALUE:
+			this->UpdateBuckets();
 			for (AIAbstractListBucket::iterator iter = this->buckets.begin(); iter != this->buckets.end(); iter = this->buckets.begin()) {
 				AIItemList *items = &(*iter).second;
 				size_t size = items->size();
@@ -621,6 +669,7 @@ void AIAbstractList::RemoveBottom(int32 count)
 	switch (this->sorter_type) {
 		default: NOT_REACHED();
 		case SORT_BY_VALUE:
+			this->UpdateBuckets();
 			for (AIAbstractListBucket::reverse_iterator iter = this->buckets.rbegin(); iter != this->buckets.rend(); iter = this->buckets.rbegin()) {
 				AIItemList *items = &(*iter).second;
 				size_t size = items->size();
@@ -43,6 +43,20 @@ private:
 	bool sort_ascending;          //!< Whether to sort ascending or descending
 	bool initialized;             //!< Whether an iteration has been started
 	int modifications;            //!< Number of modification that has been done. To prevent changing data while valuating.
+	bool buckets_valid;           //!< Whether #buckets matches #items; they are only kept up to date while walking the list by value.
+
+	friend class AIAbstractListSorter;
+
+	/**
+	 * Fill the buckets from the items, if they are not up to date.
+	 */
+	void UpdateBuckets();
+
+	/**
+	 * Forget the buckets, unless the list is being walked by value at the moment.
+	 * Called before changes that would have to allocate in the buckets.
+	 */
+	void DropUnusedBuckets();
 
 public:
 	typedef std::set<int32> AIItemList;                       //!< The list of items inside the bucket
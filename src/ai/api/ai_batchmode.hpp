@@ -0,0 +1,63 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file ai_batchmode.hpp Switch the AI to Batch Mode. */
+
+#ifndef AI_BATCHMODE_HPP
+#define AI_BATCHMODE_HPP
+
+#include "ai_object.hpp"
+
+/**
+ * Class to switch current mode to Batch Mode.
+ * If you create an instance of this class, the mode will be switched to
+ *   Batch. The original mode is stored and recovered from when ever the
+ *   instance is destroyed.
+ * In Batch mode all commands you do are executed for real, like in Execute
+ *   mode, but your AI is not suspended after each command. This allows you
+ *   to do many commands, for example all pieces of a rail line, in a single
+ *   tick.
+ * In single player the result of each command is final. In multiplayer the
+ *   commands are sent to the server without waiting for the result, so the
+ *   result and costs you get are those of the test run before sending it;
+ *   the server executes the commands in the order you did them.
+ * Commands that return something other than success, like the ID of a new
+ *   vehicle, sign or group, still wait till they are executed.
+ */
+class AIBatchMode : public AIObject {
+friend class AIObject;
+public:
+	static const char *GetClassName() { return "AIBatchMode"; }
+
+private:
+	AIModeProc *last_mode;
+	AIObject *last_instance;
+
+protected:
+	/**
+	 * The callback proc for Batch mode.
+	 */
+	static bool ModeProc();
+
+public:
+	/**
+	 * Creating instance of this class switches the build mode to Batch.
+	 * @note When the instance is destroyed, he restores the mode that was
+	 *   current when the instance was created!
+	 */
+	AIBatchMode();
+
+	/**
+	 * Destroying this instance reset the building mode to the mode it was
+	 *   in when the instance was created.
+	 */
+	~AIBatchMode();
+};
+
+#endif /* AI_BATCHMODE_HPP */
@@ -19,10 +19,16 @@
  * 1.1.0 is not yet released. The following changes are not set in stone yet.
  *
  * API additions:
+ * \li AIBatchMode
  * \li IsEnd for all lists.
  * \li AIIndustry::GetIndustryID
  * \li AIIndustryType::INDUSTRYTYPE_TOWN
  * \li AIIndustryType::INDUSTRYTYPE_UNKNOWN
+ * \li AIStation::GetCargoLoaded
+ * \li AIStation::GetCargoDelivered
+ * \li AIStation::GetCargoTransferred
+ * \li AITileList::KeepNative
+ * \li AITileList::ValuateNative
  *
  * API removals:
  * \li HasNext for all lists.
@@ -17,6 +17,7 @@
 #include "../ai_storage.hpp"
 #include "../ai_instance.hpp"
 #include "ai_error.hpp"
+#include "ai_batchmode.hpp"
 
 static AIStorage *GetStorage()
 {
@@ -34,6 +35,16 @@ uint AIObject::GetDoCommandDelay()
 	return GetStorage()->delay;
 }
 
+uint AIObject::GetBatchedCommands()
+{
+	return GetStorage()->batched_commands;
+}
+
+void AIObject::SetBatchedCommands(uint count)
+{
+	GetStorage()->batched_commands = count;
+}
+
 void AIObject::SetDoCommandMode(AIModeProc *proc, AIObject *instance)
 {
 	GetStorage()->mode = proc;
@@ -203,12 +214,16 @@ bool AIObject::DoCommand(TileIndex tile, uint32 p1, uint32 p2, uint cmd, const c
 		throw AI_FatalError("You are not allowed to execute any DoCommand (even indirect) in your constructor, Save(), Load(), and any valuator.");
 	}
 
-	/* Set the default callback to return a true/false result of the DoCommand */
-	if (callback == NULL) callback = &AIInstance::DoCommandReturn;
-
 	/* Are we only interested in the estimate costs? */
 	bool estimate_only = GetDoCommandMode() != NULL && !GetDoCommandMode()();
 
+	/* In batch mode we do not wait for the command, unless its result
+	 * has to be read by a callback after it is executed. */
+	bool batched = GetDoCommandMode() == &AIBatchMode::ModeProc && callback == NULL;
+
+	/* Set the default callback to return a true/false result of the DoCommand */
+	if (callback == NULL) callback = &AIInstance::DoCommandReturn;
+
 	/* Try to perform the command. */
 	CommandCost res = ::DoCommandPInternal(tile, p1, p2, cmd, _networking ? CcAI : NULL, text, false, estimate_only);
 
@@ -231,6 +246,16 @@ bool AIObject::DoCommand(TileIndex tile, uint32 p1, uint32 p2, uint cmd, const c
 	SetLastCost(res.GetCost());
 	SetLastCommandRes(true);
 
+	if (batched) {
+		if (_networking) {
+			/* CcAI will see the result of this command; it must not wake us. */
+			SetBatchedCommands(GetBatchedCommands() + 1);
+		} else {
+			IncreaseDoCommandCosts(res.GetCost());
+		}
+		return true;
+	}
+
 	if (_networking) {
 		/* Suspend the AI till the command is really executed. */
 		throw AI_VMSuspend(-(int)GetDoCommandDelay(), callback);
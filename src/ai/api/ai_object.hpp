@@ -114,6 +114,16 @@ protected:
 	 */
 	static uint GetDoCommandDelay();
 
+	/**
+	 * Get the number of commands done in batch mode that are still on their way to the server.
+	 */
+	static uint GetBatchedCommands();
+
+	/**
+	 * Set the number of commands done in batch mode that are still on their way to the server.
+	 */
+	static void SetBatchedCommands(uint count);
+
 	/**
 	 * Get the latest result of a DoCommand.
 	 */
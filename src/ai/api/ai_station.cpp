@@ -47,6 +47,30 @@
 	return ::ToPercent8(::Station::Get(station_id)->goods[cargo_id].rating);
 }
 
+/* static */ int32 AIStation::GetCargoLoaded(StationID station_id, CargoID cargo_id)
+{
+	if (!IsValidStation(station_id)) return -1;
+	if (!AICargo::IsValidCargo(cargo_id)) return -1;
+
+	return ::Station::Get(station_id)->goods[cargo_id].flow.Get(1).loaded;
+}
+
+/* static */ int32 AIStation::GetCargoDelivered(StationID station_id, CargoID cargo_id)
+{
+	if (!IsValidStation(station_id)) return -1;
+	if (!AICargo::IsValidCargo(cargo_id)) return -1;
+
+	return ::Station::Get(station_id)->goods[cargo_id].flow.Get(1).delivered;
+}
+
+/* static */ int32 AIStation::GetCargoTransferred(StationID station_id, CargoID cargo_id)
+{
+	if (!IsValidStation(station_id)) return -1;
+	if (!AICargo::IsValidCargo(cargo_id)) return -1;
+
+	return ::Station::Get(station_id)->goods[cargo_id].flow.Get(1).transferred;
+}
+
 /* static */ int32 AIStation::GetCoverageRadius(AIStation::StationType station_type)
 {
 	if (station_type == STATION_AIRPORT) {
@@ -89,6 +89,37 @@ public:
 	 */
 	static int32 GetCargoRating(StationID station_id, CargoID cargo_id);
 
+	/**
+	 * See how much cargo has been loaded into vehicles at a station last month.
+	 * @param station_id The station to get the amount of.
+	 * @param cargo_id The cargo to get the amount of.
+	 * @pre IsValidStation(station_id).
+	 * @pre IsValidCargo(cargo_id).
+	 * @return The amount of units loaded last month.
+	 */
+	static int32 GetCargoLoaded(StationID station_id, CargoID cargo_id);
+
+	/**
+	 * See how much cargo has been delivered to its destination at a station last month.
+	 * @param station_id The station to get the amount of.
+	 * @param cargo_id The cargo to get the amount of.
+	 * @pre IsValidStation(station_id).
+	 * @pre IsValidCargo(cargo_id).
+	 * @return The amount of units delivered last month.
+	 */
+	static int32 GetCargoDelivered(StationID station_id, CargoID cargo_id);
+
+	/**
+	 * See how much cargo has been unloaded to wait at a station last month,
+	 * either by a transfer or by a forced unload.
+	 * @param station_id The station to get the amount of.
+	 * @param cargo_id The cargo to get the amount of.
+	 * @pre IsValidStation(station_id).
+	 * @pre IsValidCargo(cargo_id).
+	 * @return The amount of units transferred last month.
+	 */
+	static int32 GetCargoTransferred(StationID station_id, CargoID cargo_id);
+
 	/**
 	 * Get the coverage radius of this type of station.
 	 * @param station_type The type of station.
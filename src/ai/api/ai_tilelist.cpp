@@ -11,8 +11,11 @@
 
 #include "ai_tilelist.hpp"
 #include "ai_industry.hpp"
+#include "ai_tile.hpp"
+#include "../../script/squirrel.hpp"
 #include "../../industry.h"
 #include "../../station_base.h"
+#include "../../core/smallvec_type.hpp"
 
 void AITileList::AddRectangle(TileIndex t1, TileIndex t2)
 {
@@ -30,6 +33,125 @@ void AITileList::AddTile(TileIndex tile)
 	this->AddItem(tile);
 }
 
+/** Number of params, besides the tile, of each AITileList::TileValuator. */
+static const byte _tile_valuator_params[] = {
+	0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 4, 1, 1,
+};
+assert_compile(lengthof(_tile_valuator_params) == AITileList::VALUATOR_END);
+
+/**
+ * Get the value of a single tile for a native valuator.
+ * @param valuator The AITile function to call.
+ * @param tile The tile to valuate.
+ * @param p The params of the function, besides the tile.
+ * @return The value of the tile.
+ */
+static int32 GetNativeTileValue(AITileList::TileValuator valuator, TileIndex tile, const SQInteger *p)
+{
+	switch (valuator) {
+		default: NOT_REACHED();
+		case AITileList::VALUATOR_IS_BUILDABLE:           return AITile::IsBuildable(tile);
+		case AITileList::VALUATOR_IS_BUILDABLE_RECTANGLE: return AITile::IsBuildableRectangle(tile, p[0], p[1]);
+		case AITileList::VALUATOR_IS_WATER_TILE:          return AITile::IsWaterTile(tile);
+		case AITileList::VALUATOR_IS_COAST_TILE:          return AITile::IsCoastTile(tile);
+		case AITileList::VALUATOR_IS_STATION_TILE:        return AITile::IsStationTile(tile);
+		case AITileList::VALUATOR_HAS_TREE_ON_TILE:       return AITile::HasTreeOnTile(tile);
+		case AITileList::VALUATOR_IS_FARM_TILE:           return AITile::IsFarmTile(tile);
+		case AITileList::VALUATOR_IS_ROCK_TILE:           return AITile::IsRockTile(tile);
+		case AITileList::VALUATOR_IS_ROUGH_TILE:          return AITile::IsRoughTile(tile);
+		case AITileList::VALUATOR_IS_SNOW_TILE:           return AITile::IsSnowTile(tile);
+		case AITileList::VALUATOR_IS_DESERT_TILE:         return AITile::IsDesertTile(tile);
+		case AITileList::VALUATOR_GET_SLOPE:              return AITile::GetSlope(tile);
+		case AITileList::VALUATOR_GET_MIN_HEIGHT:         return AITile::GetMinHeight(tile);
+		case AITileList::VALUATOR_GET_MAX_HEIGHT:         return AITile::GetMaxHeight(tile);
+		case AITileList::VALUATOR_GET_OWNER:              return AITile::GetOwner(tile);
+		case AITileList::VALUATOR_GET_CARGO_ACCEPTANCE:   return AITile::GetCargoAcceptance(tile, p[0], p[1], p[2], p[3]);
+		case AITileList::VALUATOR_GET_CARGO_PRODUCTION:   return AITile::GetCargoProduction(tile, p[0], p[1], p[2], p[3]);
+		case AITileList::VALUATOR_GET_DISTANCE_MANHATTAN: return AITile::GetDistanceManhattanToTile(tile, p[0]);
+		case AITileList::VALUATOR_GET_DISTANCE_SQUARE:    return AITile::GetDistanceSquareToTile(tile, p[0]);
+	}
+}
+
+/**
+ * Read a native valuator and its params from the stack of the VM.
+ * @param vm The VM to read from.
+ * @param first The stack index of the valuator; its params follow it, up to the top of the stack.
+ * @param valuator Where to store the valuator.
+ * @param params Where to store the params of the valuator.
+ * @return The error to return to the script, or 0 when valuator and params are valid.
+ */
+static SQInteger GetNativeTileValuator(HSQUIRRELVM vm, int first, AITileList::TileValuator *valuator, SQInteger *params)
+{
+	int nparam = sq_gettop(vm) - first + 1;
+	if (nparam < 1 || sq_gettype(vm, first) != OT_INTEGER) {
+		return sq_throwerror(vm, _SC("the valuator has an invalid type (expected integer)"));
+	}
+	SQInteger value;
+	sq_getinteger(vm, first, &value);
+	if (value < 0 || value >= AITileList::VALUATOR_END) {
+		return sq_throwerror(vm, _SC("the valuator is not a valid valuator"));
+	}
+	if (nparam - 1 != _tile_valuator_params[value]) {
+		return sq_throwerror(vm, _SC("wrong number of parameters for this valuator"));
+	}
+
+	for (int i = 0; i < nparam - 1; i++) {
+		if (sq_gettype(vm, first + i + 1) != OT_INTEGER) {
+			return sq_throwerror(vm, _SC("parameters of a valuator must be integers"));
+		}
+		sq_getinteger(vm, first + i + 1, &params[i]);
+	}
+	*valuator = (AITileList::TileValuator)value;
+	return 0;
+}
+
+SQInteger AITileList::ValuateNative(HSQUIRRELVM vm)
+{
+	/* The first parameter is the instance of AITileList. */
+	TileValuator valuator;
+	SQInteger params[4];
+	SQInteger ret = GetNativeTileValuator(vm, 2, &valuator, params);
+	if (ret != 0) return ret;
+
+	for (AIAbstractListMap::iterator iter = this->items.begin(); iter != this->items.end(); iter++) {
+		this->SetValue((*iter).first, GetNativeTileValue(valuator, (*iter).first, params));
+	}
+
+	/* Charge for the work, but a lot less than calling the function from the script. */
+	Squirrel::DecreaseOps(vm, this->Count());
+
+	return 0;
+}
+
+SQInteger AITileList::KeepNative(HSQUIRRELVM vm)
+{
+	/* The first parameter is the instance of AITileList. */
+	if (sq_gettop(vm) < 4 || sq_gettype(vm, 2) != OT_INTEGER || sq_gettype(vm, 3) != OT_INTEGER) {
+		return sq_throwerror(vm, _SC("the range of values to keep has an invalid type (expected integers)"));
+	}
+	SQInteger min_value, max_value;
+	sq_getinteger(vm, 2, &min_value);
+	sq_getinteger(vm, 3, &max_value);
+
+	TileValuator valuator;
+	SQInteger params[4];
+	SQInteger ret = GetNativeTileValuator(vm, 4, &valuator, params);
+	if (ret != 0) return ret;
+
+	/* Collect the tiles first, as removing them while walking the items would invalidate the iterator. */
+	int count = this->Count();
+	SmallVector<TileIndex, 64> remove;
+	for (AIAbstractListMap::iterator iter = this->items.begin(); iter != this->items.end(); iter++) {
+		int32 value = GetNativeTileValue(valuator, (*iter).first, params);
+		if (value < min_value || value > max_value) *remove.Append() = (*iter).first;
+	}
+	for (const TileIndex *tile = remove.Begin(); tile != remove.End(); tile++) this->RemoveItem(*tile);
+
+	/* Charge for the work, but a lot less than calling the function from the script. */
+	Squirrel::DecreaseOps(vm, count);
+	return 0;
+}
+
 void AITileList::RemoveRectangle(TileIndex t1, TileIndex t2)
 {
 	if (!::IsValidTile(t1)) return;
@@ -23,6 +23,33 @@ class AITileList : public AIAbstractList {
 public:
 	static const char *GetClassName() { return "AITileList"; }
 
+	/**
+	 * The AITile functions that can be used with ValuateNative.
+	 */
+	enum TileValuator {
+		/* Note: these values represent part of the in-game API; do not change their order. */
+		VALUATOR_IS_BUILDABLE,           //!< AITile::IsBuildable(tile)
+		VALUATOR_IS_BUILDABLE_RECTANGLE, //!< AITile::IsBuildableRectangle(tile, width, height)
+		VALUATOR_IS_WATER_TILE,          //!< AITile::IsWaterTile(tile)
+		VALUATOR_IS_COAST_TILE,          //!< AITile::IsCoastTile(tile)
+		VALUATOR_IS_STATION_TILE,        //!< AITile::IsStationTile(tile)
+		VALUATOR_HAS_TREE_ON_TILE,       //!< AITile::HasTreeOnTile(tile)
+		VALUATOR_IS_FARM_TILE,           //!< AITile::IsFarmTile(tile)
+		VALUATOR_IS_ROCK_TILE,           //!< AITile::IsRockTile(tile)
+		VALUATOR_IS_ROUGH_TILE,          //!< AITile::IsRoughTile(tile)
+		VALUATOR_IS_SNOW_TILE,           //!< AITile::IsSnowTile(tile)
+		VALUATOR_IS_DESERT_TILE,         //!< AITile::IsDesertTile(tile)
+		VALUATOR_GET_SLOPE,              //!< AITile::GetSlope(tile)
+		VALUATOR_GET_MIN_HEIGHT,         //!< AITile::GetMinHeight(tile)
+		VALUATOR_GET_MAX_HEIGHT,         //!< AITile::GetMaxHeight(tile)
+		VALUATOR_GET_OWNER,              //!< AITile::GetOwner(tile)
+		VALUATOR_GET_CARGO_ACCEPTANCE,   //!< AITile::GetCargoAcceptance(tile, cargo_type, width, height, radius)
+		VALUATOR_GET_CARGO_PRODUCTION,   //!< AITile::GetCargoProduction(tile, cargo_type, width, height, radius)
+		VALUATOR_GET_DISTANCE_MANHATTAN, //!< AITile::GetDistanceManhattanToTile(tile, tile_to)
+		VALUATOR_GET_DISTANCE_SQUARE,    //!< AITile::GetDistanceSquareToTile(tile, tile_to)
+		VALUATOR_END,                    //!< End marker, not a valid valuator.
+	};
+
 	/**
 	 * Adds the rectangle between tile_from and tile_to to the to-be-evaluated tiles.
 	 * @param tile_from One corner of the tiles to add.
@@ -54,6 +81,62 @@ public:
 	 * @pre AIMap::IsValidTile(tile).
 	 */
 	void RemoveTile(TileIndex tile);
+
+#ifndef DOXYGEN_SKIP
+	/**
+	 * The ValuateNative() wrapper from Squirrel.
+	 */
+	SQInteger ValuateNative(HSQUIRRELVM vm);
+#else
+	/**
+	 * Give all tiles a value defined by one of the AITile functions, without
+	 *  calling back into the script for every tile. This gives the same values
+	 *  as calling Valuate with the AITile function, but is a lot faster.
+	 * @param valuator The function to valuate the tiles with.
+	 * @param params The params to give to the function, minus the first
+	 *  param, which is always the tile being valuated.
+	 * @pre valuator < VALUATOR_END.
+	 * @pre The number of params matches the function of the valuator.
+	 * @note Example:
+	 *  list.ValuateNative(AITileList.VALUATOR_IS_BUILDABLE);
+	 *  list.ValuateNative(AITileList.VALUATOR_IS_BUILDABLE_RECTANGLE, 4, 3);
+	 *  list.ValuateNative(AITileList.VALUATOR_GET_DISTANCE_MANHATTAN, town_tile);
+	 */
+	void ValuateNative(TileValuator valuator, int params, ...);
+#endif /* DOXYGEN_SKIP */
+
+#ifndef DOXYGEN_SKIP
+	/**
+	 * The KeepNative() wrapper from Squirrel.
+	 */
+	SQInteger KeepNative(HSQUIRRELVM vm);
+#else
+	/**
+	 * Keep only the tiles for which one of the AITile functions gives a value
+	 *  between min_value and max_value, without calling back into the script
+	 *  for every tile. The values of the kept tiles are not changed, and the
+	 *  list is not sorted in between, so several KeepNative calls in a row
+	 *  replace a Valuate and KeepBetweenValue pass each, while only the tiles
+	 *  that are still in the list are checked by the later calls. Therefore
+	 *  it pays to do the cheap checks first.
+	 * @param min_value The lowest value to keep.
+	 * @param max_value The highest value to keep.
+	 * @param valuator The function to check the tiles with.
+	 * @param params The params to give to the function, minus the first
+	 *  param, which is always the tile being checked.
+	 * @pre valuator < VALUATOR_END.
+	 * @pre The number of params matches the function of the valuator.
+	 * @note Example, the buildable flat tiles near town_tile that accept at
+	 *  least 8 of cargo for a station of 1x1 with radius 3:
+	 *  local list = AITileList();
+	 *  list.AddRectangle(town_tile - AIMap.GetTileIndex(10, 10), town_tile + AIMap.GetTileIndex(10, 10));
+	 *  list.KeepNative(1, 1, AITileList.VALUATOR_IS_BUILDABLE);
+	 *  list.KeepNative(AITile.SLOPE_FLAT, AITile.SLOPE_FLAT, AITileList.VALUATOR_GET_SLOPE);
+	 *  list.KeepNative(0, 10 * 10, AITileList.VALUATOR_GET_DISTANCE_SQUARE, town_tile);
+	 *  list.KeepNative(8, 1 << 30, AITileList.VALUATOR_GET_CARGO_ACCEPTANCE, cargo, 1, 1, 3);
+	 */
+	void KeepNative(int32 min_value, int32 max_value, TileValuator valuator, int params, ...);
+#endif /* DOXYGEN_SKIP */
 };
 
 /**
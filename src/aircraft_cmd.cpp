@@ -76,7 +76,7 @@ static const byte _airport_terminal_state[] = {2, 3, 4, 5, 6, 7, 19, 20, 0, 0, 8
 static const byte _airport_terminal_flag[] =  {0, 1, 2, 3, 4, 5, 22, 23, 0, 0, 6, 7, 24, 25};
 
 static bool AirportMove(Aircraft *v, const AirportFTAClass *apc);
-static bool AirportSetBlocks(Aircraft *v, const AirportFTA *current_pos, const AirportFTAClass *apc);
+static bool AirportSetBlocks(Aircraft *v, const AirportFTAMove *move);
 static bool AirportHasBlock(Aircraft *v, const AirportFTA *current_pos, const AirportFTAClass *apc);
 static bool AirportFindFreeTerminal(Aircraft *v, const AirportFTAClass *apc);
 static bool AirportFindFreeHelipad(Aircraft *v, const AirportFTAClass *apc);
@@ -370,12 +370,14 @@ CommandCost CmdBuildAircraft(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 		}
 
 		InvalidateWindowData(WC_VEHICLE_DEPOT, v->tile);
-		InvalidateWindowClassesData(WC_AIRCRAFT_LIST, 0);
+		InvalidateVehicleListsOfVehicle(v);
 		SetWindowDirty(WC_COMPANY, v->owner);
 		if (IsLocalCompany())
 			InvalidateAutoreplaceWindow(v->engine_type, v->group_id); // updates the replace Aircraft window
 
-		Company::Get(_current_company)->num_engines[eid]++;
+		Company *c = Company::Get(_current_company);
+		c->num_engines[eid]++;
+		c->num_vehicles[v->type]++;
 	}
 
 	return value;
@@ -489,7 +491,7 @@ CommandCost CmdRefitAircraft(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 		v->colourmap = PAL_NONE; // invalidate vehicle colour map
 		SetWindowDirty(WC_VEHICLE_DETAILS, v->index);
 		SetWindowDirty(WC_VEHICLE_DEPOT, v->tile);
-		InvalidateWindowClassesData(WC_AIRCRAFT_LIST, 0);
+		InvalidateVehicleListsOfVehicle(v);
 	}
 	v->InvalidateNewGRFCacheOfChain(); // always invalidate; querycost might have filled it
 
@@ -1679,30 +1681,18 @@ static bool AirportMove(Aircraft *v, const AirportFTAClass *apc)
 
 	v->previous_pos = v->pos; // save previous location
 
-	/* there is only one choice to move to */
-	if (current->next == NULL) {
-		if (AirportSetBlocks(v, current, apc)) {
-			v->pos = current->next_position;
-			UpdateAircraftCache(v);
-		} // move to next position
-		return false;
+	/* the only choice, or the first one that matches our heading */
+	const AirportFTAMove *move = apc->GetMove(v->pos, v->state);
+	if (move->next_position == MAX_ELEMENTS) {
+		DEBUG(misc, 0, "[Ap] cannot move further on Airport! (pos %d state %d) for vehicle %d", v->pos, v->state, v->index);
+		NOT_REACHED();
 	}
 
-	/* there are more choices to choose from, choose the one that
-	 * matches our heading */
-	do {
-		if (v->state == current->heading || current->heading == TO_ALL) {
-			if (AirportSetBlocks(v, current, apc)) {
-				v->pos = current->next_position;
-				UpdateAircraftCache(v);
-			} // move to next position
-			return false;
-		}
-		current = current->next;
-	} while (current != NULL);
-
-	DEBUG(misc, 0, "[Ap] cannot move further on Airport! (pos %d state %d) for vehicle %d", v->pos, v->state, v->index);
-	NOT_REACHED();
+	if (AirportSetBlocks(v, move)) {
+		v->pos = move->next_position;
+		UpdateAircraftCache(v);
+	} // move to next position
+	return false;
 }
 
 /*  returns true if the road ahead is busy, eg. you must wait before proceeding */
@@ -1733,45 +1723,22 @@ static bool AirportHasBlock(Aircraft *v, const AirportFTA *current_pos, const Ai
 /**
  * "reserve" a block for the plane
  * @param v airplane that requires the operation
- * @param current_pos of the vehicle in the list of blocks
- * @param apc airport on which block is requsted to be set
+ * @param move the move the airplane wants to make
  * @returns true on success. Eg, next block was free and we have occupied it
  */
-static bool AirportSetBlocks(Aircraft *v, const AirportFTA *current_pos, const AirportFTAClass *apc)
+static bool AirportSetBlocks(Aircraft *v, const AirportFTAMove *move)
 {
-	const AirportFTA *next = &apc->layout[current_pos->next_position];
-	const AirportFTA *reference = &apc->layout[v->pos];
-
-	/* if the next position is in another block, check it and wait until it is free */
-	if ((apc->layout[current_pos->position].block & next->block) != next->block) {
-		uint64 airport_flags = next->block;
-		/* search for all all elements in the list with the same state, and blocks != N
-		 * this means more blocks should be checked/set */
-		const AirportFTA *current = current_pos;
-		if (current == reference) current = current->next;
-		while (current != NULL) {
-			if (current->heading == current_pos->heading && current->block != 0) {
-				airport_flags |= current->block;
-				break;
-			}
-			current = current->next;
-		};
-
-		/* if the block to be checked is in the next position, then exclude that from
-		 * checking, because it has been set by the airplane before */
-		if (current_pos->block == next->block) airport_flags ^= next->block;
-
-		Station *st = Station::Get(v->targetairport);
-		if (st->airport.flags & airport_flags) {
-			v->cur_speed = 0;
-			v->subspeed = 0;
-			return false;
-		}
+	/* if the next position is in another block, wait until it is free */
+	if (move->check_blocks == 0 && move->set_blocks == 0) return true;
 
-		if (next->block != NOTHING_block) {
-			SETBITS(st->airport.flags, airport_flags); // occupy next block
-		}
+	Station *st = Station::Get(v->targetairport);
+	if (st->airport.flags & move->check_blocks) {
+		v->cur_speed = 0;
+		v->subspeed = 0;
+		return false;
 	}
+
+	SETBITS(st->airport.flags, move->set_blocks); // occupy next block
 	return true;
 }
 
@@ -1789,15 +1756,6 @@ static bool FreeTerminal(Aircraft *v, byte i, byte last_terminal)
 	return false;
 }
 
-static uint GetNumTerminals(const AirportFTAClass *apc)
-{
-	uint num = 0;
-
-	for (uint i = apc->terminals[0]; i > 0; i--) num += apc->terminals[i];
-
-	return num;
-}
-
 static bool AirportFindFreeTerminal(Aircraft *v, const AirportFTAClass *apc)
 {
 	/* example of more terminalgroups
@@ -1842,16 +1800,7 @@ static bool AirportFindFreeTerminal(Aircraft *v, const AirportFTAClass *apc)
 	}
 
 	/* if there is only 1 terminalgroup, all terminals are checked (starting from 0 to max) */
-	return FreeTerminal(v, 0, GetNumTerminals(apc));
-}
-
-static uint GetNumHelipads(const AirportFTAClass *apc)
-{
-	uint num = 0;
-
-	for (uint i = apc->helipads[0]; i > 0; i--) num += apc->helipads[i];
-
-	return num;
+	return FreeTerminal(v, 0, apc->nofterminals);
 }
 
 
@@ -1894,7 +1843,7 @@ static bool AirportFindFreeHelipad(Aircraft *v, const AirportFTAClass *apc)
 	} else {
 		/* only 1 helicoptergroup, check all helipads
 		 * The blocks for helipads start after the last terminal (MAX_TERMINALS) */
-		return FreeTerminal(v, MAX_TERMINALS, GetNumHelipads(apc) + MAX_TERMINALS);
+		return FreeTerminal(v, MAX_TERMINALS, apc->nofhelipads + MAX_TERMINALS);
 	}
 	return false; // it shouldn't get here anytime, but just to be sure
 }
@@ -146,6 +146,7 @@ static uint16 AirportGetNofElements(const AirportFTAbuildup *apFA);
 static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildup *apFA);
 static byte AirportGetTerminalCount(const byte *terminals, byte *groups);
 static byte AirportTestFTA(uint nofelements, const AirportFTA *layout, const byte *terminals);
+static AirportFTAMove *AirportBuildMoves(uint nofelements, const AirportFTA *layout);
 
 #ifdef DEBUG_AIRPORT
 static void AirportPrintOut(uint nofelements, const AirportFTA *layout, bool full_report);
@@ -174,13 +175,13 @@ AirportFTAClass::AirportFTAClass(
 	/* Set up the terminal and helipad count for an airport.
 	 * TODO: If there are more than 10 terminals or 4 helipads, internal variables
 	 * need to be changed, so don't allow that for now */
-	uint nofterminals = AirportGetTerminalCount(terminals, &nofterminalgroups);
+	nofterminals = AirportGetTerminalCount(terminals, &nofterminalgroups);
 	if (nofterminals > MAX_TERMINALS) {
 		DEBUG(misc, 0, "[Ap] only a maximum of %d terminals are supported (requested %d)", MAX_TERMINALS, nofterminals);
 		assert(nofterminals <= MAX_TERMINALS);
 	}
 
-	uint nofhelipads = AirportGetTerminalCount(helipads, &nofhelipadgroups);
+	nofhelipads = AirportGetTerminalCount(helipads, &nofhelipadgroups);
 	if (nofhelipads > MAX_HELIPADS) {
 		DEBUG(misc, 0, "[Ap] only a maximum of %d helipads are supported (requested %d)", MAX_HELIPADS, nofhelipads);
 		assert(nofhelipads <= MAX_HELIPADS);
@@ -209,6 +210,8 @@ AirportFTAClass::AirportFTAClass(
 	if (ret != MAX_ELEMENTS) DEBUG(misc, 0, "[Ap] problem with element: %d", ret - 1);
 	assert(ret == MAX_ELEMENTS);
 
+	moves = AirportBuildMoves(nofelements, layout);
+
 #ifdef DEBUG_AIRPORT
 	AirportPrintOut(nofelements, layout, DEBUG_AIRPORT);
 #endif
@@ -225,6 +228,7 @@ AirportFTAClass::~AirportFTAClass()
 		};
 	}
 	free(layout);
+	free(moves);
 }
 
 /** Get the number of elements of a source Airport state automata
@@ -266,6 +270,65 @@ static byte AirportGetTerminalCount(const byte *terminals, byte *groups)
 }
 
 
+/**
+ * Compute the moves of the aircraft at every position of an airport, so an
+ * aircraft does not need to walk the choices of its position every time.
+ * @param nofelements The number of positions of the airport.
+ * @param layout The state machine of the airport.
+ * @return The moves, indexed like AirportFTAClass::GetMove.
+ */
+static AirportFTAMove *AirportBuildMoves(uint nofelements, const AirportFTA *layout)
+{
+	AirportFTAMove *moves = MallocT<AirportFTAMove>(nofelements * (MAX_HEADINGS + 1));
+
+	for (uint pos = 0; pos < nofelements; pos++) {
+		const AirportFTA *reference = &layout[pos];
+
+		for (uint state = 0; state <= MAX_HEADINGS; state++) {
+			AirportFTAMove *move = &moves[pos * (MAX_HEADINGS + 1) + state];
+
+			/* With only one choice that one is taken, otherwise the first that matches the state. */
+			const AirportFTA *current_pos = reference;
+			if (reference->next != NULL) {
+				while (current_pos != NULL && current_pos->heading != state && current_pos->heading != TO_ALL) current_pos = current_pos->next;
+			}
+
+			move->check_blocks = 0;
+			move->set_blocks = 0;
+			if (current_pos == NULL) {
+				move->next_position = MAX_ELEMENTS;
+				continue;
+			}
+			move->next_position = current_pos->next_position;
+
+			/* If the next position is in another block, it has to be free to move on. */
+			const AirportFTA *next = &layout[current_pos->next_position];
+			if ((layout[current_pos->position].block & next->block) == next->block) continue;
+
+			/* All elements in the list with the same state and a block mean more blocks should be checked and set. */
+			uint64 airport_flags = next->block;
+			const AirportFTA *current = current_pos;
+			if (current == reference) current = current->next;
+			while (current != NULL) {
+				if (current->heading == current_pos->heading && current->block != 0) {
+					airport_flags |= current->block;
+					break;
+				}
+				current = current->next;
+			}
+
+			/* if the block to be checked is in the next position, then exclude that from
+			 * checking, because it has been set by the airplane before */
+			if (current_pos->block == next->block) airport_flags ^= next->block;
+
+			move->check_blocks = airport_flags;
+			if (next->block != NOTHING_block) move->set_blocks = airport_flags;
+		}
+	}
+
+	return moves;
+}
+
 static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildup *apFA)
 {
 	AirportFTA *FAutomata = MallocT<AirportFTA>(nofelements);
@@ -137,6 +137,13 @@ struct AirportMovingData {
 
 struct AirportFTAbuildup;
 
+/** The precomputed move of an aircraft from a position of an airport, for one state of the aircraft. */
+struct AirportFTAMove {
+	uint64 check_blocks; ///< The blocks that must be free to move on.
+	uint64 set_blocks;   ///< The blocks that are occupied when moving on.
+	byte next_position;  ///< The position to move to; #MAX_ELEMENTS when there is no move for this state.
+};
+
 /** Finite sTate mAchine --> FTA */
 struct AirportFTAClass {
 public:
@@ -165,12 +172,27 @@ public:
 		return &moving_data[position];
 	}
 
+	/**
+	 * Get the move of an aircraft that has not yet reached the heading of its position.
+	 * @param position The position of the aircraft.
+	 * @param state The state of the aircraft.
+	 * @return The move to make.
+	 */
+	const AirportFTAMove *GetMove(byte position, byte state) const
+	{
+		assert(position < nofelements && state <= MAX_HEADINGS);
+		return &moves[position * (MAX_HEADINGS + 1) + state];
+	}
+
 	const AirportMovingData *moving_data;
 	struct AirportFTA *layout;            ///< state machine for airport
+	AirportFTAMove *moves;                ///< The moves out of all positions, for each state; see #GetMove.
 	const byte *terminals;
 	const byte *helipads;
 	Flags flags;
 	byte nofelements;                     ///< number of positions the airport consists of
+	byte nofterminals;                    ///< number of terminals of all groups together
+	byte nofhelipads;                     ///< number of helipads of all groups together
 	const byte *entry_points;             ///< when an airplane arrives at this airport, enter it at position entry_point, index depends on direction
 	byte delta_z;                         ///< Z adjustment for helicopter pads
 };
@@ -13,12 +13,142 @@
 #include "core/alloc_func.hpp"
 #include "functions.h"
 
-/** The table/list with animated tiles. */
+/** The table/list with animated tiles. Removed tiles leave an INVALID_TILE hole until the list is compacted. */
 TileIndex *_animated_tile_list = NULL;
-/** The number of animated tiles in the current state. */
+/** The number of animated tiles in the current state, including the holes. */
 uint _animated_tile_count = 0;
 /** The number of slots for animated tiles allocated currently. */
 uint _animated_tile_allocated = 0;
+/** The number of holes in the table/list with animated tiles. */
+static uint _animated_tile_holes = 0;
+/** Whether AnimateAnimatedTiles is walking the list, i.e. whether it may not be compacted. */
+static bool _animating_tiles = false;
+
+/** Entry of the index from tile to position in #_animated_tile_list. */
+struct AnimatedTileIndexEntry {
+	TileIndex tile; ///< The animated tile, or INVALID_TILE when the entry is free.
+	uint pos;       ///< Position of the tile in #_animated_tile_list.
+};
+
+/** Open addressing hash of all tiles in #_animated_tile_list. */
+static AnimatedTileIndexEntry *_animated_tile_index = NULL;
+/** Number of bits of the hash; the index has 1 << bits entries. */
+static uint _animated_tile_index_bits = 0;
+
+/**
+ * Get the preferred entry of a tile in the index.
+ * @param tile the tile to get the entry of
+ * @return the position in #_animated_tile_index
+ */
+static inline uint GetAnimatedTileIndexSlot(TileIndex tile)
+{
+	return (uint32)(tile * 0x9E3779B1U) >> (32 - _animated_tile_index_bits);
+}
+
+/**
+ * Find the index entry of a tile.
+ * @param tile the tile to look for
+ * @return the entry, or NULL when the tile is not animated
+ */
+static AnimatedTileIndexEntry *FindAnimatedTileIndexEntry(TileIndex tile)
+{
+	uint mask = (1 << _animated_tile_index_bits) - 1;
+	for (uint i = GetAnimatedTileIndexSlot(tile);; i = (i + 1) & mask) {
+		AnimatedTileIndexEntry *entry = &_animated_tile_index[i];
+		if (entry->tile == tile) return entry;
+		if (entry->tile == INVALID_TILE) return NULL;
+	}
+}
+
+/**
+ * Add a tile to the index.
+ * @param tile the tile to add
+ * @param pos  the position of the tile in #_animated_tile_list
+ * @pre the tile is not in the index yet
+ */
+static void AddAnimatedTileIndexEntry(TileIndex tile, uint pos)
+{
+	uint mask = (1 << _animated_tile_index_bits) - 1;
+	uint i = GetAnimatedTileIndexSlot(tile);
+	while (_animated_tile_index[i].tile != INVALID_TILE) i = (i + 1) & mask;
+
+	_animated_tile_index[i].tile = tile;
+	_animated_tile_index[i].pos = pos;
+}
+
+/**
+ * Remove an entry from the index, moving entries after it back
+ * so no lookup chain gets broken.
+ * @param entry the entry to remove
+ */
+static void RemoveAnimatedTileIndexEntry(AnimatedTileIndexEntry *entry)
+{
+	uint mask = (1 << _animated_tile_index_bits) - 1;
+	uint hole = entry - _animated_tile_index;
+
+	for (uint i = (hole + 1) & mask; _animated_tile_index[i].tile != INVALID_TILE; i = (i + 1) & mask) {
+		/* Move the entry into the hole when its preferred slot is cyclically not within (hole, i]. */
+		uint slot = GetAnimatedTileIndexSlot(_animated_tile_index[i].tile);
+		if (((i - slot) & mask) >= ((i - hole) & mask)) {
+			_animated_tile_index[hole] = _animated_tile_index[i];
+			hole = i;
+		}
+	}
+	_animated_tile_index[hole].tile = INVALID_TILE;
+}
+
+/**
+ * Size the index to the allocated animated tile list and fill it with the
+ * tiles in the list. Duplicate tiles in the list are turned into holes.
+ */
+static void RebuildAnimatedTileIndex()
+{
+	/* Keep the index at most half full, so the lookup chains stay short. */
+	uint bits = 1;
+	while ((1U << bits) < _animated_tile_allocated * 2) bits++;
+	if (bits != _animated_tile_index_bits) {
+		_animated_tile_index_bits = bits;
+		free(_animated_tile_index);
+		_animated_tile_index = MallocT<AnimatedTileIndexEntry>(1 << bits);
+	}
+	for (uint i = 0; i < (1U << bits); i++) _animated_tile_index[i].tile = INVALID_TILE;
+
+	for (uint i = 0; i < _animated_tile_count; i++) {
+		TileIndex tile = _animated_tile_list[i];
+		if (tile == INVALID_TILE) continue;
+
+		if (FindAnimatedTileIndexEntry(tile) != NULL) {
+			_animated_tile_list[i] = INVALID_TILE;
+			_animated_tile_holes++;
+		} else {
+			AddAnimatedTileIndexEntry(tile, i);
+		}
+	}
+}
+
+/**
+ * Remove the holes and any duplicates from the animated tile list, while
+ * keeping the order, and rebuild the index to match the list. Must be called
+ * whenever the list has been changed directly, e.g. by loading a game.
+ */
+void RebuildAnimatedTileList()
+{
+	RebuildAnimatedTileIndex();
+
+	uint count = 0;
+	for (uint i = 0; i < _animated_tile_count; i++) {
+		TileIndex tile = _animated_tile_list[i];
+		if (tile == INVALID_TILE) continue;
+
+		if (count != i) {
+			_animated_tile_list[count] = tile;
+			FindAnimatedTileIndexEntry(tile)->pos = count;
+		}
+		count++;
+	}
+	_animated_tile_count = count;
+	_animated_tile_holes = 0;
+}
 
 /**
  * Removes the given tile from the animated tile table.
@@ -26,18 +156,16 @@ uint _animated_tile_allocated = 0;
  */
 void DeleteAnimatedTile(TileIndex tile)
 {
-	for (TileIndex *ti = _animated_tile_list; ti < _animated_tile_list + _animated_tile_count; ti++) {
-		if (tile == *ti) {
-			/* Remove the hole
-			 * The order of the remaining elements must stay the same, otherwise the animation loop
-			 * may miss a tile; that's why we must use memmove instead of just moving the last element.
-			 */
-			memmove(ti, ti + 1, (_animated_tile_list + _animated_tile_count - (ti + 1)) * sizeof(*ti));
-			_animated_tile_count--;
-			MarkTileDirtyByTile(tile);
-			return;
-		}
-	}
+	AnimatedTileIndexEntry *entry = FindAnimatedTileIndexEntry(tile);
+	if (entry == NULL) return;
+
+	/* The order of the remaining elements must stay the same, otherwise the
+	 * animation loop may miss a tile; that's why we leave a hole that gets
+	 * removed when the list is compacted. */
+	_animated_tile_list[entry->pos] = INVALID_TILE;
+	_animated_tile_holes++;
+	RemoveAnimatedTileIndexEntry(entry);
+	MarkTileDirtyByTile(tile);
 }
 
 /**
@@ -49,17 +177,22 @@ void AddAnimatedTile(TileIndex tile)
 {
 	MarkTileDirtyByTile(tile);
 
-	for (const TileIndex *ti = _animated_tile_list; ti < _animated_tile_list + _animated_tile_count; ti++) {
-		if (tile == *ti) return;
-	}
+	if (FindAnimatedTileIndexEntry(tile) != NULL) return;
 
-	/* Table not large enough, so make it larger */
+	/* Table full; get rid of the holes, or make it larger when that does not free enough.
+	 * While animating the positions must stay the same, so then only grow it. */
 	if (_animated_tile_count == _animated_tile_allocated) {
-		_animated_tile_allocated *= 2;
-		_animated_tile_list = ReallocT<TileIndex>(_animated_tile_list, _animated_tile_allocated);
+		if (!_animating_tiles && _animated_tile_holes >= _animated_tile_count / 2) {
+			RebuildAnimatedTileList();
+		} else {
+			_animated_tile_allocated *= 2;
+			_animated_tile_list = ReallocT<TileIndex>(_animated_tile_list, _animated_tile_allocated);
+			RebuildAnimatedTileIndex();
+		}
 	}
 
 	_animated_tile_list[_animated_tile_count] = tile;
+	AddAnimatedTileIndexEntry(tile, _animated_tile_count);
 	_animated_tile_count++;
 }
 
@@ -68,21 +201,16 @@ void AddAnimatedTile(TileIndex tile)
  */
 void AnimateAnimatedTiles()
 {
-	const TileIndex *ti = _animated_tile_list;
-	while (ti < _animated_tile_list + _animated_tile_count) {
-		const TileIndex curr = *ti;
-		AnimateTile(curr);
-		/* During the AnimateTile call, DeleteAnimatedTile could have been called,
-		 * deleting an element we've already processed and pushing the rest one
-		 * slot to the left. We can detect this by checking whether the index
-		 * in the current slot has changed - if it has, an element has been deleted,
-		 * and we should process the current slot again instead of going forward.
-		 * NOTE: this will still break if more than one animated tile is being
-		 *       deleted during the same AnimateTile call, but no code seems to
-		 *       be doing this anyway.
-		 */
-		if (*ti == curr) ++ti;
+	/* Tiles deleted during the AnimateTile calls only leave a hole, and
+	 * tiles added are appended, so the positions stay valid while walking. */
+	_animating_tiles = true;
+	for (uint i = 0; i < _animated_tile_count; i++) {
+		const TileIndex curr = _animated_tile_list[i];
+		if (curr != INVALID_TILE) AnimateTile(curr);
 	}
+	_animating_tiles = false;
+
+	if (_animated_tile_holes != 0) RebuildAnimatedTileList();
 }
 
 /**
@@ -93,4 +221,6 @@ void InitializeAnimatedTiles()
 	_animated_tile_list = ReallocT<TileIndex>(_animated_tile_list, 256);
 	_animated_tile_count = 0;
 	_animated_tile_allocated = 256;
+	_animated_tile_holes = 0;
+	RebuildAnimatedTileIndex();
 }
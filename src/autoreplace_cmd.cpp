@@ -21,6 +21,7 @@
 #include "autoreplace_func.h"
 #include "articulated_vehicles.h"
 #include "core/random_func.hpp"
+#include "core/smallvec_type.hpp"
 
 #include "table/strings.h"
 
@@ -28,6 +29,143 @@ extern void ChangeVehicleViewports(VehicleID from_index, VehicleID to_index);
 extern void ChangeVehicleNews(VehicleID from_index, VehicleID to_index);
 extern void ChangeVehicleViewWindow(VehicleID from_index, VehicleID to_index);
 
+/** What autoreplace found out about an engine during a round of autoreplacing. */
+struct AutoreplaceEngineInfo {
+	EngineID engine;          ///< The engine this is about.
+	uint32 union_mask;        ///< The union of the refit masks of all parts, including their default cargo.
+	uint32 intersection_mask; ///< The intersection of the refit masks of all parts, including their default cargo.
+	uint32 refit_mask;        ///< The union of the refit masks of all parts, excluding their default cargo.
+	bool has_capacity;        ///< Whether #capacity is known yet.
+	CargoArray capacity;      ///< The default capacity of all parts.
+};
+
+/** The replacement engine a company chose for an engine in a group, found during a round of autoreplacing. */
+struct AutoreplaceChoice {
+	CompanyID company; ///< The company that chose.
+	GroupID group;     ///< The group the choice is for.
+	EngineID from;     ///< The engine to replace.
+	EngineID to;       ///< The buildable replacement, or INVALID_ENGINE if there is none.
+};
+
+static bool _autoreplace_round = false;                              ///< Whether a round of autoreplacing is going on, see StartAutoreplaceRound().
+static SmallVector<AutoreplaceEngineInfo, 16> _autoreplace_engines; ///< The engines looked at in this round.
+static SmallVector<AutoreplaceChoice, 16> _autoreplace_choices;     ///< The replacements looked up in this round.
+
+void StartAutoreplaceRound()
+{
+	_autoreplace_round = true;
+}
+
+void EndAutoreplaceRound()
+{
+	_autoreplace_round = false;
+	_autoreplace_engines.Clear();
+	_autoreplace_choices.Clear();
+}
+
+/**
+ * Get what is known about an engine in this round of autoreplacing.
+ * @param engine the engine
+ * @return the information, determined now when the engine wasn't looked at yet
+ */
+static AutoreplaceEngineInfo *GetAutoreplaceEngineInfo(EngineID engine)
+{
+	assert(_autoreplace_round);
+
+	for (AutoreplaceEngineInfo *info = _autoreplace_engines.Begin(); info != _autoreplace_engines.End(); info++) {
+		if (info->engine == engine) return info;
+	}
+
+	AutoreplaceEngineInfo *info = _autoreplace_engines.Append();
+	info->engine = engine;
+	GetArticulatedRefitMasks(engine, true, &info->union_mask, &info->intersection_mask);
+	info->refit_mask = GetUnionOfArticulatedRefitMasks(engine, false);
+	info->has_capacity = false;
+	return info;
+}
+
+/**
+ * Merges the refit masks of all articulated parts, remembering them during a round of autoreplacing.
+ * @param engine the first part
+ * @param union_mask returns the cargos at least one part can carry
+ * @param intersection_mask returns the cargos every part with capacity can carry
+ * @see GetArticulatedRefitMasks
+ */
+static void GetAutoreplaceRefitMasks(EngineID engine, uint32 *union_mask, uint32 *intersection_mask)
+{
+	if (!_autoreplace_round) {
+		GetArticulatedRefitMasks(engine, true, union_mask, intersection_mask);
+		return;
+	}
+
+	const AutoreplaceEngineInfo *info = GetAutoreplaceEngineInfo(engine);
+	*union_mask = info->union_mask;
+	*intersection_mask = info->intersection_mask;
+}
+
+/**
+ * Ors the refit masks of all articulated parts, remembering them during a round of autoreplacing.
+ * @param engine the first part
+ * @param include_initial_cargo_type if true the default cargo type of the vehicle is included; if false only the refit_mask
+ * @return the cargos at least one part can carry
+ * @see GetUnionOfArticulatedRefitMasks
+ */
+static uint32 GetAutoreplaceUnionOfRefitMasks(EngineID engine, bool include_initial_cargo_type)
+{
+	if (!_autoreplace_round) return GetUnionOfArticulatedRefitMasks(engine, include_initial_cargo_type);
+
+	const AutoreplaceEngineInfo *info = GetAutoreplaceEngineInfo(engine);
+	return include_initial_cargo_type ? info->union_mask : info->refit_mask;
+}
+
+/**
+ * Get the default capacity of all articulated parts, remembering it during a round of autoreplacing.
+ * @param engine the first part
+ * @return the capacity per cargo
+ * @see GetCapacityOfArticulatedParts
+ */
+static CargoArray GetAutoreplaceCapacity(EngineID engine)
+{
+	if (!_autoreplace_round) return GetCapacityOfArticulatedParts(engine);
+
+	AutoreplaceEngineInfo *info = GetAutoreplaceEngineInfo(engine);
+	if (!info->has_capacity) {
+		info->capacity = GetCapacityOfArticulatedParts(engine);
+		info->has_capacity = true;
+	}
+	return info->capacity;
+}
+
+/**
+ * Get the buildable replacement a company chose for an engine, remembering it during a round of autoreplacing.
+ * @param c the company
+ * @param engine the engine to replace
+ * @param group the group of the vehicle
+ * @param type the type of the vehicle
+ * @return the replacement, or INVALID_ENGINE if there is none or it can't be built
+ */
+static EngineID GetBuildableReplacement(const Company *c, EngineID engine, GroupID group, VehicleType type)
+{
+	if (_autoreplace_round) {
+		for (const AutoreplaceChoice *choice = _autoreplace_choices.Begin(); choice != _autoreplace_choices.End(); choice++) {
+			if (choice->company == c->index && choice->from == engine && choice->group == group) return choice->to;
+		}
+	}
+
+	EngineID e = EngineReplacementForCompany(c, engine, group);
+	if (e != INVALID_ENGINE && !IsEngineBuildable(e, type, c->index)) e = INVALID_ENGINE;
+
+	if (_autoreplace_round) {
+		AutoreplaceChoice *choice = _autoreplace_choices.Append();
+		choice->company = c->index;
+		choice->group = group;
+		choice->from = engine;
+		choice->to = e;
+	}
+
+	return e;
+}
+
 /** Figure out if two engines got at least one type of cargo in common (refitting if needed)
  * @param engine_a one of the EngineIDs
  * @param engine_b the other EngineID
@@ -36,8 +174,8 @@ extern void ChangeVehicleViewWindow(VehicleID from_index, VehicleID to_index);
  */
 static bool EnginesHaveCargoInCommon(EngineID engine_a, EngineID engine_b)
 {
-	uint32 available_cargos_a = GetUnionOfArticulatedRefitMasks(engine_a, true);
-	uint32 available_cargos_b = GetUnionOfArticulatedRefitMasks(engine_b, true);
+	uint32 available_cargos_a = GetAutoreplaceUnionOfRefitMasks(engine_a, true);
+	uint32 available_cargos_b = GetAutoreplaceUnionOfRefitMasks(engine_b, true);
 	return (available_cargos_a == 0 || available_cargos_b == 0 || (available_cargos_a & available_cargos_b) != 0);
 }
 
@@ -135,8 +273,8 @@ static void TransferCargo(Vehicle *old_veh, Vehicle *new_head, bool part_of_chai
 static bool VerifyAutoreplaceRefitForOrders(const Vehicle *v, EngineID engine_type)
 {
 
-	uint32 union_refit_mask_a = GetUnionOfArticulatedRefitMasks(v->engine_type, false);
-	uint32 union_refit_mask_b = GetUnionOfArticulatedRefitMasks(engine_type, false);
+	uint32 union_refit_mask_a = GetAutoreplaceUnionOfRefitMasks(v->engine_type, false);
+	uint32 union_refit_mask_b = GetAutoreplaceUnionOfRefitMasks(engine_type, false);
 
 	const Order *o;
 	const Vehicle *u = (v->type == VEH_TRAIN) ? v->First() : v;
@@ -163,7 +301,7 @@ static bool VerifyAutoreplaceRefitForOrders(const Vehicle *v, EngineID engine_ty
 static CargoID GetNewCargoTypeForReplace(Vehicle *v, EngineID engine_type, bool part_of_chain)
 {
 	uint32 available_cargo_types, union_mask;
-	GetArticulatedRefitMasks(engine_type, true, &union_mask, &available_cargo_types);
+	GetAutoreplaceRefitMasks(engine_type, &union_mask, &available_cargo_types);
 
 	if (union_mask == 0) return CT_NO_REFIT; // Don't try to refit an engine with no cargo capacity
 
@@ -183,7 +321,7 @@ static CargoID GetNewCargoTypeForReplace(Vehicle *v, EngineID engine_type, bool
 			/* Now we found a cargo type being carried on the train and we will see if it is possible to carry to this one */
 			if (HasBit(available_cargo_types, v->cargo_type)) {
 				/* Do we have to refit the vehicle, or is it already carrying the right cargo? */
-				CargoArray default_capacity = GetCapacityOfArticulatedParts(engine_type);
+				CargoArray default_capacity = GetAutoreplaceCapacity(engine_type);
 				for (CargoID cid = 0; cid < NUM_CARGO; cid++) {
 					if (cid != v->cargo_type && default_capacity[cid] > 0) return v->cargo_type;
 				}
@@ -199,7 +337,7 @@ static CargoID GetNewCargoTypeForReplace(Vehicle *v, EngineID engine_type, bool
 		if (part_of_chain && !VerifyAutoreplaceRefitForOrders(v, engine_type)) return CT_INVALID; // Some refit orders lose their effect
 
 		/* Do we have to refit the vehicle, or is it already carrying the right cargo? */
-		CargoArray default_capacity = GetCapacityOfArticulatedParts(engine_type);
+		CargoArray default_capacity = GetAutoreplaceCapacity(engine_type);
 		for (CargoID cid = 0; cid < NUM_CARGO; cid++) {
 			if (cid != cargo_type && default_capacity[cid] > 0) return cargo_type;
 		}
@@ -222,11 +360,8 @@ static EngineID GetNewEngineType(const Vehicle *v, const Company *c)
 		return INVALID_ENGINE;
 	}
 
-	EngineID e = EngineReplacementForCompany(c, v->engine_type, v->group_id);
-
-	if (e != INVALID_ENGINE && IsEngineBuildable(e, v->type, _current_company)) {
-		return e;
-	}
+	EngineID e = GetBuildableReplacement(c, v->engine_type, v->group_id, v->type);
+	if (e != INVALID_ENGINE) return e;
 
 	if (v->NeedsAutorenewing(c) && // replace if engine is too old
 	    IsEngineBuildable(v->engine_type, v->type, _current_company)) { // engine can still be build
@@ -118,4 +118,14 @@ static inline CommandCost RemoveEngineReplacementForCompany(Company *c, EngineID
 
 bool CheckAutoreplaceValidity(EngineID from, EngineID to, CompanyID company);
 
+/**
+ * Start a round of autoreplacing the vehicles that entered a depot this tick.
+ * Until the round ends, the refit masks and capacities of engines and the
+ * replacements companies chose are looked up only once, as nothing changes
+ * them in the meantime.
+ */
+void StartAutoreplaceRound();
+/** End a round of autoreplacing and forget what was looked up in it. */
+void EndAutoreplaceRound();
+
 #endif /* AUTOREPLACE_FUNC_H */
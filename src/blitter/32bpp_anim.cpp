@@ -18,6 +18,33 @@
 
 static FBlitter_32bppAnim iFBlitter_32bppAnim;
 
+/**
+ * Remember that a part of the screen can contain palette animated pixels,
+ * i.e. that values other than 0 have been written to the anim-buffer there.
+ * @param offset the position of the top left of the part in the anim-buffer
+ * @param width  the width of the part
+ * @param height the height of the part
+ */
+void Blitter_32bppAnim::MarkAnimated(size_t offset, int width, int height)
+{
+	int left = (int)(offset % this->anim_buf_width);
+	int top = (int)(offset / this->anim_buf_width);
+	int right = min(left + width, this->anim_buf_width);
+	int bottom = min(top + height, this->anim_buf_height);
+	if (left >= right || top >= bottom) return;
+
+	for (int b = top / ANIM_BAND_HEIGHT; b <= (bottom - 1) / ANIM_BAND_HEIGHT; b++) {
+		AnimBand *band = &this->anim_bands[b];
+		if (band->left >= band->right) {
+			band->left = left;
+			band->right = right;
+		} else {
+			band->left = min(band->left, left);
+			band->right = max(band->right, right);
+		}
+	}
+}
+
 template <BlitterMode mode>
 inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom)
 {
@@ -36,6 +63,9 @@ inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel
 
 	const byte *remap = bp->remap; // store so we don't have to access it via bp everytime
 
+	/* All values written to the anim-buffer or-ed together; when it's 0 there's nothing to animate. */
+	uint anim_used = 0;
+
 	for (int y = 0; y < bp->height; y++) {
 		uint32 *dst_ln = dst + bp->pitch;
 		uint8 *anim_ln = anim + this->anim_buf_width;
@@ -107,6 +137,7 @@ inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel
 							} else {
 								uint r = remap[m];
 								*anim = r;
+								anim_used |= r;
 								if (r != 0) *dst = this->LookupColourInPalette(r);
 							}
 							anim++;
@@ -123,6 +154,7 @@ inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel
 							} else {
 								uint r = remap[m];
 								*anim = r;
+								anim_used |= r;
 								if (r != 0) *dst = ComposeColourPANoCheck(this->LookupColourInPalette(r), src_px->a, *dst);
 							}
 							anim++;
@@ -145,6 +177,7 @@ inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel
 						do {
 							*dst = MakeTransparent(*dst, 3, 4);
 							*anim = remap[*anim];
+							anim_used |= *anim;
 							anim++;
 							dst++;
 						} while (--n != 0);
@@ -152,6 +185,7 @@ inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel
 						do {
 							*dst = MakeTransparent(*dst, (256 * 4 - src_px->a), 256 * 4);
 							*anim = remap[*anim];
+							anim_used |= *anim;
 							anim++;
 							dst++;
 							src_px++;
@@ -166,6 +200,7 @@ inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel
 							uint m = *src_n++;
 							/* Above 217 (PALETTE_ANIM_SIZE_START) is palette animation */
 							*anim++ = m;
+							anim_used |= m;
 							*dst++ = (m >= PALETTE_ANIM_SIZE_START) ? this->LookupColourInPalette(m) : src_px->data;
 							src_px++;
 						} while (--n != 0);
@@ -173,6 +208,7 @@ inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel
 						do {
 							uint m = *src_n++;
 							*anim++ = m;
+							anim_used |= m;
 							if (m >= PALETTE_ANIM_SIZE_START) {
 								*dst = ComposeColourPANoCheck(this->LookupColourInPalette(m), src_px->a, *dst);
 							} else {
@@ -191,6 +227,8 @@ inline void Blitter_32bppAnim::Draw(const Blitter::BlitterParams *bp, ZoomLevel
 		src_px = src_px_ln;
 		src_n  = src_n_ln;
 	}
+
+	if (anim_used != 0) this->MarkAnimated(((uint32 *)bp->dst - (uint32 *)_screen.dst_ptr) + bp->top * this->anim_buf_width + bp->left, bp->width, bp->height);
 }
 
 void Blitter_32bppAnim::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
@@ -258,7 +296,9 @@ void Blitter_32bppAnim::SetPixel(void *video, int x, int y, uint8 colour)
 
 	/* Set the colour in the anim-buffer too, if we are rendering to the screen */
 	if (_screen_disable_anim) return;
-	this->anim_buf[((uint32 *)video - (uint32 *)_screen.dst_ptr) + x + y * this->anim_buf_width] = colour;
+	size_t offset = ((uint32 *)video - (uint32 *)_screen.dst_ptr) + x + y * this->anim_buf_width;
+	this->anim_buf[offset] = colour;
+	if (colour != 0) this->MarkAnimated(offset, 1, 1);
 }
 
 void Blitter_32bppAnim::DrawRect(void *video, int width, int height, uint8 colour)
@@ -273,6 +313,7 @@ void Blitter_32bppAnim::DrawRect(void *video, int width, int height, uint8 colou
 	uint8 *anim_line;
 
 	anim_line = ((uint32 *)video - (uint32 *)_screen.dst_ptr) + this->anim_buf;
+	if (colour != 0) this->MarkAnimated((uint32 *)video - (uint32 *)_screen.dst_ptr, width, height);
 
 	do {
 		uint32 *dst = (uint32 *)video;
@@ -297,6 +338,7 @@ void Blitter_32bppAnim::CopyFromBuffer(void *video, const void *src, int width,
 	uint32 *dst = (uint32 *)video;
 	uint32 *usrc = (uint32 *)src;
 	uint8 *anim_line = ((uint32 *)video - (uint32 *)_screen.dst_ptr) + this->anim_buf;
+	this->MarkAnimated((uint32 *)video - (uint32 *)_screen.dst_ptr, width, height);
 
 	int count = (_use_palette == PAL_DOS) ? PALETTE_ANIM_SIZE_DOS : PALETTE_ANIM_SIZE_WIN;
 
@@ -361,6 +403,9 @@ void Blitter_32bppAnim::ScrollBuffer(void *video, int &left, int &top, int &widt
 	assert(video >= _screen.dst_ptr && video <= (uint32 *)_screen.dst_ptr + _screen.width + _screen.height * _screen.pitch);
 	uint8 *dst, *src;
 
+	/* The animated pixels can move anywhere in the scrolled part. */
+	this->MarkAnimated(left + top * this->anim_buf_width, width, height);
+
 	/* We need to scroll the anim-buffer too */
 	if (scroll_y > 0) {
 		dst = this->anim_buf + left + (top + height - 1) * this->anim_buf_width;
@@ -421,25 +466,56 @@ void Blitter_32bppAnim::PaletteAnimate(uint start, uint count)
 		count--;
 	}
 
-	const uint8 *anim = this->anim_buf;
-	uint32 *dst = (uint32 *)_screen.dst_ptr;
-
-	/* Let's walk the anim buffer and try to find the pixels */
-	for (int y = this->anim_buf_height; y != 0 ; y--) {
-		for (int x = this->anim_buf_width; x != 0 ; x--) {
-			uint colour = *anim;
-			if (IsInsideBS(colour, start, count)) {
-				/* Update this pixel */
-				*dst = LookupColourInPalette(colour);
+	/* The part of the screen that has been looked at, so the backend has to redraw. */
+	int dirty_left = this->anim_buf_width;
+	int dirty_top = this->anim_buf_height;
+	int dirty_right = 0;
+	int dirty_bottom = 0;
+
+	/* Let's walk the parts of the anim buffer that aren't 0 and try to find the pixels */
+	for (int b = 0; b * ANIM_BAND_HEIGHT < this->anim_buf_height; b++) {
+		AnimBand *band = &this->anim_bands[b];
+		if (band->left >= band->right) continue;
+
+		int top = b * ANIM_BAND_HEIGHT;
+		int bottom = min(top + ANIM_BAND_HEIGHT, this->anim_buf_height);
+		int width = band->right - band->left;
+
+		dirty_left = min(dirty_left, band->left);
+		dirty_right = max(dirty_right, band->right);
+		dirty_top = min(dirty_top, top);
+		dirty_bottom = bottom;
+
+		/* Whatever has been drawn over since doesn't need to be looked at again. */
+		int used_left = band->right;
+		int used_right = band->left;
+
+		const uint8 *anim = this->anim_buf + top * this->anim_buf_width + band->left;
+		uint32 *dst = (uint32 *)_screen.dst_ptr + top * _screen.pitch + band->left;
+		for (int y = top; y < bottom; y++) {
+			for (int x = band->left; x < band->right; x++) {
+				uint colour = *anim;
+				if (colour != 0) {
+					used_left = min(used_left, x);
+					used_right = max(used_right, x + 1);
+					if (IsInsideBS(colour, start, count)) {
+						/* Update this pixel */
+						*dst = LookupColourInPalette(colour);
+					}
+				}
+				dst++;
+				anim++;
 			}
-			dst++;
-			anim++;
+			dst += _screen.pitch - width;
+			anim += this->anim_buf_width - width;
 		}
-		dst += _screen.pitch - this->anim_buf_width;
+
+		band->left = used_left;
+		band->right = used_right;
 	}
 
-	/* Make sure the backend redraws the whole screen */
-	_video_driver->MakeDirty(0, 0, _screen.width, _screen.height);
+	/* Make sure the backend redraws what might have changed */
+	if (dirty_left < dirty_right) _video_driver->MakeDirty(dirty_left, dirty_top, dirty_right - dirty_left, dirty_bottom - dirty_top);
 }
 
 Blitter::PaletteAnimation Blitter_32bppAnim::UsePaletteAnimation()
@@ -455,5 +531,9 @@ void Blitter_32bppAnim::PostResize()
 		this->anim_buf = CallocT<uint8>(_screen.width * _screen.height);
 		this->anim_buf_width = _screen.width;
 		this->anim_buf_height = _screen.height;
+
+		/* Nothing to animate in an empty buffer. */
+		free(this->anim_bands);
+		this->anim_bands = CallocT<AnimBand>(CeilDiv(_screen.height, ANIM_BAND_HEIGHT));
 	}
 }
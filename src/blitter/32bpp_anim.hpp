@@ -16,15 +16,27 @@
 
 class Blitter_32bppAnim : public Blitter_32bppOptimized {
 private:
+	/** The part of a band of lines of the screen that can contain palette animated pixels. */
+	struct AnimBand {
+		int left;  ///< The first column that can contain them.
+		int right; ///< The column after the last one that can contain them; not more than left when there are none.
+	};
+
+	static const int ANIM_BAND_HEIGHT = 8; ///< The number of lines of the screen in an AnimBand.
+
 	uint8 *anim_buf; ///< In this buffer we keep track of the 8bpp indexes so we can do palette animation
 	int anim_buf_width;
 	int anim_buf_height;
+	AnimBand *anim_bands; ///< For every ANIM_BAND_HEIGHT lines of the screen, where the anim-buffer isn't 0, so palette animation only has to look there
+
+	void MarkAnimated(size_t offset, int width, int height);
 
 public:
 	Blitter_32bppAnim() :
 		anim_buf(NULL),
 		anim_buf_width(0),
-		anim_buf_height(0)
+		anim_buf_height(0),
+		anim_bands(NULL)
 	{}
 
 	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
@@ -0,0 +1,343 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_sse2.cpp Implementation of the optimized 32 bpp blitter using SSE2 for blending. */
+
+#include "../stdafx.h"
+#include "../debug.h"
+#include "../core/math_func.hpp"
+#include "32bpp_sse2.hpp"
+
+#ifdef WITH_SSE2_BLITTER
+
+#include "../table/sprites.h"
+
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__i386__)
+#include <cpuid.h>
+#endif
+
+static FBlitter_32bppSSE2 iFBlitter_32bppSSE2;
+
+/**
+ * Does the CPU we run on support SSE2?
+ * @return true when the SSE2 blitter can be used.
+ */
+/* static */ bool Blitter_32bppSSE2::HasCPUSupport()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return HasBit(info[3], 26);
+#else
+	uint eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) return false;
+	return HasBit(edx, 26);
+#endif
+}
+
+Blitter *FBlitter_32bppSSE2::CreateInstance()
+{
+	if (Blitter_32bppSSE2::HasCPUSupport()) return new Blitter_32bppSSE2();
+
+	DEBUG(driver, 0, "This CPU has no SSE2; using the 32bpp-optimized blitter instead");
+	return new Blitter_32bppOptimized();
+}
+
+/**
+ * Blend two pixels with their own alpha onto two pixels on the screen;
+ * per channel this is dst + (src - dst) * alpha / 256, exactly like
+ * Blitter_32bppBase::ComposeColourRGBANoCheck does it.
+ * @param src the two pixels to draw, in the low 64 bits
+ * @param dst the two pixels on the screen, in the low 64 bits
+ * @return the two blended pixels, in the low 64 bits, with full alpha
+ */
+static inline __m128i AlphaBlendTwoPixels(__m128i src, __m128i dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i byte_mask = _mm_set1_epi16(0x00FF);
+	const __m128i full_alpha = _mm_set1_epi32(0xFF000000);
+
+	__m128i s = _mm_unpacklo_epi8(src, zero);
+	__m128i d = _mm_unpacklo_epi8(dst, zero);
+	/* Every channel of a pixel gets multiplied by the alpha of that pixel. */
+	__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+	/* Only the low byte of the result matters, so the product may overflow into the high one. */
+	__m128i r = _mm_mullo_epi16(_mm_sub_epi16(s, d), a);
+	r = _mm_and_si128(_mm_add_epi16(_mm_srli_epi16(r, 8), d), byte_mask);
+	return _mm_or_si128(_mm_packus_epi16(r, r), full_alpha);
+}
+
+/**
+ * Make four pixels on the screen darker; per channel this is colour * nom / 1024.
+ * @param dst    the four pixels
+ * @param nom_lo the nominators, of at most 1024, per channel of the first two pixels
+ * @param nom_hi the nominators, of at most 1024, per channel of the last two pixels
+ * @return the darker pixels, with full alpha
+ */
+static inline __m128i MakeTransparentFourPixels(__m128i dst, __m128i nom_lo, __m128i nom_hi)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full_alpha = _mm_set1_epi32(0xFF000000);
+
+	/* (colour << 6) * nom / 65536 is exactly colour * nom / 1024, and fits in 16 bits. */
+	__m128i lo = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpacklo_epi8(dst, zero), 6), nom_lo);
+	__m128i hi = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpackhi_epi8(dst, zero), 6), nom_hi);
+	return _mm_or_si128(_mm_packus_epi16(lo, hi), full_alpha);
+}
+
+/**
+ * Blend a run of pixels with their own alpha onto the screen.
+ * @param dst where to draw
+ * @param src the pixels
+ * @param n   the number of pixels
+ */
+static inline void AlphaBlendRun(uint32 *dst, const Colour *src, uint n)
+{
+	for (; n >= 2; n -= 2) {
+		__m128i s = _mm_loadl_epi64((const __m128i *)src);
+		__m128i d = _mm_loadl_epi64((const __m128i *)dst);
+		_mm_storel_epi64((__m128i *)dst, AlphaBlendTwoPixels(s, d));
+		dst += 2;
+		src += 2;
+	}
+	if (n != 0) {
+		__m128i r = AlphaBlendTwoPixels(_mm_cvtsi32_si128(src->data), _mm_cvtsi32_si128(*dst));
+		*dst = _mm_cvtsi128_si32(r);
+	}
+}
+
+/**
+ * Make a run of pixels on the screen darker, for the transparency of a
+ * sprite; per channel this is colour * (1024 - alpha) / 1024.
+ * @param dst where to draw
+ * @param src the pixels of the sprite, for their alpha, or NULL when they are all fully opaque
+ * @param n   the number of pixels
+ */
+static inline void MakeTransparentRun(uint32 *dst, const Colour *src, uint n)
+{
+	/* A fully opaque sprite darkens the screen to 3 / 4, i.e. 768 / 1024. */
+	const __m128i opaque = _mm_set1_epi16(768);
+
+	for (; n >= 4; n -= 4) {
+		__m128i nom_lo = opaque;
+		__m128i nom_hi = opaque;
+		if (src != NULL) {
+			nom_lo = _mm_set_epi16(1024 - src[1].a, 1024 - src[1].a, 1024 - src[1].a, 1024 - src[1].a, 1024 - src[0].a, 1024 - src[0].a, 1024 - src[0].a, 1024 - src[0].a);
+			nom_hi = _mm_set_epi16(1024 - src[3].a, 1024 - src[3].a, 1024 - src[3].a, 1024 - src[3].a, 1024 - src[2].a, 1024 - src[2].a, 1024 - src[2].a, 1024 - src[2].a);
+			src += 4;
+		}
+		__m128i d = _mm_loadu_si128((const __m128i *)dst);
+		_mm_storeu_si128((__m128i *)dst, MakeTransparentFourPixels(d, nom_lo, nom_hi));
+		dst += 4;
+	}
+	for (; n != 0; n--) {
+		*dst = (src == NULL) ? Blitter_32bppBase::MakeTransparent(*dst, 3, 4) : Blitter_32bppBase::MakeTransparent(*dst, 256 * 4 - src->a, 256 * 4);
+		dst++;
+		if (src != NULL) src++;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. It is templated to allow faster operation.
+ *
+ * @tparam mode blitter mode
+ * @param bp further blitting parameters
+ * @param zoom zoom level at which we are drawing
+ */
+template <BlitterMode mode>
+inline void Blitter_32bppSSE2::Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom)
+{
+	const SpriteData *src = (const SpriteData *)bp->sprite;
+
+	/* See Blitter_32bppOptimized::Draw for the layout of the sprite. */
+	const Colour *src_px = (const Colour *)(src->data + src->offset[zoom][0]);
+	const uint8  *src_n  = (const uint8  *)(src->data + src->offset[zoom][1]);
+
+	/* skip upper lines in src_px and src_n */
+	for (uint i = bp->skip_top; i != 0; i--) {
+		src_px = (const Colour *)((const byte *)src_px + *(const uint32 *)src_px);
+		src_n += *(uint32 *)src_n;
+	}
+
+	/* skip lines in dst */
+	uint32 *dst = (uint32 *)bp->dst + bp->top * bp->pitch + bp->left;
+
+	/* store so we don't have to access it via bp everytime (compiler assumes pointer aliasing) */
+	const byte *remap = bp->remap;
+
+	for (int y = 0; y < bp->height; y++) {
+		/* next dst line begins here */
+		uint32 *dst_ln = dst + bp->pitch;
+
+		/* next src line begins here */
+		const Colour *src_px_ln = (const Colour *)((const byte *)src_px + *(const uint32 *)src_px);
+		src_px++;
+
+		/* next src_n line begins here */
+		const uint8 *src_n_ln = src_n + *(uint32 *)src_n;
+		src_n += 4;
+
+		/* we will end this line when we reach this point */
+		uint32 *dst_end = dst + bp->skip_left;
+
+		/* number of pixels with the same aplha channel class */
+		uint n;
+
+		while (dst < dst_end) {
+			n = *src_n++;
+
+			if (src_px->a == 0) {
+				dst += n;
+				src_px ++;
+				src_n++;
+			} else {
+				if (dst + n > dst_end) {
+					uint d = dst_end - dst;
+					src_px += d;
+					src_n += d;
+
+					dst = dst_end - bp->skip_left;
+					dst_end = dst + bp->width;
+
+					n = min<uint>(n - d, (uint)bp->width);
+					goto draw;
+				}
+				dst += n;
+				src_px += n;
+				src_n += n;
+			}
+		}
+
+		dst -= bp->skip_left;
+		dst_end -= bp->skip_left;
+
+		dst_end += bp->width;
+
+		while (dst < dst_end) {
+			n = min<uint>(*src_n++, (uint)(dst_end - dst));
+
+			if (src_px->a == 0) {
+				dst += n;
+				src_px++;
+				src_n++;
+				continue;
+			}
+
+			draw:;
+
+			switch (mode) {
+				case BM_COLOUR_REMAP:
+					/* The remapping is a lookup per pixel, which SSE2 can't do any faster. */
+					if (src_px->a == 255) {
+						do {
+							uint m = *src_n;
+							/* In case the m-channel is zero, do not remap this pixel in any way */
+							if (m == 0) {
+								*dst = src_px->data;
+							} else {
+								uint r = remap[m];
+								if (r != 0) *dst = this->LookupColourInPalette(r);
+							}
+							dst++;
+							src_px++;
+							src_n++;
+						} while (--n != 0);
+					} else {
+						do {
+							uint m = *src_n;
+							if (m == 0) {
+								*dst = ComposeColourRGBANoCheck(src_px->r, src_px->g, src_px->b, src_px->a, *dst);
+							} else {
+								uint r = remap[m];
+								if (r != 0) *dst = ComposeColourPANoCheck(this->LookupColourInPalette(r), src_px->a, *dst);
+							}
+							dst++;
+							src_px++;
+							src_n++;
+						} while (--n != 0);
+					}
+					break;
+
+				case BM_TRANSPARENT:
+					/* Make the current colour a bit more black, so it looks like this image is transparent */
+					src_n += n;
+					MakeTransparentRun(dst, src_px->a == 255 ? NULL : src_px, n);
+					src_px += n;
+					dst += n;
+					break;
+
+				default:
+					src_n += n;
+					if (src_px->a == 255) {
+						memcpy(dst, src_px, n * sizeof(uint32));
+					} else {
+						AlphaBlendRun(dst, src_px, n);
+					}
+					src_px += n;
+					dst += n;
+					break;
+			}
+		}
+
+		dst = dst_ln;
+		src_px = src_px_ln;
+		src_n  = src_n_ln;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void Blitter_32bppSSE2::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	switch (mode) {
+		default: NOT_REACHED();
+		case BM_NORMAL:       Draw<BM_NORMAL>      (bp, zoom); return;
+		case BM_COLOUR_REMAP: Draw<BM_COLOUR_REMAP>(bp, zoom); return;
+		case BM_TRANSPARENT:  Draw<BM_TRANSPARENT> (bp, zoom); return;
+	}
+}
+
+void Blitter_32bppSSE2::DrawColourMappingRect(void *dst, int width, int height, PaletteID pal)
+{
+	if (pal != PALETTE_TO_TRANSPARENT) {
+		Blitter_32bppOptimized::DrawColourMappingRect(dst, width, height, pal);
+		return;
+	}
+
+	/* Like MakeTransparent(colour, 154), so colour * 616 / 1024. */
+	const __m128i nom = _mm_set1_epi16(154 * 4);
+
+	uint32 *udst = (uint32 *)dst;
+	do {
+		int i = width;
+		for (; i >= 4; i -= 4) {
+			__m128i d = _mm_loadu_si128((const __m128i *)udst);
+			_mm_storeu_si128((__m128i *)udst, MakeTransparentFourPixels(d, nom, nom));
+			udst += 4;
+		}
+		for (; i != 0; i--) {
+			*udst = MakeTransparent(*udst, 154);
+			udst++;
+		}
+		udst = udst - width + _screen.pitch;
+	} while (--height);
+}
+
+#endif /* WITH_SSE2_BLITTER */
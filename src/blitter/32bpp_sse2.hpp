@@ -0,0 +1,52 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_sse2.hpp Optimized 32 bpp blitter using SSE2 for blending. */
+
+#ifndef BLITTER_32BPP_SSE2_HPP
+#define BLITTER_32BPP_SSE2_HPP
+
+/* x86-64 always has SSE2; 32 bits x86 has to be compiled for it, except
+ * with MSVC, which can use it anyway and then checks the CPU when the
+ * blitter is selected. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_MSC_VER) && defined(_M_IX86))
+#define WITH_SSE2_BLITTER
+#endif
+
+#ifdef WITH_SSE2_BLITTER
+
+#include "32bpp_optimized.hpp"
+
+/**
+ * The optimized 32 bpp blitter, but blending, the transparency and the
+ * colour mapping rectangles are done for two or four pixels at once.
+ * It uses the sprites of the optimized 32 bpp blitter.
+ */
+class Blitter_32bppSSE2 : public Blitter_32bppOptimized {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+	/* virtual */ void DrawColourMappingRect(void *dst, int width, int height, PaletteID pal);
+
+	/* virtual */ const char *GetName() { return "32bpp-sse2"; }
+
+	template <BlitterMode mode> void Draw(const Blitter::BlitterParams *bp, ZoomLevel zoom);
+
+	static bool HasCPUSupport();
+};
+
+class FBlitter_32bppSSE2: public BlitterFactory<FBlitter_32bppSSE2> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-sse2"; }
+	/* virtual */ const char *GetDescription() { return "32bpp SSE2 Blitter (no palette animation)"; }
+	/* virtual */ Blitter *CreateInstance();
+};
+
+#endif /* WITH_SSE2_BLITTER */
+
+#endif /* BLITTER_32BPP_SSE2_HPP */
@@ -47,7 +47,18 @@ TileIndex GetSouthernBridgeEnd(TileIndex t)
 TileIndex GetOtherBridgeEnd(TileIndex tile)
 {
 	assert(IsBridgeTile(tile));
-	return GetBridgeEnd(tile, GetTunnelBridgeDirection(tile));
+	DiagDirection dir = GetTunnelBridgeDirection(tile);
+
+	/* Use the distance stored in the map when it points at the matching end. */
+	uint distance = GetTunnelBridgeEndDistance(tile);
+	if (distance != 0) {
+		TileIndex end = tile + TileOffsByDiagDir(dir) * (int)distance;
+		if (end < MapSize() && IsBridgeTile(end) && GetTunnelBridgeDirection(end) == ReverseDiagDir(dir)) return end;
+	}
+
+	TileIndex end = GetBridgeEnd(tile, dir);
+	SetTunnelBridgeEnds(tile, end);
+	return end;
 }
 
 uint GetBridgeHeight(TileIndex t)
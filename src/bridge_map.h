@@ -14,6 +14,7 @@
 
 #include "road_map.h"
 #include "bridge.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 /**
  * Checks if this is a bridge, instead of a tunnel
@@ -211,6 +212,7 @@ static inline void MakeRailBridgeRamp(TileIndex t, Owner o, BridgeType bridgetyp
 static inline void MakeAqueductBridgeRamp(TileIndex t, Owner o, DiagDirection d)
 {
 	MakeBridgeRamp(t, o, 0, d, TRANSPORT_WATER, 0);
+	YapfNotifyWaterLayoutChange(t);
 }
 
 #endif /* BRIDGE_MAP_H */
@@ -13,6 +13,8 @@
 #include "core/pool_func.hpp"
 #include "economy_base.h"
 
+#include <map>
+
 /* Initialize the cargopacket-pool */
 CargoPacketPool _cargopacket_pool("CargoPacket");
 INSTANTIATE_POOL_METHODS(CargoPacket)
@@ -116,6 +118,7 @@ template <class Tinst>
 void CargoList<Tinst>::Append(CargoPacket *cp)
 {
 	assert(cp != NULL);
+	static_cast<Tinst *>(this)->ApplyAge();
 	static_cast<Tinst *>(this)->AddToCache(cp);
 
 	for (List::reverse_iterator it(this->packets.rbegin()); it != this->packets.rend(); it++) {
@@ -137,16 +140,11 @@ void CargoList<Tinst>::Append(CargoPacket *cp)
 template <class Tinst>
 void CargoList<Tinst>::Truncate(uint max_remaining)
 {
-	for (Iterator it(packets.begin()); it != packets.end(); /* done during loop*/) {
-		CargoPacket *cp = *it;
-		if (max_remaining == 0) {
-			/* Nothing should remain, just remove the packets. */
-			this->packets.erase(it++);
-			static_cast<Tinst *>(this)->RemoveFromCache(cp);
-			delete cp;
-			continue;
-		}
+	static_cast<Tinst *>(this)->ApplyAge();
 
+	Iterator it(this->packets.begin());
+	for (; it != this->packets.end() && max_remaining != 0; ++it) {
+		CargoPacket *cp = *it;
 		uint local_count = cp->count;
 		if (local_count > max_remaining) {
 			uint diff = local_count - max_remaining;
@@ -157,8 +155,15 @@ void CargoList<Tinst>::Truncate(uint max_remaining)
 		} else {
 			max_remaining -= local_count;
 		}
-		++it;
 	}
+
+	/* Nothing should remain of the others, just remove the packets. */
+	for (Iterator rem(it); rem != this->packets.end(); ++rem) {
+		CargoPacket *cp = *rem;
+		static_cast<Tinst *>(this)->RemoveFromCache(cp);
+		delete cp;
+	}
+	this->packets.erase(it, this->packets.end());
 }
 
 template <class Tinst>
@@ -168,11 +173,17 @@ bool CargoList<Tinst>::MoveTo(Tother_inst *dest, uint max_move, MoveToAction mta
 	assert(mta == MTA_FINAL_DELIVERY || dest != NULL);
 	assert(mta == MTA_UNLOAD || mta == MTA_CARGO_LOAD || payment != NULL);
 
+	static_cast<Tinst *>(this)->ApplyAge();
+
+	/* Packets that stay are gathered at the front of the processed part
+	 * of the list, so the moved ones can be erased in one go afterwards. */
 	Iterator it(this->packets.begin());
+	Iterator keep(it);
 	while (it != this->packets.end() && max_move > 0) {
 		CargoPacket *cp = *it;
 		if (cp->source == data && mta == MTA_FINAL_DELIVERY) {
 			/* Skip cargo that originated from this station. */
+			*keep++ = cp;
 			++it;
 			continue;
 		}
@@ -180,7 +191,7 @@ bool CargoList<Tinst>::MoveTo(Tother_inst *dest, uint max_move, MoveToAction mta
 		if (cp->count <= max_move) {
 			/* Can move the complete packet */
 			max_move -= cp->count;
-			this->packets.erase(it++);
+			++it;
 			static_cast<Tinst *>(this)->RemoveFromCache(cp);
 			switch(mta) {
 				case MTA_FINAL_DELIVERY:
@@ -237,12 +248,16 @@ bool CargoList<Tinst>::MoveTo(Tother_inst *dest, uint max_move, MoveToAction mta
 		max_move = 0;
 	}
 
-	return it != packets.end();
+	bool remaining = it != this->packets.end();
+	this->packets.erase(keep, it);
+	return remaining;
 }
 
 template <class Tinst>
 void CargoList<Tinst>::InvalidateCache()
 {
+	static_cast<Tinst *>(this)->ApplyAge();
+
 	this->count = 0;
 	this->cargo_days_in_transit = 0;
 
@@ -261,27 +276,115 @@ void VehicleCargoList::RemoveFromCache(const CargoPacket *cp)
 void VehicleCargoList::AddToCache(const CargoPacket *cp)
 {
 	this->feeder_share += cp->feeder_share;
+	this->age_headroom = min(this->age_headroom, 0xFF - cp->days_in_transit);
 	this->Parent::AddToCache(cp);
 }
 
 void VehicleCargoList::AgeCargo()
 {
+	/* As long as no packet can reach the maximum age, every entity ages
+	 * and the cache can be updated without touching the packets. */
+	if (this->pending_age < this->age_headroom) {
+		this->pending_age++;
+		this->cargo_days_in_transit += this->count;
+		return;
+	}
+
+	this->ApplyAge();
+
+	byte headroom = 0xFF;
 	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
 		CargoPacket *cp = *it;
 		/* If we're at the maximum, then we can't increase no more. */
-		if (cp->days_in_transit == 0xFF) continue;
+		if (cp->days_in_transit == 0xFF) {
+			headroom = 0;
+			continue;
+		}
 
 		cp->days_in_transit++;
 		this->cargo_days_in_transit += cp->count;
+		headroom = min(headroom, 0xFF - cp->days_in_transit);
+	}
+	this->age_headroom = headroom;
+}
+
+void VehicleCargoList::ApplyAge()
+{
+	if (this->pending_age == 0) return;
+
+	/* The pending aging never makes a packet pass the maximum age and
+	 * it is already accounted for in the cache. */
+	byte headroom = 0xFF;
+	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
+		CargoPacket *cp = *it;
+		assert(cp->days_in_transit + this->pending_age <= 0xFF);
+		cp->days_in_transit += this->pending_age;
+		headroom = min(headroom, 0xFF - cp->days_in_transit);
 	}
+	this->pending_age = 0;
+	this->age_headroom = headroom;
 }
 
 void VehicleCargoList::InvalidateCache()
 {
 	this->feeder_share = 0;
+	this->ApplyAge();
+	this->age_headroom = 0xFF;
 	this->Parent::InvalidateCache();
 }
 
+/** The properties that have to be equal for station cargo packets to be merged. */
+struct CargoMergeKey {
+	TileIndex source_xy;    ///< The location of the source station
+	SourceType source_type; ///< The type of the source
+	SourceID source_id;     ///< The source
+
+	CargoMergeKey(const CargoPacket *cp) : source_xy(cp->SourceStationXY()), source_type(cp->SourceSubsidyType()), source_id(cp->SourceSubsidyID()) {}
+
+	bool operator <(const CargoMergeKey &other) const
+	{
+		if (this->source_xy != other.source_xy) return this->source_xy < other.source_xy;
+		if (this->source_type != other.source_type) return this->source_type < other.source_type;
+		return this->source_id < other.source_id;
+	}
+};
+
+void StationCargoList::Compact(uint max_days_diff)
+{
+	if (max_days_diff == 0 || this->packets.size() < 2) return;
+
+	/* For every key the packet the next ones are merged into. */
+	typedef std::map<CargoMergeKey, CargoPacket *> MergeMap;
+	MergeMap heads;
+
+	bool merged = false;
+	Iterator keep(this->packets.begin());
+	for (Iterator it(this->packets.begin()); it != this->packets.end(); ++it) {
+		CargoPacket *cp = *it;
+		std::pair<MergeMap::iterator, bool> ins = heads.insert(MergeMap::value_type(CargoMergeKey(cp), cp));
+		CargoPacket *head = ins.first->second;
+
+		if (!ins.second && (uint)abs(head->days_in_transit - cp->days_in_transit) <= max_days_diff &&
+				head->count + cp->count <= CargoPacket::MAX_COUNT) {
+			uint total = head->count + cp->count;
+			head->days_in_transit = (head->days_in_transit * head->count + cp->days_in_transit * cp->count + total / 2) / total;
+			head->count = total;
+			head->feeder_share += cp->feeder_share;
+			delete cp;
+			merged = true;
+			continue;
+		}
+
+		/* This packet is where the following ones of its kind are merged into. */
+		ins.first->second = cp;
+		*keep++ = cp;
+	}
+	this->packets.erase(keep, this->packets.end());
+
+	/* The rounded average changes the sum of the days in transit. */
+	if (merged) this->InvalidateCache();
+}
+
 /*
  * We have to instantiate everything we want to be usable.
  */
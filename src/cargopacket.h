@@ -17,14 +17,14 @@
 #include "station_type.h"
 #include "cargo_type.h"
 #include "vehicle_type.h"
-#include <list>
+#include <deque>
 
 /** Unique identifier for a single cargo packet. */
 typedef uint32 CargoPacketID;
 struct CargoPacket;
 
 /** Type of the pool for cargo packets. */
-typedef Pool<CargoPacket, CargoPacketID, 1024, 1048576, true, false> CargoPacketPool;
+typedef Pool<CargoPacket, CargoPacketID, 1024, 1048576, false, false, true> CargoPacketPool;
 /** The actual pool with cargo packets */
 extern CargoPacketPool _cargopacket_pool;
 
@@ -190,8 +190,12 @@ public:
 template <class Tinst>
 class CargoList {
 public:
-	/** Container with cargo packets */
-	typedef std::list<CargoPacket *> List;
+	/**
+	 * Container with cargo packets. The pointers are stored contiguously
+	 * (per block), which makes walking over them cheap; packets are
+	 * removed from it in one go instead of one by one.
+	 */
+	typedef std::deque<CargoPacket *> List;
 	/** The iterator for our container */
 	typedef List::iterator Iterator;
 	/** The const iterator for our container */
@@ -225,6 +229,12 @@ protected:
 	 */
 	void RemoveFromCache(const CargoPacket *cp);
 
+	/**
+	 * Bring the packets up to date before they are looked at or changed.
+	 * Lists that postpone work on their packets do it here.
+	 */
+	FORCEINLINE void ApplyAge() {}
+
 public:
 	/** Create the cargo list */
 	CargoList() {}
@@ -330,6 +340,8 @@ protected:
 	typedef CargoList<VehicleCargoList> Parent;
 
 	Money feeder_share; ///< Cache for the feeder share
+	byte pending_age;   ///< Number of times the cargo has been aged without updating the packets
+	byte age_headroom;  ///< Number of times the cargo can be aged before a packet reaches the maximum age
 
 	/**
 	 * Update the cache to reflect adding of this packet.
@@ -365,6 +377,12 @@ public:
 	 */
 	void AgeCargo();
 
+	/**
+	 * Applies the postponed aging to the packets of this list.
+	 * @note Must be called before the packets themselves are read.
+	 */
+	void ApplyAge();
+
 	/** Invalidates the cached data and rebuild it */
 	void InvalidateCache();
 
@@ -409,6 +427,14 @@ public:
 				cp1->source_type     == cp2->source_type &&
 				cp1->source_id       == cp2->source_id;
 	}
+
+	/**
+	 * Merges the packets that only differ a bit in the number of days they
+	 * have been in transit, regardless of where they are in the list.
+	 * The merged packet gets the average number of days of its parts.
+	 * @param max_days_diff how much the days in transit may differ
+	 */
+	void Compact(uint max_days_diff);
 };
 
 #endif /* CARGOPACKET_H */
@@ -17,6 +17,7 @@
 #include "network/network.h"
 #include "genworld.h"
 #include "newgrf_storage.h"
+#include "newgrf_station.h"
 #include "strings_func.h"
 #include "gfx_func.h"
 #include "functions.h"
@@ -26,7 +27,9 @@
 #include "company_func.h"
 #include "company_base.h"
 #include "signal_func.h"
+#include "road_func.h"
 #include "core/backup_type.hpp"
+#include "window_func.h"
 
 #include "table/strings.h"
 
@@ -297,13 +300,13 @@ static const Command _command_proc_table[] = {
 	DEF_CMD(CmdOrderRefit,                                     0), // CMD_ORDER_REFIT
 	DEF_CMD(CmdCloneOrder,                                     0), // CMD_CLONE_ORDER
 
-	DEF_CMD(CmdClearArea,                            CMD_NO_TEST), // CMD_CLEAR_AREA; destroying multi-tile houses makes town rating differ between test and execution
+	DEF_CMD(CmdClearArea,         CMD_NO_TEST | CMD_TESTS_ITSELF), // CMD_CLEAR_AREA; destroying multi-tile houses makes town rating differ between test and execution
 
 	DEF_CMD(CmdMoneyCheat,                           CMD_OFFLINE), // CMD_MONEY_CHEAT
 	DEF_CMD(CmdBuildCanal,                              CMD_AUTO), // CMD_BUILD_CANAL
 	DEF_CMD(CmdCompanyCtrl,                        CMD_SPECTATOR), // CMD_COMPANY_CTRL
 
-	DEF_CMD(CmdLevelLand, CMD_ALL_TILES | CMD_NO_TEST | CMD_AUTO), // CMD_LEVEL_LAND; test run might clear tiles multiple times, in execution that only happens once
+	DEF_CMD(CmdLevelLand, CMD_ALL_TILES | CMD_NO_TEST | CMD_TESTS_ITSELF | CMD_AUTO), // CMD_LEVEL_LAND; test run might clear tiles multiple times, in execution that only happens once
 
 	DEF_CMD(CmdRefitRailVehicle,                               0), // CMD_REFIT_RAIL_VEHICLE
 	DEF_CMD(CmdRestoreOrderIndex,                              0), // CMD_RESTORE_ORDER_INDEX
@@ -549,7 +552,7 @@ bool DoCommandP(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd, CommandCallbac
  * @param cmd   the command cost to return.
  * @param clear whether to keep the storage changes or not.
  */
-#define return_dcpi(cmd, clear) { _docommand_recursive = 0; ClearStorageChanges(clear); return cmd; }
+#define return_dcpi(cmd, clear) { _docommand_recursive = 0; ClearStorageChanges(clear); InvalidateStationRelocationCache(); return cmd; }
 
 /*!
  * Helper function for the toplevel network safe docommand function for the current company.
@@ -570,6 +573,9 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 	assert(_docommand_recursive == 0);
 	_docommand_recursive = 1;
 
+	/* The windows are updated once the command is done. */
+	ScheduleInvalidationsScope schedule_invalidations;
+
 	/* Reset the state. */
 	_additional_cash_required = 0;
 
@@ -606,6 +612,15 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 	bool test_and_exec_can_differ = (cmd_flags & CMD_NO_TEST) != 0;
 	bool skip_test = _networking && (cmd & CMD_NO_TEST_IF_IN_NETWORK) != 0;
 
+	/* Commands that test every part of themselves while executing fail
+	 * in exactly the same way without a test run, and they check the
+	 * money themselves. For those, like clearing or levelling a large
+	 * area, the test run would only walk all tiles one more time, so it
+	 * is only done when the command is about to be sent to the server,
+	 * to not send commands that fail anyway. */
+	assert((cmd_flags & CMD_TESTS_ITSELF) == 0 || test_and_exec_can_differ);
+	if ((cmd_flags & CMD_TESTS_ITSELF) != 0 && (!_networking || (cmd & CMD_NETWORK_COMMAND) != 0)) skip_test = true;
+
 	/* Do we need to do a test run?
 	 * Basically we need to always do this, except when
 	 * the no-test-in-network flag is giving and we're
@@ -688,6 +703,7 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 		/* It could happen we removed rail, thus gained money, and deleted something else.
 		 * So make sure the signal buffer is empty even in this case */
 		UpdateSignalsInBuffer();
+		UpdateRoadVehPathCaches();
 		SetDParam(0, _additional_cash_required);
 		return_dcpi(CommandCost(STR_ERROR_NOT_ENOUGH_CASH_REQUIRES_CURRENCY), false);
 	}
@@ -700,8 +716,9 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 
 	SubtractMoneyFromCompany(res2);
 
-	/* update signals if needed */
+	/* update signals and road vehicle paths if needed */
 	UpdateSignalsInBuffer();
+	UpdateRoadVehPathCaches();
 
 	return_dcpi(res2, true);
 }
@@ -342,6 +342,7 @@ enum CommandFlags {
 	CMD_ALL_TILES = 0x10, ///< allow this command also on MP_VOID tiles
 	CMD_NO_TEST   = 0x20, ///< the command's output may differ between test and execute due to town rating changes etc.
 	CMD_NO_WATER  = 0x40, ///< set the DC_NO_WATER flag on this command
+	CMD_TESTS_ITSELF = 0x80, ///< the execution tests every part right before doing it and fails without changing anything when the test would fail, so the test run is only needed before sending the command to the server; implies CMD_NO_TEST
 };
 
 /**
@@ -20,6 +20,7 @@
 #include "economy_type.h"
 #include "tile_type.h"
 #include "settings_type.h"
+#include "vehicle_type.h"
 
 struct CompanyEconomyEntry {
 	Money income;
@@ -98,6 +99,7 @@ struct Company : CompanyPool::PoolItem<&_company_pool>, CompanyProperties {
 	EngineRenewList engine_renew_list; ///< Defined later
 	CompanySettings settings;          ///< settings specific for each company
 	uint16 *num_engines; ///< caches the number of engines of each type the company owns (no need to save this)
+	uint16 num_vehicles[VEH_COMPANY_END]; ///< caches the number of primary vehicles of each vehicle type the company owns (no need to save this)
 
 	static FORCEINLINE bool IsValidAiID(size_t index)
 	{
@@ -122,6 +124,21 @@ struct Company : CompanyPool::PoolItem<&_company_pool>, CompanyProperties {
 #define FOR_ALL_COMPANIES_FROM(var, start) FOR_ALL_ITEMS_FROM(Company, company_index, var, start)
 #define FOR_ALL_COMPANIES(var) FOR_ALL_COMPANIES_FROM(var, 0)
 
+/** Statistics of the vehicles and stations of a company, gathered for all companies at once. */
+struct CompanyAssetStats {
+	Money vehicle_value;           ///< Value of the vehicles that count for the company value
+	Money min_profit;              ///< Lowest profit last year of the primary vehicles older than two years
+	bool has_min_profit;           ///< Is there any primary vehicle older than two years?
+	uint profitable_vehicles;      ///< Number of primary vehicles that made a profit last year
+	uint station_facilities;       ///< Number of facilities of all stations
+	uint serviced_facilities;      ///< Number of facilities of the stations that have been serviced lately
+	uint16 num_vehicles[VEH_END];  ///< Number of primary vehicles of each type
+	uint16 num_buses;              ///< Number of primary road vehicles that are buses
+	uint16 num_stations[8];        ///< Number of stations with a facility, indexed by the bit of the facility
+};
+
+void GetCompanyAssetStats(CompanyAssetStats *stats);
+Money CalculateCompanyValue(const Company *c, const CompanyAssetStats *stats, bool including_loan = true);
 Money CalculateCompanyValue(const Company *c, bool including_loan = true);
 
 extern uint _next_competitor_start;
@@ -13,6 +13,7 @@
 #include "engine_base.h"
 #include "company_func.h"
 #include "company_gui.h"
+#include "graph_gui.h"
 #include "town.h"
 #include "news_func.h"
 #include "cmd_helper.h"
@@ -75,6 +76,7 @@ Company::~Company()
 void Company::PostDestructor(size_t index)
 {
 	InvalidateWindowData(WC_GRAPH_LEGEND, 0, (int)index);
+	InvalidateCompanyGraphs();
 	InvalidateWindowData(WC_PERFORMANCE_DETAIL, 0, (int)index);
 	InvalidateWindowData(WC_COMPANY_LEAGUE, 0, 0);
 	/* If the currently shown error message has this company in it, the close it. */
@@ -499,6 +501,7 @@ Company *DoStartupNewCompany(bool is_ai, CompanyID company = INVALID_COMPANY)
 	GeneratePresidentName(c);
 
 	SetWindowDirty(WC_GRAPH_LEGEND, 0);
+	InvalidateCompanyGraphs();
 	SetWindowDirty(WC_TOOLBAR_MENU, 0);
 	SetWindowDirty(WC_CLIENT_LIST, 0);
 
@@ -961,11 +964,7 @@ CommandCost CmdSetCompanyColour(TileIndex tile, DoCommandFlag flags, uint32 p1,
 		MarkWholeScreenDirty();
 
 		/* All graph related to companies use the company colour. */
-		InvalidateWindowData(WC_INCOME_GRAPH, 0);
-		InvalidateWindowData(WC_OPERATING_PROFIT, 0);
-		InvalidateWindowData(WC_DELIVERED_CARGO, 0);
-		InvalidateWindowData(WC_PERFORMANCE_HISTORY, 0);
-		InvalidateWindowData(WC_COMPANY_VALUE, 0);
+		InvalidateCompanyGraphs();
 
 		/* Company colour data is indirectly cached. */
 		Vehicle *v;
@@ -1842,25 +1842,15 @@ struct CompanyWindow : Window
 				break;
 
 			case CW_WIDGET_DESC_VEHICLE_COUNTS: {
-				uint amounts[] = { 0, 0, 0, 0 };
+				const uint16 *amounts = c->num_vehicles;
 				int y = r.top;
 
-				const Vehicle *v;
-				FOR_ALL_VEHICLES(v) {
-					if (v->owner == c->index) {
-						if (v->IsPrimaryVehicle()) {
-							assert((size_t)v->type < lengthof(amounts));
-							amounts[v->type]++;
-						}
-					}
-				}
-
 				if (amounts[0] + amounts[1] + amounts[2] + amounts[3] == 0) {
 					DrawString(r.left, r.right, y, STR_COMPANY_VIEW_VEHICLES_NONE);
 				} else {
-					assert_compile(lengthof(amounts) == lengthof(_company_view_vehicle_count_strings));
+					assert_compile(lengthof(c->num_vehicles) == lengthof(_company_view_vehicle_count_strings));
 
-					for (uint i = 0; i < lengthof(amounts); i++) {
+					for (uint i = 0; i < lengthof(c->num_vehicles); i++) {
 						if (amounts[i] != 0) {
 							SetDParam(0, amounts[i]);
 							DrawString(r.left, r.right, y, _company_view_vehicle_count_strings[i]);
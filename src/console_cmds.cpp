@@ -31,11 +31,17 @@
 #include "vehicle_func.h"
 #include "company_func.h"
 #include "company_base.h"
+#include "station_base.h"
 #include "gamelog.h"
 #include "ai/ai.hpp"
 #include "ai/ai_config.hpp"
 #include "newgrf.h"
 #include "console_func.h"
+#include "tick_profiler.h"
+#include "timeline.h"
+#include "memory_usage.h"
+#include "newgrf_profiling.h"
+#include "pathfinder/pf_recorder.h"
 
 #ifdef ENABLE_NETWORK
 	#include "table/strings.h"
@@ -1158,6 +1164,97 @@ DEF_CONSOLE_CMD(ConRescanAI)
 
 	return true;
 }
+
+DEF_CONSOLE_CMD(ConAIUsage)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the time, operations and memory each running AI uses. Usage: 'ai_usage'");
+		IConsoleHelp("Times are averages per tick the AI ran in; the object count is from the last garbage collection.");
+		return true;
+	}
+
+	if (_networking && !_network_server) {
+		IConsoleWarning("Only the server runs the AIs, so only the server knows what they use.");
+		return true;
+	}
+
+	char buf[4096];
+	char *p = &buf[0];
+	p = AI::GetConsoleUsage(p, lastof(buf));
+
+	p = &buf[0];
+	/* Print output line by line */
+	for (char *p2 = &buf[0]; *p2 != '\0'; p2++) {
+		if (*p2 == '\n') {
+			*p2 = '\0';
+			IConsolePrintF(CC_DEFAULT, "%s", p);
+			p = p2 + 1;
+		}
+	}
+
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConAIProfile)
+{
+	if (argc < 3 || argc > 4) {
+		IConsoleHelp("Profile where an AI spends its operations. Usage: 'ai_profile <company-id> start [<interval>] | stop | flat | tree'");
+		IConsoleHelp("'start' samples the running function every <interval> operations, 100 by default, and counts the calls to the API.");
+		IConsoleHelp("'flat' shows the samples per function and line, 'tree' the samples per call stack. Both also show the API calls.");
+		return true;
+	}
+
+	if (_networking && !_network_server) {
+		IConsoleWarning("Only the server can profile an AI.");
+		return true;
+	}
+
+	CompanyID company_id = (CompanyID)(atoi(argv[1]) - 1);
+	if (!Company::IsValidAiID(company_id)) {
+		IConsoleWarning("Company is not controlled by an AI.");
+		return true;
+	}
+
+	if (strcasecmp(argv[2], "start") == 0) {
+		uint interval = argc == 4 ? atoi(argv[3]) : 100;
+		if (!AI::StartProfile(company_id, interval)) {
+			IConsoleWarning("The AI is not running.");
+			return true;
+		}
+		IConsolePrint(CC_DEFAULT, "Profiling started.");
+		return true;
+	}
+	if (argc != 3) return false;
+
+	if (strcasecmp(argv[2], "stop") == 0) {
+		AI::StopProfile(company_id);
+		IConsolePrint(CC_DEFAULT, "Profiling stopped.");
+		return true;
+	}
+
+	bool tree = strcasecmp(argv[2], "tree") == 0;
+	if (!tree && strcasecmp(argv[2], "flat") != 0) return false;
+
+	static char buf[16384];
+	char *p = &buf[0];
+	p = AI::GetConsoleProfile(company_id, tree, p, lastof(buf));
+	if (p == &buf[0]) {
+		IConsoleWarning("The AI has not been profiled.");
+		return true;
+	}
+
+	p = &buf[0];
+	/* Print output line by line */
+	for (char *p2 = &buf[0]; *p2 != '\0'; p2++) {
+		if (*p2 == '\n') {
+			*p2 = '\0';
+			IConsolePrintF(CC_DEFAULT, "%s", p);
+			p = p2 + 1;
+		}
+	}
+
+	return true;
+}
 #endif /* ENABLE_AI */
 
 DEF_CONSOLE_CMD(ConGetSeed)
@@ -1210,9 +1307,11 @@ DEF_CONSOLE_CMD(ConAlias)
 DEF_CONSOLE_CMD(ConScreenShot)
 {
 	if (argc == 0) {
-		IConsoleHelp("Create a screenshot of the game. Usage: 'screenshot [big | no_con] [file name]'");
+		IConsoleHelp("Create a screenshot of the game. Usage: 'screenshot [big | tiles | no_con] [file name]'");
 		IConsoleHelp("'big' makes a screenshot of the whole map, 'no_con' hides the console to create "
 				"the screenshot. Screenshots of whole map are always drawn without console");
+		IConsoleHelp("'tiles' makes a screenshot of the whole map as a directory of small images for every "
+				"zoom level, for web map viewers. It is made in the background while the game goes on");
 		return true;
 	}
 
@@ -1226,6 +1325,10 @@ DEF_CONSOLE_CMD(ConScreenShot)
 			/* screenshot big [filename] */
 			type = SC_WORLD;
 			if (argc > 2) name = argv[2];
+		} else if (strcmp(argv[1], "tiles") == 0) {
+			/* screenshot tiles [filename] */
+			type = SC_TILES;
+			if (argc > 2) name = argv[2];
 		} else if (strcmp(argv[1], "no_con") == 0) {
 			/* screenshot no_con [filename] */
 			IConsoleClose();
@@ -1677,6 +1780,204 @@ DEF_CONSOLE_CMD(ConGamelogPrint)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConChunkStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the time spent on and the size of every chunk of the last save or load. Usage: 'chunk_stats'");
+		IConsoleHelp("Set the 'sl' debug level to 3 or higher to show them after every save and load.");
+		return true;
+	}
+
+	if (argc != 1) return false;
+
+	PrintChunkStatistics(true);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConCargoFlow)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the amounts of cargo that went through a station in the last months. Usage: 'cargo_flow <station-id>'");
+		IConsoleHelp("Also shows the source stations most of the cargo arrived from.");
+		return true;
+	}
+
+	if (argc != 2) return false;
+
+	const Station *st = Station::GetIfValid(atoi(argv[1]));
+	if (st == NULL) {
+		IConsoleError("Invalid station.");
+		return true;
+	}
+
+	for (CargoID c = 0; c < NUM_CARGO; c++) {
+		const CargoFlowStats &flow = st->goods[c].flow;
+		for (uint age = 0; age < CargoFlowStats::NUM_MONTHS; age++) {
+			const CargoFlowMonth &m = flow.Get(age);
+			if (m.loaded == 0 && m.delivered == 0 && m.transferred == 0) continue;
+			IConsolePrintF(CC_DEFAULT, "cargo %2d, %d month(s) ago: %u loaded, %u delivered, %u transferred", c, age, m.loaded, m.delivered, m.transferred);
+		}
+	}
+
+	for (const CargoFlowLink *l = st->flow_links; l != endof(st->flow_links); l++) {
+		if (l->current == 0 && l->last == 0) continue;
+		IConsolePrintF(CC_DEFAULT, "from station %u, cargo %2d: %u this month, %u last month", l->from, l->cargo, l->current, l->last);
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConNewGRFProfile)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the time spent in the sprite groups of each NewGRF. Usage: 'newgrf_profile [start | stop | reset]'");
+		IConsoleHelp("Measuring is started and stopped with 'start' and 'stop'; with 'reset' all collected measurements are discarded.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	if (argc == 2) {
+		if (strcasecmp(argv[1], "start") == 0) {
+			_newgrf_profiling = true;
+			IConsolePrint(CC_DEFAULT, "NewGRF profiling started.");
+		} else if (strcasecmp(argv[1], "stop") == 0) {
+			_newgrf_profiling = false;
+			IConsolePrint(CC_DEFAULT, "NewGRF profiling stopped.");
+		} else if (strcasecmp(argv[1], "reset") == 0) {
+			NewGRFProfileReset();
+			IConsolePrint(CC_DEFAULT, "NewGRF measurements reset.");
+		} else {
+			return false;
+		}
+		InvalidateWindowClassesData(WC_NEWGRF_PROFILE);
+		return true;
+	}
+
+	NewGRFProfilePrint();
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConNewGRFMemory)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the memory used by the sprite groups and texts of each NewGRF. Usage: 'newgrf_memory'");
+		return true;
+	}
+
+	NewGRFMemoryPrint();
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConMemoryUsage)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the memory used by the pools, the map, the caches, the NewGRFs, the AIs and saveload. Usage: 'memory'");
+		return true;
+	}
+
+	MemoryUsagePrint();
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConTickProfile)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the time spent in the different stages of the game loop. Usage: 'tick_profile [reset]'");
+		IConsoleHelp("With 'reset' all collected measurements are discarded.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	if (argc == 2) {
+		if (strcasecmp(argv[1], "reset") != 0) return false;
+		TickProfilerReset();
+		IConsolePrint(CC_DEFAULT, "Game loop measurements reset.");
+		return true;
+	}
+
+	TickProfilerPrint();
+	return true;
+}
+
+#ifdef WITH_TIMELINE
+DEF_CONSOLE_CMD(ConTimeline)
+{
+	if (argc == 0) {
+		IConsoleHelp("Record a timeline of the game loop, pathfinder, saveload, network and drawing. Usage: 'timeline start | stop | dump <file>'");
+		IConsoleHelp("The dump is written to the autosave directory in the format of Chrome's trace viewer (chrome://tracing).");
+		return true;
+	}
+
+	if (argc == 2 && strcasecmp(argv[1], "start") == 0) {
+		TimelineStart();
+		IConsolePrint(CC_DEFAULT, "Recording the timeline.");
+		return true;
+	}
+
+	if (argc == 2 && strcasecmp(argv[1], "stop") == 0) {
+		TimelineStop();
+		IConsolePrint(CC_DEFAULT, "Stopped recording the timeline.");
+		return true;
+	}
+
+	if (argc == 3 && strcasecmp(argv[1], "dump") == 0) {
+		TimelineStop();
+		if (!TimelineDump(argv[2])) {
+			IConsolePrintF(CC_ERROR, "Cannot open '%s' for writing.", argv[2]);
+			return true;
+		}
+		IConsolePrintF(CC_DEFAULT, "Timeline written to '%s'.", argv[2]);
+		return true;
+	}
+
+	return false;
+}
+#endif /* WITH_TIMELINE */
+
+DEF_CONSOLE_CMD(ConPathfinderRecord)
+{
+	if (argc == 0) {
+		IConsoleHelp("Record all pathfinder queries to a file in the autosave directory. Usage: 'pf_record <file> | stop'");
+		IConsoleHelp("The queries can be measured again later with 'pf_replay' on the game they were recorded in.");
+		return true;
+	}
+
+	if (argc != 2) return false;
+
+	if (strcasecmp(argv[1], "stop") == 0) {
+		StopRecordingPathfinderQueries();
+		IConsolePrint(CC_DEFAULT, "Stopped recording pathfinder queries.");
+		return true;
+	}
+
+	if (!StartRecordingPathfinderQueries(argv[1])) {
+		IConsolePrintF(CC_ERROR, "Cannot open '%s' for writing.", argv[1]);
+		return true;
+	}
+	IConsolePrintF(CC_DEFAULT, "Recording pathfinder queries to '%s'.", argv[1]);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConPathfinderReplay)
+{
+	if (argc == 0) {
+		IConsoleHelp("Ask recorded pathfinder queries again with every pathfinder and show how long they take. Usage: 'pf_replay <file>'");
+		IConsoleHelp("Load the game the queries were recorded in first; queries of vehicles that moved on are skipped.");
+		return true;
+	}
+
+	if (argc != 2) return false;
+
+	if (IsRecordingPathfinderQueries()) {
+		IConsolePrint(CC_ERROR, "Stop recording pathfinder queries first.");
+		return true;
+	}
+
+	if (!ReplayPathfinderQueries(argv[1])) IConsolePrintF(CC_ERROR, "Cannot open '%s' for reading.", argv[1]);
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConNewGRFReload)
 {
 	if (argc == 0) {
@@ -1741,6 +2042,17 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("setting_newgame", ConSettingNewgame);
 	IConsoleCmdRegister("list_settings",ConListSettings);
 	IConsoleCmdRegister("gamelog",      ConGamelogPrint);
+	IConsoleCmdRegister("tick_profile", ConTickProfile);
+#ifdef WITH_TIMELINE
+	IConsoleCmdRegister("timeline",     ConTimeline);
+#endif
+	IConsoleCmdRegister("newgrf_profile", ConNewGRFProfile);
+	IConsoleCmdRegister("newgrf_memory",  ConNewGRFMemory);
+	IConsoleCmdRegister("memory",       ConMemoryUsage);
+	IConsoleCmdRegister("chunk_stats",  ConChunkStats);
+	IConsoleCmdRegister("cargo_flow",   ConCargoFlow);
+	IConsoleCmdRegister("pf_record",    ConPathfinderRecord);
+	IConsoleCmdRegister("pf_replay",    ConPathfinderReplay);
 
 	IConsoleAliasRegister("dir",          "ls");
 	IConsoleAliasRegister("del",          "rm %+");
@@ -1759,6 +2071,8 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("rescan_ai",    ConRescanAI);
 	IConsoleCmdRegister("start_ai",     ConStartAI);
 	IConsoleCmdRegister("stop_ai",      ConStopAI);
+	IConsoleCmdRegister("ai_usage",     ConAIUsage);
+	IConsoleCmdRegister("ai_profile",   ConAIProfile);
 #endif /* ENABLE_AI */
 
 	/* networking functions */
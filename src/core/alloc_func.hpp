@@ -21,6 +21,13 @@
 void NORETURN MallocError(size_t size);
 void NORETURN ReallocError(size_t size);
 
+#ifdef WITH_ALLOC_PROFILING
+void AllocProfilerCount(size_t size);
+#else
+/** Without allocation profiling there is nothing to count. */
+static FORCEINLINE void AllocProfilerCount(size_t size) { }
+#endif /* WITH_ALLOC_PROFILING */
+
 /**
  * Simplified allocation function that allocates the specified number of
  * elements of the given type. It also explicitly casts it to the requested
@@ -41,6 +48,7 @@ static FORCEINLINE T *MallocT(size_t num_elements)
 	 */
 	if (num_elements == 0) return NULL;
 
+	AllocProfilerCount(num_elements * sizeof(T));
 	T *t_ptr = (T*)malloc(num_elements * sizeof(T));
 	if (t_ptr == NULL) MallocError(num_elements * sizeof(T));
 	return t_ptr;
@@ -66,6 +74,7 @@ static FORCEINLINE T *CallocT(size_t num_elements)
 	 */
 	if (num_elements == 0) return NULL;
 
+	AllocProfilerCount(num_elements * sizeof(T));
 	T *t_ptr = (T*)calloc(num_elements, sizeof(T));
 	if (t_ptr == NULL) MallocError(num_elements * sizeof(T));
 	return t_ptr;
@@ -95,6 +104,7 @@ static FORCEINLINE T *ReallocT(T *t_ptr, size_t num_elements)
 		return NULL;
 	}
 
+	AllocProfilerCount(num_elements * sizeof(T));
 	t_ptr = (T*)realloc(t_ptr, num_elements * sizeof(T));
 	if (t_ptr == NULL) ReallocError(num_elements * sizeof(T));
 	return t_ptr;
@@ -17,8 +17,8 @@
 #include "pool_type.hpp"
 
 #define DEFINE_POOL_METHOD(type) \
-	template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, bool Tcache, bool Tzero> \
-	type Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tcache, Tzero>
+	template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, bool Tcache, bool Tzero, bool Tslab> \
+	type Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tcache, Tzero, Tslab>
 
 DEFINE_POOL_METHOD(inline)::Pool(const char *name) :
 		name(name),
@@ -28,6 +28,8 @@ DEFINE_POOL_METHOD(inline)::Pool(const char *name) :
 		items(0),
 		cleaning(false),
 		data(NULL),
+		slabs(NULL),
+		used(NULL),
 		alloc_cache(NULL)
 { }
 
@@ -41,22 +43,34 @@ DEFINE_POOL_METHOD(inline void)::ResizeFor(size_t index)
 	this->data = ReallocT(this->data, new_size);
 	MemSetT(this->data + this->size, 0, new_size - this->size);
 
+	size_t old_words = CeilDiv(this->size, 32);
+	size_t new_words = CeilDiv(new_size, 32);
+	this->used = ReallocT(this->used, new_words);
+	MemSetT(this->used + old_words, 0, new_words - old_words);
+
+	if (Tslab) {
+		size_t old_slabs = CeilDiv(this->size, Tgrowth_step);
+		size_t new_slabs = CeilDiv(new_size, Tgrowth_step);
+		this->slabs = ReallocT(this->slabs, new_slabs);
+		MemSetT(this->slabs + old_slabs, 0, new_slabs - old_slabs);
+	}
+
 	this->size = new_size;
 }
 
 DEFINE_POOL_METHOD(inline size_t)::FindFirstFree()
 {
-	size_t index = this->first_free;
-
-	for (; index < this->first_unused; index++) {
-		if (this->data[index] == NULL) return index;
+	/* All indices before first_free are in use, so start at its word
+	 * and skip the words that are completely in use. */
+	size_t words = CeilDiv(this->size, 32);
+	for (size_t word = this->first_free / 32; word < words; word++) {
+		if (this->used[word] == 0xFFFFFFFF) continue;
+
+		size_t index = word * 32 + FindFirstBit(~this->used[word]);
+		if (index < this->size) return index;
 	}
 
-	if (index < this->size) {
-		return index;
-	}
-
-	assert(index == this->size);
+	size_t index = this->size;
 	assert(this->first_unused == this->size);
 
 	if (index < Tmax_size) {
@@ -77,7 +91,13 @@ DEFINE_POOL_METHOD(inline void *)::AllocateItem(size_t size, size_t index)
 	this->items++;
 
 	Titem *item;
-	if (Tcache && this->alloc_cache != NULL) {
+	if (Tslab) {
+		assert(sizeof(Titem) == size);
+		byte *&slab = this->slabs[index / Tgrowth_step];
+		if (slab == NULL) slab = MallocT<byte>(Tgrowth_step * sizeof(Titem));
+		item = (Titem *)(slab + (index % Tgrowth_step) * sizeof(Titem));
+		if (Tzero) MemSetT(item, 0);
+	} else if (Tcache && this->alloc_cache != NULL) {
 		assert(sizeof(Titem) == size);
 		item = (Titem *)this->alloc_cache;
 		this->alloc_cache = this->alloc_cache->next;
@@ -88,6 +108,7 @@ DEFINE_POOL_METHOD(inline void *)::AllocateItem(size_t size, size_t index)
 		item = (Titem *)MallocT<byte>(size);
 	}
 	this->data[index] = item;
+	SetBit(this->used[index / 32], index % 32);
 	item->index = (uint)index;
 	return item;
 }
@@ -123,7 +144,9 @@ DEFINE_POOL_METHOD(void)::FreeItem(size_t index)
 {
 	assert(index < this->size);
 	assert(this->data[index] != NULL);
-	if (Tcache) {
+	if (Tslab) {
+		/* The memory stays in its slab, to be reused by the next item with this index. */
+	} else if (Tcache) {
 		AllocCache *ac = (AllocCache *)this->data[index];
 		ac->next = this->alloc_cache;
 		this->alloc_cache = ac;
@@ -131,6 +154,7 @@ DEFINE_POOL_METHOD(void)::FreeItem(size_t index)
 		free(this->data[index]);
 	}
 	this->data[index] = NULL;
+	ClrBit(this->used[index / 32], index % 32);
 	this->first_free = min(this->first_free, index);
 	this->items--;
 	if (!this->cleaning) Titem::PostDestructor(index);
@@ -143,9 +167,16 @@ DEFINE_POOL_METHOD(void)::CleanPool()
 		delete this->Get(i); // 'delete NULL;' is very valid
 	}
 	assert(this->items == 0);
+	if (Tslab) {
+		for (size_t i = 0; i < CeilDiv(this->size, Tgrowth_step); i++) free(this->slabs[i]);
+		free(this->slabs);
+		this->slabs = NULL;
+	}
 	free(this->data);
+	free(this->used);
 	this->first_unused = this->first_free = this->size = 0;
 	this->data = NULL;
+	this->used = NULL;
 	this->cleaning = false;
 
 	if (Tcache) {
@@ -12,6 +12,9 @@
 #ifndef POOL_TYPE_HPP
 #define POOL_TYPE_HPP
 
+#include "bitmath_func.hpp"
+#include "math_func.hpp"
+
 /**
  * Base class for all pools.
  * @tparam Titem        Type of the class/struct that is going to be pooled
@@ -20,9 +23,11 @@
  * @tparam Tmax_size    Maximum size of the pool
  * @tparam Tcache       Whether to perform 'alloc' caching, i.e. don't actually free/malloc just reuse the memory
  * @tparam Tzero        Whether to zero the memory
- * @warning when Tcache is enabled *all* instances of this pool's item must be of the same size.
+ * @tparam Tslab        Whether to allocate the items in contiguous chunks of \a Tgrowth_step items, so
+ *                      iterating the pool goes through sequential memory; freed items are reused in place
+ * @warning when Tcache or Tslab is enabled *all* instances of this pool's item must be of the same size.
  */
-template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, bool Tcache = false, bool Tzero = true>
+template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, bool Tcache = false, bool Tzero = true, bool Tslab = false>
 struct Pool {
 	static const size_t MAX_SIZE = Tmax_size; ///< Make template parameter accessible from outside
 
@@ -36,6 +41,8 @@ struct Pool {
 	bool cleaning;       ///< True if cleaning pool (deleting all items)
 
 	Titem **data;        ///< Pointer to array of pointers to Titem
+	byte **slabs;        ///< Memory of the items when \a Tslab is set, chunks of \a Tgrowth_step items allocated when first needed
+	uint32 *used;        ///< Bitmap of the indices that are in use, one bit per index
 
 	/** Constructor */
 	Pool(const char *name);
@@ -64,6 +71,44 @@ struct Pool {
 		return index < this->first_unused && this->Get(index) != NULL;
 	}
 
+	/**
+	 * Get the number of bytes used by the pool and its items.
+	 * @return the memory usage in bytes
+	 * @note Items are counted as \a Titem, so subclasses that are larger are undercounted.
+	 */
+	size_t GetMemoryUsage() const
+	{
+		size_t bytes = this->size * sizeof(Titem *) + CeilDiv(this->size, 32) * sizeof(uint32);
+		if (Tslab) {
+			size_t num_slabs = CeilDiv(this->size, Tgrowth_step);
+			bytes += num_slabs * sizeof(byte *);
+			for (size_t i = 0; i < num_slabs; i++) {
+				if (this->slabs[i] != NULL) bytes += Tgrowth_step * sizeof(Titem);
+			}
+		} else {
+			bytes += this->items * sizeof(Titem);
+		}
+		return bytes;
+	}
+
+	/**
+	 * Searches for the first index in use, starting at the given index.
+	 * Whole words of free indices are skipped at once, so iterating
+	 * a sparse pool only touches its valid items.
+	 * @param index index to start searching at
+	 * @return first valid index >= \a index, or first_unused if there is none
+	 */
+	FORCEINLINE size_t GetNextUsed(size_t index)
+	{
+		while (index < this->first_unused) {
+			uint32 bits = this->used[index / 32] >> (index % 32);
+			if (bits & 1) return index;
+			if (bits != 0) return index + FindFirstBit(bits);
+			index = (index | 31) + 1;
+		}
+		return this->first_unused;
+	}
+
 	/**
 	 * Tests whether we can allocate 'n' items
 	 * @param n number of items we want to allocate
@@ -78,7 +123,7 @@ struct Pool {
 	 * Base class for all PoolItems
 	 * @tparam Tpool The pool this item is going to be part of
 	 */
-	template <struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tcache, Tzero> *Tpool>
+	template <struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tcache, Tzero, Tslab> *Tpool>
 	struct PoolItem {
 		Tindex index; ///< Index of this pool item
 
@@ -204,6 +249,17 @@ struct Pool {
 			return Tpool->first_unused;
 		}
 
+		/**
+		 * Returns the first valid index at or after the given index.
+		 * Useful when iterating over all pool items.
+		 * @param index index to start searching at
+		 * @return first valid index, or GetPoolSize() if there is none
+		 */
+		static FORCEINLINE size_t GetNextIndex(size_t index)
+		{
+			return Tpool->GetNextUsed(index);
+		}
+
 		/**
 		 * Returns number of valid items in the pool
 		 * @return number of valid items in the pool
@@ -288,7 +344,7 @@ private:
 };
 
 #define FOR_ALL_ITEMS_FROM(type, iter, var, start) \
-	for (size_t iter = start; var = NULL, iter < type::GetPoolSize(); iter++) \
+	for (size_t iter = type::GetNextIndex(start); var = NULL, iter < type::GetPoolSize(); iter = type::GetNextIndex(iter + 1)) \
 		if ((var = type::Get(iter)) != NULL)
 
 #define FOR_ALL_ITEMS(type, iter, var) FOR_ALL_ITEMS_FROM(type, iter, var, 0)
@@ -13,6 +13,7 @@
 #define SMALLMAP_TYPE_HPP
 
 #include "smallvec_type.hpp"
+#include "alloc_func.hpp"
 #include "sort_func.hpp"
 
 /** Simple pair of data. Both types have to be POD ("Plain Old Data")! */
@@ -118,4 +119,219 @@ struct SmallMap : SmallVector<SmallPair<T, U>, S> {
 	}
 };
 
+/**
+ * Hash of a key of a HashedSmallMap.
+ * @param key the key to hash
+ * @return the hash; only its upper bits are well mixed
+ */
+template <typename T>
+static FORCEINLINE uint32 SmallMapHash(const T &key)
+{
+	return (uint32)key * 0x9E3779B9U;
+}
+
+/**
+ * Hash of a pointer key of a HashedSmallMap.
+ * @param key the key to hash
+ * @return the hash; only its upper bits are well mixed
+ */
+template <typename T>
+static FORCEINLINE uint32 SmallMapHash(T *key)
+{
+	return (uint32)((size_t)key >> 3) * 0x9E3779B9U;
+}
+
+/**
+ * Mapping class like SmallMap, that switches from linear searching to an
+ * open-addressing hash table over the positions of its pairs when it gets
+ * more than \a Tthreshold items. The pairs stay in a SmallVector, so
+ * iterating works as for SmallMap.
+ * @note Only modify it via its own methods, not via the inherited Append() or SmallVector::Erase().
+ */
+template <typename T, typename U, uint S = 16, uint Tthreshold = 16>
+struct HashedSmallMap : SmallMap<T, U, S> {
+	typedef SmallMap<T, U, S> Base;
+	typedef typename Base::Pair Pair;
+	typedef Pair *iterator;
+	typedef const Pair *const_iterator;
+
+	uint32 *slots;   ///< For each slot of the hash table the position of its pair plus one, 0 for an empty slot; NULL while searching linearly.
+	uint slot_bits;  ///< The hash table has 2^slot_bits slots.
+
+	/** Creates new HashedSmallMap, that searches linearly. */
+	FORCEINLINE HashedSmallMap() : slots(NULL), slot_bits(0) { }
+	/** The pairs are freed in SmallVector destructor */
+	FORCEINLINE ~HashedSmallMap() { free(this->slots); }
+
+	/** Remove all items, but keep the memory of the pairs. */
+	FORCEINLINE void Clear()
+	{
+		Base::Clear();
+		this->ResetSlots();
+	}
+
+	/** Remove all items and free all memory. */
+	FORCEINLINE void Reset()
+	{
+		Base::Reset();
+		this->ResetSlots();
+	}
+
+	/** Finds given key in this map
+	 * @param key key to find
+	 * @return &Pair(key, data) if found, this->End() if not
+	 */
+	FORCEINLINE Pair *Find(const T &key)
+	{
+		if (this->slots == NULL) return Base::Find(key);
+		uint32 pos = this->slots[this->FindSlot(key)];
+		return pos == 0 ? this->End() : &this->data[pos - 1];
+	}
+
+	/** Removes given pair from this map
+	 * @param pair pair to remove
+	 * @note it has to be pointer to pair in this map. It is overwritten by the last item.
+	 */
+	FORCEINLINE void Erase(Pair *pair)
+	{
+		assert(pair >= this->Begin() && pair < this->End());
+		if (this->slots != NULL) {
+			this->ClearSlot(this->FindSlot(pair->first));
+			Pair *last = this->End() - 1;
+			if (pair != last) this->slots[this->FindSlot(last->first)] = (uint32)(pair - this->Begin()) + 1;
+		}
+		*pair = this->data[--this->items];
+	}
+
+	/** Removes given key from this map
+	 * @param key key to remove
+	 * @return true iff the key was found
+	 * @note last item is moved to its place, so don't increase your iterator if true is returned!
+	 */
+	FORCEINLINE bool Erase(const T &key)
+	{
+		Pair *pair = this->Find(key);
+		if (pair == this->End()) return false;
+		this->Erase(pair);
+		return true;
+	}
+
+	/** Adds new item to this map.
+	 * @param key key
+	 * @param data data
+	 * @return true iff the key wasn't already present
+	 */
+	FORCEINLINE bool Insert(const T &key, const U &data)
+	{
+		if (this->Find(key) != this->End()) return false;
+		Pair *n = this->Append();
+		n->first = key;
+		n->second = data;
+		this->AddLast();
+		return true;
+	}
+
+	/** Returns data belonging to this key
+	 * @param key key
+	 * @return data belonging to this key
+	 * @note if this key wasn't present, new entry is created
+	 */
+	FORCEINLINE U &operator[](const T &key)
+	{
+		Pair *pair = this->Find(key);
+		if (pair != this->End()) return pair->second;
+		Pair *n = this->Append();
+		n->first = key;
+		this->AddLast();
+		return this->data[this->items - 1].second;
+	}
+
+	FORCEINLINE void SortByKey()
+	{
+		Base::SortByKey();
+		if (this->slots != NULL) this->Rehash();
+	}
+
+private:
+	/** Go back to searching linearly. */
+	FORCEINLINE void ResetSlots()
+	{
+		free(this->slots);
+		this->slots = NULL;
+		this->slot_bits = 0;
+	}
+
+	/**
+	 * Get the slot a key hashes to.
+	 * @param key the key
+	 * @return the first slot to look for the key
+	 */
+	FORCEINLINE uint HomeSlot(const T &key) const
+	{
+		return SmallMapHash(key) >> (32 - this->slot_bits);
+	}
+
+	/**
+	 * Find the slot of a key, or the empty slot it would be put in.
+	 * @param key the key
+	 * @return the slot
+	 */
+	FORCEINLINE uint FindSlot(const T &key) const
+	{
+		uint mask = (1U << this->slot_bits) - 1;
+		for (uint i = this->HomeSlot(key);; i = (i + 1) & mask) {
+			uint32 pos = this->slots[i];
+			if (pos == 0 || this->data[pos - 1].first == key) return i;
+		}
+	}
+
+	/**
+	 * Empty a slot and move the slots after it back, so every key can
+	 * still be found from its home slot without passing an empty slot.
+	 * @param i the slot to empty
+	 */
+	void ClearSlot(uint i)
+	{
+		uint mask = (1U << this->slot_bits) - 1;
+		this->slots[i] = 0;
+		for (uint j = (i + 1) & mask; this->slots[j] != 0; j = (j + 1) & mask) {
+			uint home = this->HomeSlot(this->data[this->slots[j] - 1].first);
+			/* Slot j can move to i when its home is not cyclically in (i, j]. */
+			if (((j - home) & mask) >= ((j - i) & mask)) {
+				this->slots[i] = this->slots[j];
+				this->slots[j] = 0;
+				i = j;
+			}
+		}
+	}
+
+	/** Put the position of the last pair in the hash table, switching to hashing when needed. */
+	FORCEINLINE void AddLast()
+	{
+		if (this->slots == NULL) {
+			if (this->items > Tthreshold) this->Rehash();
+			return;
+		}
+		/* Keep the table at most half full. */
+		if (this->items * 2 > (1U << this->slot_bits)) {
+			this->Rehash();
+			return;
+		}
+		this->slots[this->FindSlot(this->data[this->items - 1].first)] = this->items;
+	}
+
+	/** (Re)build the hash table for all pairs. */
+	void Rehash()
+	{
+		this->slot_bits = 1;
+		while ((1U << this->slot_bits) < this->items * 4) this->slot_bits++;
+
+		free(this->slots);
+		this->slots = CallocT<uint32>(1U << this->slot_bits);
+		for (uint i = 0; i < this->items; i++) {
+			this->slots[this->FindSlot(this->data[i].first)] = i + 1;
+		}
+	}
+};
+
 #endif /* SMALLMAP_TYPE_HPP */
@@ -297,7 +297,7 @@ bool CrashLog::WriteSavegame(char *filename, const char *filename_last) const
 {
 	/* If the map array doesn't exist, saving will fail too. If the map got
 	 * initialised, there is a big chance the rest is initialised too. */
-	if (_m == NULL) return false;
+	if (MapSize() == 0) return false;
 
 	try {
 		GamelogEmergency();
@@ -328,6 +328,9 @@ bool CrashLog::MakeCrashLog() const
 	if (crashlogged) return false;
 	crashlogged = true;
 
+	/* Get the debug output that was logged just before the crash out first. */
+	DebugFlushWriter();
+
 	char filename[MAX_PATH];
 	char buffer[65536];
 	bool ret = true;
@@ -20,6 +20,7 @@
 #include "debug.h"
 #include "rail_gui.h"
 #include "saveload/saveload.h"
+#include "tick_profiler.h"
 
 Year      _cur_year;   ///< Current year, starting at 0
 Month     _cur_month;  ///< Current month (0..11)
@@ -270,7 +271,9 @@ void IncreaseDate()
 
 	/* increase day counter and call various daily loops */
 	_date++;
+	TickProfilerStart(TPE_DAILY_LOOP);
 	OnNewDay();
+	TickProfilerStop(TPE_DAILY_LOOP);
 
 	YearMonthDay ymd;
 
@@ -280,12 +283,16 @@ void IncreaseDate()
 
 	/* yes, call various monthly loops */
 	_cur_month = ymd.month;
+	TickProfilerStart(TPE_MONTHLY_LOOP);
 	OnNewMonth();
+	TickProfilerStop(TPE_MONTHLY_LOOP);
 
 	/* check if we entered a new year? */
 	if (ymd.year == _cur_year) return;
 
 	/* yes, call various yearly loops */
 	_cur_year = ymd.year;
+	TickProfilerStart(TPE_YEARLY_LOOP);
 	OnNewYear();
+	TickProfilerStop(TPE_YEARLY_LOOP);
 }
@@ -16,6 +16,8 @@
 #include "string_func.h"
 #include "fileio_func.h"
 #include "settings_type.h"
+#include "gfx_func.h"
+#include "thread/thread.h"
 
 #include <time.h>
 
@@ -69,14 +71,132 @@ struct DebugLevel {
 
 #if !defined(NO_DEBUG_MESSAGES)
 
+/** Where a debug line goes to. */
+enum DebugLineTarget {
+	DLT_STDERR,  ///< The standard error output.
+	DLT_SOCKET,  ///< The debug socket.
+	DLT_DESYNC,  ///< The log of the commands for debugging desyncs.
+};
+
+/** A debug line that is waiting to be written. */
+struct DebugLine {
+	DebugLineTarget target; ///< Where the line goes to.
+	char text[1024 + 64];   ///< The formatted line, including its prefix and newline.
+};
+
+/** The number of lines that can wait to be written; when full a thread that logs waits for a free line. */
+static const uint DEBUG_QUEUE_SIZE = 512;
+
+static DebugLine _debug_queue[DEBUG_QUEUE_SIZE]; ///< The lines waiting to be written.
+static uint _debug_queue_first = 0;              ///< The first line that waits.
+static uint _debug_queue_count = 0;              ///< The number of lines that wait.
+static bool _debug_writing = false;              ///< Whether the writer thread is writing a line it took from the queue.
+static bool _debug_writer_exit = false;          ///< Whether the writer thread has to stop once the queue is empty.
+static ThreadMutex *_debug_mutex = NULL;         ///< Guards the queue; NULL when lines are written directly.
+static ThreadObject *_debug_writer = NULL;       ///< The thread that writes the lines.
+
+/**
+ * Write a line to its target.
+ * @param line The line to write.
+ */
+static void WriteDebugLine(const DebugLine *line)
+{
+	switch (line->target) {
+#if defined(ENABLE_NETWORK)
+		case DLT_SOCKET:
+			send(_debug_socket, line->text, (int)strlen(line->text), 0);
+			break;
+#endif /* ENABLE_NETWORK */
+
+		case DLT_DESYNC: {
+			static FILE *f = FioFOpenFile("commands-out.log", "wb", AUTOSAVE_DIR);
+			if (f == NULL) return;
+
+			fputs(line->text, f);
+			fflush(f);
+			break;
+		}
+
+		default:
+			fputs(line->text, stderr);
+			break;
+	}
+}
+
+/**
+ * Write the queued lines, in the order they were logged, until told to stop.
+ * @param param Unused.
+ */
+static void DebugWriterThread(void *param)
+{
+	DebugLine line;
+
+	_debug_mutex->BeginCritical();
+	for (;;) {
+		while (_debug_queue_count == 0 && !_debug_writer_exit) _debug_mutex->WaitForSignal();
+		if (_debug_queue_count == 0) break;
+
+		line = _debug_queue[_debug_queue_first];
+		_debug_queue_first = (_debug_queue_first + 1) % DEBUG_QUEUE_SIZE;
+		_debug_queue_count--;
+		_debug_writing = true;
+
+		/* Logging threads can continue while the line is written. */
+		_debug_mutex->EndCritical();
+		WriteDebugLine(&line);
+		_debug_mutex->BeginCritical();
+
+		_debug_writing = false;
+	}
+	_debug_mutex->EndCritical();
+}
+
+/**
+ * Queue a line to be written by the writer thread, or write it
+ * directly when there is no writer thread.
+ * @param target Where the line goes to.
+ * @param dbg    The category of the line.
+ * @param buf    The text of the line.
+ */
+static void QueueDebugLine(DebugLineTarget target, const char *dbg, const char *buf)
+{
+	DebugLine direct;
+	DebugLine *line = &direct;
+
+	if (_debug_mutex != NULL) {
+		_debug_mutex->BeginCritical();
+		while (_debug_queue_count == DEBUG_QUEUE_SIZE) {
+			/* The writer can't keep up; wait till it made room. */
+			_debug_mutex->EndCritical();
+			CSleep(1);
+			_debug_mutex->BeginCritical();
+		}
+		line = &_debug_queue[(_debug_queue_first + _debug_queue_count) % DEBUG_QUEUE_SIZE];
+	}
+
+	/* The prefix is made while holding the lock, as GetLogPrefix uses a static buffer. */
+	line->target = target;
+	if (target == DLT_DESYNC) {
+		snprintf(line->text, lengthof(line->text), "%s%s\n", GetLogPrefix(), buf);
+	} else {
+		snprintf(line->text, lengthof(line->text), "%sdbg: [%s] %s\n", GetLogPrefix(), dbg, buf);
+	}
+
+	if (_debug_mutex == NULL) {
+		WriteDebugLine(line);
+		return;
+	}
+
+	_debug_queue_count++;
+	_debug_mutex->SendSignal();
+	_debug_mutex->EndCritical();
+}
+
 static void debug_print(const char *dbg, const char *buf)
 {
 #if defined(ENABLE_NETWORK)
 	if (_debug_socket != INVALID_SOCKET) {
-		char buf2[1024 + 32];
-
-		snprintf(buf2, lengthof(buf2), "%sdbg: [%s] %s\n", GetLogPrefix(), dbg, buf);
-		send(_debug_socket, buf2, (int)strlen(buf2), 0);
+		QueueDebugLine(DLT_SOCKET, dbg, buf);
 		return;
 	}
 #endif /* ENABLE_NETWORK */
@@ -87,15 +207,11 @@ static void debug_print(const char *dbg, const char *buf)
 		_sntprintf(tbuf, sizeof(tbuf), _T("%s"), OTTD2FS(dbg));
 		NKDbgPrintfW(_T("dbg: [%s] %s\n"), tbuf, OTTD2FS(buf));
 #else
-		fprintf(stderr, "%sdbg: [%s] %s\n", GetLogPrefix(), dbg, buf);
+		QueueDebugLine(DLT_STDERR, dbg, buf);
 #endif
 		IConsoleDebug(dbg, buf);
 	} else {
-		static FILE *f = FioFOpenFile("commands-out.log", "wb", AUTOSAVE_DIR);
-		if (f == NULL) return;
-
-		fprintf(f, "%s%s\n", GetLogPrefix(), buf);
-		fflush(f);
+		QueueDebugLine(DLT_DESYNC, dbg, buf);
 	}
 }
 
@@ -110,6 +226,81 @@ void CDECL debug(const char *dbg, const char *format, ...)
 
 	debug_print(dbg, buf);
 }
+
+/**
+ * Start the thread that writes the debug lines, so logging threads only
+ * have to format their lines. Without threads the lines are written by
+ * the logging thread itself.
+ */
+void DebugStartWriter()
+{
+	if (_debug_mutex != NULL) return;
+
+	_debug_mutex = ThreadMutex::New();
+	_debug_writer_exit = false;
+	if (!ThreadObject::New(&DebugWriterThread, NULL, &_debug_writer)) {
+		delete _debug_mutex;
+		_debug_mutex = NULL;
+	}
+}
+
+/** Write all queued debug lines and stop the thread that writes them. */
+void DebugStopWriter()
+{
+	if (_debug_mutex == NULL) return;
+
+	_debug_mutex->BeginCritical();
+	_debug_writer_exit = true;
+	_debug_mutex->SendSignal();
+	_debug_mutex->EndCritical();
+
+	_debug_writer->Join();
+	delete _debug_writer;
+	_debug_writer = NULL;
+
+	/* The writer wrote everything, so from now on lines are written directly. */
+	ThreadMutex *mutex = _debug_mutex;
+	_debug_mutex = NULL;
+	delete mutex;
+}
+
+/**
+ * Write the debug lines directly from now on, in a child made with fork().
+ * The child has no writer thread, and the mutex may have been held by one
+ * of the threads of the parent, so neither is touched anymore; the lines
+ * that were queued are written by the parent.
+ */
+void DebugForgetWriter()
+{
+	_debug_mutex = NULL;
+	_debug_writer = NULL;
+	_debug_queue_first = 0;
+	_debug_queue_count = 0;
+	_debug_writing = false;
+}
+
+/**
+ * Wait till the writer thread wrote all queued debug lines, for at most
+ * a second, e.g. before a crash log is made.
+ */
+void DebugFlushWriter()
+{
+	for (uint i = 0; i < 1000 && _debug_mutex != NULL; i++) {
+		_debug_mutex->BeginCritical();
+		bool done = _debug_queue_count == 0 && !_debug_writing;
+		_debug_mutex->EndCritical();
+		if (done) return;
+		CSleep(1);
+	}
+}
+
+#else
+
+void DebugStartWriter() {}
+void DebugStopWriter() {}
+void DebugFlushWriter() {}
+void DebugForgetWriter() {}
+
 #endif /* NO_DEBUG_MESSAGES */
 
 void SetDebugString(const char *s)
@@ -97,6 +97,28 @@ void CDECL ShowInfoF(const char *str, ...) WARN_FORMAT(1, 2);
 
 const char *GetLogPrefix();
 
+void DebugStartWriter();
+void DebugStopWriter();
+void DebugFlushWriter();
+void DebugForgetWriter();
+
+/**
+ * Get the time of the monotonic clock: it only goes forward, at the same
+ * speed as the real time, and does not wrap.
+ * @return The time in nanoseconds since some moment.
+ */
+uint64 GetMonotonicTime();
+
+/**
+ * Get the time of the monotonic clock in milliseconds.
+ * @return The time in milliseconds since some moment.
+ * @see GetMonotonicTime
+ */
+static inline uint64 GetMonotonicMilliseconds()
+{
+	return GetMonotonicTime() / 1000000;
+}
+
 /** The real time in the game. */
 extern uint32 _realtime_tick;
 
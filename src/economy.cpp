@@ -21,6 +21,7 @@
 #include "ai/ai.hpp"
 #include "aircraft.h"
 #include "train.h"
+#include "roadveh.h"
 #include "newgrf_cargo.h"
 #include "newgrf_engine.h"
 #include "newgrf_sound.h"
@@ -48,6 +49,7 @@
 #include "newgrf.h"
 #include "engine_base.h"
 #include "core/backup_type.hpp"
+#include "graph_gui.h"
 
 #include "table/strings.h"
 #include "table/sprites.h"
@@ -113,39 +115,87 @@ Money _additional_cash_required;
 static PriceMultipliers _price_base_multiplier;
 
 /**
- * Calculate the value of the company. That is the value of all
- * assets (vehicles, stations, etc) and money minus the loan,
- * except when including_loan is \c false which is useful when
- * we want to calculate the value for bankruptcy.
- * @param c              the company to get the value of.
- * @param including_loan include the loan in the company value.
- * @return the value of the company.
+ * Gather the statistics of the vehicles and stations of all companies
+ * with one walk over the vehicle and station pools.
+ * @param stats the statistics, MAX_COMPANIES entries indexed by company.
  */
-Money CalculateCompanyValue(const Company *c, bool including_loan)
+void GetCompanyAssetStats(CompanyAssetStats *stats)
 {
-	Owner owner = c->index;
-	Money value = 0;
-
-	Station *st;
-	uint num = 0;
+	for (CompanyID c = COMPANY_FIRST; c < MAX_COMPANIES; c++) stats[c] = CompanyAssetStats();
 
+	const Station *st;
 	FOR_ALL_STATIONS(st) {
-		if (st->owner == owner) num += CountBits((byte)st->facilities);
-	}
+		if (st->owner >= MAX_COMPANIES) continue;
+
+		CompanyAssetStats *s = &stats[st->owner];
+		uint num = CountBits((byte)st->facilities);
+		s->station_facilities += num;
+		/* Only count stations that are actually serviced for the rating */
+		if (st->time_since_load <= 20 || st->time_since_unload <= 20) s->serviced_facilities += num;
 
-	value += num * _price[PR_STATION_VALUE] * 25;
+		for (uint i = 0; i < lengthof(s->num_stations); i++) {
+			if (HasBit((byte)st->facilities, i)) s->num_stations[i]++;
+		}
+	}
 
-	Vehicle *v;
+	const Vehicle *v;
 	FOR_ALL_VEHICLES(v) {
-		if (v->owner != owner) continue;
+		if (v->owner >= MAX_COMPANIES) continue;
 
+		CompanyAssetStats *s = &stats[v->owner];
 		if (v->type == VEH_TRAIN ||
 				v->type == VEH_ROAD ||
 				(v->type == VEH_AIRCRAFT && Aircraft::From(v)->IsNormalAircraft()) ||
 				v->type == VEH_SHIP) {
-			value += v->value * 3 >> 1;
+			s->vehicle_value += v->value * 3 >> 1;
+		}
+
+		if (!IsCompanyBuildableVehicleType(v->type) || !v->IsPrimaryVehicle()) continue;
+
+		s->num_vehicles[v->type]++;
+		if (v->type == VEH_ROAD && RoadVehicle::From(v)->IsBus()) s->num_buses++;
+
+		if (v->profit_last_year > 0) s->profitable_vehicles++; // For the vehicle score only count profitable vehicles
+		if (v->age > 730) {
+			/* Find the vehicle with the lowest amount of profit */
+			if (!s->has_min_profit || s->min_profit > v->profit_last_year) {
+				s->min_profit = v->profit_last_year;
+				s->has_min_profit = true;
+			}
 		}
 	}
+}
+
+/**
+ * Calculate the value of the company. That is the value of all
+ * assets (vehicles, stations, etc) and money minus the loan,
+ * except when including_loan is \c false which is useful when
+ * we want to calculate the value for bankruptcy.
+ * @param c              the company to get the value of.
+ * @param including_loan include the loan in the company value.
+ * @return the value of the company.
+ */
+Money CalculateCompanyValue(const Company *c, bool including_loan)
+{
+	CompanyAssetStats stats[MAX_COMPANIES];
+	GetCompanyAssetStats(stats);
+	return CalculateCompanyValue(c, &stats[c->index], including_loan);
+}
+
+/**
+ * Calculate the value of the company with already gathered statistics.
+ * @param c              the company to get the value of.
+ * @param stats          the statistics of the assets of this company.
+ * @param including_loan include the loan in the company value.
+ * @return the value of the company.
+ * @see GetCompanyAssetStats
+ */
+Money CalculateCompanyValue(const Company *c, const CompanyAssetStats *stats, bool including_loan)
+{
+	Money value = 0;
+
+	value += stats->station_facilities * _price[PR_STATION_VALUE] * 25;
+	value += stats->vehicle_value;
 
 	/* Add real money value */
 	if (including_loan) value -= c->current_loan;
@@ -158,55 +208,36 @@ Money CalculateCompanyValue(const Company *c, bool including_loan)
  *  (also the house is updated, should only be true in the on-tick event)
  * @param update the economy with calculated score
  * @param c company been evaluated
+ * @param stats the statistics of the assets of this company, or NULL to gather them
  * @return actual score of this company
  * */
-int UpdateCompanyRatingAndValue(Company *c, bool update)
+int UpdateCompanyRatingAndValue(Company *c, bool update, const CompanyAssetStats *stats)
 {
 	Owner owner = c->index;
 	int score = 0;
 
+	CompanyAssetStats all_stats[MAX_COMPANIES];
+	if (stats == NULL) {
+		GetCompanyAssetStats(all_stats);
+		stats = &all_stats[owner];
+	}
+
 	memset(_score_part[owner], 0, sizeof(_score_part[owner]));
 
 	/* Count vehicles */
 	{
-		Vehicle *v;
-		Money min_profit = 0;
-		bool min_profit_first = true;
-		uint num = 0;
-
-		FOR_ALL_VEHICLES(v) {
-			if (v->owner != owner) continue;
-			if (IsCompanyBuildableVehicleType(v->type) && v->IsPrimaryVehicle()) {
-				if (v->profit_last_year > 0) num++; // For the vehicle score only count profitable vehicles
-				if (v->age > 730) {
-					/* Find the vehicle with the lowest amount of profit */
-					if (min_profit_first || min_profit > v->profit_last_year) {
-						min_profit = v->profit_last_year;
-						min_profit_first = false;
-					}
-				}
-			}
-		}
+		Money min_profit = stats->has_min_profit ? stats->min_profit : (Money)0;
 
 		min_profit >>= 8; // remove the fract part
 
-		_score_part[owner][SCORE_VEHICLES] = num;
+		_score_part[owner][SCORE_VEHICLES] = stats->profitable_vehicles;
 		/* Don't allow negative min_profit to show */
 		if (min_profit > 0)
 			_score_part[owner][SCORE_MIN_PROFIT] = ClampToI32(min_profit);
 	}
 
 	/* Count stations */
-	{
-		uint num = 0;
-		const Station *st;
-
-		FOR_ALL_STATIONS(st) {
-			/* Only count stations that are actually serviced */
-			if (st->owner == owner && (st->time_since_load <= 20 || st->time_since_unload <= 20)) num += CountBits((byte)st->facilities);
-		}
-		_score_part[owner][SCORE_STATIONS] = num;
-	}
+	_score_part[owner][SCORE_STATIONS] = stats->serviced_facilities;
 
 	/* Generate statistics depending on recent income statistics */
 	{
@@ -289,7 +320,7 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 	if (update) {
 		c->old_economy[0].performance_history = score;
 		UpdateCompanyHQ(c, score);
-		c->old_economy[0].company_value = CalculateCompanyValue(c);
+		c->old_economy[0].company_value = CalculateCompanyValue(c, stats);
 	}
 
 	SetWindowDirty(WC_PERFORMANCE_DETAIL, 0);
@@ -353,13 +384,12 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 	FOR_ALL_SUBSIDIES(s) {
 		if (s->awarded == old_owner) {
 			if (new_owner == INVALID_OWNER) {
-				delete s;
+				DeleteSubsidy(s);
 			} else {
 				s->awarded = new_owner;
 			}
 		}
 	}
-	if (new_owner == INVALID_OWNER) RebuildSubsidisedSourceAndDestinationCache();
 
 	/* Take care of rating in towns */
 	FOR_ALL_TOWNS(t) {
@@ -396,7 +426,10 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 					v->owner = new_owner;
 					v->colourmap = PAL_NONE;
 					if (v->IsEngineCountable()) Company::Get(new_owner)->num_engines[v->engine_type]++;
-					if (v->IsPrimaryVehicle()) v->unitnumber = unitidgen[v->type].NextID();
+					if (v->IsPrimaryVehicle()) {
+						Company::Get(new_owner)->num_vehicles[v->type]++;
+						v->unitnumber = unitidgen[v->type].NextID();
+					}
 				}
 			}
 		}
@@ -564,6 +597,11 @@ static void CompaniesGenStatistics()
 	if (!HasBit(1 << 0 | 1 << 3 | 1 << 6 | 1 << 9, _cur_month))
 		return;
 
+	/* Bankrupt companies only remove their own assets, so the statistics
+	 * of the other companies stay valid during the loop. */
+	CompanyAssetStats stats[MAX_COMPANIES];
+	GetCompanyAssetStats(stats);
+
 	FOR_ALL_COMPANIES(c) {
 		memmove(&c->old_economy[1], &c->old_economy[0], sizeof(c->old_economy) - sizeof(c->old_economy[0]));
 		c->old_economy[0] = c->cur_economy;
@@ -571,16 +609,12 @@ static void CompaniesGenStatistics()
 
 		if (c->num_valid_stat_ent != MAX_HISTORY_MONTHS) c->num_valid_stat_ent++;
 
-		UpdateCompanyRatingAndValue(c, true);
+		UpdateCompanyRatingAndValue(c, true, &stats[c->index]);
 		if (c->block_preview != 0) c->block_preview--;
 		CompanyCheckBankrupt(c);
 	}
 
-	SetWindowDirty(WC_INCOME_GRAPH, 0);
-	SetWindowDirty(WC_OPERATING_PROFIT, 0);
-	SetWindowDirty(WC_DELIVERED_CARGO, 0);
-	SetWindowDirty(WC_PERFORMANCE_HISTORY, 0);
-	SetWindowDirty(WC_COMPANY_VALUE, 0);
+	InvalidateCompanyGraphs();
 	SetWindowDirty(WC_COMPANY_LEAGUE, 0);
 }
 
@@ -681,7 +715,7 @@ void RecomputePrices()
 	SetWindowClassesDirty(WC_BUILD_VEHICLE);
 	SetWindowClassesDirty(WC_REPLACE_VEHICLE);
 	SetWindowClassesDirty(WC_VEHICLE_DETAILS);
-	SetWindowDirty(WC_PAYMENT_RATES, 0);
+	InvalidateWindowData(WC_PAYMENT_RATES, 0);
 }
 
 static void CompaniesPayInterest()
@@ -891,9 +925,14 @@ static uint DeliverGoodsToIndustry(const Station *st, CargoID cargo_type, uint n
 	 *  3) The results of callbacks CBID_INDUSTRY_REFUSE_CARGO and CBID_INDTILE_CARGO_ACCEPTANCE are inconsistent. (documented behaviour)
 	 */
 
+	/* None of the industries around accepts this cargo at all */
+	if (!HasBit(st->industries_near_cargo, cargo_type)) return 0;
+
 	uint accepted = 0;
 
 	for (uint i = 0; i < st->industries_near.Length() && num_pieces != 0; i++) {
+		if (!HasBit(st->industries_near_accepts[i], cargo_type)) continue;
+
 		Industry *ind = st->industries_near[i];
 		if (ind->index == source) continue;
 
@@ -1057,6 +1096,8 @@ void CargoPayment::PayFinalDelivery(const CargoPacket *cp, uint count)
 	}
 
 	/* Handle end of route payment */
+	Station::Get(this->current_station)->RecordFlowLink(cp->SourceStation(), this->ct, count);
+
 	Money profit = DeliverGoods(count, this->ct, this->current_station, cp->SourceStationXY(), cp->DaysInTransit(), this->owner, cp->SourceSubsidyType(), cp->SourceSubsidyID());
 	this->route_profit += profit;
 
@@ -1072,6 +1113,8 @@ void CargoPayment::PayFinalDelivery(const CargoPacket *cp, uint count)
  */
 Money CargoPayment::PayTransfer(const CargoPacket *cp, uint count)
 {
+	Station::Get(this->current_station)->RecordFlowLink(cp->SourceStation(), this->ct, count);
+
 	Money profit = GetTransportedGoodsIncome(
 		count,
 		/* pay transfer vehicle for only the part of transfer it has done: ie. cargo_loaded_at_xy to here */
@@ -1096,6 +1139,7 @@ void PrepareUnload(Vehicle *front_v)
 
 	/* Start unloading in at the first possible moment */
 	front_v->load_unload_ticks = 1;
+	front_v->lrcache.valid = false;
 
 	if ((front_v->current_order.GetUnloadType() & OUFB_NO_UNLOAD) == 0) {
 		for (Vehicle *v = front_v; v != NULL; v = v->Next()) {
@@ -1109,6 +1153,51 @@ void PrepareUnload(Vehicle *front_v)
 	front_v->cargo_payment = new CargoPayment(front_v);
 }
 
+/**
+ * 'Reserve' the capacity that is left in a vehicle chain. The capacity
+ * left is cached, because it only changes when the chain is (un)loaded.
+ * @param front the first vehicle of the chain
+ * @param cargo_left the amount of each cargo type that is
+ *                   virtually left on the platform.
+ */
+static void ReserveCargoCapacity(Vehicle *front, int *cargo_left)
+{
+	LoadReservationCache *lrc = &front->lrcache;
+
+	if (!lrc->valid) {
+		lrc->valid = true;
+		lrc->num_cargo = 0;
+		for (const Vehicle *v = front; v != NULL; v = v->Next()) {
+			int cap_left = v->cargo_cap - v->cargo.Count();
+			if (cap_left <= 0) continue;
+
+			uint i = 0;
+			while (i < lrc->num_cargo && lrc->cargo[i] != v->cargo_type) i++;
+			if (i == lrc->num_cargo) {
+				if (i == LoadReservationCache::MAX_CARGO_TYPES) {
+					/* Too many cargo types; always walk the chain. */
+					lrc->num_cargo++;
+					break;
+				}
+				lrc->num_cargo++;
+				lrc->cargo[i] = v->cargo_type;
+				lrc->cap_left[i] = 0;
+			}
+			lrc->cap_left[i] += cap_left;
+		}
+	}
+
+	if (lrc->num_cargo <= LoadReservationCache::MAX_CARGO_TYPES) {
+		for (uint i = 0; i < lrc->num_cargo; i++) cargo_left[lrc->cargo[i]] -= lrc->cap_left[i];
+		return;
+	}
+
+	for (const Vehicle *v = front; v != NULL; v = v->Next()) {
+		int cap_left = v->cargo_cap - v->cargo.Count();
+		if (cap_left > 0) cargo_left[v->cargo_type] -= cap_left;
+	}
+}
+
 /**
  * Loads/unload the vehicle if possible.
  * @param v the vehicle to be (un)loaded
@@ -1127,14 +1216,14 @@ static void LoadUnloadVehicle(Vehicle *v, int *cargo_left)
 	if (--v->load_unload_ticks != 0) {
 		if (_settings_game.order.improved_load && (v->current_order.GetLoadType() & OLFB_FULL_LOAD)) {
 			/* 'Reserve' this cargo for this vehicle, because we were first. */
-			for (; v != NULL; v = v->Next()) {
-				int cap_left = v->cargo_cap - v->cargo.Count();
-				if (cap_left > 0) cargo_left[v->cargo_type] -= cap_left;
-			}
+			ReserveCargoCapacity(v, cargo_left);
 		}
 		return;
 	}
 
+	/* The cargo in the vehicle is going to change. */
+	v->lrcache.valid = false;
+
 	StationID last_visited = v->last_station_visited;
 	Station *st = Station::Get(last_visited);
 
@@ -1188,6 +1277,7 @@ static void LoadUnloadVehicle(Vehicle *v, int *cargo_left)
 			if (HasBit(ge->acceptance_pickup, GoodsEntry::ACCEPTANCE) && !(u->current_order.GetUnloadType() & OUFB_TRANSFER)) {
 				/* The cargo has reached its final destination, the packets may now be destroyed */
 				remaining = v->cargo.MoveTo<StationCargoList>(NULL, amount_unloaded, VehicleCargoList::MTA_FINAL_DELIVERY, payment, last_visited);
+				ge->flow.Current().delivered += cargo_count - v->cargo.Count();
 
 				dirty_vehicle = true;
 				accepted = true;
@@ -1199,7 +1289,9 @@ static void LoadUnloadVehicle(Vehicle *v, int *cargo_left)
 			 * station is still accepting the cargo in the vehicle. It doesn't
 			 * accept cargo that was loaded at the same station. */
 			if ((u->current_order.GetUnloadType() & (OUFB_UNLOAD | OUFB_TRANSFER)) && (!accepted || v->cargo.Count() == cargo_count)) {
+				uint before = v->cargo.Count();
 				remaining = v->cargo.MoveTo(&ge->cargo, amount_unloaded, u->current_order.GetUnloadType() & OUFB_TRANSFER ? VehicleCargoList::MTA_TRANSFER : VehicleCargoList::MTA_UNLOAD, payment);
+				ge->flow.Current().transferred += before - v->cargo.Count();
 				SetBit(ge->acceptance_pickup, GoodsEntry::PICKUP);
 
 				dirty_vehicle = dirty_station = true;
@@ -1285,6 +1377,7 @@ static void LoadUnloadVehicle(Vehicle *v, int *cargo_left)
 			anything_loaded = true;
 
 			ge->cargo.MoveTo(&v->cargo, cap, StationCargoList::MTA_CARGO_LOAD, NULL, st->xy);
+			ge->flow.Current().loaded += cap;
 
 			st->time_since_load = 0;
 			st->last_vehicle_type = v->type;
@@ -1313,10 +1406,7 @@ static void LoadUnloadVehicle(Vehicle *v, int *cargo_left)
 	 * enough to fill the previous wagons) */
 	if (_settings_game.order.improved_load && (u->current_order.GetLoadType() & OLFB_FULL_LOAD)) {
 		/* Update left cargo */
-		for (v = u; v != NULL; v = v->Next()) {
-			int cap_left = v->cargo_cap - v->cargo.Count();
-			if (cap_left > 0) cargo_left[v->cargo_type] -= cap_left;
-		}
+		ReserveCargoCapacity(u, cargo_left);
 	}
 
 	v = u;
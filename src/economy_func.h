@@ -27,7 +27,7 @@ extern Economy _economy;
 /* Prices and also the fractional part. */
 extern Prices _price;
 
-int UpdateCompanyRatingAndValue(Company *c, bool update);
+int UpdateCompanyRatingAndValue(Company *c, bool update, const struct CompanyAssetStats *stats = NULL);
 void StartupIndustryDailyChanges(bool init_counter);
 
 Money GetTransportedGoodsIncome(uint num_pieces, uint dist, byte transit_days, CargoID cargo_type);
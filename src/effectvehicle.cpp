@@ -18,121 +18,261 @@
 #include "animated_tile_func.h"
 #include "effectvehicle_func.h"
 #include "effectvehicle_base.h"
+#include "viewport_func.h"
+#include "spritecache.h"
+#include "blitter/factory.hpp"
 
 #include "table/sprites.h"
 
-static void ChimneySmokeInit(EffectVehicle *v)
+/**
+ * A short lived effect, like smoke and sparks. These are only looks, so
+ * unlike effect vehicles they are not in the vehicle pool and the position
+ * hash, are not saved and are not made at all when nothing is drawn.
+ */
+struct EffectParticle {
+	int32 x_pos;        ///< x coordinate.
+	int32 y_pos;        ///< y coordinate.
+	byte z_pos;         ///< z coordinate.
+	byte type;          ///< The EffectVehicleType of the particle.
+	byte progress;      ///< Ticks till the next change of the image, or the ticks passed.
+	SpriteID cur_image; ///< The sprite that is drawn.
+	Rect coord;         ///< The bounds of the sprite on the screen.
+};
+
+/** The most particles there can be; more are simply not made. */
+static const uint MAX_EFFECT_PARTICLES = 16384;
+
+/** All particles; they are updated in one go in the order of this list. */
+static SmallVector<EffectParticle, 256> _effect_particles;
+
+/**
+ * Update the bounds of a particle on the screen and mark its old and new location dirty.
+ * @param p The particle that moved or changed its image.
+ * @param update_viewport Whether to mark the viewports dirty.
+ */
+static void EffectParticleMove(EffectParticle *p, bool update_viewport)
 {
-	uint32 r = Random();
-	v->cur_image = SPR_CHIMNEY_SMOKE_0 + GB(r, 0, 3);
-	v->progress = GB(r, 16, 3);
+	Point pt = RemapCoords(p->x_pos, p->y_pos, p->z_pos);
+	const Sprite *spr = GetSprite(p->cur_image, ST_NORMAL);
+
+	pt.x += spr->x_offs;
+	pt.y += spr->y_offs;
+
+	Rect old_coord = p->coord;
+	p->coord.left   = pt.x;
+	p->coord.top    = pt.y;
+	p->coord.right  = pt.x + spr->width + 2;
+	p->coord.bottom = pt.y + spr->height + 2;
+
+	if (update_viewport) {
+		MarkAllViewportsDirty(
+			min(old_coord.left,   p->coord.left),
+			min(old_coord.top,    p->coord.top),
+			max(old_coord.right,  p->coord.right) + 1,
+			max(old_coord.bottom, p->coord.bottom) + 1
+		);
+	}
+}
+
+static void ChimneySmokeInit(EffectParticle *p)
+{
+	/* Particles are not in the game state, so they must not use its randomness. */
+	uint32 r = InteractiveRandom();
+	p->cur_image = SPR_CHIMNEY_SMOKE_0 + GB(r, 0, 3);
+	p->progress = GB(r, 16, 3);
 }
 
-static bool ChimneySmokeTick(EffectVehicle *v)
+static bool ChimneySmokeTick(EffectParticle *p)
 {
-	if (v->progress > 0) {
-		v->progress--;
+	if (p->progress > 0) {
+		p->progress--;
 	} else {
-		TileIndex tile = TileVirtXY(v->x_pos, v->y_pos);
-		if (!IsTileType(tile, MP_INDUSTRY)) {
-			delete v;
-			return false;
-		}
+		TileIndex tile = TileVirtXY(p->x_pos, p->y_pos);
+		if (!IsTileType(tile, MP_INDUSTRY)) return false;
 
-		if (v->cur_image != SPR_CHIMNEY_SMOKE_7) {
-			v->cur_image++;
+		if (p->cur_image != SPR_CHIMNEY_SMOKE_7) {
+			p->cur_image++;
 		} else {
-			v->cur_image = SPR_CHIMNEY_SMOKE_0;
+			p->cur_image = SPR_CHIMNEY_SMOKE_0;
 		}
-		v->progress = 7;
-		VehicleMove(v, true);
+		p->progress = 7;
+		EffectParticleMove(p, true);
 	}
 
 	return true;
 }
 
-static void SteamSmokeInit(EffectVehicle *v)
+static void SteamSmokeInit(EffectParticle *p)
 {
-	v->cur_image = SPR_STEAM_SMOKE_0;
-	v->progress = 12;
+	p->cur_image = SPR_STEAM_SMOKE_0;
+	p->progress = 12;
 }
 
-static bool SteamSmokeTick(EffectVehicle *v)
+static bool SteamSmokeTick(EffectParticle *p)
 {
 	bool moved = false;
 
-	v->progress++;
+	p->progress++;
 
-	if ((v->progress & 7) == 0) {
-		v->z_pos++;
+	if ((p->progress & 7) == 0) {
+		p->z_pos++;
 		moved = true;
 	}
 
-	if ((v->progress & 0xF) == 4) {
-		if (v->cur_image != SPR_STEAM_SMOKE_4) {
-			v->cur_image++;
-		} else {
-			delete v;
-			return false;
-		}
+	if ((p->progress & 0xF) == 4) {
+		if (p->cur_image == SPR_STEAM_SMOKE_4) return false;
+		p->cur_image++;
 		moved = true;
 	}
 
-	if (moved) VehicleMove(v, true);
+	if (moved) EffectParticleMove(p, true);
 
 	return true;
 }
 
-static void DieselSmokeInit(EffectVehicle *v)
+static void DieselSmokeInit(EffectParticle *p)
 {
-	v->cur_image = SPR_DIESEL_SMOKE_0;
-	v->progress = 0;
+	p->cur_image = SPR_DIESEL_SMOKE_0;
+	p->progress = 0;
 }
 
-static bool DieselSmokeTick(EffectVehicle *v)
+static bool DieselSmokeTick(EffectParticle *p)
 {
-	v->progress++;
-
-	if ((v->progress & 3) == 0) {
-		v->z_pos++;
-		VehicleMove(v, true);
-	} else if ((v->progress & 7) == 1) {
-		if (v->cur_image != SPR_DIESEL_SMOKE_5) {
-			v->cur_image++;
-			VehicleMove(v, true);
-		} else {
-			delete v;
-			return false;
-		}
+	p->progress++;
+
+	if ((p->progress & 3) == 0) {
+		p->z_pos++;
+		EffectParticleMove(p, true);
+	} else if ((p->progress & 7) == 1) {
+		if (p->cur_image == SPR_DIESEL_SMOKE_5) return false;
+		p->cur_image++;
+		EffectParticleMove(p, true);
 	}
 
 	return true;
 }
 
-static void ElectricSparkInit(EffectVehicle *v)
+static void ElectricSparkInit(EffectParticle *p)
 {
-	v->cur_image = SPR_ELECTRIC_SPARK_0;
-	v->progress = 1;
+	p->cur_image = SPR_ELECTRIC_SPARK_0;
+	p->progress = 1;
 }
 
-static bool ElectricSparkTick(EffectVehicle *v)
+static bool ElectricSparkTick(EffectParticle *p)
 {
-	if (v->progress < 2) {
-		v->progress++;
+	if (p->progress < 2) {
+		p->progress++;
 	} else {
-		v->progress = 0;
-		if (v->cur_image != SPR_ELECTRIC_SPARK_5) {
-			v->cur_image++;
-			VehicleMove(v, true);
-		} else {
-			delete v;
-			return false;
-		}
+		p->progress = 0;
+		if (p->cur_image == SPR_ELECTRIC_SPARK_5) return false;
+		p->cur_image++;
+		EffectParticleMove(p, true);
 	}
 
 	return true;
 }
 
+typedef void EffectParticleInitProc(EffectParticle *p);
+typedef bool EffectParticleTickProc(EffectParticle *p);
+
+/** Initialisation of the particles, indexed by EffectVehicleType. */
+static EffectParticleInitProc * const _effect_particle_init_procs[] = {
+	ChimneySmokeInit,
+	SteamSmokeInit,
+	DieselSmokeInit,
+	ElectricSparkInit,
+};
+
+/** Update of the particles, indexed by EffectVehicleType. */
+static EffectParticleTickProc * const _effect_particle_tick_procs[] = {
+	ChimneySmokeTick,
+	SteamSmokeTick,
+	DieselSmokeTick,
+	ElectricSparkTick,
+};
+
+assert_compile(lengthof(_effect_particle_init_procs) == EV_END_PARTICLE);
+assert_compile(lengthof(_effect_particle_tick_procs) == EV_END_PARTICLE);
+
+/**
+ * Make a particle, unless nothing is ever drawn.
+ * @param x    The x coordinate of the particle.
+ * @param y    The y coordinate of the particle.
+ * @param z    The z coordinate of the particle.
+ * @param type The type of the particle; one of the types below #EV_END_PARTICLE.
+ */
+void CreateEffectParticle(int x, int y, int z, EffectVehicleType type)
+{
+	assert(type < EV_END_PARTICLE);
+
+	if (BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 0 || _effect_particles.Length() >= MAX_EFFECT_PARTICLES) return;
+
+	EffectParticle *p = _effect_particles.Append();
+	p->x_pos = x;
+	p->y_pos = y;
+	p->z_pos = z;
+	p->type = type;
+	_effect_particle_init_procs[type](p);
+
+	EffectParticleMove(p, false);
+	MarkAllViewportsDirty(p->coord.left, p->coord.top, p->coord.right + 1, p->coord.bottom + 1);
+}
+
+/**
+ * Make a particle relative to a vehicle, unless nothing is ever drawn.
+ * @param v    The vehicle the position is relative to.
+ * @param x    The x offset from the vehicle.
+ * @param y    The y offset from the vehicle.
+ * @param z    The z offset from the vehicle.
+ * @param type The type of the particle; one of the types below #EV_END_PARTICLE.
+ */
+void CreateEffectParticleRel(const Vehicle *v, int x, int y, int z, EffectVehicleType type)
+{
+	CreateEffectParticle(v->x_pos + x, v->y_pos + y, v->z_pos + z, type);
+}
+
+/** Update all particles, and remove those that are done. */
+void CallEffectParticleTicks()
+{
+	for (uint i = 0; i < _effect_particles.Length();) {
+		EffectParticle *p = _effect_particles.Get(i);
+		if (_effect_particle_tick_procs[p->type](p)) {
+			i++;
+			continue;
+		}
+
+		MarkAllViewportsDirty(p->coord.left, p->coord.top, p->coord.right + 1, p->coord.bottom + 1);
+		_effect_particles.Erase(p);
+	}
+}
+
+/**
+ * Add the particles that are within the given part of the viewport to it.
+ * @param dpi The part of the viewport that is drawn.
+ */
+void ViewportAddEffectParticles(DrawPixelInfo *dpi)
+{
+	/* From far away only the vehicles themselves are shown. */
+	if (IsViewportLowDetail()) return;
+
+	const int l = dpi->left;
+	const int r = dpi->left + dpi->width;
+	const int t = dpi->top;
+	const int b = dpi->top + dpi->height;
+
+	for (const EffectParticle *p = _effect_particles.Begin(); p != _effect_particles.End(); p++) {
+		if (l <= p->coord.right && t <= p->coord.bottom && r >= p->coord.left && b >= p->coord.top) {
+			AddSortableSpriteToDraw(p->cur_image, PAL_NONE, p->x_pos, p->y_pos, 1, 1, 1, p->z_pos);
+		}
+	}
+}
+
+/** Remove all particles, e.g. when another game is started. */
+void ResetEffectParticles()
+{
+	_effect_particles.Reset();
+}
+
 static void SmokeInit(EffectVehicle *v)
 {
 	v->cur_image = SPR_SMOKE_0;
@@ -531,11 +671,12 @@ static bool BubbleTick(EffectVehicle *v)
 typedef void EffectInitProc(EffectVehicle *v);
 typedef bool EffectTickProc(EffectVehicle *v);
 
+/** Initialisation of the effect vehicles, indexed by EffectVehicleType; the first types are particles. */
 static EffectInitProc * const _effect_init_procs[] = {
-	ChimneySmokeInit,
-	SteamSmokeInit,
-	DieselSmokeInit,
-	ElectricSparkInit,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
 	SmokeInit,
 	ExplosionLargeInit,
 	BreakdownSmokeInit,
@@ -544,11 +685,12 @@ static EffectInitProc * const _effect_init_procs[] = {
 	BubbleInit,
 };
 
+/** Update of the effect vehicles, indexed by EffectVehicleType; the first types are particles. */
 static EffectTickProc * const _effect_tick_procs[] = {
-	ChimneySmokeTick,
-	SteamSmokeTick,
-	DieselSmokeTick,
-	ElectricSparkTick,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
 	SmokeTick,
 	ExplosionLargeTick,
 	BreakdownSmokeTick,
@@ -560,6 +702,7 @@ static EffectTickProc * const _effect_tick_procs[] = {
 
 EffectVehicle *CreateEffectVehicle(int x, int y, int z, EffectVehicleType type)
 {
+	assert(type >= EV_END_PARTICLE);
 	if (!Vehicle::CanAllocateItem()) return NULL;
 
 	EffectVehicle *v = new EffectVehicle();
@@ -20,6 +20,7 @@ enum EffectVehicleType {
 	EV_STEAM_SMOKE     = 1,
 	EV_DIESEL_SMOKE    = 2,
 	EV_ELECTRIC_SPARK  = 3,
+	EV_END_PARTICLE    = 4, ///< The types before this are particles, the others effect vehicles.
 	EV_SMOKE           = 4,
 	EV_EXPLOSION_LARGE = 5,
 	EV_BREAKDOWN_SMOKE = 6,
@@ -32,4 +33,10 @@ EffectVehicle *CreateEffectVehicle(int x, int y, int z, EffectVehicleType type);
 EffectVehicle *CreateEffectVehicleAbove(int x, int y, int z, EffectVehicleType type);
 EffectVehicle *CreateEffectVehicleRel(const Vehicle *v, int x, int y, int z, EffectVehicleType type);
 
+void CreateEffectParticle(int x, int y, int z, EffectVehicleType type);
+void CreateEffectParticleRel(const Vehicle *v, int x, int y, int z, EffectVehicleType type);
+void CallEffectParticleTicks();
+void ViewportAddEffectParticles(struct DrawPixelInfo *dpi);
+void ResetEffectParticles();
+
 #endif /* EFFECTVEHICLE_FUNC_H */
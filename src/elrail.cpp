@@ -70,6 +70,39 @@
 #include "table/sprites.h"
 #include "table/elrail_data.h"
 
+/** A pylon placed by the catenary of a tile. */
+struct CatenaryPylon {
+	DiagDirection pcp; ///< The control point the pylon belongs to.
+	Direction ppp;     ///< The position of the pylon around the control point.
+	bool halftile;     ///< Whether the pylon uses the sprites of the upper halftile.
+	byte z;            ///< The elevation of the pylon.
+};
+
+/** A wire placed by the catenary of a tile. */
+struct CatenaryWire {
+	CatenarySprite sprite; ///< The wire sprite, an index into #CatenarySpriteData.
+	bool halftile;         ///< Whether the wire uses the sprites of the upper halftile.
+	byte z;                ///< The elevation of the ground under the wire.
+};
+
+/**
+ * Where the pylons and wires of a tile go. Finding that out looks at the
+ * track and slopes of the tile and all its neighbours, while the outcome only
+ * changes when one of them changes; those tiles are then marked dirty.
+ */
+struct CatenaryCache {
+	TileIndex tile;                      ///< The tile the layout is of; INVALID_TILE if it is of no tile.
+	byte num_pylons;                     ///< The number of pylons on the tile.
+	byte num_wires;                      ///< The number of wires on the tile.
+	bool under_low_bridge;               ///< Whether the wires are hidden when the catenary isn't transparent.
+	CatenaryPylon pylons[DIAGDIR_END];   ///< The pylons, at most one per control point.
+	CatenaryWire wires[TRACK_END];       ///< The wires, at most one per track.
+};
+
+static const uint CATENARY_CACHE_BITS = 7;                            ///< The catenary cache holds a square of 2^bits tiles.
+static const uint CATENARY_CACHE_MASK = (1 << CATENARY_CACHE_BITS) - 1; ///< Mask of the coordinates of a tile in the catenary cache.
+static CatenaryCache *_catenary_cache = NULL;                         ///< The catenary cache; tiles with the same coordinates modulo 2^#CATENARY_CACHE_BITS share an entry.
+
 static inline TLG GetTLG(TileIndex t)
 {
 	return (TLG)((HasBit(TileX(t), 0) << 1) + HasBit(TileY(t), 0));
@@ -258,11 +291,18 @@ void DrawCatenaryOnTunnel(const TileInfo *ti)
 	);
 }
 
-/** Draws wires and, if required, pylons on a given tile
- * @param ti The Tileinfo to draw the tile for
+/**
+ * Determine where the pylons and wires of a tile go.
+ * @param ti The Tileinfo of the tile
+ * @param cache The cache entry to fill
  */
-static void DrawCatenaryRailway(const TileInfo *ti)
+static void MakeCatenaryLayout(const TileInfo *ti, CatenaryCache *cache)
 {
+	cache->tile = ti->tile;
+	cache->num_pylons = 0;
+	cache->num_wires = 0;
+	cache->under_low_bridge = false;
+
 	/* Pylons are placed on a tile edge, so we need to take into account
 	 * the track configuration of 2 adjacent tiles. trackconfig[0] stores the
 	 * current tile (home tile) while [1] holds the neighbour */
@@ -299,9 +339,6 @@ static void DrawCatenaryRailway(const TileInfo *ti)
 
 	AdjustTileh(ti->tile, &tileh[TS_HOME]);
 
-	SpriteID pylon_normal = GetPylonBase(ti->tile);
-	SpriteID pylon_halftile = (halftile_corner != CORNER_INVALID) ? GetPylonBase(ti->tile, true) : pylon_normal;
-
 	for (DiagDirection i = DIAGDIR_BEGIN; i < DIAGDIR_END; i++) {
 		static const uint edge_corners[] = {
 			1 << CORNER_N | 1 << CORNER_E, // DIAGDIR_NE
@@ -309,7 +346,6 @@ static void DrawCatenaryRailway(const TileInfo *ti)
 			1 << CORNER_S | 1 << CORNER_W, // DIAGDIR_SW
 			1 << CORNER_N | 1 << CORNER_W, // DIAGDIR_NW
 		};
-		SpriteID pylon_base = (halftile_corner != CORNER_INVALID && HasBit(edge_corners[i], halftile_corner)) ? pylon_halftile : pylon_normal;
 		TileIndex neighbour = ti->tile + TileOffsByDiagDir(i);
 		Foundation foundation = FOUNDATION_NONE;
 		byte elevation = GetPCPElevation(ti->tile, i);
@@ -409,9 +445,6 @@ static void DrawCatenaryRailway(const TileInfo *ti)
 				byte temp = PPPorder[i][GetTLG(ti->tile)][k];
 
 				if (HasBit(PPPallowed[i], temp)) {
-					uint x  = ti->x + x_pcp_offsets[i] + x_ppp_offsets[temp];
-					uint y  = ti->y + y_pcp_offsets[i] + y_ppp_offsets[temp];
-
 					/* Don't build the pylon if it would be outside the tile */
 					if (!HasBit(OwnedPPPonPCP[i], temp)) {
 						/* We have a neighour that will draw it, bail out */
@@ -419,10 +452,13 @@ static void DrawCatenaryRailway(const TileInfo *ti)
 						continue; // No neighbour, go looking for a better position
 					}
 
-					AddSortableSpriteToDraw(pylon_base + pylon_sprites[temp], PAL_NONE, x, y, 1, 1, BB_HEIGHT_UNDER_BRIDGE,
-						elevation, IsTransparencySet(TO_CATENARY), -1, -1);
+					CatenaryPylon *pylon = &cache->pylons[cache->num_pylons++];
+					pylon->pcp = i;
+					pylon->ppp = (Direction)temp;
+					pylon->halftile = halftile_corner != CORNER_INVALID && HasBit(edge_corners[i], halftile_corner);
+					pylon->z = elevation;
 
-					break; // We already have drawn a pylon, bail out
+					break; // We already have placed a pylon, bail out
 				}
 			}
 		}
@@ -431,15 +467,13 @@ static void DrawCatenaryRailway(const TileInfo *ti)
 	/* The wire above the tunnel is drawn together with the tunnel-roof (see DrawCatenaryOnTunnel()) */
 	if (IsTunnelTile(ti->tile)) return;
 
-	/* Don't draw a wire under a low bridge */
-	if (MayHaveBridgeAbove(ti->tile) && IsBridgeAbove(ti->tile) && !IsTransparencySet(TO_CATENARY)) {
+	/* Wires under a low bridge are only drawn when the catenary is transparent */
+	if (MayHaveBridgeAbove(ti->tile) && IsBridgeAbove(ti->tile)) {
 		uint height = GetBridgeHeight(GetNorthernBridgeEnd(ti->tile));
 
-		if (height <= GetTileMaxZ(ti->tile) + TILE_HEIGHT) return;
+		cache->under_low_bridge = height <= GetTileMaxZ(ti->tile) + TILE_HEIGHT;
 	}
 
-	SpriteID wire_normal = GetWireBase(ti->tile);
-	SpriteID wire_halftile = (halftile_corner != CORNER_INVALID) ? GetWireBase(ti->tile, true) : wire_normal;
 	Track halftile_track;
 	switch (halftile_corner) {
 		case CORNER_W: halftile_track = TRACK_LEFT; break;
@@ -449,10 +483,9 @@ static void DrawCatenaryRailway(const TileInfo *ti)
 		default:       halftile_track = INVALID_TRACK; break;
 	}
 
-	/* Drawing of pylons is finished, now draw the wires */
+	/* Placing of pylons is finished, now place the wires */
 	Track t;
 	FOR_EACH_SET_TRACK(t, wireconfig[TS_HOME]) {
-		SpriteID wire_base = (t == halftile_track) ? wire_halftile : wire_normal;
 		byte PCPconfig = HasBit(PCPstatus, PCPpositions[t][0]) +
 			(HasBit(PCPstatus, PCPpositions[t][1]) << 1);
 
@@ -461,19 +494,97 @@ static void DrawCatenaryRailway(const TileInfo *ti)
 
 		assert(PCPconfig != 0); // We have a pylon on neither end of the wire, that doesn't work (since we have no sprites for that)
 		assert(!IsSteepSlope(tileh[TS_HOME]));
-		sss = &CatenarySpriteData[Wires[tileh_selector][t][PCPconfig]];
+		CatenaryWire *wire = &cache->wires[cache->num_wires++];
+		wire->sprite = Wires[tileh_selector][t][PCPconfig];
+		wire->halftile = (t == halftile_track);
+		sss = &CatenarySpriteData[wire->sprite];
 
 		/*
 		 * The "wire"-sprite position is inside the tile, i.e. 0 <= sss->?_offset < TILE_SIZE.
 		 * Therefore it is safe to use GetSlopeZ() for the elevation.
 		 * Also note, that the result of GetSlopeZ() is very special for bridge-ramps.
 		 */
-		AddSortableSpriteToDraw(wire_base + sss->image_offset, PAL_NONE, ti->x + sss->x_offset, ti->y + sss->y_offset,
-			sss->x_size, sss->y_size, sss->z_size, GetSlopeZ(ti->x + sss->x_offset, ti->y + sss->y_offset) + sss->z_offset,
+		wire->z = GetSlopeZ(ti->x + sss->x_offset, ti->y + sss->y_offset);
+	}
+}
+
+/**
+ * Get the entry of the catenary cache a tile uses, making the cache when there is none yet.
+ * @param tile the tile
+ * @return the entry; it holds the layout of another tile when the tile isn't cached
+ */
+static CatenaryCache *GetCatenaryCache(TileIndex tile)
+{
+	if (_catenary_cache == NULL) {
+		_catenary_cache = MallocT<CatenaryCache>(1 << (2 * CATENARY_CACHE_BITS));
+		for (uint i = 0; i < 1 << (2 * CATENARY_CACHE_BITS); i++) _catenary_cache[i].tile = INVALID_TILE;
+	}
+	return &_catenary_cache[(TileX(tile) & CATENARY_CACHE_MASK) | (TileY(tile) & CATENARY_CACHE_MASK) << CATENARY_CACHE_BITS];
+}
+
+void InvalidateCatenaryCache(TileIndex tile)
+{
+	if (_catenary_cache == NULL) return;
+
+	uint x = TileX(tile);
+	uint y = TileY(tile);
+	for (uint cy = max(y, 1U) - 1; cy <= min(y + 1, MapMaxY()); cy++) {
+		for (uint cx = max(x, 1U) - 1; cx <= min(x + 1, MapMaxX()); cx++) {
+			CatenaryCache *cache = GetCatenaryCache(TileXY(cx, cy));
+			if (cache->tile == TileXY(cx, cy)) cache->tile = INVALID_TILE;
+		}
+	}
+}
+
+void ResetCatenaryCache()
+{
+	if (_catenary_cache == NULL) return;
+
+	for (uint i = 0; i < 1 << (2 * CATENARY_CACHE_BITS); i++) _catenary_cache[i].tile = INVALID_TILE;
+}
+
+/** Draws wires and, if required, pylons on a given tile
+ * @param ti The Tileinfo to draw the tile for
+ */
+static void DrawCatenaryRailway(const TileInfo *ti)
+{
+	CatenaryCache *cache = GetCatenaryCache(ti->tile);
+	if (cache->tile != ti->tile) MakeCatenaryLayout(ti, cache);
+
+	/* The sprites are looked up every time; NewGRFs may vary them without anything on the map changing */
+	bool halftile = IsHalftileSlope(ti->tileh);
+
+	if (cache->num_pylons != 0) {
+		SpriteID pylon_normal = GetPylonBase(ti->tile);
+		SpriteID pylon_halftile = halftile ? GetPylonBase(ti->tile, true) : pylon_normal;
+
+		for (uint i = 0; i < cache->num_pylons; i++) {
+			const CatenaryPylon *pylon = &cache->pylons[i];
+			uint x = ti->x + x_pcp_offsets[pylon->pcp] + x_ppp_offsets[pylon->ppp];
+			uint y = ti->y + y_pcp_offsets[pylon->pcp] + y_ppp_offsets[pylon->ppp];
+
+			AddSortableSpriteToDraw((pylon->halftile ? pylon_halftile : pylon_normal) + pylon_sprites[pylon->ppp], PAL_NONE, x, y, 1, 1, BB_HEIGHT_UNDER_BRIDGE,
+				pylon->z, IsTransparencySet(TO_CATENARY), -1, -1);
+		}
+	}
+
+	/* Don't draw a wire under a low bridge */
+	if (cache->num_wires == 0 || (cache->under_low_bridge && !IsTransparencySet(TO_CATENARY))) return;
+
+	SpriteID wire_normal = GetWireBase(ti->tile);
+	SpriteID wire_halftile = halftile ? GetWireBase(ti->tile, true) : wire_normal;
+
+	for (uint i = 0; i < cache->num_wires; i++) {
+		const CatenaryWire *wire = &cache->wires[i];
+		const SortableSpriteStruct *sss = &CatenarySpriteData[wire->sprite];
+
+		AddSortableSpriteToDraw((wire->halftile ? wire_halftile : wire_normal) + sss->image_offset, PAL_NONE, ti->x + sss->x_offset, ti->y + sss->y_offset,
+			sss->x_size, sss->y_size, sss->z_size, wire->z + sss->z_offset,
 			IsTransparencySet(TO_CATENARY));
 	}
 }
 
+
 void DrawCatenaryOnBridge(const TileInfo *ti)
 {
 	TileIndex end = GetSouthernBridgeEnd(ti->tile);
@@ -43,6 +43,15 @@ void DrawCatenary(const TileInfo *ti);
 void DrawCatenaryOnTunnel(const TileInfo *ti);
 void DrawCatenaryOnBridge(const TileInfo *ti);
 
+/**
+ * Forget where the catenary of a tile and its neighbours goes, as the
+ * catenary of a tile depends on the track of its neighbours.
+ * @param tile the tile that changed
+ */
+void InvalidateCatenaryCache(TileIndex tile);
+/** Forget where the catenary of all tiles goes, e.g. because the map changed. */
+void ResetCatenaryCache();
+
 bool SettingsDisableElrail(int32 p1); ///< _settings_game.disable_elrail callback
 
 #endif /* ELRAIL_FUNC_H */
@@ -410,6 +410,7 @@ void SetCachedEngineCounts()
 	FOR_ALL_COMPANIES(c) {
 		free(c->num_engines);
 		c->num_engines = CallocT<EngineID>(engines);
+		memset(c->num_vehicles, 0, sizeof(c->num_vehicles));
 	}
 
 	/* Recalculate */
@@ -425,7 +426,9 @@ void SetCachedEngineCounts()
 
 		assert(v->engine_type < engines);
 
-		Company::Get(v->owner)->num_engines[v->engine_type]++;
+		Company *c = Company::Get(v->owner);
+		c->num_engines[v->engine_type]++;
+		if (v->IsPrimaryVehicle()) c->num_vehicles[v->type]++;
 
 		if (v->group_id == DEFAULT_GROUP) continue;
 
@@ -29,6 +29,14 @@
 #include <sys/stat.h>
 #include <algorithm>
 
+#if defined(UNIX) && !defined(__MORPHOS__)
+/* The files in the slots are read from a mapping of the file into memory, when possible. */
+#	define WITH_MAPPED_SLOTS
+/* MapFileToMem really maps files, instead of reading them. */
+#	define WITH_MAPPED_FILES
+#	include <sys/mman.h>
+#endif
+
 /*************************************************/
 /* FILE IO ROUTINES ******************************/
 /*************************************************/
@@ -44,6 +52,11 @@ struct Fio {
 	byte buffer_start[FIO_BUFFER_SIZE];    ///< local buffer when read from file
 	const char *filenames[MAX_FILE_SLOTS]; ///< array of filenames we (should) have open
 	char *shortnames[MAX_FILE_SLOTS];      ///< array of short names for spriteloader's use
+	uint32 stamps[MAX_FILE_SLOTS];         ///< array of stamps that change whenever the files change
+	byte *maps[MAX_FILE_SLOTS];            ///< array of mappings of the files into memory; NULL for files read through the buffer
+	size_t map_sizes[MAX_FILE_SLOTS];      ///< array of sizes of the mappings
+	byte *cur_map;                         ///< mapping of the current file, if any
+	size_t cur_map_size;                   ///< size of the mapping of the current file
 #if defined(LIMITED_FDS)
 	uint open_handles;                     ///< current amount of open handles
 	uint usage_count[MAX_FILE_SLOTS];      ///< count how many times this file has been opened
@@ -64,6 +77,17 @@ size_t FioGetPos()
 	return _fio.pos + (_fio.buffer - _fio.buffer_end);
 }
 
+/**
+ * Get a stamp of the file in a slot, made from its name, size, position
+ * and modification time, which changes whenever the file is changed.
+ * @param slot the slot of the file
+ * @return the stamp
+ */
+uint32 FioGetFileStamp(uint8 slot)
+{
+	return _fio.stamps[slot];
+}
+
 const char *FioGetFilename(uint8 slot)
 {
 	return _fio.shortnames[slot];
@@ -72,6 +96,15 @@ const char *FioGetFilename(uint8 slot)
 void FioSeekTo(size_t pos, int mode)
 {
 	if (mode == SEEK_CUR) pos += FioGetPos();
+
+	if (_fio.cur_map != NULL) {
+		/* The mapping is the buffer, and the system position is at its end. */
+		_fio.buffer = _fio.cur_map + min(pos, _fio.cur_map_size);
+		_fio.buffer_end = _fio.cur_map + _fio.cur_map_size;
+		_fio.pos = _fio.cur_map_size;
+		return;
+	}
+
 	_fio.buffer = _fio.buffer_end = _fio.buffer_start + FIO_BUFFER_SIZE;
 	_fio.pos = pos;
 	fseek(_fio.cur_fh, _fio.pos, SEEK_SET);
@@ -100,6 +133,8 @@ void FioSeekToFile(uint8 slot, size_t pos)
 	f = _fio.handles[slot];
 	assert(f != NULL);
 	_fio.cur_fh = f;
+	_fio.cur_map = _fio.maps[slot];
+	_fio.cur_map_size = _fio.map_sizes[slot];
 	_fio.filename = _fio.filenames[slot];
 	FioSeekTo(pos, SEEK_SET);
 }
@@ -107,6 +142,9 @@ void FioSeekToFile(uint8 slot, size_t pos)
 byte FioReadByte()
 {
 	if (_fio.buffer == _fio.buffer_end) {
+		/* There is nothing after the end of a mapping. */
+		if (_fio.cur_map != NULL) return 0;
+
 		_fio.buffer = _fio.buffer_start;
 		size_t size = fread(_fio.buffer, 1, FIO_BUFFER_SIZE, _fio.cur_fh);
 		_fio.pos += size;
@@ -143,6 +181,13 @@ uint32 FioReadDword()
 
 void FioReadBlock(void *ptr, size_t size)
 {
+	if (_fio.cur_map != NULL) {
+		size = min<size_t>(size, _fio.buffer_end - _fio.buffer);
+		memcpy(ptr, _fio.buffer, size);
+		_fio.buffer += size;
+		return;
+	}
+
 	FioSeekTo(FioGetPos(), SEEK_SET);
 	_fio.pos += fread(ptr, 1, size, _fio.cur_fh);
 }
@@ -152,6 +197,14 @@ static inline void FioCloseFile(int slot)
 	if (_fio.handles[slot] != NULL) {
 		fclose(_fio.handles[slot]);
 
+		if (_fio.maps[slot] != NULL) {
+			if (_fio.cur_map == _fio.maps[slot]) _fio.cur_map = NULL;
+#ifdef WITH_MAPPED_SLOTS
+			munmap(_fio.maps[slot], _fio.map_sizes[slot]);
+#endif /* WITH_MAPPED_SLOTS */
+			_fio.maps[slot] = NULL;
+		}
+
 		free(_fio.shortnames[slot]);
 		_fio.shortnames[slot] = NULL;
 
@@ -216,6 +269,24 @@ void FioOpenFile(int slot, const char *filename)
 	if (t2 != NULL) *t2 = '\0';
 	strtolower(_fio.shortnames[slot]);
 
+	uint32 stamp = pos;
+	for (const char *c = _fio.shortnames[slot]; *c != '\0'; c++) stamp = stamp * 31 + *c;
+	struct stat st;
+	bool have_stat = fstat(fileno(f), &st) == 0;
+	if (have_stat) stamp = (stamp * 31 + (uint32)st.st_size) * 31 + (uint32)st.st_mtime;
+	_fio.stamps[slot] = stamp;
+
+#ifdef WITH_MAPPED_SLOTS
+	/* For a file in a tar the whole tar is mapped, as the positions are those in the tar. */
+	if (have_stat && st.st_size > 0) {
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+		if (map != MAP_FAILED) {
+			_fio.maps[slot] = (byte *)map;
+			_fio.map_sizes[slot] = st.st_size;
+		}
+	}
+#endif /* WITH_MAPPED_SLOTS */
+
 #if defined(LIMITED_FDS)
 	_fio.usage_count[slot] = 0;
 	_fio.open_handles++;
@@ -243,6 +314,29 @@ TarFileList _tar_filelist;
 typedef std::map<std::string, std::string> TarLinkList;
 static TarLinkList _tar_linklist; ///< List of directory links
 
+/** A file in a tar, as kept in the tar scan cache. */
+struct TarScanCacheFile {
+	size_t size;     ///< The size of the file.
+	size_t position; ///< The position of the file in the tar.
+};
+
+/** What a scan of a tar found, so an unchanged tar needn't be read again by the next scan. */
+struct TarScanCacheItem {
+	uint64 size;                                         ///< The size of the tar.
+	int64 mtime;                                         ///< The modification time of the tar.
+	std::string dirname;                                 ///< The first directory in the tar; empty if there is none.
+	std::map<std::string, TarScanCacheFile> files;       ///< The files in the tar, by their simplified name.
+	TarLinkList links;                                   ///< The links in the tar, resolved within the tar.
+};
+
+typedef std::map<std::string, TarScanCacheItem> TarScanCache;
+
+/** The version of the format of the tar scan cache file. */
+static const uint32 TAR_SCAN_CACHE_VERSION = 1;
+
+static TarScanCache _tar_scan_cache; ///< What the last scan found, by the path of the tar.
+static TarScanCache _tar_scan_found; ///< What this scan found, to be remembered for the next scan.
+
 /**
  * Check whether the given file exists
  * @param filename the file to try for existance
@@ -544,18 +638,158 @@ static void SimplifyFileName(char *name)
 #endif
 }
 
+/**
+ * Get the name of the file with what the last scan found in the tars.
+ * @param buf  the buffer for the name
+ * @param last the last element of the buffer
+ */
+static void GetTarScanCacheFilename(char *buf, const char *last)
+{
+	seprintf(buf, last, "%starscan.cache", _personal_dir);
+}
+
+/**
+ * Write a string to the tar scan cache file.
+ * @param f   the file
+ * @param str the string
+ */
+static void WriteTarScanCacheString(FILE *f, const std::string &str)
+{
+	uint32 len = (uint32)str.length();
+	fwrite(&len, sizeof(len), 1, f);
+	if (len != 0) fwrite(str.data(), 1, len, f);
+}
+
+/**
+ * Read a string from the tar scan cache file.
+ * @param f   the file
+ * @param str where to store the string
+ * @return false if the file is broken
+ */
+static bool ReadTarScanCacheString(FILE *f, std::string *str)
+{
+	char buf[1024];
+	uint32 len;
+	if (fread(&len, sizeof(len), 1, f) != 1 || len > sizeof(buf)) return false;
+
+	if (len != 0 && fread(buf, 1, len, f) != len) return false;
+	str->assign(buf, len);
+	return true;
+}
+
+/** Read what the last scan found in the tars. */
+static void LoadTarScanCache()
+{
+	_tar_scan_cache.clear();
+
+	char filename[MAX_PATH];
+	GetTarScanCacheFilename(filename, lastof(filename));
+	FILE *f = fopen(filename, "rb");
+	if (f == NULL) return;
+
+	uint32 header[3];
+	bool ok = fread(header, sizeof(header), 1, f) == 1 && header[0] == TAR_SCAN_CACHE_VERSION && header[1] == TTD_ENDIAN;
+
+	for (uint32 i = 0; ok && i < header[2]; i++) {
+		std::string path;
+		uint32 num_files, num_links;
+		ok = ReadTarScanCacheString(f, &path);
+		if (!ok) break;
+
+		TarScanCacheItem &item = _tar_scan_cache[path];
+		ok = fread(&item.size, sizeof(item.size), 1, f) == 1 &&
+				fread(&item.mtime, sizeof(item.mtime), 1, f) == 1 &&
+				ReadTarScanCacheString(f, &item.dirname) &&
+				fread(&num_files, sizeof(num_files), 1, f) == 1;
+
+		for (uint32 j = 0; ok && j < num_files; j++) {
+			std::string name;
+			uint64 file[2];
+			ok = ReadTarScanCacheString(f, &name) && fread(file, sizeof(file), 1, f) == 1;
+			TarScanCacheFile &entry = item.files[name];
+			entry.size = (size_t)file[0];
+			entry.position = (size_t)file[1];
+		}
+
+		ok = ok && fread(&num_links, sizeof(num_links), 1, f) == 1;
+		for (uint32 j = 0; ok && j < num_links; j++) {
+			std::string src, dest;
+			ok = ReadTarScanCacheString(f, &src) && ReadTarScanCacheString(f, &dest);
+			item.links[src] = dest;
+		}
+	}
+
+	if (!ok) {
+		DEBUG(misc, 1, "Tar scan cache is broken; reading all tars");
+		_tar_scan_cache.clear();
+	}
+
+	fclose(f);
+}
+
+/** Remember what this scan found in the tars for the next scan. */
+static void SaveTarScanCache()
+{
+	char filename[MAX_PATH];
+	GetTarScanCacheFilename(filename, lastof(filename));
+	FILE *f = fopen(filename, "wb");
+	if (f == NULL) return;
+
+	uint32 header[3] = { TAR_SCAN_CACHE_VERSION, TTD_ENDIAN, (uint32)_tar_scan_found.size() };
+	fwrite(header, sizeof(header), 1, f);
+
+	for (TarScanCache::const_iterator it = _tar_scan_found.begin(); it != _tar_scan_found.end(); it++) {
+		const TarScanCacheItem &item = it->second;
+		WriteTarScanCacheString(f, it->first);
+		fwrite(&item.size, sizeof(item.size), 1, f);
+		fwrite(&item.mtime, sizeof(item.mtime), 1, f);
+		WriteTarScanCacheString(f, item.dirname);
+
+		uint32 num_files = (uint32)item.files.size();
+		fwrite(&num_files, sizeof(num_files), 1, f);
+		for (std::map<std::string, TarScanCacheFile>::const_iterator file = item.files.begin(); file != item.files.end(); file++) {
+			WriteTarScanCacheString(f, file->first);
+			uint64 entry[2] = { file->second.size, file->second.position };
+			fwrite(entry, sizeof(entry), 1, f);
+		}
+
+		uint32 num_links = (uint32)item.links.size();
+		fwrite(&num_links, sizeof(num_links), 1, f);
+		for (TarLinkList::const_iterator link = item.links.begin(); link != item.links.end(); link++) {
+			WriteTarScanCacheString(f, link->first);
+			WriteTarScanCacheString(f, link->second);
+		}
+	}
+
+	if (ferror(f) != 0) DEBUG(misc, 0, "Could not write the tar scan cache '%s'", filename);
+	fclose(f);
+}
+
 /* static */ uint TarScanner::DoScan() {
 	DEBUG(misc, 1, "Scanning for tars");
+	LoadTarScanCache();
+
 	TarScanner fs;
 	uint num = fs.Scan(".tar", DATA_DIR, false);
 	num += fs.Scan(".tar", AI_DIR, false);
 	num += fs.Scan(".tar", AI_LIBRARY_DIR, false);
 	num += fs.Scan(".tar", SCENARIO_DIR, false);
 	DEBUG(misc, 1, "Scan complete, found %d files", num);
+
+	SaveTarScanCache();
+	_tar_scan_cache.clear();
+	_tar_scan_found.clear();
 	return num;
 }
 
-bool TarScanner::AddFile(const char *filename, size_t basepath_length)
+/**
+ * Read the headers of a tar to find what is in it.
+ * @param f        the tar, at its start
+ * @param filename the name of the tar
+ * @param item     where to store what is found
+ * @return false if the tar is broken; what was found up to there is in \a item still
+ */
+static bool ReadTarHeaders(FILE *f, const char *filename, TarScanCacheItem *item)
 {
 	/* The TAR-header, repeated for every file */
 	typedef struct TarHeader {
@@ -579,29 +813,12 @@ bool TarScanner::AddFile(const char *filename, size_t basepath_length)
 		char unused[12];
 	} TarHeader;
 
-	/* Check if we already seen this file */
-	TarList::iterator it = _tar_list.find(filename);
-	if (it != _tar_list.end()) return false;
-
-	FILE *f = fopen(filename, "rb");
-	/* Although the file has been found there can be
-	 * a number of reasons we cannot open the file.
-	 * Most common case is when we simply have not
-	 * been given read access. */
-	if (f == NULL) return false;
-
-	const char *dupped_filename = strdup(filename);
-	_tar_list[filename].filename = dupped_filename;
-	_tar_list[filename].dirname = NULL;
-
-	TarLinkList links; ///< Temporary list to collect links
-
 	TarHeader th;
 	char buf[sizeof(th.name) + 1], *end;
 	char name[sizeof(th.prefix) + 1 + sizeof(th.name) + 1];
 	char link[sizeof(th.linkname) + 1];
 	char dest[sizeof(th.prefix) + 1 + sizeof(th.name) + 1 + 1 + sizeof(th.linkname) + 1];
-	size_t num = 0, pos = 0;
+	size_t pos = 0;
 
 	/* Make a char of 512 empty bytes */
 	char empty[512];
@@ -651,16 +868,15 @@ bool TarScanner::AddFile(const char *filename, size_t basepath_length)
 				if (strlen(name) == 0) break;
 
 				/* Store this entry in the list */
-				TarFileListEntry entry;
-				entry.tar_filename = dupped_filename;
-				entry.size         = skip;
-				entry.position     = pos;
+				TarScanCacheFile entry;
+				entry.size     = skip;
+				entry.position = pos;
 
 				/* Convert to lowercase and our PATHSEPCHAR */
 				SimplifyFileName(name);
 
 				DEBUG(misc, 6, "Found file in tar: %s (" PRINTF_SIZE " bytes, " PRINTF_SIZE " offset)", name, skip, pos);
-				if (_tar_filelist.insert(TarFileList::value_type(name, entry)).second) num++;
+				item->files.insert(std::map<std::string, TarScanCacheFile>::value_type(name, entry));
 
 				break;
 			}
@@ -722,7 +938,7 @@ bool TarScanner::AddFile(const char *filename, size_t basepath_length)
 
 				/* Store links in temporary list */
 				DEBUG(misc, 6, "Found link in tar: %s -> %s", name, dest);
-				links.insert(TarLinkList::value_type(name, dest));
+				item->links.insert(TarLinkList::value_type(name, dest));
 
 				break;
 			}
@@ -733,7 +949,7 @@ bool TarScanner::AddFile(const char *filename, size_t basepath_length)
 
 				/* Store the first directory name we detect */
 				DEBUG(misc, 6, "Found dir in tar: %s", name);
-				if (_tar_list[filename].dirname == NULL) _tar_list[filename].dirname = strdup(name);
+				if (item->dirname.empty()) item->dirname = name;
 				break;
 
 			default:
@@ -747,9 +963,59 @@ bool TarScanner::AddFile(const char *filename, size_t basepath_length)
 		pos += skip;
 	}
 
-	DEBUG(misc, 1, "Found tar '%s' with " PRINTF_SIZE " new files", filename, num);
+	return true;
+}
+
+bool TarScanner::AddFile(const char *filename, size_t basepath_length)
+{
+	/* Check if we already seen this file */
+	TarList::iterator it = _tar_list.find(filename);
+	if (it != _tar_list.end()) return false;
+
+	FILE *f = fopen(filename, "rb");
+	/* Although the file has been found there can be
+	 * a number of reasons we cannot open the file.
+	 * Most common case is when we simply have not
+	 * been given read access. */
+	if (f == NULL) return false;
+
+	const char *dupped_filename = strdup(filename);
+	_tar_list[filename].filename = dupped_filename;
+	_tar_list[filename].dirname = NULL;
+
+	/* A tar that didn't change since the last scan needn't be read again. */
+	struct stat st;
+	bool have_stat = fstat(fileno(f), &st) == 0;
+	TarScanCache::iterator cached = _tar_scan_cache.find(filename);
+	bool valid = true;
+	TarScanCacheItem found;
+	const TarScanCacheItem *item;
+	if (have_stat && cached != _tar_scan_cache.end() && cached->second.size == (uint64)st.st_size && cached->second.mtime == (int64)st.st_mtime) {
+		DEBUG(misc, 6, "Tar '%s' didn't change since the last scan", filename);
+		item = &cached->second;
+	} else {
+		found.size = have_stat ? st.st_size : 0;
+		found.mtime = have_stat ? st.st_mtime : 0;
+		valid = ReadTarHeaders(f, filename, &found);
+		item = &found;
+	}
 	fclose(f);
 
+	size_t num = 0;
+	for (std::map<std::string, TarScanCacheFile>::const_iterator file = item->files.begin(); file != item->files.end(); file++) {
+		TarFileListEntry entry;
+		entry.tar_filename = dupped_filename;
+		entry.size         = file->second.size;
+		entry.position     = file->second.position;
+		if (_tar_filelist.insert(TarFileList::value_type(file->first, entry)).second) num++;
+	}
+	if (!item->dirname.empty()) _tar_list[filename].dirname = strdup(item->dirname.c_str());
+
+	if (!valid) return false;
+
+	DEBUG(misc, 1, "Found tar '%s' with " PRINTF_SIZE " new files", filename, num);
+	if (have_stat) _tar_scan_found[filename] = *item;
+
 	/* Resolve file links and store directory links.
 	 * We restrict usage of links to two cases:
 	 *  1) Links to directories:
@@ -759,7 +1025,7 @@ bool TarScanner::AddFile(const char *filename, size_t basepath_length)
 	 *      The destination path must NOT contain any links.
 	 *      The source path may contain one directory link.
 	 */
-	for (TarLinkList::iterator link = links.begin(); link != links.end(); link++) {
+	for (TarLinkList::const_iterator link = item->links.begin(); link != item->links.end(); link++) {
 		const std::string &src = link->first;
 		const std::string &dest = link->second;
 		TarAddLink(src, dest);
@@ -1122,6 +1388,53 @@ void *ReadFileToMem(const char *filename, size_t *lenp, size_t maxsize)
 	return mem;
 }
 
+/**
+ * Map a file read-only into memory. When the OS supports it, the pages of
+ * the file are shared by all processes that map it. Otherwise the file is
+ * simply read into memory. Unlike with #ReadFileToMem, there is no
+ * terminating zero after the data.
+ * @param filename the file to map
+ * @param lenp     the size of the file is returned here
+ * @param maxsize  the maximum size of the file
+ * @return the data of the file, or NULL on failure; release it with #UnmapFileFromMem
+ */
+const void *MapFileToMem(const char *filename, size_t *lenp, size_t maxsize)
+{
+#ifdef WITH_MAPPED_FILES
+	FILE *in = fopen(filename, "rb");
+	if (in == NULL) return NULL;
+
+	struct stat st;
+	void *map = MAP_FAILED;
+	if (fstat(fileno(in), &st) == 0 && st.st_size > 0 && (size_t)st.st_size <= maxsize) {
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fileno(in), 0);
+	}
+	/* The mapping stays valid after closing the file. */
+	fclose(in);
+	if (map == MAP_FAILED) return NULL;
+
+	*lenp = st.st_size;
+	return map;
+#else
+	return ReadFileToMem(filename, lenp, maxsize);
+#endif /* WITH_MAPPED_FILES */
+}
+
+/**
+ * Release a file that was mapped with #MapFileToMem.
+ * @param mem the data of the file
+ * @param len the size of the file
+ */
+void UnmapFileFromMem(const void *mem, size_t len)
+{
+	if (mem == NULL) return;
+#ifdef WITH_MAPPED_FILES
+	munmap(const_cast<void *>(mem), len);
+#else
+	free(const_cast<void *>(mem));
+#endif /* WITH_MAPPED_FILES */
+}
+
 
 /**
  * Scan a single directory (and recursively its children) and add
@@ -18,6 +18,7 @@ void FioSeekTo(size_t pos, int mode);
 void FioSeekToFile(uint8 slot, size_t pos);
 size_t FioGetPos();
 const char *FioGetFilename(uint8 slot);
+uint32 FioGetFileStamp(uint8 slot);
 byte FioReadByte();
 uint16 FioReadWord();
 uint32 FioReadDword();
@@ -60,6 +61,8 @@ void SanitizeFilename(char *filename);
 bool AppendPathSeparator(char *buf, size_t buflen);
 void DeterminePaths(const char *exe);
 void *ReadFileToMem(const char *filename, size_t *lenp, size_t maxsize);
+const void *MapFileToMem(const char *filename, size_t *lenp, size_t maxsize);
+void UnmapFileFromMem(const void *mem, size_t len);
 bool FileExists(const char *filename);
 const char *FioTarFirstDir(const char *tarname);
 void FioTarAddLink(const char *src, const char *dest);
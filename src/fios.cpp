@@ -18,6 +18,7 @@
 #include "fileio_func.h"
 #include "tar_type.h"
 #include "string_func.h"
+#include "debug.h"
 #include <sys/stat.h>
 
 #ifdef WIN32
@@ -64,9 +65,61 @@ int CDECL CompareFiosItems(const FiosItem *da, const FiosItem *db)
 	return r;
 }
 
+typedef FiosType fios_getlist_callback_proc(SaveLoadDialogMode mode, const char *filename, const char *ext, char *title, const char *last);
+
+/** The time the files of a directory are listed at once when the list is built a bit at a time, in milliseconds. */
+static const uint FIOS_LIST_SLICE = 10;
+
+/**
+ * The state of building the file list. The directory is read a bit at a
+ * time, so a directory with thousands of files, or on a slow network share,
+ * does not block the game while the list is built.
+ */
+static struct FiosListState {
+	DIR *dir;                                  ///< The directory being read, or NULL when it is read completely.
+	SaveLoadDialogMode mode;                   ///< The mode we are listing for.
+	fios_getlist_callback_proc *callback_proc; ///< Callback to check whether a file may be added.
+	bool list_files;                           ///< Whether the files come from #dir, instead of a scan of the search paths.
+	bool parent;                               ///< Whether the list starts with the parent directory.
+	bool quiet;                                ///< Whether the list is only replaced once it is complete.
+	SmallVector<FiosItem, 32> dirs;            ///< The directories found so far.
+	SmallVector<FiosItem, 32> files;           ///< The files found so far.
+} _fios_list;
+
+/** The last complete list, shown at once when the same directory is listed again while it is read anew. */
+static struct FiosListCache {
+	char path[MAX_PATH];                       ///< The listed directory; empty when nothing is cached.
+	SaveLoadDialogMode mode;                   ///< The mode it was listed for.
+	fios_getlist_callback_proc *callback_proc; ///< The callback it was listed with.
+	SmallVector<FiosItem, 32> dirs;            ///< The directories of the list.
+	SmallVector<FiosItem, 32> files;           ///< The files of the list.
+} _fios_list_cache;
+
+/**
+ * Replace the items of a list by those of another.
+ * @param dst The list to fill.
+ * @param src The list to copy.
+ */
+static void CopyFiosItems(SmallVector<FiosItem, 32> *dst, const SmallVector<FiosItem, 32> &src)
+{
+	dst->Clear();
+	if (src.Length() != 0) memcpy(dst->Append(src.Length()), src.Begin(), src.Length() * sizeof(FiosItem));
+}
+
+/** Stop reading the directory of the list, if that still happens. */
+static void FiosStopReadingDirectory()
+{
+	if (_fios_list.dir == NULL) return;
+	closedir(_fios_list.dir);
+	_fios_list.dir = NULL;
+}
+
 /** Clear the list */
 void FiosFreeSavegameList()
 {
+	FiosStopReadingDirectory();
+	_fios_list.dirs.Reset();
+	_fios_list.files.Reset();
 	_fios_items.Clear();
 	_fios_items.Compact();
 }
@@ -190,7 +243,57 @@ bool FileExists(const char *filename)
 #endif
 }
 
-typedef FiosType fios_getlist_callback_proc(SaveLoadDialogMode mode, const char *filename, const char *ext, char *title, const char *last);
+/**
+ * Add a file to a list when it is of the type that is listed.
+ * @param items    The list to add the file to.
+ * @param mode     The mode we are listing for.
+ * @param callback_proc The function that tells whether the file may be added.
+ * @param filename The full path to the file.
+ * @param mtime    The time the file was last changed, or NULL if it still has to be determined.
+ * @return true if the file is added.
+ */
+static bool FiosAddFile(SmallVector<FiosItem, 32> *items, SaveLoadDialogMode mode, fios_getlist_callback_proc *callback_proc, const char *filename, const uint64 *mtime)
+{
+	const char *ext = strrchr(filename, '.');
+	if (ext == NULL) return false;
+
+	char fios_title[64];
+	fios_title[0] = '\0'; // reset the title;
+
+	FiosType type = callback_proc(mode, filename, ext, fios_title, lastof(fios_title));
+	if (type == FIOS_TYPE_INVALID) return false;
+
+	FiosItem *fios = items->Append();
+	if (mtime != NULL) {
+		fios->mtime = *mtime;
+	} else {
+#ifdef WIN32
+		struct _stat sb;
+		if (_tstat(OTTD2FS(filename), &sb) == 0) {
+#else
+		struct stat sb;
+		if (stat(filename, &sb) == 0) {
+#endif
+			fios->mtime = sb.st_mtime;
+		} else {
+			fios->mtime = 0;
+		}
+	}
+
+	fios->type = type;
+	strecpy(fios->name, filename, lastof(fios->name));
+
+	/* If the file doesn't have a title, use its filename */
+	const char *t = fios_title;
+	if (StrEmpty(fios_title)) {
+		t = strrchr(filename, PATHSEPCHAR);
+		t = (t == NULL) ? filename : (t + 1);
+	}
+	strecpy(fios->title, t, lastof(fios->title));
+	str_validate(fios->title, lastof(fios->title));
+
+	return true;
+}
 
 /**
  * Scanner to scan for a particular type of FIOS file.
@@ -220,118 +323,165 @@ public:
  */
 bool FiosFileScanner::AddFile(const char *filename, size_t basepath_length)
 {
-	const char *ext = strrchr(filename, '.');
-	if (ext == NULL) return false;
-
-	char fios_title[64];
-	fios_title[0] = '\0'; // reset the title;
-
-	FiosType type = this->callback_proc(this->mode, filename, ext, fios_title, lastof(fios_title));
-	if (type == FIOS_TYPE_INVALID) return false;
-
-	for (const FiosItem *fios = _fios_items.Begin(); fios != _fios_items.End(); fios++) {
+	/* The same file can be found via several search paths. */
+	for (const FiosItem *fios = _fios_list.files.Begin(); fios != _fios_list.files.End(); fios++) {
 		if (strcmp(fios->name, filename) == 0) return false;
 	}
 
-	FiosItem *fios = _fios_items.Append();
-#ifdef WIN32
-	struct _stat sb;
-	if (_tstat(OTTD2FS(filename), &sb) == 0) {
-#else
+	return FiosAddFile(&_fios_list.files, this->mode, this->callback_proc, filename, NULL);
+}
+
+/**
+ * Read more entries of the directory of the list.
+ * @param deadline The GetMonotonicMilliseconds() at which to stop reading, or 0 to read the whole directory.
+ * @return true when the whole directory has been read.
+ */
+static bool FiosReadDirectory(uint64 deadline)
+{
 	struct stat sb;
-	if (stat(filename, &sb) == 0) {
-#endif
-		fios->mtime = sb.st_mtime;
-	} else {
-		fios->mtime = 0;
-	}
+	struct dirent *dirent;
 
-	fios->type = type;
-	strecpy(fios->name, filename, lastof(fios->name));
+	while ((dirent = readdir(_fios_list.dir)) != NULL) {
+		char d_name[sizeof(_fios_list.dirs.Begin()->name)];
+		strecpy(d_name, FS2OTTD(dirent->d_name), lastof(d_name));
+
+		if (FiosIsValidFile(_fios_path, dirent, &sb)) {
+			if (S_ISDIR(sb.st_mode)) {
+				/* found file must be directory, but not '.' or '..' */
+				if (_fios_list.mode != SLD_NEW_GAME &&
+						(!FiosIsHiddenFile(dirent) || strncasecmp(d_name, PERSONAL_DIR, strlen(d_name)) == 0) &&
+						strcmp(d_name, ".") != 0 && strcmp(d_name, "..") != 0) {
+					FiosItem *fios = _fios_list.dirs.Append();
+					fios->type = FIOS_TYPE_DIR;
+					fios->mtime = 0;
+					strecpy(fios->name, d_name, lastof(fios->name));
+					snprintf(fios->title, lengthof(fios->title), "%s" PATHSEP " (Directory)", d_name);
+					str_validate(fios->title, lastof(fios->title));
+				}
+			} else if (S_ISREG(sb.st_mode) && _fios_list.list_files) {
+				char filename[MAX_PATH];
+				snprintf(filename, lengthof(filename), "%s%s", _fios_path, d_name);
+				uint64 mtime = sb.st_mtime;
+				FiosAddFile(&_fios_list.files, _fios_list.mode, _fios_list.callback_proc, filename, &mtime);
+			}
+		}
 
-	/* If the file doesn't have a title, use its filename */
-	const char *t = fios_title;
-	if (StrEmpty(fios_title)) {
-		t = strrchr(filename, PATHSEPCHAR);
-		t = (t == NULL) ? filename : (t + 1);
+		if (deadline != 0 && GetMonotonicMilliseconds() >= deadline) return false;
 	}
-	strecpy(fios->title, t, lastof(fios->title));
-	str_validate(fios->title, lastof(fios->title));
 
+	FiosStopReadingDirectory();
 	return true;
 }
 
-
-/** Fill the list of the files in a directory, according to some arbitrary rule.
- *  @param mode The mode we are in. Some modes don't allow 'parent'.
- *  @param callback_proc The function that is called where you need to do the filtering.
- *  @param subdir The directory from where to start (global) searching.
+/**
+ * Fill #_fios_items with the parent directory, the directories, the files and the drives.
+ * @param dirs  The directories to show.
+ * @param files The files to show.
  */
-static void FiosGetFileList(SaveLoadDialogMode mode, fios_getlist_callback_proc *callback_proc, Subdirectory subdir)
+static void FiosMakeFileList(SmallVector<FiosItem, 32> *dirs, SmallVector<FiosItem, 32> *files)
 {
-	struct stat sb;
-	struct dirent *dirent;
-	DIR *dir;
-	FiosItem *fios;
-	int sort_start;
-	char d_name[sizeof(fios->name)];
-
 	_fios_items.Clear();
 
 	/* A parent directory link exists if we are not in the root directory */
-	if (!FiosIsRoot(_fios_path) && mode != SLD_NEW_GAME) {
-		fios = _fios_items.Append();
+	if (_fios_list.parent) {
+		FiosItem *fios = _fios_items.Append();
 		fios->type = FIOS_TYPE_PARENT;
 		fios->mtime = 0;
 		strecpy(fios->name, "..", lastof(fios->name));
 		strecpy(fios->title, ".. (Parent directory)", lastof(fios->title));
 	}
 
-	/* Show subdirectories */
-	if (mode != SLD_NEW_GAME && (dir = ttd_opendir(_fios_path)) != NULL) {
-		while ((dirent = readdir(dir)) != NULL) {
-			strecpy(d_name, FS2OTTD(dirent->d_name), lastof(d_name));
-
-			/* found file must be directory, but not '.' or '..' */
-			if (FiosIsValidFile(_fios_path, dirent, &sb) && S_ISDIR(sb.st_mode) &&
-					(!FiosIsHiddenFile(dirent) || strncasecmp(d_name, PERSONAL_DIR, strlen(d_name)) == 0) &&
-					strcmp(d_name, ".") != 0 && strcmp(d_name, "..") != 0) {
-				fios = _fios_items.Append();
-				fios->type = FIOS_TYPE_DIR;
-				fios->mtime = 0;
-				strecpy(fios->name, d_name, lastof(fios->name));
-				snprintf(fios->title, lengthof(fios->title), "%s" PATHSEP " (Directory)", d_name);
-				str_validate(fios->title, lastof(fios->title));
-			}
-		}
-		closedir(dir);
-	}
-
 	/* Sort the subdirs always by name, ascending, remember user-sorting order */
 	{
 		SortingBits order = _savegame_sort_order;
 		_savegame_sort_order = SORT_BY_NAME | SORT_ASCENDING;
-		QSortT(_fios_items.Begin(), _fios_items.Length(), CompareFiosItems);
+		QSortT(dirs->Begin(), dirs->Length(), CompareFiosItems);
 		_savegame_sort_order = order;
 	}
+	QSortT(files->Begin(), files->Length(), CompareFiosItems);
 
-	/* This is where to start sorting for the filenames */
-	sort_start = _fios_items.Length();
+	for (const FiosItem *fios = dirs->Begin(); fios != dirs->End(); fios++) *_fios_items.Append() = *fios;
+	for (const FiosItem *fios = files->Begin(); fios != files->End(); fios++) *_fios_items.Append() = *fios;
 
-	/* Show files */
-	FiosFileScanner scanner(mode, callback_proc);
-	if (subdir == NO_DIRECTORY) {
-		scanner.Scan(NULL, _fios_path, false);
-	} else {
+	/* Show drives */
+	if (_fios_list.mode != SLD_NEW_GAME) FiosGetDrives();
+}
+
+/** The directory is read completely: show the whole list and remember it. */
+static void FiosFinishFileList()
+{
+	FiosMakeFileList(&_fios_list.dirs, &_fios_list.files);
+	_fios_items.Compact();
+
+	strecpy(_fios_list_cache.path, _fios_path, lastof(_fios_list_cache.path));
+	_fios_list_cache.mode = _fios_list.mode;
+	_fios_list_cache.callback_proc = _fios_list.callback_proc;
+	CopyFiosItems(&_fios_list_cache.dirs, _fios_list.dirs);
+	CopyFiosItems(&_fios_list_cache.files, _fios_list.files);
+}
+
+/**
+ * Continue building a file list that is built a bit at a time.
+ * @return true when #_fios_items has changed, so pointers to its items are not valid anymore.
+ */
+bool FiosContinueFileList()
+{
+	if (_fios_list.dir == NULL) return false;
+
+	uint found = _fios_list.dirs.Length() + _fios_list.files.Length();
+	if (FiosReadDirectory(GetMonotonicMilliseconds() + FIOS_LIST_SLICE)) {
+		FiosFinishFileList();
+		return true;
+	}
+
+	if (_fios_list.quiet || found == _fios_list.dirs.Length() + _fios_list.files.Length()) return false;
+
+	FiosMakeFileList(&_fios_list.dirs, &_fios_list.files);
+	return true;
+}
+
+
+/** Fill the list of the files in a directory, according to some arbitrary rule.
+ *  @param mode The mode we are in. Some modes don't allow 'parent'.
+ *  @param callback_proc The function that is called where you need to do the filtering.
+ *  @param subdir The directory from where to start (global) searching.
+ *  @param incremental Whether the directory may be read a bit at a time by #FiosContinueFileList.
+ */
+static void FiosGetFileList(SaveLoadDialogMode mode, fios_getlist_callback_proc *callback_proc, Subdirectory subdir, bool incremental)
+{
+	FiosStopReadingDirectory();
+	_fios_items.Clear();
+
+	_fios_list.mode = mode;
+	_fios_list.callback_proc = callback_proc;
+	_fios_list.list_files = subdir == NO_DIRECTORY;
+	_fios_list.parent = !FiosIsRoot(_fios_path) && mode != SLD_NEW_GAME;
+	_fios_list.quiet = false;
+	_fios_list.dirs.Clear();
+	_fios_list.files.Clear();
+
+	/* Files in the search paths and tars are found by scanning those. */
+	if (!_fios_list.list_files) {
+		FiosFileScanner scanner(mode, callback_proc);
 		scanner.Scan(NULL, subdir, true, true);
 	}
 
-	QSortT(_fios_items.Get(sort_start), _fios_items.Length() - sort_start, CompareFiosItems);
+	/* Show subdirectories and, when not scanned already, the files */
+	if (mode != SLD_NEW_GAME || _fios_list.list_files) _fios_list.dir = ttd_opendir(_fios_path);
 
-	/* Show drives */
-	if (mode != SLD_NEW_GAME) FiosGetDrives();
+	if (_fios_list.dir == NULL || !incremental || FiosReadDirectory(GetMonotonicMilliseconds() + FIOS_LIST_SLICE)) {
+		if (_fios_list.dir != NULL) FiosReadDirectory(0);
+		FiosFinishFileList();
+		return;
+	}
 
-	_fios_items.Compact();
+	/* Reading takes a while; show the list of the last time till it is done. */
+	if (strcmp(_fios_list_cache.path, _fios_path) == 0 && _fios_list_cache.mode == mode && _fios_list_cache.callback_proc == callback_proc) {
+		_fios_list.quiet = true;
+		FiosMakeFileList(&_fios_list_cache.dirs, &_fios_list_cache.files);
+	} else {
+		FiosMakeFileList(&_fios_list.dirs, &_fios_list.files);
+	}
 }
 
 /**
@@ -394,10 +544,11 @@ FiosType FiosGetSavegameListCallback(SaveLoadDialogMode mode, const char *file,
 /**
  * Get a list of savegames.
  * @param mode Save/load mode.
+ * @param incremental Whether the list may be built a bit at a time; see #FiosContinueFileList.
  * @return A pointer to an array of FiosItem representing all the files to be shown in the save/load dialog.
  * @see FiosGetFileList
  */
-void FiosGetSavegameList(SaveLoadDialogMode mode)
+void FiosGetSavegameList(SaveLoadDialogMode mode, bool incremental)
 {
 	static char *fios_save_path = NULL;
 
@@ -408,7 +559,7 @@ void FiosGetSavegameList(SaveLoadDialogMode mode)
 
 	_fios_path = fios_save_path;
 
-	FiosGetFileList(mode, &FiosGetSavegameListCallback, NO_DIRECTORY);
+	FiosGetFileList(mode, &FiosGetSavegameListCallback, NO_DIRECTORY, incremental);
 }
 
 /**
@@ -446,10 +597,11 @@ static FiosType FiosGetScenarioListCallback(SaveLoadDialogMode mode, const char
 /**
  * Get a list of scenarios.
  * @param mode Save/load mode.
+ * @param incremental Whether the list may be built a bit at a time; see #FiosContinueFileList.
  * @return A pointer to an array of FiosItem representing all the files to be shown in the save/load dialog.
  * @see FiosGetFileList
  */
-void FiosGetScenarioList(SaveLoadDialogMode mode)
+void FiosGetScenarioList(SaveLoadDialogMode mode, bool incremental)
 {
 	static char *fios_scn_path = NULL;
 
@@ -464,7 +616,7 @@ void FiosGetScenarioList(SaveLoadDialogMode mode)
 	char base_path[MAX_PATH];
 	FioGetDirectory(base_path, sizeof(base_path), SCENARIO_DIR);
 
-	FiosGetFileList(mode, &FiosGetScenarioListCallback, (mode == SLD_LOAD_SCENARIO && strcmp(base_path, _fios_path) == 0) ? SCENARIO_DIR : NO_DIRECTORY);
+	FiosGetFileList(mode, &FiosGetScenarioListCallback, (mode == SLD_LOAD_SCENARIO && strcmp(base_path, _fios_path) == 0) ? SCENARIO_DIR : NO_DIRECTORY, incremental);
 }
 
 static FiosType FiosGetHeightmapListCallback(SaveLoadDialogMode mode, const char *file, const char *ext, char *title, const char *last)
@@ -512,7 +664,7 @@ static FiosType FiosGetHeightmapListCallback(SaveLoadDialogMode mode, const char
 }
 
 /* Get a list of Heightmaps */
-void FiosGetHeightmapList(SaveLoadDialogMode mode)
+void FiosGetHeightmapList(SaveLoadDialogMode mode, bool incremental)
 {
 	static char *fios_hmap_path = NULL;
 
@@ -526,7 +678,7 @@ void FiosGetHeightmapList(SaveLoadDialogMode mode)
 	char base_path[MAX_PATH];
 	FioGetDirectory(base_path, sizeof(base_path), HEIGHTMAP_DIR);
 
-	FiosGetFileList(mode, &FiosGetHeightmapListCallback, strcmp(base_path, _fios_path) == 0 ? HEIGHTMAP_DIR : NO_DIRECTORY);
+	FiosGetFileList(mode, &FiosGetHeightmapListCallback, strcmp(base_path, _fios_path) == 0 ? HEIGHTMAP_DIR : NO_DIRECTORY, incremental);
 }
 
 #if defined(ENABLE_NETWORK)
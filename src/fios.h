@@ -67,6 +67,7 @@ struct LoadCheckData {
 	}
 
 	void Clear();
+	void CopyFrom(const LoadCheckData &src);
 };
 
 extern LoadCheckData _load_check_data;
@@ -155,11 +156,13 @@ extern SortingBits _savegame_sort_order;
 void ShowSaveLoadDialog(SaveLoadDialogMode mode);
 
 /* Get a list of savegames */
-void FiosGetSavegameList(SaveLoadDialogMode mode);
+void FiosGetSavegameList(SaveLoadDialogMode mode, bool incremental = false);
 /* Get a list of scenarios */
-void FiosGetScenarioList(SaveLoadDialogMode mode);
+void FiosGetScenarioList(SaveLoadDialogMode mode, bool incremental = false);
 /* Get a list of Heightmaps */
-void FiosGetHeightmapList(SaveLoadDialogMode mode);
+void FiosGetHeightmapList(SaveLoadDialogMode mode, bool incremental = false);
+/* Continue building a list that is built a bit at a time */
+bool FiosContinueFileList();
 /* Free the list of savegames */
 void FiosFreeSavegameList();
 /* Browse to. Returns a filename w/path if we reached a file. */
@@ -178,7 +181,7 @@ int CDECL CompareFiosItems(const FiosItem *a, const FiosItem *b);
 /* FIOS_TYPE_FILE, FIOS_TYPE_OLDFILE etc. different colours */
 extern const TextColour _fios_colours[];
 
-void BuildFileList();
+void BuildFileList(bool incremental = false);
 void SetFiosType(const byte fiostype);
 
 #endif /* FIOS_H */
@@ -19,6 +19,7 @@
 #include "network/network_content.h"
 #include "strings_func.h"
 #include "fileio_func.h"
+#include "string_func.h"
 #include "fios.h"
 #include "window_func.h"
 #include "tilehighlight_func.h"
@@ -60,6 +61,77 @@ void LoadCheckData::Clear()
 	ClearGRFConfigList(&this->grfconfig);
 }
 
+/**
+ * Replace the read data by a copy of other read data.
+ * @param src The data to copy.
+ */
+void LoadCheckData::CopyFrom(const LoadCheckData &src)
+{
+	this->Clear();
+
+	this->checkable = src.checkable;
+	this->error = src.error;
+	if (src.error_data != NULL) this->error_data = strdup(src.error_data);
+
+	this->map_size_x = src.map_size_x;
+	this->map_size_y = src.map_size_y;
+	this->current_date = src.current_date;
+	this->settings = src.settings;
+
+	const CompanyPropertiesMap::const_iterator end = src.companies.End();
+	for (CompanyPropertiesMap::const_iterator it = src.companies.Begin(); it != end; it++) {
+		CompanyProperties *cprops = new CompanyProperties();
+		*cprops = *it->second;
+		if (cprops->name != NULL) cprops->name = strdup(cprops->name);
+		if (cprops->president_name != NULL) cprops->president_name = strdup(cprops->president_name);
+		this->companies.Insert(it->first, cprops);
+	}
+
+	CopyGRFConfigList(&this->grfconfig, src.grfconfig, false);
+	this->grf_compatibility = src.grf_compatibility;
+}
+
+/** Number of checked savegames that are remembered. */
+static const uint LOAD_CHECK_CACHE_SIZE = 16;
+
+/** A remembered result of checking a savegame. */
+struct LoadCheckCacheItem {
+	char name[MAX_PATH]; ///< The file of the savegame; empty when the item isn't used.
+	uint64 mtime;        ///< The time the file was last changed when it was checked.
+	LoadCheckData data;  ///< The result of checking it.
+};
+
+static LoadCheckCacheItem _load_check_cache[LOAD_CHECK_CACHE_SIZE]; ///< The remembered results of checking savegames.
+static uint _load_check_cache_next; ///< The item of #_load_check_cache that is replaced next.
+
+/**
+ * Check a savegame into #_load_check_data. When the same file has been
+ * checked before and it hasn't changed since, the earlier result is used.
+ * @param name  The file of the savegame.
+ * @param mtime The time the file was last changed, or 0 if unknown.
+ */
+static void LoadCheckSavegame(const char *name, uint64 mtime)
+{
+	if (mtime != 0) {
+		for (uint i = 0; i < LOAD_CHECK_CACHE_SIZE; i++) {
+			const LoadCheckCacheItem *item = &_load_check_cache[i];
+			if (item->mtime == mtime && strcmp(item->name, name) == 0) {
+				_load_check_data.CopyFrom(item->data);
+				return;
+			}
+		}
+	}
+
+	SaveOrLoad(name, SL_LOAD_CHECK, NO_DIRECTORY, false);
+	if (mtime == 0) return;
+
+	LoadCheckCacheItem *item = &_load_check_cache[_load_check_cache_next];
+	_load_check_cache_next = (_load_check_cache_next + 1) % LOAD_CHECK_CACHE_SIZE;
+	strecpy(item->name, name, lastof(item->name));
+	item->mtime = mtime;
+	item->data.CopyFrom(_load_check_data);
+}
+
 
 enum SaveLoadWindowWidgets {
 	SLWW_WINDOWTITLE,
@@ -197,7 +269,11 @@ const TextColour _fios_colours[] = {
 	TC_ORANGE,     TC_LIGHT_BROWN, TC_ORANGE,     TC_ORANGE, TC_YELLOW
 };
 
-void BuildFileList()
+/**
+ * Build the list of files of the current save/load mode.
+ * @param incremental Whether the list may be built a bit at a time; see #FiosContinueFileList.
+ */
+void BuildFileList(bool incremental)
 {
 	_fios_path_changed = true;
 	FiosFreeSavegameList();
@@ -206,11 +282,11 @@ void BuildFileList()
 		case SLD_NEW_GAME:
 		case SLD_LOAD_SCENARIO:
 		case SLD_SAVE_SCENARIO:
-			FiosGetScenarioList(_saveload_mode); break;
+			FiosGetScenarioList(_saveload_mode, incremental); break;
 		case SLD_LOAD_HEIGHTMAP:
-			FiosGetHeightmapList(_saveload_mode); break;
+			FiosGetHeightmapList(_saveload_mode, incremental); break;
 
-		default: FiosGetSavegameList(_saveload_mode); break;
+		default: FiosGetSavegameList(_saveload_mode, incremental); break;
 	}
 }
 
@@ -545,7 +621,7 @@ public:
 							_load_check_data.Clear();
 
 							if (file->type == FIOS_TYPE_FILE || file->type == FIOS_TYPE_SCENARIO) {
-								SaveOrLoad(name, SL_LOAD_CHECK, NO_DIRECTORY, false);
+								LoadCheckSavegame(name, file->mtime);
 							}
 
 							this->InvalidateData(1);
@@ -602,6 +678,29 @@ public:
 		}
 	}
 
+	virtual void OnTick()
+	{
+		/* Keep the selection by name, as the items move when the list grows. */
+		FiosItem selected;
+		if (this->selected != NULL) selected = *this->selected;
+
+		if (!FiosContinueFileList()) return;
+
+		if (this->selected != NULL) {
+			this->selected = NULL;
+			for (const FiosItem *item = _fios_items.Begin(); item != _fios_items.End(); item++) {
+				if (item->type == selected.type && strcmp(item->name, selected.name) == 0) {
+					this->selected = item;
+					break;
+				}
+			}
+			if (this->selected == NULL) _load_check_data.Clear();
+		}
+
+		this->InvalidateData(1);
+		this->SetDirty();
+	}
+
 	virtual EventState OnKeyPress(uint16 key, uint16 keycode)
 	{
 		if (keycode == WKC_ESC) {
@@ -655,7 +754,7 @@ public:
 				/* Rescan files */
 				this->selected = NULL;
 				_load_check_data.Clear();
-				BuildFileList();
+				BuildFileList(true);
 			/* FALL THROUGH */
 			case 1:
 				/* Selection changes */
@@ -887,6 +887,7 @@ struct GlyphEntry {
  * This can be simply changed in the two functions Get & SetGlyphPtr.
  */
 static GlyphEntry **_glyph_ptr[FS_END];
+static size_t _glyph_memory = 0; ///< The number of bytes allocated for the sprites and tables of the glyph cache.
 
 /** Clear the complete cache */
 static void ResetGlyphCache()
@@ -907,6 +908,16 @@ static void ResetGlyphCache()
 		free(_glyph_ptr[i]);
 		_glyph_ptr[i] = NULL;
 	}
+	_glyph_memory = 0;
+}
+
+/**
+ * Get the memory used by the glyph cache.
+ * @return the number of bytes allocated for the rendered glyphs and the tables that refer to them
+ */
+size_t GetGlyphCacheMemoryUsage()
+{
+	return _glyph_memory;
 }
 
 static GlyphEntry *GetGlyphPtr(FontSize size, WChar key)
@@ -922,11 +933,13 @@ static void SetGlyphPtr(FontSize size, WChar key, const GlyphEntry *glyph)
 	if (_glyph_ptr[size] == NULL) {
 		DEBUG(freetype, 3, "Allocating root glyph cache for size %u", size);
 		_glyph_ptr[size] = CallocT<GlyphEntry*>(256);
+		_glyph_memory += 256 * sizeof(GlyphEntry*);
 	}
 
 	if (_glyph_ptr[size][GB(key, 8, 8)] == NULL) {
 		DEBUG(freetype, 3, "Allocating glyph cache for range 0x%02X00, size %u", GB(key, 8, 8), size);
 		_glyph_ptr[size][GB(key, 8, 8)] = CallocT<GlyphEntry>(256);
+		_glyph_memory += 256 * sizeof(GlyphEntry);
 	}
 
 	DEBUG(freetype, 4, "Set glyph for unicode character 0x%04X, size %u", key, size);
@@ -936,6 +949,7 @@ static void SetGlyphPtr(FontSize size, WChar key, const GlyphEntry *glyph)
 
 static void *AllocateFont(size_t size)
 {
+	_glyph_memory += size;
 	return MallocT<byte>(size);
 }
 
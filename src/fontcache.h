@@ -45,6 +45,7 @@ void InitFreeType();
 void UninitFreeType();
 const Sprite *GetGlyph(FontSize size, uint32 key);
 uint GetGlyphWidth(FontSize size, uint32 key);
+size_t GetGlyphCacheMemoryUsage();
 
 /**
  * We would like to have a fallback font as the current one
@@ -63,6 +64,9 @@ bool SetFallbackFont(FreeTypeSettings *settings, const char *language_isocode, i
 static inline void InitFreeType() { ResetFontSizes(); }
 static inline void UninitFreeType() { ResetFontSizes(); }
 
+/** Without FreeType the glyphs are sprites in the sprite cache. */
+static inline size_t GetGlyphCacheMemoryUsage() { return 0; }
+
 /** Get the Sprite for a glyph */
 static inline const Sprite *GetGlyph(FontSize size, uint32 key)
 {
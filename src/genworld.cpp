@@ -25,6 +25,7 @@
 #include "date_func.h"
 #include "engine_func.h"
 #include "newgrf_storage.h"
+#include "newgrf_station.h"
 #include "water.h"
 #include "blitter/factory.hpp"
 #include "tilehighlight_func.h"
@@ -34,6 +35,7 @@
 #include "newgrf.h"
 #include "core/random_func.hpp"
 #include "core/backup_type.hpp"
+#include "pathfinder/pf_performance_timer.hpp"
 
 #include "table/sprites.h"
 
@@ -64,6 +66,53 @@ ThreadMutex *_genworld_paint_mutex = ThreadMutex::New();
 /** Whether we are generating the map or not. */
 bool _generating_world;
 
+/** Time spent in each stage of the world generation. */
+static CPerformanceTimer _genworld_stage_timers[GWP_CLASS_COUNT];
+/** The stage the time is currently measured for, GWP_CLASS_COUNT when none. */
+static GenWorldProgress _genworld_timed_stage = GWP_CLASS_COUNT;
+
+/**
+ * Attribute the time from now on to the given stage of the world generation.
+ * @param cls the stage that is started.
+ */
+void StartGeneratingWorldStageTimer(GenWorldProgress cls)
+{
+	if (cls == _genworld_timed_stage) return;
+
+	if (_genworld_timed_stage != GWP_CLASS_COUNT) _genworld_stage_timers[_genworld_timed_stage].Stop();
+	_genworld_timed_stage = cls;
+	if (cls != GWP_CLASS_COUNT) _genworld_stage_timers[cls].Start();
+}
+
+/**
+ * Print the time spent in each stage of the world generation, one
+ * key=value line per stage.
+ * Shown with -d map=1; together with the null drivers and -G this
+ * can be used to compare the generation speed of different versions.
+ */
+static void PrintGeneratingWorldTimings()
+{
+	static const char * const stage_names[] = {
+		"map_init", "landscape", "rough_rocky", "town", "industry",
+		"unmovable", "tree", "game_init", "runtileloop", "game_start",
+	};
+	assert_compile(lengthof(stage_names) == GWP_CLASS_COUNT);
+
+	StartGeneratingWorldStageTimer(GWP_CLASS_COUNT);
+
+	int total = 0;
+	for (uint i = 0; i < GWP_CLASS_COUNT; i++) {
+		int ms = _genworld_stage_timers[i].Get(1000);
+		total += ms;
+		DEBUG(map, 1, "genworld_timing: seed=%u size=%ux%u generator=%u stage=%s ms=%d",
+				_settings_game.game_creation.generation_seed, MapSizeX(), MapSizeY(),
+				_settings_game.game_creation.land_generator, stage_names[i], ms);
+	}
+	DEBUG(map, 1, "genworld_timing: seed=%u size=%ux%u generator=%u stage=total ms=%d",
+			_settings_game.game_creation.generation_seed, MapSizeX(), MapSizeY(),
+			_settings_game.game_creation.land_generator, total);
+}
+
 /**
  * Tells if the world generation is done in a thread or not.
  * @return the 'threaded' status
@@ -105,6 +154,8 @@ static void _GenerateWorld(void *)
 	try {
 		_generating_world = true;
 		_genworld_mapgen_mutex->BeginCritical();
+		_genworld_timed_stage = GWP_CLASS_COUNT;
+		for (uint i = 0; i < GWP_CLASS_COUNT; i++) _genworld_stage_timers[i] = CPerformanceTimer();
 		if (_network_dedicated) DEBUG(net, 0, "Generating map, please wait...");
 		/* Set the Random() seed to generation_seed so we produce the same map with the same seed */
 		if (_settings_game.game_creation.generation_seed == GENERATE_NEW_SEED) _settings_game.game_creation.generation_seed = _settings_newgame.game_creation.generation_seed = InteractiveRandom();
@@ -149,6 +200,7 @@ static void _GenerateWorld(void *)
 		}
 
 		ClearStorageChanges(true);
+		InvalidateStationRelocationCache();
 
 		/* These are probably pointless when inside the scenario editor. */
 		SetGeneratingWorldProgress(GWP_GAME_INIT, 3);
@@ -163,10 +215,25 @@ static void _GenerateWorld(void *)
 		if (_gw.mode != GWM_EMPTY) {
 			uint i;
 
-			SetGeneratingWorldProgress(GWP_RUNTILELOOP, 0x500);
-			for (i = 0; i < 0x500; i++) {
-				RunTileLoop();
-				IncreaseGeneratingWorldProgress(GWP_RUNTILELOOP);
+			if (_settings_game.game_creation.fast_landscape_settle) {
+				/* Give every tile as many tile loops as the 0x500 calls of
+				 * RunTileLoop below, but walk the map row by row. That is a
+				 * lot faster on big maps, but as the tiles are visited in
+				 * another order it gives another map for the same seed. */
+				const uint passes = 0x500 / 256;
+				SetGeneratingWorldProgress(GWP_RUNTILELOOP, passes * MapSizeY());
+				for (i = 0; i < passes; i++) {
+					for (uint y = 0; y < MapSizeY(); y++) {
+						RunTileLoopOnRow(y);
+						IncreaseGeneratingWorldProgress(GWP_RUNTILELOOP);
+					}
+				}
+			} else {
+				SetGeneratingWorldProgress(GWP_RUNTILELOOP, 0x500);
+				for (i = 0; i < 0x500; i++) {
+					RunTileLoop();
+					IncreaseGeneratingWorldProgress(GWP_RUNTILELOOP);
+				}
 			}
 		}
 
@@ -180,6 +247,7 @@ static void _GenerateWorld(void *)
 		IncreaseGeneratingWorldProgress(GWP_GAME_START);
 
 		CleanupGeneration();
+		PrintGeneratingWorldTimings();
 
 		ShowNewGRFError();
 
@@ -193,6 +261,7 @@ static void _GenerateWorld(void *)
 		}
 	} catch (...) {
 		if (_cur_company.IsValid()) _cur_company.Restore();
+		StartGeneratingWorldStageTimer(GWP_CLASS_COUNT);
 		_generating_world = false;
 		_genworld_mapgen_mutex->EndCritical();
 		throw;
@@ -283,6 +352,17 @@ void HandleGeneratingWorldAbortion()
 void GenerateWorld(GenWorldMode mode, uint size_x, uint size_y, bool reset_settings)
 {
 	if (_gw.active) return;
+
+	/* The sizes are only limited per axis by the settings, so shrink the
+	 * longest axis till the map does not have too many tiles. */
+	while (size_x * size_y > MAX_MAP_TILES) {
+		if (size_x > size_y) {
+			size_x /= 2;
+		} else {
+			size_y /= 2;
+		}
+	}
+
 	_gw.mode   = mode;
 	_gw.size_x = size_x;
 	_gw.size_y = size_y;
@@ -85,6 +85,7 @@ void GenerateWorld(GenWorldMode mode, uint size_x, uint size_y, bool reset_setti
 void AbortGeneratingWorld();
 bool IsGeneratingWorldAborted();
 void HandleGeneratingWorldAbortion();
+void StartGeneratingWorldStageTimer(GenWorldProgress cls);
 
 /* genworld_gui.cpp */
 void SetNewLandscapeType(byte landscape);
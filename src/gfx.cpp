@@ -23,7 +23,10 @@
 #include "network/network_func.h"
 #include "thread/thread.h"
 #include "window_func.h"
+#include "viewport_func.h"
+#include "vehicle_func.h"
 #include "newgrf_debug.h"
+#include "timeline.h"
 
 #include "table/palettes.h"
 #include "table/sprites.h"
@@ -108,6 +111,8 @@ static byte _string_colourremap[3]; ///< Recoloursprite for stringdrawing. The g
 
 static const uint DIRTY_BLOCK_HEIGHT   = 8;
 static const uint DIRTY_BLOCK_WIDTH    = 64;
+static const uint DIRTY_TILE_HEIGHT    = 8; ///< Height of the screen tiles the dirty blocks are grouped in, in dirty blocks.
+static const uint DIRTY_TILE_WIDTH     = 4; ///< Width of the screen tiles the dirty blocks are grouped in, in dirty blocks.
 
 static uint _dirty_bytes_per_line = 0;
 static byte *_dirty_blocks = NULL;
@@ -124,9 +129,11 @@ void GfxScroll(int left, int top, int width, int height, int xo, int yo)
 	if (_networking) NetworkUndrawChatMessage();
 #endif /* ENABLE_NETWORK */
 
+	/* When the video driver can move what is shown itself, only the uncovered
+	 * parts have to be copied to the screen; else all of it is dirty now. */
+	bool scrolled = _video_driver->ScrollScreen(left, top, width, height, xo, yo);
 	blitter->ScrollBuffer(_screen.dst_ptr, left, top, width, height, xo, yo);
-	/* This part of the screen is now dirty. */
-	_video_driver->MakeDirty(left, top, width, height);
+	if (!scrolled) _video_driver->MakeDirty(left, top, width, height);
 }
 
 
@@ -418,6 +425,87 @@ static int TruncateString(char *str, int maxw, bool ignore_setxy, FontSize start
 
 static int ReallyDoDrawString(const UChar *string, int x, int y, DrawStringParams &params, bool parse_string_also_when_clipped = false);
 
+/** The measurement of a string, as kept in the cache so drawing the same string again needn't measure it again. */
+struct StringMeasurement {
+	char *str;          ///< The string, or NULL when this entry is unused.
+	uint32 hash;        ///< The hash of the string and the font size.
+	FontSize fontsize;  ///< The font size the string starts with.
+	Dimension box;      ///< The bounding box of the string.
+	bool plain;         ///< Whether the string has no SETX(Y) and no newlines, so its width is the sum of the widths of its characters.
+};
+
+static const uint STRING_MEASUREMENT_CACHE_SIZE = 1024; ///< The number of strings in the cache; a power of two.
+static StringMeasurement _string_measurements[STRING_MEASUREMENT_CACHE_SIZE]; ///< The cache of measured strings.
+
+/** Forget all measured strings, e.g. because the fonts changed. */
+static void ClearStringMeasurements()
+{
+	for (uint i = 0; i < lengthof(_string_measurements); i++) {
+		free(_string_measurements[i].str);
+		_string_measurements[i].str = NULL;
+	}
+}
+
+/**
+ * Measure a string, or get the measurement from the cache.
+ * @param str the string
+ * @param start_fontsize the font size to start the text with
+ * @return the measurement; valid until the next string is measured
+ */
+static const StringMeasurement *MeasureString(const char *str, FontSize start_fontsize)
+{
+	uint32 hash = 2166136261U ^ start_fontsize;
+	for (const char *s = str; *s != '\0'; s++) hash = (hash ^ (byte)*s) * 16777619U;
+
+	StringMeasurement *m = &_string_measurements[hash & (STRING_MEASUREMENT_CACHE_SIZE - 1)];
+	if (m->str != NULL && m->hash == hash && m->fontsize == start_fontsize && strcmp(m->str, str) == 0) return m;
+
+	free(m->str);
+	m->str = strdup(str);
+	m->hash = hash;
+	m->fontsize = start_fontsize;
+	m->plain = true;
+
+	FontSize size = start_fontsize;
+	Dimension br;
+	uint max_width;
+	WChar c;
+
+	br.width = br.height = max_width = 0;
+	for (;;) {
+		c = Utf8Consume(&str);
+		if (c == 0) break;
+		if (IsPrintable(c)) {
+			br.width += GetCharacterWidth(size, c);
+		} else {
+			switch (c) {
+				case SCC_SETX:
+					br.width = max((uint)*str++, br.width);
+					m->plain = false;
+					break;
+				case SCC_SETXY:
+					br.width  = max((uint)*str++, br.width);
+					br.height = max((uint)*str++, br.height);
+					m->plain = false;
+					break;
+				case SCC_TINYFONT: size = FS_SMALL; break;
+				case SCC_BIGFONT:  size = FS_LARGE; break;
+				case '\n':
+					br.height += GetCharacterHeight(size);
+					if (br.width > max_width) max_width = br.width;
+					br.width = 0;
+					m->plain = false;
+					break;
+			}
+		}
+	}
+	br.height += GetCharacterHeight(size);
+
+	br.width  = max(br.width, max_width);
+	m->box = br;
+	return m;
+}
+
 /**
  * Get the real width of the string.
  * @param str the string to draw
@@ -484,7 +572,17 @@ static int DrawString(int left, int right, int top, char *str, const char *last,
 	int initial_right = right;
 	int initial_top = top;
 
-	if (truncate) TruncateString(str, right - left + 1, (align & SA_STRIP) == SA_STRIP, params.fontsize);
+	/* The width of the string, when it is known without measuring it again. */
+	int known_width = -1;
+	if (truncate) {
+		/* A plain string that fits needs no truncating; most strings are drawn many times without changing. */
+		const StringMeasurement *m = MeasureString(str, params.fontsize);
+		if (m->plain && (int)m->box.width <= right - left + 1) {
+			known_width = m->box.width;
+		} else {
+			TruncateString(str, right - left + 1, (align & SA_STRIP) == SA_STRIP, params.fontsize);
+		}
+	}
 
 	/*
 	 * To support SETX and SETXY properly with RTL languages we have to
@@ -567,7 +665,12 @@ static int DrawString(int left, int right, int top, char *str, const char *last,
 		}
 
 		to_draw = HandleBiDiAndArabicShapes(to_draw);
+#if defined(WITH_ICU)
+		/* Shaping changes the characters, and so the width. */
 		int w = GetStringWidth(to_draw, params.fontsize);
+#else
+		int w = (known_width >= 0 && setx_offsets.Length() == 1) ? known_width : GetStringWidth(to_draw, params.fontsize);
+#endif /* WITH_ICU */
 
 		/* right is the right most position to draw on. In this case we want to do
 		 * calculations with the width of the string. In comparison right can be
@@ -926,38 +1029,7 @@ int DrawStringMultiLine(int left, int right, int top, int bottom, StringID str,
  * @return string width and height in pixels */
 Dimension GetStringBoundingBox(const char *str, FontSize start_fontsize)
 {
-	FontSize size = start_fontsize;
-	Dimension br;
-	uint max_width;
-	WChar c;
-
-	br.width = br.height = max_width = 0;
-	for (;;) {
-		c = Utf8Consume(&str);
-		if (c == 0) break;
-		if (IsPrintable(c)) {
-			br.width += GetCharacterWidth(size, c);
-		} else {
-			switch (c) {
-				case SCC_SETX: br.width = max((uint)*str++, br.width); break;
-				case SCC_SETXY:
-					br.width  = max((uint)*str++, br.width);
-					br.height = max((uint)*str++, br.height);
-					break;
-				case SCC_TINYFONT: size = FS_SMALL; break;
-				case SCC_BIGFONT:  size = FS_LARGE; break;
-				case '\n':
-					br.height += GetCharacterHeight(size);
-					if (br.width > max_width) max_width = br.width;
-					br.width = 0;
-					break;
-			}
-		}
-	}
-	br.height += GetCharacterHeight(size);
-
-	br.width  = max(br.width, max_width);
-	return br;
+	return MeasureString(str, start_fontsize)->box;
 }
 
 /**
@@ -1357,6 +1429,9 @@ void LoadStringWidthTable()
 	_max_char_height = 0;
 	_max_char_width  = 0;
 
+	/* The widths of the characters may have changed, so the strings have to be measured again. */
+	ClearStringMeasurements();
+
 	for (FontSize fs = FS_BEGIN; fs < FS_END; fs++) {
 		_max_char_height = max<int>(_max_char_height, GetCharacterHeight(fs));
 		for (uint i = 0; i != 224; i++) {
@@ -1515,8 +1590,74 @@ void RedrawScreenRect(int left, int top, int right, int bottom)
  *
  * @see SetDirtyBlocks
  */
+/**
+ * Redraw a part of the screen, as far as it is invalid.
+ * @param left   the left of the area
+ * @param top    the top of the area
+ * @param right  the right of the area
+ * @param bottom the bottom of the area
+ */
+static void RedrawDirtyRect(int left, int top, int right, int bottom)
+{
+	if (left   < _invalid_rect.left  ) left   = _invalid_rect.left;
+	if (top    < _invalid_rect.top   ) top    = _invalid_rect.top;
+	if (right  > _invalid_rect.right ) right  = _invalid_rect.right;
+	if (bottom > _invalid_rect.bottom) bottom = _invalid_rect.bottom;
+
+	if (left < right && top < bottom) {
+		RedrawScreenRect(left, top, right, bottom);
+	}
+}
+
+/**
+ * Redraw the screen tiles that are partly dirty, but with their dirty blocks
+ * close together, as one rectangle each. Vehicles that move around leave
+ * many small, scattered dirty areas; each of which, when drawn by itself,
+ * costs as much as looking through the windows and collecting the sprites
+ * of the viewport again. Tiles that are dirty all over are left to the
+ * coalescing of DrawDirtyBlocks, which can combine them with their neighbours.
+ * @param cols the number of dirty blocks on a line of the screen
+ * @param rows the number of lines of dirty blocks
+ */
+static void DrawDirtyTiles(uint cols, uint rows)
+{
+	for (uint ty = 0; ty < rows; ty += DIRTY_TILE_HEIGHT) {
+		for (uint tx = 0; tx < cols; tx += DIRTY_TILE_WIDTH) {
+			uint tx_end = min(tx + DIRTY_TILE_WIDTH, cols);
+			uint ty_end = min(ty + DIRTY_TILE_HEIGHT, rows);
+
+			/* Find the dirty blocks of the tile and what they span. */
+			uint count = 0;
+			uint left = tx_end, top = ty_end, right = tx, bottom = ty;
+			for (uint y = ty; y < ty_end; y++) {
+				const byte *b = _dirty_blocks + y * _dirty_bytes_per_line;
+				for (uint x = tx; x < tx_end; x++) {
+					if (b[x] == 0) continue;
+					count++;
+					left   = min(left, x);
+					right  = max(right, x + 1);
+					top    = min(top, y);
+					bottom = max(bottom, y + 1);
+				}
+			}
+
+			if (count == 0 || count == (tx_end - tx) * (ty_end - ty)) continue;
+
+			/* Don't redraw more than twice the area that is actually dirty. */
+			if (count * 2 < (right - left) * (bottom - top)) continue;
+
+			for (uint y = top; y < bottom; y++) {
+				memset(_dirty_blocks + y * _dirty_bytes_per_line + left, 0, right - left);
+			}
+			RedrawDirtyRect(left * DIRTY_BLOCK_WIDTH, top * DIRTY_BLOCK_HEIGHT, right * DIRTY_BLOCK_WIDTH, bottom * DIRTY_BLOCK_HEIGHT);
+		}
+	}
+}
+
 void DrawDirtyBlocks()
 {
+	TIMELINE_ZONE("draw dirty blocks");
+
 	byte *b = _dirty_blocks;
 	const int w = Align(_screen.width,  DIRTY_BLOCK_WIDTH);
 	const int h = Align(_screen.height, DIRTY_BLOCK_HEIGHT);
@@ -1536,13 +1677,15 @@ void DrawDirtyBlocks()
 		_genworld_mapgen_mutex->BeginCritical();
 	}
 
+	FlushDirtyTileAreas();
+	FlushVehicleDirtyAreas();
+	DrawDirtyTiles(w / DIRTY_BLOCK_WIDTH, h / DIRTY_BLOCK_HEIGHT);
+
 	y = 0;
 	do {
 		x = 0;
 		do {
 			if (*b != 0) {
-				int left;
-				int top;
 				int right = x + DIRTY_BLOCK_WIDTH;
 				int bottom = y;
 				byte *p = b;
@@ -1582,18 +1725,7 @@ void DrawDirtyBlocks()
 				}
 				no_more_coalesc:
 
-				left = x;
-				top = y;
-
-				if (left   < _invalid_rect.left  ) left   = _invalid_rect.left;
-				if (top    < _invalid_rect.top   ) top    = _invalid_rect.top;
-				if (right  > _invalid_rect.right ) right  = _invalid_rect.right;
-				if (bottom > _invalid_rect.bottom) bottom = _invalid_rect.bottom;
-
-				if (left < right && top < bottom) {
-					RedrawScreenRect(left, top, right, bottom);
-				}
-
+				RedrawDirtyRect(x, y, right, bottom);
 			}
 		} while (b++, (x += DIRTY_BLOCK_WIDTH) != w);
 	} while (b += -(int)(w / DIRTY_BLOCK_WIDTH) + _dirty_bytes_per_line, (y += DIRTY_BLOCK_HEIGHT) != h);
@@ -1604,6 +1736,19 @@ void DrawDirtyBlocks()
 	_invalid_rect.bottom = 0;
 }
 
+/**
+ * Get the time between two draws of the screen, for drivers that draw
+ * independent of the ticks of the game.
+ * @return The time in milliseconds.
+ */
+uint GetDrawInterval()
+{
+	uint interval = 1000 / max<uint>(_settings_client.gui.refresh_rate, 1);
+	/* Drawing every tick would take most of the time of fast forwarding. */
+	if (_fast_forward && !_pause_mode) interval = max(interval, FAST_FORWARD_DRAW_INTERVAL);
+	return interval;
+}
+
 /*!
  * This function extends the internal _invalid_rect rectangle as it
  * now contains the rectangle defined by the given parameters. Note
@@ -1663,6 +1808,7 @@ void SetDirtyBlocks(int left, int top, int right, int bottom)
  */
 void MarkWholeScreenDirty()
 {
+	ResetTileDrawCache();
 	SetDirtyBlocks(0, 0, _screen.width, _screen.height);
 }
 
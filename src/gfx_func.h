@@ -76,6 +76,14 @@ void HandleCtrlChanged();
 void HandleMouseEvents();
 void CSleep(int milliseconds);
 void UpdateWindows();
+void TickWindows();
+void DrawWindows();
+uint GetDrawInterval();
+
+/** The number of draws that may be skipped in a row when the ticks of the game take too long. */
+static const uint MAX_SKIPPED_DRAWS = 4;
+/** The minimum time between two draws while fast forwarding, in milliseconds. */
+static const uint FAST_FORWARD_DRAW_INTERVAL = 40;
 
 void DrawMouseCursor();
 void ScreenSizeChanged();
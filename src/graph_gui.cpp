@@ -89,11 +89,7 @@ struct GraphLegendWindow : Window {
 		ToggleBit(_legend_excluded_companies, widget - GLW_FIRST_COMPANY);
 		this->ToggleWidgetLoweredState(widget);
 		this->SetDirty();
-		InvalidateWindowData(WC_INCOME_GRAPH, 0);
-		InvalidateWindowData(WC_OPERATING_PROFIT, 0);
-		InvalidateWindowData(WC_DELIVERED_CARGO, 0);
-		InvalidateWindowData(WC_PERFORMANCE_HISTORY, 0);
-		InvalidateWindowData(WC_COMPANY_VALUE, 0);
+		InvalidateCompanyGraphs();
 	}
 
 	virtual void OnInvalidateData(int data)
@@ -202,6 +198,29 @@ protected:
 	StringID format_str_y_axis;
 	byte colours[GRAPH_MAX_DATASETS];
 	OverflowSafeInt64 cost[GRAPH_MAX_DATASETS][GRAPH_NUM_MONTHS]; ///< Stored costs for the last #GRAPH_NUM_MONTHS months
+	ValuesInterval dataset_interval[GRAPH_MAX_DATASETS];          ///< Highest and lowest value of each dataset, see #UpdateDatasetIntervals.
+
+	/**
+	 * Determine the highest and lowest value of each dataset, so painting the graph
+	 * does not need to go through all data points. Call this whenever #cost changed.
+	 */
+	void UpdateDatasetIntervals()
+	{
+		for (int i = 0; i < this->num_dataset; i++) {
+			ValuesInterval &interval = this->dataset_interval[i];
+			interval.highest = INT64_MIN;
+			interval.lowest  = INT64_MAX;
+
+			for (int j = 0; j < this->num_on_x_axis; j++) {
+				OverflowSafeInt64 datapoint = this->cost[i][j];
+
+				if (datapoint != INVALID_DATAPOINT) {
+					interval.highest = max(interval.highest, datapoint);
+					interval.lowest  = min(interval.lowest, datapoint);
+				}
+			}
+		}
+	}
 
 	/**
 	 * Get the interval that contains the graph's data. Excluded data is ignored to show smaller values in
@@ -217,14 +236,8 @@ protected:
 
 		for (int i = 0; i < this->num_dataset; i++) {
 			if (HasBit(this->excluded_data, i)) continue;
-			for (int j = 0; j < this->num_on_x_axis; j++) {
-				OverflowSafeInt64 datapoint = this->cost[i][j];
-
-				if (datapoint != INVALID_DATAPOINT) {
-					current_interval.highest = max(current_interval.highest, datapoint);
-					current_interval.lowest  = min(current_interval.lowest, datapoint);
-				}
-			}
+			current_interval.highest = max(current_interval.highest, this->dataset_interval[i].highest);
+			current_interval.lowest  = min(current_interval.lowest, this->dataset_interval[i].lowest);
 		}
 
 		/* Prevent showing values too close to the graph limits. */
@@ -548,11 +561,10 @@ public:
 		if (widget == BGW_KEY_BUTTON) ShowGraphLegend();
 	}
 
-	virtual void OnTick()
-	{
-		this->UpdateStatistics(false);
-	}
-
+	/**
+	 * The statistics only change when a month has passed or the set of companies has changed;
+	 * both are signalled through #InvalidateCompanyGraphs instead of being polled every tick.
+	 */
 	virtual void OnInvalidateData(int data)
 	{
 		this->UpdateStatistics(true);
@@ -609,6 +621,7 @@ public:
 		}
 
 		this->num_dataset = numd;
+		this->UpdateDatasetIntervals();
 	}
 };
 
@@ -872,6 +885,20 @@ void ShowCompanyValueGraph()
 	AllocateWindowDescFront<CompanyValueGraphWindow>(&_company_value_graph_desc, 0);
 }
 
+/**
+ * Invalidate the data of the graphs with per company statistics, so they
+ * recompute them. Call this when a month passed or companies were added,
+ * removed, recoloured or hidden from the graphs.
+ */
+void InvalidateCompanyGraphs()
+{
+	InvalidateWindowData(WC_INCOME_GRAPH, 0);
+	InvalidateWindowData(WC_OPERATING_PROFIT, 0);
+	InvalidateWindowData(WC_DELIVERED_CARGO, 0);
+	InvalidateWindowData(WC_PERFORMANCE_HISTORY, 0);
+	InvalidateWindowData(WC_COMPANY_VALUE, 0);
+}
+
 /*****************/
 /* PAYMENT RATES */
 /*****************/
@@ -901,7 +928,7 @@ struct PaymentRatesGraphWindow : BaseGraphWindow {
 		this->x_values_increment = 10;
 
 		/* Initialise the dataset */
-		this->OnHundredthTick();
+		this->UpdatePaymentRates();
 
 		this->InitNested(desc, window_number);
 
@@ -914,7 +941,7 @@ struct PaymentRatesGraphWindow : BaseGraphWindow {
 		 * InitNested is done. On the first init these functions are called in the correct order by the constructor. */
 		if (!this->first_init) {
 			/* Initialise the dataset */
-			this->OnHundredthTick();
+			this->UpdatePaymentRates();
 			this->UpdateLoweredWidgets();
 		}
 		this->first_init = false;
@@ -1017,17 +1044,14 @@ struct PaymentRatesGraphWindow : BaseGraphWindow {
 		}
 	}
 
-	virtual void OnTick()
-	{
-		/* Override default OnTick */
-	}
-
+	/** The payment rates change with inflation, which invalidates this window. */
 	virtual void OnInvalidateData(int data)
 	{
-		this->OnHundredthTick();
+		this->UpdatePaymentRates();
 	}
 
-	virtual void OnHundredthTick()
+	/** Compute the payment rates of the shown cargoes. */
+	void UpdatePaymentRates()
 	{
 		this->UpdateExcludedData();
 
@@ -1041,6 +1065,7 @@ struct PaymentRatesGraphWindow : BaseGraphWindow {
 			i++;
 		}
 		this->num_dataset = i;
+		this->UpdateDatasetIntervals();
 	}
 };
 
@@ -1317,9 +1342,12 @@ struct PerformanceRatingDetailWindow : Window {
 	{
 		/* Update all company stats with the current data
 		 * (this is because _score_info is not saved to a savegame) */
+		CompanyAssetStats stats[MAX_COMPANIES];
+		GetCompanyAssetStats(stats);
+
 		Company *c;
 		FOR_ALL_COMPANIES(c) {
-			UpdateCompanyRatingAndValue(c, false);
+			UpdateCompanyRatingAndValue(c, false, &stats[c->index]);
 		}
 
 		this->timeout = DAY_TICKS * 5;
@@ -21,4 +21,6 @@ void ShowCargoPaymentRates();
 void ShowCompanyLeagueTable();
 void ShowPerformanceRatingDetail();
 
+void InvalidateCompanyGraphs();
+
 #endif /* GRAPH_GUI_H */
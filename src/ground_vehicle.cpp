@@ -24,6 +24,17 @@ template <class T, VehicleType Type>
 void GroundVehicle<T, Type>::PowerChanged()
 {
 	assert(this->First() == this);
+	T::From(this)->UpdatePartProperties();
+	this->UpdatePower();
+}
+
+/**
+ * Recalculates the cached total power from the properties of the parts.
+ * @pre The properties of the parts are up to date.
+ */
+template <class T, VehicleType Type>
+void GroundVehicle<T, Type>::UpdatePower()
+{
 	const T *v = T::From(this);
 
 	uint32 total_power = 0;
@@ -73,6 +84,9 @@ void GroundVehicle<T, Type>::CargoChanged()
 	assert(this->First() == this);
 	uint32 weight = 0;
 
+	/* The callbacks of every part are called once, not again for the power. */
+	T::From(this)->UpdatePartProperties();
+
 	for (T *u = T::From(this); u != NULL; u = u->Next()) {
 		uint32 current_weight = u->GetWeight();
 		weight += current_weight;
@@ -83,7 +97,7 @@ void GroundVehicle<T, Type>::CargoChanged()
 	this->acc_cache.cached_weight = max<uint32>(1, weight);
 
 	/* Now update vehicle power (tractive effort is dependent on weight). */
-	this->PowerChanged();
+	this->UpdatePower();
 }
 
 /**
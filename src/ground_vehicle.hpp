@@ -75,6 +75,7 @@ struct GroundVehicle : public SpecializedVehicle<T, Type> {
 
 	void PowerChanged();
 	void CargoChanged();
+	void UpdatePower();
 	int GetAcceleration() const;
 
 	/**
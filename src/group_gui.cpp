@@ -246,7 +246,9 @@ public:
 
 	virtual void OnInvalidateData(int data)
 	{
-		if (data == 0) {
+		if (HasBit(data, VLI_VEHICLE_CHANGED) || HasBit(data, VLI_VEHICLE_REMOVED)) {
+			this->UpdateVehicleInList(GB(data, 16, 16), HasBit(data, VLI_VEHICLE_REMOVED), this->owner, this->group_sel, IsAllGroupID(this->group_sel) ? VLW_STANDARD : VLW_GROUP_LIST);
+		} else if (data == 0) {
 			this->vehicles.ForceRebuild();
 			this->groups.ForceRebuild();
 		} else {
@@ -655,14 +657,14 @@ public:
 static WindowDesc _other_group_desc(
 	WDP_AUTO, 460, 246,
 	WC_INVALID, WC_NONE,
-	WDF_UNCLICK_BUTTONS,
+	WDF_UNCLICK_BUTTONS | WDF_IMMEDIATE_INVALIDATE,
 	_nested_group_widgets, lengthof(_nested_group_widgets)
 );
 
 static const WindowDesc _train_group_desc(
 	WDP_AUTO, 525, 246,
 	WC_TRAINS_LIST, WC_NONE,
-	WDF_UNCLICK_BUTTONS,
+	WDF_UNCLICK_BUTTONS | WDF_IMMEDIATE_INVALIDATE,
 	_nested_group_widgets, lengthof(_nested_group_widgets)
 );
 
@@ -34,19 +34,151 @@ static inline byte RGBToGrayscale(byte red, byte green, byte blue)
 	return ((red * 19595) + (green * 38470) + (blue * 7471)) / 65536;
 }
 
+/**
+ * Scales the rows of a heightmap image onto the map while they are read, so
+ * the image never has to be in memory as a whole. Every tile gets the height
+ * of the nearest pixel; rows of the image that no tile uses are skipped.
+ */
+class HeightmapScaler {
+	/** Defines the detail of the aspect ratio (to avoid doubles) */
+	static const uint NUM_DIV = 16384;
+
+	bool clockwise;  ///< Whether the image is rotated clockwise onto the map.
+	uint img_scale;  ///< Size of a pixel in tiles, in 1 / #NUM_DIV.
+	uint row_pad;    ///< Number of rows of tiles above the image.
+	uint row_begin;  ///< First row of tiles that gets its height from the image.
+	uint row_end;    ///< One past the last row of tiles that gets its height from the image.
+	uint col_begin;  ///< First column of tiles that gets its height from the image.
+	uint col_end;    ///< One past the last column of tiles that gets its height from the image.
+	uint *img_cols;  ///< Column of the image for each column of tiles.
+
+	/**
+	 * Get the tile at a row and column of the image, as rotated onto the map.
+	 * @param col The column.
+	 * @param row The row.
+	 * @return The tile.
+	 */
+	FORCEINLINE TileIndex GetTile(uint col, uint row) const
+	{
+		return this->clockwise ? TileXY(row, col) : TileXY(col, row);
+	}
+
+public:
+	HeightmapScaler(uint img_width, uint img_height);
+
+	~HeightmapScaler()
+	{
+		free(this->img_cols);
+	}
+
+	void ScaleRow(uint img_row, const byte *row);
+};
+
+/**
+ * Prepare scaling an image onto the map. All tiles are made clear and flat,
+ * except for the void edges, so only the tiles the image covers are written
+ * when the rows are read.
+ * @param img_width  the width of the image in pixels
+ * @param img_height the height of the image in pixels
+ */
+HeightmapScaler::HeightmapScaler(uint img_width, uint img_height)
+{
+	uint width, height;
+	uint col_pad = 0;
+
+	/* Get map size and calculate scale and padding values */
+	switch (_settings_game.game_creation.heightmap_rotation) {
+		default: NOT_REACHED();
+		case HM_COUNTER_CLOCKWISE:
+			this->clockwise = false;
+			width   = MapSizeX();
+			height  = MapSizeY();
+			break;
+		case HM_CLOCKWISE:
+			this->clockwise = true;
+			width   = MapSizeY();
+			height  = MapSizeX();
+			break;
+	}
+
+	this->row_pad = 0;
+	if ((img_width * NUM_DIV) / img_height > ((width * NUM_DIV) / height)) {
+		/* Image is wider than map - center vertically */
+		this->img_scale = (width * NUM_DIV) / img_width;
+		this->row_pad = (1 + height - ((img_height * this->img_scale) / NUM_DIV)) / 2;
+	} else {
+		/* Image is taller than map - center horizontally */
+		this->img_scale = (height * NUM_DIV) / img_height;
+		col_pad = (1 + width - ((img_width * this->img_scale) / NUM_DIV)) / 2;
+	}
+
+	/* Tiles within the padding regions, and without freeform edges also
+	 * those within the 1-pixel map edge, stay at height 0. */
+	bool freeform = _settings_game.construction.freeform_edges;
+	this->row_begin = max(this->row_pad, freeform ? 0U : 2U);
+	this->row_end   = min(height - this->row_pad - (freeform ? 0 : 1), height - (freeform ? 0 : 2));
+	this->col_begin = max(col_pad, freeform ? 0U : 2U);
+	this->col_end   = min(width - col_pad - (freeform ? 0 : 1), width - (freeform ? 0 : 2));
+
+	/* Use nearest neighbor resizing to scale map data.
+	 *  We rotate the map 45 degrees (counter)clockwise */
+	this->img_cols = MallocT<uint>(width);
+	for (uint col = this->col_begin; col < this->col_end; col++) {
+		this->img_cols[col] = (((this->clockwise ? col - col_pad : width - 1 - col - col_pad) * NUM_DIV) / this->img_scale);
+		assert(this->img_cols[col] < img_width);
+	}
+
+	if (freeform) {
+		for (uint x = 0; x < MapSizeX(); x++) MakeVoid(TileXY(x, 0));
+		for (uint y = 0; y < MapSizeY(); y++) MakeVoid(TileXY(0, y));
+	}
+
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		SetTileHeight(tile, 0);
+		/* Only clear the tiles within the map area. */
+		if (TileX(tile) != MapMaxX() && TileY(tile) != MapMaxY() &&
+				(!freeform || (TileX(tile) != 0 && TileY(tile) != 0))) {
+			MakeClear(tile, CLEAR_GRASS, 3);
+		}
+	}
+}
+
+/**
+ * Give the tiles nearest to a row of the image its heights.
+ * @param img_row the index of the row in the image
+ * @param row     the grayscale pixels of the row
+ */
+void HeightmapScaler::ScaleRow(uint img_row, const byte *row)
+{
+	/* The rows of tiles whose nearest row of the image is this one. */
+	uint first = max(this->row_begin, this->row_pad + CeilDiv(img_row * this->img_scale, NUM_DIV));
+	uint last  = min(this->row_end,   this->row_pad + CeilDiv((img_row + 1) * this->img_scale, NUM_DIV));
+
+	for (uint r = first; r < last; r++) {
+		for (uint c = this->col_begin; c < this->col_end; c++) {
+			/* Colour scales from 0 to 255, OpenTTD height scales from 0 to 15 */
+			SetTileHeight(this->GetTile(c, r), row[this->img_cols[c]] / 16);
+		}
+	}
+}
+
 
 #ifdef WITH_PNG
 
 #include <png.h>
 
 /**
- * The PNG Heightmap loader.
+ * The PNG Heightmap loader. The image is read and scaled onto the map a row
+ * at a time, so except for interlaced images it is never in memory as a whole.
+ * @param scaler   the scaler to pass the grayscale rows to
+ * @param png_ptr  the PNG being read
+ * @param info_ptr the information about the PNG
+ * @param rows     where to keep the memory for the rows, for the caller to free
  */
-static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop info_ptr)
+static void ReadHeightmapPNGImageData(HeightmapScaler *scaler, png_structp png_ptr, png_infop info_ptr, png_bytep volatile *rows)
 {
 	uint x, y;
 	byte gray_palette[256];
-	png_bytep *row_pointers = NULL;
 
 	/* Get palette and convert it to grayscale */
 	if (png_get_color_type(png_ptr, info_ptr) == PNG_COLOR_TYPE_PALETTE) {
@@ -74,32 +206,55 @@ static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop
 		}
 	}
 
-	row_pointers = png_get_rows(png_ptr, info_ptr);
+	uint width = png_get_image_width(png_ptr, info_ptr);
+	uint height = png_get_image_height(png_ptr, info_ptr);
+	uint channels = png_get_channels(png_ptr, info_ptr);
+	bool palette = png_get_color_type(png_ptr, info_ptr) == PNG_COLOR_TYPE_PALETTE;
+
+	/* The passes of an interlaced image each fill in parts of all rows, so those need all rows at once.
+	 * The grayscale row follows the rows, so it is freed together with them. */
+	bool interlaced = png_get_interlace_type(png_ptr, info_ptr) != PNG_INTERLACE_NONE;
+	size_t image_size = (size_t)png_get_rowbytes(png_ptr, info_ptr) * (interlaced ? height : 1);
+	png_bytep image = *rows = MallocT<png_byte>(image_size + width);
+	byte *gray = image + image_size;
+	if (interlaced) {
+		png_bytep *row_pointers = AllocaM(png_bytep, height);
+		for (y = 0; y < height; y++) row_pointers[y] = image + y * png_get_rowbytes(png_ptr, info_ptr);
+		png_read_image(png_ptr, row_pointers);
+	}
 
 	/* Read the raw image data and convert in 8-bit grayscale */
-	for (x = 0; x < png_get_image_width(png_ptr, info_ptr); x++) {
-		for (y = 0; y < png_get_image_height(png_ptr, info_ptr); y++) {
-			byte *pixel = &map[y * png_get_image_width(png_ptr, info_ptr) + x];
-			uint x_offset = x * png_get_channels(png_ptr, info_ptr);
-
-			if (png_get_color_type(png_ptr, info_ptr) == PNG_COLOR_TYPE_PALETTE) {
-				*pixel = gray_palette[row_pointers[y][x_offset]];
-			} else if (png_get_channels(png_ptr, info_ptr) == 3) {
-				*pixel = RGBToGrayscale(row_pointers[y][x_offset + 0],
-						row_pointers[y][x_offset + 1], row_pointers[y][x_offset + 2]);
+	for (y = 0; y < height; y++) {
+		png_bytep row = image;
+		if (interlaced) {
+			row += y * png_get_rowbytes(png_ptr, info_ptr);
+		} else {
+			png_read_row(png_ptr, row, NULL);
+		}
+
+		byte *pixel = gray;
+		for (x = 0; x < width; x++, pixel++) {
+			uint x_offset = x * channels;
+
+			if (palette) {
+				*pixel = gray_palette[row[x_offset]];
+			} else if (channels == 3) {
+				*pixel = RGBToGrayscale(row[x_offset + 0], row[x_offset + 1], row[x_offset + 2]);
 			} else {
-				*pixel = row_pointers[y][x_offset];
+				*pixel = row[x_offset];
 			}
 		}
+
+		scaler->ScaleRow(y, gray);
 	}
 }
 
 /**
  * Reads the heightmap and/or size of the heightmap from a PNG file.
- * If map == NULL only the size of the PNG is read, otherwise a map
- * with grayscale pixels is allocated and assigned to *map.
+ * If scaler == NULL only the size of the PNG is read, otherwise the
+ * image is scaled onto the map by it.
  */
-static bool ReadHeightmapPNG(char *filename, uint *x, uint *y, byte **map)
+static bool ReadHeightmapPNG(char *filename, uint *x, uint *y, HeightmapScaler *scaler)
 {
 	FILE *fp;
 	png_structp png_ptr = NULL;
@@ -118,20 +273,30 @@ static bool ReadHeightmapPNG(char *filename, uint *x, uint *y, byte **map)
 		return false;
 	}
 
+	/* The memory for the rows, which is freed when reading the image fails. */
+	png_bytep volatile image = NULL;
+
 	info_ptr = png_create_info_struct(png_ptr);
 	if (info_ptr == NULL || setjmp(png_jmpbuf(png_ptr))) {
 		ShowErrorMessage(STR_ERROR_PNGMAP, STR_ERROR_PNGMAP_MISC, WL_ERROR);
 		fclose(fp);
 		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+		free(image);
 		return false;
 	}
 
+	/* The image itself is only read, and then row by row, when the map is wanted;
+	 * the dialogs only need the size. */
 	png_init_io(png_ptr, fp);
+	png_read_info(png_ptr, info_ptr);
 
-	/* Allocate memory and read image, without alpha or 16-bit samples
+	/* Read the image without alpha or 16-bit samples
 	 * (result is either 8-bit indexed/grayscale or 24-bit RGB) */
 	png_set_packing(png_ptr);
-	png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_PACKING | PNG_TRANSFORM_STRIP_ALPHA | PNG_TRANSFORM_STRIP_16, NULL);
+	png_set_strip_alpha(png_ptr);
+	png_set_strip_16(png_ptr);
+	if (png_get_interlace_type(png_ptr, info_ptr) != PNG_INTERLACE_NONE) png_set_interlace_handling(png_ptr);
+	png_read_update_info(png_ptr, info_ptr);
 
 	/* Maps of wrong colour-depth are not used.
 	 * (this should have been taken care of by stripping alpha and 16-bit samples on load) */
@@ -142,9 +307,9 @@ static bool ReadHeightmapPNG(char *filename, uint *x, uint *y, byte **map)
 		return false;
 	}
 
-	if (map != NULL) {
-		*map = MallocT<byte>(png_get_image_width(png_ptr, info_ptr) * png_get_image_height(png_ptr, info_ptr));
-		ReadHeightmapPNGImageData(*map, png_ptr, info_ptr);
+	if (scaler != NULL) {
+		ReadHeightmapPNGImageData(scaler, png_ptr, info_ptr, &image);
+		free(image);
 	}
 
 	*x = png_get_image_width(png_ptr, info_ptr);
@@ -161,7 +326,7 @@ static bool ReadHeightmapPNG(char *filename, uint *x, uint *y, byte **map)
 /**
  * The BMP Heightmap loader.
  */
-static void ReadHeightmapBMPImageData(byte *map, BmpInfo *info, BmpData *data)
+static void ReadHeightmapBMPImageData(HeightmapScaler *scaler, BmpInfo *info, BmpData *data)
 {
 	uint x, y;
 	byte gray_palette[256];
@@ -198,8 +363,9 @@ static void ReadHeightmapBMPImageData(byte *map, BmpInfo *info, BmpData *data)
 	}
 
 	/* Read the raw image data and convert in 8-bit grayscale */
+	byte *gray = MallocT<byte>(info->width);
 	for (y = 0; y < info->height; y++) {
-		byte *pixel = &map[y * info->width];
+		byte *pixel = gray;
 		byte *bitmap = &data->bitmap[y * info->width * (info->bpp == 24 ? 3 : 1)];
 
 		for (x = 0; x < info->width; x++) {
@@ -210,15 +376,18 @@ static void ReadHeightmapBMPImageData(byte *map, BmpInfo *info, BmpData *data)
 				bitmap += 3;
 			}
 		}
+
+		scaler->ScaleRow(y, gray);
 	}
+	free(gray);
 }
 
 /**
  * Reads the heightmap and/or size of the heightmap from a BMP file.
- * If map == NULL only the size of the BMP is read, otherwise a map
- * with grayscale pixels is allocated and assigned to *map.
+ * If scaler == NULL only the size of the BMP is read, otherwise the
+ * image is scaled onto the map by it.
  */
-static bool ReadHeightmapBMP(char *filename, uint *x, uint *y, byte **map)
+static bool ReadHeightmapBMP(char *filename, uint *x, uint *y, HeightmapScaler *scaler)
 {
 	FILE *f;
 	BmpInfo info;
@@ -243,7 +412,7 @@ static bool ReadHeightmapBMP(char *filename, uint *x, uint *y, byte **map)
 		return false;
 	}
 
-	if (map != NULL) {
+	if (scaler != NULL) {
 		if (!BmpReadBitmap(&buffer, &info, &data)) {
 			ShowErrorMessage(STR_ERROR_BMPMAP, STR_ERROR_BMPMAP_IMAGE_TYPE, WL_ERROR);
 			fclose(f);
@@ -251,8 +420,7 @@ static bool ReadHeightmapBMP(char *filename, uint *x, uint *y, byte **map)
 			return false;
 		}
 
-		*map = MallocT<byte>(info.width * info.height);
-		ReadHeightmapBMPImageData(*map, &info, &data);
+		ReadHeightmapBMPImageData(scaler, &info, &data);
 	}
 
 	BmpDestroyData(&data);
@@ -264,96 +432,6 @@ static bool ReadHeightmapBMP(char *filename, uint *x, uint *y, byte **map)
 	return true;
 }
 
-/**
- * Converts a given grayscale map to something that fits in OTTD map system
- * and create a map of that data.
- * @param img_width  the with of the image in pixels/tiles
- * @param img_height the height of the image in pixels/tiles
- * @param map        the input map
- */
-static void GrayscaleToMapHeights(uint img_width, uint img_height, byte *map)
-{
-	/* Defines the detail of the aspect ratio (to avoid doubles) */
-	const uint num_div = 16384;
-
-	uint width, height;
-	uint row, col;
-	uint row_pad = 0, col_pad = 0;
-	uint img_scale;
-	uint img_row, img_col;
-	TileIndex tile;
-
-	/* Get map size and calculate scale and padding values */
-	switch (_settings_game.game_creation.heightmap_rotation) {
-		default: NOT_REACHED();
-		case HM_COUNTER_CLOCKWISE:
-			width   = MapSizeX();
-			height  = MapSizeY();
-			break;
-		case HM_CLOCKWISE:
-			width   = MapSizeY();
-			height  = MapSizeX();
-			break;
-	}
-
-	if ((img_width * num_div) / img_height > ((width * num_div) / height)) {
-		/* Image is wider than map - center vertically */
-		img_scale = (width * num_div) / img_width;
-		row_pad = (1 + height - ((img_height * img_scale) / num_div)) / 2;
-	} else {
-		/* Image is taller than map - center horizontally */
-		img_scale = (height * num_div) / img_height;
-		col_pad = (1 + width - ((img_width * img_scale) / num_div)) / 2;
-	}
-
-	if (_settings_game.construction.freeform_edges) {
-		for (uint x = 0; x < MapSizeX(); x++) MakeVoid(TileXY(x, 0));
-		for (uint y = 0; y < MapSizeY(); y++) MakeVoid(TileXY(0, y));
-	}
-
-	/* Form the landscape */
-	for (row = 0; row < height; row++) {
-		for (col = 0; col < width; col++) {
-			switch (_settings_game.game_creation.heightmap_rotation) {
-				default: NOT_REACHED();
-				case HM_COUNTER_CLOCKWISE: tile = TileXY(col, row); break;
-				case HM_CLOCKWISE:         tile = TileXY(row, col); break;
-			}
-
-			/* Check if current tile is within the 1-pixel map edge or padding regions */
-			if ((!_settings_game.construction.freeform_edges && DistanceFromEdge(tile) <= 1) ||
-					(row < row_pad) || (row >= (height - row_pad - (_settings_game.construction.freeform_edges ? 0 : 1))) ||
-					(col < col_pad) || (col >= (width  - col_pad - (_settings_game.construction.freeform_edges ? 0 : 1)))) {
-				SetTileHeight(tile, 0);
-			} else {
-				/* Use nearest neighbor resizing to scale map data.
-				 *  We rotate the map 45 degrees (counter)clockwise */
-				img_row = (((row - row_pad) * num_div) / img_scale);
-				switch (_settings_game.game_creation.heightmap_rotation) {
-					default: NOT_REACHED();
-					case HM_COUNTER_CLOCKWISE:
-						img_col = (((width - 1 - col - col_pad) * num_div) / img_scale);
-						break;
-					case HM_CLOCKWISE:
-						img_col = (((col - col_pad) * num_div) / img_scale);
-						break;
-				}
-
-				assert(img_row < img_height);
-				assert(img_col < img_width);
-
-				/* Colour scales from 0 to 255, OpenTTD height scales from 0 to 15 */
-				SetTileHeight(tile, map[img_row * img_width + img_col] / 16);
-			}
-			/* Only clear the tiles within the map area. */
-			if (TileX(tile) != MapMaxX() && TileY(tile) != MapMaxY() &&
-					(!_settings_game.construction.freeform_edges || (TileX(tile) != 0 && TileY(tile) != 0))) {
-				MakeClear(tile, CLEAR_GRASS, 3);
-			}
-		}
-	}
-}
-
 /**
  * This function takes care of the fact that land in OpenTTD can never differ
  * more than 1 in height
@@ -417,16 +495,16 @@ void FixSlopes()
 /**
  * Reads the heightmap with the correct file reader
  */
-static bool ReadHeightMap(char *filename, uint *x, uint *y, byte **map)
+static bool ReadHeightMap(char *filename, uint *x, uint *y, HeightmapScaler *scaler)
 {
 	switch (_file_to_saveload.mode) {
 		default: NOT_REACHED();
 #ifdef WITH_PNG
 		case SL_PNG:
-			return ReadHeightmapPNG(filename, x, y, map);
+			return ReadHeightmapPNG(filename, x, y, scaler);
 #endif /* WITH_PNG */
 		case SL_BMP:
-			return ReadHeightmapBMP(filename, x, y, map);
+			return ReadHeightmapBMP(filename, x, y, scaler);
 	}
 }
 
@@ -438,16 +516,16 @@ bool GetHeightmapDimensions(char *filename, uint *x, uint *y)
 void LoadHeightmap(char *filename)
 {
 	uint x, y;
-	byte *map = NULL;
+	if (!GetHeightmapDimensions(filename, &x, &y)) return;
 
-	if (!ReadHeightMap(filename, &x, &y, &map)) {
-		free(map);
+	/* The tiles get their heights while the image is read. */
+	HeightmapScaler scaler(x, y);
+	if (!ReadHeightMap(filename, &x, &y, &scaler)) {
+		/* Do not leave the part that was read before the error. */
+		for (TileIndex tile = 0; tile < MapSize(); tile++) SetTileHeight(tile, 0);
 		return;
 	}
 
-	GrayscaleToMapHeights(x, y, map);
-	free(map);
-
 	FixSlopes();
 	MarkWholeScreenDirty();
 }
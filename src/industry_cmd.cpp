@@ -37,6 +37,7 @@
 #include "vehicle_func.h"
 #include "sound_func.h"
 #include "animated_tile_func.h"
+#include "station_func.h"
 #include "effectvehicle_func.h"
 #include "effectvehicle_base.h"
 #include "ai/ai.hpp"
@@ -525,6 +526,7 @@ static void TransportIndustryGoods(TileIndex tile)
 			ResetIndustryConstructionStage(tile);
 			SetIndustryCompleted(tile, true);
 			SetIndustryGfx(tile, newgfx);
+			MarkCatchmentTileChanged(tile);
 			MarkTileDirtyByTile(tile);
 		}
 	}
@@ -711,7 +713,7 @@ static void CreateChimneySmoke(TileIndex tile)
 	uint y = TileY(tile) * TILE_SIZE;
 	uint z = GetTileMaxZ(tile);
 
-	CreateEffectVehicle(x + 15, y + 14, z + 59, EV_CHIMNEY_SMOKE);
+	CreateEffectParticle(x + 15, y + 14, z + 59, EV_CHIMNEY_SMOKE);
 }
 
 static void MakeIndustryTileBigger(TileIndex tile)
@@ -821,6 +823,7 @@ static void TileLoop_Industry(TileIndex tile)
 	if (newgfx != INDUSTRYTILE_NOANIM) {
 		ResetIndustryConstructionStage(tile);
 		SetIndustryGfx(tile, newgfx);
+		MarkCatchmentTileChanged(tile);
 		MarkTileDirtyByTile(tile);
 		return;
 	}
@@ -1530,6 +1533,15 @@ static bool CheckIfCanLevelIndustryPlatform(TileIndex tile, DoCommandFlag flags,
 static CommandCost CheckIfFarEnoughFromConflictingIndustry(TileIndex tile, int type)
 {
 	const IndustrySpec *indspec = GetIndustrySpec(type);
+
+	/* No need to look at all industries when none of the conflicting types exist. */
+	bool any_conflicting = false;
+	for (uint j = 0; j < lengthof(indspec->conflicting); j++) {
+		IndustryType conflicting = indspec->conflicting[j];
+		if (conflicting < NUM_INDUSTRYTYPES && Industry::GetIndustryTypeCount(conflicting) > 0) any_conflicting = true;
+	}
+	if (!any_conflicting) return CommandCost();
+
 	const Industry *i;
 	FOR_ALL_INDUSTRIES(i) {
 		/* Within 14 tiles from another industry is considered close */
@@ -1668,6 +1680,7 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 			DoCommand(cur_tile, 0, 0, DC_EXEC | DC_NO_TEST_TOWN_RATING | DC_NO_MODIFY_TOWN_RATING, CMD_LANDSCAPE_CLEAR);
 
 			MakeIndustry(cur_tile, i->index, it->gfx, Random(), wc);
+			MarkCatchmentTileChanged(cur_tile);
 
 			if (_generating_world) {
 				SetIndustryConstructionCounter(cur_tile, 3);
@@ -1837,14 +1850,56 @@ CommandCost CmdBuildIndustry(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 }
 
 
+/**
+ * Quick check whether an industry could be built at a location at all.
+ * It only tests the conditions of #CreateNewIndustryHelper that merely need
+ * to look at the map, so no commands or NewGRF callbacks are run. Random
+ * placement tries a lot of unsuitable locations; this rejects most of them
+ * before the expensive checks are done. It never rejects a location that the
+ * full checks would accept, so the same industries end up at the same places.
+ * @param tile         North tile of the industry.
+ * @param type         Type of the industry.
+ * @param itspec_index The layout of the industry.
+ * @return false if the industry can certainly not be built here.
+ */
+static bool IsPossibleIndustrySite(TileIndex tile, IndustryType type, uint itspec_index)
+{
+	const IndustrySpec *indspec = GetIndustrySpec(type);
+	const IndustryTileTable *it = indspec->table[itspec_index];
+
+	do {
+		TileIndex cur_tile = TileAddWrap(tile, it->ti.x, it->ti.y);
+		if (!IsValidTile(cur_tile)) return false;
+
+		IndustryGfx gfx = GetTranslatedIndustryTileID(it->gfx);
+		if (gfx == GFX_WATERTILE_SPECIALCHECK) {
+			if (!IsTileType(cur_tile, MP_WATER) || GetTileSlope(cur_tile, NULL) != SLOPE_FLAT) return false;
+			continue;
+		}
+
+		if (MayHaveBridgeAbove(cur_tile) && IsBridgeAbove(cur_tile)) return false;
+
+		const IndustryTileSpec *its = GetIndustryTileSpec(gfx);
+		if (!HasBit(its->slopes_refused, 5) && (IsWaterTile(cur_tile) == !(indspec->behaviour & INDUSTRYBEH_BUILT_ONWATER))) return false;
+		if ((indspec->behaviour & (INDUSTRYBEH_ONLY_INTOWN | INDUSTRYBEH_TOWN1200_MORE)) && !IsTileType(cur_tile, MP_HOUSE)) return false;
+	} while ((++it)->ti.x != -0x80);
+
+	if (!HasBit(indspec->callback_mask, CBM_IND_LOCATION) && _check_new_industry_procs[indspec->check_proc](tile).Failed()) return false;
+
+	return CheckIfFarEnoughFromConflictingIndustry(tile, type).Succeeded();
+}
+
 static Industry *CreateNewIndustry(TileIndex tile, IndustryType type)
 {
 	const IndustrySpec *indspec = GetIndustrySpec(type);
 
 	uint32 seed = Random();
 	uint32 seed2 = Random();
+	uint itspec_index = RandomRange(indspec->num_table);
+	if (!IsPossibleIndustrySite(tile, type, itspec_index)) return NULL;
+
 	Industry *i = NULL;
-	CommandCost ret = CreateNewIndustryHelper(tile, type, DC_EXEC, indspec, RandomRange(indspec->num_table), seed, GB(seed2, 0, 16), OWNER_NONE, &i);
+	CommandCost ret = CreateNewIndustryHelper(tile, type, DC_EXEC, indspec, itspec_index, seed, GB(seed2, 0, 16), OWNER_NONE, &i);
 	assert(i != NULL || ret.Failed());
 	return i;
 }
@@ -950,7 +950,7 @@ class IndustryDirectoryWindow : public Window {
 protected:
 	/* Runtime saved values */
 	static Listing last_sorting;
-	static const Industry *last_industry;
+	static NameCache town_names;
 
 	/* Constants for sorting stations */
 	static const StringID sorter_names[];
@@ -975,7 +975,7 @@ protected:
 		}
 
 		if (!this->industries.Sort()) return;
-		IndustryDirectoryWindow::last_industry = NULL; // Reset name sorter sort cache
+		IndustryDirectoryWindow::town_names.Clear(); // Reset name sorter sort cache
 		this->SetWidgetDirty(IDW_INDUSTRY_LIST); // Set the modified widget dirty
 	}
 
@@ -1014,19 +1014,7 @@ protected:
 	/** Sort industries by name */
 	static int CDECL IndustryNameSorter(const Industry * const *a, const Industry * const *b)
 	{
-		static char buf_cache[96];
-		static char buf[96];
-
-		SetDParam(0, (*a)->town->index);
-		GetString(buf, STR_TOWN_NAME, lastof(buf));
-
-		if (*b != last_industry) {
-			last_industry = *b;
-			SetDParam(0, (*b)->town->index);
-			GetString(buf_cache, STR_TOWN_NAME, lastof(buf_cache));
-		}
-
-		return strcmp(buf, buf_cache);
+		return strcmp(town_names.Get((*a)->town->index), town_names.Get((*b)->town->index));
 	}
 
 	/** Sort industries by type and name */
@@ -1223,12 +1211,7 @@ public:
 		this->vscroll.SetCapacityFromWidget(this, IDW_INDUSTRY_LIST);
 	}
 
-	virtual void OnHundredthTick()
-	{
-		this->industries.ForceResort();
-		this->BuildSortIndustriesList();
-	}
-
+	/** The industries' production and transported cargo change monthly, which invalidates this window. */
 	virtual void OnInvalidateData(int data)
 	{
 		if (data == 0) {
@@ -1241,7 +1224,7 @@ public:
 };
 
 Listing IndustryDirectoryWindow::last_sorting = {false, 0};
-const Industry *IndustryDirectoryWindow::last_industry = NULL;
+NameCache IndustryDirectoryWindow::town_names(STR_TOWN_NAME);
 
 /* Availible station sorting functions */
 GUIIndustryList::SortFunction * const IndustryDirectoryWindow::sorter_funcs[] = {
@@ -26,13 +26,31 @@
 # include <shellapi.h>
 #endif
 
-IniItem::IniItem(IniGroup *parent, const char *name, size_t len) : next(NULL), value(NULL), comment(NULL)
+/**
+ * Get the bucket of the hash for the name of a group or an item.
+ * @param name the name
+ * @param len  the length of the name
+ * @return the bucket in the hash
+ */
+static uint IniHash(const char *name, size_t len)
+{
+	uint hash = 0;
+	for (size_t i = 0; i < len; i++) hash = hash * 31 + (byte)name[i];
+	return hash % INI_HASH_SIZE;
+}
+
+IniItem::IniItem(IniGroup *parent, const char *name, size_t len) : next(NULL), hash_next(NULL), value(NULL), comment(NULL)
 {
 	if (len == 0) len = strlen(name);
 
 	this->name = strndup(name, len);
 	*parent->last_item = this;
 	parent->last_item = &this->next;
+
+	/* Append, so with duplicate names the first one is still found. */
+	IniItem **bucket = &parent->item_hash[IniHash(name, len)];
+	while (*bucket != NULL) bucket = &(*bucket)->hash_next;
+	*bucket = this;
 }
 
 IniItem::~IniItem()
@@ -50,15 +68,20 @@ void IniItem::SetValue(const char *value)
 	this->value = strdup(value);
 }
 
-IniGroup::IniGroup(IniFile *parent, const char *name, size_t len) : next(NULL), type(IGT_VARIABLES), item(NULL), comment(NULL)
+IniGroup::IniGroup(IniFile *parent, const char *name, size_t len) : next(NULL), hash_next(NULL), type(IGT_VARIABLES), item(NULL), comment(NULL)
 {
 	if (len == 0) len = strlen(name);
 
 	this->name = strndup(name, len);
 	this->last_item = &this->item;
+	MemSetT(this->item_hash, 0, INI_HASH_SIZE);
 	*parent->last_group = this;
 	parent->last_group = &this->next;
 
+	IniGroup **bucket = &parent->group_hash[IniHash(name, len)];
+	while (*bucket != NULL) bucket = &(*bucket)->hash_next;
+	*bucket = this;
+
 	if (parent->list_group_names == NULL) return;
 
 	for (uint i = 0; parent->list_group_names[i] != NULL; i++) {
@@ -80,14 +103,16 @@ IniGroup::~IniGroup()
 
 IniItem *IniGroup::GetItem(const char *name, bool create)
 {
-	for (IniItem *item = this->item; item != NULL; item = item->next) {
+	size_t len = strlen(name);
+
+	for (IniItem *item = this->item_hash[IniHash(name, len)]; item != NULL; item = item->hash_next) {
 		if (strcmp(item->name, name) == 0) return item;
 	}
 
 	if (!create) return NULL;
 
 	/* otherwise make a new one */
-	return new IniItem(this, name, strlen(name));
+	return new IniItem(this, name, len);
 }
 
 void IniGroup::Clear()
@@ -95,11 +120,13 @@ void IniGroup::Clear()
 	delete this->item;
 	this->item = NULL;
 	this->last_item = &this->item;
+	MemSetT(this->item_hash, 0, INI_HASH_SIZE);
 }
 
 IniFile::IniFile(const char * const *list_group_names) : group(NULL), comment(NULL), list_group_names(list_group_names)
 {
 	this->last_group = &this->group;
+	MemSetT(this->group_hash, 0, INI_HASH_SIZE);
 }
 
 IniFile::~IniFile()
@@ -113,7 +140,7 @@ IniGroup *IniFile::GetGroup(const char *name, size_t len)
 	if (len == 0) len = strlen(name);
 
 	/* does it exist already? */
-	for (IniGroup *group = this->group; group != NULL; group = group->next) {
+	for (IniGroup *group = this->group_hash[IniHash(name, len)]; group != NULL; group = group->hash_next) {
 		if (!memcmp(group->name, name, len) && group->name[len] == 0) {
 			return group;
 		}
@@ -127,26 +154,18 @@ IniGroup *IniFile::GetGroup(const char *name, size_t len)
 
 void IniFile::RemoveGroup(const char *name)
 {
-	size_t len = strlen(name);
-	IniGroup *prev = NULL;
-	IniGroup *group;
-
 	/* does it exist already? */
-	for (group = this->group; group != NULL; prev = group, group = group->next) {
-		if (memcmp(group->name, name, len) == 0) {
-			break;
-		}
-	}
+	IniGroup **bucket = &this->group_hash[IniHash(name, strlen(name))];
+	while (*bucket != NULL && strcmp((*bucket)->name, name) != 0) bucket = &(*bucket)->hash_next;
 
+	IniGroup *group = *bucket;
 	if (group == NULL) return;
+	*bucket = group->hash_next;
 
-	if (prev != NULL) {
-		prev->next = prev->next->next;
-		if (this->last_group == &group->next) this->last_group = &prev->next;
-	} else {
-		this->group = this->group->next;
-		if (this->last_group == &group->next) this->last_group = &this->group;
-	}
+	IniGroup **link = &this->group;
+	while (*link != group) link = &(*link)->next;
+	*link = group->next;
+	if (this->last_group == &group->next) this->last_group = link;
 
 	group->next = NULL;
 	delete group;
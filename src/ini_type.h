@@ -18,9 +18,13 @@ enum IniGroupType {
 	IGT_LIST      = 1, ///< a list of values, seperated by \n and terminated by the next group block
 };
 
+/** Number of buckets in the hashes of the groups of a file and of the items of a group. */
+static const uint INI_HASH_SIZE = 64;
+
 /** A single "line" in an ini file. */
 struct IniItem {
-	IniItem *next; ///< The next item in this group
+	IniItem *next;      ///< The next item in this group
+	IniItem *hash_next; ///< The next item in the same bucket of the hash of this group
 	char *name;    ///< The name of this item
 	char *value;   ///< The value of this item
 	char *comment; ///< The comment associated with this item
@@ -46,11 +50,13 @@ struct IniItem {
 /** A group within an ini file. */
 struct IniGroup {
 	IniGroup *next;      ///< the next group within this file
+	IniGroup *hash_next; ///< the next group in the same bucket of the hash of this file
 	IniGroupType type;   ///< type of group
 	IniItem *item;       ///< the first item in the group
 	IniItem **last_item; ///< the last item in the group
 	char *name;          ///< name of group
 	char *comment;       ///< comment for group
+	IniItem *item_hash[INI_HASH_SIZE]; ///< the items of the group by the hash of their name
 
 	/**
 	 * Construct a new in-memory group of an Ini file.
@@ -84,6 +90,7 @@ struct IniFile {
 	IniGroup **last_group;                ///< the last group in the ini
 	char *comment;                        ///< last comment in file
 	const char * const *list_group_names; ///< NULL terminated list with group names that are lists
+	IniGroup *group_hash[INI_HASH_SIZE];  ///< the groups of the ini by the hash of their name
 
 	/**
 	 * Construct a new in-memory Ini file representation.
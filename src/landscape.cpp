@@ -28,7 +28,10 @@
 #include "effectvehicle_func.h"
 #include "landscape_type.h"
 #include "animated_tile_func.h"
+#include "station_func.h"
+#include "road_func.h"
 #include "core/random_func.hpp"
+#include "tick_profiler.h"
 
 #include "table/sprites.h"
 
@@ -481,7 +484,13 @@ void DoClearSquare(TileIndex tile)
 	/* If the tile can have animation and we clear it, delete it from the animated tile list. */
 	if (_tile_type_procs[GetTileType(tile)]->animate_tile_proc != NULL) DeleteAnimatedTile(tile);
 
+	/* Removing a road, road stop, tunnel or bridge might change the paths of road vehicles. */
+	if (IsTileType(tile, MP_ROAD) || IsTileType(tile, MP_STATION) || IsTileType(tile, MP_TUNNELBRIDGE)) MarkRoadLayoutChanged(tile);
+	/* Removing water, a dock, a buoy or an aqueduct might change the paths of ships. */
+	if (IsTileType(tile, MP_WATER) || IsTileType(tile, MP_STATION) || IsTileType(tile, MP_TUNNELBRIDGE)) YapfNotifyWaterLayoutChange(tile);
+
 	MakeClear(tile, CLEAR_GRASS, _generating_world ? 3 : 0);
+	MarkCatchmentTileChanged(tile);
 	MarkTileDirtyByTile(tile);
 }
 
@@ -665,22 +674,25 @@ TileIndex _cur_tileloop_tile;
 #define TILELOOP_ASSERTMASK ((TILELOOP_SIZE - 1) + ((TILELOOP_SIZE - 1) << MapLogX()))
 #define TILELOOP_CHKMASK (((1 << (MapLogX() - TILELOOP_BITS))-1) << TILELOOP_BITS)
 
+/**
+ * Run the tile loop handler of one tile of every TILELOOP_SIZE x TILELOOP_SIZE
+ * block of the map, so every tile is handled once every 256 ticks.
+ * The tiles are visited row by row, in the order of their index. Void tiles
+ * at the borders of the map never have anything to do, so their handler is
+ * not called at all.
+ */
 void RunTileLoop()
 {
 	TileIndex tile = _cur_tileloop_tile;
 
 	assert((tile & ~TILELOOP_ASSERTMASK) == 0);
-	uint count = (MapSizeX() / TILELOOP_SIZE) * (MapSizeY() / TILELOOP_SIZE);
-	do {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
-
-		if (TileX(tile) < MapSizeX() - TILELOOP_SIZE) {
-			tile += TILELOOP_SIZE; // no overflow
-		} else {
-			tile = TILE_MASK(tile - TILELOOP_SIZE * (MapSizeX() / TILELOOP_SIZE - 1) + TileDiffXY(0, TILELOOP_SIZE)); // x would overflow, also increase y
+	for (uint y = TileY(tile); y < MapSizeY(); y += TILELOOP_SIZE) {
+		for (uint x = TileX(tile); x < MapSizeX(); x += TILELOOP_SIZE) {
+			TileIndex cur = TileXY(x, y);
+			TileType type = GetTileType(cur);
+			if (type != MP_VOID) _tile_type_procs[type]->tile_loop_proc(cur);
 		}
-	} while (--count != 0);
-	assert((tile & ~TILELOOP_ASSERTMASK) == 0);
+	}
 
 	tile += 9;
 	if (tile & TILELOOP_CHKMASK) {
@@ -689,6 +701,20 @@ void RunTileLoop()
 	_cur_tileloop_tile = tile;
 }
 
+/**
+ * Run the tile loop handler of every tile in a row of the map.
+ * This is used to let the landscape settle after generating a world
+ * when walking the map linearly is preferred over the order of #RunTileLoop.
+ * @param y The row to run the tile loop of.
+ */
+void RunTileLoopOnRow(uint y)
+{
+	for (TileIndex cur = TileXY(0, y); cur < TileXY(0, y) + MapSizeX(); cur++) {
+		TileType type = GetTileType(cur);
+		if (type != MP_VOID) _tile_type_procs[type]->tile_loop_proc(cur);
+	}
+}
+
 void InitializeLandscape()
 {
 	uint maxx = MapMaxX();
@@ -759,16 +785,16 @@ static void GenerateTerrain(int type, uint flag)
 	if (x + w >= MapMaxX() - 1) return;
 	if (y + h >= MapMaxY() - 1) return;
 
-	Tile *tile = &_m[TileXY(x, y)];
+	TileIndex tile = TileXY(x, y);
 
 	switch (direction) {
 		default: NOT_REACHED();
 		case DIAGDIR_NE:
 			do {
-				Tile *tile_cur = tile;
+				TileIndex tile_cur = tile;
 
 				for (uint w_cur = w; w_cur != 0; --w_cur) {
-					if (GB(*p, 0, 4) >= tile_cur->type_height) tile_cur->type_height = GB(*p, 0, 4);
+					if (GB(*p, 0, 4) >= _m[tile_cur].type_height) _m[tile_cur].type_height = GB(*p, 0, 4);
 					p++;
 					tile_cur++;
 				}
@@ -778,10 +804,10 @@ static void GenerateTerrain(int type, uint flag)
 
 		case DIAGDIR_SE:
 			do {
-				Tile *tile_cur = tile;
+				TileIndex tile_cur = tile;
 
 				for (uint h_cur = h; h_cur != 0; --h_cur) {
-					if (GB(*p, 0, 4) >= tile_cur->type_height) tile_cur->type_height = GB(*p, 0, 4);
+					if (GB(*p, 0, 4) >= _m[tile_cur].type_height) _m[tile_cur].type_height = GB(*p, 0, 4);
 					p++;
 					tile_cur += TileDiffXY(0, 1);
 				}
@@ -792,10 +818,10 @@ static void GenerateTerrain(int type, uint flag)
 		case DIAGDIR_SW:
 			tile += TileDiffXY(w - 1, 0);
 			do {
-				Tile *tile_cur = tile;
+				TileIndex tile_cur = tile;
 
 				for (uint w_cur = w; w_cur != 0; --w_cur) {
-					if (GB(*p, 0, 4) >= tile_cur->type_height) tile_cur->type_height = GB(*p, 0, 4);
+					if (GB(*p, 0, 4) >= _m[tile_cur].type_height) _m[tile_cur].type_height = GB(*p, 0, 4);
 					p++;
 					tile_cur--;
 				}
@@ -806,10 +832,10 @@ static void GenerateTerrain(int type, uint flag)
 		case DIAGDIR_NW:
 			tile += TileDiffXY(0, h - 1);
 			do {
-				Tile *tile_cur = tile;
+				TileIndex tile_cur = tile;
 
 				for (uint h_cur = h; h_cur != 0; --h_cur) {
-					if (GB(*p, 0, 4) >= tile_cur->type_height) tile_cur->type_height = GB(*p, 0, 4);
+					if (GB(*p, 0, 4) >= _m[tile_cur].type_height) _m[tile_cur].type_height = GB(*p, 0, 4);
 					p++;
 					tile_cur -= TileDiffXY(0, 1);
 				}
@@ -950,10 +976,16 @@ void OnTick_Companies();
 
 void CallLandscapeTick()
 {
+	TickProfilerStart(TPE_TOWNS);
 	OnTick_Town();
+	TickProfilerStop(TPE_TOWNS);
+
 	OnTick_Trees();
 	OnTick_Station();
+
+	TickProfilerStart(TPE_INDUSTRIES);
 	OnTick_Industry();
+	TickProfilerStop(TPE_INDUSTRIES);
 
 	OnTick_Companies();
 }
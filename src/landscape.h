@@ -89,6 +89,7 @@ bool HasFoundationNE(TileIndex tile, Slope slope_here, uint z_here);
 
 void DoClearSquare(TileIndex tile);
 void RunTileLoop();
+void RunTileLoopOnRow(uint y);
 
 void InitializeLandscape();
 void GenerateLandscape(byte mode);
@@ -13,6 +13,7 @@
 #include "debug.h"
 #include "core/alloc_func.hpp"
 #include "core/math_func.hpp"
+#include "core/mem_func.hpp"
 #include "tile_map.h"
 
 #if defined(_MSC_VER)
@@ -27,7 +28,11 @@ uint _map_size_y;    ///< Size of the map along the Y
 uint _map_size;      ///< The number of tiles on the map
 uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
+#ifdef WITH_MAP_PLANES
+TilePlanes _m;            ///< Fields of the tiles of the map
+#else
 Tile *_m = NULL;          ///< Tiles of the map
+#endif /* WITH_MAP_PLANES */
 TileExtended *_me = NULL; ///< Extended Tiles of the map
 
 
@@ -43,7 +48,8 @@ void AllocateMap(uint size_x, uint size_y)
 	if (!IsInsideMM(size_x, MIN_MAP_SIZE, MAX_MAP_SIZE + 1) ||
 			!IsInsideMM(size_y, MIN_MAP_SIZE, MAX_MAP_SIZE + 1) ||
 			(size_x & (size_x - 1)) != 0 ||
-			(size_y & (size_y - 1)) != 0)
+			(size_y & (size_y - 1)) != 0 ||
+			size_x * size_y > MAX_MAP_TILES)
 		error("Invalid map size");
 
 	DEBUG(map, 1, "Allocating map of size %dx%d", size_x, size_y);
@@ -55,13 +61,55 @@ void AllocateMap(uint size_x, uint size_y)
 	_map_size = size_x * size_y;
 	_map_tile_mask = _map_size - 1;
 
+#ifdef WITH_MAP_PLANES
+	free(_m.type_height);
+	free(_m.m1);
+	free(_m.m2);
+	free(_m.m3);
+	free(_m.m4);
+	free(_m.m5);
+	free(_m.m6);
+	free(_me);
+
+	_m.type_height = CallocT<byte>(_map_size);
+	_m.m1 = CallocT<byte>(_map_size);
+	_m.m2 = CallocT<uint16>(_map_size);
+	_m.m3 = CallocT<byte>(_map_size);
+	_m.m4 = CallocT<byte>(_map_size);
+	_m.m5 = CallocT<byte>(_map_size);
+	_m.m6 = CallocT<byte>(_map_size);
+#else
 	free(_m);
 	free(_me);
 
 	_m = CallocT<Tile>(_map_size);
+#endif /* WITH_MAP_PLANES */
 	_me = CallocT<TileExtended>(_map_size);
 }
 
+/**
+ * Reset all fields of a range of tiles to zero.
+ * @param begin The first tile to reset.
+ * @param count The number of tiles to reset.
+ */
+void ClearTiles(TileIndex begin, uint count)
+{
+	assert(begin + count <= MapSize());
+
+#ifdef WITH_MAP_PLANES
+	MemSetT(_m.type_height + begin, 0, count);
+	MemSetT(_m.m1 + begin, 0, count);
+	MemSetT(_m.m2 + begin, 0, count);
+	MemSetT(_m.m3 + begin, 0, count);
+	MemSetT(_m.m4 + begin, 0, count);
+	MemSetT(_m.m5 + begin, 0, count);
+	MemSetT(_m.m6 + begin, 0, count);
+#else
+	MemSetT(_m + begin, 0, count);
+#endif /* WITH_MAP_PLANES */
+	MemSetT(_me + begin, 0, count);
+}
+
 
 #ifdef _DEBUG
 TileIndex TileAdd(TileIndex tile, TileIndexDiff add,
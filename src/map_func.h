@@ -27,6 +27,14 @@ extern uint _map_tile_mask;
 
 #define TILE_MASK(x) ((x) & _map_tile_mask)
 
+#ifdef WITH_MAP_PLANES
+/**
+ * The arrays with the fields of the tiles of the map.
+ *
+ * Indexing it gives the same members as indexing the normal tile-array.
+ */
+extern TilePlanes _m;
+#else
 /**
  * Pointer to the tile-array.
  *
@@ -34,6 +42,7 @@ extern uint _map_tile_mask;
  * the map.
  */
 extern Tile *_m;
+#endif /* WITH_MAP_PLANES */
 
 /**
  * Pointer to the extended tile-array.
@@ -48,6 +57,8 @@ extern TileExtended *_me;
  */
 void AllocateMap(uint size_x, uint size_y);
 
+void ClearTiles(TileIndex begin, uint count);
+
 /**
  * Logarithm of the map size along the X side.
  * @note try to avoid using this one
@@ -26,6 +26,51 @@ struct Tile {
 	byte   m6;          ///< Primarily used for bridges and rainforest/desert
 };
 
+#ifdef WITH_MAP_PLANES
+/**
+ * References to the fields of one tile when every field of the map is
+ * stored in its own array. It has the same members as #Tile, so the map
+ * accessors work with both storage methods.
+ */
+struct TileRef {
+	byte   &type_height; ///< The type (bits 4..7) and height of the northern corner
+	byte   &m1;          ///< Primarily used for ownership information
+	uint16 &m2;          ///< Primarily used for indices to towns, industries and stations
+	byte   &m3;          ///< General purpose
+	byte   &m4;          ///< General purpose
+	byte   &m5;          ///< General purpose
+	byte   &m6;          ///< Primarily used for bridges and rainforest/desert
+};
+
+/**
+ * The map stored as one array per field of #Tile. Scans over a single
+ * field, like the tile type, only touch the memory of that field.
+ */
+struct TilePlanes {
+	byte   *type_height; ///< The type and height of all tiles
+	byte   *m1;          ///< The m1 of all tiles
+	uint16 *m2;          ///< The m2 of all tiles
+	byte   *m3;          ///< The m3 of all tiles
+	byte   *m4;          ///< The m4 of all tiles
+	byte   *m5;          ///< The m5 of all tiles
+	byte   *m6;          ///< The m6 of all tiles
+
+	/**
+	 * Get the fields of a tile.
+	 * @param tile The tile to get the fields of.
+	 * @return References to the fields of the tile.
+	 */
+	FORCEINLINE TileRef operator [](uint tile) const
+	{
+		TileRef ref = {
+			this->type_height[tile], this->m1[tile], this->m2[tile], this->m3[tile],
+			this->m4[tile], this->m5[tile], this->m6[tile]
+		};
+		return ref;
+	}
+};
+#endif /* WITH_MAP_PLANES */
+
 /**
  * Data that is stored per tile. Also used Tile for this.
  * Look at docs/landscape.html for the exact meaning of the members.
@@ -59,9 +104,13 @@ struct TileIndexDiffC {
 
 /** Minimal and maximal map width and height */
 static const uint MIN_MAP_SIZE_BITS = 6;                      ///< Minimal size of map is equal to 2 ^ MIN_MAP_SIZE_BITS
-static const uint MAX_MAP_SIZE_BITS = 11;                     ///< Maximal size of map is equal to 2 ^ MAX_MAP_SIZE_BITS
+static const uint MAX_MAP_SIZE_BITS = 13;                     ///< Maximal size of map is equal to 2 ^ MAX_MAP_SIZE_BITS
 static const uint MIN_MAP_SIZE      = 1 << MIN_MAP_SIZE_BITS; ///< Minimal map size = 64
-static const uint MAX_MAP_SIZE      = 1 << MAX_MAP_SIZE_BITS; ///< Maximal map size = 2048
+static const uint MAX_MAP_SIZE      = 1 << MAX_MAP_SIZE_BITS; ///< Maximal map size = 8192
+
+/** Maximal number of tiles of a map */
+static const uint MAX_MAP_TILES_BITS = 24;                      ///< Maximal number of tiles of a map is equal to 2 ^ MAX_MAP_TILES_BITS
+static const uint MAX_MAP_TILES      = 1 << MAX_MAP_TILES_BITS; ///< Maximal number of tiles of a map = 4096 * 4096
 
 /**
  * Approximation of the length of a straight track, relative to a diagonal
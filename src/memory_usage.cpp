@@ -0,0 +1,183 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file memory_usage.cpp Reporting the memory used by the pools and the other big structures. */
+
+#include "stdafx.h"
+#include "memory_usage.h"
+#include "console_func.h"
+#include "map_func.h"
+#include "train.h"
+#include "roadveh.h"
+#include "ship.h"
+#include "aircraft.h"
+#include "effectvehicle_base.h"
+#include "station_base.h"
+#include "waypoint_base.h"
+#include "roadstop_base.h"
+#include "town.h"
+#include "industry.h"
+#include "company_base.h"
+#include "engine_base.h"
+#include "group.h"
+#include "depot_base.h"
+#include "signs_base.h"
+#include "subsidy_base.h"
+#include "autoreplace_base.h"
+#include "economy_base.h"
+#include "newgrf.h"
+#include "newgrf_config.h"
+#include "newgrf_text.h"
+#include "spritecache.h"
+#include "fontcache.h"
+#include "saveload/saveload.h"
+#include "ai/ai_instance.hpp"
+
+/**
+ * Print the usage of one pool.
+ * @param name  The name of the pool.
+ * @param pool  The pool to print.
+ * @param extra Bytes used by the items on top of the size of the pooled type.
+ * @return the number of bytes used by the pool
+ */
+template <class Tpool>
+static size_t PrintPoolUsage(const char *name, const Tpool &pool, size_t extra = 0)
+{
+	size_t bytes = pool.GetMemoryUsage() + extra;
+	IConsolePrintF(CC_DEFAULT, "  %-16s %8u %8u %8u", name, (uint)pool.items, (uint)pool.size, (uint)(bytes / 1024));
+	return bytes;
+}
+
+/**
+ * Print the usage of something that is not a pool.
+ * @param name  The name of the structure.
+ * @param bytes The number of bytes it uses.
+ * @return \a bytes
+ */
+static size_t PrintUsage(const char *name, size_t bytes)
+{
+	IConsolePrintF(CC_DEFAULT, "  %-16s %8s %8s %8u", name, "", "", (uint)(bytes / 1024));
+	return bytes;
+}
+
+/**
+ * Get the number of bytes the vehicles use on top of the size of Vehicle.
+ * @return the extra bytes of the vehicle types
+ */
+static size_t GetVehicleSubclassMemoryUsage()
+{
+	size_t bytes = 0;
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		switch (v->type) {
+			case VEH_TRAIN:    bytes += sizeof(Train); break;
+			case VEH_ROAD:     bytes += sizeof(RoadVehicle); break;
+			case VEH_SHIP:     bytes += sizeof(Ship); break;
+			case VEH_AIRCRAFT: bytes += sizeof(Aircraft); break;
+			case VEH_EFFECT:   bytes += sizeof(EffectVehicle); break;
+			case VEH_DISASTER: bytes += sizeof(DisasterVehicle); break;
+			default:           bytes += sizeof(Vehicle); break;
+		}
+		bytes -= sizeof(Vehicle);
+	}
+	return bytes;
+}
+
+/**
+ * Get the number of bytes the stations and waypoints use on top of the size of BaseStation.
+ * @return the extra bytes of the station types
+ */
+static size_t GetStationSubclassMemoryUsage()
+{
+	size_t bytes = 0;
+	const BaseStation *st;
+	FOR_ALL_BASE_STATIONS(st) {
+		bytes += Station::IsExpected(st) ? sizeof(Station) - sizeof(BaseStation) : sizeof(Waypoint) - sizeof(BaseStation);
+	}
+	return bytes;
+}
+
+/** @return The bytes used by the arrays of the map. */
+static size_t GetMapMemoryUsage()
+{
+#ifdef WITH_MAP_PLANES
+	size_t per_tile = sizeof(*_m.type_height) + sizeof(*_m.m1) + sizeof(*_m.m2) + sizeof(*_m.m3) + sizeof(*_m.m4) + sizeof(*_m.m5) + sizeof(*_m.m6);
+#else
+	size_t per_tile = sizeof(*_m);
+#endif /* WITH_MAP_PLANES */
+	return MapSize() * (per_tile + sizeof(*_me));
+}
+
+/** @return The bytes used by the sprite groups and texts of all NewGRFs. */
+static size_t GetNewGRFMemoryUsage()
+{
+	size_t bytes = 0;
+	for (const GRFConfig *c = _grfconfig; c != NULL; c = c->next) {
+		const GRFFile *grffile = GetFileByGRFID(c->ident.grfid);
+		if (grffile == NULL) continue;
+
+		uint num_texts;
+		bytes += grffile->spritegroup_memory + GetGRFTextMemoryUsage(grffile->grfid, &num_texts);
+	}
+	return bytes;
+}
+
+/** @return The bytes used by the virtual machines of all AIs. */
+static size_t GetAIMemoryUsage()
+{
+	size_t bytes = 0;
+#ifdef ENABLE_AI
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		if (c->is_ai && c->ai_instance != NULL) bytes += c->ai_instance->GetAllocatedMemory();
+	}
+#endif /* ENABLE_AI */
+	return bytes;
+}
+
+/**
+ * Print the memory used by the pools and the other big structures to the
+ * console. Nothing is walked except for the vehicles, the stations, the
+ * NewGRFs and the AIs, so it is cheap enough to be called regularly.
+ */
+void MemoryUsagePrint()
+{
+	IConsolePrint(CC_DEFAULT, "Memory usage; sizes in KiB:");
+	IConsolePrintF(CC_DEFAULT, "  %-16s %8s %8s %8s", "pool", "items", "capacity", "size");
+
+	size_t total = 0;
+	total += PrintPoolUsage("vehicles",       _vehicle_pool, GetVehicleSubclassMemoryUsage());
+	total += PrintPoolUsage("orders",         _order_pool);
+	total += PrintPoolUsage("order lists",    _orderlist_pool);
+	total += PrintPoolUsage("cargo packets",  _cargopacket_pool);
+	total += PrintPoolUsage("cargo payments", _cargo_payment_pool);
+	total += PrintPoolUsage("stations",       _station_pool, GetStationSubclassMemoryUsage());
+	total += PrintPoolUsage("road stops",     _roadstop_pool);
+	total += PrintPoolUsage("towns",          _town_pool);
+	total += PrintPoolUsage("industries",     _industry_pool);
+	total += PrintPoolUsage("depots",         _depot_pool);
+	total += PrintPoolUsage("companies",      _company_pool);
+	total += PrintPoolUsage("engines",        _engine_pool);
+	total += PrintPoolUsage("engine renews",  _enginerenew_pool);
+	total += PrintPoolUsage("groups",         _group_pool);
+	total += PrintPoolUsage("signs",          _sign_pool);
+	total += PrintPoolUsage("subsidies",      _subsidy_pool);
+
+	size_t sprites_allocated, sprites_in_use;
+	size_t sprite_table = GetSpriteCacheMemoryUsage(&sprites_allocated, &sprites_in_use);
+
+	total += PrintUsage("map",          GetMapMemoryUsage());
+	total += PrintUsage("sprite cache", sprite_table + sprites_allocated);
+	total += PrintUsage("glyph cache",  GetGlyphCacheMemoryUsage());
+	total += PrintUsage("NewGRFs",      GetNewGRFMemoryUsage());
+	total += PrintUsage("AIs",          GetAIMemoryUsage());
+	total += PrintUsage("saveload",     GetSaveLoadMemoryUsage());
+
+	IConsolePrintF(CC_DEFAULT, "Total: %u KiB; %u KiB of the sprite cache is in use", (uint)(total / 1024), (uint)(sprites_in_use / 1024));
+}
@@ -19,12 +19,16 @@
 #include "economy_func.h"
 #include "date_func.h"
 #include "texteff.hpp"
+#include "viewport_func.h"
 #include "gfx_func.h"
 #include "gamelog.h"
 #include "animated_tile_func.h"
 #include "tilehighlight_func.h"
 #include "network/network_func.h"
 #include "window_func.h"
+#include "road_func.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "pbs.h"
 
 
 extern TileIndex _cur_tileloop_tile;
@@ -103,12 +107,17 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	InitializeBuildingCounts();
 
 	InitializeNPF();
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	YapfNotifyWaterLayoutChange(INVALID_TILE);
+	ForgetRoadLayoutChanges();
+	ClearReservationOwners();
 
 	InitializeCompanies();
 	AI::Initialize();
 	InitializeCheats();
 
 	InitTextEffects();
+	ResetViewportSignIndex();
 #ifdef ENABLE_NETWORK
 	NetworkInitChatMessage();
 #endif /* ENABLE_NETWORK */
@@ -43,6 +43,15 @@ public:
 	FORCEINLINE SmallArray() { }
 	/** Clear (destroy) all items */
 	FORCEINLINE void Clear() {data.Clear();}
+	/** Destroy all items, but keep the first block of memory for reuse */
+	FORCEINLINE void Reset()
+	{
+		if (data.Length() > 1) {
+			data.Clear();
+		} else if (!data.IsEmpty()) {
+			data[0].Clear();
+		}
+	}
 	/** Return actual number of items */
 	FORCEINLINE uint Length() const
 	{
@@ -62,7 +71,7 @@ public:
 	/** indexed access (non-const) */
 	FORCEINLINE T& operator [] (uint index)
 	{
-		const SubArray& s = data[index / B];
+		SubArray& s = data[index / B];
 		T& item = s[index % B];
 		return item;
 	}
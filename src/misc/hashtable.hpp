@@ -177,6 +177,15 @@ public:
 	/** simple clear - forget all items - used by CSegmentCostCacheT.Flush() */
 	FORCEINLINE void Clear() const {for (int i = 0; i < Tcapacity; i++) m_slots[i].Clear();}
 
+	/** forget all items by clearing only the slots of the given items, which
+	 *  must include all items in the table - cheaper than Clear() for a big,
+	 *  sparsely filled table */
+	template <class Tarray> FORCEINLINE void ClearItems(Tarray& items)
+	{
+		for (uint i = 0; i < items.Length(); i++) m_slots[CalcHash(items[i])].Clear();
+		m_num_items = 0;
+	}
+
 	/** const item search */
 	const Titem_ *Find(const Tkey& key) const
 	{
@@ -756,9 +756,24 @@ void ShowEstimatedCostOrIncome(Money cost, int x, int y)
 	ShowErrorMessage(msg, INVALID_STRING_ID, WL_INFO, x, y);
 }
 
+/**
+ * Whether a rising cost or income text at the given position is worth
+ * showing. In the minimal presentation mode the money of the competitors
+ * is not shown, nor is anything that no viewport shows.
+ * @param pt The position of the text in virtual coordinates.
+ * @return true iff the text should be shown.
+ */
+static bool IsMoneyAnimationShown(Point pt)
+{
+	if (!_settings_client.gui.minimal_presentation) return true;
+	return IsLocalCompany() && IsPtInAnyViewport(pt.x, pt.y);
+}
+
 void ShowCostOrIncomeAnimation(int x, int y, int z, Money cost)
 {
 	Point pt = RemapCoords(x, y, z);
+	if (!IsMoneyAnimationShown(pt)) return;
+
 	StringID msg = STR_INCOME_FLOAT_COST;
 
 	if (cost < 0) {
@@ -772,6 +787,7 @@ void ShowCostOrIncomeAnimation(int x, int y, int z, Money cost)
 void ShowFeederIncomeAnimation(int x, int y, int z, Money cost)
 {
 	Point pt = RemapCoords(x, y, z);
+	if (!IsMoneyAnimationShown(pt)) return;
 
 	SetDParam(0, cost);
 	AddTextEffect(STR_FEEDER, pt.x, pt.y, DAY_TICKS, TE_RISING);
@@ -783,6 +799,9 @@ TextEffectID ShowFillingPercent(int x, int y, int z, uint8 percent, StringID str
 
 	assert(string != STR_NULL);
 
+	/* The indicator is tried again the next time the vehicle loads, so it appears once it comes in sight. */
+	if (_settings_client.gui.minimal_presentation && !IsPtInAnyViewport(pt.x, pt.y)) return INVALID_TE_ID;
+
 	SetDParam(0, percent);
 	return AddTextEffect(string, pt.x, pt.y, 0, TE_STATIC);
 }
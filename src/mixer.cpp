@@ -12,6 +12,14 @@
 #include "stdafx.h"
 #include <math.h>
 #include "core/math_func.hpp"
+#include "core/alloc_func.hpp"
+#include "mixer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	/* Mix with SSE2 when the compiler may use it for every processor the binary runs on. */
+#	define WITH_SSE2_MIXER
+#	include <emmintrin.h>
+#endif
 
 struct MixerChannel {
 	bool active;
@@ -35,6 +43,8 @@ struct MixerChannel {
 static MixerChannel _channels[8];
 static uint32 _play_rate = 11025;
 static uint32 _max_size = UINT_MAX;
+static bool _mixer_initialized = false;        ///< Whether a sound driver is mixing the sounds.
+static MxStreamCallback *_music_stream = NULL; ///< The function that provides the music, if any.
 
 /**
  * The theoretical maximum volume for a single sound sample. Multiple sound
@@ -57,49 +67,89 @@ static int RateConversion(T *b, int frac_pos)
 	return ((b[0] * ((1 << 16) - frac_pos)) + (b[1] * frac_pos)) >> 16;
 }
 
-static void mix_int16(MixerChannel *sc, int16 *buffer, uint samples)
+#if defined(WITH_SSE2_MIXER)
+/**
+ * Mix samples that play at the rate of the output, eight at a time.
+ * @param b      the samples, sign extended to 16 bits
+ * @param buffer the stereo buffer to add the samples to
+ * @param volume_left  the volume of the left channel, at most INT16_MAX
+ * @param volume_right the volume of the right channel, at most INT16_MAX
+ * @param shift  the number of bits to shift the product of sample and volume with
+ */
+static FORCEINLINE void MixEightSamples(__m128i b, int32 *buffer, __m128i volume_left, __m128i volume_right, __m128i shift)
 {
-	if (samples > sc->samples_left) samples = sc->samples_left;
-	sc->samples_left -= samples;
-	assert(samples > 0);
-
-	const int16 *b = (const int16 *)sc->memory + sc->pos;
-	uint32 frac_pos = sc->frac_pos;
-	uint32 frac_speed = sc->frac_speed;
-	int volume_left = sc->volume_left;
-	int volume_right = sc->volume_right;
+	/* 16 x 16 bits multiplications, of which the halves are joined to 32 bits. */
+	__m128i lo = _mm_mullo_epi16(b, volume_left);
+	__m128i hi = _mm_mulhi_epi16(b, volume_left);
+	__m128i left_0 = _mm_sra_epi32(_mm_unpacklo_epi16(lo, hi), shift);
+	__m128i left_1 = _mm_sra_epi32(_mm_unpackhi_epi16(lo, hi), shift);
+
+	lo = _mm_mullo_epi16(b, volume_right);
+	hi = _mm_mulhi_epi16(b, volume_right);
+	__m128i right_0 = _mm_sra_epi32(_mm_unpacklo_epi16(lo, hi), shift);
+	__m128i right_1 = _mm_sra_epi32(_mm_unpackhi_epi16(lo, hi), shift);
+
+	/* Interleave the channels to left, right, left, right... */
+	__m128i *out = (__m128i *)buffer;
+	_mm_storeu_si128(out + 0, _mm_add_epi32(_mm_loadu_si128(out + 0), _mm_unpacklo_epi32(left_0, right_0)));
+	_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi32(left_0, right_0)));
+	_mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi32(left_1, right_1)));
+	_mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi32(left_1, right_1)));
+}
 
-	if (frac_speed == 0x10000) {
-		/* Special case when frac_speed is 0x10000 */
-		do {
-			buffer[0] = Clamp(buffer[0] + (*b * volume_left  >> 16), -MAX_VOLUME, MAX_VOLUME);
-			buffer[1] = Clamp(buffer[1] + (*b * volume_right >> 16), -MAX_VOLUME, MAX_VOLUME);
-			b++;
-			buffer += 2;
-		} while (--samples > 0);
-	} else {
-		do {
-			int data = RateConversion(b, frac_pos);
-			buffer[0] = Clamp(buffer[0] + (data * volume_left  >> 16), -MAX_VOLUME, MAX_VOLUME);
-			buffer[1] = Clamp(buffer[1] + (data * volume_right >> 16), -MAX_VOLUME, MAX_VOLUME);
-			buffer += 2;
-			frac_pos += frac_speed;
-			b += frac_pos >> 16;
-			frac_pos &= 0xffff;
-		} while (--samples > 0);
+/**
+ * Mix the samples of a channel that plays at the rate of the output, as
+ * far as possible eight samples at a time.
+ * @param b       the samples
+ * @param buffer  the stereo buffer to add the samples to
+ * @param samples the number of samples to mix
+ * @param volume_left  the volume of the left channel
+ * @param volume_right the volume of the right channel
+ * @tparam T the type of the samples (8 or 16 bits)
+ * @return the number of samples that are mixed; the rest has to be mixed one by one
+ */
+template <typename T>
+static uint MixSamplesVector(const T *b, int32 *buffer, uint samples, int volume_left, int volume_right)
+{
+	if (volume_left > INT16_MAX || volume_right > INT16_MAX) return 0;
+
+	__m128i vl = _mm_set1_epi16((int16)volume_left);
+	__m128i vr = _mm_set1_epi16((int16)volume_right);
+	__m128i shift = _mm_cvtsi32_si128(sizeof(T) == 1 ? 8 : 16);
+
+	uint done = 0;
+	for (; done + 8 <= samples; done += 8, b += 8, buffer += 16) {
+		__m128i s;
+		if (sizeof(T) == 1) {
+			/* Sign extend the bytes by putting them in the high half of each
+			 * word and shifting them back. */
+			s = _mm_loadl_epi64((const __m128i *)b);
+			s = _mm_srai_epi16(_mm_unpacklo_epi8(s, s), 8);
+		} else {
+			s = _mm_loadu_si128((const __m128i *)b);
+		}
+		MixEightSamples(s, buffer, vl, vr, shift);
 	}
-
-	sc->frac_pos = frac_pos;
-	sc->pos = b - (const int16 *)sc->memory;
+	return done;
 }
+#endif /* WITH_SSE2_MIXER */
 
-static void mix_int8_to_int16(MixerChannel *sc, int16 *buffer, uint samples)
+/**
+ * Mix the samples of a channel into the buffer.
+ * @param sc      the channel to mix
+ * @param buffer  the stereo buffer to add the samples to
+ * @param samples the number of samples to mix
+ * @tparam T     the type of the samples (8 or 16 bits)
+ * @tparam Tshift the number of bits to shift the product of sample and volume with
+ */
+template <typename T, int Tshift>
+static void MixChannel(MixerChannel *sc, int32 *buffer, uint samples)
 {
 	if (samples > sc->samples_left) samples = sc->samples_left;
 	sc->samples_left -= samples;
 	assert(samples > 0);
 
-	const int8 *b = sc->memory + sc->pos;
+	const T *b = (const T *)sc->memory + sc->pos;
 	uint32 frac_pos = sc->frac_pos;
 	uint32 frac_speed = sc->frac_speed;
 	int volume_left = sc->volume_left;
@@ -107,17 +157,23 @@ static void mix_int8_to_int16(MixerChannel *sc, int16 *buffer, uint samples)
 
 	if (frac_speed == 0x10000) {
 		/* Special case when frac_speed is 0x10000 */
-		do {
-			buffer[0] = Clamp(buffer[0] + (*b * volume_left  >> 8), -MAX_VOLUME, MAX_VOLUME);
-			buffer[1] = Clamp(buffer[1] + (*b * volume_right >> 8), -MAX_VOLUME, MAX_VOLUME);
+#if defined(WITH_SSE2_MIXER)
+		uint done = MixSamplesVector(b, buffer, samples, volume_left, volume_right);
+		b += done;
+		buffer += 2 * done;
+		samples -= done;
+#endif
+		for (; samples > 0; samples--) {
+			buffer[0] += *b * volume_left  >> Tshift;
+			buffer[1] += *b * volume_right >> Tshift;
 			b++;
 			buffer += 2;
-		} while (--samples > 0);
+		}
 	} else {
 		do {
 			int data = RateConversion(b, frac_pos);
-			buffer[0] = Clamp(buffer[0] + (data * volume_left  >> 8), -MAX_VOLUME, MAX_VOLUME);
-			buffer[1] = Clamp(buffer[1] + (data * volume_right >> 8), -MAX_VOLUME, MAX_VOLUME);
+			buffer[0] += data * volume_left  >> Tshift;
+			buffer[1] += data * volume_right >> Tshift;
 			buffer += 2;
 			frac_pos += frac_speed;
 			b += frac_pos >> 16;
@@ -126,7 +182,7 @@ static void mix_int8_to_int16(MixerChannel *sc, int16 *buffer, uint samples)
 	}
 
 	sc->frac_pos = frac_pos;
-	sc->pos = b - sc->memory;
+	sc->pos = b - (const T *)sc->memory;
 }
 
 static void MxCloseChannel(MixerChannel *mc)
@@ -134,24 +190,63 @@ static void MxCloseChannel(MixerChannel *mc)
 	mc->active = false;
 }
 
+/**
+ * Mix the active channels into the buffer of the sound driver.
+ * @param buffer  the stereo buffer with 16 bits samples to fill
+ * @param samples the number of samples to fill the buffer with
+ */
 void MxMixSamples(void *buffer, uint samples)
 {
-	MixerChannel *mc;
-
-	/* Clear the buffer */
-	memset(buffer, 0, sizeof(int16) * 2 * samples);
+	/* The channels are added up in 32 bits and only clamped at the end,
+	 * so the order of the channels doesn't matter and nothing overflows. */
+	static int32 *mix_buffer = NULL;
+	static uint mix_buffer_samples = 0;
+	if (samples > mix_buffer_samples) {
+		mix_buffer_samples = samples;
+		free(mix_buffer);
+		mix_buffer = MallocT<int32>(2 * samples);
+	}
+	memset(mix_buffer, 0, sizeof(int32) * 2 * samples);
 
 	/* Mix each channel */
-	for (mc = _channels; mc != endof(_channels); mc++) {
+	for (MixerChannel *mc = _channels; mc != endof(_channels); mc++) {
 		if (mc->active) {
 			if (mc->is16bit) {
-				mix_int16(mc, (int16*)buffer, samples);
+				MixChannel<int16, 16>(mc, mix_buffer, samples);
 			} else {
-				mix_int8_to_int16(mc, (int16*)buffer, samples);
+				MixChannel<int8, 8>(mc, mix_buffer, samples);
 			}
 			if (mc->samples_left == 0) MxCloseChannel(mc);
 		}
 	}
+
+	/* The music is at full volume; the sounds only go up to MAX_VOLUME. */
+	MxStreamCallback *music_stream = _music_stream;
+	if (music_stream != NULL) {
+		static int16 *music_buffer = NULL;
+		static uint music_buffer_samples = 0;
+		if (samples > music_buffer_samples) {
+			music_buffer_samples = samples;
+			free(music_buffer);
+			music_buffer = MallocT<int16>(2 * samples);
+		}
+		music_stream(music_buffer, samples);
+		for (uint i = 0; i < 2 * samples; i++) mix_buffer[i] += music_buffer[i] / 2;
+	}
+
+	int16 *out = (int16 *)buffer;
+	uint i = 0;
+#if defined(WITH_SSE2_MIXER)
+	/* MAX_VOLUME fits in 16 bits, so saturating to 16 bits first doesn't change the outcome. */
+	const __m128i max_volume = _mm_set1_epi16(MAX_VOLUME);
+	const __m128i min_volume = _mm_set1_epi16(-MAX_VOLUME);
+	for (; i + 8 <= 2 * samples; i += 8) {
+		__m128i s = _mm_packs_epi32(_mm_loadu_si128((const __m128i *)(mix_buffer + i)), _mm_loadu_si128((const __m128i *)(mix_buffer + i + 4)));
+		s = _mm_max_epi16(_mm_min_epi16(s, max_volume), min_volume);
+		_mm_storeu_si128((__m128i *)(out + i), s);
+	}
+#endif
+	for (; i < 2 * samples; i++) out[i] = Clamp(mix_buffer[i], -MAX_VOLUME, MAX_VOLUME);
 }
 
 MixerChannel *MxAllocateChannel()
@@ -211,5 +306,25 @@ bool MxInitialize(uint rate)
 {
 	_play_rate = rate;
 	_max_size  = UINT_MAX / _play_rate;
+	_mixer_initialized = true;
 	return true;
 }
+
+/**
+ * Get the rate the sound driver plays at.
+ * @return The samples per second, or 0 when no sound driver uses the mixer.
+ */
+uint MxGetRate()
+{
+	return _mixer_initialized ? _play_rate : 0;
+}
+
+/**
+ * Set the function that provides the music to mix with the sounds. It is
+ * called from the thread of the sound driver, so it must not wait long.
+ * @param music_callback The function, or NULL to stop mixing music.
+ */
+void MxSetMusicSource(MxStreamCallback *music_callback)
+{
+	_music_stream = music_callback;
+}
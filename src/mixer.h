@@ -14,8 +14,17 @@
 
 struct MixerChannel;
 
+/**
+ * Type of the function that provides the music to mix with the sounds.
+ * @param buffer  The buffer to fill with 16 bits stereo samples.
+ * @param samples The number of samples to fill.
+ */
+typedef void MxStreamCallback(int16 *buffer, uint samples);
+
 bool MxInitialize(uint rate);
+uint MxGetRate();
 void MxMixSamples(void *buffer, uint samples);
+void MxSetMusicSource(MxStreamCallback *music_callback);
 
 MixerChannel *MxAllocateChannel();
 void MxSetChannelRawSrc(MixerChannel *mc, int8 *mem, size_t size, uint rate, bool is16bit);
@@ -13,6 +13,10 @@
 #include "../openttd.h"
 #include "../sound_type.h"
 #include "../debug.h"
+#include "../mixer.h"
+#include "../string_func.h"
+#include "../core/math_func.hpp"
+#include "../thread/thread.h"
 #include "libtimidity.h"
 #include <fcntl.h>
 #include <sys/types.h>
@@ -26,28 +30,226 @@
 #include <pspaudiolib.h>
 #endif /* PSP */
 
-enum MidiState {
-	MIDI_STOPPED = 0,
-	MIDI_PLAYING = 1,
-};
+/** The number of frames rendered at once. */
+static const uint MIDI_RENDER_FRAMES = 4096;
+/** The number of frames that are rendered ahead of what is played. */
+static const uint MIDI_RING_FRAMES = 4 * MIDI_RENDER_FRAMES;
 
+/**
+ * The state of the driver. Loading and rendering songs takes long, so it is
+ * done by a thread of its own: the other threads only ask it to, and the
+ * sound driver plays what it has rendered into the ring buffer. The songs
+ * themselves are only used by that thread, so it does not have to hold the
+ * mutex while loading or rendering them.
+ */
 static struct {
-	MidIStream *stream;
 	MidSongOptions options;
-	MidSong *song;
 
-	MidiState status;
-	uint32 song_length;
-	uint32 song_position;
+	ThreadMutex *mutex;    ///< Guards the state shared between the threads.
+	ThreadObject *thread;  ///< The thread loading and rendering the songs, or NULL if everything is done inline.
+	bool exit;             ///< Whether the thread is asked to stop.
+
+	MidSong *song;         ///< The song being rendered.
+	MidSong *next_song;    ///< The song loaded beforehand, as it is likely played next.
+	char play_file[MAX_PATH]; ///< The file of the song to play, or empty to stop playing.
+	char next_file[MAX_PATH]; ///< The file of #next_song.
+	bool play_request;     ///< Whether #play_file has to be loaded or stopped.
+	bool prepare_request;  ///< Whether #next_file has to be loaded.
+	bool loading;          ///< Whether #play_file is being loaded.
+	bool playing;          ///< Whether a song is loading, being rendered, or still in the ring buffer.
+	byte volume;           ///< The volume to play at, 0..127.
+
+	int16 ring[2 * MIDI_RING_FRAMES]; ///< The rendered frames that wait to be played.
+	uint ring_read;        ///< The first frame in the ring buffer to play.
+	uint ring_fill;        ///< The number of frames in the ring buffer.
 } _midi;
 
+/**
+ * Load a song and prepare it for rendering.
+ * @param filename The file to load.
+ * @return The song, or NULL when it could not be loaded.
+ */
+static MidSong *LoadSong(const char *filename)
+{
+	MidIStream *stream = mid_istream_open_file(filename);
+	if (stream == NULL) {
+		DEBUG(driver, 0, "Could not open music file");
+		return NULL;
+	}
+
+	MidSong *song = mid_song_load(stream, &_midi.options);
+	mid_istream_close(stream);
+
+	if (song == NULL) {
+		DEBUG(driver, 1, "Invalid MIDI file");
+		return NULL;
+	}
+
+	mid_song_start(song);
+	return song;
+}
+
+/**
+ * Do the next thing that has to be done: switch the song, load the next song
+ * or render a piece of the song. The mutex is released while doing so.
+ * @return False if there was nothing to do.
+ * @pre The mutex is held.
+ */
+static bool MidiWork()
+{
+	if (_midi.play_request) {
+		_midi.play_request = false;
+
+		char file[MAX_PATH];
+		strecpy(file, _midi.play_file, lastof(file));
+		MidSong *old = _midi.song;
+		_midi.song = NULL;
+
+		MidSong *song = NULL;
+		if (!StrEmpty(file) && _midi.next_song != NULL && strcmp(file, _midi.next_file) == 0) {
+			song = _midi.next_song;
+			_midi.next_song = NULL;
+			_midi.next_file[0] = '\0';
+		}
+
+		_midi.loading = true;
+		_midi.mutex->EndCritical();
+		/* mid_song_free cannot handle NULL! */
+		if (old != NULL) mid_song_free(old);
+		if (song == NULL && !StrEmpty(file)) song = LoadSong(file);
+		_midi.mutex->BeginCritical();
+		_midi.loading = false;
+
+		if (_midi.play_request) {
+			/* Another song was asked for in the meantime. */
+			if (song != NULL) mid_song_free(song);
+			return true;
+		}
+
+		_midi.song = song;
+		if (song == NULL) _midi.playing = false;
+		return true;
+	}
+
+	if (_midi.prepare_request) {
+		_midi.prepare_request = false;
+
+		char file[MAX_PATH];
+		strecpy(file, _midi.next_file, lastof(file));
+		MidSong *old = _midi.next_song;
+		_midi.next_song = NULL;
+
+		_midi.mutex->EndCritical();
+		if (old != NULL) mid_song_free(old);
+		MidSong *song = LoadSong(file);
+		_midi.mutex->BeginCritical();
+
+		if (_midi.prepare_request) {
+			if (song != NULL) mid_song_free(song);
+			return true;
+		}
+
+		_midi.next_song = song;
+		return true;
+	}
+
+	if (_midi.song != NULL && MIDI_RING_FRAMES - _midi.ring_fill >= MIDI_RENDER_FRAMES) {
+		static int16 buffer[2 * MIDI_RENDER_FRAMES];
+
+		MidSong *song = _midi.song;
+		_midi.mutex->EndCritical();
+		uint frames = (uint)mid_song_read_wave(song, (sint8 *)buffer, sizeof(buffer)) / (2 * sizeof(*buffer));
+		_midi.mutex->BeginCritical();
+
+		/* When another song was asked for what has been rendered is not wanted anymore. */
+		if (_midi.play_request) return true;
+
+		if (frames == 0) {
+			/* The end of the song; it stops playing when the ring buffer is empty. */
+			mid_song_free(_midi.song);
+			_midi.song = NULL;
+			if (_midi.ring_fill == 0) _midi.playing = false;
+			return true;
+		}
+
+		uint write = (_midi.ring_read + _midi.ring_fill) % MIDI_RING_FRAMES;
+		for (uint i = 0; i < frames; i++) {
+			_midi.ring[2 * write]     = buffer[2 * i];
+			_midi.ring[2 * write + 1] = buffer[2 * i + 1];
+			if (++write == MIDI_RING_FRAMES) write = 0;
+		}
+		_midi.ring_fill += frames;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * The thread that loads and renders the songs.
+ * @param param Unused.
+ */
+static void MidiThread(void *param)
+{
+	_midi.mutex->BeginCritical();
+	while (!_midi.exit) {
+		if (!MidiWork()) _midi.mutex->WaitForSignal();
+	}
+	_midi.mutex->EndCritical();
+}
+
+/**
+ * Let the work asked for be done.
+ * @pre The mutex is held.
+ */
+static void MidiWakeUp()
+{
+	if (_midi.thread != NULL) {
+		_midi.mutex->SendSignal();
+	} else {
+		while (MidiWork()) {}
+	}
+}
+
+/** Forget everything that has been rendered. */
+static void MidiClearRing()
+{
+	_midi.ring_read = 0;
+	_midi.ring_fill = 0;
+}
+
+/**
+ * Fill a buffer with the rendered song.
+ * @param buffer  The buffer to fill with 16 bits stereo frames.
+ * @param samples The number of frames to fill.
+ */
+static void MidiFillBuffer(int16 *buffer, uint samples)
+{
+	_midi.mutex->BeginCritical();
+
+	uint done = 0;
+	while (done < samples && _midi.ring_fill > 0) {
+		uint n = min(samples - done, min(_midi.ring_fill, MIDI_RING_FRAMES - _midi.ring_read));
+		const int16 *src = &_midi.ring[2 * _midi.ring_read];
+		for (uint i = 0; i < 2 * n; i++) buffer[2 * done + i] = src[i] * _midi.volume / 127;
+
+		done += n;
+		_midi.ring_fill -= n;
+		_midi.ring_read = (_midi.ring_read + n) % MIDI_RING_FRAMES;
+	}
+	if (done < samples) memset(buffer + 2 * done, 0, (samples - done) * 2 * sizeof(*buffer));
+
+	if (_midi.song == NULL && _midi.ring_fill == 0 && !_midi.play_request && !_midi.loading) _midi.playing = false;
+
+	/* There is room in the ring buffer again. */
+	if (_midi.thread != NULL) _midi.mutex->SendSignal();
+	_midi.mutex->EndCritical();
+}
+
 #if defined(PSP)
 static void AudioOutCallback(void *buf, unsigned int _reqn, void *userdata)
 {
-	memset(buf, 0, _reqn * PSP_NUM_AUDIO_CHANNELS);
-	if (_midi.status == MIDI_PLAYING) {
-		mid_song_read_wave(_midi.song, buf, _reqn * PSP_NUM_AUDIO_CHANNELS);
-	}
+	MidiFillBuffer((int16 *)buf, _reqn);
 }
 #endif /* PSP */
 
@@ -55,8 +257,13 @@ static FMusicDriver_LibTimidity iFMusicDriver_LibTimidity;
 
 const char *MusicDriver_LibTimidity::Start(const char * const *param)
 {
-	_midi.status = MIDI_STOPPED;
-	_midi.song = NULL;
+#if defined(PSP)
+	_midi.options.rate = 44100;
+#else
+	/* The songs are played by the mixer of the sound driver, so they have to be rendered at its rate. */
+	_midi.options.rate = MxGetRate();
+	if (_midi.options.rate == 0) return "no sound driver to play the music with";
+#endif
 
 	if (mid_init(param == NULL ? NULL : const_cast<char *>(param[0])) < 0) {
 		/* If init fails, it can be because no configuration was found.
@@ -68,19 +275,38 @@ const char *MusicDriver_LibTimidity::Start(const char * const *param)
 	}
 	DEBUG(driver, 1, "successfully initialised timidity");
 
-	_midi.options.rate = 44100;
 	_midi.options.format = MID_AUDIO_S16LSB;
 	_midi.options.channels = 2;
 #if defined(PSP)
 	_midi.options.buffer_size = PSP_NUM_AUDIO_SAMPLES;
 #else
-	_midi.options.buffer_size = _midi.options.rate;
+	_midi.options.buffer_size = MIDI_RENDER_FRAMES;
 #endif
 
+	_midi.song = NULL;
+	_midi.next_song = NULL;
+	_midi.play_file[0] = '\0';
+	_midi.next_file[0] = '\0';
+	_midi.play_request = false;
+	_midi.prepare_request = false;
+	_midi.loading = false;
+	_midi.playing = false;
+	_midi.volume = 127;
+	_midi.exit = false;
+	MidiClearRing();
+
+	_midi.mutex = ThreadMutex::New();
+	if (!ThreadObject::New(&MidiThread, NULL, &_midi.thread)) {
+		_midi.thread = NULL;
+		DEBUG(driver, 1, "timidity: no thread to render the music with, rendering inline");
+	}
+
 #if defined(PSP)
 	pspAudioInit();
 	pspAudioSetChannelCallback(_midi.options.channels, &AudioOutCallback, NULL);
 	pspAudioSetVolume(_midi.options.channels, PSP_VOLUME_MAX, PSP_VOLUME_MAX);
+#else
+	MxSetMusicSource(&MidiFillBuffer);
 #endif /* PSP */
 
 	return NULL;
@@ -88,55 +314,75 @@ const char *MusicDriver_LibTimidity::Start(const char * const *param)
 
 void MusicDriver_LibTimidity::Stop()
 {
-	if (_midi.status == MIDI_PLAYING) this->StopSong();
-	mid_exit();
-}
+#if !defined(PSP)
+	MxSetMusicSource(NULL);
+#endif
 
-void MusicDriver_LibTimidity::PlaySong(const char *filename)
-{
-	this->StopSong();
+	_midi.mutex->BeginCritical();
+	_midi.exit = true;
+	_midi.mutex->SendSignal();
+	_midi.mutex->EndCritical();
 
-	_midi.stream = mid_istream_open_file(filename);
-	if (_midi.stream == NULL) {
-		DEBUG(driver, 0, "Could not open music file");
-		return;
+	if (_midi.thread != NULL) {
+		_midi.thread->Join();
+		delete _midi.thread;
+		_midi.thread = NULL;
 	}
 
-	_midi.song = mid_song_load(_midi.stream, &_midi.options);
-	mid_istream_close(_midi.stream);
-	_midi.song_length = mid_song_get_total_time(_midi.song);
+	if (_midi.song != NULL) mid_song_free(_midi.song);
+	if (_midi.next_song != NULL) mid_song_free(_midi.next_song);
+	_midi.song = NULL;
+	_midi.next_song = NULL;
+	delete _midi.mutex;
+	_midi.mutex = NULL;
 
-	if (_midi.song == NULL) {
-		DEBUG(driver, 1, "Invalid MIDI file");
-		return;
-	}
+	mid_exit();
+}
 
-	mid_song_start(_midi.song);
-	_midi.status = MIDI_PLAYING;
+void MusicDriver_LibTimidity::PlaySong(const char *filename)
+{
+	_midi.mutex->BeginCritical();
+	strecpy(_midi.play_file, filename, lastof(_midi.play_file));
+	_midi.play_request = true;
+	_midi.playing = true;
+	MidiClearRing();
+	MidiWakeUp();
+	_midi.mutex->EndCritical();
 }
 
 void MusicDriver_LibTimidity::StopSong()
 {
-	_midi.status = MIDI_STOPPED;
-	/* mid_song_free cannot handle NULL! */
-	if (_midi.song != NULL) mid_song_free(_midi.song);
-	_midi.song = NULL;
+	_midi.mutex->BeginCritical();
+	_midi.play_file[0] = '\0';
+	_midi.play_request = true;
+	_midi.playing = false;
+	MidiClearRing();
+	MidiWakeUp();
+	_midi.mutex->EndCritical();
 }
 
-bool MusicDriver_LibTimidity::IsSongPlaying()
+void MusicDriver_LibTimidity::PrepareSong(const char *filename)
 {
-	if (_midi.status == MIDI_PLAYING) {
-		_midi.song_position = mid_song_get_time(_midi.song);
-		if (_midi.song_position >= _midi.song_length) {
-			_midi.status = MIDI_STOPPED;
-			_midi.song_position = 0;
-		}
+	_midi.mutex->BeginCritical();
+	if (strcmp(filename, _midi.next_file) != 0) {
+		strecpy(_midi.next_file, filename, lastof(_midi.next_file));
+		_midi.prepare_request = true;
+		MidiWakeUp();
 	}
+	_midi.mutex->EndCritical();
+}
 
-	return (_midi.status == MIDI_PLAYING);
+bool MusicDriver_LibTimidity::IsSongPlaying()
+{
+	_midi.mutex->BeginCritical();
+	/* Without thread whatever has to be rendered is rendered now. */
+	if (_midi.thread == NULL) MidiWakeUp();
+	bool playing = _midi.playing;
+	_midi.mutex->EndCritical();
+	return playing;
 }
 
 void MusicDriver_LibTimidity::SetVolume(byte vol)
 {
-	if (_midi.song != NULL) mid_song_set_volume(_midi.song, vol);
+	_midi.volume = min(vol, (byte)127);
 }
@@ -24,6 +24,8 @@ public:
 
 	/* virtual */ void StopSong();
 
+	/* virtual */ void PrepareSong(const char *filename);
+
 	/* virtual */ bool IsSongPlaying();
 
 	/* virtual */ void SetVolume(byte vol);
@@ -20,6 +20,13 @@ public:
 
 	virtual void StopSong() = 0;
 
+	/**
+	 * Tell which song is likely played next, so the driver can load it
+	 * beforehand and switch to it without a gap.
+	 * @param filename The file of the song.
+	 */
+	virtual void PrepareSong(const char *filename) {}
+
 	virtual bool IsSongPlaying() = 0;
 
 	virtual void SetVolume(byte vol) = 0;
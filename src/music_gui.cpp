@@ -169,15 +169,36 @@ static void MusicVolumeChanged(byte new_vol)
 	_music_driver->SetVolume(new_vol);
 }
 
+/**
+ * Get the full path of the file of a song.
+ * @param song     The song, 1 based.
+ * @param filename The buffer for the path.
+ * @param last     The last character of the buffer.
+ */
+static void GetSongFilename(byte song, char *filename, const char *last)
+{
+	FioFindFullPath(filename, last - filename + 1, GM_DIR, BaseMusic::GetUsedSet()->files[song - 1].filename);
+}
+
 static void DoPlaySong()
 {
 	char filename[MAX_PATH];
-	FioFindFullPath(filename, lengthof(filename), GM_DIR,
-			BaseMusic::GetUsedSet()->files[_music_wnd_cursong - 1].filename);
+	GetSongFilename(_music_wnd_cursong, filename, lastof(filename));
 	_music_driver->PlaySong(filename);
 	SetWindowDirty(WC_MUSIC_WINDOW, 0);
 }
 
+/** Let the music driver load the song that follows in the playlist already. */
+static void PrepareNextSong()
+{
+	byte next = _cur_playlist[1] != 0 ? _cur_playlist[1] : _cur_playlist[0];
+	if (next == 0 || next == _music_wnd_cursong) return;
+
+	char filename[MAX_PATH];
+	GetSongFilename(next, filename, lastof(filename));
+	_music_driver->PrepareSong(filename);
+}
+
 static void DoStopMusic()
 {
 	_music_driver->StopSong();
@@ -241,6 +262,7 @@ static void PlayPlaylistSong()
 	}
 	_music_wnd_cursong = _cur_playlist[0];
 	DoPlaySong();
+	PrepareNextSong();
 	_song_is_active = true;
 
 	SetWindowWidgetDirty(WC_MUSIC_WINDOW, 0, 9);
@@ -15,9 +15,51 @@
 
 #include "../../stdafx.h"
 #include "../../string_func.h"
+#include "../../core/alloc_func.hpp"
 
 #include "packet.h"
 
+/** Maximum number of deleted packets that are kept to be used again. */
+static const uint MAX_FREE_PACKETS = 256;
+
+static Packet *_free_packets = NULL; ///< The deleted packets, linked by their next pointer.
+static uint _free_packet_count = 0;  ///< The number of packets in #_free_packets.
+
+/**
+ * Allocate the memory for a packet; that of a deleted packet when there is one.
+ * Packets are only made and deleted by the main thread.
+ * @param size the size of a packet
+ * @return the memory
+ */
+void *Packet::operator new(size_t size)
+{
+	assert(size == sizeof(Packet));
+	if (_free_packets == NULL) return MallocT<byte>(size);
+
+	Packet *p = _free_packets;
+	_free_packets = p->next;
+	_free_packet_count--;
+	return p;
+}
+
+/**
+ * Keep the memory of a deleted packet to be used again, unless there are enough of those already.
+ * @param p the memory of the packet
+ */
+void Packet::operator delete(void *p)
+{
+	if (p == NULL) return;
+	if (_free_packet_count >= MAX_FREE_PACKETS) {
+		free(p);
+		return;
+	}
+
+	Packet *packet = (Packet *)p;
+	packet->next = _free_packets;
+	_free_packets = packet;
+	_free_packet_count++;
+}
+
 /**
  * Create a packet that is used to read from a network socket
  * @param cs the socket handler associated with the socket we are reading from
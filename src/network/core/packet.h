@@ -49,6 +49,9 @@ public:
 	Packet(NetworkSocketHandler *cs);
 	Packet(PacketType type);
 
+	void *operator new(size_t size);
+	void operator delete(void *p);
+
 	/* Sending/writing of packets */
 	void PrepareToSend();
 
@@ -0,0 +1,366 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file poller.cpp Waiting for many sockets at once, without looking at the sockets that aren't ready.
+ */
+
+#ifdef ENABLE_NETWORK
+
+#include "../../stdafx.h"
+#include "../../debug.h"
+#include "../../core/alloc_func.hpp"
+#include "poller.h"
+
+#if defined(__linux__)
+#	define WITH_EPOLL
+#	include <sys/epoll.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__) || defined(__DragonFly__)
+#	define WITH_KQUEUE
+#	include <sys/types.h>
+#	include <sys/event.h>
+#	if defined(__NetBSD__)
+#		define KEVENT_UDATA(id) ((intptr_t)(id))
+#	else
+#		define KEVENT_UDATA(id) ((void *)(size_t)(id))
+#	endif
+#elif defined(WIN32)
+#	define WITH_WSAPOLL
+
+/** Our own copy of WSAPOLLFD, as the headers only have it when compiling for Vista and later. */
+struct PollFd {
+	SOCKET fd;     ///< The socket.
+	short events;  ///< The events to poll for.
+	short revents; ///< The events that happened.
+};
+
+static const short PFD_POLLERR    = 0x0001; ///< The socket is in error.
+static const short PFD_POLLHUP    = 0x0002; ///< The connection has been closed.
+static const short PFD_POLLWRNORM = 0x0010; ///< The socket can be written to.
+static const short PFD_POLLRDNORM = 0x0100; ///< The socket can be read from.
+
+/** WSAPoll; it is looked up when the program runs, so it still starts on systems before Vista. */
+typedef int (WSAAPI *WSAPollProc)(PollFd *fds, ULONG nfds, INT timeout);
+static WSAPollProc _wsa_poll = NULL;
+#endif
+
+/** The poller for all game sockets. */
+SocketPoller _network_poller;
+
+SocketPoller::SocketPoller() : backend(PB_NONE), fd(-1), count(0), buffer(NULL), buffer_size(0)
+{
+}
+
+SocketPoller::~SocketPoller()
+{
+#if defined(WITH_EPOLL) || defined(WITH_KQUEUE)
+	if (this->fd != -1) close(this->fd);
+#endif
+	free(this->buffer);
+}
+
+/** Decide how to poll; the native way of the system when it works, otherwise select. */
+void SocketPoller::ChooseBackend()
+{
+	static const char * const backend_names[] = { "none", "select", "epoll", "kqueue", "WSAPoll" };
+
+	this->backend = PB_SELECT;
+#if defined(WITH_EPOLL)
+	this->fd = epoll_create(16);
+	if (this->fd != -1) this->backend = PB_EPOLL;
+#elif defined(WITH_KQUEUE)
+	this->fd = kqueue();
+	if (this->fd != -1) this->backend = PB_KQUEUE;
+#elif defined(WITH_WSAPOLL)
+	HMODULE ws2 = GetModuleHandleA("ws2_32.dll");
+	if (ws2 != NULL) _wsa_poll = (WSAPollProc)GetProcAddress(ws2, "WSAPoll");
+	if (_wsa_poll != NULL) this->backend = PB_WSAPOLL;
+#endif
+
+	DEBUG(net, 3, "[core] polling sockets with %s", backend_names[this->backend]);
+}
+
+/**
+ * Find the registration of a socket, for the select and WSAPoll backends.
+ * @param s the socket
+ * @return the registration, or NULL when the socket isn't registered
+ */
+SocketPoller::Registration *SocketPoller::FindRegistration(SOCKET s)
+{
+	for (Registration *r = this->registrations.Begin(); r != this->registrations.End(); r++) {
+		if (r->sock == s) return r;
+	}
+	return NULL;
+}
+
+/**
+ * Get the memory for the events the backend reports.
+ * @param size the number of bytes needed
+ * @return the memory
+ */
+void *SocketPoller::GetBuffer(size_t size)
+{
+	if (size > this->buffer_size) {
+		this->buffer_size = max<size_t>(size, this->buffer_size * 2);
+		this->buffer = ReallocT(this->buffer, this->buffer_size);
+	}
+	return this->buffer;
+}
+
+/**
+ * Start polling a socket. Adding a socket that is registered already changes its registration.
+ * @param s     the socket
+ * @param id    the identifier to report the socket with
+ * @param write whether to poll for writing too
+ */
+void SocketPoller::Add(SOCKET s, uint id, bool write)
+{
+	if (this->backend == PB_NONE) this->ChooseBackend();
+
+	switch (this->backend) {
+#if defined(WITH_EPOLL)
+		case PB_EPOLL: {
+			struct epoll_event ev;
+			ev.events = write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+			ev.data.u64 = (uint64)id << 32 | (uint32)s;
+			if (epoll_ctl(this->fd, EPOLL_CTL_ADD, s, &ev) == 0) {
+				this->count++;
+			} else if (errno != EEXIST || epoll_ctl(this->fd, EPOLL_CTL_MOD, s, &ev) != 0) {
+				DEBUG(net, 0, "[core] epoll_ctl failed with error %d", errno);
+			}
+			return;
+		}
+#endif
+
+#if defined(WITH_KQUEUE)
+		case PB_KQUEUE: {
+			struct kevent ev[2];
+			EV_SET(&ev[0], s, EVFILT_READ, EV_ADD, 0, 0, KEVENT_UDATA(id));
+			EV_SET(&ev[1], s, EVFILT_WRITE, EV_ADD | (write ? EV_ENABLE : EV_DISABLE), 0, 0, KEVENT_UDATA(id));
+			if (kevent(this->fd, ev, 2, NULL, 0, NULL) == -1) {
+				DEBUG(net, 0, "[core] kevent failed with error %d", errno);
+				return;
+			}
+			this->count++;
+			return;
+		}
+#endif
+
+		default: {
+			Registration *r = this->FindRegistration(s);
+			if (r == NULL) {
+				r = this->registrations.Append();
+				r->sock = s;
+				this->count++;
+			}
+			r->id = id;
+			r->write = write;
+			return;
+		}
+	}
+}
+
+/**
+ * Start or stop polling a registered socket for writing.
+ * @param s     the socket
+ * @param id    the identifier the socket is registered with
+ * @param write whether to poll for writing
+ */
+void SocketPoller::SetWriteInterest(SOCKET s, uint id, bool write)
+{
+	switch (this->backend) {
+#if defined(WITH_EPOLL)
+		case PB_EPOLL: {
+			struct epoll_event ev;
+			ev.events = write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+			ev.data.u64 = (uint64)id << 32 | (uint32)s;
+			if (epoll_ctl(this->fd, EPOLL_CTL_MOD, s, &ev) != 0) DEBUG(net, 0, "[core] epoll_ctl failed with error %d", errno);
+			return;
+		}
+#endif
+
+#if defined(WITH_KQUEUE)
+		case PB_KQUEUE: {
+			struct kevent ev;
+			EV_SET(&ev, s, EVFILT_WRITE, write ? EV_ENABLE : EV_DISABLE, 0, 0, KEVENT_UDATA(id));
+			if (kevent(this->fd, &ev, 1, NULL, 0, NULL) == -1) DEBUG(net, 0, "[core] kevent failed with error %d", errno);
+			return;
+		}
+#endif
+
+		default: {
+			Registration *r = this->FindRegistration(s);
+			if (r != NULL) r->write = write;
+			return;
+		}
+	}
+}
+
+/**
+ * Stop polling a socket. This must be done before the socket is closed.
+ * @param s the socket
+ */
+void SocketPoller::Remove(SOCKET s)
+{
+	switch (this->backend) {
+#if defined(WITH_EPOLL)
+		case PB_EPOLL: {
+			/* Kernels before 2.6.9 want an event, even though it isn't used. */
+			struct epoll_event ev;
+			if (epoll_ctl(this->fd, EPOLL_CTL_DEL, s, &ev) == 0) this->count--;
+			return;
+		}
+#endif
+
+#if defined(WITH_KQUEUE)
+		case PB_KQUEUE: {
+			struct kevent ev;
+			EV_SET(&ev, s, EVFILT_WRITE, EV_DELETE, 0, 0, KEVENT_UDATA(0));
+			kevent(this->fd, &ev, 1, NULL, 0, NULL);
+			EV_SET(&ev, s, EVFILT_READ, EV_DELETE, 0, 0, KEVENT_UDATA(0));
+			if (kevent(this->fd, &ev, 1, NULL, 0, NULL) == 0) this->count--;
+			return;
+		}
+#endif
+
+		default: {
+			Registration *r = this->FindRegistration(s);
+			if (r == NULL) return;
+			this->registrations.Erase(r);
+			this->count--;
+			return;
+		}
+	}
+}
+
+/**
+ * Find the ready sockets with select.
+ * @param events  the list to add the ready sockets to
+ * @param timeout the maximum time to wait for a ready socket, in milliseconds
+ */
+void SocketPoller::PollSelect(EventList *events, uint timeout)
+{
+	fd_set read_fd, write_fd;
+	struct timeval tv;
+
+	FD_ZERO(&read_fd);
+	FD_ZERO(&write_fd);
+
+	for (const Registration *r = this->registrations.Begin(); r != this->registrations.End(); r++) {
+		FD_SET(r->sock, &read_fd);
+		if (r->write) FD_SET(r->sock, &write_fd);
+	}
+
+	tv.tv_sec = timeout / 1000;
+	tv.tv_usec = (timeout % 1000) * 1000;
+#if !defined(__MORPHOS__) && !defined(__AMIGA__)
+	int n = select(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv);
+#else
+	int n = WaitSelect(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv, NULL);
+#endif
+	if (n <= 0) return;
+
+	for (const Registration *r = this->registrations.Begin(); r != this->registrations.End(); r++) {
+		bool readable = FD_ISSET(r->sock, &read_fd) != 0;
+		bool writable = FD_ISSET(r->sock, &write_fd) != 0;
+		if (!readable && !writable) continue;
+
+		Event *e = events->Append();
+		e->sock = r->sock;
+		e->id = r->id;
+		e->readable = readable;
+		e->writable = writable;
+	}
+}
+
+/**
+ * Find the ready sockets with the native way of the system.
+ * @param events  the list to add the ready sockets to
+ * @param timeout the maximum time to wait for a ready socket, in milliseconds
+ */
+void SocketPoller::PollNative(EventList *events, uint timeout)
+{
+	switch (this->backend) {
+#if defined(WITH_EPOLL)
+		case PB_EPOLL: {
+			struct epoll_event *ev = (struct epoll_event *)this->GetBuffer(this->count * sizeof(*ev));
+			int n = epoll_wait(this->fd, ev, this->count, timeout);
+			for (int i = 0; i < n; i++) {
+				Event *e = events->Append();
+				e->sock = (SOCKET)(uint32)ev[i].data.u64;
+				e->id = (uint)(ev[i].data.u64 >> 32);
+				e->readable = (ev[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+				e->writable = (ev[i].events & EPOLLOUT) != 0;
+			}
+			return;
+		}
+#endif
+
+#if defined(WITH_KQUEUE)
+		case PB_KQUEUE: {
+			/* A socket can be reported twice, once for reading and once for writing. */
+			struct kevent *ev = (struct kevent *)this->GetBuffer(2 * this->count * sizeof(*ev));
+			struct timespec ts = { (time_t)(timeout / 1000), (long)(timeout % 1000) * 1000000 };
+			int n = kevent(this->fd, NULL, 0, ev, 2 * this->count, &ts);
+			for (int i = 0; i < n; i++) {
+				if (ev[i].flags & EV_ERROR) continue;
+				Event *e = events->Append();
+				e->sock = (SOCKET)ev[i].ident;
+				e->id = (uint)(size_t)ev[i].udata;
+				e->readable = ev[i].filter == EVFILT_READ;
+				e->writable = ev[i].filter == EVFILT_WRITE;
+			}
+			return;
+		}
+#endif
+
+#if defined(WITH_WSAPOLL)
+		case PB_WSAPOLL: {
+			PollFd *fds = (PollFd *)this->GetBuffer(this->count * sizeof(*fds));
+			for (uint i = 0; i < this->count; i++) {
+				fds[i].fd = this->registrations[i].sock;
+				fds[i].events = PFD_POLLRDNORM | (this->registrations[i].write ? PFD_POLLWRNORM : 0);
+				fds[i].revents = 0;
+			}
+			if (_wsa_poll(fds, this->count, timeout) <= 0) return;
+			for (uint i = 0; i < this->count; i++) {
+				if (fds[i].revents == 0) continue;
+				Event *e = events->Append();
+				e->sock = fds[i].fd;
+				e->id = this->registrations[i].id;
+				e->readable = (fds[i].revents & (PFD_POLLRDNORM | PFD_POLLERR | PFD_POLLHUP)) != 0;
+				e->writable = (fds[i].revents & PFD_POLLWRNORM) != 0;
+			}
+			return;
+		}
+#endif
+
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Find the registered sockets that are ready.
+ * @param events  the list to put the ready sockets in
+ * @param timeout the maximum time to wait till a socket is ready, in milliseconds; 0 to not wait at all
+ * @note Without registered sockets it returns at once, whatever the timeout.
+ */
+void SocketPoller::Poll(EventList *events, uint timeout)
+{
+	events->Clear();
+	if (this->count == 0) return;
+
+	if (this->backend == PB_SELECT) {
+		this->PollSelect(events, timeout);
+	} else {
+		this->PollNative(events, timeout);
+	}
+}
+
+#endif /* ENABLE_NETWORK */
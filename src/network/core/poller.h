@@ -0,0 +1,93 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file poller.h Waiting for many sockets at once, without looking at the sockets that aren't ready.
+ */
+
+#ifndef NETWORK_CORE_POLLER_H
+#define NETWORK_CORE_POLLER_H
+
+#include "os_abstraction.h"
+#include "../../core/smallvec_type.hpp"
+
+#ifdef ENABLE_NETWORK
+
+/**
+ * The sockets that are registered stay registered until they are removed, so
+ * polling only costs time for the sockets that are ready. It uses epoll on
+ * Linux, kqueue on the BSDs and OSX and WSAPoll on Windows when the system
+ * has it; otherwise, or when these fail, it falls back to select.
+ * Every socket is polled for reading; polling for writing has to be asked
+ * for, and should only be asked for while a socket is known not to be
+ * writable, as a writable socket is reported on every poll.
+ */
+class SocketPoller {
+public:
+	/** A registered socket that is ready. */
+	struct Event {
+		SOCKET sock;   ///< The socket.
+		uint id;       ///< The identifier the socket was registered with.
+		bool readable; ///< Whether the socket can be read from, has been closed or is in error.
+		bool writable; ///< Whether the socket can be written to.
+	};
+
+	/** The ready sockets of one poll. */
+	typedef SmallVector<Event, 32> EventList;
+
+	SocketPoller();
+	~SocketPoller();
+
+	void Add(SOCKET s, uint id, bool write);
+	void SetWriteInterest(SOCKET s, uint id, bool write);
+	void Remove(SOCKET s);
+	void Poll(EventList *events, uint timeout = 0);
+
+	/**
+	 * Whether there are no sockets to poll, so polling can't wait.
+	 * @return true when no sockets are registered
+	 */
+	FORCEINLINE bool IsEmpty() const { return this->count == 0; }
+
+private:
+	/** A registered socket, as the select and WSAPoll backends need them. */
+	struct Registration {
+		SOCKET sock; ///< The socket.
+		uint id;     ///< The identifier of the socket.
+		bool write;  ///< Whether to poll for writing too.
+	};
+
+	/** The ways of polling. */
+	enum Backend {
+		PB_NONE,    ///< Not decided yet; it is when the first socket is added.
+		PB_SELECT,  ///< select
+		PB_EPOLL,   ///< epoll
+		PB_KQUEUE,  ///< kqueue
+		PB_WSAPOLL, ///< WSAPoll
+	};
+
+	Backend backend;                             ///< The way this poller polls.
+	int fd;                                      ///< The epoll or kqueue descriptor.
+	uint count;                                  ///< The number of registered sockets.
+	byte *buffer;                                ///< Memory for the events the epoll, kqueue and WSAPoll backends report.
+	size_t buffer_size;                          ///< The size of #buffer in bytes.
+	SmallVector<Registration, 16> registrations; ///< The registered sockets, for the select and WSAPoll backends.
+
+	void ChooseBackend();
+	Registration *FindRegistration(SOCKET s);
+	void *GetBuffer(size_t size);
+	void PollSelect(EventList *events, uint timeout);
+	void PollNative(EventList *events, uint timeout);
+};
+
+extern SocketPoller _network_poller;
+
+#endif /* ENABLE_NETWORK */
+
+#endif /* NETWORK_CORE_POLLER_H */
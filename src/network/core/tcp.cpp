@@ -18,6 +18,14 @@
 
 #include "tcp.h"
 
+#if defined(UNIX) && !defined(__OS2__) && !defined(__BEOS__) && !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(PSP)
+#	define WITH_WRITEV
+#	include <sys/uio.h>
+#endif
+
+/** Maximum number of packets that are handed to the OS at once; systems accept at least 16 buffers. */
+static const uint MAX_SEND_BATCH = 16;
+
 NetworkTCPSocketHandler::NetworkTCPSocketHandler(SOCKET s) :
 		NetworkSocketHandler(),
 		packet_queue(NULL), packet_recv(NULL),
@@ -75,6 +83,45 @@ void NetworkTCPSocketHandler::Send_Packet(Packet *packet)
 	}
 }
 
+/**
+ * Hand the first packets of a queue to the OS with one call, where the OS can
+ * do that; otherwise hand it only the first packet.
+ * @param s     the socket to send with
+ * @param queue the first packet to send
+ * @param total the number of bytes that are offered is stored here
+ * @return the number of bytes that are sent, or -1 on error
+ */
+static ssize_t SendPacketBatch(SOCKET s, Packet *queue, size_t *total)
+{
+	*total = 0;
+#if defined(WIN32)
+	WSABUF bufs[MAX_SEND_BATCH];
+	DWORD n = 0;
+	for (Packet *p = queue; p != NULL && n < MAX_SEND_BATCH; p = p->next, n++) {
+		bufs[n].buf = (char *)p->buffer + p->pos;
+		bufs[n].len = p->size - p->pos;
+		*total += bufs[n].len;
+	}
+
+	DWORD sent;
+	if (WSASend(s, bufs, n, &sent, 0, NULL, NULL) != 0) return -1;
+	return sent;
+#elif defined(WITH_WRITEV)
+	struct iovec bufs[MAX_SEND_BATCH];
+	int n = 0;
+	for (Packet *p = queue; p != NULL && n < (int)MAX_SEND_BATCH; p = p->next, n++) {
+		bufs[n].iov_base = (void *)(p->buffer + p->pos);
+		bufs[n].iov_len = p->size - p->pos;
+		*total += bufs[n].iov_len;
+	}
+
+	return writev(s, bufs, n);
+#else
+	*total = queue->size - queue->pos;
+	return send(s, (const char*)queue->buffer + queue->pos, *total, 0);
+#endif
+}
+
 /**
  * Sends all the buffered packets out for this client. It stops when:
  *   1) all packets are send (queue is empty)
@@ -85,16 +132,13 @@ void NetworkTCPSocketHandler::Send_Packet(Packet *packet)
  */
 bool NetworkTCPSocketHandler::Send_Packets(bool closing_down)
 {
-	ssize_t res;
-	Packet *p;
-
 	/* We can not write to this socket!! */
 	if (!this->writable) return false;
 	if (!this->IsConnected()) return false;
 
-	p = this->packet_queue;
-	while (p != NULL) {
-		res = send(this->sock, (const char*)p->buffer + p->pos, p->size - p->pos, 0);
+	while (this->packet_queue != NULL) {
+		size_t total;
+		ssize_t res = SendPacketBatch(this->sock, this->packet_queue, &total);
 		if (res == -1) {
 			int err = GET_LAST_ERROR();
 			if (err != EWOULDBLOCK) {
@@ -105,6 +149,8 @@ bool NetworkTCPSocketHandler::Send_Packets(bool closing_down)
 				}
 				return false;
 			}
+			/* Wait until the OS tells us there is room again */
+			this->writable = false;
 			return true;
 		}
 		if (res == 0) {
@@ -113,15 +159,24 @@ bool NetworkTCPSocketHandler::Send_Packets(bool closing_down)
 			return false;
 		}
 
-		p->pos += res;
+		/* Remove the packets that are sent completely */
+		size_t sent = res;
+		while (sent > 0) {
+			Packet *p = this->packet_queue;
+			size_t left = p->size - p->pos;
+			if (sent < left) {
+				p->pos += sent;
+				break;
+			}
 
-		/* Is this packet sent? */
-		if (p->pos == p->size) {
-			/* Go to the next packet */
+			sent -= left;
 			this->packet_queue = p->next;
 			delete p;
-			p = this->packet_queue;
-		} else {
+		}
+
+		if ((size_t)res < total) {
+			/* The OS took only part of it, so its buffer is full */
+			this->writable = false;
 			return true;
 		}
 	}
@@ -214,4 +269,17 @@ bool NetworkTCPSocketHandler::IsPacketQueueEmpty()
 	return this->packet_queue == NULL;
 }
 
+/**
+ * Get the number of bytes that are queued, but not sent yet.
+ * @return the number of bytes
+ */
+size_t NetworkTCPSocketHandler::GetQueuedBytes() const
+{
+	size_t bytes = 0;
+	for (const Packet *p = this->packet_queue; p != NULL; p = p->next) {
+		bytes += p->size - p->pos;
+	}
+	return bytes;
+}
+
 #endif /* ENABLE_NETWORK */
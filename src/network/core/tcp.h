@@ -38,6 +38,7 @@ public:
 	void Send_Packet(Packet *packet);
 	bool Send_Packets(bool closing_down = false);
 	bool IsPacketQueueEmpty();
+	size_t GetQueuedBytes() const;
 
 	Packet *Recv_Packet();
 
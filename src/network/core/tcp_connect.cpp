@@ -52,7 +52,9 @@ void TCPConnecter::Connect()
 
 /* static */ void TCPConnecter::CheckCallbacks()
 {
-	for (TCPConnecter **iter = _tcp_connecters.Begin(); iter < _tcp_connecters.End(); /* nothing */) {
+	/* The callbacks can make new connecters, which can move the list; so don't keep pointers into it. */
+	for (uint i = 0; i < _tcp_connecters.Length(); /* nothing */) {
+		TCPConnecter **iter = _tcp_connecters.Get(i);
 		TCPConnecter *cur = *iter;
 		if ((cur->connected || cur->aborted) && cur->killed) {
 			_tcp_connecters.Erase(iter);
@@ -72,7 +74,7 @@ void TCPConnecter::Connect()
 			delete cur;
 			continue;
 		}
-		iter++;
+		i++;
 	}
 }
 
@@ -17,6 +17,7 @@
 
 #include "../network.h"
 #include "../network_internal.h"
+#include "../network_relay.h"
 #include "../../core/pool_func.hpp"
 
 #include "table/strings.h"
@@ -36,10 +37,12 @@ NetworkClientSocket::NetworkClientSocket(ClientID client_id)
 
 NetworkClientSocket::~NetworkClientSocket()
 {
-	while (this->command_queue != NULL) {
-		CommandPacket *p = this->command_queue->next;
-		free(this->command_queue);
-		this->command_queue = p;
+	NetworkServerReleaseMapSnapshot(this);
+
+	while (this->relay_backlog != NULL) {
+		Packet *p = this->relay_backlog->next;
+		delete this->relay_backlog;
+		this->relay_backlog = p;
 	}
 
 	if (_redirect_console_to_client == this->client_id) _redirect_console_to_client = INVALID_CLIENT_ID;
@@ -57,8 +60,8 @@ NetworkClientSocket::~NetworkClientSocket()
  */
 NetworkRecvStatus NetworkClientSocket::CloseConnection(bool error)
 {
-	/* Clients drop back to the main menu */
-	if (!_network_server && _networking) {
+	/* Clients drop back to the main menu; relays only when they lose the server they relay */
+	if (!_network_server && _networking && !NetworkIsRelaySpectator(this)) {
 		_switch_mode = SM_MENU;
 		_networking = false;
 		extern StringID _switch_mode_errorstr;
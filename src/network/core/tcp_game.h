@@ -68,12 +68,45 @@ enum TCPPacketType {
 	PACKET_CLIENT_MOVE,
 	PACKET_SERVER_COMPANY_UPDATE,
 	PACKET_SERVER_CONFIG_UPDATE,
+	PACKET_SERVER_COMMANDS,
 	PACKET_END                   ///< Must ALWAYS be on the end of this list!! (period)
 };
 
 /** Packet that wraps a command */
 struct CommandPacket;
 
+/**
+ * A queue of commands, in the order they are to be sent or executed.
+ * Appending is done at the end without walking the queue, so queueing
+ * a command for every client does not slow down when a client lags behind.
+ */
+class CommandQueue {
+	CommandPacket *first; ///< The first command in the queue.
+	CommandPacket *last;  ///< The last command in the queue.
+	uint count;           ///< The number of commands in the queue.
+
+public:
+	/** Initialise an empty queue. */
+	CommandQueue() : first(NULL), last(NULL), count(0) {}
+	~CommandQueue() { this->Free(); }
+
+	void Append(const CommandPacket *p);
+	CommandPacket *Pop();
+	void Free();
+
+	/**
+	 * Get the first command without removing it from the queue.
+	 * @return The first command, or NULL when the queue is empty.
+	 */
+	FORCEINLINE CommandPacket *Peek() const { return this->first; }
+
+	/**
+	 * Get the number of commands in the queue.
+	 * @return The number of commands.
+	 */
+	FORCEINLINE uint Count() const { return this->count; }
+};
+
 /** Status of a client */
 enum ClientStatus {
 	STATUS_INACTIVE,     ///< The client is not connected nor active
@@ -106,7 +139,18 @@ public:
 
 	ClientStatus status;      ///< Status of this client
 
-	CommandPacket *command_queue; ///< The command-queue awaiting delivery
+	CommandQueue command_queue; ///< The command-queue awaiting delivery
+
+	struct NetworkMapSnapshot *map_snapshot; ///< The savegame the client is downloading, or NULL
+	size_t map_sent;                         ///< The number of bytes of #map_snapshot sent to the client
+	uint32 map_rate;                         ///< The estimate of the bytes per second the connection takes while downloading the map
+	size_t map_queued;                       ///< The number of bytes that were queued after the map was sent to last time
+	uint32 map_tick;                         ///< The _realtime_tick of the last time the map was sent to
+	Packet *relay_backlog;                   ///< Packets of the relayed server that wait until the client has loaded the map
+	Packet *relay_backlog_last;              ///< The last packet of #relay_backlog
+
+	bool poll_writable;       ///< Whether the poller is asked to tell when the socket can be written to
+	bool batched_commands;    ///< Whether the client understands PACKET_SERVER_COMMANDS
 
 	NetworkRecvStatus CloseConnection(bool error = true);
 
@@ -118,6 +162,8 @@ public:
 
 	const char *Recv_Command(Packet *p, CommandPacket *cp);
 	void Send_Command(Packet *p, const CommandPacket *cp);
+	const char *Recv_BatchedCommand(Packet *p, CommandPacket *cp, const CommandPacket *prev);
+	bool Send_BatchedCommand(Packet *p, const CommandPacket *cp, const CommandPacket *prev);
 };
 
 #define FOR_ALL_CLIENT_SOCKETS_FROM(var, start) FOR_ALL_ITEMS_FROM(NetworkClientSocket, clientsocket_index, var, start)
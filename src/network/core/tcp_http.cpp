@@ -35,12 +35,15 @@ NetworkHTTPSocketHandler::NetworkHTTPSocketHandler(SOCKET s,
 	redirect_depth(depth),
 	sock(s)
 {
-	size_t bufferSize = strlen(url) + strlen(host) + strlen(_openttd_revision) + (data == NULL ? 0 : strlen(data)) + 128;
+	size_t bufferSize = strlen(url) + strlen(host) + strlen(_openttd_revision) + (data == NULL ? 0 : strlen(data)) + 160;
 	char *buffer = AllocaM(char, bufferSize);
 
 	DEBUG(net, 7, "[tcp/http] requesting %s%s", host, url);
 	if (data != NULL) {
 		seprintf(buffer, buffer + bufferSize - 1, "POST %s HTTP/1.0\r\nHost: %s\r\nUser-Agent: OpenTTD/%s\r\nContent-Type: text/plain\r\nContent-Length: %d\r\n\r\n%s\r\n", url, host, _openttd_revision, (int)strlen(data), data);
+	} else if (callback->GetResumeOffset() != 0) {
+		DEBUG(net, 7, "[tcp/http] resuming at %u bytes", (uint)callback->GetResumeOffset());
+		seprintf(buffer, buffer + bufferSize - 1, "GET %s HTTP/1.0\r\nHost: %s\r\nUser-Agent: OpenTTD/%s\r\nRange: bytes=%u-\r\n\r\n", url, host, _openttd_revision, (uint)callback->GetResumeOffset());
 	} else {
 		seprintf(buffer, buffer + bufferSize - 1, "GET %s HTTP/1.0\r\nHost: %s\r\nUser-Agent: OpenTTD/%s\r\n\r\n", url, host, _openttd_revision);
 	}
@@ -52,6 +55,7 @@ NetworkHTTPSocketHandler::NetworkHTTPSocketHandler(SOCKET s,
 		 * of information? Just fall back to the old system! */
 		this->callback->OnFailure();
 		delete this;
+		return;
 	}
 
 	*_http_connections.Append() = this;
@@ -84,6 +88,7 @@ static const char * const HTTP_1_0       = "HTTP/1.0 ";        ///< Preamble for
 static const char * const HTTP_1_1       = "HTTP/1.1 ";        ///< Preamble for HTTP 1.1 servers
 static const char * const CONTENT_LENGTH = "Content-Length: "; ///< Header for the length of the content
 static const char * const LOCATION       = "Location: ";       ///< Header for location
+static const char * const CONTENT_RANGE  = "Content-Range: bytes "; ///< Header for the part of the content that is sent
 
 /**
  * Handle the header of a HTTP reply.
@@ -107,8 +112,15 @@ int NetworkHTTPSocketHandler::HandleHeader()
 	}
 
 	char *status = this->recv_buffer + strlen(HTTP_1_0);
-	if (strncmp(status, "200", 3) == 0) {
-		/* We are going to receive a document. */
+	bool partial = strncmp(status, "206", 3) == 0;
+	if (strncmp(status, "200", 3) == 0 || partial) {
+		/* We are going to receive a document, or the part we asked for. */
+		size_t offset = 0;
+		if (partial) {
+			char *range = strcasestr(this->recv_buffer, CONTENT_RANGE);
+			if (range == NULL) return_error("[tcp/http] missing 'content-range' header");
+			offset = strtoul(range + strlen(CONTENT_RANGE), NULL, 10);
+		}
 
 		/* Get the length of the document to receive */
 		char *length = strcasestr(this->recv_buffer, CONTENT_LENGTH);
@@ -133,6 +145,7 @@ int NetworkHTTPSocketHandler::HandleHeader()
 		if (len == 0) return_error("[tcp/http] refusing to download 0 bytes");
 
 		DEBUG(net, 7, "[tcp/http] downloading %i bytes", len);
+		this->callback->OnReceiveStart(offset);
 		return len;
 	}
 
@@ -34,6 +34,21 @@ struct HTTPCallback {
 	 */
 	virtual void OnReceiveData(const char *data, size_t length) = 0;
 
+	/**
+	 * From where in the document to receive it; a download that was broken
+	 * off only needs the part it doesn't have yet.
+	 * @return the offset in bytes to ask the server for, 0 for the whole document.
+	 */
+	virtual size_t GetResumeOffset() const { return 0; }
+
+	/**
+	 * The server is about to send the document; this is called again
+	 * when the server redirects us to another one.
+	 * @param offset where in the document the data that follows starts;
+	 *               0 when the server sends the whole document anyway.
+	 */
+	virtual void OnReceiveStart(size_t offset) {}
+
 	/** Silentium */
 	virtual ~HTTPCallback() {}
 };
@@ -22,8 +22,11 @@
 #include "network_udp.h"
 #include "network_gamelist.h"
 #include "network_base.h"
+#include "network_relay.h"
+#include "network_sync_hash.h"
 #include "core/udp.h"
 #include "core/host.h"
+#include "core/poller.h"
 #include "network_gui.h"
 #include "../console_func.h"
 #include "../3rdparty/md5/md5.h"
@@ -35,6 +38,8 @@
 #include "../rev.h"
 #include "../core/pool_func.hpp"
 #include "../gfx_func.h"
+#include "../timeline.h"
+#include "../genworld.h"
 #include "table/strings.h"
 
 #ifdef DEBUG_DUMP_COMMANDS
@@ -54,6 +59,9 @@ bool _networking;         ///< are we in networking mode?
 bool _network_server;     ///< network-server is active
 bool _network_available;  ///< is network mode available?
 bool _network_dedicated;  ///< are we a dedicated server?
+bool _network_relay;      ///< are we relaying the game of the server we joined to spectators?
+bool _network_catching_up; ///< are we replaying the frames we are behind the server, without drawing them?
+uint32 _network_catch_up_start; ///< the frame we started catching up at
 bool _is_network_server;  ///< Does this client wants to be a network-server?
 NetworkServerGameInfo _network_game_info;
 NetworkCompanyState *_network_company_states = NULL;
@@ -288,6 +296,8 @@ static void ServerStartError(const char *error)
 
 static void NetworkClientError(NetworkRecvStatus res, NetworkClientSocket *cs)
 {
+	_network_catching_up = false;
+
 	/* First, send a CLIENT_ERROR to the server, so he knows we are
 	 *  disconnection (and why!) */
 	NetworkErrorCode errorno;
@@ -504,11 +514,20 @@ void ParseConnectionString(const char **company, const char **port, char *connec
 	}
 }
 
+/**
+ * Do we accept clients, as a server or as a relay that is in sync?
+ * @return true when the clients that connect are ours to serve
+ */
+static inline bool NetworkServesClients()
+{
+	return _network_server || (_network_relay && _listensockets.Length() != 0);
+}
+
 /* Creates a new client from a socket
  *   Used both by the server and the client */
 static NetworkClientSocket *NetworkAllocClient(SOCKET s)
 {
-	if (_network_server) {
+	if (NetworkServesClients()) {
 		/* Can we handle a new client? */
 		if (_network_clients_connected >= MAX_CLIENTS) return NULL;
 		if (_network_game_info.clients_on >= _settings_client.network.max_clients) return NULL;
@@ -522,7 +541,11 @@ static NetworkClientSocket *NetworkAllocClient(SOCKET s)
 	cs->last_frame = _frame_counter;
 	cs->last_frame_server = _frame_counter;
 
-	if (_network_server) {
+	/* The socket isn't known to be writable yet, so wait for it. */
+	_network_poller.Add(s, cs->index, true);
+	cs->poll_writable = true;
+
+	if (NetworkServesClients()) {
 		cs->client_id = _network_client_id++;
 		NetworkClientInfo *ci = new NetworkClientInfo(cs->client_id);
 		cs->SetInfo(ci);
@@ -567,9 +590,9 @@ NetworkRecvStatus NetworkCloseClient(NetworkClientSocket *cs, NetworkRecvStatus
 
 	DEBUG(net, 1, "Closed client connection %d", cs->client_id);
 
-	if (_network_server) {
+	if (_network_server || NetworkIsRelaySpectator(cs)) {
 		/* We just lost one client :( */
-		if (cs->status >= STATUS_AUTHORIZED) _network_game_info.clients_on--;
+		if (_network_server && cs->status >= STATUS_AUTHORIZED) _network_game_info.clients_on--;
 		_network_clients_connected--;
 
 		SetWindowDirty(WC_CLIENT_LIST, 0);
@@ -577,6 +600,7 @@ NetworkRecvStatus NetworkCloseClient(NetworkClientSocket *cs, NetworkRecvStatus
 
 	cs->Send_Packets(true);
 
+	_network_poller.Remove(cs->sock);
 	delete cs->GetInfo();
 	delete cs;
 
@@ -640,6 +664,9 @@ static void NetworkAcceptClients(SOCKET ls)
 	}
 }
 
+/** The identifier the listen sockets are known by to the poller; the client sockets are known by their index. */
+static const uint LISTEN_SOCKET_ID = UINT_MAX;
+
 /* Set up the listen socket for the server */
 static bool NetworkListen()
 {
@@ -657,6 +684,10 @@ static bool NetworkListen()
 		return false;
 	}
 
+	for (SocketList::iterator s = _listensockets.Begin(); s != _listensockets.End(); s++) {
+		_network_poller.Add(s->second, LISTEN_SOCKET_ID, false);
+	}
+
 	return true;
 }
 
@@ -673,16 +704,17 @@ static void NetworkClose()
 	NetworkClientSocket *cs;
 
 	FOR_ALL_CLIENT_SOCKETS(cs) {
-		if (!_network_server) {
+		if (!_network_server && cs->index == 0) {
 			SEND_COMMAND(PACKET_CLIENT_QUIT)();
 			cs->Send_Packets();
 		}
 		NetworkCloseClient(cs, NETWORK_RECV_STATUS_CONN_LOST);
 	}
 
-	if (_network_server) {
-		/* We are a server, also close the listensocket */
+	if (_network_server || _network_relay) {
+		/* We are a server or a relay, also close the listensocket */
 		for (SocketList::iterator s = _listensockets.Begin(); s != _listensockets.End(); s++) {
+			_network_poller.Remove(s->second);
 			closesocket(s->second);
 		}
 		_listensockets.Clear();
@@ -695,6 +727,8 @@ static void NetworkClose()
 	_network_server = false;
 
 	NetworkFreeLocalCommandQueue();
+	NetworkRelayReset();
+	_network_catching_up = false;
 
 	free(_network_company_states);
 	_network_company_states = NULL;
@@ -938,46 +972,35 @@ void NetworkDisconnect(bool blocking)
 
 /**
  * Receives something from the network.
+ * @param timeout the maximum time to wait for something to receive, in milliseconds.
  * @return true if everthing went fine, false when the connection got closed.
  */
-static bool NetworkReceive()
+static bool NetworkReceive(uint timeout = 0)
 {
-	NetworkClientSocket *cs;
-	fd_set read_fd, write_fd;
-	struct timeval tv;
+	TIMELINE_ZONE("network receive");
 
-	FD_ZERO(&read_fd);
-	FD_ZERO(&write_fd);
+	static SocketPoller::EventList events;
+	_network_poller.Poll(&events, timeout);
 
-	FOR_ALL_CLIENT_SOCKETS(cs) {
-		FD_SET(cs->sock, &read_fd);
-		FD_SET(cs->sock, &write_fd);
-	}
+	for (const SocketPoller::Event *e = events.Begin(); e != events.End(); e++) {
+		/* accept clients.. */
+		if (e->id == LISTEN_SOCKET_ID) {
+			if (e->readable) NetworkAcceptClients(e->sock);
+			continue;
+		}
 
-	/* take care of listener port */
-	for (SocketList::iterator s = _listensockets.Begin(); s != _listensockets.End(); s++) {
-		FD_SET(s->second, &read_fd);
-	}
+		/* An earlier packet might have closed this client already. */
+		NetworkClientSocket *cs = NetworkClientSocket::GetIfValid(e->id);
+		if (cs == NULL || cs->sock != e->sock) continue;
 
-	tv.tv_sec = tv.tv_usec = 0; // don't block at all.
-#if !defined(__MORPHOS__) && !defined(__AMIGA__)
-	int n = select(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv);
-#else
-	int n = WaitSelect(FD_SETSIZE, &read_fd, &write_fd, NULL, &tv, NULL);
-#endif
-	if (n == -1 && !_network_server) NetworkError(STR_NETWORK_ERROR_LOSTCONNECTION);
-
-	/* accept clients.. */
-	for (SocketList::iterator s = _listensockets.Begin(); s != _listensockets.End(); s++) {
-		if (FD_ISSET(s->second, &read_fd)) NetworkAcceptClients(s->second);
-	}
+		if (e->writable) cs->writable = true;
 
-	/* read stuff from clients */
-	FOR_ALL_CLIENT_SOCKETS(cs) {
-		cs->writable = !!FD_ISSET(cs->sock, &write_fd);
-		if (FD_ISSET(cs->sock, &read_fd)) {
+		/* read stuff from clients */
+		if (e->readable) {
 			if (_network_server) {
 				NetworkServer_ReadPackets(cs);
+			} else if (NetworkIsRelaySpectator(cs)) {
+				NetworkRelay_ReadPackets(cs);
 			} else {
 				NetworkRecvStatus res;
 
@@ -1000,6 +1023,8 @@ static bool NetworkReceive()
 /* This sends all buffered commands (if possible) */
 static void NetworkSend()
 {
+	TIMELINE_ZONE("network send");
+
 	NetworkClientSocket *cs;
 	FOR_ALL_CLIENT_SOCKETS(cs) {
 		if (cs->writable) {
@@ -1010,9 +1035,55 @@ static void NetworkSend()
 				SEND_COMMAND(PACKET_SERVER_MAP)(cs);
 			}
 		}
+
+		/* Only wait for the sockets that can't be written to, as the others are reported on every poll. */
+		if (cs->IsConnected() && cs->poll_writable == cs->writable) {
+			cs->poll_writable = !cs->writable;
+			_network_poller.SetWriteInterest(cs->sock, cs->index, cs->poll_writable);
+		}
+	}
+}
+
+/** The number of frames we have to be behind the server before we catch up without drawing them. */
+static const uint32 NETWORK_CATCH_UP_MIN_FRAMES = DAY_TICKS;
+/** The number of frames to catch up with in one game loop, so the progress is drawn now and then. */
+static const uint NETWORK_CATCH_UP_FRAMES_PER_LOOP = 4 * DAY_TICKS;
+
+/**
+ * Start replaying the frames we are behind the server, e.g. after joining,
+ * without ticking the windows, drawing the viewports and playing sounds.
+ */
+static void NetworkStartCatchUp()
+{
+	_network_catching_up = true;
+	_network_catch_up_start = _frame_counter;
+	DEBUG(net, 1, "Catching up %d frames with the server", _frame_counter_server - _frame_counter);
+
+	/* Don't replace the window of a client that is registering its new company. */
+	if (FindWindowById(WC_NETWORK_STATUS_WINDOW, 0) == NULL) {
+		_network_join_status = NETWORK_JOIN_STATUS_CATCHING_UP;
+		ShowJoinStatusWindow();
 	}
 }
 
+/** We are at the frame of the server again; show what happened meanwhile. */
+static void NetworkStopCatchUp()
+{
+	_network_catching_up = false;
+	if (_network_join_status == NETWORK_JOIN_STATUS_CATCHING_UP) DeleteWindowById(WC_NETWORK_STATUS_WINDOW, 0);
+	MarkWholeScreenDirty();
+}
+
+/** Start serving the game we are in sync with to spectators. */
+static void NetworkStartRelay()
+{
+	_network_client_id = CLIENT_ID_RELAY_FIRST;
+	_network_clients_connected = 0;
+
+	if (!NetworkListen()) return;
+	DEBUG(net, 0, "[relay] relaying the game to spectators on port %d", _settings_client.network.server_port);
+}
+
 static bool NetworkDoClientLoop()
 {
 	_frame_counter++;
@@ -1024,6 +1095,9 @@ static bool NetworkDoClientLoop()
 	/* Check if we are in sync! */
 	if (_sync_frame != 0) {
 		if (_sync_frame == _frame_counter) {
+			/* Before the seeds, which only tell that something differs. */
+			NetworkSyncHashCheck(&_sync_hashes);
+
 #ifdef NETWORK_SEND_DOUBLE_SEED
 			if (_sync_seed_1 != _random.state[0] || _sync_seed_2 != _random.state[1]) {
 #else
@@ -1042,6 +1116,7 @@ static bool NetworkDoClientLoop()
 			if (_network_first_time) {
 				_network_first_time = false;
 				SEND_COMMAND(PACKET_CLIENT_ACK)();
+				if (_network_relay) NetworkStartRelay();
 			}
 
 			_sync_frame = 0;
@@ -1054,9 +1129,27 @@ static bool NetworkDoClientLoop()
 	return true;
 }
 
+/**
+ * Wait till a socket of the game is ready or the time is up, and handle
+ * the packets that came in and the ones waiting to be sent. This lets a
+ * dedicated server sleep between the ticks without delaying the packets
+ * till the next tick.
+ * @param timeout the maximum time to wait, in milliseconds.
+ * @return false when there are no sockets to wait for, so no time has passed.
+ */
+bool NetworkWaitForPackets(uint timeout)
+{
+	if (!_networking || IsGeneratingWorld() || _network_poller.IsEmpty()) return false;
+
+	if (NetworkReceive(timeout)) NetworkSend();
+	return true;
+}
+
 /* We have to do some UDP checking */
 void NetworkUDPGameLoop()
 {
+	TIMELINE_ZONE("network UDP");
+
 	_network_content_client.SendReceive();
 	TCPConnecter::CheckCallbacks();
 	NetworkHTTPSocketHandler::HTTPReceive();
@@ -1207,8 +1300,17 @@ void NetworkGameLoop()
 	} else {
 		/* Client */
 
-		/* Make sure we are at the frame were the server is (quick-frames) */
-		if (_frame_counter_server > _frame_counter) {
+		if (!_network_catching_up && _frame_counter_server > _frame_counter + NETWORK_CATCH_UP_MIN_FRAMES) NetworkStartCatchUp();
+
+		if (_network_catching_up) {
+			for (uint i = 0; i < NETWORK_CATCH_UP_FRAMES_PER_LOOP && _frame_counter_server > _frame_counter; i++) {
+				if (!NetworkDoClientLoop()) break;
+			}
+
+			if (_network_catching_up && _frame_counter_server <= _frame_counter) NetworkStopCatchUp();
+			SetWindowDirty(WC_NETWORK_STATUS_WINDOW, 0);
+		} else if (_frame_counter_server > _frame_counter) {
+			/* Make sure we are at the frame were the server is (quick-frames) */
 			while (_frame_counter_server > _frame_counter) {
 				if (!NetworkDoClientLoop()) break;
 			}
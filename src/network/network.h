@@ -23,6 +23,8 @@ extern bool _networking;         ///< are we in networking mode?
 extern bool _network_server;     ///< network-server is active
 extern bool _network_available;  ///< is network mode available?
 extern bool _network_dedicated;  ///< are we a dedicated server?
+extern bool _network_relay;      ///< are we relaying the game of the server we joined to spectators?
+extern bool _network_catching_up; ///< are we replaying the frames we are behind the server, without drawing them?
 extern bool _is_network_server;  ///< Does this client wants to be a network-server?
 
 #else /* ENABLE_NETWORK */
@@ -36,6 +38,8 @@ static inline void NetworkDrawChatMessage() {}
 #define _network_server 0
 #define _network_available 0
 #define _network_dedicated 0
+#define _network_relay 0
+#define _network_catching_up 0
 #define _is_network_server 0
 
 #endif /* ENABLE_NETWORK */
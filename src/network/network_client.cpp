@@ -28,6 +28,8 @@
 #include "../rev.h"
 #include "network.h"
 #include "network_base.h"
+#include "network_relay.h"
+#include "network_sync_hash.h"
 
 #include "table/strings.h"
 
@@ -139,6 +141,7 @@ DEF_CLIENT_SEND_COMMAND(PACKET_CLIENT_JOIN)
 	 *    String: Client Name (max NETWORK_NAME_LENGTH)
 	 *    uint8:  Play as Company id (1..MAX_COMPANIES)
 	 *    uint8:  Language ID
+	 *    bool:   Whether we understand PACKET_SERVER_COMMANDS
 	 */
 
 	Packet *p;
@@ -150,6 +153,8 @@ DEF_CLIENT_SEND_COMMAND(PACKET_CLIENT_JOIN)
 	p->Send_string(_settings_client.network.client_name); // Client name
 	p->Send_uint8 (_network_join_as);     // PlayAs
 	p->Send_uint8 (NETLANG_ANY);          // Language
+	/* A relay passes the commands on to spectators that might not understand batches */
+	p->Send_bool  (!_network_relay);      // Batched commands
 	MY_CLIENT->Send_Packet(p);
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -732,6 +737,7 @@ DEF_CLIENT_RECEIVE_COMMAND(PACKET_SERVER_SYNC)
 #ifdef NETWORK_SEND_DOUBLE_SEED
 	_sync_seed_2 = p->Recv_uint32();
 #endif
+	NetworkSyncHashRecv(p, _sync_frame, &_sync_hashes);
 
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -756,6 +762,29 @@ DEF_CLIENT_RECEIVE_COMMAND(PACKET_SERVER_COMMAND)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+DEF_CLIENT_RECEIVE_COMMAND(PACKET_SERVER_COMMANDS)
+{
+	CommandPacket prev;
+	memset(&prev, 0, sizeof(prev));
+
+	while (p->pos < p->size) {
+		CommandPacket cp;
+		const char *err = MY_CLIENT->Recv_BatchedCommand(p, &cp, &prev);
+		cp.next = NULL;
+
+		if (MY_CLIENT->HasClientQuit()) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+		if (err != NULL) {
+			IConsolePrintF(CC_ERROR, "WARNING: %s from server, dropping...", err);
+			return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+		}
+
+		NetworkAddCommandQueue(cp);
+		prev = cp;
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 DEF_CLIENT_RECEIVE_COMMAND(PACKET_SERVER_CHAT)
 {
 	char name[NETWORK_NAME_LENGTH], msg[NETWORK_CHAT_LENGTH];
@@ -976,6 +1005,7 @@ static NetworkClientPacket * const _network_client_packet[] = {
 	NULL, // PACKET_CLIENT_MOVE
 	RECEIVE_COMMAND(PACKET_SERVER_COMPANY_UPDATE),
 	RECEIVE_COMMAND(PACKET_SERVER_CONFIG_UPDATE),
+	RECEIVE_COMMAND(PACKET_SERVER_COMMANDS),
 };
 
 /* If this fails, check the array above with network_data.h */
@@ -1001,6 +1031,8 @@ NetworkRecvStatus NetworkClient_ReadPackets(NetworkClientSocket *cs)
 	while (res == NETWORK_RECV_STATUS_OKAY && (p = cs->Recv_Packet()) != NULL) {
 		byte type = p->Recv_uint8();
 		if (type < PACKET_END && _network_client_packet[type] != NULL && !MY_CLIENT->HasClientQuit()) {
+			/* Before handling it, as handling the packets that end the game closes the connections */
+			if (_network_relay) NetworkRelayForward(p);
 			res = _network_client_packet[type](p);
 		} else {
 			res = NETWORK_RECV_STATUS_MALFORMED_PACKET;
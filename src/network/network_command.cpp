@@ -17,6 +17,7 @@
 #include "network.h"
 #include "../command_func.h"
 #include "../company_func.h"
+#include "../string_func.h"
 
 /** Table with all the callbacks we'll use for conversion*/
 static CommandCallback * const _callback_table[] = {
@@ -53,7 +54,48 @@ static CommandCallback * const _callback_table[] = {
 };
 
 /** Local queue of packets */
-static CommandPacket *_local_command_queue = NULL;
+static CommandQueue _local_command_queue;
+
+/**
+ * Append a copy of a command to the end of the queue.
+ * @param p The command to append.
+ */
+void CommandQueue::Append(const CommandPacket *p)
+{
+	CommandPacket *add = MallocT<CommandPacket>(1);
+	*add = *p;
+	add->next = NULL;
+
+	if (this->first == NULL) {
+		this->first = add;
+	} else {
+		this->last->next = add;
+	}
+	this->last = add;
+	this->count++;
+}
+
+/**
+ * Remove the first command from the queue.
+ * @return The first command, to be freed by the caller, or NULL when the queue is empty.
+ */
+CommandPacket *CommandQueue::Pop()
+{
+	CommandPacket *ret = this->first;
+	if (ret == NULL) return NULL;
+
+	this->first = ret->next;
+	if (this->first == NULL) this->last = NULL;
+	this->count--;
+	return ret;
+}
+
+/** Free all commands in the queue. */
+void CommandQueue::Free()
+{
+	CommandPacket *cp;
+	while ((cp = this->Pop()) != NULL) free(cp);
+}
 
 /**
  * Add a command to the local or client socket command queue,
@@ -63,18 +105,7 @@ static CommandPacket *_local_command_queue = NULL;
  */
 void NetworkAddCommandQueue(CommandPacket cp, NetworkClientSocket *cs)
 {
-	CommandPacket *new_cp = MallocT<CommandPacket>(1);
-	*new_cp = cp;
-
-	CommandPacket **begin = (cs == NULL ? &_local_command_queue : &cs->command_queue);
-
-	if (*begin == NULL) {
-		*begin = new_cp;
-	} else {
-		CommandPacket *c = *begin;
-		while (c->next != NULL) c = c->next;
-		c->next = new_cp;
-	}
+	(cs == NULL ? &_local_command_queue : &cs->command_queue)->Append(&cp);
 }
 
 /**
@@ -141,7 +172,7 @@ void NetworkSend_Command(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd, Comma
  */
 void NetworkSyncCommandQueue(NetworkClientSocket *cs)
 {
-	for (CommandPacket *p = _local_command_queue; p != NULL; p = p->next) {
+	for (CommandPacket *p = _local_command_queue.Peek(); p != NULL; p = p->next) {
 		CommandPacket c = *p;
 		c.callback = 0;
 		c.next = NULL;
@@ -156,27 +187,25 @@ void NetworkExecuteLocalCommandQueue()
 {
 	assert(_current_company == _local_company);
 
-	while (_local_command_queue != NULL) {
+	CommandPacket *cp;
+	while ((cp = _local_command_queue.Peek()) != NULL) {
 
 		/* The queue is always in order, which means
 		 * that the first element will be executed first. */
-		if (_frame_counter < _local_command_queue->frame) break;
+		if (_frame_counter < cp->frame) break;
 
-		if (_frame_counter > _local_command_queue->frame) {
+		if (_frame_counter > cp->frame) {
 			/* If we reach here, it means for whatever reason, we've already executed
 			 * past the command we need to execute. */
 			error("[net] Trying to execute a packet in the past!");
 		}
 
-		CommandPacket *cp = _local_command_queue;
-
 		/* We can execute this command */
 		_current_company = cp->company;
 		cp->cmd |= CMD_NETWORK_COMMAND;
 		DoCommandP(cp, cp->my_cmd);
 
-		_local_command_queue = _local_command_queue->next;
-		free(cp);
+		free(_local_command_queue.Pop());
 	}
 
 	/* Local company may have changed, so we should not restore the old value */
@@ -189,11 +218,43 @@ void NetworkExecuteLocalCommandQueue()
 void NetworkFreeLocalCommandQueue()
 {
 	/* Free all queued commands */
-	while (_local_command_queue != NULL) {
-		CommandPacket *p = _local_command_queue;
-		_local_command_queue = _local_command_queue->next;
-		free(p);
+	_local_command_queue.Free();
+}
+
+/**
+ * Check a received command and set its callback.
+ * @param cp the command.
+ * @param callback the index of the callback in the callback table.
+ * @return an error message. When NULL there has been no error.
+ */
+static const char *CheckReceivedCommand(CommandPacket *cp, byte callback)
+{
+	if (!IsValidCommand(cp->cmd))               return "invalid command";
+	if (GetCommandFlags(cp->cmd) & CMD_OFFLINE) return "offline only command";
+	if ((cp->cmd & CMD_FLAGS_MASK) != 0)        return "invalid command flag";
+	if (callback > lengthof(_callback_table))   return "invalid callback";
+
+	cp->callback = _callback_table[callback];
+	return NULL;
+}
+
+/**
+ * Get the index of the callback of a command in the callback table.
+ * @param cp the command.
+ * @return the index of the callback.
+ */
+static byte GetCommandCallbackIndex(const CommandPacket *cp)
+{
+	byte callback = 0;
+	while (callback < lengthof(_callback_table) && _callback_table[callback] != cp->callback) {
+		callback++;
 	}
+
+	if (callback == lengthof(_callback_table)) {
+		DEBUG(net, 0, "Unknown callback. (Pointer: %p) No callback sent", cp->callback);
+		callback = 0; // _callback_table[0] == NULL
+	}
+	return callback;
 }
 
 /**
@@ -213,13 +274,7 @@ const char *NetworkClientSocket::Recv_Command(Packet *p, CommandPacket *cp)
 
 	byte callback = p->Recv_uint8();
 
-	if (!IsValidCommand(cp->cmd))               return "invalid command";
-	if (GetCommandFlags(cp->cmd) & CMD_OFFLINE) return "offline only command";
-	if ((cp->cmd & CMD_FLAGS_MASK) != 0)        return "invalid command flag";
-	if (callback > lengthof(_callback_table))   return "invalid callback";
-
-	cp->callback = _callback_table[callback];
-	return NULL;
+	return CheckReceivedCommand(cp, callback);
 }
 
 /**
@@ -235,17 +290,140 @@ void NetworkClientSocket::Send_Command(Packet *p, const CommandPacket *cp)
 	p->Send_uint32(cp->p2);
 	p->Send_uint32(cp->tile);
 	p->Send_string(cp->text);
+	p->Send_uint8 (GetCommandCallbackIndex(cp));
+}
 
-	byte callback = 0;
-	while (callback < lengthof(_callback_table) && _callback_table[callback] != cp->callback) {
-		callback++;
+/** The fields of a command in a batch that are sent, or differ from the previous command of the batch. */
+enum BatchedCommandFlags {
+	BCF_COMPANY  = 1 << 0, ///< The company differs.
+	BCF_CMD      = 1 << 1, ///< The command differs.
+	BCF_P1       = 1 << 2, ///< P1 differs.
+	BCF_P2       = 1 << 3, ///< P2 differs.
+	BCF_TILE     = 1 << 4, ///< The tile differs.
+	BCF_TEXT     = 1 << 5, ///< There is a text.
+	BCF_CALLBACK = 1 << 6, ///< There is a callback.
+	BCF_MY_CMD   = 1 << 7, ///< The command is of the client it is sent to.
+};
+
+/** The most bytes a command takes in a batch: the flags, the company, five numbers, the text and the callback. */
+static const uint MAX_BATCHED_COMMAND_SIZE = 1 + 1 + 5 * 5 + sizeof(((CommandContainer *)NULL)->text) + 1;
+
+/**
+ * Send a number in as few bytes as needed; 7 bits per byte, the lowest first.
+ * @param p the packet to send it in.
+ * @param value the number.
+ */
+static void SendVarUint32(Packet *p, uint32 value)
+{
+	while (value >= 0x80) {
+		p->Send_uint8((value & 0x7F) | 0x80);
+		value >>= 7;
 	}
+	p->Send_uint8(value);
+}
 
-	if (callback == lengthof(_callback_table)) {
-		DEBUG(net, 0, "Unknown callback. (Pointer: %p) No callback sent", cp->callback);
-		callback = 0; // _callback_table[0] == NULL
+/**
+ * Receive a number sent by #SendVarUint32.
+ * @param p the packet to read from.
+ * @return the number.
+ */
+static uint32 RecvVarUint32(Packet *p)
+{
+	uint32 value = 0;
+	for (uint shift = 0; shift < 32; shift += 7) {
+		byte b = p->Recv_uint8();
+		value |= (uint32)(b & 0x7F) << shift;
+		if ((b & 0x80) == 0) break;
+	}
+	return value;
+}
+
+/**
+ * Send the difference between two numbers, so small steps either way take few bytes.
+ * @param p the packet to send it in.
+ * @param value the number.
+ * @param prev the number it is the difference to.
+ */
+static void SendVarDelta(Packet *p, uint32 value, uint32 prev)
+{
+	int32 delta = (int32)(value - prev);
+	SendVarUint32(p, ((uint32)delta << 1) ^ (uint32)(delta >> 31));
+}
+
+/**
+ * Receive a number sent by #SendVarDelta.
+ * @param p the packet to read from.
+ * @param prev the number it is the difference to.
+ * @return the number.
+ */
+static uint32 RecvVarDelta(Packet *p, uint32 prev)
+{
+	uint32 zigzag = RecvVarUint32(p);
+	return prev + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+}
+
+/**
+ * Receives a command of a batch of commands from the network.
+ * @param p the packet to read from.
+ * @param cp the struct to write the data to.
+ * @param prev the previous command of the batch; zeroed for the first.
+ * @return an error message. When NULL there has been no error.
+ */
+const char *NetworkClientSocket::Recv_BatchedCommand(Packet *p, CommandPacket *cp, const CommandPacket *prev)
+{
+	byte flags = p->Recv_uint8();
+
+	cp->company = (flags & BCF_COMPANY) ? (CompanyID)p->Recv_uint8() : (CompanyID)prev->company;
+	cp->cmd     = (flags & BCF_CMD)  ? RecvVarUint32(p)            : prev->cmd;
+	cp->p1      = (flags & BCF_P1)   ? RecvVarDelta(p, prev->p1)   : prev->p1;
+	cp->p2      = (flags & BCF_P2)   ? RecvVarDelta(p, prev->p2)   : prev->p2;
+	cp->tile    = (flags & BCF_TILE) ? RecvVarDelta(p, prev->tile) : prev->tile;
+	if (flags & BCF_TEXT) {
+		p->Recv_string(cp->text, lengthof(cp->text));
+	} else {
+		cp->text[0] = '\0';
 	}
-	p->Send_uint8 (callback);
+	byte callback = (flags & BCF_CALLBACK) ? p->Recv_uint8() : 0;
+	cp->frame   = RecvVarDelta(p, prev->frame);
+	cp->my_cmd  = (flags & BCF_MY_CMD) != 0;
+
+	return CheckReceivedCommand(cp, callback);
+}
+
+/**
+ * Sends a command of a batch of commands over the network, with its fields
+ * as difference to the previous command of the batch.
+ * @param p the packet to send it in.
+ * @param cp the packet to actually send.
+ * @param prev the previous command of the batch; zeroed for the first.
+ * @return false when the command doesn't fit in the packet anymore; nothing is sent then.
+ */
+bool NetworkClientSocket::Send_BatchedCommand(Packet *p, const CommandPacket *cp, const CommandPacket *prev)
+{
+	if (p->size + MAX_BATCHED_COMMAND_SIZE > SEND_MTU) return false;
+
+	byte callback = GetCommandCallbackIndex(cp);
+
+	byte flags = 0;
+	if (cp->company != prev->company) flags |= BCF_COMPANY;
+	if (cp->cmd     != prev->cmd)     flags |= BCF_CMD;
+	if (cp->p1      != prev->p1)      flags |= BCF_P1;
+	if (cp->p2      != prev->p2)      flags |= BCF_P2;
+	if (cp->tile    != prev->tile)    flags |= BCF_TILE;
+	if (!StrEmpty(cp->text))          flags |= BCF_TEXT;
+	if (callback != 0)                flags |= BCF_CALLBACK;
+	if (cp->my_cmd)                   flags |= BCF_MY_CMD;
+
+	p->Send_uint8(flags);
+	if (flags & BCF_COMPANY) p->Send_uint8(cp->company);
+	if (flags & BCF_CMD)     SendVarUint32(p, cp->cmd);
+	if (flags & BCF_P1)      SendVarDelta(p, cp->p1, prev->p1);
+	if (flags & BCF_P2)      SendVarDelta(p, cp->p2, prev->p2);
+	if (flags & BCF_TILE)    SendVarDelta(p, cp->tile, prev->tile);
+	if (flags & BCF_TEXT)    p->Send_string(cp->text);
+	if (flags & BCF_CALLBACK) p->Send_uint8(callback);
+	SendVarDelta(p, cp->frame, prev->frame);
+	return true;
 }
 
 #endif /* ENABLE_NETWORK */
@@ -425,6 +425,22 @@ static bool GunzipFile(const ContentInfo *ci)
 #endif /* defined(WITH_ZLIB) */
 }
 
+/**
+ * Make a downloaded and unpacked tar known.
+ * @param ci container with filename
+ */
+static void AddDownloadedTar(const ContentInfo *ci)
+{
+	TarScanner ts;
+	ts.AddFile(GetFullFilename(ci, false), 0);
+
+	if (ci->type == CONTENT_TYPE_BASE_MUSIC) {
+		/* Music can't be in a tar. So extract the tar! */
+		ExtractTar(GetFullFilename(ci, false));
+		unlink(GetFullFilename(ci, false));
+	}
+}
+
 DEF_CONTENT_RECEIVE_COMMAND(Client, PACKET_CONTENT_SERVER_CONTENT)
 {
 	if (this->curFile == NULL) {
@@ -501,15 +517,7 @@ void ClientNetworkContentSocketHandler::AfterDownload()
 
 	if (GunzipFile(this->curInfo)) {
 		unlink(GetFullFilename(this->curInfo, true));
-
-		TarScanner ts;
-		ts.AddFile(GetFullFilename(this->curInfo, false), 0);
-
-		if (this->curInfo->type == CONTENT_TYPE_BASE_MUSIC) {
-			/* Music can't be in a tar. So extract the tar! */
-			ExtractTar(GetFullFilename(this->curInfo, false));
-			unlink(GetFullFilename(this->curInfo, false));
-		}
+		AddDownloadedTar(this->curInfo);
 
 		this->OnDownloadComplete(this->curInfo->id);
 	} else {
@@ -517,145 +525,376 @@ void ClientNetworkContentSocketHandler::AfterDownload()
 	}
 }
 
-/* Also called to just clean up the mess. */
-void ClientNetworkContentSocketHandler::OnFailure()
+/** The number of files that are downloaded over HTTP at the same time. */
+static const uint MAX_HTTP_DOWNLOADS = 4;
+/** How often a download over HTTP is tried before it is left to the content server. */
+static const uint MAX_HTTP_ATTEMPTS = 3;
+
+/**
+ * A file that is downloaded over HTTP, by its own connection so several of
+ * them can be downloaded at the same time. The gzip is unpacked while it
+ * arrives and when the connection breaks off the download continues where
+ * it was, as far as the server supports that.
+ */
+class ContentHTTPDownload : public HTTPCallback {
+	ContentInfo *info; ///< What is downloaded; only the type, ID, file size and file name are known.
+	char *url;         ///< Where to download it from.
+	FILE *file;        ///< The tar the gzip is unpacked into.
+#if defined(WITH_ZLIB)
+	z_stream z;        ///< The state of unpacking the gzip.
+#endif /* WITH_ZLIB */
+	size_t received;   ///< Bytes of the gzip that have been unpacked; where to resume.
+	size_t reported;   ///< Bytes that have been reported as progress; no more than the file size.
+	uint attempts;     ///< How often the download has been started.
+	bool active;       ///< Whether a connection is busy with the download.
+	bool ignore;       ///< Whether the data of the current connection is of no use.
+	bool ended;        ///< Whether the end of the gzip has been unpacked.
+	bool broken;       ///< Whether unpacking or writing failed, so there's no point in going on.
+
+	bool Reset();
+	bool Unpack(const char *data, size_t length);
+	void Finish(bool success);
+
+public:
+	ContentHTTPDownload(ContentInfo *info, const char *url);
+	~ContentHTTPDownload();
+
+	void Start();
+
+	/**
+	 * Has the download been started?
+	 * @return true when it has been started, even if it has finished already.
+	 */
+	bool IsStarted() const { return this->attempts != 0; }
+
+	/**
+	 * Is a connection busy with the download?
+	 * @return true when a connection is busy with it.
+	 */
+	bool IsActive() const { return this->active; }
+
+	virtual void OnFailure();
+	virtual void OnReceiveData(const char *data, size_t length);
+	virtual size_t GetResumeOffset() const { return this->received; }
+	virtual void OnReceiveStart(size_t offset);
+};
+
+/**
+ * Create the download of a file.
+ * @param info what to download; the download takes over freeing it.
+ * @param url  where to download it from.
+ */
+ContentHTTPDownload::ContentHTTPDownload(ContentInfo *info, const char *url) :
+	info(info),
+	url(strdup(url)),
+	file(NULL),
+	received(0),
+	reported(0),
+	attempts(0),
+	active(false),
+	ignore(false),
+	ended(false),
+	broken(false)
 {
-	/* If we fail, download the rest via the 'old' system. */
-	uint files, bytes;
-	this->DownloadSelectedContent(files, bytes, true);
+#if defined(WITH_ZLIB)
+	memset(&this->z, 0, sizeof(this->z));
+	if (inflateInit2(&this->z, MAX_WBITS + 32) != Z_OK) this->broken = true;
+#endif /* WITH_ZLIB */
+}
 
-	this->http_response.Reset();
-	this->http_response_index = -2;
+/** Free whatever we've allocated. */
+ContentHTTPDownload::~ContentHTTPDownload()
+{
+#if defined(WITH_ZLIB)
+	inflateEnd(&this->z);
+#endif /* WITH_ZLIB */
+	if (this->file != NULL) fclose(this->file);
+	free(this->url);
+	delete this->info;
+}
+
+/** Start downloading the file, or where the previous attempt stopped. */
+void ContentHTTPDownload::Start()
+{
+	this->attempts++;
+	this->active = true;
+	this->ignore = false;
 
-	if (this->curFile != NULL) {
-		fclose(this->curFile);
-		this->curFile = NULL;
+	if (NetworkHTTPSocketHandler::Connect(this->url, this) != 0) {
+		this->active = false;
+		this->Finish(false);
 	}
 }
 
-void ClientNetworkContentSocketHandler::OnReceiveData(const char *data, size_t length)
+/**
+ * Start unpacking into an empty tar.
+ * @return false when the tar can't be written.
+ */
+bool ContentHTTPDownload::Reset()
 {
-	assert(data == NULL || length != 0);
+	if (this->file != NULL) fclose(this->file);
+	this->file = fopen(GetFullFilename(this->info, false), "wb");
+	this->received = 0;
+	this->ended = false;
 
-	/* Ignore any latent data coming from a connection we closed. */
-	if (this->http_response_index == -2) return;
+#if defined(WITH_ZLIB)
+	if (inflateReset(&this->z) != Z_OK) return false;
+#endif /* WITH_ZLIB */
+	return this->file != NULL;
+}
 
-	if (this->http_response_index == -1) {
-		if (data != NULL) {
-			/* Append the rest of the response. */
-			memcpy(this->http_response.Append((uint)length), data, length);
-			return;
-		} else {
-			/* Make sure the response is properly terminated. */
-			*this->http_response.Append() = '\0';
+/**
+ * Unpack the next part of the gzip into the tar.
+ * @param data   the part of the gzip.
+ * @param length the length of the part.
+ * @return false when the gzip is broken or the tar can't be written.
+ */
+bool ContentHTTPDownload::Unpack(const char *data, size_t length)
+{
+#if defined(WITH_ZLIB)
+	this->z.next_in = const_cast<Bytef *>((const Bytef *)data); // only cast because zlib does not declare next_in const, it only reads it
+	this->z.avail_in = (uInt)length;
+
+	for (;;) {
+		byte buff[8192];
+		this->z.next_out = buff;
+		this->z.avail_out = sizeof(buff);
+
+		int ret = inflate(&this->z, Z_NO_FLUSH);
+		if (ret != Z_OK && ret != Z_STREAM_END) return false;
 
-			/* And prepare for receiving the rest of the data. */
-			this->http_response_index = 0;
+		size_t unpacked = sizeof(buff) - this->z.avail_out;
+		if (fwrite(buff, 1, unpacked, this->file) != unpacked) return false;
+
+		if (ret == Z_STREAM_END) {
+			/* Anything after the end of the gzip is of no interest. */
+			this->ended = true;
+			return true;
 		}
+		/* Everything is unpacked when it didn't fill the buffer. */
+		if (this->z.avail_in == 0 && this->z.avail_out != 0) return true;
 	}
+#else
+	NOT_REACHED();
+#endif /* defined(WITH_ZLIB) */
+}
 
-	if (data != NULL) {
-		/* We have data, so write it to the file. */
-		if (fwrite(data, 1, length, this->curFile) != length) {
-			/* Writing failed somehow, let try via the old method. */
+void ContentHTTPDownload::OnReceiveStart(size_t offset)
+{
+	if (this->broken) return;
+
+	if (offset == 0 && this->received != 0) {
+		/* The server can't resume, so start all over again. */
+		DEBUG(net, 1, "[content] %s does not resume downloads, restarting", this->url);
+	} else if (offset != this->received) {
+		/* It resumes at a place that is of no use to us. */
+		this->ignore = true;
+		return;
+	}
+
+	if (offset == 0 && !this->Reset()) this->broken = true;
+}
+
+void ContentHTTPDownload::OnReceiveData(const char *data, size_t length)
+{
+	assert(data == NULL || length != 0);
+
+	if (data == NULL) {
+		this->active = false;
+		if (this->ignore) {
 			this->OnFailure();
 		} else {
-			/* Just received the data. */
-			this->OnDownloadProgress(this->curInfo, (uint)length);
+			this->Finish(this->ended && !this->broken);
 		}
-		/* Nothing more to do now. */
 		return;
 	}
 
-	if (this->curFile != NULL) {
-		/* We've finished downloading a file. */
-		this->AfterDownload();
+	if (this->ignore || this->broken || this->ended) return;
+
+	if (!this->Unpack(data, length)) {
+		/* Retrying won't help; the content server might do better. */
+		this->broken = true;
+		return;
 	}
+	this->received += length;
 
-	if ((uint)this->http_response_index >= this->http_response.Length()) {
-		/* It's not a real failure, but if there's
-		 * nothing more to download it helps with
-		 * cleaning up the stuff we allocated. */
-		this->OnFailure();
+	/* When the download had to restart, only the bytes we didn't have before are progress. */
+	size_t progress = min<size_t>(this->received, this->info->filesize);
+	if (progress > this->reported) {
+		_network_content_client.OnDownloadProgress(this->info, (uint)(progress - this->reported));
+		this->reported = progress;
+	}
+}
+
+void ContentHTTPDownload::OnFailure()
+{
+	this->active = false;
+
+	if (!this->broken && this->attempts < MAX_HTTP_ATTEMPTS) {
+		DEBUG(net, 1, "[content] downloading %s failed at %u bytes, retrying", this->url, (uint)this->received);
+		this->Start();
 		return;
 	}
 
-	delete this->curInfo;
-	/* When we haven't opened a file this must be our first packet with metadata. */
-	this->curInfo = new ContentInfo;
+	this->Finish(false);
+}
 
-/** Check p for not being null and return calling OnFailure if that's not the case. */
-#define check_not_null(p) { if ((p) == NULL) { this->OnFailure(); return; } }
-/** Check p for not being null and then terminate, or return calling OnFailure. */
-#define check_and_terminate(p) { check_not_null(p); *(p) = '\0'; }
+/**
+ * Handle the end of the download; the download is gone afterwards.
+ * @param success whether the whole file was downloaded and unpacked.
+ */
+void ContentHTTPDownload::Finish(bool success)
+{
+	if (this->file != NULL) {
+		fclose(this->file);
+		this->file = NULL;
+
+		/* Whatever failed is left to the content server once the other downloads are done. */
+		if (!success) unlink(GetFullFilename(this->info, false));
+	}
+
+	if (success) {
+		AddDownloadedTar(this->info);
+		_network_content_client.OnDownloadComplete(this->info->id);
+	}
+
+	_network_content_client.OnHTTPDownloadDone(this);
+}
+
+/**
+ * Make the download of one line of the answer of the mirror.
+ * @param line the line, without the newline: "id,type,filesize,url".
+ * @return the download, or NULL when the file can't be downloaded over HTTP.
+ */
+static ContentHTTPDownload *ParseHTTPContentLine(char *line)
+{
+	/* Split off the ID, type and file size from the URL. */
+	char *fields[3];
+	for (uint i = 0; i < lengthof(fields); i++) {
+		fields[i] = line;
+		line = strchr(line, ',');
+		if (line == NULL) return NULL;
+		*line++ = '\0';
+	}
+
+	/* Is it a fallback URL? Then the content server has to send it. */
+	if (strncmp(line, "ottd", 4) == 0) return NULL;
 
+	const char *name = strrchr(line, '/');
+	if (name == NULL) return NULL;
+
+	char tmp[MAX_PATH];
+	if (strecpy(tmp, name + 1, lastof(tmp)) == lastof(tmp)) return NULL;
+	/* Remove the extension from the string. */
+	for (uint i = 0; i < 2; i++) {
+		char *ext = strrchr(tmp, '.');
+		if (ext == NULL) return NULL;
+		*ext = '\0';
+	}
+
+	ContentInfo *ci = new ContentInfo;
+	ci->id       = (ContentID)atoi(fields[0]);
+	ci->type     = (ContentType)atoi(fields[1]);
+	ci->filesize = atoi(fields[2]);
+	/* Copy the string, without extension, to the filename. */
+	strecpy(ci->filename, tmp, lastof(ci->filename));
+
+	if (!ci->IsValid() || ci->filesize == 0 || GetFullFilename(ci, false) == NULL) {
+		delete ci;
+		return NULL;
+	}
+
+	return new ContentHTTPDownload(ci, line);
+}
+
+/** Start downloading the next files over HTTP, until as many are downloaded at the same time as allowed. */
+void ClientNetworkContentSocketHandler::StartHTTPDownloads()
+{
+	/* Starting a download can finish it right away, which changes the list; so look again every time. */
 	for (;;) {
+		uint active = 0;
+		ContentHTTPDownload *next = NULL;
+		for (ContentHTTPDownload **iter = this->http_downloads.Begin(); iter != this->http_downloads.End(); iter++) {
+			if ((*iter)->IsActive()) active++;
+			if (next == NULL && !(*iter)->IsStarted()) next = *iter;
+		}
+
+		if (next == NULL || active >= MAX_HTTP_DOWNLOADS) return;
+		next->Start();
+	}
+}
+
+/**
+ * A download over HTTP has finished, whether it succeeded or not.
+ * @param download the download; it is freed.
+ */
+void ClientNetworkContentSocketHandler::OnHTTPDownloadDone(ContentHTTPDownload *download)
+{
+	this->http_downloads.Erase(this->http_downloads.Find(download));
+	delete download;
+
+	if (this->http_downloads.Length() != 0) {
+		this->StartHTTPDownloads();
+		return;
+	}
+
+	/* It's not a real failure, but if there's
+	 * nothing more to download it helps with
+	 * cleaning up the stuff we allocated. */
+	this->OnFailure();
+}
+
+/* Also called to just clean up the mess. */
+void ClientNetworkContentSocketHandler::OnFailure()
+{
+	/* If we fail, download the rest via the 'old' system. */
+	uint files, bytes;
+	this->DownloadSelectedContent(files, bytes, true);
+
+	this->http_response.Reset();
+	this->http_response_index = -2;
+}
+
+void ClientNetworkContentSocketHandler::OnReceiveData(const char *data, size_t length)
+{
+	assert(data == NULL || length != 0);
+
+	/* Ignore any latent data coming from a connection we closed. */
+	if (this->http_response_index == -2) return;
+
+	if (data != NULL) {
+		/* Append the rest of the response. */
+		memcpy(this->http_response.Append((uint)length), data, length);
+		return;
+	}
+
+	/* Make sure the response is properly terminated. */
+	*this->http_response.Append() = '\0';
+
+	/* Every line tells where to download a file; what can't be
+	 * downloaded over HTTP is left to the content server. */
+	for (this->http_response_index = 0;;) {
 		char *str = this->http_response.Begin() + this->http_response_index;
 		char *p = strchr(str, '\n');
-		check_and_terminate(p);
+		if (p == NULL) break;
+		*p = '\0';
 
 		/* Update the index for the next one */
-		this->http_response_index += (int)strlen(str) + 1;
-
-		/* Read the ID */
-		p = strchr(str, ',');
-		check_and_terminate(p);
-		this->curInfo->id = (ContentID)atoi(str);
-
-		/* Read the type */
-		str = p + 1;
-		p = strchr(str, ',');
-		check_and_terminate(p);
-		this->curInfo->type = (ContentType)atoi(str);
-
-		/* Read the file size */
-		str = p + 1;
-		p = strchr(str, ',');
-		check_and_terminate(p);
-		this->curInfo->filesize = atoi(str);
-
-		/* Read the URL */
-		str = p + 1;
-		/* Is it a fallback URL? If so, just continue with the next one. */
-		if (strncmp(str, "ottd", 4) == 0) {
-			if ((uint)this->http_response_index >= this->http_response.Length()) {
-				/* Have we gone through all lines? */
-				this->OnFailure();
-				return;
-			}
-			continue;
-		}
-
-		p = strrchr(str, '/');
-		check_not_null(p);
-		p++; // Start after the '/'
+		this->http_response_index += (int)(p - str) + 1;
 
-		char tmp[MAX_PATH];
-		if (strecpy(tmp, p, lastof(tmp)) == lastof(tmp)) {
-			this->OnFailure();
-			return;
-		}
-		/* Remove the extension from the string. */
-		for (uint i = 0; i < 2; i++) {
-			p = strrchr(tmp, '.');
-			check_and_terminate(p);
-		}
-
-		/* Copy the string, without extension, to the filename. */
-		strecpy(this->curInfo->filename, tmp, lastof(this->curInfo->filename));
+		ContentHTTPDownload *download = ParseHTTPContentLine(str);
+		if (download != NULL) *this->http_downloads.Append() = download;
+	}
 
-		/* Request the next file. */
-		if (!this->BeforeDownload()) {
-			this->OnFailure();
-			return;
-		}
+	this->http_response.Reset();
+	this->http_response_index = -2;
 
-		NetworkHTTPSocketHandler::Connect(str, this);
+	if (this->http_downloads.Length() == 0) {
+		this->OnFailure();
 		return;
 	}
 
-#undef check
-#undef check_and_terminate
+	this->StartHTTPDownloads();
 }
 
 /**
@@ -678,6 +917,8 @@ ClientNetworkContentSocketHandler::~ClientNetworkContentSocketHandler()
 	delete this->curInfo;
 	if (this->curFile != NULL) fclose(this->curFile);
 
+	for (ContentHTTPDownload **iter = this->http_downloads.Begin(); iter != this->http_downloads.End(); iter++) delete *iter;
+
 	for (ContentIterator iter = this->infos.Begin(); iter != this->infos.End(); iter++) delete *iter;
 }
 
@@ -732,7 +973,7 @@ void ClientNetworkContentSocketHandler::SendReceive()
 {
 	if (this->sock == INVALID_SOCKET || this->isConnecting) return;
 
-	if (this->lastActivity + IDLE_TIMEOUT < _realtime_tick) {
+	if (_realtime_tick - this->lastActivity > IDLE_TIMEOUT) {
 		this->Close();
 		return;
 	}
@@ -61,6 +61,8 @@ struct ContentCallback {
 	virtual ~ContentCallback() {}
 };
 
+class ContentHTTPDownload;
+
 /**
  * Socket handler for the content server connection
  */
@@ -72,6 +74,7 @@ protected:
 	ContentVector infos;                         ///< All content info we received
 	SmallVector<char, 1024> http_response;       ///< The HTTP response to the requests we've been doing
 	int http_response_index;                     ///< Where we are, in the response, with handling it
+	SmallVector<ContentHTTPDownload *, 4> http_downloads; ///< The files that are (still to be) downloaded over HTTP
 
 	FILE *curFile;        ///< Currently downloaded file
 	ContentInfo *curInfo; ///< Information about the currently downloaded file
@@ -79,6 +82,7 @@ protected:
 	uint32 lastActivity;  ///< The last time there was network activity
 
 	friend class NetworkContentConnecter;
+	friend class ContentHTTPDownload;
 
 	DECLARE_CONTENT_RECEIVE_COMMAND(PACKET_CONTENT_SERVER_INFO);
 	DECLARE_CONTENT_RECEIVE_COMMAND(PACKET_CONTENT_SERVER_CONTENT);
@@ -99,6 +103,8 @@ protected:
 	void AfterDownload();
 
 	void DownloadSelectedContentHTTP(const ContentIDList &content);
+	void StartHTTPDownloads();
+	void OnHTTPDownloadDone(ContentHTTPDownload *download);
 	void DownloadSelectedContentFallback(const ContentIDList &content);
 public:
 	/** The idle timeout; when to close the connection because it's idle. */
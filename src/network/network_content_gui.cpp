@@ -58,6 +58,7 @@ struct NetworkContentDownloadStatusWindow : public Window, ContentCallback {
 private:
 	ClientNetworkContentSocketHandler *connection; ///< Our connection with the content server
 	SmallVector<ContentType, 4> receivedTypes;     ///< Types we received so we can update their cache
+	SmallVector<ContentID, 16> receivedIDs;        ///< Content we received data of; files are downloaded at the same time
 
 	uint total_files;      ///< Number of files to download
 	uint downloaded_files; ///< Number of files downloaded
@@ -182,7 +183,7 @@ public:
 		if (ci->id != this->cur_id) {
 			strecpy(this->name, ci->filename, lastof(this->name));
 			this->cur_id = ci->id;
-			this->downloaded_files++;
+			if (!this->receivedIDs.Include(ci->id)) this->downloaded_files++;
 			this->receivedTypes.Include(ci->type);
 		}
 		this->downloaded_bytes += bytes;
@@ -41,6 +41,7 @@ void NetworkReboot();
 void NetworkDisconnect(bool blocking = false);
 void NetworkGameLoop();
 void NetworkUDPGameLoop();
+bool NetworkWaitForPackets(uint timeout);
 void NetworkUDPCloseAll();
 void ParseConnectionString(const char **company, const char **port, char *connection_string);
 void NetworkStartDebugLog(NetworkAddress address);
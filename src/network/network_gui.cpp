@@ -29,6 +29,7 @@
 #include "../company_base.h"
 #include "../company_func.h"
 #include "../core/geometry_func.hpp"
+#include "../map_type.h"
 
 #include "table/strings.h"
 #include "../table/sprites.h"
@@ -509,8 +510,8 @@ public:
 
 			case NGWW_MAPSIZE:
 				size->width += 2 * WD_SORTBUTTON_ARROW_WIDTH; // Make space for the arrow
-				SetDParam(0, 2048);
-				SetDParam(1, 2048);
+				SetDParam(0, MAX_MAP_SIZE);
+				SetDParam(1, MAX_MAP_SIZE);
 				*size = maxdim(*size, GetStringBoundingBox(STR_NETWORK_SERVER_LIST_MAP_SIZE_SHORT));
 				break;
 
@@ -2128,6 +2129,18 @@ uint8 _network_join_waiting;
 uint32 _network_join_bytes;
 uint32 _network_join_bytes_total;
 
+/**
+ * Get the string describing a join status.
+ * @param status the status
+ * @return the string
+ */
+static StringID GetJoinStatusString(NetworkJoinStatus status)
+{
+	/* The other strings are in the order of the statuses. */
+	if (status == NETWORK_JOIN_STATUS_CATCHING_UP) return STR_NETWORK_CONNECTING_CATCHING_UP;
+	return STR_NETWORK_CONNECTING_1 + status;
+}
+
 /** Widgets used for the join status window. */
 enum NetworkJoinStatusWidgets {
 	NJSW_BACKGROUND, ///< Background
@@ -2153,7 +2166,7 @@ struct NetworkJoinStatusWindow : Window {
 		if (widget != NJSW_BACKGROUND) return;
 
 		uint8 progress; // used for progress bar
-		DrawString(r.left + 2, r.right - 2, r.top + 20, STR_NETWORK_CONNECTING_1 + _network_join_status, TC_FROMSTRING, SA_HOR_CENTER);
+		DrawString(r.left + 2, r.right - 2, r.top + 20, GetJoinStatusString(_network_join_status), TC_FROMSTRING, SA_HOR_CENTER);
 		switch (_network_join_status) {
 			case NETWORK_JOIN_STATUS_CONNECTING: case NETWORK_JOIN_STATUS_AUTHORIZING:
 			case NETWORK_JOIN_STATUS_GETTING_COMPANY_INFO:
@@ -2164,6 +2177,16 @@ struct NetworkJoinStatusWindow : Window {
 				DrawString(r.left + 2, r.right - 2, r.top + 20 + FONT_HEIGHT_NORMAL, STR_NETWORK_CONNECTING_WAITING, TC_FROMSTRING, SA_HOR_CENTER);
 				progress = 15; // third stage is 15%
 				break;
+			case NETWORK_JOIN_STATUS_CATCHING_UP: {
+				/* The server keeps on going while we catch up */
+				uint32 total = max<uint32>(_frame_counter_server - _network_catch_up_start, 1);
+				uint32 done = min<uint32>(_frame_counter - _network_catch_up_start, total);
+				SetDParam(0, done);
+				SetDParam(1, total);
+				DrawString(r.left + 2, r.right - 2, r.top + 20 + FONT_HEIGHT_NORMAL, STR_NETWORK_CONNECTING_CATCHING_UP_FRAMES, TC_FROMSTRING, SA_HOR_CENTER);
+				progress = (uint8)((uint64)done * 100 / total);
+				break;
+			}
 			case NETWORK_JOIN_STATUS_DOWNLOADING:
 				SetDParam(0, _network_join_bytes);
 				SetDParam(1, _network_join_bytes_total);
@@ -2186,7 +2209,7 @@ struct NetworkJoinStatusWindow : Window {
 		/* Account for the statuses */
 		uint width = 0;
 		for (uint i = 0; i < NETWORK_JOIN_STATUS_END; i++) {
-			width = max(width, GetStringBoundingBox(STR_NETWORK_CONNECTING_1 + i).width);
+			width = max(width, GetStringBoundingBox(GetJoinStatusString((NetworkJoinStatus)i)).width);
 		}
 
 		/* For the number of waiting (other) players */
@@ -2198,6 +2221,11 @@ struct NetworkJoinStatusWindow : Window {
 		SetDParam(1, 10000000);
 		width = max(width, GetStringBoundingBox(STR_NETWORK_CONNECTING_DOWNLOADING).width);
 
+		/* Account for catching up ~ 100 game days */
+		SetDParam(0, 10000000);
+		SetDParam(1, 10000000);
+		width = max(width, GetStringBoundingBox(STR_NETWORK_CONNECTING_CATCHING_UP_FRAMES).width);
+
 		/* Give a bit more clearing for the widest strings than strictly needed */
 		size->width = width + WD_FRAMERECT_LEFT + WD_FRAMERECT_BOTTOM + 10;
 	}
@@ -66,6 +66,7 @@ enum NetworkJoinStatus {
 	NETWORK_JOIN_STATUS_REGISTERING,
 
 	NETWORK_JOIN_STATUS_GETTING_COMPANY_INFO,
+	NETWORK_JOIN_STATUS_CATCHING_UP,
 	NETWORK_JOIN_STATUS_END,
 };
 
@@ -130,6 +131,7 @@ extern NetworkJoinStatus _network_join_status;
 extern uint8 _network_join_waiting;
 extern uint32 _network_join_bytes;
 extern uint32 _network_join_bytes_total;
+extern uint32 _network_catch_up_start;
 
 extern uint8 _network_reconnect;
 
@@ -165,6 +167,9 @@ void NetworkExecuteLocalCommandQueue();
 void NetworkFreeLocalCommandQueue();
 void NetworkSyncCommandQueue(NetworkClientSocket *cs);
 
+/* from network_server.cpp */
+void NetworkServerReleaseMapSnapshot(NetworkClientSocket *cs);
+
 /* from network.c */
 NetworkRecvStatus NetworkCloseClient(NetworkClientSocket *cs, NetworkRecvStatus status);
 void NetworkTextMessage(NetworkAction action, ConsoleColour colour, bool self_send, const char *name, const char *str = "", int64 data = 0);
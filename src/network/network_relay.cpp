@@ -0,0 +1,288 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file network_relay.cpp Relaying the game of a server to spectators.
+ *
+ * A relay is a dedicated instance that joins a server as a spectator, like
+ * any other client. Once it is in sync it listens for clients itself and
+ * serves them as spectators: they get the map from the relay, and the
+ * frames, commands and messages of the server are passed on to them as the
+ * relay receives them. Nothing the spectators send is passed on to the
+ * server, so the server only has the relay as client, however many
+ * spectators watch the game.
+ */
+
+#ifdef ENABLE_NETWORK
+
+#include "../stdafx.h"
+#include "../debug.h"
+#include "../string_func.h"
+#include "../settings_type.h"
+#include "network_relay.h"
+#include "network_server.h"
+#include "network_base.h"
+
+static Packet *_relay_company_update = NULL; ///< The last PACKET_SERVER_COMPANY_UPDATE of the server, for new spectators.
+static Packet *_relay_config_update = NULL;  ///< The last PACKET_SERVER_CONFIG_UPDATE of the server, for new spectators.
+
+/**
+ * Make a copy of a packet that can be sent.
+ * @param p the packet, as received or as made to be sent
+ * @return the copy
+ */
+static Packet *NetworkRelayCopyPacket(const Packet *p)
+{
+	Packet *copy = new Packet((PacketType)p->buffer[sizeof(PacketSize)]);
+	memcpy(copy->buffer, p->buffer, p->size);
+	copy->size = p->size;
+	return copy;
+}
+
+/**
+ * Remember a packet of the server for the spectators that join later.
+ * @param store where to remember it
+ * @param p     the packet
+ */
+static void NetworkRelayRemember(Packet **store, const Packet *p)
+{
+	delete *store;
+	*store = NetworkRelayCopyPacket(p);
+}
+
+/**
+ * Pass a packet of the server on to the spectators. The spectators that are
+ * still downloading or loading the map get it once they have loaded it.
+ * @param p the packet, as received from the server
+ */
+void NetworkRelayForward(const Packet *p)
+{
+	switch (p->buffer[sizeof(PacketSize)]) {
+		case PACKET_SERVER_COMPANY_UPDATE:
+			NetworkRelayRemember(&_relay_company_update, p);
+			break;
+
+		case PACKET_SERVER_CONFIG_UPDATE:
+			NetworkRelayRemember(&_relay_config_update, p);
+			break;
+
+		case PACKET_SERVER_CLIENT_INFO:
+		case PACKET_SERVER_JOIN:
+		case PACKET_SERVER_FRAME:
+		case PACKET_SERVER_SYNC:
+		case PACKET_SERVER_COMMAND:
+		case PACKET_SERVER_CHAT:
+		case PACKET_SERVER_QUIT:
+		case PACKET_SERVER_ERROR_QUIT:
+		case PACKET_SERVER_SHUTDOWN:
+		case PACKET_SERVER_NEWGAME:
+		case PACKET_SERVER_MOVE:
+			break;
+
+		/* The handshake and the map are between the server and us only. */
+		default: return;
+	}
+
+	NetworkClientSocket *cs;
+	FOR_ALL_CLIENT_SOCKETS(cs) {
+		if (!NetworkIsRelaySpectator(cs)) continue;
+
+		if (cs->status == STATUS_ACTIVE) {
+			cs->Send_Packet(NetworkRelayCopyPacket(p));
+		} else if (cs->status >= STATUS_MAP) {
+			/* The map is saved already; everything after that has to follow once it is loaded. */
+			Packet *copy = NetworkRelayCopyPacket(p);
+			if (cs->relay_backlog == NULL) {
+				cs->relay_backlog = copy;
+			} else {
+				cs->relay_backlog_last->next = copy;
+			}
+			cs->relay_backlog_last = copy;
+		}
+	}
+}
+
+/** Forget everything about the server that was remembered for new spectators. */
+void NetworkRelayReset()
+{
+	delete _relay_company_update;
+	_relay_company_update = NULL;
+	delete _relay_config_update;
+	_relay_config_update = NULL;
+}
+
+/**
+ * Tell a spectator it may join, as the server tells us.
+ * @param cs the spectator
+ * @return the status of the connection
+ */
+static NetworkRecvStatus NetworkRelaySendWelcome(NetworkClientSocket *cs)
+{
+	cs->status = STATUS_AUTHORIZED;
+
+	Packet *p = new Packet(PACKET_SERVER_WELCOME);
+	p->Send_uint32(cs->client_id);
+	p->Send_uint32(_settings_game.game_creation.generation_seed);
+	p->Send_string(_settings_client.network.network_id);
+	cs->Send_Packet(p);
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/**
+ * A spectator wants to join.
+ * @param cs the spectator
+ * @param p  the packet with its revision and name
+ * @return the status of the connection
+ */
+static NetworkRecvStatus NetworkRelayReceiveJoin(NetworkClientSocket *cs, Packet *p)
+{
+	if (cs->status != STATUS_INACTIVE) return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_NOT_EXPECTED);
+
+	char client_revision[NETWORK_REVISION_LENGTH];
+	p->Recv_string(client_revision, sizeof(client_revision));
+	if (!IsNetworkCompatibleVersion(client_revision)) return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_WRONG_REVISION);
+
+	char name[NETWORK_CLIENT_NAME_LENGTH];
+	p->Recv_string(name, sizeof(name));
+	CompanyID playas = (Owner)p->Recv_uint8();
+	NetworkLanguage client_lang = (NetworkLanguage)p->Recv_uint8();
+
+	/* A relay can't pass the commands of a company on to the server. */
+	if (playas != COMPANY_SPECTATOR) return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_NOT_AUTHORIZED);
+
+	if (StrEmpty(name)) strecpy(name, "Spectator", lastof(name));
+	if (!NetworkFindName(name)) return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_NAME_IN_USE);
+
+	NetworkClientInfo *ci = cs->GetInfo();
+	strecpy(ci->client_name, name, lastof(ci->client_name));
+	ci->client_playas = COMPANY_SPECTATOR;
+	ci->client_lang = client_lang;
+
+	if (_grfconfig == NULL) return NetworkRelaySendWelcome(cs);
+
+	cs->status = STATUS_NEWGRFS_CHECK;
+	return SEND_COMMAND(PACKET_SERVER_CHECK_NEWGRFS)(cs);
+}
+
+/**
+ * A spectator has loaded the map; give it everything it missed since the
+ * map was saved, and from then on everything the server sends.
+ * @param cs the spectator
+ * @return the status of the connection
+ */
+static NetworkRecvStatus NetworkRelayReceiveMapOk(NetworkClientSocket *cs)
+{
+	if (cs->status != STATUS_DONE_MAP) return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_NOT_EXPECTED);
+
+	cs->status = STATUS_ACTIVE;
+
+	/* First the commands that were waiting to be executed when the map was saved... */
+	NetworkHandleCommandQueue(cs);
+
+	/* ... then everything the server sent after that, in the same order. */
+	while (cs->relay_backlog != NULL) {
+		Packet *p = cs->relay_backlog;
+		cs->relay_backlog = p->next;
+		p->next = NULL;
+		cs->Send_Packet(p);
+	}
+	cs->relay_backlog_last = NULL;
+
+	/* The clients of the server and the spectator itself; not the other spectators of the relay. */
+	NetworkClientInfo *ci;
+	FOR_ALL_CLIENT_INFOS(ci) {
+		if (ci->client_id < CLIENT_ID_RELAY_FIRST || ci == cs->GetInfo()) SEND_COMMAND(PACKET_SERVER_CLIENT_INFO)(cs, ci);
+	}
+	if (_relay_company_update != NULL) cs->Send_Packet(NetworkRelayCopyPacket(_relay_company_update));
+	if (_relay_config_update != NULL) cs->Send_Packet(NetworkRelayCopyPacket(_relay_config_update));
+
+	/* In case the server sent no frame since the map was saved. */
+	Packet *p = new Packet(PACKET_SERVER_FRAME);
+	p->Send_uint32(_frame_counter_server);
+	p->Send_uint32(_frame_counter_max);
+#ifdef ENABLE_NETWORK_SYNC_EVERY_FRAME
+	p->Send_uint32(_sync_seed_1);
+#ifdef NETWORK_SEND_DOUBLE_SEED
+	p->Send_uint32(_sync_seed_2);
+#endif
+#endif
+	cs->Send_Packet(p);
+
+	DEBUG(net, 1, "[relay] spectator %d joined", cs->client_id);
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/**
+ * Handle a packet of a spectator.
+ * @param cs   the spectator
+ * @param type the type of the packet
+ * @param p    the packet
+ * @return the status of the connection
+ */
+static NetworkRecvStatus NetworkRelayReceivePacket(NetworkClientSocket *cs, PacketType type, Packet *p)
+{
+	switch (type) {
+		case PACKET_CLIENT_JOIN:
+			return NetworkRelayReceiveJoin(cs, p);
+
+		case PACKET_CLIENT_NEWGRFS_CHECKED:
+			if (cs->status != STATUS_NEWGRFS_CHECK) return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_NOT_EXPECTED);
+			return NetworkRelaySendWelcome(cs);
+
+		case PACKET_CLIENT_GETMAP:
+			if (cs->status != STATUS_AUTHORIZED) return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_NOT_AUTHORIZED);
+			return SEND_COMMAND(PACKET_SERVER_MAP)(cs);
+
+		case PACKET_CLIENT_MAP_OK:
+			return NetworkRelayReceiveMapOk(cs);
+
+		case PACKET_CLIENT_ACK:
+			cs->last_frame = p->Recv_uint32();
+			cs->last_frame_server = _frame_counter;
+			return NETWORK_RECV_STATUS_OKAY;
+
+		/* Spectators of a relay can't change anything; nothing is passed on to the server. */
+		case PACKET_CLIENT_COMMAND:
+		case PACKET_CLIENT_CHAT:
+		case PACKET_CLIENT_SET_PASSWORD:
+		case PACKET_CLIENT_SET_NAME:
+		case PACKET_CLIENT_RCON:
+		case PACKET_CLIENT_MOVE:
+			return NETWORK_RECV_STATUS_OKAY;
+
+		case PACKET_CLIENT_QUIT:
+		case PACKET_CLIENT_ERROR:
+			return NetworkCloseClient(cs, NETWORK_RECV_STATUS_CONN_LOST);
+
+		/* The relay can't tell enough about the companies of the server to answer queries. */
+		case PACKET_CLIENT_COMPANY_INFO:
+			return NetworkCloseClient(cs, NETWORK_RECV_STATUS_CLOSE_QUERY);
+
+		default:
+			DEBUG(net, 0, "[relay] received invalid packet type %d", type);
+			return NetworkCloseClient(cs, NETWORK_RECV_STATUS_MALFORMED_PACKET);
+	}
+}
+
+/**
+ * Read and handle the packets of a spectator of this relay.
+ * @param cs the spectator
+ */
+void NetworkRelay_ReadPackets(NetworkClientSocket *cs)
+{
+	Packet *p;
+	NetworkRecvStatus res = NETWORK_RECV_STATUS_OKAY;
+
+	while (res == NETWORK_RECV_STATUS_OKAY && (p = cs->Recv_Packet()) != NULL) {
+		res = NetworkRelayReceivePacket(cs, (PacketType)p->Recv_uint8(), p);
+		delete p;
+	}
+}
+
+#endif /* ENABLE_NETWORK */
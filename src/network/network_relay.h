@@ -0,0 +1,40 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file network_relay.h Relaying the game of a server to spectators. */
+
+#ifndef NETWORK_RELAY_H
+#define NETWORK_RELAY_H
+
+#ifdef ENABLE_NETWORK
+
+#include "network.h"
+#include "network_internal.h"
+
+/** The first client identifier a relay gives to its spectators; far above the ones of the server it relays. */
+static const ClientID CLIENT_ID_RELAY_FIRST = (ClientID)0x40000000;
+
+/**
+ * Is a client socket one of the spectators of a relay?
+ * @param cs the client socket
+ * @return false for the connection of a relay to the server it relays, and when we aren't relaying
+ */
+static inline bool NetworkIsRelaySpectator(const NetworkClientSocket *cs)
+{
+	/* The connection to the server is made before anyone can connect to us, so it is always the first. */
+	return _network_relay && cs->index != 0;
+}
+
+void NetworkRelayForward(const Packet *p);
+void NetworkRelay_ReadPackets(NetworkClientSocket *cs);
+void NetworkRelayReset();
+
+#endif /* ENABLE_NETWORK */
+
+#endif /* NETWORK_RELAY_H */
@@ -19,6 +19,7 @@
 #include "network_udp.h"
 #include "network.h"
 #include "network_base.h"
+#include "network_sync_hash.h"
 #include "../console_func.h"
 #include "../company_base.h"
 #include "../command_func.h"
@@ -36,8 +37,6 @@
 
 /* This file handles all the server-commands */
 
-static void NetworkHandleCommandQueue(NetworkClientSocket *cs);
-
 /***********
  * Sending functions
  *   DEF_SERVER_SEND_COMMAND has parameter: NetworkClientSocket *cs
@@ -281,31 +280,118 @@ DEF_SERVER_SEND_COMMAND(PACKET_SERVER_WELCOME)
 	return SEND_COMMAND(PACKET_SERVER_CLIENT_INFO)(cs, NetworkFindClientInfoFromClientID(CLIENT_ID_SERVER));
 }
 
-DEF_SERVER_SEND_COMMAND(PACKET_SERVER_WAIT)
+/**
+ * A savegame of the game kept in memory. It is shared by all clients that
+ * start downloading the map in the same frame, so the game is saved only
+ * once for all of them.
+ */
+struct NetworkMapSnapshot {
+	byte *data;   ///< The savegame.
+	size_t size;  ///< The number of bytes of #data.
+	uint32 frame; ///< The frame the game was saved in.
+	uint refs;    ///< The number of clients downloading the savegame.
+};
+
+/** The snapshot of the game that clients starting to download the map get, or NULL when there is none. */
+static NetworkMapSnapshot *_network_map_snapshot = NULL;
+
+/**
+ * Get the snapshot of the game in the current frame, saving the game if
+ * there is none yet, and add the client to the ones downloading it.
+ * @param cs the client that starts downloading the map
+ */
+static void NetworkAcquireMapSnapshot(NetworkClientSocket *cs)
 {
-	/*
-	 * Packet: PACKET_SERVER_WAIT
-	 * Function: The client can not receive the map at the moment because
-	 *             someone else is already receiving the map
-	 * Data:
-	 *    uint8:  Clients awaiting map
-	 */
-	int waiting = 0;
-	NetworkClientSocket *new_cs;
-	Packet *p;
+	assert(cs->map_snapshot == NULL);
 
-	/* Count how many clients are waiting in the queue */
-	FOR_ALL_CLIENT_SOCKETS(new_cs) {
-		if (new_cs->status == STATUS_MAP_WAIT) waiting++;
+	if (_network_map_snapshot == NULL || _network_map_snapshot->frame != _frame_counter) {
+		NetworkMapSnapshot *snapshot = new NetworkMapSnapshot();
+		if (SaveToMemory(&snapshot->data, &snapshot->size) != SL_OK) usererror("network savedump failed");
+		if (snapshot->size == 0) usererror("network savedump failed - zero sized savegame?");
+		snapshot->frame = _frame_counter;
+		snapshot->refs = 0;
+
+		/* Clients still downloading the old snapshot keep it alive. */
+		_network_map_snapshot = snapshot;
 	}
 
-	p = new Packet(PACKET_SERVER_WAIT);
-	p->Send_uint8(waiting);
-	cs->Send_Packet(p);
-	return NETWORK_RECV_STATUS_OKAY;
+	cs->map_snapshot = _network_map_snapshot;
+	cs->map_snapshot->refs++;
+	cs->map_sent = 0;
+}
+
+/**
+ * Remove the client from the ones downloading a snapshot of the game,
+ * and free the snapshot once no client downloads it anymore.
+ * @param cs the client that stops downloading the map
+ */
+void NetworkServerReleaseMapSnapshot(NetworkClientSocket *cs)
+{
+	NetworkMapSnapshot *snapshot = cs->map_snapshot;
+	if (snapshot == NULL) return;
+	cs->map_snapshot = NULL;
+
+	if (--snapshot->refs != 0) return;
+	if (_network_map_snapshot == snapshot) _network_map_snapshot = NULL;
+	free(snapshot->data);
+	delete snapshot;
 }
 
 /* This sends the map to the client */
+/** The rate a map download starts at, in bytes per second. */
+static const uint32 MAP_INITIAL_RATE = 64 * 1024;
+/** The most a map download may have queued, in milliseconds of its rate; in game packets wait behind it. */
+static const uint32 MAP_QUEUE_TIME = 100;
+
+/**
+ * Determine how many bytes of the map may be queued for a client now. The
+ * rate of each download follows how fast its connection drains the queue:
+ * when everything was sent it is probed upwards, otherwise it is what was
+ * drained. Then, at most #MAP_QUEUE_TIME of that rate is kept queued, so
+ * the packets of the game don't wait long behind the map, and all downloads
+ * share network.max_map_upload.
+ * @param cs the client that is downloading the map
+ * @return the number of bytes to queue
+ */
+static size_t NetworkMapSendBudget(NetworkClientSocket *cs)
+{
+	uint32 elapsed = _realtime_tick - cs->map_tick;
+	cs->map_tick = _realtime_tick;
+
+	size_t queued = cs->GetQueuedBytes();
+	if (elapsed != 0) {
+		size_t drained = cs->map_queued > queued ? cs->map_queued - queued : 0;
+		uint32 measured = (uint32)min<uint64>((uint64)drained * 1000 / elapsed, UINT32_MAX / 4);
+
+		if (queued == 0) {
+			/* It all went, so the connection might take more */
+			cs->map_rate = max(cs->map_rate, measured) * 2;
+		} else {
+			/* The connection is what holds us back; follow what it drained, smoothed */
+			cs->map_rate = (cs->map_rate + measured) / 2;
+		}
+		cs->map_rate = Clamp<uint32>(cs->map_rate, SEND_MTU, UINT32_MAX / 4);
+	}
+
+	size_t target = (uint64)cs->map_rate * MAP_QUEUE_TIME / 1000;
+	size_t budget = target > queued ? target - queued : 0;
+
+	if (_settings_client.network.max_map_upload != 0) {
+		uint downloads = 0;
+		const NetworkClientSocket *other;
+		FOR_ALL_CLIENT_SOCKETS(other) {
+			if (other->status == STATUS_MAP) downloads++;
+		}
+
+		size_t share = (uint64)_settings_client.network.max_map_upload * 1024 * max<uint32>(elapsed, 1) / 1000 / max(downloads, 1U);
+		budget = min(budget, share);
+	}
+
+	/* Always keep the download going, however slowly */
+	if (queued == 0) budget = max<size_t>(budget, 1);
+	return budget;
+}
+
 DEF_SERVER_SEND_COMMAND(PACKET_SERVER_MAP)
 {
 	/*
@@ -322,39 +408,25 @@ DEF_SERVER_SEND_COMMAND(PACKET_SERVER_MAP)
 	 *    nothing
 	 */
 
-	static FILE *file_pointer = NULL;
-	static uint sent_packets; // How many packets we did send succecfully last time
-
 	if (cs->status < STATUS_AUTHORIZED) {
 		/* Illegal call, return error and ignore the packet */
 		return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
 	if (cs->status == STATUS_AUTHORIZED) {
-		const char *filename = "network_server.tmp";
-		Packet *p;
-
-		/* Make a dump of the current game */
-		if (SaveOrLoad(filename, SL_SAVE, AUTOSAVE_DIR) != SL_OK) usererror("network savedump failed");
-
-		if (file_pointer != NULL) fclose(file_pointer);
-
-		file_pointer = FioFOpenFile(filename, "rb", AUTOSAVE_DIR);
-		if (file_pointer == NULL) usererror("network savedump failed - could not open just saved dump");
-
-		fseek(file_pointer, 0, SEEK_END);
-		if (ftell(file_pointer) == 0) usererror("network savedump failed - zero sized savegame?");
+		/* Get a dump of the current game */
+		NetworkAcquireMapSnapshot(cs);
 
 		/* Now send the _frame_counter and how many packets are coming */
-		p = new Packet(PACKET_SERVER_MAP);
+		Packet *p = new Packet(PACKET_SERVER_MAP);
 		p->Send_uint8 (MAP_PACKET_START);
-		p->Send_uint32(_frame_counter);
-		p->Send_uint32(ftell(file_pointer));
+		p->Send_uint32(cs->map_snapshot->frame);
+		p->Send_uint32((uint32)cs->map_snapshot->size);
 		cs->Send_Packet(p);
 
-		fseek(file_pointer, 0, SEEK_SET);
-
-		sent_packets = 4; // We start with trying 4 packets
+		cs->map_rate = MAP_INITIAL_RATE;
+		cs->map_queued = cs->GetQueuedBytes();
+		cs->map_tick = _realtime_tick;
 
 		NetworkSyncCommandQueue(cs);
 		cs->status = STATUS_MAP;
@@ -364,19 +436,19 @@ DEF_SERVER_SEND_COMMAND(PACKET_SERVER_MAP)
 	}
 
 	if (cs->status == STATUS_MAP) {
-		uint i;
-		int res;
-		for (i = 0; i < sent_packets; i++) {
+		const NetworkMapSnapshot *snapshot = cs->map_snapshot;
+		size_t budget = NetworkMapSendBudget(cs);
+		for (size_t queued = 0; queued < budget; queued += SEND_MTU) {
 			Packet *p = new Packet(PACKET_SERVER_MAP);
 			p->Send_uint8(MAP_PACKET_NORMAL);
-			res = (int)fread(p->buffer + p->size, 1, SEND_MTU - p->size, file_pointer);
-
-			if (ferror(file_pointer)) usererror("Error reading temporary network savegame!");
-
-			p->size += res;
+			size_t len = min<size_t>(SEND_MTU - p->size, snapshot->size - cs->map_sent);
+			memcpy(p->buffer + p->size, snapshot->data + cs->map_sent, len);
+			p->size += (PacketSize)len;
+			cs->map_sent += len;
 			cs->Send_Packet(p);
-			if (feof(file_pointer)) {
-				/* Done reading! */
+
+			if (cs->map_sent == snapshot->size) {
+				/* Done sending! */
 				Packet *p = new Packet(PACKET_SERVER_MAP);
 				p->Send_uint8(MAP_PACKET_END);
 				cs->Send_Packet(p);
@@ -384,42 +456,15 @@ DEF_SERVER_SEND_COMMAND(PACKET_SERVER_MAP)
 				/* Set the status to DONE_MAP, no we will wait for the client
 				 *  to send it is ready (maybe that happens like never ;)) */
 				cs->status = STATUS_DONE_MAP;
-				fclose(file_pointer);
-				file_pointer = NULL;
-
-				NetworkClientSocket *new_cs;
-				bool new_map_client = false;
-				/* Check if there is a client waiting for receiving the map
-				 *  and start sending him the map */
-				FOR_ALL_CLIENT_SOCKETS(new_cs) {
-					if (new_cs->status == STATUS_MAP_WAIT) {
-						/* Check if we already have a new client to send the map to */
-						if (!new_map_client) {
-							/* If not, this client will get the map */
-							new_cs->status = STATUS_AUTHORIZED;
-							new_map_client = true;
-							SEND_COMMAND(PACKET_SERVER_MAP)(new_cs);
-						} else {
-							/* Else, send the other clients how many clients are in front of them */
-							SEND_COMMAND(PACKET_SERVER_WAIT)(new_cs);
-						}
-					}
-				}
+				NetworkServerReleaseMapSnapshot(cs);
 
 				/* There is no more data, so break the for */
 				break;
 			}
 		}
 
-		/* Send all packets (forced) and check if we have send it all */
 		cs->Send_Packets();
-		if (cs->IsPacketQueueEmpty()) {
-			/* All are sent, increase the sent_packets */
-			sent_packets *= 2;
-		} else {
-			/* Not everything is sent, decrease the sent_packets */
-			if (sent_packets > 1) sent_packets /= 2;
-		}
+		cs->map_queued = cs->GetQueuedBytes();
 	}
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -480,6 +525,9 @@ DEF_SERVER_SEND_COMMAND(PACKET_SERVER_SYNC)
 	 *    uint32: General-seed-1
 	 *    [uint32: general-seed-2]
 	 *      (last one depends on compile-settings, and are not default settings)
+	 *    [uint8:  number of state hashes]
+	 *    [uint32: first object, number of objects, hash]
+	 *      (only when the server hashes the game state)
 	 */
 
 	Packet *p = new Packet(PACKET_SERVER_SYNC);
@@ -489,6 +537,12 @@ DEF_SERVER_SEND_COMMAND(PACKET_SERVER_SYNC)
 #ifdef NETWORK_SEND_DOUBLE_SEED
 	p->Send_uint32(_sync_seed_2);
 #endif
+
+	if (_settings_client.network.sync_state_hash) {
+		/* Hash once per frame, however many clients get it */
+		if (!_sync_hashes.valid || _sync_hashes.frame != _frame_counter) NetworkSyncHashCompute(&_sync_hashes);
+		NetworkSyncHashSend(p, &_sync_hashes);
+	}
 	cs->Send_Packet(p);
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -519,6 +573,45 @@ DEF_SERVER_SEND_COMMAND_PARAM(PACKET_SERVER_COMMAND)(NetworkClientSocket *cs, co
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+DEF_SERVER_SEND_COMMAND_PARAM(PACKET_SERVER_COMMANDS)(NetworkClientSocket *cs)
+{
+	/*
+	 * Packet: SERVER_COMMANDS
+	 * Function: Sends all queued DoCommands to the client, in as few packets as possible
+	 * Data, for every command until the end of the packet:
+	 *    uint8:  Fields that are sent (BatchedCommandFlags)
+	 *    [uint8: CompanyID]
+	 *    [var:   CommandID]
+	 *    [var:   P1, P2 and Tile, as difference to the previous command]
+	 *    [string: text]
+	 *    [uint8: CallBackID]
+	 *    var:    Frame of execution, as difference to the previous command
+	 *  The fields that aren't sent are the same as those of the previous command.
+	 */
+
+	Packet *p = NULL;
+	CommandPacket prev;
+
+	CommandPacket *cp;
+	while ((cp = cs->command_queue.Pop()) != NULL) {
+		if (p != NULL && !cs->Send_BatchedCommand(p, cp, &prev)) {
+			/* Full; the next packet starts over without a previous command */
+			cs->Send_Packet(p);
+			p = NULL;
+		}
+		if (p == NULL) {
+			p = new Packet(PACKET_SERVER_COMMANDS);
+			memset(&prev, 0, sizeof(prev));
+			cs->Send_BatchedCommand(p, cp, &prev);
+		}
+		prev = *cp;
+		free(cp);
+	}
+
+	if (p != NULL) cs->Send_Packet(p);
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 DEF_SERVER_SEND_COMMAND_PARAM(PACKET_SERVER_CHAT)(NetworkClientSocket *cs, NetworkAction action, ClientID client_id, bool self_send, const char *msg, int64 data)
 {
 	/*
@@ -703,6 +796,8 @@ DEF_SERVER_RECEIVE_COMMAND(PACKET_CLIENT_JOIN)
 	p->Recv_string(name, sizeof(name));
 	playas = (Owner)p->Recv_uint8();
 	client_lang = (NetworkLanguage)p->Recv_uint8();
+	/* Older clients end here */
+	cs->batched_commands = p->pos < p->size && p->Recv_bool();
 
 	if (cs->HasClientQuit()) return NETWORK_RECV_STATUS_CONN_LOST;
 
@@ -802,8 +897,6 @@ DEF_SERVER_RECEIVE_COMMAND(PACKET_CLIENT_COMPANY_PASSWORD)
 
 DEF_SERVER_RECEIVE_COMMAND(PACKET_CLIENT_GETMAP)
 {
-	NetworkClientSocket *new_cs;
-
 	/* Do an extra version match. We told the client our version already,
 	 * lets confirm that the client isn't lieing to us.
 	 * But only do it for stable releases because of those we are sure
@@ -829,15 +922,6 @@ DEF_SERVER_RECEIVE_COMMAND(PACKET_CLIENT_GETMAP)
 		return SEND_COMMAND(PACKET_SERVER_ERROR)(cs, NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
-	/* Check if someone else is receiving the map */
-	FOR_ALL_CLIENT_SOCKETS(new_cs) {
-		if (new_cs->status == STATUS_MAP) {
-			/* Tell the new client to wait */
-			cs->status = STATUS_MAP_WAIT;
-			return SEND_COMMAND(PACKET_SERVER_WAIT)(cs);
-		}
-	}
-
 	/* We receive a request to upload the map.. give it to the client! */
 	return SEND_COMMAND(PACKET_SERVER_MAP)(cs);
 }
@@ -1338,6 +1422,7 @@ static NetworkServerPacket * const _network_server_packet[] = {
 	RECEIVE_COMMAND(PACKET_CLIENT_MOVE),
 	NULL, // PACKET_SERVER_COMPANY_UPDATE,
 	NULL, // PACKET_SERVER_CONFIG_UPDATE,
+	NULL, // PACKET_SERVER_COMMANDS,
 };
 
 /* If this fails, check the array above with network_data.h */
@@ -1392,36 +1477,29 @@ void NetworkSocketHandler::Send_CompanyInformation(Packet *p, const Company *c,
  */
 void NetworkPopulateCompanyStats(NetworkCompanyStats *stats)
 {
-	const Vehicle *v;
-	const Station *s;
-
 	memset(stats, 0, sizeof(*stats) * MAX_COMPANIES);
 
-	/* Go through all vehicles and count the type of vehicles */
-	FOR_ALL_VEHICLES(v) {
-		if (!Company::IsValidID(v->owner) || !v->IsPrimaryVehicle()) continue;
-		byte type = 0;
-		switch (v->type) {
-			case VEH_TRAIN: type = NETWORK_VEH_TRAIN; break;
-			case VEH_ROAD: type = RoadVehicle::From(v)->IsBus() ? NETWORK_VEH_BUS : NETWORK_VEH_LORRY; break;
-			case VEH_AIRCRAFT: type = NETWORK_VEH_PLANE; break;
-			case VEH_SHIP: type = NETWORK_VEH_SHIP; break;
-			default: continue;
-		}
-		stats[v->owner].num_vehicle[type]++;
-	}
-
-	/* Go through all stations and count the types of stations */
-	FOR_ALL_STATIONS(s) {
-		if (Company::IsValidID(s->owner)) {
-			NetworkCompanyStats *npi = &stats[s->owner];
+	CompanyAssetStats assets[MAX_COMPANIES];
+	GetCompanyAssetStats(assets);
 
-			if (s->facilities & FACIL_TRAIN)      npi->num_station[NETWORK_VEH_TRAIN]++;
-			if (s->facilities & FACIL_TRUCK_STOP) npi->num_station[NETWORK_VEH_LORRY]++;
-			if (s->facilities & FACIL_BUS_STOP)   npi->num_station[NETWORK_VEH_BUS]++;
-			if (s->facilities & FACIL_AIRPORT)    npi->num_station[NETWORK_VEH_PLANE]++;
-			if (s->facilities & FACIL_DOCK)       npi->num_station[NETWORK_VEH_SHIP]++;
-		}
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		const CompanyAssetStats *a = &assets[c->index];
+		NetworkCompanyStats *npi = &stats[c->index];
+
+		/* The types of the vehicles */
+		npi->num_vehicle[NETWORK_VEH_TRAIN] = a->num_vehicles[VEH_TRAIN];
+		npi->num_vehicle[NETWORK_VEH_LORRY] = a->num_vehicles[VEH_ROAD] - a->num_buses;
+		npi->num_vehicle[NETWORK_VEH_BUS]   = a->num_buses;
+		npi->num_vehicle[NETWORK_VEH_PLANE] = a->num_vehicles[VEH_AIRCRAFT];
+		npi->num_vehicle[NETWORK_VEH_SHIP]  = a->num_vehicles[VEH_SHIP];
+
+		/* The types of the stations */
+		npi->num_station[NETWORK_VEH_TRAIN] = a->num_stations[FindFirstBit(FACIL_TRAIN)];
+		npi->num_station[NETWORK_VEH_LORRY] = a->num_stations[FindFirstBit(FACIL_TRUCK_STOP)];
+		npi->num_station[NETWORK_VEH_BUS]   = a->num_stations[FindFirstBit(FACIL_BUS_STOP)];
+		npi->num_station[NETWORK_VEH_PLANE] = a->num_stations[FindFirstBit(FACIL_AIRPORT)];
+		npi->num_station[NETWORK_VEH_SHIP]  = a->num_stations[FindFirstBit(FACIL_DOCK)];
 	}
 }
 
@@ -1587,13 +1665,22 @@ bool NetworkServerChangeClientName(ClientID client_id, const char *new_name)
 	return true;
 }
 
+/**
+ * The maximum number of packets read from one client each time the sockets are
+ * polled. The rest stays in the buffers of the socket, which is then reported
+ * as readable again by the next poll; this way a client that floods the server
+ * with packets can not stall the game loop, nor the handling of other clients.
+ */
+static const uint MAX_PACKETS_PER_RECEIVE = 64;
+
 /* Reads a packet from the stream */
 void NetworkServer_ReadPackets(NetworkClientSocket *cs)
 {
 	Packet *p;
 	NetworkRecvStatus res = NETWORK_RECV_STATUS_OKAY;
+	uint budget = MAX_PACKETS_PER_RECEIVE;
 
-	while (res == NETWORK_RECV_STATUS_OKAY && (p = cs->Recv_Packet()) != NULL) {
+	while (res == NETWORK_RECV_STATUS_OKAY && budget-- > 0 && (p = cs->Recv_Packet()) != NULL) {
 		byte type = p->Recv_uint8();
 		if (type < PACKET_END && _network_server_packet[type] != NULL && !cs->HasClientQuit()) {
 			res = _network_server_packet[type](cs, p);
@@ -1608,14 +1695,17 @@ void NetworkServer_ReadPackets(NetworkClientSocket *cs)
 }
 
 /* Handle the local command-queue */
-static void NetworkHandleCommandQueue(NetworkClientSocket *cs)
+void NetworkHandleCommandQueue(NetworkClientSocket *cs)
 {
+	if (cs->batched_commands) {
+		SEND_COMMAND(PACKET_SERVER_COMMANDS)(cs);
+		return;
+	}
+
 	CommandPacket *cp;
 
-	while ( (cp = cs->command_queue) != NULL) {
+	while ( (cp = cs->command_queue.Pop()) != NULL) {
 		SEND_COMMAND(PACKET_SERVER_COMMAND)(cs, cp);
-
-		cs->command_queue = cp->next;
 		free(cp);
 	}
 }
@@ -0,0 +1,237 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file network_sync_hash.cpp Hashes of parts of the game state, to find where a desync starts.
+ *
+ * When enabled, the server adds hashes of the vehicles, the cargo waiting at
+ * stations, the money of the companies and the map to its sync packets. Each
+ * sync only hashes the next range of the vehicles, stations and tiles, so a
+ * check stays cheap however large the game is, and every object is checked
+ * once in a while. The clients hash the same ranges at the same frame, and
+ * report the part and range that differs as soon as it differs.
+ */
+
+#ifdef ENABLE_NETWORK
+
+#include "../stdafx.h"
+#include "../debug.h"
+#include "../map_func.h"
+#include "../vehicle_base.h"
+#include "../station_base.h"
+#include "../company_base.h"
+#include "../console_func.h"
+#include "network_internal.h"
+#include "network_sync_hash.h"
+
+SyncHashes _sync_hashes; ///< The hashes of the last sync; computed by the server, received by the clients.
+
+/** The number of objects of each part that are hashed per sync. */
+static const uint32 _sync_hash_slice[SHP_END] = {
+	256,           // SHP_VEHICLES
+	64,            // SHP_STATION_CARGO
+	MAX_COMPANIES, // SHP_COMPANIES
+	1 << 14,       // SHP_MAP
+};
+
+/** The names of the parts, for the reports. */
+static const char * const _sync_hash_part_names[SHP_END] = {
+	"vehicles",
+	"station cargo",
+	"companies",
+	"tiles",
+};
+
+/**
+ * Add a value to a hash (FNV-1a on words).
+ * @param hash  the hash so far
+ * @param value the value to add
+ * @return the new hash
+ */
+static inline uint32 SyncHashAdd(uint32 hash, uint32 value)
+{
+	return (hash ^ value) * 16777619U;
+}
+
+/**
+ * Get the number of objects a part has.
+ * @param part the part
+ * @return the number of indices or tiles
+ */
+static uint32 SyncHashPartSize(SyncHashPart part)
+{
+	switch (part) {
+		case SHP_VEHICLES:      return (uint32)Vehicle::GetPoolSize();
+		case SHP_STATION_CARGO: return (uint32)Station::GetPoolSize();
+		case SHP_COMPANIES:     return MAX_COMPANIES;
+		case SHP_MAP:           return MapSize();
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Hash a range of objects of a part of the game state.
+ * @param part  the part
+ * @param first the first object
+ * @param count the number of objects
+ * @return the hash
+ */
+static uint32 SyncHashRange(SyncHashPart part, uint32 first, uint32 count)
+{
+	uint32 hash = 2166136261U;
+	uint32 end = min(first + count, SyncHashPartSize(part));
+
+	for (uint32 i = first; i < end; i++) {
+		switch (part) {
+			case SHP_VEHICLES: {
+				const Vehicle *v = Vehicle::GetIfValid(i);
+				if (v == NULL) continue;
+				hash = SyncHashAdd(hash, i);
+				hash = SyncHashAdd(hash, v->type | v->owner << 8 | v->direction << 16);
+				hash = SyncHashAdd(hash, v->tile);
+				hash = SyncHashAdd(hash, v->x_pos);
+				hash = SyncHashAdd(hash, v->y_pos);
+				hash = SyncHashAdd(hash, v->z_pos | v->progress << 8 | v->cur_speed << 16);
+				hash = SyncHashAdd(hash, v->cargo.Count());
+				break;
+			}
+
+			case SHP_STATION_CARGO: {
+				const Station *st = Station::GetIfValid(i);
+				if (st == NULL) continue;
+				hash = SyncHashAdd(hash, i);
+				for (CargoID c = 0; c < NUM_CARGO; c++) {
+					const GoodsEntry *ge = &st->goods[c];
+					hash = SyncHashAdd(hash, ge->cargo.Count());
+					hash = SyncHashAdd(hash, ge->acceptance_pickup | ge->days_since_pickup << 8 | ge->rating << 16);
+				}
+				break;
+			}
+
+			case SHP_COMPANIES: {
+				const Company *c = Company::GetIfValid(i);
+				if (c == NULL) continue;
+				hash = SyncHashAdd(hash, i);
+				hash = SyncHashAdd(hash, GB(c->money, 0, 32));
+				hash = SyncHashAdd(hash, GB(c->money, 32, 32));
+				hash = SyncHashAdd(hash, GB(c->current_loan, 0, 32));
+				hash = SyncHashAdd(hash, GB(c->current_loan, 32, 32));
+				break;
+			}
+
+			case SHP_MAP:
+				hash = SyncHashAdd(hash, _m[i].type_height | _m[i].m1 << 8 | _m[i].m2 << 16);
+				hash = SyncHashAdd(hash, _m[i].m3 | _m[i].m4 << 8 | _m[i].m5 << 16 | _m[i].m6 << 24);
+				hash = SyncHashAdd(hash, _me[i].m7);
+				break;
+
+			default: NOT_REACHED();
+		}
+	}
+
+	return hash;
+}
+
+/**
+ * Hash the next range of every part of the game state at the current frame; for the server.
+ * @param hashes where to put the hashes
+ */
+void NetworkSyncHashCompute(SyncHashes *hashes)
+{
+	/* Where the next range of each part starts. */
+	static uint32 next[SHP_END];
+
+	for (SyncHashPart part = SHP_VEHICLES; part < SHP_END; part++) {
+		uint32 size = SyncHashPartSize(part);
+		if (next[part] >= size) next[part] = 0;
+
+		SyncHash *h = &hashes->parts[part];
+		h->first = next[part];
+		h->count = min(_sync_hash_slice[part], size - h->first);
+		h->hash = SyncHashRange(part, h->first, h->count);
+
+		next[part] += h->count;
+	}
+	hashes->valid = true;
+	hashes->frame = _frame_counter;
+}
+
+/**
+ * Add the hashes to a sync packet.
+ * @param p      the packet
+ * @param hashes the hashes
+ */
+void NetworkSyncHashSend(Packet *p, const SyncHashes *hashes)
+{
+	p->Send_uint8(SHP_END);
+	for (SyncHashPart part = SHP_VEHICLES; part < SHP_END; part++) {
+		const SyncHash *h = &hashes->parts[part];
+		p->Send_uint32(h->first);
+		p->Send_uint32(h->count);
+		p->Send_uint32(h->hash);
+	}
+}
+
+/**
+ * Read the hashes of a sync packet, if the server sent them.
+ * @param p      the packet, after the seeds
+ * @param frame  the frame of the sync
+ * @param hashes where to put the hashes
+ */
+void NetworkSyncHashRecv(Packet *p, uint32 frame, SyncHashes *hashes)
+{
+	hashes->frame = frame;
+
+	/* Servers that don't hash the state don't send anything after the seeds. */
+	hashes->valid = p->pos < p->size;
+	if (!hashes->valid) return;
+
+	uint parts = p->Recv_uint8();
+	for (uint i = 0; i < parts; i++) {
+		SyncHash h;
+		h.first = p->Recv_uint32();
+		h.count = p->Recv_uint32();
+		h.hash = p->Recv_uint32();
+
+		/* Parts of newer servers that we don't know */
+		if (i < SHP_END) hashes->parts[i] = h;
+	}
+	/* And the parts that older servers don't know */
+	for (uint i = parts; i < SHP_END; i++) hashes->parts[i].count = 0;
+}
+
+/**
+ * Compare the hashes of the server with those of our game state, and report
+ * the parts that differ.
+ * @param hashes the hashes of the server
+ * @return true when our game state has the same hashes, or there are none of the current frame
+ */
+bool NetworkSyncHashCheck(const SyncHashes *hashes)
+{
+	if (!hashes->valid || hashes->frame != _frame_counter) return true;
+
+	bool same = true;
+	for (SyncHashPart part = SHP_VEHICLES; part < SHP_END; part++) {
+		const SyncHash *h = &hashes->parts[part];
+		if (h->count == 0) continue;
+		if (SyncHashRange(part, h->first, h->count) == h->hash) continue;
+
+		same = false;
+		uint32 last = h->first + h->count - 1;
+		if (part == SHP_MAP) {
+			DEBUG(desync, 0, "State hash mismatch at frame %d: %s (%d,%d) - (%d,%d)", _frame_counter, _sync_hash_part_names[part], TileX(h->first), TileY(h->first), TileX(last), TileY(last));
+		} else {
+			DEBUG(desync, 0, "State hash mismatch at frame %d: %s %d - %d", _frame_counter, _sync_hash_part_names[part], h->first, last);
+		}
+		IConsolePrintF(CC_ERROR, "The game state differs from the server's in the %s %d - %d", _sync_hash_part_names[part], h->first, last);
+	}
+	return same;
+}
+
+#endif /* ENABLE_NETWORK */
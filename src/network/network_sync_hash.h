@@ -0,0 +1,53 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file network_sync_hash.h Hashes of parts of the game state, to find where a desync starts. */
+
+#ifndef NETWORK_SYNC_HASH_H
+#define NETWORK_SYNC_HASH_H
+
+#ifdef ENABLE_NETWORK
+
+#include "core/packet.h"
+#include "../core/enum_type.hpp"
+
+/** The parts of the game state that are hashed. */
+enum SyncHashPart {
+	SHP_VEHICLES,      ///< A range of the vehicle pool.
+	SHP_STATION_CARGO, ///< The goods of a range of the station pool.
+	SHP_COMPANIES,     ///< The money and loans of all companies.
+	SHP_MAP,           ///< A range of tiles.
+	SHP_END,           ///< End marker.
+};
+DECLARE_POSTFIX_INCREMENT(SyncHashPart)
+
+/** The hash of one range of objects of a part of the game state. */
+struct SyncHash {
+	uint32 first; ///< The first object (index or tile) of the range.
+	uint32 count; ///< The number of objects in the range.
+	uint32 hash;  ///< The hash of the objects in the range.
+};
+
+/** The hashes that are checked at one frame; a range of every part. */
+struct SyncHashes {
+	bool valid;               ///< Whether the hashes are known.
+	uint32 frame;             ///< The frame the hashes are of.
+	SyncHash parts[SHP_END];  ///< The hash of each part.
+};
+
+extern SyncHashes _sync_hashes;
+
+void NetworkSyncHashCompute(SyncHashes *hashes);
+void NetworkSyncHashSend(Packet *p, const SyncHashes *hashes);
+void NetworkSyncHashRecv(Packet *p, uint32 frame, SyncHashes *hashes);
+bool NetworkSyncHashCheck(const SyncHashes *hashes);
+
+#endif /* ENABLE_NETWORK */
+
+#endif /* NETWORK_SYNC_HASH_H */
@@ -72,16 +72,90 @@ DEF_UDP_RECEIVE_COMMAND(Master, PACKET_UDP_MASTER_SESSION_KEY)
 
 ///*** Communication with clients (we are server) ***/
 
+static const uint UDP_QUERY_SOURCES  = 256;  ///< number of addresses whose queries are counted at once
+static const uint UDP_QUERY_INTERVAL = 1000; ///< interval in milliseconds in which the queries of an address are counted
+static const uint UDP_QUERY_LIMIT    = 10;   ///< queries an address may make per interval; the others get no answer
+
 class ServerNetworkUDPSocketHandler : public NetworkUDPSocketHandler {
+private:
+	/** The queries of an address in the current interval. */
+	struct QuerySource {
+		uint32 hash;  ///< The hash of the address.
+		uint32 start; ///< The _realtime_tick the interval started at.
+		uint count;   ///< The number of queries in the interval.
+	};
+	QuerySource sources[UDP_QUERY_SOURCES]; ///< The addresses that queried us lately, by hash.
+
+	Packet *server_response;      ///< The last PACKET_UDP_SERVER_RESPONSE, or NULL.
+	uint32 server_response_frame; ///< The frame #server_response is of.
+	Packet *detail_info;          ///< The last PACKET_UDP_SERVER_DETAIL_INFO, or NULL.
+	Date detail_info_date;        ///< The date #detail_info is of.
+	uint detail_info_companies;   ///< The number of companies #detail_info has.
+
+	bool IsQueryAllowed(NetworkAddress *client_addr);
+
 protected:
 	DECLARE_UDP_RECEIVE_COMMAND(PACKET_UDP_CLIENT_FIND_SERVER);
 	DECLARE_UDP_RECEIVE_COMMAND(PACKET_UDP_CLIENT_DETAIL_INFO);
 	DECLARE_UDP_RECEIVE_COMMAND(PACKET_UDP_CLIENT_GET_NEWGRFS);
 public:
-	ServerNetworkUDPSocketHandler(NetworkAddressList *addresses) : NetworkUDPSocketHandler(addresses) {}
-	virtual ~ServerNetworkUDPSocketHandler() {}
+	ServerNetworkUDPSocketHandler(NetworkAddressList *addresses) : NetworkUDPSocketHandler(addresses), server_response(NULL), detail_info(NULL)
+	{
+		memset(this->sources, 0, sizeof(this->sources));
+	}
+
+	virtual ~ServerNetworkUDPSocketHandler()
+	{
+		delete this->server_response;
+		delete this->detail_info;
+	}
 };
 
+/**
+ * Count a query of an address, and check whether it may be answered.
+ * Scanners and scripts can query many times a second; each address only
+ * gets #UDP_QUERY_LIMIT answers per #UDP_QUERY_INTERVAL.
+ * @param client_addr the address the query came from
+ * @return true when the query may be answered
+ */
+bool ServerNetworkUDPSocketHandler::IsQueryAllowed(NetworkAddress *client_addr)
+{
+	/* Only the host counts, not the port it sent from. */
+	const sockaddr_storage *address = client_addr->GetAddress();
+	const byte *host;
+	size_t length;
+	switch (address->ss_family) {
+		case AF_INET:
+			host = (const byte *)&((const sockaddr_in *)address)->sin_addr;
+			length = sizeof(in_addr);
+			break;
+
+		case AF_INET6:
+			host = (const byte *)&((const sockaddr_in6 *)address)->sin6_addr;
+			length = sizeof(in6_addr);
+			break;
+
+		default:
+			return true;
+	}
+
+	uint32 hash = 2166136261U;
+	for (size_t i = 0; i < length; i++) hash = (hash ^ host[i]) * 16777619U;
+
+	QuerySource *source = &this->sources[hash % UDP_QUERY_SOURCES];
+	if (source->hash != hash || _realtime_tick - source->start >= UDP_QUERY_INTERVAL) {
+		/* A new interval, or another address that takes over the slot */
+		source->hash = hash;
+		source->start = _realtime_tick;
+		source->count = 0;
+	}
+
+	if (++source->count <= UDP_QUERY_LIMIT) return true;
+
+	DEBUG(net, 3, "[udp] too many queries from %s, not answering", client_addr->GetHostname());
+	return false;
+}
+
 DEF_UDP_RECEIVE_COMMAND(Server, PACKET_UDP_CLIENT_FIND_SERVER)
 {
 	/* Just a fail-safe.. should never happen */
@@ -89,6 +163,15 @@ DEF_UDP_RECEIVE_COMMAND(Server, PACKET_UDP_CLIENT_FIND_SERVER)
 		return;
 	}
 
+	if (!this->IsQueryAllowed(client_addr)) return;
+
+	/* Nothing we tell changes within a frame */
+	if (this->server_response != NULL && this->server_response_frame == _frame_counter) {
+		this->SendPacket(this->server_response, client_addr);
+		DEBUG(net, 2, "[udp] queried from %s", client_addr->GetHostname());
+		return;
+	}
+
 	NetworkGameInfo ngi;
 
 	/* Update some game_info */
@@ -113,11 +196,13 @@ DEF_UDP_RECEIVE_COMMAND(Server, PACKET_UDP_CLIENT_FIND_SERVER)
 	strecpy(ngi.server_name, _settings_client.network.server_name, lastof(ngi.server_name));
 	strecpy(ngi.server_revision, _openttd_revision, lastof(ngi.server_revision));
 
-	Packet packet(PACKET_UDP_SERVER_RESPONSE);
-	this->Send_NetworkGameInfo(&packet, &ngi);
+	delete this->server_response;
+	this->server_response = new Packet(PACKET_UDP_SERVER_RESPONSE);
+	this->server_response_frame = _frame_counter;
+	this->Send_NetworkGameInfo(this->server_response, &ngi);
 
 	/* Let the client know that we are here */
-	this->SendPacket(&packet, client_addr);
+	this->SendPacket(this->server_response, client_addr);
 
 	DEBUG(net, 2, "[udp] queried from %s", client_addr->GetHostname());
 }
@@ -127,7 +212,20 @@ DEF_UDP_RECEIVE_COMMAND(Server, PACKET_UDP_CLIENT_DETAIL_INFO)
 	/* Just a fail-safe.. should never happen */
 	if (!_network_udp_server) return;
 
-	Packet packet(PACKET_UDP_SERVER_DETAIL_INFO);
+	if (!this->IsQueryAllowed(client_addr)) return;
+
+	/* Gathering the stats means going through all vehicles and stations;
+	 * once a day is recent enough, unless a company came or went. */
+	if (this->detail_info != NULL && this->detail_info_date == _date && this->detail_info_companies == Company::GetNumItems()) {
+		this->SendPacket(this->detail_info, client_addr);
+		return;
+	}
+
+	delete this->detail_info;
+	this->detail_info = new Packet(PACKET_UDP_SERVER_DETAIL_INFO);
+	this->detail_info_date = _date;
+	this->detail_info_companies = (uint)Company::GetNumItems();
+	Packet &packet = *this->detail_info;
 
 	/* Send the amount of active companies */
 	packet.Send_uint8 (NETWORK_COMPANY_INFO_VERSION);
@@ -171,6 +269,8 @@ DEF_UDP_RECEIVE_COMMAND(Server, PACKET_UDP_CLIENT_GET_NEWGRFS)
 
 	DEBUG(net, 6, "[udp] newgrf data request from %s", client_addr->GetAddressAsString());
 
+	if (!this->IsQueryAllowed(client_addr)) return;
+
 	num_grfs = p->Recv_uint8 ();
 	if (num_grfs > NETWORK_MAX_GRF_COUNT) return;
 
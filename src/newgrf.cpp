@@ -48,6 +48,8 @@
 #include "core/mem_func.hpp"
 #include "smallmap_gui.h"
 #include "genworld.h"
+#include "thread/thread.h"
+#include "blitter/factory.hpp"
 
 #include "table/strings.h"
 #include "table/build_industry.h"
@@ -70,6 +72,7 @@ static SmallVector<GRFFile *, 16> _grf_files;
 static GRFFile *_cur_grffile;
 static SpriteID _cur_spriteid;
 static GrfLoadingStage _cur_stage;
+static bool _skip_graphics; ///< Nothing is ever drawn, e.g. on a dedicated server, so data that is only used for drawing is not kept.
 static uint32 _nfo_line;
 
 static GRFConfig *_cur_grfconfig;
@@ -242,7 +245,12 @@ void CDECL grfmsg(int severity, const char *str, ...)
 	DEBUG(grf, severity, "[%s:%d] %s", _cur_grfconfig->filename, _nfo_line, buf);
 }
 
-static GRFFile *GetFileByGRFID(uint32 grfid)
+/**
+ * Get the loaded NewGRF with the given ID.
+ * @param grfid The ID of the NewGRF.
+ * @return The NewGRF, or NULL when it is not loaded.
+ */
+GRFFile *GetFileByGRFID(uint32 grfid)
 {
 	const GRFFile * const *end = _grf_files.End();
 	for (GRFFile * const *file = _grf_files.Begin(); file != end; file++) {
@@ -261,6 +269,14 @@ static GRFFile *GetFileByFilename(const char *filename)
 }
 
 /** Reset all NewGRFData that was used only while processing data */
+/**
+ * The callback result groups of the GRF that is being loaded, by the value
+ * they are referenced with. Callback results make up a large part of the
+ * sprite groups, but the same result needs just one group.
+ */
+typedef std::map<uint16, const SpriteGroup *> CallbackResultGroupMap;
+static CallbackResultGroupMap _callback_result_groups;
+
 static void ClearTemporaryNewGRFData(GRFFile *gf)
 {
 	/* Clear the GOTO labels used for GRF processing */
@@ -275,6 +291,8 @@ static void ClearTemporaryNewGRFData(GRFFile *gf)
 	free(gf->spritegroups);
 	gf->spritegroups = NULL;
 	gf->spritegroups_count = 0;
+
+	_callback_result_groups.clear();
 }
 
 
@@ -3217,11 +3235,27 @@ static void SkipAct1(ByteReader *buf)
 	grfmsg(3, "SkipAct1: Skipping %d sprites", _skip_sprites);
 }
 
+/**
+ * Get the group of a callback result, sharing it with the other references
+ * to the same result of the GRF.
+ * @param value The value the result is referenced with.
+ * @return The group.
+ */
+static const SpriteGroup *GetCallbackResultGroup(uint16 value)
+{
+	CallbackResultGroupMap::iterator it = _callback_result_groups.find(value);
+	if (it != _callback_result_groups.end()) return it->second;
+
+	const SpriteGroup *group = new CallbackResultSpriteGroup(value);
+	_callback_result_groups[value] = group;
+	return group;
+}
+
 /* Helper function to either create a callback or link to a previously
  * defined spritegroup. */
 static const SpriteGroup *GetGroupFromGroupID(byte setid, byte type, uint16 groupid)
 {
-	if (HasBit(groupid, 15)) return new CallbackResultSpriteGroup(groupid);
+	if (HasBit(groupid, 15)) return GetCallbackResultGroup(groupid);
 
 	if (groupid >= _cur_grffile->spritegroups_count || _cur_grffile->spritegroups[groupid] == NULL) {
 		grfmsg(1, "GetGroupFromGroupID(0x%02X:0x%02X): Groupid 0x%04X does not exist, leaving empty", setid, type, groupid);
@@ -3234,7 +3268,7 @@ static const SpriteGroup *GetGroupFromGroupID(byte setid, byte type, uint16 grou
 /* Helper function to either create a callback or a result sprite group. */
 static const SpriteGroup *CreateGroupFromGroupID(byte feature, byte setid, byte type, uint16 spriteid, uint16 num_sprites)
 {
-	if (HasBit(spriteid, 15)) return new CallbackResultSpriteGroup(spriteid);
+	if (HasBit(spriteid, 15)) return GetCallbackResultGroup(spriteid);
 
 	if (spriteid >= _cur_grffile->spriteset_numsets) {
 		grfmsg(1, "CreateGroupFromGroupID(0x%02X:0x%02X): Sprite set %u invalid, max %u", setid, type, spriteid, _cur_grffile->spriteset_numsets);
@@ -3363,6 +3397,9 @@ static void NewSpriteGroup(ByteReader *buf)
 			}
 
 			group->default_group = GetGroupFromGroupID(setid, type, buf->ReadWord());
+			group->InitDispatch();
+			group->InitMemo();
+			if (feature <= GSF_AIRCRAFT) group->InitCacheable();
 			break;
 		}
 
@@ -3391,6 +3428,7 @@ static void NewSpriteGroup(ByteReader *buf)
 				group->groups[i] = GetGroupFromGroupID(setid, type, buf->ReadWord());
 			}
 
+			if (feature <= GSF_AIRCRAFT) group->InitCacheable();
 			break;
 		}
 
@@ -3455,6 +3493,10 @@ static void NewSpriteGroup(ByteReader *buf)
 					act_group = group;
 					/* num_building_stages should be 1, if we are only using non-custom sprites */
 					group->num_building_stages = max((uint8)1, num_spriteset_ents);
+
+					/* The layout is only used for drawing the tile; the rest of the sprite is not read anymore. */
+					if (_skip_graphics) break;
+
 					group->dts = CallocT<DrawTileSprites>(1);
 
 					/* Groundsprite */
@@ -5724,6 +5766,9 @@ static void LoadGRFSound(ByteReader *buf)
 	 * so that the indices used elsewhere are still correct. */
 	SoundEntry *sound = AllocateSound();
 
+	/* Without drawing there is nobody to play the sound to either. */
+	if (_skip_graphics) return;
+
 	if (buf->ReadDWord() != BSWAP32('RIFF')) {
 		grfmsg(1, "LoadGRFSound: Missing RIFF header");
 		return;
@@ -6736,6 +6781,210 @@ static void DecodeSpecialSprite(byte *buf, uint num, GrfLoadingStage stage)
 }
 
 
+static const uint GRF_INDEX_THREADS = 4; ///< The number of threads that read the NewGRFs to index their sprites.
+
+/** Where the sprites of a NewGRF start in its file, so the loading stages needn't decode a sprite to get past it. */
+struct GRFSpriteIndex {
+	const GRFConfig *config;         ///< The NewGRF.
+	SmallVector<size_t, 16> headers; ///< The position of the header of each sprite, starting with the one after the header sprite.
+};
+
+static const GRFSpriteIndex *_cur_sprite_index = NULL; ///< The sprite index of the NewGRF being loaded, if any.
+
+/** A reader of a NewGRF through a buffer of its own, so the indexing threads don't touch the Fio slots. */
+struct GRFIndexReader {
+	FILE *f;        ///< The file.
+	size_t pos;     ///< The position in the file of the end of the buffer.
+	size_t left;    ///< The bytes of the NewGRF after the end of the buffer.
+	byte *buffer;   ///< The next byte in the buffer.
+	byte *end;      ///< The end of the data in the buffer.
+	bool eof;       ///< Whether we tried to read past the end of the NewGRF.
+	byte data[4096];///< The buffer.
+
+	/** Get the position of the next byte to read in the file. */
+	size_t GetPos() const
+	{
+		return this->pos - (this->end - this->buffer);
+	}
+
+	/** Read a byte; 0 after the end of the NewGRF, like FioReadByte. */
+	byte ReadByte()
+	{
+		if (this->buffer == this->end) {
+			size_t size = fread(this->data, 1, min<size_t>(this->left, sizeof(this->data)), this->f);
+			this->pos += size;
+			this->left -= size;
+			this->buffer = this->data;
+			this->end = this->data + size;
+			if (size == 0) {
+				this->eof = true;
+				return 0;
+			}
+		}
+		return *this->buffer++;
+	}
+
+	uint16 ReadWord()
+	{
+		byte b = this->ReadByte();
+		return (this->ReadByte() << 8) | b;
+	}
+
+	/** Skip bytes, like FioSkipBytes. */
+	void SkipBytes(size_t n)
+	{
+		size_t in_buffer = this->end - this->buffer;
+		if (n <= in_buffer) {
+			this->buffer += n;
+			return;
+		}
+		n -= in_buffer;
+		if (n > this->left) {
+			n = this->left;
+			this->eof = true;
+		}
+		fseek(this->f, n, SEEK_CUR);
+		this->pos += n;
+		this->left -= n;
+		this->buffer = this->end = this->data;
+	}
+
+	/** Skip the data of a real sprite, like SkipSpriteData. */
+	bool SkipSpriteData(byte type, uint16 num)
+	{
+		if (type & 2) {
+			this->SkipBytes(num);
+			return true;
+		}
+		while (num > 0) {
+			int8 i = this->ReadByte();
+			if (i >= 0) {
+				int size = (i == 0) ? 0x80 : i;
+				if (size > num) return false;
+				num -= size;
+				this->SkipBytes(size);
+			} else {
+				i = -(i >> 3);
+				num -= i;
+				this->ReadByte();
+			}
+		}
+		return true;
+	}
+};
+
+/**
+ * Find where the sprites of a NewGRF start, the way LoadNewGRFFile walks
+ * through them. The index ends early at a sprite that can't be skipped,
+ * or that doesn't end before the end of the file.
+ * @param index the index to fill
+ * @param mutex the mutex to hold while opening the file
+ */
+static void IndexGRFSprites(GRFSpriteIndex *index, ThreadMutex *mutex)
+{
+	GRFIndexReader *reader = new GRFIndexReader();
+
+	mutex->BeginCritical();
+	reader->f = FioFOpenFile(index->config->filename, "rb", DATA_DIR, &reader->left);
+	mutex->EndCritical();
+
+	if (reader->f != NULL) {
+		reader->pos = ftell(reader->f);
+		reader->buffer = reader->end = reader->data;
+		reader->eof = false;
+
+		if (reader->ReadWord() == 4 && reader->ReadByte() == 0xFF) {
+			reader->SkipBytes(4);
+
+			for (;;) {
+				*index->headers.Append() = reader->GetPos();
+
+				uint16 num = reader->ReadWord();
+				if (num == 0) break;
+
+				byte type = reader->ReadByte();
+				if (type == 0xFF) {
+					reader->SkipBytes(num);
+				} else {
+					reader->SkipBytes(7);
+					if (!reader->SkipSpriteData(type, num - 8)) break;
+				}
+				if (reader->eof) break;
+			}
+		}
+
+		FioFCloseFile(reader->f);
+	}
+
+	delete reader;
+}
+
+/** The NewGRFs the threads index the sprites of. */
+struct GRFSpriteIndexQueue {
+	GRFSpriteIndex *indices; ///< The indices to fill.
+	uint count;              ///< The number of indices.
+	uint next;               ///< The next index a thread takes.
+	ThreadMutex *mutex;      ///< The mutex for #next and for opening files.
+};
+
+/**
+ * Index the sprites of the NewGRFs in a queue until there are none left.
+ * @param data the GRFSpriteIndexQueue
+ */
+static void IndexGRFSpritesThread(void *data)
+{
+	GRFSpriteIndexQueue *queue = (GRFSpriteIndexQueue *)data;
+
+	for (;;) {
+		queue->mutex->BeginCritical();
+		uint i = queue->next++;
+		queue->mutex->EndCritical();
+
+		if (i >= queue->count) return;
+
+		IndexGRFSprites(&queue->indices[i], queue->mutex);
+	}
+}
+
+/**
+ * Index the sprites of all NewGRFs that will be loaded, with a few threads.
+ * @param count the number of indices made
+ * @return the indices; free them with delete[]
+ */
+static GRFSpriteIndex *IndexAllGRFSprites(uint *count)
+{
+	uint num = 0;
+	for (const GRFConfig *c = _grfconfig; c != NULL; c = c->next) {
+		if (c->status != GCS_NOT_FOUND) num++;
+	}
+
+	GRFSpriteIndexQueue queue;
+	queue.indices = new GRFSpriteIndex[num];
+	queue.count = num;
+	queue.next = 0;
+	queue.mutex = ThreadMutex::New();
+
+	uint n = 0;
+	for (const GRFConfig *c = _grfconfig; c != NULL; c = c->next) {
+		if (c->status != GCS_NOT_FOUND) queue.indices[n++].config = c;
+	}
+
+	ThreadObject *threads[GRF_INDEX_THREADS - 1];
+	uint num_threads = 0;
+	while (num_threads < lengthof(threads) && num_threads + 1 < num && ThreadObject::New(&IndexGRFSpritesThread, &queue, &threads[num_threads])) num_threads++;
+
+	IndexGRFSpritesThread(&queue);
+
+	for (uint i = 0; i < num_threads; i++) {
+		threads[i]->Join();
+		delete threads[i];
+	}
+	delete queue.mutex;
+
+	*count = num;
+	return queue.indices;
+}
+
 void LoadNewGRFFile(GRFConfig *config, uint file_index, GrfLoadingStage stage)
 {
 	const char *filename = config->filename;
@@ -6812,8 +7061,14 @@ void LoadNewGRFFile(GRFConfig *config, uint file_index, GrfLoadingStage stage)
 				break;
 			}
 
-			FioSkipBytes(7);
-			SkipSpriteData(type, num - 8);
+			/* The header of line N is at index N - 1; skip to the one of the next line when we know where this sprite is. */
+			const GRFSpriteIndex *index = _cur_sprite_index;
+			if (index != NULL && _nfo_line < index->headers.Length() && index->headers[_nfo_line - 1] == FioGetPos() - 3) {
+				FioSeekTo(index->headers[_nfo_line], SEEK_SET);
+			} else {
+				FioSkipBytes(7);
+				SkipSpriteData(type, num - 8);
+			}
 		}
 
 		if (_skip_sprites > 0) _skip_sprites--;
@@ -7008,6 +7263,7 @@ static void AfterLoadGRFs()
 
 	/* Add all new houses to the house array. */
 	FinaliseHouseArray();
+	InvalidateHouseCandidates();
 
 	/* Add all new industries to the industry array. */
 	FinaliseIndustriesArray();
@@ -7087,6 +7343,8 @@ void LoadNewGRF(uint load_index, uint file_index)
 
 	ResetNewGRFData();
 
+	_skip_graphics = BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 0;
+
 	/*
 	 * Reset the status of all files, so we can 'retry' to load them.
 	 * This is needed when one for example rearranges the NewGRFs in-game
@@ -7100,6 +7358,10 @@ void LoadNewGRF(uint load_index, uint file_index)
 
 	_cur_spriteid = load_index;
 
+	/* Finding where the sprites are is the same for every stage, and independent for every NewGRF. */
+	uint num_indices;
+	GRFSpriteIndex *indices = IndexAllGRFSprites(&num_indices);
+
 	/* Load newgrf sprites
 	 * in each loading stage, (try to) open each file specified in the config
 	 * and load information from it. */
@@ -7124,7 +7386,14 @@ void LoadNewGRF(uint load_index, uint file_index)
 			}
 
 			if (stage == GLS_LABELSCAN) InitNewGRFFile(c, _cur_spriteid);
+
+			for (uint i = 0; i < num_indices; i++) {
+				if (indices[i].config == c) _cur_sprite_index = &indices[i];
+			}
+			size_t first_spritegroup = SpriteGroup::GetPoolSize();
+			SpriteID first_sprite = _cur_spriteid;
 			LoadNewGRFFile(c, slot++, stage);
+			_cur_sprite_index = NULL;
 			if (stage == GLS_RESERVE) {
 				SetBit(c->flags, GCF_RESERVED);
 			} else if (stage == GLS_ACTIVATION) {
@@ -7132,6 +7401,17 @@ void LoadNewGRF(uint load_index, uint file_index)
 				assert(GetFileByGRFID(c->ident.grfid) == _cur_grffile);
 				ClearTemporaryNewGRFData(_cur_grffile);
 				BuildCargoTranslationMap();
+
+				/* Sprite groups are not freed while loading, so all new ones belong to this GRF. */
+				_cur_grffile->num_sprites = _cur_spriteid - first_sprite;
+				_cur_grffile->num_spritegroups = 0;
+				_cur_grffile->spritegroup_memory = 0;
+				for (size_t i = first_spritegroup; i < SpriteGroup::GetPoolSize(); i++) {
+					const SpriteGroup *group = SpriteGroup::GetIfValid(i);
+					if (group == NULL) continue;
+					_cur_grffile->num_spritegroups++;
+					_cur_grffile->spritegroup_memory += group->GetMemoryUsage();
+				}
 				DEBUG(sprite, 2, "LoadNewGRF: Currently %i sprites are loaded", _cur_spriteid);
 			} else if (stage == GLS_INIT && HasBit(c->flags, GCF_INIT_ONLY)) {
 				/* We're not going to activate this, so free whatever data we allocated */
@@ -7140,6 +7420,8 @@ void LoadNewGRF(uint load_index, uint file_index)
 		}
 	}
 
+	delete[] indices;
+
 	/* Call any functions that should be run after GRFs have been loaded. */
 	AfterLoadGRFs();
 
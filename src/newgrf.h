@@ -76,6 +76,27 @@ struct GRFLabel {
 	struct GRFLabel *next;
 };
 
+/** Kinds of features the measurements of resolving the sprite groups of a NewGRF are split into. */
+enum NewGRFProfileFeature {
+	NPF_VEHICLES,   ///< Trains, road vehicles, ships and aircraft
+	NPF_STATIONS,   ///< Stations
+	NPF_HOUSES,     ///< Houses
+	NPF_INDUSTRIES, ///< Industries and industry tiles
+	NPF_AIRPORTS,   ///< Airports and airport tiles
+	NPF_CANALS,     ///< Canals
+	NPF_OTHER,      ///< Everything else, like cargos and rail types
+	NPF_END,        ///< End marker
+};
+
+/** Measurements of resolving the sprite groups of a NewGRF for one kind of feature, see newgrf_profiling.h. */
+struct NewGRFProfileCounts {
+	uint64 resolves;       ///< Number of times a sprite group was resolved
+	uint64 callbacks;      ///< Number of those resolves that were done for a callback
+	uint64 storage_writes; ///< Number of writes to the temporary and persistent storages
+	uint64 time;           ///< Total time spent resolving, in rdtsc cycles
+	uint64 peak_time;      ///< Time the longest single resolve took, in rdtsc cycles
+};
+
 /** Dynamic data of a loaded NewGRF */
 struct GRFFile {
 	char *filename;
@@ -132,6 +153,12 @@ struct GRFFile {
 	uint32 grf_features;                     ///< Bitset of GrfSpecFeature the grf uses
 	PriceMultipliers price_base_multipliers; ///< Price base multipliers as set by the grf.
 
+	NewGRFProfileCounts profile[NPF_END];    ///< Measurements of resolving the sprite groups of the grf, per kind of feature.
+
+	uint num_sprites;                        ///< Number of sprites the grf loaded, including replaced base sprites.
+	uint num_spritegroups;                   ///< Number of sprite groups the grf allocated.
+	size_t spritegroup_memory;               ///< Memory used by the sprite groups of the grf, in bytes.
+
 	/** Get GRF Parameter with range checking */
 	uint32 GetParam(uint number) const
 	{
@@ -167,6 +194,7 @@ void CDECL grfmsg(int severity, const char *str, ...) WARN_FORMAT(2, 3);
 
 bool HasGrfMiscBit(GrfMiscBit bit);
 bool GetGlobalVariable(byte param, uint32 *value);
+GRFFile *GetFileByGRFID(uint32 grfid);
 
 StringID MapGRFStringID(uint32 grfid, StringID str);
 void ShowNewGRFError();
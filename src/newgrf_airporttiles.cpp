@@ -235,6 +235,7 @@ static void AirportTileResolver(ResolverObject *res, StationGfx gfx, TileIndex t
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_AIRPORTTILES;
 	res->count           = 0;
 
 	const AirportTileSpec *ats = AirportTileSpec::Get(gfx);
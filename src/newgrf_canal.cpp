@@ -88,6 +88,7 @@ static void NewCanalResolver(ResolverObject *res, TileIndex tile, const GRFFile
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_CANALS;
 	res->count           = 0;
 	res->grffile         = grffile;
 }
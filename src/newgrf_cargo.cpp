@@ -69,6 +69,7 @@ static void NewCargoResolver(ResolverObject *res, const CargoSpec *cs)
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_CARGOS;
 	res->count           = 0;
 	res->grffile         = cs->grffile;
 }
@@ -22,6 +22,7 @@
 #include "tree_map.h"
 #include "tunnelbridge_map.h"
 #include "core/mem_func.hpp"
+#include "core/sort_func.hpp"
 
 /** Constructor of generic class
  * @param offset end of original data for this entity. i.e: houses = 110
@@ -38,6 +39,7 @@ OverrideManagerBase::OverrideManagerBase(uint16 offset, uint16 maximum, uint16 i
 	entity_overrides = MallocT<uint16>(max_offset);
 	for (size_t i = 0; i < max_offset; i++) entity_overrides[i] = invalid;
 	grfid_overrides = CallocT<uint32>(max_offset);
+	index_valid = false;
 }
 
 /** Destructor of the generic class.
@@ -70,6 +72,95 @@ void OverrideManagerBase::Add(uint8 local_id, uint32 grfid, uint entity_type)
 void OverrideManagerBase::ResetMapping()
 {
 	memset(mapping_ID, 0, (max_new_entities - 1) * sizeof(EntityIDMapping));
+	/* The mapping may be written directly after this, e.g. by loading a savegame. */
+	index_valid = false;
+}
+
+/**
+ * Compare two entries of the index of an OverrideManagerBase.
+ * @param a The first entry.
+ * @param b The second entry.
+ * @return Less than zero when \a a comes first, more than zero when \a b comes first.
+ */
+static int CDECL CompareEntityIDIndexEntries(const EntityIDIndexEntry *a, const EntityIDIndexEntry *b)
+{
+	if (a->grfid != b->grfid) return a->grfid < b->grfid ? -1 : 1;
+	if (a->entity_id != b->entity_id) return a->entity_id - b->entity_id;
+	return a->id - b->id;
+}
+
+/** Make the index contain all entries of the mapping. */
+void OverrideManagerBase::BuildIndex()
+{
+	this->index.Clear();
+	for (uint16 id = 0; id < max_new_entities; id++) {
+		EntityIDIndexEntry *entry = this->index.Append();
+		entry->grfid     = mapping_ID[id].grfid;
+		entry->entity_id = mapping_ID[id].entity_id;
+		entry->id        = id;
+	}
+	QSortT(this->index.Begin(), this->index.Length(), &CompareEntityIDIndexEntries);
+	this->index_valid = true;
+}
+
+/**
+ * Binary search the index for the first entry that does not come before the given one.
+ * @param grfid The GRF ID of the entry.
+ * @param entity_id The entity ID of the entry.
+ * @param id The index of the entry in the mapping.
+ * @return The entry, or the end of the index.
+ * @pre The index is valid.
+ */
+EntityIDIndexEntry *OverrideManagerBase::FindIndexEntry(uint32 grfid, uint8 entity_id, uint16 id)
+{
+	EntityIDIndexEntry key;
+	key.grfid     = grfid;
+	key.entity_id = entity_id;
+	key.id        = id;
+
+	uint first = 0;
+	uint last = this->index.Length();
+	while (first < last) {
+		uint mid = (first + last) / 2;
+		if (CompareEntityIDIndexEntries(&this->index[mid], &key) < 0) {
+			first = mid + 1;
+		} else {
+			last = mid;
+		}
+	}
+	return this->index.Begin() + first;
+}
+
+/**
+ * Change an entry of the mapping, keeping the index sorted.
+ * @param id The entry to change.
+ * @param grf_local_id The new entity ID within the GRF file.
+ * @param grfid The new GRF ID.
+ * @param substitute_id The new substitute ID.
+ */
+void OverrideManagerBase::SetMapping(uint16 id, byte grf_local_id, uint32 grfid, byte substitute_id)
+{
+	EntityIDMapping *map = &mapping_ID[id];
+
+	if (this->index_valid) {
+		/* Move the entries between the old and the new place of the entry one place. */
+		EntityIDIndexEntry *from = this->FindIndexEntry(map->grfid, map->entity_id, id);
+		EntityIDIndexEntry *to   = this->FindIndexEntry(grfid, grf_local_id, id);
+		assert(from != this->index.End() && from->id == id);
+		if (to > from) {
+			to--;
+			MemMoveT(from, from + 1, to - from);
+		} else {
+			MemMoveT(to + 1, to, from - to);
+		}
+		to->grfid     = grfid;
+		to->entity_id = grf_local_id;
+		to->id        = id;
+	}
+
+	map->entity_id     = grf_local_id;
+	map->grfid         = grfid;
+	map->substitute_id = substitute_id;
 }
 
 /** Resets the override, which is used while initializing game */
@@ -88,13 +179,12 @@ void OverrideManagerBase::ResetOverride()
  */
 uint16 OverrideManagerBase::GetID(uint8 grf_local_id, uint32 grfid)
 {
-	const EntityIDMapping *map;
+	if (!this->index_valid) this->BuildIndex();
 
-	for (uint16 id = 0; id < max_new_entities; id++) {
-		map = &mapping_ID[id];
-		if (map->entity_id == grf_local_id && map->grfid == grfid) {
-			return id;
-		}
+	/* The first entry with this GRF ID and entity ID has the lowest ID. */
+	const EntityIDIndexEntry *entry = this->FindIndexEntry(grfid, grf_local_id, 0);
+	if (entry != this->index.End() && entry->entity_id == grf_local_id && entry->grfid == grfid) {
+		return entry->id;
 	}
 
 	return invalid_ID;
@@ -124,9 +214,7 @@ uint16 OverrideManagerBase::AddEntityID(byte grf_local_id, uint32 grfid, byte su
 		map = &mapping_ID[id];
 
 		if (CheckValidNewID(id) && map->entity_id == 0 && map->grfid == 0) {
-			map->entity_id     = grf_local_id;
-			map->grfid         = grfid;
-			map->substitute_id = substitute_id;
+			this->SetMapping(id, grf_local_id, grfid, substitute_id);
 			return id;
 		}
 	}
@@ -212,9 +300,7 @@ uint16 IndustryOverrideManager::AddEntityID(byte grf_local_id, uint32 grfid, byt
 
 			if (map->entity_id == 0 && map->grfid == 0) {
 				/* winning slot, mark it as been used */
-				map->entity_id     = grf_local_id;
-				map->grfid         = grfid;
-				map->substitute_id = substitute_id;
+				this->SetMapping(id, grf_local_id, grfid, substitute_id);
 				return id;
 			}
 		}
@@ -15,6 +15,7 @@
 #define NEWGRF_COMMONS_H
 
 #include "tile_cmd.h"
+#include "core/smallvec_type.hpp"
 
 /**
  * Maps an entity id stored on the map to a GRF file.
@@ -34,6 +35,13 @@ struct EntityIDMapping {
 	uint8  substitute_id;  ///< The (original) entity ID to use if this GRF is not available
 };
 
+/** Entry of the index on the mapping of an OverrideManagerBase, sorted on GRF ID, entity ID and then ID. */
+struct EntityIDIndexEntry {
+	uint32 grfid;    ///< The GRF ID of the mapping
+	uint16 id;       ///< Index of the mapping
+	uint8 entity_id; ///< The entity ID within the GRF file of the mapping
+};
+
 class OverrideManagerBase {
 protected:
 	uint16 *entity_overrides;
@@ -45,6 +53,13 @@ protected:
 	uint16 invalid_ID;       ///< ID used to dected invalid entities;
 	virtual bool CheckValidNewID(uint16 testid) { return true; }
 
+	SmallVector<EntityIDIndexEntry, 16> index; ///< All entries of #mapping_ID, to binary search them in GetID.
+	bool index_valid;                          ///< Whether #index matches #mapping_ID; it is rebuilt when needed.
+
+	void BuildIndex();
+	EntityIDIndexEntry *FindIndexEntry(uint32 grfid, uint8 entity_id, uint16 id);
+	void SetMapping(uint16 id, byte grf_local_id, uint32 grfid, byte substitute_id);
+
 public:
 	EntityIDMapping *mapping_ID; ///< mapping of ids from grf files.  Public out of convenience
 
@@ -19,6 +19,12 @@
 
 #include "fileio_func.h"
 #include "fios.h"
+#include "tar_type.h"
+#include "thread/thread.h"
+#include "core/alloc_type.hpp"
+#include "core/sort_func.hpp"
+
+#include <sys/stat.h>
 
 GRFConfig::GRFConfig(const char *filename)
 {
@@ -89,21 +95,24 @@ void UpdateNewGRFConfigPalette()
 
 /** Calculate the MD5 sum for a GRF, and store it in the config.
  * @param config GRF to compute.
+ * @param mutex  the mutex to hold while opening the file, when other threads open files too
  * @return MD5 sum was successfully computed
  */
-static bool CalcGRFMD5Sum(GRFConfig *config)
+static bool CalcGRFMD5Sum(GRFConfig *config, ThreadMutex *mutex = NULL)
 {
 	FILE *f;
 	Md5 checksum;
-	uint8 buffer[1024];
+	SmallStackSafeStackAlloc<uint8, 64 * 1024> buffer;
 	size_t len, size;
 
 	/* open the file */
+	if (mutex != NULL) mutex->BeginCritical();
 	f = FioFOpenFile(config->filename, "rb", DATA_DIR, &size);
+	if (mutex != NULL) mutex->EndCritical();
 	if (f == NULL) return false;
 
 	/* calculate md5sum */
-	while ((len = fread(buffer, 1, (size > sizeof(buffer)) ? sizeof(buffer) : size, f)) != 0 && size != 0) {
+	while ((len = fread(buffer, 1, min<size_t>(size, 64 * 1024), f)) != 0 && size != 0) {
 		size -= len;
 		checksum.Append(buffer, len);
 	}
@@ -115,12 +124,12 @@ static bool CalcGRFMD5Sum(GRFConfig *config)
 }
 
 
-/** Find the GRFID of a given grf, and calculate its md5sum.
+/** Find the GRFID of a given grf, without calculating its md5sum.
  * @param config    grf to fill.
  * @param is_static grf is static.
  * @return Operation was successfully completed.
  */
-bool FillGRFDetails(GRFConfig *config, bool is_static)
+static bool ReadGRFInfo(GRFConfig *config, bool is_static)
 {
 	if (!FioCheckFileExists(config->filename)) {
 		config->status = GCS_NOT_FOUND;
@@ -143,7 +152,17 @@ bool FillGRFDetails(GRFConfig *config, bool is_static)
 
 	config->windows_paletted = (_use_palette == PAL_WINDOWS);
 
-	return CalcGRFMD5Sum(config);
+	return true;
+}
+
+/** Find the GRFID of a given grf, and calculate its md5sum.
+ * @param config    grf to fill.
+ * @param is_static grf is static.
+ * @return Operation was successfully completed.
+ */
+bool FillGRFDetails(GRFConfig *config, bool is_static)
+{
+	return ReadGRFInfo(config, is_static) && CalcGRFMD5Sum(config);
 }
 
 
@@ -338,59 +357,409 @@ compatible_grf:
 	return res;
 }
 
+/** The version of the format of the file with what is known about the scanned files. */
+static const uint32 GRF_SCAN_CACHE_VERSION = 1;
+/** The number of threads calculating the MD5 sums of the NewGRFs that are new or changed, including the main thread. */
+static const uint GRF_MD5SUM_THREADS = 4;
+
+/** What is known about a scanned file from an earlier scan for NewGRFs. */
+struct GRFScanCacheItem {
+	char *path;        ///< The full path of the file; for a file in a tar its name in that tar.
+	uint64 size;       ///< The size of the file.
+	uint64 position;   ///< The position of the file in its tar; 0 for other files.
+	int64 mtime;       ///< The modification time of the file, or of its tar.
+	GRFConfig *config; ///< The details of the NewGRF; NULL if the file is no NewGRF that can be used.
+};
+
+typedef SmallVector<GRFScanCacheItem, 64> GRFScanCache;
+
+static GRFScanCache _grf_scan_cache; ///< What the last scan found, sorted by path.
+
+/**
+ * Forget what is known about scanned files.
+ * @param cache the files
+ */
+static void ClearGRFScanCache(GRFScanCache *cache)
+{
+	for (GRFScanCacheItem *item = cache->Begin(); item != cache->End(); item++) {
+		free(item->path);
+		delete item->config;
+	}
+	cache->Clear();
+}
+
+/**
+ * Get the size and the modification time of a scanned file.
+ * @param item the item to fill; its path has to be set
+ * @return false if they aren't known, so the file has to be scanned
+ */
+static bool StatGRFScanCacheItem(GRFScanCacheItem *item)
+{
+	const char *path = item->path;
+	item->size = 0;
+	item->position = 0;
+
+	TarFileList::iterator it = _tar_filelist.find(path);
+	if (it != _tar_filelist.end()) {
+		path = it->second.tar_filename;
+		item->size = it->second.size;
+		item->position = it->second.position;
+	}
+
+#ifdef WIN32
+	struct _stat sb;
+	if (_tstat(OTTD2FS(path), &sb) != 0) return false;
+#else
+	struct stat sb;
+	if (stat(path, &sb) != 0) return false;
+#endif
+
+	if (item->position == 0) item->size = sb.st_size;
+	item->mtime = sb.st_mtime;
+	return true;
+}
+
+/**
+ * Compare the paths of two scanned files.
+ * @param a the first file
+ * @param b the second file
+ * @return the same strcmp would return for their paths
+ */
+static int CDECL GRFScanCacheItemSorter(const GRFScanCacheItem *a, const GRFScanCacheItem *b)
+{
+	return strcmp(a->path, b->path);
+}
+
+/**
+ * Find what the last scan found about a file.
+ * @param path the full path of the file
+ * @return what is known about it, or NULL when the file wasn't scanned
+ */
+static const GRFScanCacheItem *FindGRFScanCacheItem(const char *path)
+{
+	uint first = 0;
+	uint last = _grf_scan_cache.Length();
+	while (first < last) {
+		uint mid = (first + last) / 2;
+		int cmp = strcmp(_grf_scan_cache[mid].path, path);
+		if (cmp == 0) return &_grf_scan_cache[mid];
+		if (cmp < 0) {
+			first = mid + 1;
+		} else {
+			last = mid;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Get the name of the file with what is known about the scanned files.
+ * @param buf  the buffer for the name
+ * @param last the last element of the buffer
+ */
+static void GetGRFScanCacheFilename(char *buf, const char *last)
+{
+	seprintf(buf, last, "%sgrfscan.cache", _personal_dir);
+}
+
+/**
+ * Write a string to the scan cache file.
+ * @param f   the file
+ * @param str the string; may be NULL
+ */
+static void WriteGRFScanCacheString(FILE *f, const char *str)
+{
+	uint32 len = (str == NULL) ? 0 : (uint32)strlen(str) + 1;
+	fwrite(&len, sizeof(len), 1, f);
+	if (len > 1) fwrite(str, 1, len - 1, f);
+}
+
+/**
+ * Read a string from the scan cache file.
+ * @param f   the file
+ * @param str where to store the string, which is NULL or has to be freed
+ * @return false if the file is broken
+ */
+static bool ReadGRFScanCacheString(FILE *f, char **str)
+{
+	*str = NULL;
+
+	uint32 len;
+	if (fread(&len, sizeof(len), 1, f) != 1 || len > 0x10000) return false;
+	if (len == 0) return true;
+
+	*str = MallocT<char>(len);
+	(*str)[len - 1] = '\0';
+	return len == 1 || fread(*str, 1, len - 1, f) == len - 1;
+}
+
+/** Read what the last scan for NewGRFs found. */
+static void LoadGRFScanCache()
+{
+	ClearGRFScanCache(&_grf_scan_cache);
+
+	char filename[MAX_PATH];
+	GetGRFScanCacheFilename(filename, lastof(filename));
+	FILE *f = fopen(filename, "rb");
+	if (f == NULL) return;
+
+	uint32 header[3];
+	if (fread(header, sizeof(header), 1, f) != 1 || header[0] != GRF_SCAN_CACHE_VERSION || header[1] != TTD_ENDIAN) {
+		fclose(f);
+		return;
+	}
+
+	for (uint32 i = 0; i < header[2]; i++) {
+		GRFScanCacheItem *item = _grf_scan_cache.Append();
+		item->config = NULL;
+
+		byte usable = 0;
+		bool ok = ReadGRFScanCacheString(f, &item->path) && item->path != NULL &&
+				fread(&item->size, sizeof(item->size), 1, f) == 1 &&
+				fread(&item->position, sizeof(item->position), 1, f) == 1 &&
+				fread(&item->mtime, sizeof(item->mtime), 1, f) == 1 &&
+				fread(&usable, sizeof(usable), 1, f) == 1;
+
+		if (ok && usable != 0) {
+			GRFConfig *c = item->config = new GRFConfig();
+			ok = ReadGRFScanCacheString(f, &c->filename) && c->filename != NULL &&
+					ReadGRFScanCacheString(f, &c->name) &&
+					ReadGRFScanCacheString(f, &c->info) &&
+					fread(&c->ident.grfid, sizeof(c->ident.grfid), 1, f) == 1 &&
+					fread(c->ident.md5sum, sizeof(c->ident.md5sum), 1, f) == 1 &&
+					fread(&c->flags, sizeof(c->flags), 1, f) == 1;
+		}
+
+		if (!ok) {
+			DEBUG(grf, 1, "NewGRF scan cache is broken; scanning all NewGRFs");
+			ClearGRFScanCache(&_grf_scan_cache);
+			break;
+		}
+	}
+
+	fclose(f);
+
+	QSortT(_grf_scan_cache.Begin(), _grf_scan_cache.Length(), &GRFScanCacheItemSorter);
+}
+
+/**
+ * Write what a scan for NewGRFs found, for the next one.
+ * @param cache what was found
+ */
+static void SaveGRFScanCache(const GRFScanCache *cache)
+{
+	char filename[MAX_PATH];
+	GetGRFScanCacheFilename(filename, lastof(filename));
+	FILE *f = fopen(filename, "wb");
+	if (f == NULL) return;
+
+	uint32 header[3] = { GRF_SCAN_CACHE_VERSION, TTD_ENDIAN, cache->Length() };
+	fwrite(header, sizeof(header), 1, f);
+
+	for (const GRFScanCacheItem *item = cache->Begin(); item != cache->End(); item++) {
+		WriteGRFScanCacheString(f, item->path);
+		fwrite(&item->size, sizeof(item->size), 1, f);
+		fwrite(&item->position, sizeof(item->position), 1, f);
+		fwrite(&item->mtime, sizeof(item->mtime), 1, f);
+
+		byte usable = (item->config != NULL) ? 1 : 0;
+		fwrite(&usable, sizeof(usable), 1, f);
+		if (item->config == NULL) continue;
+
+		const GRFConfig *c = item->config;
+		WriteGRFScanCacheString(f, c->filename);
+		WriteGRFScanCacheString(f, c->name);
+		WriteGRFScanCacheString(f, c->info);
+		fwrite(&c->ident.grfid, sizeof(c->ident.grfid), 1, f);
+		fwrite(c->ident.md5sum, sizeof(c->ident.md5sum), 1, f);
+		fwrite(&c->flags, sizeof(c->flags), 1, f);
+	}
+
+	if (ferror(f) != 0) DEBUG(grf, 0, "Could not write the NewGRF scan cache '%s'", filename);
+	fclose(f);
+}
+
+/** A NewGRF found while scanning. */
+struct GRFScanCandidate {
+	GRFConfig *config; ///< The NewGRF.
+	uint cache_item;   ///< The index of the scanned file in the scan cache of the next scan; UINT_MAX if it isn't in there.
+	bool need_md5sum;  ///< Whether the MD5 sum has to be calculated still.
+	bool ok;           ///< Whether the MD5 sum is known.
+};
+
+/** The NewGRFs of which the threads calculate the MD5 sums. */
+struct GRFMD5SumQueue {
+	GRFScanCandidate *candidates; ///< The NewGRFs.
+	uint count;                   ///< The number of NewGRFs.
+	uint next;                    ///< The next NewGRF a thread takes.
+	ThreadMutex *mutex;           ///< The mutex for #next and for opening files.
+};
+
+/**
+ * Calculate the MD5 sums of the NewGRFs in a queue until there are none left.
+ * @param data the GRFMD5SumQueue
+ */
+static void CalcGRFMD5SumsThread(void *data)
+{
+	GRFMD5SumQueue *queue = (GRFMD5SumQueue *)data;
+
+	for (;;) {
+		queue->mutex->BeginCritical();
+		uint i = queue->next++;
+		queue->mutex->EndCritical();
+
+		if (i >= queue->count) return;
+
+		GRFScanCandidate *c = &queue->candidates[i];
+		if (c->need_md5sum) c->ok = CalcGRFMD5Sum(c->config, queue->mutex);
+	}
+}
+
+/**
+ * Add a NewGRF to the list of all NewGRFs, at the position determined by its
+ * name, unless it is known already.
+ * @param c the NewGRF
+ * @return false if it is known already
+ */
+static bool AddGRFToList(GRFConfig *c)
+{
+	if (_all_grfs == NULL) {
+		_all_grfs = c;
+		return true;
+	}
+
+	GRFConfig **pd, *d;
+	bool stop = false;
+	for (pd = &_all_grfs; (d = *pd) != NULL; pd = &d->next) {
+		if (c->ident.grfid == d->ident.grfid && memcmp(c->ident.md5sum, d->ident.md5sum, sizeof(c->ident.md5sum)) == 0) return false;
+		/* Because there can be multiple grfs with the same name, make sure we checked all grfs with the same name,
+		 *  before inserting the entry. So insert a new grf at the end of all grfs with the same name, instead of
+		 *  just after the first with the same name. Avoids doubles in the list. */
+		if (strcasecmp(c->GetName(), d->GetName()) <= 0) {
+			stop = true;
+		} else if (stop) {
+			break;
+		}
+	}
+
+	c->next = d;
+	*pd = c;
+	return true;
+}
+
 /** Helper for scanning for files with GRF as extension */
 class GRFFileScanner : FileScanner {
 public:
+	GRFScanCache cache;                           ///< What is known about the scanned files, for the next scan.
+	SmallVector<GRFScanCandidate, 64> candidates; ///< The NewGRFs found.
+
 	/* virtual */ bool AddFile(const char *filename, size_t basepath_length);
 
 	/** Do the scan for GRFs. */
-	static uint DoScan()
+	void DoScan()
 	{
-		GRFFileScanner fs;
-		return fs.Scan(".grf", DATA_DIR);
+		this->Scan(".grf", DATA_DIR);
 	}
+
+	void CalcMD5Sums();
+	uint AddToList();
 };
 
 bool GRFFileScanner::AddFile(const char *filename, size_t basepath_length)
 {
-	GRFConfig *c = new GRFConfig(filename + basepath_length);
+	GRFScanCacheItem item;
+	item.path = strdup(filename);
+	item.config = NULL;
+
+	uint cache_item = UINT_MAX;
+	const GRFScanCacheItem *known = NULL;
+	if (StatGRFScanCacheItem(&item)) {
+		known = FindGRFScanCacheItem(filename);
+		if (known != NULL && (known->size != item.size || known->position != item.position || known->mtime != item.mtime)) known = NULL;
+
+		cache_item = this->cache.Length();
+		*this->cache.Append() = item;
+	} else {
+		free(item.path);
+	}
 
-	bool added = true;
-	if (FillGRFDetails(c, false)) {
-		if (_all_grfs == NULL) {
-			_all_grfs = c;
-		} else {
-			/* Insert file into list at a position determined by its
-			 * name, so the list is sorted as we go along */
-			GRFConfig **pd, *d;
-			bool stop = false;
-			for (pd = &_all_grfs; (d = *pd) != NULL; pd = &d->next) {
-				if (c->ident.grfid == d->ident.grfid && memcmp(c->ident.md5sum, d->ident.md5sum, sizeof(c->ident.md5sum)) == 0) added = false;
-				/* Because there can be multiple grfs with the same name, make sure we checked all grfs with the same name,
-				 *  before inserting the entry. So insert a new grf at the end of all grfs with the same name, instead of
-				 *  just after the first with the same name. Avoids doubles in the list. */
-				if (strcasecmp(c->GetName(), d->GetName()) <= 0) {
-					stop = true;
-				} else if (stop) {
-					break;
-				}
-			}
-			if (added) {
-				c->next = d;
-				*pd = c;
-			}
-		}
+	GRFConfig *config;
+	if (known != NULL) {
+		/* The file hasn't changed since the last scan, so use what that found. */
+		if (known->config == NULL) return false;
+
+		config = DuplicateGRFConfig(known->config);
+		config->windows_paletted = (_use_palette == PAL_WINDOWS);
 	} else {
-		added = false;
+		config = new GRFConfig(filename + basepath_length);
+		if (!ReadGRFInfo(config, false)) {
+			/* File couldn't be opened, or is either not a NewGRF or is a
+			 * 'system' NewGRF, so forget about it. */
+			delete config;
+			return false;
+		}
 	}
 
-	if (!added) {
-		/* File couldn't be opened, or is either not a NewGRF or is a
-		 * 'system' NewGRF or it's already known, so forget about it. */
-		delete c;
+	GRFScanCandidate *c = this->candidates.Append();
+	c->config = config;
+	c->cache_item = cache_item;
+	c->need_md5sum = (known == NULL);
+	c->ok = (known != NULL);
+	return true;
+}
+
+/** Calculate the MD5 sums of the found NewGRFs that aren't known yet, with a few threads. */
+void GRFFileScanner::CalcMD5Sums()
+{
+	GRFMD5SumQueue queue;
+	queue.candidates = this->candidates.Begin();
+	queue.count = this->candidates.Length();
+	queue.next = 0;
+	queue.mutex = ThreadMutex::New();
+
+	uint needed = 0;
+	for (const GRFScanCandidate *c = this->candidates.Begin(); c != this->candidates.End(); c++) {
+		if (c->need_md5sum) needed++;
 	}
 
-	return added;
+	ThreadObject *threads[GRF_MD5SUM_THREADS - 1];
+	uint num_threads = 0;
+	while (num_threads < lengthof(threads) && num_threads + 1 < needed && ThreadObject::New(&CalcGRFMD5SumsThread, &queue, &threads[num_threads])) num_threads++;
+
+	CalcGRFMD5SumsThread(&queue);
+
+	for (uint i = 0; i < num_threads; i++) {
+		threads[i]->Join();
+		delete threads[i];
+	}
+	delete queue.mutex;
+}
+
+/**
+ * Add the found NewGRFs to the list of all NewGRFs, and remember them for the next scan.
+ * @return the number of NewGRFs added
+ */
+uint GRFFileScanner::AddToList()
+{
+	uint num = 0;
+
+	for (GRFScanCandidate *c = this->candidates.Begin(); c != this->candidates.End(); c++) {
+		if (!c->ok) {
+			delete c->config;
+			continue;
+		}
+
+		if (c->cache_item != UINT_MAX) this->cache[c->cache_item].config = DuplicateGRFConfig(c->config);
+		if (AddGRFToList(c->config)) {
+			num++;
+		} else {
+			/* It's already known, so forget about it. */
+			delete c->config;
+		}
+	}
+	this->candidates.Clear();
+
+	return num;
 }
 
 /**
@@ -413,7 +782,16 @@ void ScanNewGRFFiles()
 	ClearGRFConfigList(&_all_grfs);
 
 	DEBUG(grf, 1, "Scanning for NewGRFs");
-	uint num = GRFFileScanner::DoScan();
+	LoadGRFScanCache();
+
+	GRFFileScanner fs;
+	fs.DoScan();
+	fs.CalcMD5Sums();
+	uint num = fs.AddToList();
+
+	SaveGRFScanCache(&fs.cache);
+	ClearGRFScanCache(&fs.cache);
+	ClearGRFScanCache(&_grf_scan_cache);
 
 	DEBUG(grf, 1, "Scan complete, found %d files", num);
 	if (num == 0 || _all_grfs == NULL) return;
@@ -80,4 +80,9 @@ GrfSpecFeature GetGrfSpecFeature(VehicleType type);
  */
 void ShowSpriteAlignerWindow();
 
+/**
+ * Show the window with the time spent in the sprite groups of each NewGRF.
+ */
+void ShowNewGRFProfileWindow();
+
 #endif /* NEWGRF_DEBUG_H */
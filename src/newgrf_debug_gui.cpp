@@ -34,6 +34,10 @@
 #include "newgrf_spritegroup.h"
 #include "newgrf_station.h"
 #include "newgrf_town.h"
+#include "newgrf_profiling.h"
+#include "sortlist_type.h"
+#include "widgets/dropdown_func.h"
+#include "core/geometry_func.hpp"
 
 #include "table/strings.h"
 
@@ -809,3 +813,320 @@ void ShowSpriteAlignerWindow()
 {
 	AllocateWindowDescFront<SpriteAlignerWindow>(&_sprite_aligner_desc, 0);
 }
+
+/** Widgets of the NewGRF profile window. */
+enum NewGRFProfileWidgets {
+	NPW_START_STOP,      ///< Button to start or stop profiling
+	NPW_RESET,           ///< Button to forget the measurements
+	NPW_SORT_ORDER,      ///< Button to toggle the sort order
+	NPW_SORT_CRITERIA,   ///< Dropdown for the sort criteria
+	NPW_LIST,            ///< The list of measurements
+	NPW_SCROLLBAR,       ///< Scrollbar of the list
+};
+
+static const NWidgetPart _nested_newgrf_profile_widgets[] = {
+	NWidget(NWID_HORIZONTAL),
+		NWidget(WWT_CLOSEBOX, COLOUR_GREY),
+		NWidget(WWT_CAPTION, COLOUR_GREY), SetDataTip(STR_NEWGRF_PROFILE_CAPTION, STR_TOOLTIP_WINDOW_TITLE_DRAG_THIS),
+		NWidget(WWT_SHADEBOX, COLOUR_GREY),
+		NWidget(WWT_STICKYBOX, COLOUR_GREY),
+	EndContainer(),
+	NWidget(NWID_HORIZONTAL),
+		NWidget(WWT_TEXTBTN, COLOUR_GREY, NPW_START_STOP), SetDataTip(STR_NEWGRF_PROFILE_START_BUTTON, STR_NEWGRF_PROFILE_START_STOP_TOOLTIP),
+		NWidget(WWT_PUSHTXTBTN, COLOUR_GREY, NPW_RESET), SetDataTip(STR_NEWGRF_PROFILE_RESET_BUTTON, STR_NEWGRF_PROFILE_RESET_TOOLTIP),
+		NWidget(WWT_TEXTBTN, COLOUR_GREY, NPW_SORT_ORDER), SetDataTip(STR_BUTTON_SORT_BY, STR_TOOLTIP_SORT_ORDER),
+		NWidget(WWT_DROPDOWN, COLOUR_GREY, NPW_SORT_CRITERIA), SetDataTip(STR_JUST_STRING, STR_TOOLTIP_SORT_CRITERIA),
+		NWidget(WWT_PANEL, COLOUR_GREY), SetResize(1, 0), EndContainer(),
+	EndContainer(),
+	NWidget(NWID_HORIZONTAL),
+		NWidget(WWT_PANEL, COLOUR_GREY, NPW_LIST), SetMinimalSize(400, 0), SetResize(1, 1), EndContainer(),
+		NWidget(NWID_VERTICAL),
+			NWidget(WWT_SCROLLBAR, COLOUR_GREY, NPW_SCROLLBAR),
+			NWidget(WWT_RESIZEBOX, COLOUR_GREY),
+		EndContainer(),
+	EndContainer(),
+};
+
+typedef GUIList<NewGRFProfileEntry> GUINewGRFProfileList;
+
+/** Window showing the time spent in resolving the sprite groups of each NewGRF. */
+struct NewGRFProfileWindow : Window {
+	/* Runtime saved values */
+	static Listing last_sorting;
+
+	/* Constants for sorting */
+	static const StringID sorter_names[];
+	static GUINewGRFProfileList::SortFunction * const sorter_funcs[];
+
+	GUINewGRFProfileList entries;
+
+	/** (Re)Build the list of measurements */
+	void BuildSortEntryList()
+	{
+		if (this->entries.NeedRebuild()) {
+			GetNewGRFProfileEntries(&this->entries);
+
+			this->entries.Compact();
+			this->entries.RebuildDone();
+			this->vscroll.SetCount(this->entries.Length());
+		}
+
+		if (!this->entries.Sort()) return;
+		this->SetWidgetDirty(NPW_LIST);
+	}
+
+	/** Sort by name of the NewGRF and then the kind of feature */
+	static int CDECL NameSorter(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b)
+	{
+		int r = strcasecmp(GetNewGRFProfileName(a->grfid), GetNewGRFProfileName(b->grfid));
+		if (r == 0) r = a->feature - b->feature;
+		return r;
+	}
+
+	/**
+	 * Compare two measurements, falling back to the name when they are equal.
+	 * @param a The first measurement.
+	 * @param b The second measurement.
+	 * @param va The value of the first measurement to sort on.
+	 * @param vb The value of the second measurement to sort on.
+	 * @return The ordering of the measurements.
+	 */
+	static int CompareValues(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b, uint64 va, uint64 vb)
+	{
+		if (va == vb) return NameSorter(a, b);
+		return (va < vb) ? -1 : 1;
+	}
+
+	/** Sort by the number of resolves */
+	static int CDECL ResolvesSorter(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b)
+	{
+		return CompareValues(a, b, a->counts.resolves, b->counts.resolves);
+	}
+
+	/** Sort by the number of callbacks */
+	static int CDECL CallbacksSorter(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b)
+	{
+		return CompareValues(a, b, a->counts.callbacks, b->counts.callbacks);
+	}
+
+	/** Sort by the average time of a resolve */
+	static int CDECL AverageTimeSorter(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b)
+	{
+		return CompareValues(a, b, a->counts.time / a->counts.resolves, b->counts.time / b->counts.resolves);
+	}
+
+	/** Sort by the time of the longest resolve */
+	static int CDECL PeakTimeSorter(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b)
+	{
+		return CompareValues(a, b, a->counts.peak_time, b->counts.peak_time);
+	}
+
+	/** Sort by the total time spent */
+	static int CDECL TotalTimeSorter(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b)
+	{
+		return CompareValues(a, b, a->counts.time, b->counts.time);
+	}
+
+	/** Sort by the number of storage writes */
+	static int CDECL StorageWritesSorter(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b)
+	{
+		return CompareValues(a, b, a->counts.storage_writes, b->counts.storage_writes);
+	}
+
+	/**
+	 * Set the parameters of the string of a measurement.
+	 * @param entry The measurement.
+	 * @return The string to draw.
+	 */
+	static StringID GetEntryString(const NewGRFProfileEntry *entry)
+	{
+		SetDParamStr(0, GetNewGRFProfileName(entry->grfid));
+		SetDParam(1, STR_NEWGRF_PROFILE_FEATURE_VEHICLES + entry->feature);
+		SetDParam(2, entry->counts.resolves);
+		SetDParam(3, entry->counts.callbacks);
+		SetDParam(4, entry->counts.time / entry->counts.resolves);
+		SetDParam(5, entry->counts.peak_time);
+		SetDParam(6, entry->counts.time / 1000);
+		SetDParam(7, entry->counts.storage_writes);
+		return STR_NEWGRF_PROFILE_ITEM;
+	}
+
+	NewGRFProfileWindow(const WindowDesc *desc, WindowNumber number) : Window()
+	{
+		this->entries.SetListing(this->last_sorting);
+		this->entries.SetSortFuncs(NewGRFProfileWindow::sorter_funcs);
+		this->entries.ForceRebuild();
+		this->BuildSortEntryList();
+
+		this->InitNested(desc, number);
+	}
+
+	~NewGRFProfileWindow()
+	{
+		this->last_sorting = this->entries.GetListing();
+	}
+
+	virtual void SetStringParameters(int widget) const
+	{
+		if (widget == NPW_SORT_CRITERIA) SetDParam(0, NewGRFProfileWindow::sorter_names[this->entries.SortType()]);
+	}
+
+	virtual void OnPaint()
+	{
+		this->GetWidget<NWidgetCore>(NPW_START_STOP)->widget_data = _newgrf_profiling ? STR_NEWGRF_PROFILE_STOP_BUTTON : STR_NEWGRF_PROFILE_START_BUTTON;
+		this->SetWidgetLoweredState(NPW_START_STOP, _newgrf_profiling);
+		this->DrawWidgets();
+	}
+
+	virtual void DrawWidget(const Rect &r, int widget) const
+	{
+		switch (widget) {
+			case NPW_SORT_ORDER:
+				this->DrawSortButtonState(widget, this->entries.IsDescSortOrder() ? SBS_DOWN : SBS_UP);
+				break;
+
+			case NPW_LIST: {
+				int y = r.top + WD_FRAMERECT_TOP;
+				if (this->entries.Length() == 0) {
+					DrawString(r.left + WD_FRAMERECT_LEFT, r.right - WD_FRAMERECT_RIGHT, y, STR_NEWGRF_PROFILE_NONE);
+					break;
+				}
+				int n = 0;
+				for (uint i = this->vscroll.GetPosition(); i < this->entries.Length(); i++) {
+					DrawString(r.left + WD_FRAMERECT_LEFT, r.right - WD_FRAMERECT_RIGHT, y, GetEntryString(&this->entries[i]));
+
+					y += this->resize.step_height;
+					if (++n == this->vscroll.GetCapacity()) break;
+				}
+				break;
+			}
+		}
+	}
+
+	virtual void UpdateWidgetSize(int widget, Dimension *size, const Dimension &padding, Dimension *fill, Dimension *resize)
+	{
+		switch (widget) {
+			case NPW_START_STOP: {
+				Dimension d = maxdim(GetStringBoundingBox(STR_NEWGRF_PROFILE_START_BUTTON), GetStringBoundingBox(STR_NEWGRF_PROFILE_STOP_BUTTON));
+				d.width += padding.width;
+				d.height += padding.height;
+				*size = maxdim(*size, d);
+				break;
+			}
+
+			case NPW_SORT_ORDER: {
+				Dimension d = GetStringBoundingBox(this->GetWidget<NWidgetCore>(widget)->widget_data);
+				d.width += padding.width + WD_SORTBUTTON_ARROW_WIDTH * 2; // Doubled since the word is centered, also looks nice.
+				d.height += padding.height;
+				*size = maxdim(*size, d);
+				break;
+			}
+
+			case NPW_SORT_CRITERIA: {
+				Dimension d = {0, 0};
+				for (uint i = 0; NewGRFProfileWindow::sorter_names[i] != INVALID_STRING_ID; i++) {
+					d = maxdim(d, GetStringBoundingBox(NewGRFProfileWindow::sorter_names[i]));
+				}
+				d.width += padding.width;
+				d.height += padding.height;
+				*size = maxdim(*size, d);
+				break;
+			}
+
+			case NPW_LIST:
+				resize->height = FONT_HEIGHT_NORMAL;
+				size->height = 10 * resize->height + WD_FRAMERECT_TOP + WD_FRAMERECT_BOTTOM;
+				break;
+		}
+	}
+
+	virtual void OnClick(Point pt, int widget, int click_count)
+	{
+		switch (widget) {
+			case NPW_START_STOP:
+				_newgrf_profiling = !_newgrf_profiling;
+				this->SetDirty();
+				break;
+
+			case NPW_RESET:
+				NewGRFProfileReset();
+				this->entries.ForceRebuild();
+				this->BuildSortEntryList();
+				this->SetDirty();
+				break;
+
+			case NPW_SORT_ORDER:
+				this->entries.ToggleSortOrder();
+				this->SetDirty();
+				break;
+
+			case NPW_SORT_CRITERIA:
+				ShowDropDownMenu(this, NewGRFProfileWindow::sorter_names, this->entries.SortType(), NPW_SORT_CRITERIA, 0, 0);
+				break;
+		}
+	}
+
+	virtual void OnDropdownSelect(int widget, int index)
+	{
+		if (this->entries.SortType() != index) {
+			this->entries.SetSortType(index);
+			this->BuildSortEntryList();
+		}
+	}
+
+	virtual void OnResize()
+	{
+		this->vscroll.SetCapacityFromWidget(this, NPW_LIST);
+	}
+
+	virtual void OnHundredthTick()
+	{
+		this->entries.ForceRebuild();
+		this->BuildSortEntryList();
+		this->SetDirty();
+	}
+
+	virtual void OnInvalidateData(int data)
+	{
+		this->entries.ForceRebuild();
+		this->BuildSortEntryList();
+		this->SetDirty();
+	}
+};
+
+Listing NewGRFProfileWindow::last_sorting = {true, 5};
+
+/* Available sorting functions */
+GUINewGRFProfileList::SortFunction * const NewGRFProfileWindow::sorter_funcs[] = {
+	&NameSorter,
+	&ResolvesSorter,
+	&CallbacksSorter,
+	&AverageTimeSorter,
+	&PeakTimeSorter,
+	&TotalTimeSorter,
+	&StorageWritesSorter,
+};
+
+/* Names of the sorting functions */
+const StringID NewGRFProfileWindow::sorter_names[] = {
+	STR_SORT_BY_NAME,
+	STR_NEWGRF_PROFILE_SORT_BY_RESOLVES,
+	STR_NEWGRF_PROFILE_SORT_BY_CALLBACKS,
+	STR_NEWGRF_PROFILE_SORT_BY_AVERAGE_TIME,
+	STR_NEWGRF_PROFILE_SORT_BY_PEAK_TIME,
+	STR_NEWGRF_PROFILE_SORT_BY_TOTAL_TIME,
+	STR_NEWGRF_PROFILE_SORT_BY_STORAGE_WRITES,
+	INVALID_STRING_ID
+};
+
+static const WindowDesc _newgrf_profile_desc(
+	WDP_AUTO, 600, 200,
+	WC_NEWGRF_PROFILE, WC_NONE,
+	WDF_UNCLICK_BUTTONS,
+	_nested_newgrf_profile_widgets, lengthof(_nested_newgrf_profile_widgets)
+);
+
+void ShowNewGRFProfileWindow()
+{
+	AllocateWindowDescFront<NewGRFProfileWindow>(&_newgrf_profile_desc, 0);
+}
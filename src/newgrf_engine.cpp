@@ -870,6 +870,7 @@ static inline void NewVehicleResolver(ResolverObject *res, EngineID engine_type,
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = (GrfSpecFeature)(GSF_TRAINS + Engine::Get(engine_type)->type);
 	res->count           = 0;
 
 	const Engine *e = Engine::Get(engine_type);
@@ -918,17 +919,64 @@ static const SpriteGroup *GetVehicleSpriteGroup(EngineID engine, const Vehicle *
 }
 
 
+/**
+ * Get the state of a vehicle a sprite group can depend on, yet which
+ * does not cause the vehicle cache to be invalidated when it changes.
+ * @param v The vehicle to get the state of.
+ * @return The state as checked by the sprite cache.
+ */
+static inline uint64 GetVehicleSpriteState(const Vehicle *v)
+{
+	const Vehicle *parent = v->First();
+	uint64 state = v->cargo.Count();
+	state |= (uint64)v->cargo_cap << 16;
+	state |= (uint64)v->cargo_type << 32;
+	state |= (uint64)v->random_bits << 40;
+	state |= (uint64)parent->random_bits << 48;
+	if (parent->current_order.IsType(OT_LOADING)) state |= (uint64)1 << 56;
+	return state;
+}
+
 SpriteID GetCustomEngineSprite(EngineID engine, const Vehicle *v, Direction direction)
 {
-	const SpriteGroup *group;
+	const SpriteGroup *root = GetVehicleSpriteGroup(engine, v);
+
+	/* The sprite is asked for on every step of the vehicle, but for most
+	 * sets it only depends on things that rarely change. */
+	bool cacheable = v != NULL && SpriteGroup::IsCacheable(root);
+	uint64 state = 0;
+	if (cacheable) {
+		state = GetVehicleSpriteState(v);
+		if (HasBit(v->vcache.cache_valid, 4) && v->vcache.cached_sprite_group == root && v->vcache.cached_sprite_state == state) {
+			if (v->vcache.cached_sprite_num == 0) return 0;
+			return v->vcache.cached_sprite + (direction % v->vcache.cached_sprite_num);
+		}
+	}
+
 	ResolverObject object;
 
 	NewVehicleResolver(&object, engine, v);
 
-	group = SpriteGroup::Resolve(GetVehicleSpriteGroup(engine, v), &object);
-	if (group == NULL || group->GetNumResults() == 0) return 0;
+	const SpriteGroup *group = SpriteGroup::Resolve(root, &object);
+	SpriteID sprite = 0;
+	byte num = 0;
+	if (group != NULL) {
+		sprite = group->GetResult();
+		num = group->GetNumResults();
+	}
+
+	if (cacheable) {
+		Vehicle *u = const_cast<Vehicle *>(v);
+		u->vcache.cached_sprite_group = root;
+		u->vcache.cached_sprite_state = state;
+		u->vcache.cached_sprite       = sprite;
+		u->vcache.cached_sprite_num   = num;
+		SetBit(u->vcache.cache_valid, 4);
+	}
+
+	if (num == 0) return 0;
 
-	return group->GetResult() + (direction % group->GetNumResults());
+	return sprite + (direction % num);
 }
 
 
@@ -1152,7 +1200,7 @@ void AlterVehicleListOrder(EngineID engine, EngineID target)
 void CommitVehicleListOrderChanges()
 {
 	/* List position to Engine map */
-	typedef SmallMap<uint16, Engine *, 16> ListPositionMap;
+	typedef HashedSmallMap<uint16, Engine *, 16> ListPositionMap;
 	ListPositionMap lptr_map;
 
 	const ListOrderChange *end = _list_order_changes.End();
@@ -129,6 +129,7 @@ static inline void NewGenericResolver(ResolverObject *res, const GRFFile *grffil
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_INVALID;
 	res->count           = 0;
 	res->grffile         = grffile;
 }
@@ -148,6 +149,7 @@ static uint16 GetGenericCallbackResult(uint8 feature, ResolverObject *object, co
 	/* Test each feature callback sprite group. */
 	for (GenericCallbackList::const_iterator it = _gcl[feature].begin(); it != _gcl[feature].end(); ++it) {
 		const SpriteGroup *group = it->group;
+		object->feature = (GrfSpecFeature)feature;
 		group = SpriteGroup::Resolve(group, object);
 		if (group == NULL) continue;
 
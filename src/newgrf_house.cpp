@@ -384,6 +384,7 @@ static void NewHouseResolver(ResolverObject *res, HouseID house_id, TileIndex ti
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_HOUSES;
 	res->count           = 0;
 
 	const HouseSpec *hs = HouseSpec::Get(house_id);
@@ -473,6 +474,10 @@ void AnimateNewHouseTile(TileIndex tile)
 	byte animation_speed = hs->animation_speed;
 	bool frame_set_by_callback = false;
 
+	/* Even the fastest animation only changes every fourth tick; there is
+	 * no need to ask the callback for the speed in between. */
+	if (_tick_counter % (1 << 2) != 0) return;
+
 	if (HasBit(hs->callback_mask, CBM_HOUSE_ANIMATION_SPEED)) {
 		uint16 callback_res = GetHouseCallback(CBID_HOUSE_ANIMATION_SPEED, 0, 0, GetHouseType(tile), Town::GetByTile(tile), tile);
 		if (callback_res != CALLBACK_FAILED) animation_speed = Clamp(callback_res & 0xFF, 2, 16);
@@ -377,6 +377,7 @@ static void NewIndustryResolver(ResolverObject *res, TileIndex tile, Industry *i
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_INDUSTRIES;
 	res->count           = 0;
 
 	const IndustrySpec *indspec = GetIndustrySpec(type);
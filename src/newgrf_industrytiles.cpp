@@ -170,6 +170,7 @@ static void NewIndustryTileResolver(ResolverObject *res, IndustryGfx gfx, TileIn
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_INDUSTRYTILES;
 	res->count           = 0;
 
 	const IndustryTileSpec *its = GetIndustryTileSpec(gfx);
@@ -297,11 +298,15 @@ CommandCost PerformIndustryTileSlopeCheck(TileIndex ind_base_tile, TileIndex ind
 
 void AnimateNewIndustryTile(TileIndex tile)
 {
-	Industry *ind = Industry::GetByTile(tile);
 	IndustryGfx gfx = GetIndustryGfx(tile);
 	const IndustryTileSpec *itspec = GetIndustryTileSpec(gfx);
 	byte animation_speed = itspec->animation_speed;
 
+	/* Without callback most tiles are not animated this tick; bail out before looking up the industry. */
+	if (!HasBit(itspec->callback_mask, CBM_INDT_ANIM_SPEED) && (_tick_counter % (1 << animation_speed)) != 0) return;
+
+	Industry *ind = Industry::GetByTile(tile);
+
 	if (HasBit(itspec->callback_mask, CBM_INDT_ANIM_SPEED)) {
 		uint16 callback_res = GetIndustryTileCallback(CBID_INDTILE_ANIMATION_SPEED, 0, 0, gfx, ind, tile);
 		if (callback_res != CALLBACK_FAILED) animation_speed = Clamp(callback_res & 0xFF, 0, 16);
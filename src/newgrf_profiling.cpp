@@ -0,0 +1,182 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file newgrf_profiling.cpp Measuring the time spent in resolving the sprite groups of each NewGRF and the memory they use. */
+
+#include "stdafx.h"
+#include "newgrf_profiling.h"
+#include "newgrf_config.h"
+#include "newgrf_text.h"
+#include "console_func.h"
+#include "core/bitmath_func.hpp"
+#include "core/mem_func.hpp"
+#include "core/sort_func.hpp"
+
+bool _newgrf_profiling = false;          ///< Whether resolving sprite groups is being measured.
+uint _newgrf_profile_storage_writes = 0; ///< Number of writes to the NewGRF storages done so far.
+
+/** Names of the kinds of features, as shown in the console. */
+static const char * const _newgrf_profile_feature_names[] = {
+	"vehicles",
+	"stations",
+	"houses",
+	"industries",
+	"airports",
+	"canals",
+	"other",
+};
+assert_compile(lengthof(_newgrf_profile_feature_names) == NPF_END);
+
+/**
+ * Get the kind of feature the measurements of a feature are added to.
+ * @param feature The feature to get the kind of.
+ * @return The kind of feature.
+ */
+NewGRFProfileFeature GetNewGRFProfileFeature(GrfSpecFeature feature)
+{
+	switch (feature) {
+		case GSF_TRAINS:
+		case GSF_ROADVEHICLES:
+		case GSF_SHIPS:
+		case GSF_AIRCRAFT:
+			return NPF_VEHICLES;
+
+		case GSF_STATIONS:      return NPF_STATIONS;
+		case GSF_HOUSES:        return NPF_HOUSES;
+
+		case GSF_INDUSTRIES:
+		case GSF_INDUSTRYTILES:
+			return NPF_INDUSTRIES;
+
+		case GSF_AIRPORTS:
+		case GSF_AIRPORTTILES:
+			return NPF_AIRPORTS;
+
+		case GSF_CANALS:        return NPF_CANALS;
+		default:                return NPF_OTHER;
+	}
+}
+
+/**
+ * Add the measurements of resolving a sprite group.
+ * @param grffile        The NewGRF the resolved group belongs to.
+ * @param feature        The feature of the object the group was resolved for.
+ * @param callback       Whether a callback was resolved.
+ * @param time           The time resolving took, in rdtsc cycles.
+ * @param storage_writes The number of writes to the NewGRF storages while resolving.
+ */
+void NewGRFProfileAdd(const GRFFile *grffile, GrfSpecFeature feature, bool callback, uint64 time, uint storage_writes)
+{
+	NewGRFProfileCounts *counts = &const_cast<GRFFile *>(grffile)->profile[GetNewGRFProfileFeature(feature)];
+
+	counts->resolves++;
+	if (callback) counts->callbacks++;
+	counts->storage_writes += storage_writes;
+	counts->time += time;
+	counts->peak_time = max(counts->peak_time, time);
+}
+
+/**
+ * Get the measurements of all active NewGRFs, one entry for every kind of
+ * feature a NewGRF resolved sprite groups for.
+ * @param list The list to fill.
+ */
+void GetNewGRFProfileEntries(NewGRFProfileEntryList *list)
+{
+	list->Clear();
+
+	for (const GRFConfig *c = _grfconfig; c != NULL; c = c->next) {
+		const GRFFile *grffile = GetFileByGRFID(c->ident.grfid);
+		if (grffile == NULL) continue;
+
+		for (uint i = 0; i < NPF_END; i++) {
+			if (grffile->profile[i].resolves == 0) continue;
+
+			NewGRFProfileEntry *entry = list->Append();
+			entry->grfid   = grffile->grfid;
+			entry->feature = (NewGRFProfileFeature)i;
+			entry->counts  = grffile->profile[i];
+		}
+	}
+}
+
+/**
+ * Get the name of a NewGRF to show in the profile.
+ * @param grfid The ID of the NewGRF to get the name of.
+ * @return The name.
+ */
+const char *GetNewGRFProfileName(uint32 grfid)
+{
+	const GRFConfig *c = GetGRFConfig(grfid);
+	return (c == NULL) ? "" : c->GetName();
+}
+
+/** Forget all measurements. */
+void NewGRFProfileReset()
+{
+	for (const GRFConfig *c = _grfconfig; c != NULL; c = c->next) {
+		GRFFile *grffile = GetFileByGRFID(c->ident.grfid);
+		if (grffile != NULL) MemSetT(grffile->profile, 0, lengthof(grffile->profile));
+	}
+}
+
+/** Sort the entries by the total time spent, the most expensive first. */
+static int CDECL NewGRFProfileTimeSorter(const NewGRFProfileEntry *a, const NewGRFProfileEntry *b)
+{
+	if (a->counts.time == b->counts.time) return 0;
+	return (a->counts.time < b->counts.time) ? 1 : -1;
+}
+
+/** Print the collected measurements to the console. */
+void NewGRFProfilePrint()
+{
+	NewGRFProfileEntryList list;
+	GetNewGRFProfileEntries(&list);
+
+	if (list.Length() == 0) {
+		IConsolePrint(CC_DEFAULT, "No sprite groups have been resolved while profiling.");
+		return;
+	}
+
+	QSortT(list.Begin(), list.Length(), &NewGRFProfileTimeSorter);
+
+	IConsolePrint(CC_DEFAULT, "NewGRF sprite group resolving; times in cycles, total in kilocycles:");
+	IConsolePrintF(CC_DEFAULT, "  %-8s %-10s %10s %10s %8s %8s %10s %10s  %s", "grfid", "feature", "resolves", "callbacks", "average", "peak", "total", "writes", "name");
+
+	for (const NewGRFProfileEntry *entry = list.Begin(); entry != list.End(); entry++) {
+		const NewGRFProfileCounts *counts = &entry->counts;
+		IConsolePrintF(CC_DEFAULT, "  %08X %-10s %10u %10u %8u %8u %10u %10u  %s",
+				BSWAP32(entry->grfid), _newgrf_profile_feature_names[entry->feature],
+				(uint)counts->resolves, (uint)counts->callbacks, (uint)(counts->time / counts->resolves), (uint)counts->peak_time,
+				(uint)(counts->time / 1000), (uint)counts->storage_writes, GetNewGRFProfileName(entry->grfid));
+	}
+}
+
+/** Print the memory used by the data of each active NewGRF to the console. */
+void NewGRFMemoryPrint()
+{
+	IConsolePrint(CC_DEFAULT, "NewGRF memory usage; sizes in KiB, sprites are in the sprite cache:");
+	IConsolePrintF(CC_DEFAULT, "  %-8s %8s %8s %8s %8s %8s  %s", "grfid", "sprites", "groups", "size", "texts", "size", "name");
+
+	size_t total = 0;
+	for (const GRFConfig *c = _grfconfig; c != NULL; c = c->next) {
+		const GRFFile *grffile = GetFileByGRFID(c->ident.grfid);
+		if (grffile == NULL) continue;
+
+		uint num_texts;
+		size_t text_memory = GetGRFTextMemoryUsage(grffile->grfid, &num_texts);
+		total += grffile->spritegroup_memory + text_memory;
+
+		IConsolePrintF(CC_DEFAULT, "  %08X %8u %8u %8u %8u %8u  %s",
+				BSWAP32(grffile->grfid), grffile->num_sprites, grffile->num_spritegroups, (uint)(grffile->spritegroup_memory / 1024),
+				num_texts, (uint)(text_memory / 1024), c->GetName());
+	}
+
+	IConsolePrintF(CC_DEFAULT, "Total: %u KiB", (uint)(total / 1024));
+}
@@ -0,0 +1,39 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file newgrf_profiling.h Measuring the time spent in resolving the sprite groups of each NewGRF and the memory they use. */
+
+#ifndef NEWGRF_PROFILING_H
+#define NEWGRF_PROFILING_H
+
+#include "newgrf.h"
+#include "core/smallvec_type.hpp"
+
+/** A single line of the profile: the measurements of one NewGRF for one kind of feature. */
+struct NewGRFProfileEntry {
+	uint32 grfid;                 ///< The NewGRF that was measured.
+	NewGRFProfileFeature feature; ///< The kind of feature that was measured.
+	NewGRFProfileCounts counts;   ///< Copy of the measurements.
+};
+
+/** A list of lines of the profile. */
+typedef SmallVector<NewGRFProfileEntry, 32> NewGRFProfileEntryList;
+
+extern bool _newgrf_profiling;
+extern uint _newgrf_profile_storage_writes;
+
+NewGRFProfileFeature GetNewGRFProfileFeature(GrfSpecFeature feature);
+void NewGRFProfileAdd(const GRFFile *grffile, GrfSpecFeature feature, bool callback, uint64 time, uint storage_writes);
+void GetNewGRFProfileEntries(NewGRFProfileEntryList *list);
+const char *GetNewGRFProfileName(uint32 grfid);
+void NewGRFProfileReset();
+void NewGRFProfilePrint();
+void NewGRFMemoryPrint();
+
+#endif /* NEWGRF_PROFILING_H */
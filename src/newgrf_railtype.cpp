@@ -93,6 +93,7 @@ static inline void NewRailTypeResolver(ResolverObject *res, TileIndex tile, bool
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_RAILTYPES;
 	res->count           = 0;
 }
 
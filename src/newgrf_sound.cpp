@@ -54,6 +54,9 @@ uint GetNumSounds()
 
 bool PlayVehicleSound(const Vehicle *v, VehicleSoundEvent event)
 {
+	/* Nobody would hear it; don't ask the NewGRF, nor play the default sound. */
+	if (!SndIsVehicleAudible(v)) return true;
+
 	const GRFFile *file = GetEngineGRF(v->engine_type);
 	uint16 callback;
 
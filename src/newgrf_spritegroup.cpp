@@ -15,6 +15,10 @@
 #include "sprite.h"
 #include "core/bitmath_func.hpp"
 #include "core/pool_func.hpp"
+#include "core/smallvec_type.hpp"
+#include "core/sort_func.hpp"
+#include "date_func.h"
+#include "pathfinder/pf_performance_timer.hpp"
 
 SpriteGroupPool _spritegroup_pool("SpriteGroup");
 INSTANTIATE_POOL_METHODS(SpriteGroup)
@@ -25,10 +29,172 @@ RealSpriteGroup::~RealSpriteGroup()
 	free((void*)this->loading);
 }
 
+/**
+ * A remembered resolve of a pure DeterministicSpriteGroup. Such a group gives
+ * the same result as long as its inputs, which are all in the key, and the
+ * date do not change, so it is only remembered for the tick it was made in.
+ */
+struct SpriteGroupMemo {
+	const DeterministicSpriteGroup *group; ///< The group that was resolved, NULL for an unused entry.
+	const GRFFile *grffile;                ///< GRF file of the resolver, for the GRF parameters.
+	CallbackID callback;                   ///< The callback that was resolved.
+	uint32 callback_param1;                ///< First parameter of the callback.
+	uint32 callback_param2;                ///< Second parameter of the callback.
+	uint16 tick;                           ///< Tick the resolve was made in.
+	Date date;                             ///< Date the resolve was made at.
+	DateFract date_fract;                  ///< Fraction of the date the resolve was made at.
+
+	const SpriteGroup *result;             ///< The group it resolved to.
+	uint16 nvarzero_result;                ///< The callback result, when the result is the shared group for nvar == 0.
+	uint32 last_value;                     ///< The last value of the resolver after resolving.
+	VarSpriteGroupScope scope;             ///< The scope of the resolver after resolving.
+};
+
+/** Groups with a lower cost are cheaper to resolve than to look up. */
+static const uint SPRITE_GROUP_MEMO_MIN_COST = 4;
+
+static SpriteGroupMemo _spritegroup_memo[256]; ///< The remembered resolves, by hash of their key.
+
+/** Shared result of the deterministic groups with nvar == 0, which turn their value into a callback result. */
+static CallbackResultSpriteGroup _nvarzero(0);
+
+/**
+ * Get the entry of the memo table for a resolve.
+ * @param group  The group to resolve.
+ * @param object The resolver.
+ * @return The entry, which might hold another resolve.
+ */
+static inline SpriteGroupMemo *GetSpriteGroupMemo(const DeterministicSpriteGroup *group, const ResolverObject *object)
+{
+	size_t hash = (size_t)group >> 4;
+	hash ^= object->callback * 0x9E37 ^ object->callback_param1 * 0x3B ^ object->callback_param2 * 0x1F3;
+	return &_spritegroup_memo[(hash ^ (hash >> 8)) & (lengthof(_spritegroup_memo) - 1)];
+}
+
 DeterministicSpriteGroup::~DeterministicSpriteGroup()
 {
 	free(this->adjusts);
 	free(this->ranges);
+	free(this->dispatch);
+
+	/* A new group may be allocated at the same address. */
+	if (this->pure) {
+		for (uint i = 0; i < lengthof(_spritegroup_memo); i++) {
+			if (_spritegroup_memo[i].group == this) _spritegroup_memo[i].group = NULL;
+		}
+	}
+}
+
+/** Sort the bounds of the ranges of a DeterministicSpriteGroup ascending. */
+static int CDECL CompareBounds(const uint64 *a, const uint64 *b)
+{
+	return *a < *b ? -1 : (*a > *b ? 1 : 0);
+}
+
+/**
+ * Build the table that is used to find the group for a value. The ranges of
+ * an action 2 may overlap, in which case the first one wins, so finding the
+ * group means checking all of them in order. The table splits them into
+ * disjoint ranges that give the same group, so it can be binary searched.
+ * Must be called once all ranges are read.
+ */
+void DeterministicSpriteGroup::InitDispatch()
+{
+	free(this->dispatch);
+	this->dispatch = NULL;
+	this->num_dispatch = 0;
+	if (this->num_ranges == 0) return;
+
+	/* Every lower bound and every value just after an upper bound is where the group may change. */
+	SmallVector<uint64, 16> bounds;
+	for (uint i = 0; i < this->num_ranges; i++) {
+		if (this->ranges[i].low > this->ranges[i].high) continue;
+		bounds.Include(this->ranges[i].low);
+		bounds.Include((uint64)this->ranges[i].high + 1);
+	}
+	QSortT(bounds.Begin(), bounds.Length(), &CompareBounds);
+
+	this->error_group = this->ranges[0].group;
+	this->dispatch = MallocT<DeterministicSpriteGroupRange>(max(bounds.Length(), 1U));
+	for (uint b = 0; b + 1 < bounds.Length(); b++) {
+		uint32 low  = (uint32)bounds[b];
+		uint32 high = (uint32)(bounds[b + 1] - 1);
+
+		/* Between two bounds all values are in the same ranges, so the first one containing low wins. */
+		const SpriteGroup *group = NULL;
+		bool found = false;
+		for (uint i = 0; i < this->num_ranges; i++) {
+			if (this->ranges[i].low <= low && low <= this->ranges[i].high) {
+				group = this->ranges[i].group;
+				found = true;
+				break;
+			}
+		}
+		if (!found) continue;
+
+		/* Merge with the previous entry when it ends right before this one with the same group. */
+		if (this->num_dispatch > 0) {
+			DeterministicSpriteGroupRange *last = &this->dispatch[this->num_dispatch - 1];
+			if (last->group == group && last->high + 1 == low) {
+				last->high = high;
+				continue;
+			}
+		}
+
+		DeterministicSpriteGroupRange *range = &this->dispatch[this->num_dispatch++];
+		range->group = group;
+		range->low   = low;
+		range->high  = high;
+	}
+
+	/* Only the table is used for resolving, so trim it and drop the ranges as read. */
+	if (this->num_dispatch > 0) this->dispatch = ReallocT(this->dispatch, this->num_dispatch);
+	free(this->ranges);
+	this->ranges = NULL;
+}
+
+/**
+ * Get one of the groups a DeterministicSpriteGroup can resolve to.
+ * @param group The group to get it from.
+ * @param i     Index of the group, up to the number of dispatch entries plus two.
+ * @return The default group, the group for unavailable variables or the group of a dispatch entry.
+ */
+static inline const SpriteGroup *GetDeterministicChoice(const DeterministicSpriteGroup *group, uint i)
+{
+	switch (i) {
+		case 0: return group->default_group;
+		case 1: return group->error_group;
+		default: return group->dispatch[i - 2].group;
+	}
+}
+
+size_t RealSpriteGroup::GetMemoryUsage() const
+{
+	return sizeof(*this) + (this->num_loaded + this->num_loading) * sizeof(*this->loaded);
+}
+
+size_t DeterministicSpriteGroup::GetMemoryUsage() const
+{
+	return sizeof(*this) + this->num_adjusts * sizeof(*this->adjusts) + this->num_dispatch * sizeof(*this->dispatch);
+}
+
+size_t RandomizedSpriteGroup::GetMemoryUsage() const
+{
+	return sizeof(*this) + this->num_groups * sizeof(*this->groups);
+}
+
+size_t TileLayoutSpriteGroup::GetMemoryUsage() const
+{
+	size_t size = sizeof(*this);
+	if (this->dts == NULL) return size;
+
+	size += sizeof(*this->dts);
+	if (this->dts->seq != NULL) {
+		const DrawTileSeqStruct *dtss;
+		foreach_draw_tile_seq(dtss, this->dts->seq) {}
+		size += (dtss - this->dts->seq + 1) * sizeof(*dtss);
+	}
+	return size;
 }
 
 RandomizedSpriteGroup::~RandomizedSpriteGroup()
@@ -38,10 +204,194 @@ RandomizedSpriteGroup::~RandomizedSpriteGroup()
 
 TileLayoutSpriteGroup::~TileLayoutSpriteGroup()
 {
-	free((void*)this->dts->seq);
+	if (this->dts != NULL) free(const_cast<DrawTileSeqStruct *>(this->dts->seq));
 	free(this->dts);
 }
 
+/**
+ * Determine whether the result of a group only depends on the inputs kept in
+ * a SpriteGroupMemo, and estimate how much work resolving it is. Only the
+ * variables listed below qualify; all others depend on the object being
+ * resolved or on things that change without a tick passing. Writing to the
+ * storages and reading the registers are side effects or inputs too.
+ * Must be called once the group is completely read, which is after the
+ * groups it refers to were read.
+ */
+void DeterministicSpriteGroup::InitMemo()
+{
+	this->pure = true;
+	uint cost = this->num_adjusts;
+
+	for (uint i = 0; i < this->num_adjusts && this->pure; i++) {
+		const DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
+		if (adjust->operation == DSGA_OP_STO || adjust->operation == DSGA_OP_STOP) this->pure = false;
+
+		switch (adjust->variable) {
+			case 0x00: case 0x01: case 0x02: case 0x03: // date, year, date details, climate
+			case 0x09: case 0x0A: case 0x0B:            // date fraction, tick counter, TTDPatch version
+			case 0x0C: case 0x10: case 0x18:            // callback and its parameters
+			case 0x1A: case 0x1D: case 0x21:            // -1, platform, OpenTTD version
+			case 0x7F:                                  // GRF parameter
+				break;
+
+			case 0x7E: { // procedure call
+				const SpriteGroup *sub = adjust->subroutine;
+				if (sub != NULL && sub->type == SGT_DETERMINISTIC && ((const DeterministicSpriteGroup *)sub)->pure) {
+					cost += ((const DeterministicSpriteGroup *)sub)->cost;
+				} else if (sub != NULL && sub->type != SGT_CALLBACK && sub->type != SGT_RESULT) {
+					this->pure = false;
+				}
+				break;
+			}
+
+			default:
+				this->pure = false;
+				break;
+		}
+	}
+
+	/* All the groups it can resolve to must give the same result for the same inputs as well. */
+	uint max_range_cost = 0;
+	for (uint i = 0; i < this->num_dispatch + 2 && this->pure; i++) {
+		const SpriteGroup *group = GetDeterministicChoice(this, i);
+		if (group == NULL) continue;
+		switch (group->type) {
+			case SGT_CALLBACK:
+			case SGT_RESULT:
+			case SGT_TILELAYOUT:
+			case SGT_INDUSTRY_PRODUCTION:
+				break;
+
+			case SGT_DETERMINISTIC:
+				if (((const DeterministicSpriteGroup *)group)->pure) {
+					max_range_cost = max<uint>(max_range_cost, ((const DeterministicSpriteGroup *)group)->cost);
+				} else {
+					this->pure = false;
+				}
+				break;
+
+			default:
+				this->pure = false;
+				break;
+		}
+	}
+
+	this->cost = min<uint>(cost + max_range_cost, UINT8_MAX);
+}
+
+/**
+ * Resolve a group and add how long it took to the profile of its NewGRF.
+ * Only the outermost resolve is measured, the groups it resolves to are
+ * part of that measurement.
+ * @param group  The group to resolve.
+ * @param object The resolver.
+ * @return The resolved group.
+ */
+/* static */ const SpriteGroup *SpriteGroup::ResolveProfiled(const SpriteGroup *group, ResolverObject *object)
+{
+	static uint depth = 0;
+
+	if (depth++ > 0 || object->grffile == NULL) {
+		const SpriteGroup *result = group->Resolve(object);
+		depth--;
+		return result;
+	}
+
+	uint storage_writes = _newgrf_profile_storage_writes;
+	CPerformanceTimer timer;
+	timer.Start();
+	const SpriteGroup *result = group->Resolve(object);
+	timer.Stop();
+	depth--;
+
+	NewGRFProfileAdd(object->grffile, object->feature, object->callback != CBID_NO_CALLBACK, timer.m_acc, _newgrf_profile_storage_writes - storage_writes);
+	return result;
+}
+
+/**
+ * Whether the result of resolving a group for a vehicle only changes when
+ * the vehicle cache is invalidated or when the state the sprite cache of
+ * the vehicle is checked against changes; that is the cargo, the loading
+ * state and the random bits of the vehicle and its parent.
+ * @param group The group to check.
+ * @return True when the result may be cached.
+ */
+/* static */ bool SpriteGroup::IsCacheable(const SpriteGroup *group)
+{
+	if (group == NULL) return true;
+
+	switch (group->type) {
+		case SGT_REAL:
+		case SGT_CALLBACK:
+		case SGT_RESULT:
+			return true;
+
+		case SGT_DETERMINISTIC: return ((const DeterministicSpriteGroup *)group)->cacheable;
+		case SGT_RANDOMIZED:    return ((const RandomizedSpriteGroup *)group)->cacheable;
+
+		default: return false;
+	}
+}
+
+/**
+ * Determine whether resolving the group for a vehicle may be cached, see
+ * SpriteGroup::IsCacheable. Besides the variables that never change
+ * during a game, only the vehicle variables that are kept in the vehicle
+ * cache themselves and the random bits qualify. The cache of the parent
+ * is not invalidated together with the one of the vehicle, so those
+ * variables only qualify for the vehicle itself.
+ * Must only be called for groups of vehicles, once the group is completely read.
+ */
+void DeterministicSpriteGroup::InitCacheable()
+{
+	this->cacheable = true;
+
+	for (uint i = 0; i < this->num_adjusts && this->cacheable; i++) {
+		const DeterministicSpriteGroupAdjust *adjust = &this->adjusts[i];
+		if (adjust->operation == DSGA_OP_STO || adjust->operation == DSGA_OP_STOP) this->cacheable = false;
+
+		switch (adjust->variable) {
+			case 0x03: case 0x0B:                       // climate, TTDPatch version
+			case 0x0C: case 0x10: case 0x18:            // callback and its parameters
+			case 0x1A: case 0x1C: case 0x1D: case 0x21: // -1, last computed result, platform, OpenTTD version
+			case 0x5F:                                  // random bits and triggers
+			case 0x7F:                                  // GRF parameter
+				break;
+
+			case 0x40: case 0x41: case 0x42: case 0x43: // consist and company information
+				if (this->var_scope != VSG_SCOPE_SELF) this->cacheable = false;
+				break;
+
+			case 0x7E: // procedure call
+				this->cacheable = SpriteGroup::IsCacheable(adjust->subroutine);
+				break;
+
+			default:
+				this->cacheable = false;
+				break;
+		}
+	}
+
+	for (uint i = 0; i < this->num_dispatch + 2 && this->cacheable; i++) {
+		this->cacheable = SpriteGroup::IsCacheable(GetDeterministicChoice(this, i));
+	}
+}
+
+/**
+ * Determine whether resolving the group for a vehicle may be cached, see
+ * SpriteGroup::IsCacheable. The random bits of other vehicles than the
+ * vehicle itself and its parent are not checked by the cache.
+ * Must only be called for groups of vehicles, once the group is completely read.
+ */
+void RandomizedSpriteGroup::InitCacheable()
+{
+	this->cacheable = this->var_scope != VSG_SCOPE_RELATIVE;
+
+	for (uint i = 0; i < this->num_groups && this->cacheable; i++) {
+		this->cacheable = SpriteGroup::IsCacheable(this->groups[i]);
+	}
+}
+
 TemporaryStorageArray<int32, 0x110> _temp_store;
 
 
@@ -118,9 +468,9 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ResolverObjec
 		case DSGA_OP_AND:  return last_value & value;
 		case DSGA_OP_OR:   return last_value | value;
 		case DSGA_OP_XOR:  return last_value ^ value;
-		case DSGA_OP_STO:  _temp_store.Store((U)value, (S)last_value); return last_value;
+		case DSGA_OP_STO:  _temp_store.Store((U)value, (S)last_value); _newgrf_profile_storage_writes++; return last_value;
 		case DSGA_OP_RST:  return value;
-		case DSGA_OP_STOP: if (object->psa != NULL) object->psa->Store((U)value, (S)last_value); return last_value;
+		case DSGA_OP_STOP: if (object->psa != NULL) object->psa->Store((U)value, (S)last_value); _newgrf_profile_storage_writes++; return last_value;
 		case DSGA_OP_ROR:  return RotateRight(last_value, value);
 		case DSGA_OP_SCMP: return ((S)last_value == (S)value) ? 1 : ((S)last_value < (S)value ? 0 : 2);
 		case DSGA_OP_UCMP: return ((U)last_value == (U)value) ? 1 : ((U)last_value < (U)value ? 0 : 2);
@@ -130,6 +480,42 @@ static U EvalAdjustT(const DeterministicSpriteGroupAdjust *adjust, ResolverObjec
 
 
 const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject *object) const
+{
+	if (!this->pure || this->cost < SPRITE_GROUP_MEMO_MIN_COST) return this->ResolveChain(object);
+
+	SpriteGroupMemo *memo = GetSpriteGroupMemo(this, object);
+	if (memo->group == this && memo->grffile == object->grffile && memo->callback == object->callback &&
+			memo->callback_param1 == object->callback_param1 && memo->callback_param2 == object->callback_param2 &&
+			memo->tick == _tick_counter && memo->date == _date && memo->date_fract == _date_fract) {
+		object->last_value = memo->last_value;
+		object->scope = memo->scope;
+		if (memo->result == &_nvarzero) _nvarzero.result = memo->nvarzero_result;
+		return memo->result;
+	}
+
+	const SpriteGroup *result = this->ResolveChain(object);
+
+	memo->group           = this;
+	memo->grffile         = object->grffile;
+	memo->callback        = object->callback;
+	memo->callback_param1 = object->callback_param1;
+	memo->callback_param2 = object->callback_param2;
+	memo->tick            = _tick_counter;
+	memo->date            = _date;
+	memo->date_fract      = _date_fract;
+	memo->result          = result;
+	memo->nvarzero_result = _nvarzero.result;
+	memo->last_value      = object->last_value;
+	memo->scope           = object->scope;
+	return result;
+}
+
+/**
+ * Resolve the group by evaluating its adjusts.
+ * @param object The resolver.
+ * @return The group it resolves to.
+ */
+const SpriteGroup *DeterministicSpriteGroup::ResolveChain(ResolverObject *object) const
 {
 	uint32 last_value = 0;
 	uint32 value = 0;
@@ -160,7 +546,7 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject *object) con
 		if (!available) {
 			/* Unsupported property: skip further processing and return either
 			 * the group from the first range or the default group. */
-			return SpriteGroup::Resolve(this->num_ranges > 0 ? this->ranges[0].group : this->default_group, object);
+			return SpriteGroup::Resolve(this->num_ranges > 0 ? this->error_group : this->default_group, object);
 		}
 
 		switch (this->size) {
@@ -177,14 +563,22 @@ const SpriteGroup *DeterministicSpriteGroup::Resolve(ResolverObject *object) con
 	if (this->num_ranges == 0) {
 		/* nvar == 0 is a special case -- we turn our value into a callback result */
 		if (value != CALLBACK_FAILED) value = GB(value, 0, 15);
-		static CallbackResultSpriteGroup nvarzero(0);
-		nvarzero.result = value;
-		return &nvarzero;
+		_nvarzero.result = value;
+		return &_nvarzero;
 	}
 
-	for (i = 0; i < this->num_ranges; i++) {
-		if (this->ranges[i].low <= value && value <= this->ranges[i].high) {
-			return SpriteGroup::Resolve(this->ranges[i].group, object);
+	/* Binary search the disjoint ranges for the one containing the value. */
+	uint first = 0;
+	uint last = this->num_dispatch;
+	while (first < last) {
+		uint mid = (first + last) / 2;
+		const DeterministicSpriteGroupRange *range = &this->dispatch[mid];
+		if (value < range->low) {
+			last = mid;
+		} else if (value > range->high) {
+			first = mid + 1;
+		} else {
+			return SpriteGroup::Resolve(range->group, object);
 		}
 	}
 
@@ -22,6 +22,7 @@
 #include "newgrf_callbacks.h"
 #include "newgrf_generic.h"
 #include "newgrf_storage.h"
+#include "newgrf_profiling.h"
 
 /**
  * Gets the value of a so-called newgrf "register".
@@ -71,6 +72,12 @@ public:
 	virtual byte GetNumResults() const { return 0; }
 	virtual uint16 GetCallbackResult() const { return CALLBACK_FAILED; }
 
+	/**
+	 * Get the amount of memory used by the group, including the arrays it owns.
+	 * @return The number of bytes.
+	 */
+	virtual size_t GetMemoryUsage() const = 0;
+
 	/**
 	 * ResolverObject (re)entry point.
 	 * This cannot be made a call to a virtual function because virtual functions
@@ -82,8 +89,14 @@ public:
 	 */
 	static const SpriteGroup *Resolve(const SpriteGroup *group, ResolverObject *object)
 	{
-		return group == NULL ? NULL : group->Resolve(object);
+		if (group == NULL) return NULL;
+		if (_newgrf_profiling) return ResolveProfiled(group, object);
+		return group->Resolve(object);
 	}
+
+	static const SpriteGroup *ResolveProfiled(const SpriteGroup *group, ResolverObject *object);
+
+	static bool IsCacheable(const SpriteGroup *group);
 };
 
 
@@ -105,6 +118,8 @@ struct RealSpriteGroup : SpriteGroup {
 	const SpriteGroup **loaded;  ///< List of loaded groups (can be SpriteIDs or Callback results)
 	const SpriteGroup **loading; ///< List of loading groups (can be SpriteIDs or Callback results)
 
+	size_t GetMemoryUsage() const;
+
 protected:
 	const SpriteGroup *Resolve(ResolverObject *object) const;
 };
@@ -183,13 +198,28 @@ struct DeterministicSpriteGroup : SpriteGroup {
 	byte num_adjusts;
 	byte num_ranges;
 	DeterministicSpriteGroupAdjust *adjusts;
-	DeterministicSpriteGroupRange *ranges; // Dynamically allocated
+	DeterministicSpriteGroupRange *ranges; ///< The ranges as read from the GRF; freed by InitDispatch once #dispatch is built.
+	const SpriteGroup *error_group;        ///< The group of the first range, used when a variable is unavailable.
 
 	/* Dynamically allocated, this is the sole owner */
 	const SpriteGroup *default_group;
 
+	uint num_dispatch;                       ///< Number of entries in #dispatch.
+	DeterministicSpriteGroupRange *dispatch; ///< The ranges, made disjoint and sorted on their lower bound; values in none of them get the default group.
+
+	bool pure;   ///< The result only depends on the callback and its params, the GRF file and the date, and resolving has no side effects.
+	byte cost;   ///< Estimate of the number of adjusts evaluated by one resolve, including those of the groups it resolves to.
+	bool cacheable; ///< The result for a vehicle may be kept in the sprite cache of the vehicle, see SpriteGroup::IsCacheable.
+
+	void InitDispatch();
+	void InitMemo();
+	void InitCacheable();
+
+	size_t GetMemoryUsage() const;
+
 protected:
 	const SpriteGroup *Resolve(ResolverObject *object) const;
+	const SpriteGroup *ResolveChain(ResolverObject *object) const;
 };
 
 enum RandomizedSpriteGroupCompareMode {
@@ -212,6 +242,12 @@ struct RandomizedSpriteGroup : SpriteGroup {
 
 	const SpriteGroup **groups; ///< Take the group with appropriate index:
 
+	bool cacheable; ///< The result for a vehicle may be kept in the sprite cache of the vehicle, see SpriteGroup::IsCacheable.
+
+	void InitCacheable();
+
+	size_t GetMemoryUsage() const;
+
 protected:
 	const SpriteGroup *Resolve(ResolverObject *object) const;
 };
@@ -239,6 +275,7 @@ struct CallbackResultSpriteGroup : SpriteGroup {
 
 	uint16 result;
 	uint16 GetCallbackResult() const { return this->result; }
+	size_t GetMemoryUsage() const { return sizeof(*this); }
 };
 
 
@@ -262,6 +299,7 @@ struct ResultSpriteGroup : SpriteGroup {
 	byte num_sprites;
 	SpriteID GetResult() const { return this->sprite; }
 	byte GetNumResults() const { return this->num_sprites; }
+	size_t GetMemoryUsage() const { return sizeof(*this); }
 };
 
 struct TileLayoutSpriteGroup : SpriteGroup {
@@ -269,7 +307,9 @@ struct TileLayoutSpriteGroup : SpriteGroup {
 	~TileLayoutSpriteGroup();
 
 	byte num_building_stages;    ///< Number of building stages to show for this house/industry tile
-	struct DrawTileSprites *dts;
+	struct DrawTileSprites *dts; ///< The layout to draw; NULL when nothing is drawn, e.g. on a dedicated server.
+
+	size_t GetMemoryUsage() const;
 };
 
 struct IndustryProductionSpriteGroup : SpriteGroup {
@@ -279,6 +319,8 @@ struct IndustryProductionSpriteGroup : SpriteGroup {
 	int16 subtract_input[3];  // signed
 	uint16 add_output[2];     // unsigned
 	uint8 again;
+
+	size_t GetMemoryUsage() const { return sizeof(*this); }
 };
 
 
@@ -298,6 +340,7 @@ struct ResolverObject {
 	BaseStorageArray *psa;      ///< The persistent storage array of this resolved object.
 
 	const GRFFile *grffile;     ///< GRFFile the resolved SpriteGroup belongs to
+	GrfSpecFeature feature;     ///< Feature of the resolved object, for profiling
 
 	union {
 		struct {
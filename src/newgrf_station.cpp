@@ -668,6 +668,7 @@ static void NewStationResolver(ResolverObject *res, const StationSpec *statspec,
 	res->last_value      = 0;
 	res->trigger         = 0;
 	res->reseed          = 0;
+	res->feature         = GSF_STATIONS;
 	res->count           = 0;
 	res->grffile         = (statspec != NULL ? statspec->grffile : NULL);
 }
@@ -710,32 +711,78 @@ static const SpriteGroup *ResolveStation(ResolverObject *object)
 	return SpriteGroup::Resolve(group, object);
 }
 
-SpriteID GetCustomStationRelocation(const StationSpec *statspec, const BaseStation *st, TileIndex tile)
+/** Entry of the cache of the sprite relocations of station tiles. */
+struct StationRelocationCacheEntry {
+	TileIndex tile;              ///< The tile the relocation is for.
+	const StationSpec *statspec; ///< The spec of the station tile.
+	uint32 stamp;                ///< Value of #_station_relocation_stamp when the relocation was resolved.
+	SpriteID relocation;         ///< The resolved relocation.
+};
+
+/**
+ * The relocations of the sprites (first) and of the separate ground
+ * sprites (second) of the last drawn station tiles. Drawing a tile
+ * resolves them every time it is drawn, which happens for every frame and
+ * for every viewport that shows it.
+ */
+static StationRelocationCacheEntry _station_relocation_cache[2][512];
+static uint32 _station_relocation_stamp = 1; ///< Entries with another stamp are outdated.
+
+/**
+ * Forget all cached station sprite relocations. This must be called whenever
+ * the state of the game may have changed, i.e. for every tick and for every
+ * executed command, as the sprite groups of stations may depend on nearly
+ * everything about the stations and their surroundings.
+ */
+void InvalidateStationRelocationCache()
 {
+	_station_relocation_stamp++;
+}
+
+/**
+ * Get the relocation of the sprites of a station tile.
+ * @param statspec The spec of the station tile.
+ * @param st The station, or NULL when drawing a station in a GUI.
+ * @param tile The tile, or INVALID_TILE when drawing a station in a GUI.
+ * @param ground Whether to get the relocation of the separate ground sprite.
+ * @return The relocation.
+ */
+static SpriteID GetCustomStationRelocation(const StationSpec *statspec, const BaseStation *st, TileIndex tile, bool ground)
+{
+	StationRelocationCacheEntry *entry = NULL;
+	if (st != NULL) {
+		entry = &_station_relocation_cache[ground][(TileX(tile) + TileY(tile) * 37) % lengthof(_station_relocation_cache[ground])];
+		if (entry->stamp == _station_relocation_stamp && entry->tile == tile && entry->statspec == statspec) return entry->relocation;
+	}
+
 	const SpriteGroup *group;
 	ResolverObject object;
 
 	NewStationResolver(&object, statspec, st, tile);
+	if (ground) object.callback_param1 = 1; // Indicate we are resolving the ground sprite
 
 	group = ResolveStation(&object);
-	if (group == NULL || group->type != SGT_RESULT) return 0;
-	return group->GetResult() - 0x42D;
-}
+	SpriteID relocation = (group == NULL || group->type != SGT_RESULT) ? 0 : group->GetResult() - 0x42D;
 
+	if (entry != NULL) {
+		entry->tile       = tile;
+		entry->statspec   = statspec;
+		entry->stamp      = _station_relocation_stamp;
+		entry->relocation = relocation;
+	}
+	return relocation;
+}
 
-SpriteID GetCustomStationGroundRelocation(const StationSpec *statspec, const BaseStation *st, TileIndex tile)
+SpriteID GetCustomStationRelocation(const StationSpec *statspec, const BaseStation *st, TileIndex tile)
 {
-	const SpriteGroup *group;
-	ResolverObject object;
+	return GetCustomStationRelocation(statspec, st, tile, false);
+}
 
-	NewStationResolver(&object, statspec, st, tile);
-	if (HasBit(statspec->flags, SSF_SEPARATE_GROUND)) {
-		object.callback_param1 = 1; // Indicate we are resolving the ground sprite
-	}
 
-	group = ResolveStation(&object);
-	if (group == NULL || group->type != SGT_RESULT) return 0;
-	return group->GetResult() - 0x42D;
+SpriteID GetCustomStationGroundRelocation(const StationSpec *statspec, const BaseStation *st, TileIndex tile)
+{
+	/* Without a separate ground sprite the ground is resolved like the rest of the tile. */
+	return GetCustomStationRelocation(statspec, st, tile, HasBit(statspec->flags, SSF_SEPARATE_GROUND));
 }
 
 
@@ -11,23 +11,41 @@
 
 #include "stdafx.h"
 #include "newgrf_storage.h"
-#include <set>
 
-/** The changed storage arrays */
-static std::set<BaseStorageArray*> _changed_storage_arrays;
+/** The changed storage arrays, linked via BaseStorageArray::next_changed */
+static BaseStorageArray *_changed_storage_arrays = NULL;
+
+/** Remove the array from the list of changed arrays, should it still be in there */
+BaseStorageArray::~BaseStorageArray()
+{
+	if (!this->changed) return;
+
+	for (BaseStorageArray **it = &_changed_storage_arrays; *it != NULL; it = &(*it)->next_changed) {
+		if (*it == this) {
+			*it = this->next_changed;
+			break;
+		}
+	}
+}
 
 void AddChangedStorage(BaseStorageArray *storage)
 {
-	_changed_storage_arrays.insert(storage);
+	assert(!storage->changed);
+
+	storage->changed = true;
+	storage->next_changed = _changed_storage_arrays;
+	_changed_storage_arrays = storage;
 }
 
 void ClearStorageChanges(bool keep_changes)
 {
-	/* Loop over all changes arrays */
-	for (std::set<BaseStorageArray*>::iterator it = _changed_storage_arrays.begin(); it != _changed_storage_arrays.end(); it++) {
-		(*it)->ClearChanges(keep_changes);
-	}
+	/* Loop over all changes arrays and unlink them while doing so */
+	while (_changed_storage_arrays != NULL) {
+		BaseStorageArray *storage = _changed_storage_arrays;
+		_changed_storage_arrays = storage->next_changed;
 
-	/* And then clear that array */
-	_changed_storage_arrays.clear();
+		storage->ClearChanges(keep_changes);
+		storage->changed = false;
+		storage->next_changed = NULL;
+	}
 }
@@ -20,8 +20,14 @@
  */
 struct BaseStorageArray
 {
+	BaseStorageArray *next_changed; ///< The next array in the list of changed arrays.
+	bool changed;                   ///< Whether this array is in the list of changed arrays.
+
+	/** Simply construct the array */
+	BaseStorageArray() : next_changed(NULL), changed(false) {}
+
 	/** The needed destructor */
-	virtual ~BaseStorageArray() {}
+	virtual ~BaseStorageArray();
 
 	/**
 	 * Clear the changes made since the last ClearChanges.
@@ -48,21 +54,15 @@ struct BaseStorageArray
  */
 template <typename TYPE, uint SIZE>
 struct PersistentStorageArray : BaseStorageArray {
-	TYPE storage[SIZE]; ///< Memory to for the storage array
-	TYPE *prev_storage; ///< Memory to store "old" states so we can revert them on the performance of test cases for commands etc.
+	TYPE storage[SIZE];      ///< Memory to for the storage array
+	TYPE prev_storage[SIZE]; ///< Memory to store "old" states so we can revert them on the performance of test cases for commands etc. Only valid while #changed is set.
 
 	/** Simply construct the array */
-	PersistentStorageArray() : prev_storage(NULL)
+	PersistentStorageArray()
 	{
 		memset(this->storage, 0, sizeof(this->storage));
 	}
 
-	/** And free all data related to it */
-	~PersistentStorageArray()
-	{
-		free(this->prev_storage);
-	}
-
 	/**
 	 * Stores some value at a given position.
 	 * If there is no backup of the data that backup is made and then
@@ -80,8 +80,7 @@ struct PersistentStorageArray : BaseStorageArray {
 		if (this->storage[pos] == value) return;
 
 		/* We do not have made a backup; lets do so */
-		if (this->prev_storage != NULL) {
-			this->prev_storage = MallocT<TYPE>(SIZE);
+		if (!this->changed) {
 			memcpy(this->prev_storage, this->storage, sizeof(this->storage));
 
 			/* We only need to register ourselves when we made the backup
@@ -107,12 +106,9 @@ struct PersistentStorageArray : BaseStorageArray {
 
 	void ClearChanges(bool keep_changes)
 	{
-		assert(this->prev_storage != NULL);
-
 		if (!keep_changes) {
 			memcpy(this->storage, this->prev_storage, sizeof(this->storage));
 		}
-		free(this->prev_storage);
 	}
 };
 
@@ -144,7 +140,7 @@ struct TemporaryStorageArray : BaseStorageArray {
 		if (pos >= SIZE) return;
 
 		this->storage[pos] = value;
-		AddChangedStorage(this);
+		if (!this->changed) AddChangedStorage(this);
 	}
 
 	/**
@@ -171,6 +167,7 @@ struct TemporaryStorageArray : BaseStorageArray {
  * This is done so we only have to revert/save the changed
  * arrays, which saves quite a few clears, etc. after callbacks.
  * @param storage the array that has changed
+ * @pre !storage->changed
  */
 void AddChangedStorage(BaseStorageArray *storage);
 
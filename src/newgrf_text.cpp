@@ -500,6 +500,27 @@ bool CheckGrfLangID(byte lang_id, byte grf_version)
 	return (lang_id == _currentLangID || lang_id == GRFLX_UNSPECIFIED);
 }
 
+/**
+ * Get the amount of memory used by the texts of a GRF, in all languages.
+ * @param grfid The GRF to get the texts of.
+ * @param num_texts Output for the number of texts, not counting their translations.
+ * @return The number of bytes.
+ */
+size_t GetGRFTextMemoryUsage(uint32 grfid, uint *num_texts)
+{
+	size_t size = 0;
+	*num_texts = 0;
+	for (uint id = 0; id < _num_grf_texts; id++) {
+		if (_grf_text[id].grfid != grfid) continue;
+
+		(*num_texts)++;
+		for (const GRFText *text = _grf_text[id].textholder; text != NULL; text = text->next) {
+			size += sizeof(*text) + strlen(text->text) + 1;
+		}
+	}
+	return size;
+}
+
 /**
  * Delete all items of a linked GRFText list.
  * @param grftext the head of the list to delete
@@ -18,6 +18,7 @@ StringID AddGRFString(uint32 grfid, uint16 stringid, byte langid, bool new_schem
 StringID GetGRFStringID(uint32 grfid, uint16 stringid);
 const char *GetGRFStringPtr(uint16 stringid);
 void CleanUpStrings();
+size_t GetGRFTextMemoryUsage(uint32 grfid, uint *num_texts);
 void SetCurrentGrfLangID(byte language_id);
 char *TranslateTTDPatchCodes(uint32 grfid, const char *str);
 
@@ -30,6 +30,7 @@
 #include "company_func.h"
 #include "engine_gui.h"
 #include "core/geometry_func.hpp"
+#include "network/network.h"
 
 #include "table/strings.h"
 
@@ -684,7 +685,20 @@ static void MoveToNextItem()
  */
 void AddNewsItem(StringID string, NewsSubtype subtype, NewsReferenceType reftype1, uint32 ref1, NewsReferenceType reftype2, uint32 ref2, void *free_data)
 {
-	if (_game_mode == GM_MENU) return;
+	/* Nobody can read the news in the main menu or on a dedicated server, so do not even queue it there. */
+	if (_game_mode == GM_MENU || _network_dedicated) {
+		free(free_data);
+		return;
+	}
+
+	/* In the minimal presentation mode the news about competitors is not even queued. */
+	if (_settings_client.gui.minimal_presentation) {
+		NewsType type = _news_subtype_data[subtype].type;
+		if (type == NT_ARRIVAL_OTHER || type == NT_INDUSTRY_OTHER) {
+			free(free_data);
+			return;
+		}
+	}
 
 	/* Create new news item node */
 	NewsItem *ni = new NewsItem;
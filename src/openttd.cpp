@@ -17,6 +17,7 @@
 #include "video/video_driver.hpp"
 
 #include "fontcache.h"
+#include "spritecache_disk.h"
 #include "gui.h"
 #include "sound_func.h"
 #include "window_func.h"
@@ -60,10 +61,14 @@
 #include "engine_func.h"
 #include "core/random_func.hpp"
 #include "rail_gui.h"
+#include "viewport_func.h"
 #include "core/backup_type.hpp"
 #include "hotkeys.h"
+#include "tick_profiler.h"
+#include "thread/jobs.h"
 
 #include "newgrf_commons.h"
+#include "newgrf_station.h"
 
 #include "town.h"
 #include "industry.h"
@@ -171,6 +176,7 @@ static void ShowHelp()
 		"  -p password         = Password to join server\n"
 		"  -P password         = Password to join company\n"
 		"  -D [ip][:port]      = Start dedicated server\n"
+		"  -R                  = Relay the game of -n to spectators (dedicated only)\n"
 		"  -l ip[:port]        = Redirect DEBUG()\n"
 #if !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(WIN32)
 		"  -f                  = Fork into the background (dedicated only)\n"
@@ -350,6 +356,8 @@ static void ShutdownGame()
 	free(_config_file);
 #endif
 
+	SpriteDiskCacheClose();
+
 	/* Close all and any open filehandles */
 	FioCloseAll();
 }
@@ -426,6 +434,7 @@ int ttd_main(int argc, char *argv[])
 #if defined(ENABLE_NETWORK)
 	bool dedicated = false;
 	bool network   = false;
+	bool relay     = false;
 	char *network_conn = NULL;
 	char *debuglog_conn = NULL;
 	char *dedicated_host = NULL;
@@ -446,7 +455,7 @@ int ttd_main(int argc, char *argv[])
 	 *   a letter means: it accepts that param (e.g.: -h)
 	 *   a ':' behind it means: it need a param (e.g.: -m<driver>)
 	 *   a '::' behind it means: it can optional have a param (e.g.: -d<debug>) */
-	optformat = "m:s:v:b:hD::n::ei::I:S:M:t:d::r:g::G:c:xl:p:P:"
+	optformat = "m:s:v:b:hD::n::ei::I:S:M:t:d::r:g::G:c:xl:p:P:R"
 #if !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(WIN32)
 		"f"
 #endif
@@ -486,6 +495,7 @@ int ttd_main(int argc, char *argv[])
 			}
 			break;
 		case 'f': _dedicated_forks = true; break;
+		case 'R': relay = true; break;
 		case 'n':
 			network = true;
 			network_conn = mgo.opt; // optional IP parameter, NULL if unset
@@ -570,6 +580,9 @@ int ttd_main(int argc, char *argv[])
 	if (_dedicated_forks) DedicatedFork();
 #endif
 
+	/* Write the debug output from its own thread; only after forking as threads do not survive that. */
+	DebugStartWriter();
+
 	AI::Initialize();
 	LoadFromConfig();
 	AI::Uninitialize(true);
@@ -577,6 +590,8 @@ int ttd_main(int argc, char *argv[])
 	LoadFromHighScore();
 	LoadHotkeysFromConfig();
 
+	StartJobWorkers(_settings_client.gui.job_threads);
+
 	if (resolution.width != 0) { _cur_resolution = resolution; }
 	if (startyear != INVALID_YEAR) _settings_newgame.game_creation.starting_year = startyear;
 	if (generation_seed != GENERATE_NEW_SEED) _settings_newgame.game_creation.generation_seed = generation_seed;
@@ -596,6 +611,8 @@ int ttd_main(int argc, char *argv[])
 	}
 	if (dedicated_port) _settings_client.network.server_port = dedicated_port;
 	if (_dedicated_forks && !dedicated) _dedicated_forks = false;
+	/* A relay is a dedicated instance that joins a server */
+	_network_relay = relay && dedicated && network_conn != NULL;
 #endif /* ENABLE_NETWORK */
 
 	/* enumerate language files */
@@ -744,6 +761,8 @@ int ttd_main(int argc, char *argv[])
 				}
 			}
 			if (port != NULL) rport = atoi(port);
+			/* A relay can only pass on what happens in the game */
+			if (_network_relay) join_as = COMPANY_SPECTATOR;
 
 			LoadIntroGame();
 			_switch_mode = SM_NONE;
@@ -774,6 +793,9 @@ int ttd_main(int argc, char *argv[])
 	free(_ini_videodriver);
 	free(_ini_blitter);
 
+	StopJobWorkers();
+	DebugStopWriter();
+
 	return 0;
 }
 
@@ -1225,21 +1247,39 @@ void StateGameLoop()
 {
 	/* dont execute the state loop during pause */
 	if (_pause_mode != PM_UNPAUSED) {
-		CallWindowTickEvent();
+		if (!_network_catching_up) CallWindowTickEvent();
 		return;
 	}
 	if (IsGeneratingWorld()) return;
 
+	TickProfilerScope profile_loop(TPE_GAMELOOP);
+	ScheduleInvalidationsScope schedule_invalidations;
+
 	ClearStorageChanges(false);
+	InvalidateStationRelocationCache();
 
 	if (_game_mode == GM_EDITOR) {
+		TickProfilerStart(TPE_TILE_LOOP);
 		RunTileLoop();
+		TickProfilerStop(TPE_TILE_LOOP);
+
+		TickProfilerStart(TPE_VEHICLES);
 		CallVehicleTicks();
+		TickProfilerStop(TPE_VEHICLES);
+
+		TickProfilerStart(TPE_LANDSCAPE);
 		CallLandscapeTick();
+		TickProfilerStop(TPE_LANDSCAPE);
 		ClearStorageChanges(true);
+		UpdateRoadVehPathCaches();
 
-		CallWindowTickEvent();
+		TickProfilerStart(TPE_WINDOWS);
+		if (!_network_catching_up) CallWindowTickEvent();
+		TickProfilerStop(TPE_WINDOWS);
+
+		TickProfilerStart(TPE_NEWS);
 		NewsLoop();
+		TickProfilerStop(TPE_NEWS);
 	} else {
 		if (_debug_desync_level > 2 && _date_fract == 0 && (_date & 0x1F) == 0) {
 			/* Save the desync savegame if needed. */
@@ -1254,17 +1294,39 @@ void StateGameLoop()
 		 *  for multiplayer compatibility */
 		Backup<CompanyByte> cur_company(_current_company, OWNER_NONE, FILE_LINE);
 
+		TickProfilerStart(TPE_ANIMATED_TILES);
 		AnimateAnimatedTiles();
+		TickProfilerStop(TPE_ANIMATED_TILES);
+
+		TickProfilerStart(TPE_DATE);
 		IncreaseDate();
+		TickProfilerStop(TPE_DATE);
+
+		TickProfilerStart(TPE_TILE_LOOP);
 		RunTileLoop();
+		TickProfilerStop(TPE_TILE_LOOP);
+
+		TickProfilerStart(TPE_VEHICLES);
 		CallVehicleTicks();
+		TickProfilerStop(TPE_VEHICLES);
+
+		TickProfilerStart(TPE_LANDSCAPE);
 		CallLandscapeTick();
+		TickProfilerStop(TPE_LANDSCAPE);
 		ClearStorageChanges(true);
+		UpdateRoadVehPathCaches();
 
+		TickProfilerStart(TPE_AI);
 		AI::GameLoop();
+		TickProfilerStop(TPE_AI);
+
+		TickProfilerStart(TPE_WINDOWS);
+		if (!_network_catching_up) CallWindowTickEvent();
+		TickProfilerStop(TPE_WINDOWS);
 
-		CallWindowTickEvent();
+		TickProfilerStart(TPE_NEWS);
 		NewsLoop();
+		TickProfilerStop(TPE_NEWS);
 		cur_company.Restore();
 	}
 
@@ -1317,7 +1379,7 @@ void GameLoop()
 		_switch_mode = SM_NONE;
 	}
 
-	IncreaseSpriteLRU();
+	ViewportLoadDeferredSprites();
 	InteractiveRandom();
 
 	extern int _caret_timer;
@@ -1348,6 +1410,8 @@ void GameLoop()
 
 	if (!_pause_mode || _cheats.build_in_pause.value) MoveAllTextEffects();
 
+	ContinueTilesScreenshot();
+
 	InputLoop();
 
 	_sound_driver->MainLoop();
@@ -15,13 +15,14 @@
 #include "order_type.h"
 #include "core/pool_type.hpp"
 #include "core/bitmath_func.hpp"
+#include "core/smallvec_type.hpp"
 #include "cargo_type.h"
 #include "depot_type.h"
 #include "station_type.h"
 #include "vehicle_type.h"
 #include "date_type.h"
 
-typedef Pool<Order, OrderID, 256, 64000> OrderPool;
+typedef Pool<Order, OrderID, 256, 64000, false, true, true> OrderPool;
 typedef Pool<OrderList, OrderListID, 128, 64000> OrderListPool;
 extern OrderPool _order_pool;
 extern OrderListPool _orderlist_pool;
@@ -263,17 +264,27 @@ private:
 	friend const struct SaveLoad *GetOrderListDescription(); ///< Saving and loading of order lists.
 
 	Order *first;                   ///< First order of the order list
+	SmallVector<Order *, 16> order_index; ///< NOSAVE: The orders of the chain, indexed by their position in it
 	VehicleOrderID num_orders;      ///< NOSAVE: How many orders there are in the list
 	uint num_vehicles;              ///< NOSAVE: Number of vehicles that share this order list
 	Vehicle *first_shared;          ///< NOSAVE: pointer to the first vehicle in the shared order chain
 
 	Ticks timetable_duration;       ///< NOSAVE: Total duration of the order list
 
+	mutable bool timetable_cache_valid;                   ///< NOSAVE: Whether the timetable caches below are up to date
+	mutable SmallVector<Ticks, 16> timetable_offsets;     ///< NOSAVE: Per order, the timetabled duration of the orders before it
+	mutable VehicleOrderID num_untimetabled;              ///< NOSAVE: How many orders are not completely timetabled
+	mutable VehicleOrderID num_conditional;               ///< NOSAVE: How many orders are conditional
+
+	void IndexInsert(int index, Order *order);
+	void IndexRemove(int index);
+	void UpdateTimetableCache() const;
+
 public:
 	/** Default constructor producing an invalid order list. */
 	OrderList(VehicleOrderID num_orders = INVALID_VEH_ORDER_ID)
 		: first(NULL), num_orders(num_orders), num_vehicles(0), first_shared(NULL),
-		  timetable_duration(0) { }
+		  timetable_duration(0), timetable_cache_valid(false) { }
 
 	/** Create an order list with the given order chain for the given vehicle.
 	 *  @param chain pointer to the first order of the order chain
@@ -302,7 +313,11 @@ public:
 	 * @param index zero-based index of the order within the chain.
 	 * @return the order at position index.
 	 */
-	Order *GetOrderAt(int index) const;
+	inline Order *GetOrderAt(int index) const
+	{
+		if (index < 0 || (uint)index >= this->order_index.Length()) return NULL;
+		return this->order_index[index];
+	}
 
 	/**
 	 * Get the last order of the order chain.
@@ -383,7 +398,40 @@ public:
 	 * Checks whether all orders of the list have a filled timetable.
 	 * @return whether all orders have a filled timetable.
 	 */
-	bool IsCompleteTimetable() const;
+	inline bool IsCompleteTimetable() const
+	{
+		if (!this->timetable_cache_valid) this->UpdateTimetableCache();
+		return this->num_untimetabled == 0;
+	}
+
+	/**
+	 * Checks whether any of the orders of the list is conditional.
+	 * @return whether there is a conditional order.
+	 */
+	inline bool HasConditionalOrders() const
+	{
+		if (!this->timetable_cache_valid) this->UpdateTimetableCache();
+		return this->num_conditional != 0;
+	}
+
+	/**
+	 * Gets the timetabled duration of the orders before an order, i.e. when
+	 * the order starts, counted from the start of the first order.
+	 * @param index zero-based index of the order within the chain.
+	 * @return the duration of the orders before it.
+	 */
+	inline Ticks GetTimetableOffset(VehicleOrderID index) const
+	{
+		if (!this->timetable_cache_valid) this->UpdateTimetableCache();
+		assert(index < this->timetable_offsets.Length());
+		return this->timetable_offsets[index];
+	}
+
+	/**
+	 * Must be called if the type, flags or times of an order of the list
+	 * changed, so the timetable caches are updated when next needed.
+	 */
+	inline void InvalidateTimetableCache() { this->timetable_cache_valid = false; }
 
 	/**
 	 * Gets the total duration of the vehicles timetable or INVALID_TICKS is the timetable is not complete.
@@ -401,7 +449,11 @@ public:
 	 * Must be called if an order's timetable is changed to update internal book keeping.
 	 * @param delta By how many ticks has the timetable duration changed
 	 */
-	void UpdateOrderTimetable(Ticks delta) { this->timetable_duration += delta; }
+	void UpdateOrderTimetable(Ticks delta)
+	{
+		this->timetable_duration += delta;
+		this->InvalidateTimetableCache();
+	}
 
 	/**
 	 * Free a complete order chain.
@@ -175,6 +175,9 @@ Order::Order(uint32 packed)
  */
 void InvalidateVehicleOrder(const Vehicle *v, int data)
 {
+	/* Everything that changes orders comes by here. */
+	if (v->orders.list != NULL) v->orders.list->InvalidateTimetableCache();
+
 	SetWindowDirty(WC_VEHICLE_VIEW, v->index);
 
 	if (data != 0) {
@@ -215,10 +218,13 @@ void OrderList::Initialize(Order *chain, Vehicle *v)
 	this->num_orders = 0;
 	this->num_vehicles = 1;
 	this->timetable_duration = 0;
+	this->timetable_cache_valid = false;
+	this->order_index.Clear();
 
 	for (Order *o = this->first; o != NULL; o = o->next) {
 		++this->num_orders;
 		this->timetable_duration += o->wait_time + o->travel_time;
+		*this->order_index.Append() = o;
 	}
 
 	for (Vehicle *u = this->first_shared->PreviousShared(); u != NULL; u = u->PreviousShared()) {
@@ -239,29 +245,44 @@ void OrderList::FreeChain(bool keep_orderlist)
 
 	if (keep_orderlist) {
 		this->first = NULL;
+		this->order_index.Clear();
 		this->num_orders = 0;
 		this->timetable_duration = 0;
+		this->timetable_cache_valid = false;
 	} else {
 		delete this;
 	}
 }
 
-Order *OrderList::GetOrderAt(int index) const
+/**
+ * Put an order at the given position of the order index.
+ * @param index the position, at most the number of orders in the index.
+ * @param order the order to put there.
+ */
+void OrderList::IndexInsert(int index, Order *order)
 {
-	if (index < 0) return NULL;
-
-	Order *order = this->first;
-
-	while (order != NULL && index-- > 0)
-		order = order->next;
+	this->order_index.Append();
+	Order **pos = this->order_index.Get(index);
+	memmove(pos + 1, pos, (this->order_index.Length() - 1 - index) * sizeof(*pos));
+	*pos = order;
+}
 
-	return order;
+/**
+ * Remove the order at the given position from the order index.
+ * @param index the position of the order.
+ */
+void OrderList::IndexRemove(int index)
+{
+	Order **pos = this->order_index.Get(index);
+	memmove(pos, pos + 1, (this->order_index.Length() - 1 - index) * sizeof(*pos));
+	this->order_index.Erase(this->order_index.End() - 1);
 }
 
 void OrderList::InsertOrderAt(Order *new_order, int index)
 {
 	if (this->first == NULL) {
 		this->first = new_order;
+		index = 0;
 	} else {
 		if (index == 0) {
 			/* Insert as first or only order */
@@ -270,6 +291,7 @@ void OrderList::InsertOrderAt(Order *new_order, int index)
 		} else if (index >= this->num_orders) {
 			/* index is after the last order, add it to the end */
 			this->GetLastOrder()->next = new_order;
+			index = this->num_orders;
 		} else {
 			/* Put the new order in between */
 			Order *order = this->GetOrderAt(index - 1);
@@ -277,8 +299,10 @@ void OrderList::InsertOrderAt(Order *new_order, int index)
 			order->next = new_order;
 		}
 	}
+	this->IndexInsert(index, new_order);
 	++this->num_orders;
 	this->timetable_duration += new_order->wait_time + new_order->travel_time;
+	this->timetable_cache_valid = false;
 }
 
 
@@ -296,8 +320,10 @@ void OrderList::DeleteOrderAt(int index)
 		to_remove = prev->next;
 		prev->next = to_remove->next;
 	}
+	this->IndexRemove(index);
 	--this->num_orders;
 	this->timetable_duration -= (to_remove->wait_time + to_remove->travel_time);
+	this->timetable_cache_valid = false;
 	delete to_remove;
 }
 
@@ -316,6 +342,7 @@ void OrderList::MoveOrder(int from, int to)
 		moving_one = one_before->next;
 		one_before->next = moving_one->next;
 	}
+	this->IndexRemove(from);
 
 	/* Insert the moving_order again in the pointer-chain */
 	if (to == 0) {
@@ -326,6 +353,8 @@ void OrderList::MoveOrder(int from, int to)
 		moving_one->next = one_before->next;
 		one_before->next = moving_one;
 	}
+	this->IndexInsert(to, moving_one);
+	this->timetable_cache_valid = false;
 }
 
 void OrderList::RemoveVehicle(Vehicle *v)
@@ -350,12 +379,25 @@ int OrderList::GetPositionInSharedOrderList(const Vehicle *v) const
 	return count;
 }
 
-bool OrderList::IsCompleteTimetable() const
+/**
+ * Determine when each order starts in the timetable and how many orders
+ * prevent the timetable from being complete.
+ */
+void OrderList::UpdateTimetableCache() const
 {
-	for (Order *o = this->first; o != NULL; o = o->next) {
-		if (!o->IsCompletelyTimetabled()) return false;
+	this->timetable_offsets.Clear();
+	this->num_untimetabled = 0;
+	this->num_conditional = 0;
+
+	Ticks offset = 0;
+	for (const Order *o = this->first; o != NULL; o = o->next) {
+		*this->timetable_offsets.Append() = offset;
+		offset += o->wait_time + o->travel_time;
+		if (!o->IsCompletelyTimetabled()) this->num_untimetabled++;
+		if (o->IsType(OT_CONDITIONAL)) this->num_conditional++;
 	}
-	return true;
+
+	this->timetable_cache_valid = true;
 }
 
 void OrderList::DebugCheckSanity() const
@@ -367,12 +409,30 @@ void OrderList::DebugCheckSanity() const
 	DEBUG(misc, 6, "Checking OrderList %hu for sanity...", this->index);
 
 	for (const Order *o = this->first; o != NULL; o = o->next) {
+		assert(this->GetOrderAt(check_num_orders) == o);
 		++check_num_orders;
 		check_timetable_duration += o->wait_time + o->travel_time;
 	}
 	assert(this->num_orders == check_num_orders);
+	assert(this->order_index.Length() == check_num_orders);
 	assert(this->timetable_duration == check_timetable_duration);
 
+	if (this->timetable_cache_valid) {
+		Ticks check_offset = 0;
+		VehicleOrderID index = 0;
+		VehicleOrderID check_num_untimetabled = 0;
+		VehicleOrderID check_num_conditional = 0;
+		for (const Order *o = this->first; o != NULL; o = o->next, index++) {
+			assert(this->timetable_offsets[index] == check_offset);
+			check_offset += o->wait_time + o->travel_time;
+			if (!o->IsCompletelyTimetabled()) check_num_untimetabled++;
+			if (o->IsType(OT_CONDITIONAL)) check_num_conditional++;
+		}
+		assert(this->timetable_offsets.Length() == index);
+		assert(this->num_untimetabled == check_num_untimetabled);
+		assert(this->num_conditional == check_num_conditional);
+	}
+
 	for (const Vehicle *v = this->first_shared; v != NULL; v = v->NextShared()) {
 		++check_num_vehicles;
 		assert(v->orders.list == this);
@@ -74,3 +74,52 @@ uint64 ottd_rdtsc()
 # endif
 uint64 ottd_rdtsc() {return 0;}
 #endif
+
+/* The monotonic clock. Unlike the time of day it never jumps back when the
+ * clock of the computer is set, and unlike GetTickCount it does not wrap. */
+#if defined(WIN32)
+#include <windows.h>
+uint64 GetMonotonicTime()
+{
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+	/* Seconds and the rest separately, so the multiplication does not overflow. */
+	uint64 seconds = count.QuadPart / frequency.QuadPart;
+	uint64 rest = count.QuadPart % frequency.QuadPart;
+	return seconds * 1000000000 + rest * 1000000000 / frequency.QuadPart;
+}
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+uint64 GetMonotonicTime()
+{
+	static mach_timebase_info_data_t timebase = { 0, 0 };
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+	return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+#else
+#include <time.h>
+#include <sys/time.h>
+#if defined(CLOCK_MONOTONIC)
+uint64 GetMonotonicTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#else
+uint64 GetMonotonicTime()
+{
+	/* No monotonic clock here; at least never go back in time. */
+	static uint64 last = 0;
+	struct timeval tim;
+	gettimeofday(&tim, NULL);
+	uint64 now = (uint64)tim.tv_sec * 1000000000 + (uint64)tim.tv_usec * 1000;
+	if (now < last) return last;
+	last = now;
+	return now;
+}
+#endif
+#endif
@@ -27,33 +27,128 @@
 
 #include "../../stdafx.h"
 #include "../../core/alloc_func.hpp"
+#include "../../core/math_func.hpp"
 #include "aystar.h"
 
 static int _aystar_stats_open_size;
 static int _aystar_stats_closed_size;
 
+/** The number of nodes in a block is 1 << AYSTAR_NODE_BLOCK_BITS. */
+static const uint AYSTAR_NODE_BLOCK_BITS = 10;
+/** The number of children of a node in the open list heap. */
+static const uint AYSTAR_HEAP_ARITY = 4;
+/** Heap index of the nodes in the closed list. */
+static const uint AYSTAR_CLOSED = UINT_MAX;
+
+/* Gets the node with the given index */
+static FORCEINLINE OpenListNode *AyStarMain_GetNode(const AyStar *aystar, uint index)
+{
+	return &aystar->node_blocks[index >> AYSTAR_NODE_BLOCK_BITS][index & ((1 << AYSTAR_NODE_BLOCK_BITS) - 1)];
+}
+
+/* Gets the first slot in the hash to look for a node */
+static FORCEINLINE uint AyStarMain_Hash(const AyStar *aystar, TileIndex tile, Trackdir direction)
+{
+	return ((tile << 4 | direction) * 0x9E3779B1U) >> (32 - aystar->hash_bits);
+}
+
+/* Looks up a node in either list
+ *  If found, it returns the OpenListNode, else NULL */
+static OpenListNode *AyStarMain_Find(const AyStar *aystar, TileIndex tile, Trackdir direction)
+{
+	uint mask = (1 << aystar->hash_bits) - 1;
+	for (uint i = AyStarMain_Hash(aystar, tile, direction);; i = (i + 1) & mask) {
+		if (aystar->hash[i] == 0) return NULL;
+		OpenListNode *n = AyStarMain_GetNode(aystar, aystar->hash[i] - 1);
+		if (n->path.node.tile == tile && n->path.node.direction == direction) return n;
+	}
+}
+
+/* Puts the node with the given index in the hash */
+static void AyStarMain_Hash_Add(AyStar *aystar, uint index)
+{
+	const AyStarNode *node = &AyStarMain_GetNode(aystar, index)->path.node;
+	uint mask = (1 << aystar->hash_bits) - 1;
+	uint i = AyStarMain_Hash(aystar, node->tile, node->direction);
+	while (aystar->hash[i] != 0) i = (i + 1) & mask;
+	aystar->hash[i] = index + 1;
+}
+
+/* Removes all nodes from the hash, without touching the empty slots */
+static void AyStarMain_Hash_Clear(AyStar *aystar)
+{
+	uint mask = (1 << aystar->hash_bits) - 1;
+	for (uint index = 0; index < aystar->num_nodes; index++) {
+		const AyStarNode *node = &AyStarMain_GetNode(aystar, index)->path.node;
+		uint i = AyStarMain_Hash(aystar, node->tile, node->direction);
+		while (aystar->hash[i] != index + 1) i = (i + 1) & mask;
+		aystar->hash[i] = 0;
+	}
+}
+
 /* This looks in the Hash if a node exists in ClosedList
  *  If so, it returns the PathNode, else NULL */
 static PathNode *AyStarMain_ClosedList_IsInList(AyStar *aystar, const AyStarNode *node)
 {
-	return (PathNode*)Hash_Get(&aystar->ClosedListHash, node->tile, node->direction);
+	OpenListNode *n = AyStarMain_Find(aystar, node->tile, node->direction);
+	return (n != NULL && n->heap_index == AYSTAR_CLOSED) ? &n->path : NULL;
 }
 
 /* This adds a node to the ClosedList
- *  It makes a copy of the data */
-static void AyStarMain_ClosedList_Add(AyStar *aystar, const PathNode *node)
+ *  The node stays where it is, so its PathNode can be the parent of others */
+static void AyStarMain_ClosedList_Add(AyStar *aystar, OpenListNode *node)
 {
-	/* Add a node to the ClosedList */
-	PathNode *new_node = MallocT<PathNode>(1);
-	*new_node = *node;
-	Hash_Set(&aystar->ClosedListHash, node->node.tile, node->node.direction, new_node);
+	node->heap_index = AYSTAR_CLOSED;
+	aystar->num_closed++;
 }
 
 /* Checks if a node is in the OpenList
  *   If so, it returns the OpenListNode, else NULL */
 static OpenListNode *AyStarMain_OpenList_IsInList(AyStar *aystar, const AyStarNode *node)
 {
-	return (OpenListNode*)Hash_Get(&aystar->OpenListHash, node->tile, node->direction);
+	OpenListNode *n = AyStarMain_Find(aystar, node->tile, node->direction);
+	return (n != NULL && n->heap_index != AYSTAR_CLOSED) ? n : NULL;
+}
+
+/* Puts an item at the given position in the heap and updates its node */
+static FORCEINLINE void AyStarMain_Heap_Set(AyStar *aystar, uint pos, const AyStarHeapItem &item)
+{
+	aystar->heap[pos] = item;
+	AyStarMain_GetNode(aystar, item.node)->heap_index = pos;
+}
+
+/* Moves the item at the given position up the heap while it is better than its parent */
+static void AyStarMain_Heap_Up(AyStar *aystar, uint pos)
+{
+	AyStarHeapItem item = aystar->heap[pos];
+	while (pos > 0) {
+		uint parent = (pos - 1) / AYSTAR_HEAP_ARITY;
+		if (aystar->heap[parent].f <= item.f) break;
+		AyStarMain_Heap_Set(aystar, pos, aystar->heap[parent]);
+		pos = parent;
+	}
+	AyStarMain_Heap_Set(aystar, pos, item);
+}
+
+/* Moves the item at the given position down the heap while one of its children is better */
+static void AyStarMain_Heap_Down(AyStar *aystar, uint pos)
+{
+	AyStarHeapItem item = aystar->heap[pos];
+	for (;;) {
+		uint first = pos * AYSTAR_HEAP_ARITY + 1;
+		if (first >= aystar->heap_size) break;
+
+		uint last = min(first + AYSTAR_HEAP_ARITY, aystar->heap_size);
+		uint best = first;
+		for (uint child = first + 1; child < last; child++) {
+			if (aystar->heap[child].f < aystar->heap[best].f) best = child;
+		}
+		if (aystar->heap[best].f >= item.f) break;
+
+		AyStarMain_Heap_Set(aystar, pos, aystar->heap[best]);
+		pos = best;
+	}
+	AyStarMain_Heap_Set(aystar, pos, item);
 }
 
 /* Gets the best node from OpenList
@@ -61,10 +156,14 @@ static OpenListNode *AyStarMain_OpenList_IsInList(AyStar *aystar, const AyStarNo
  * Also it deletes the node from the OpenList */
 static OpenListNode *AyStarMain_OpenList_Pop(AyStar *aystar)
 {
-	/* Return the item the Queue returns.. the best next OpenList item. */
-	OpenListNode *res = (OpenListNode*)aystar->OpenListQueue.pop(&aystar->OpenListQueue);
-	if (res != NULL) {
-		Hash_Delete(&aystar->OpenListHash, res->path.node.tile, res->path.node.direction);
+	if (aystar->heap_size == 0) return NULL;
+
+	/* The best item is always on top; replace it by the last one. */
+	OpenListNode *res = AyStarMain_GetNode(aystar, aystar->heap[0].node);
+	aystar->heap_size--;
+	if (aystar->heap_size != 0) {
+		aystar->heap[0] = aystar->heap[aystar->heap_size];
+		AyStarMain_Heap_Down(aystar, 0);
 	}
 
 	return res;
@@ -74,15 +173,36 @@ static OpenListNode *AyStarMain_OpenList_Pop(AyStar *aystar)
  *  It makes a copy of node, and puts the pointer of parent in the struct */
 static void AyStarMain_OpenList_Add(AyStar *aystar, PathNode *parent, const AyStarNode *node, int f, int g)
 {
+	/* Make room for the new node, its hash slot and its heap item */
+	uint index = aystar->num_nodes;
+	if ((index >> AYSTAR_NODE_BLOCK_BITS) == aystar->num_node_blocks) {
+		aystar->node_blocks = ReallocT(aystar->node_blocks, aystar->num_node_blocks + 1);
+		aystar->node_blocks[aystar->num_node_blocks++] = MallocT<OpenListNode>(1 << AYSTAR_NODE_BLOCK_BITS);
+	}
+	if ((index + 1) * 2 > (1U << aystar->hash_bits)) {
+		/* Keep the hash at most half full; put all nodes in the twice as large hash */
+		aystar->hash_bits++;
+		free(aystar->hash);
+		aystar->hash = CallocT<uint>(1 << aystar->hash_bits);
+		for (uint i = 0; i < index; i++) AyStarMain_Hash_Add(aystar, i);
+	}
+	if (aystar->heap_size == aystar->heap_capacity) {
+		aystar->heap_capacity *= 2;
+		aystar->heap = ReallocT(aystar->heap, aystar->heap_capacity);
+	}
+
 	/* Add a new Node to the OpenList */
-	OpenListNode *new_node = MallocT<OpenListNode>(1);
+	OpenListNode *new_node = AyStarMain_GetNode(aystar, index);
 	new_node->g = g;
 	new_node->path.parent = parent;
 	new_node->path.node = *node;
-	Hash_Set(&aystar->OpenListHash, node->tile, node->direction, new_node);
+	aystar->num_nodes++;
+	AyStarMain_Hash_Add(aystar, index);
 
-	/* Add it to the queue */
-	aystar->OpenListQueue.push(&aystar->OpenListQueue, new_node, f);
+	/* Add it to the heap */
+	aystar->heap[aystar->heap_size].f = f;
+	aystar->heap[aystar->heap_size].node = index;
+	AyStarMain_Heap_Up(aystar, aystar->heap_size++);
 }
 
 /*
@@ -127,7 +247,6 @@ static int AyStarMain_CheckTile(AyStar *aystar, AyStarNode *current, OpenListNod
 		uint i;
 		/* Yes, check if this g value is lower.. */
 		if (new_g > check->g) return AYSTAR_DONE;
-		aystar->OpenListQueue.del(&aystar->OpenListQueue, check, 0);
 		/* It is lower, so change it to this item */
 		check->g = new_g;
 		check->path.parent = closedlist_parent;
@@ -135,8 +254,10 @@ static int AyStarMain_CheckTile(AyStar *aystar, AyStarNode *current, OpenListNod
 		for (i = 0; i < lengthof(current->user_data); i++) {
 			check->path.node.user_data[i] = current->user_data[i];
 		}
-		/* Readd him in the OpenListQueue */
-		aystar->OpenListQueue.push(&aystar->OpenListQueue, check, new_f);
+		/* Move him to his new place in the open list */
+		aystar->heap[check->heap_index].f = new_f;
+		AyStarMain_Heap_Up(aystar, check->heap_index);
+		AyStarMain_Heap_Down(aystar, check->heap_index);
 	} else {
 		/* A new node, add him to the OpenList */
 		AyStarMain_OpenList_Add(aystar, closedlist_parent, current, new_f, new_g);
@@ -169,12 +290,11 @@ static int AyStarMain_Loop(AyStar *aystar)
 	if (aystar->EndNodeCheck(aystar, current) == AYSTAR_FOUND_END_NODE) {
 		if (aystar->FoundEndNode != NULL)
 			aystar->FoundEndNode(aystar, current);
-		free(current);
 		return AYSTAR_FOUND_END_NODE;
 	}
 
 	/* Add the node to the ClosedList */
-	AyStarMain_ClosedList_Add(aystar, &current->path);
+	AyStarMain_ClosedList_Add(aystar, current);
 
 	/* Load the neighbours */
 	aystar->GetNeighbours(aystar, current);
@@ -185,10 +305,7 @@ static int AyStarMain_Loop(AyStar *aystar)
 		aystar->checktile(aystar, &aystar->neighbours[i], current);
 	}
 
-	/* Free the node */
-	free(current);
-
-	if (aystar->max_search_nodes != 0 && Hash_Size(&aystar->ClosedListHash) >= aystar->max_search_nodes) {
+	if (aystar->max_search_nodes != 0 && aystar->num_closed >= aystar->max_search_nodes) {
 		/* We've expanded enough nodes */
 		return AYSTAR_LIMIT_REACHED;
 	} else {
@@ -202,11 +319,10 @@ static int AyStarMain_Loop(AyStar *aystar)
  */
 static void AyStarMain_Free(AyStar *aystar)
 {
-	aystar->OpenListQueue.free(&aystar->OpenListQueue, false);
-	/* 2nd argument above is false, below is true, to free the values only
-	 * once */
-	delete_Hash(&aystar->OpenListHash, true);
-	delete_Hash(&aystar->ClosedListHash, true);
+	for (uint i = 0; i < aystar->num_node_blocks; i++) free(aystar->node_blocks[i]);
+	free(aystar->node_blocks);
+	free(aystar->hash);
+	free(aystar->heap);
 #ifdef AYSTAR_DEBUG
 	printf("[AyStar] Memory free'd\n");
 #endif
@@ -218,12 +334,11 @@ static void AyStarMain_Free(AyStar *aystar)
  */
 void AyStarMain_Clear(AyStar *aystar)
 {
-	/* Clean the Queue, but not the elements within. That will be done by
-	 * the hash. */
-	aystar->OpenListQueue.clear(&aystar->OpenListQueue, false);
-	/* Clean the hashes */
-	clear_Hash(&aystar->OpenListHash, true);
-	clear_Hash(&aystar->ClosedListHash, true);
+	/* Empty the lists, but keep their memory for the next search */
+	AyStarMain_Hash_Clear(aystar);
+	aystar->num_nodes = 0;
+	aystar->num_closed = 0;
+	aystar->heap_size = 0;
 
 #ifdef AYSTAR_DEBUG
 	printf("[AyStar] Cleared AyStar\n");
@@ -256,8 +371,8 @@ int AyStarMain_Main(AyStar *aystar)
 #endif
 	if (r != AYSTAR_STILL_BUSY) {
 		/* We're done, clean up */
-		_aystar_stats_open_size = aystar->OpenListHash.size;
-		_aystar_stats_closed_size = aystar->ClosedListHash.size;
+		_aystar_stats_open_size = aystar->heap_size;
+		_aystar_stats_closed_size = aystar->num_closed;
 		aystar->clear(aystar);
 	}
 
@@ -285,17 +400,18 @@ static void AyStarMain_AddStartNode(AyStar *aystar, AyStarNode *start_node, uint
 	AyStarMain_OpenList_Add(aystar, NULL, start_node, 0, g);
 }
 
-void init_AyStar(AyStar *aystar, Hash_HashProc hash, uint num_buckets)
+void init_AyStar(AyStar *aystar, uint hash_bits)
 {
-	/* Allocated the Hash for the OpenList and ClosedList */
-	init_Hash(&aystar->OpenListHash, hash, num_buckets);
-	init_Hash(&aystar->ClosedListHash, hash, num_buckets);
-
-	/* Set up our sorting queue
-	 *  BinaryHeap allocates a block of 1024 nodes
-	 *  When that one gets full it reserves another one, till this number
-	 *  That is why it can stay this high */
-	init_BinaryHeap(&aystar->OpenListQueue, 102400);
+	/* The lists start small and grow to the size the searches need */
+	aystar->node_blocks = NULL;
+	aystar->num_node_blocks = 0;
+	aystar->num_nodes = 0;
+	aystar->num_closed = 0;
+	aystar->hash_bits = hash_bits;
+	aystar->hash = CallocT<uint>(1 << hash_bits);
+	aystar->heap_capacity = 1 << AYSTAR_NODE_BLOCK_BITS;
+	aystar->heap = MallocT<AyStarHeapItem>(aystar->heap_capacity);
+	aystar->heap_size = 0;
 
 	aystar->addstart  = AyStarMain_AddStartNode;
 	aystar->main      = AyStarMain_Main;
@@ -18,7 +18,6 @@
 #ifndef AYSTAR_H
 #define AYSTAR_H
 
-#include "queue.h"
 #include "../../tile_type.h"
 #include "../../track_type.h"
 
@@ -53,6 +52,13 @@ struct PathNode {
 struct OpenListNode {
 	int g;
 	PathNode path;
+	uint heap_index; ///< Position in the open list heap, or AYSTAR_CLOSED when the node is in the closed list.
+};
+
+/* For internal use only; an item of the open list heap. */
+struct AyStarHeapItem {
+	int f;      ///< The f-value the open list is sorted on.
+	uint node;  ///< The index of the node in AyStar::node_blocks.
 };
 
 struct AyStar;
@@ -155,15 +161,24 @@ struct AyStar {
 	AyStar_Clear *clear;
 	AyStar_CheckTile *checktile;
 
-	/* These will contain the open and closed lists */
-
-	/* The actual closed list */
-	Hash ClosedListHash;
-	/* The open queue */
-	Queue OpenListQueue;
-	/* An extra hash to speed up the process of looking up an element in
-	 * the open list */
-	Hash OpenListHash;
+	/* These will contain the open and closed lists. All nodes are kept
+	 * in blocks that are reused for the next search, so no memory has to
+	 * be allocated during a search once it has grown to its usual size. */
+
+	/* The nodes of both lists, in blocks of 1 << AYSTAR_NODE_BLOCK_BITS nodes */
+	OpenListNode **node_blocks;
+	uint num_node_blocks;
+	uint num_nodes;
+	/* The number of nodes in the closed list */
+	uint num_closed;
+	/* Open addressed hash of all nodes by tile and direction; it contains
+	 * node index + 1, or 0 for an empty slot */
+	uint *hash;
+	uint hash_bits;
+	/* The open list, a d-ary heap on the f-value */
+	AyStarHeapItem *heap;
+	uint heap_size;
+	uint heap_capacity;
 };
 
 
@@ -172,8 +187,9 @@ void AyStarMain_Clear(AyStar *aystar);
 
 /* Initialize an AyStar. You should fill all appropriate fields before
  * callling init_AyStar (see the declaration of AyStar for which fields are
- * internal */
-void init_AyStar(AyStar *aystar, Hash_HashProc hash, uint num_buckets);
+ * internal). hash_bits is the log2 of the initial size of the hash; it
+ * grows when needed. */
+void init_AyStar(AyStar *aystar, uint hash_bits);
 
 
 #endif /* AYSTAR_H */
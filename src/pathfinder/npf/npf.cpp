@@ -21,11 +21,7 @@
 #include "../follow_track.hpp"
 #include "aystar.h"
 
-static const uint NPF_HASH_BITS = 12; ///< The size of the hash used in pathfinding. Just changing this value should be sufficient to change the hash size. Should be an even value.
-/* Do no change below values */
-static const uint NPF_HASH_SIZE = 1 << NPF_HASH_BITS;
-static const uint NPF_HASH_HALFBITS = NPF_HASH_BITS / 2;
-static const uint NPF_HASH_HALFMASK = (1 << NPF_HASH_HALFBITS) - 1;
+static const uint NPF_HASH_BITS = 12; ///< The log2 of the initial size of the hash used in pathfinding; it grows when needed.
 
 /** Meant to be stored in AyStar.targetdata */
 struct NPFFindStationOrTileData {
@@ -133,24 +129,6 @@ static uint NTPHash(uint key1, uint key2)
 }
 #endif
 
-/**
- * Calculates a hash value for use in the NPF.
- * @param key1 The TileIndex of the tile to hash
- * @param key2 The Trackdir of the track on the tile.
- *
- * @todo Think of a better hash.
- */
-static uint NPFHash(uint key1, uint key2)
-{
-	/* TODO: think of a better hash? */
-	uint part1 = TileX(key1) & NPF_HASH_HALFMASK;
-	uint part2 = TileY(key1) & NPF_HASH_HALFMASK;
-
-	assert(IsValidTrackdir((Trackdir)key2));
-	assert(IsValidTile(key1));
-	return ((part1 << NPF_HASH_HALFBITS | part2) + (NPF_HASH_SIZE * key2 / TRACKDIR_END)) % NPF_HASH_SIZE;
-}
-
 static int32 NPFCalcZero(AyStar *as, AyStarNode *current, OpenListNode *parent)
 {
 	return 0;
@@ -1083,7 +1061,7 @@ void InitializeNPF()
 	static bool first_init = true;
 	if (first_init) {
 		first_init = false;
-		init_AyStar(&_npf_aystar, NPFHash, NPF_HASH_SIZE);
+		init_AyStar(&_npf_aystar, NPF_HASH_BITS);
 	} else {
 		AyStarMain_Clear(&_npf_aystar);
 	}
@@ -40,6 +40,9 @@ static const int YAPF_TILE_CORNER_LENGTH = 71;
  */
 static const int YAPF_INFINITE_PENALTY = 1000 * YAPF_TILE_LENGTH;
 
+/** Distance in tiles from the destination station within which road vehicles don't remember their path. */
+static const uint YAPF_ROADVEH_PATH_CACHE_DESTINATION_LIMIT = 8;
+
 /**
  * Helper container to find a depot
  */
@@ -0,0 +1,231 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pf_recorder.cpp Recording pathfinder queries and replaying them to measure the pathfinders. */
+
+#include "../stdafx.h"
+#include "../fileio_func.h"
+#include "../console_func.h"
+#include "../train.h"
+#include "../roadveh.h"
+#include "../ship.h"
+#include "../core/smallvec_type.hpp"
+#include "../core/sort_func.hpp"
+#include "pf_recorder.h"
+#include "pf_performance_timer.hpp"
+#include "npf/npf_func.h"
+#include "opf/opf_ship.h"
+#include "yapf/yapf.h"
+
+FILE *_pf_record_file = NULL; ///< The file the pathfinder queries are recorded to, or NULL when not recording.
+
+/** The pathfinders a recorded query is measured with. */
+enum ReplayPathfinder {
+	RPF_RECORDED, ///< The measurement made while recording
+	RPF_YAPF,     ///< Replayed with YAPF
+	RPF_NPF,      ///< Replayed with NPF
+	RPF_OPF,      ///< Replayed with OPF
+	RPF_END,      ///< End marker
+};
+
+/** Names of the pathfinders, as shown in the console. */
+static const char * const _replay_pathfinder_names[] = { "recorded", "yapf", "npf", "opf" };
+assert_compile(lengthof(_replay_pathfinder_names) == RPF_END);
+
+/** Names of the query types, as shown in the console. */
+static const char * const _query_type_names[] = { "train", "road vehicle", "ship" };
+assert_compile(lengthof(_query_type_names) == PFQ_END);
+
+/** The vehicle type of each query type. */
+static const VehicleType _query_vehicle_types[] = { VEH_TRAIN, VEH_ROAD, VEH_SHIP };
+assert_compile(lengthof(_query_vehicle_types) == PFQ_END);
+
+/** The measurements of the queries of one type with one pathfinder. */
+struct ReplayStatistics {
+	SmallVector<uint64, 256> cycles; ///< The time every query took, in rdtsc cycles.
+	uint same_result;                ///< The number of queries with the same result as recorded.
+};
+
+/**
+ * Start recording all pathfinder queries to a file.
+ * @param filename the file to write to, in the autosave directory
+ * @return false if the file can't be opened
+ */
+bool StartRecordingPathfinderQueries(const char *filename)
+{
+	StopRecordingPathfinderQueries();
+	_pf_record_file = FioFOpenFile(filename, "w", AUTOSAVE_DIR);
+	return _pf_record_file != NULL;
+}
+
+/** Stop recording the pathfinder queries and close the file. */
+void StopRecordingPathfinderQueries()
+{
+	if (_pf_record_file == NULL) return;
+	FioFCloseFile(_pf_record_file);
+	_pf_record_file = NULL;
+}
+
+/**
+ * Write a pathfinder query to the record file.
+ * @param type     the kind of query
+ * @param v        the vehicle the path is searched for
+ * @param tile     the tile the vehicle is about to enter
+ * @param enterdir the direction the vehicle enters the tile in
+ * @param choices  the tracks or trackdirs to choose from
+ * @param result   the chosen track or trackdir
+ * @param cycles   the time the query took, in rdtsc cycles
+ */
+void RecordPathfinderQuery(PathfinderQueryType type, const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint choices, uint result, uint64 cycles)
+{
+	fprintf(_pf_record_file, "%u %u %u %u %u %u %u %u\n", type, v->index, tile, enterdir, choices, v->dest_tile, result, (uint)min<uint64>(cycles, UINT_MAX));
+}
+
+/**
+ * Can a recorded query be asked again for the vehicle in its current state?
+ * @param type     the kind of query
+ * @param v        the vehicle of the query, if it still exists
+ * @param enterdir the direction the vehicle entered the tile in
+ * @return true if the pathfinders can answer the query
+ */
+static bool CanReplayQuery(PathfinderQueryType type, const Vehicle *v, DiagDirection enterdir)
+{
+	if (v == NULL || v->type != _query_vehicle_types[type] || !v->IsPrimaryVehicle() || (v->vehstatus & VS_CRASHED)) return false;
+
+	/* The ship pathfinders search from the tile the ship is on, so it must still drive towards the tile. */
+	return type != PFQ_SHIP || TrackdirToExitdir(Ship::From(v)->GetVehicleTrackdir()) == enterdir;
+}
+
+/**
+ * Ask a recorded query again.
+ * @param pf       the pathfinder to use
+ * @param type     the kind of query
+ * @param v        the vehicle of the query
+ * @param tile     the tile the vehicle is about to enter
+ * @param enterdir the direction the vehicle enters the tile in
+ * @param choices  the tracks or trackdirs to choose from
+ * @return the chosen track or trackdir, or UINT_MAX when the pathfinder doesn't handle this kind of query
+ */
+static uint ReplayQuery(ReplayPathfinder pf, PathfinderQueryType type, const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint choices)
+{
+	switch (type) {
+		case PFQ_TRAIN: {
+			bool path_not_found;
+			switch (pf) {
+				case RPF_YAPF: return YapfTrainChooseTrack(Train::From(v), tile, enterdir, (TrackBits)choices, &path_not_found, false, NULL);
+				case RPF_NPF:  return NPFTrainChooseTrack(Train::From(v), tile, enterdir, (TrackBits)choices, &path_not_found, false, NULL);
+				default: return UINT_MAX;
+			}
+		}
+
+		case PFQ_ROADVEH: {
+			/* The path cache of the vehicle is part of the game state; don't touch it. */
+			RoadVehPathCache path_cache;
+			switch (pf) {
+				case RPF_YAPF: return YapfRoadVehicleChooseTrack(RoadVehicle::From(v), tile, enterdir, (TrackdirBits)choices, path_cache);
+				case RPF_NPF:  return NPFRoadVehicleChooseTrack(RoadVehicle::From(v), tile, enterdir, (TrackdirBits)choices);
+				default: return UINT_MAX;
+			}
+		}
+
+		case PFQ_SHIP:
+			switch (pf) {
+				case RPF_YAPF: return YapfShipChooseTrack(Ship::From(v), tile, enterdir, (TrackBits)choices);
+				case RPF_NPF:  return NPFShipChooseTrack(Ship::From(v), tile, enterdir, (TrackBits)choices);
+				case RPF_OPF:  return OPFShipChooseTrack(Ship::From(v), tile, enterdir, (TrackBits)choices);
+				default: return UINT_MAX;
+			}
+
+		default: NOT_REACHED();
+	}
+}
+
+/** Order the measurements from fast to slow. */
+static int CDECL CycleSorter(const uint64 *a, const uint64 *b)
+{
+	return (*a < *b) ? -1 : (*a > *b) ? 1 : 0;
+}
+
+/**
+ * Print the latency distribution of one pathfinder for one kind of query.
+ * @param type  the kind of query
+ * @param pf    the pathfinder
+ * @param stats the measurements
+ */
+static void PrintReplayStatistics(PathfinderQueryType type, ReplayPathfinder pf, ReplayStatistics *stats)
+{
+	uint num = stats->cycles.Length();
+	if (num == 0) return;
+
+	QSortT(stats->cycles.Begin(), num, &CycleSorter);
+	const uint64 *c = stats->cycles.Begin();
+	uint64 sum = 0;
+	for (uint i = 0; i < num; i++) sum += c[i];
+
+	IConsolePrintF(CC_DEFAULT, "  %-12s %-8s %7u %9u %9u %9u %9u %9u %5u%%",
+			_query_type_names[type], _replay_pathfinder_names[pf], num, (uint)(sum / num / 1000),
+			(uint)(c[num / 2] / 1000), (uint)(c[num * 9 / 10] / 1000), (uint)(c[num * 99 / 100] / 1000), (uint)(c[num - 1] / 1000),
+			stats->same_result * 100 / num);
+}
+
+/**
+ * Run all queries of a record file again with every pathfinder that can
+ * answer them, and print how long they took. The queries are asked for the
+ * vehicles as they are in the current game, so the game should be the one
+ * the queries were recorded in. The game state is not changed.
+ * @param filename the file to read, in the autosave directory
+ * @return false if the file can't be opened
+ */
+bool ReplayPathfinderQueries(const char *filename)
+{
+	FILE *f = FioFOpenFile(filename, "r", AUTOSAVE_DIR);
+	if (f == NULL) return false;
+
+	ReplayStatistics stats[PFQ_END][RPF_END];
+	for (uint type = 0; type < PFQ_END; type++) {
+		for (uint pf = 0; pf < RPF_END; pf++) stats[type][pf].same_result = 0;
+	}
+	uint skipped = 0;
+
+	uint type, vehicle, tile, enterdir, choices, dest_tile, result, cycles;
+	while (fscanf(f, "%u %u %u %u %u %u %u %u", &type, &vehicle, &tile, &enterdir, &choices, &dest_tile, &result, &cycles) == 8) {
+		Vehicle *v = Vehicle::GetIfValid(vehicle);
+		if (type >= PFQ_END || tile >= MapSize() || dest_tile >= MapSize() || enterdir >= DIAGDIR_END ||
+				!CanReplayQuery((PathfinderQueryType)type, v, (DiagDirection)enterdir)) {
+			skipped++;
+			continue;
+		}
+
+		*stats[type][RPF_RECORDED].cycles.Append() = cycles;
+		stats[type][RPF_RECORDED].same_result++;
+
+		/* Ask for the destination of the query; restore the vehicle afterwards. */
+		TileIndex old_dest_tile = v->dest_tile;
+		v->dest_tile = dest_tile;
+		for (ReplayPathfinder pf = RPF_YAPF; pf < RPF_END; pf = (ReplayPathfinder)(pf + 1)) {
+			CPerformanceTimer timer;
+			timer.Start();
+			uint res = ReplayQuery(pf, (PathfinderQueryType)type, v, tile, (DiagDirection)enterdir, choices);
+			timer.Stop();
+			if (res == UINT_MAX) continue;
+
+			*stats[type][pf].cycles.Append() = timer.m_acc;
+			if (res == result) stats[type][pf].same_result++;
+		}
+		v->dest_tile = old_dest_tile;
+	}
+	FioFCloseFile(f);
+
+	IConsolePrintF(CC_DEFAULT, "Pathfinder query timings in kilocycles; %u queries skipped as their vehicle is gone or was elsewhere:", skipped);
+	IConsolePrintF(CC_DEFAULT, "  %-12s %-8s %7s %9s %9s %9s %9s %9s %6s", "query", "pf", "queries", "average", "median", "90%", "99%", "max", "same");
+	for (uint type = 0; type < PFQ_END; type++) {
+		for (uint pf = 0; pf < RPF_END; pf++) PrintReplayStatistics((PathfinderQueryType)type, (ReplayPathfinder)pf, &stats[type][pf]);
+	}
+	return true;
+}
@@ -0,0 +1,43 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pf_recorder.h Recording pathfinder queries and replaying them to measure the pathfinders. */
+
+#ifndef PF_RECORDER_H
+#define PF_RECORDER_H
+
+#include "../direction_type.h"
+#include "../tile_type.h"
+#include "../vehicle_type.h"
+
+/** The kinds of pathfinder queries that are recorded. */
+enum PathfinderQueryType {
+	PFQ_TRAIN,   ///< Choosing the track of a train
+	PFQ_ROADVEH, ///< Choosing the trackdir of a road vehicle
+	PFQ_SHIP,    ///< Choosing the track of a ship
+	PFQ_END,     ///< End marker
+};
+
+extern FILE *_pf_record_file;
+
+/**
+ * Are the pathfinder queries being recorded?
+ * @return true if every query must be passed to #RecordPathfinderQuery
+ */
+static inline bool IsRecordingPathfinderQueries()
+{
+	return _pf_record_file != NULL;
+}
+
+bool StartRecordingPathfinderQueries(const char *filename);
+void StopRecordingPathfinderQueries();
+void RecordPathfinderQuery(PathfinderQueryType type, const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint choices, uint result, uint64 cycles);
+bool ReplayPathfinderQueries(const char *filename);
+
+#endif /* PF_RECORDER_H */
@@ -59,6 +59,53 @@ public:
 	{
 	}
 
+	/** remove all nodes, but keep the memory for the next search */
+	void Reset()
+	{
+		m_open.ClearItems(m_arr);
+		m_closed.ClearItems(m_arr);
+		m_open_queue.Clear();
+		m_arr.Reset();
+		m_new_node = NULL;
+	}
+
+	/** get a node list for a new search, reusing the one of an earlier search when possible */
+	static CNodeList_HashTableT *Acquire()
+	{
+		CNodeList_HashTableT *list = Spare().list;
+		if (list == NULL) return new CNodeList_HashTableT();
+		Spare().list = NULL;
+		return list;
+	}
+
+	/** give back a node list of a finished search, so the next search can reuse its memory */
+	static void Release(CNodeList_HashTableT *list)
+	{
+		if (Spare().list != NULL) {
+			delete list;
+			return;
+		}
+		list->Reset();
+		Spare().list = list;
+	}
+
+protected:
+	/** holder of the node list that is kept for the next search */
+	struct CSpare {
+		CNodeList_HashTableT *list;
+		CSpare() : list(NULL) {}
+		~CSpare() {delete list;}
+	};
+
+	/** the node list that is kept for the next search */
+	static CSpare& Spare()
+	{
+		static CSpare spare;
+		return spare;
+	}
+
+public:
+
 	/** return number of open nodes */
 	FORCEINLINE int OpenCount()
 	{
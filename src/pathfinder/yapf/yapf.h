@@ -18,6 +18,8 @@
 #include "../../vehicle_type.h"
 #include "../pathfinder_type.h"
 
+struct RoadVehPathCache;
+
 /**
  * Finds the best path for given ship using YAPF.
  * @param v        the ship that needs to find a path
@@ -28,15 +30,24 @@
  */
 Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks);
 
+/**
+ * Might a ship be able to get from a tile to its destination over water?
+ * @param tile the tile the ship is at or about to enter
+ * @param dest the destination of the ship
+ * @return false if the destination can certainly not be reached
+ */
+bool YapfShipMayReachTile(TileIndex tile, TileIndex dest);
+
 /**
  * Finds the best path for given road vehicle using YAPF.
  * @param v         the RV that needs to find a path
  * @param tile      the tile to find the path from (should be next tile the RV is about to enter)
  * @param enterdir  diagonal direction which the RV will enter this new tile from
  * @param trackdirs available trackdirs on the new tile (to choose from)
+ * @param path_cache is filled with the choices at the next junctions of the found path
  * @return          the best trackdir for next turn or INVALID_TRACKDIR if the path could not be found
  */
-Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs);
+Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, RoadVehPathCache &path_cache);
 
 /**
  * Finds the best path for given train using YAPF.
@@ -57,7 +57,7 @@ public:
 	typedef typename Node::Key Key;            ///< key to hash tables
 
 
-	NodeList             m_nodes;              ///< node list multi-container
+	NodeList            &m_nodes;              ///< node list multi-container, reused by the next search
 protected:
 	Node                *m_pBestDestNode;      ///< pointer to the destination node found at last round
 	Node                *m_pBestIntermediateNode; ///< here should be node closest to the destination if path not found
@@ -80,7 +80,8 @@ public:
 public:
 	/** default constructor */
 	FORCEINLINE CYapfBaseT()
-		: m_pBestDestNode(NULL)
+		: m_nodes(*NodeList::Acquire())
+		, m_pBestDestNode(NULL)
 		, m_pBestIntermediateNode(NULL)
 		, m_settings(&_settings_game.pf.yapf)
 		, m_max_search_nodes(PfGetSettings().max_search_nodes)
@@ -92,7 +93,10 @@ public:
 	}
 
 	/** default destructor */
-	~CYapfBaseT() {}
+	~CYapfBaseT()
+	{
+		NodeList::Release(&m_nodes);
+	}
 
 protected:
 	/** to access inherited path finder */
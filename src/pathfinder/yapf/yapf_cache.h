@@ -21,4 +21,16 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/**
+ * Use this function to notify YAPF that a pathfinder setting has changed, so
+ * nothing that was found with the old settings is used anymore.
+ */
+void YapfNotifySettingsChange();
+
+/**
+ * Use this function to notify YAPF that the water tracks of a tile might have changed.
+ * @param tile the tile that is changed, or INVALID_TILE when the whole map changed
+ */
+void YapfNotifyWaterLayoutChange(TileIndex tile);
+
 #endif /* YAPF_CACHE_H */
@@ -83,16 +83,23 @@ public:
 
 
 /** Base class for segment cost cache providers. Contains global counter
- *  of track layout changes and static notification function called whenever
- *  the track layout changes. It is implemented as base class because it needs
- *  to be shared between all rail YAPF types (one shared counter, one notification
- *  function. */
+ *  of track layout changes, the log of the last changed tiles and static
+ *  notification function called whenever the track layout changes. It is
+ *  implemented as base class because it needs to be shared between all rail
+ *  YAPF types (one shared counter, one notification function. */
 struct CSegmentCostCacheBase
 {
-	static int   s_rail_change_counter;
+	/** Number of changed tiles remembered; caches that missed more changes are flushed completely. */
+	static const int C_CHANGE_LOG_SIZE = 64;
+
+	static int       s_rail_change_counter;
+	static TileIndex s_changed_tiles[C_CHANGE_LOG_SIZE]; ///< the last changed tiles, INVALID_TILE when everything changed
+	static uint      s_cache_hits;                       ///< number of segments found in the global caches
+	static uint      s_cache_misses;                     ///< number of segments not found in the global caches
 
 	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
 	{
+		s_changed_tiles[s_rail_change_counter % C_CHANGE_LOG_SIZE] = tile;
 		s_rail_change_counter++;
 	}
 };
@@ -118,14 +125,57 @@ struct CSegmentCostCacheT
 
 	HashTable    m_map;
 	Heap         m_heap;
+	uint         m_num_invalid; ///< number of invalidated segments still taking space in the heap
 
-	FORCEINLINE CSegmentCostCacheT() {}
+	FORCEINLINE CSegmentCostCacheT() : m_num_invalid(0) {}
 
 	/** flush (clear) the cache */
 	FORCEINLINE void Flush()
 	{
 		m_map.Clear();
 		m_heap.Clear();
+		m_num_invalid = 0;
+	}
+
+	/**
+	 * Remove the segments that are affected by the given track layout changes.
+	 * @param first the change counter of the first change to apply
+	 * @param last  the change counter after the last change to apply
+	 */
+	void Invalidate(int first, int last)
+	{
+		if (last - first > C_CHANGE_LOG_SIZE) {
+			Flush();
+			return;
+		}
+
+		TileIndex tiles[C_CHANGE_LOG_SIZE];
+		int num_tiles = 0;
+		for (int i = first; i != last; i++) {
+			TileIndex tile = s_changed_tiles[i % C_CHANGE_LOG_SIZE];
+			if (tile == INVALID_TILE) {
+				Flush();
+				return;
+			}
+			tiles[num_tiles++] = tile;
+		}
+
+		uint num_items = m_heap.Length();
+		for (uint i = 0; i < num_items; i++) {
+			Tsegment& item = m_heap[i];
+			for (int j = 0; j < num_tiles; j++) {
+				if (!item.IsAffectedBy(tiles[j])) continue;
+
+				/* The space in the heap can't be reused, so only forget it. */
+				m_map.Pop(item);
+				item.Invalidate();
+				m_num_invalid++;
+				break;
+			}
+		}
+
+		/* Get rid of the invalidated segments when they take most of the heap. */
+		if (m_num_invalid > num_items / 2) Flush();
 	}
 
 	FORCEINLINE Tsegment& Get(Key& key, bool *found)
@@ -179,14 +229,16 @@ protected:
 		/* some statistics */
 		if (last_date != _date) {
 			last_date = _date;
-			DEBUG(yapf, 2, "Pf time today: %5d ms", _total_pf_time_us / 1000);
+			DEBUG(yapf, 2, "Pf time today: %5d ms, segment cache hits: %u, misses: %u", _total_pf_time_us / 1000, Cache::s_cache_hits, Cache::s_cache_misses);
 			_total_pf_time_us = 0;
+			Cache::s_cache_hits = 0;
+			Cache::s_cache_misses = 0;
 		}
 
-		/* delete the cache sometimes... */
+		/* forget the segments on the changed tiles */
 		if (last_rail_change_counter != Cache::s_rail_change_counter) {
+			C.Invalidate(last_rail_change_counter, Cache::s_rail_change_counter);
 			last_rail_change_counter = Cache::s_rail_change_counter;
-			C.Flush();
 		}
 		return C;
 	}
@@ -202,6 +254,11 @@ public:
 		CacheKey key(n.GetKey());
 		bool found;
 		CachedData& item = m_global_cache.Get(key, &found);
+		if (found) {
+			Cache::s_cache_hits++;
+		} else {
+			Cache::s_cache_misses++;
+		}
 		Yapf().ConnectNodeToCachedData(n, item);
 		return found;
 	}
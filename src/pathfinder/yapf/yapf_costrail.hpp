@@ -384,6 +384,9 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			/* Remember the tiles the segment cost depends on. */
+			segment.AddTile(cur.tile);
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -506,6 +509,7 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 
 			/* Gather the next tile/trackdir/tile_type/rail_type. */
 			TILE next(tf_local.m_new_tile, (Trackdir)FindFirstBit2x64(tf_local.m_new_td_bits));
+			segment.AddTile(next.tile);
 
 			if (TrackFollower::DoTrackMasking() && IsTileType(next.tile, MP_RAILWAY)) {
 				if ((HasSignalOnTrackdir(next.tile, next.td) && IsPbsSignal(GetSignalType(next.tile, TrackdirToTrack(next.td)))) ||
@@ -12,6 +12,8 @@
 #ifndef  YAPF_DESTRAIL_HPP
 #define  YAPF_DESTRAIL_HPP
 
+#include "yapf_region.hpp"
+
 class CYapfDestinationRailBase
 {
 protected:
@@ -166,6 +168,21 @@ public:
 		return PfDetectDestination(n.GetLastTile(), n.GetLastTrackdir());
 	}
 
+	/**
+	 * Might the destination be reached from the given tile at all?
+	 * @param tile the tile to start at
+	 * @return false if there is certainly no route to the destination
+	 */
+	FORCEINLINE bool MayReachDestination(TileIndex tile)
+	{
+		if (m_dest_station_id != INVALID_STATION) {
+			const TileArea &area = BaseStation::Get(m_dest_station_id)->train_station;
+			return area.tile == INVALID_TILE || _yapf_rail_regions.MayBeConnected(tile, area);
+		}
+		if (m_destTrackdirs == TRACKDIR_BIT_NONE) return true;
+		return _yapf_rail_regions.MayBeConnected(tile, TileArea(m_destTile, 1, 1));
+	}
+
 	/** Called by YAPF to detect if node ends in the desired destination */
 	FORCEINLINE bool PfDetectDestination(TileIndex tile, Trackdir td)
 	{
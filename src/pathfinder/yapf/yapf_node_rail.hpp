@@ -143,6 +143,10 @@ struct CYapfRailSegment
 	Trackdir               m_last_signal_td;
 	EndSegmentReasonBits   m_end_segment_reason;
 	CYapfRailSegment      *m_hash_next;
+	uint16                 m_min_x;  ///< lowest x of the tiles the segment cost depends on
+	uint16                 m_min_y;  ///< lowest y of the tiles the segment cost depends on
+	uint16                 m_max_x;  ///< highest x of the tiles the segment cost depends on
+	uint16                 m_max_y;  ///< highest y of the tiles the segment cost depends on
 
 	FORCEINLINE CYapfRailSegment(const CYapfRailSegmentKey& key)
 		: m_key(key)
@@ -153,8 +157,40 @@ struct CYapfRailSegment
 		, m_last_signal_td(INVALID_TRACKDIR)
 		, m_end_segment_reason(ESRB_NONE)
 		, m_hash_next(NULL)
+		, m_min_x(UINT16_MAX)
+		, m_min_y(UINT16_MAX)
+		, m_max_x(0)
+		, m_max_y(0)
 	{}
 
+	/** Add a tile to the area the segment cost depends on. */
+	FORCEINLINE void AddTile(TileIndex tile)
+	{
+		m_min_x = min<uint>(m_min_x, TileX(tile));
+		m_min_y = min<uint>(m_min_y, TileY(tile));
+		m_max_x = max<uint>(m_max_x, TileX(tile));
+		m_max_y = max<uint>(m_max_y, TileY(tile));
+	}
+
+	/**
+	 * Does a change of the given tile affect the segment? The tiles next to
+	 * the segment count too, as they decide whether the segment ends there.
+	 */
+	FORCEINLINE bool IsAffectedBy(TileIndex tile) const
+	{
+		uint x = TileX(tile);
+		uint y = TileY(tile);
+		return x + 1 >= m_min_x && x <= m_max_x + 1U && y + 1 >= m_min_y && y <= m_max_y + 1U;
+	}
+
+	/** Forget the cached cost; by the cache when the segment has been removed from it. */
+	FORCEINLINE void Invalidate()
+	{
+		m_cost = -1;
+		m_min_x = m_min_y = UINT16_MAX;
+		m_max_x = m_max_y = 0;
+	}
+
 	FORCEINLINE const Key& GetKey() const
 	{
 		return m_key;
@@ -184,6 +220,7 @@ struct CYapfRailSegment
 		dmp.WriteTile("m_last_signal_tile", m_last_signal_tile);
 		dmp.WriteEnumT("m_last_signal_td", m_last_signal_td);
 		dmp.WriteEnumT("m_end_segment_reason", m_end_segment_reason);
+		dmp.WriteLine("m_area = %d,%d - %d,%d", m_min_x, m_min_y, m_max_x, m_max_y);
 	}
 };
 
@@ -177,7 +177,7 @@ public:
 		if (target != NULL) target->okay = true;
 
 		if (Yapf().CanUseGlobalCache(*m_res_node))
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+			CSegmentCostCacheBase::NotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
 
 		return true;
 	}
@@ -358,6 +358,97 @@ public:
 	}
 };
 
+/**
+ * A track choice of a train that is remembered for the next train with the
+ * same position, destination and properties. The cache is not saved, so a
+ * client that joins searches afresh; to not desync, a remembered choice must
+ * be exactly the one a new search would make. So it is only reused as long
+ * as neither the track layout, nor a signal state or track reservation within
+ * the area the pathfinder looked at, nor a pathfinder setting changed.
+ */
+struct CachedTrainPath {
+	TileIndex     m_tile;               ///< tile of the train
+	Trackdir      m_trackdir;           ///< trackdir of the train
+	TileIndex     m_origin_tile;        ///< end of the reservation of the train
+	Trackdir      m_origin_trackdir;    ///< trackdir at the end of the reservation of the train
+	OrderType     m_order_type;         ///< type of the current order of the train
+	DestinationID m_destination;        ///< destination of the current order of the train
+	TileIndex     m_dest_tile;          ///< destination tile of the train
+	RailTypes     m_railtypes;          ///< rail types the train can use
+	Owner         m_owner;              ///< owner of the train
+	uint16        m_max_speed;          ///< maximum speed of the train
+	uint16        m_length;             ///< length of the train
+
+	int           m_layout_counter;     ///< CSegmentCostCacheBase::s_rail_change_counter when the path was found
+	uint          m_state_counter;      ///< _rail_state_counter when the path was found
+	uint16        m_min_x;              ///< lowest x of the searched area
+	uint16        m_min_y;              ///< lowest y of the searched area
+	uint16        m_max_x;              ///< highest x of the searched area
+	uint16        m_max_y;              ///< highest y of the searched area
+	Trackdir      m_result;             ///< the chosen trackdir
+	bool          m_path_not_found;     ///< whether the path was only guessed
+
+	/** Create an empty entry. */
+	CachedTrainPath() : m_tile(INVALID_TILE) {}
+
+	/**
+	 * Create the key for the track choice of the given train.
+	 * @param v the train to choose a track for
+	 */
+	CachedTrainPath(const Train *v)
+	{
+		PBSTileInfo origin = FollowTrainReservation(v);
+
+		m_tile            = v->tile;
+		m_trackdir        = v->GetVehicleTrackdir();
+		m_origin_tile     = origin.tile;
+		m_origin_trackdir = origin.trackdir;
+		m_order_type      = v->current_order.GetType();
+		m_destination     = v->current_order.GetDestination();
+		m_dest_tile       = v->dest_tile;
+		m_railtypes       = v->compatible_railtypes;
+		m_owner           = v->owner;
+		m_max_speed       = v->max_speed;
+		m_length          = v->tcache.cached_total_length;
+	}
+
+	/** Hash of the key, for the slot in the cache. */
+	FORCEINLINE uint Hash() const
+	{
+		return (m_tile ^ (m_trackdir << 7) ^ (m_destination << 3) ^ m_dest_tile) * 0x9E3779B1U;
+	}
+
+	/** Is the key of this entry the same as the one of the other entry? */
+	FORCEINLINE bool HasKey(const CachedTrainPath &other) const
+	{
+		return m_tile == other.m_tile && m_trackdir == other.m_trackdir &&
+				m_origin_tile == other.m_origin_tile && m_origin_trackdir == other.m_origin_trackdir &&
+				m_order_type == other.m_order_type && m_destination == other.m_destination && m_dest_tile == other.m_dest_tile &&
+				m_railtypes == other.m_railtypes && m_owner == other.m_owner &&
+				m_max_speed == other.m_max_speed && m_length == other.m_length;
+	}
+
+	/**
+	 * Would a new search still make the remembered choice?
+	 * @param tracks the tracks the train can choose from
+	 * @return true if the remembered choice can be used
+	 */
+	bool IsValid(TrackBits tracks) const
+	{
+		if (m_layout_counter != CSegmentCostCacheBase::s_rail_change_counter) return false;
+		if (_rail_state_counter - m_state_counter > RAIL_STATE_LOG_SIZE) return false;
+		if (m_result != INVALID_TRACKDIR && !HasBit(tracks, TrackdirToTrack(m_result))) return false;
+
+		for (uint i = m_state_counter; i != _rail_state_counter; i++) {
+			TileIndex tile = _rail_state_log[i % RAIL_STATE_LOG_SIZE];
+			uint x = TileX(tile);
+			uint y = TileY(tile);
+			if (x + 1 >= m_min_x && x <= m_max_x + 1U && y + 1 >= m_min_y && y <= m_max_y + 1U) return false;
+		}
+		return true;
+	}
+};
+
 template <class Types>
 class CYapfFollowRailT : public CYapfReserveTrack<Types>
 {
@@ -394,6 +485,11 @@ public:
 
 	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool *path_not_found, bool reserve_track, PBSTileInfo *target)
 	{
+#if !DEBUG_YAPF_CACHE
+		/* Reserving a path needs the nodes of the path, so always search then. */
+		if (!reserve_track) return stChooseRailTrackCached(v, tile, enterdir, tracks, path_not_found, target);
+#endif
+
 		/* create pathfinder instance */
 		Tpf pf1;
 #if !DEBUG_YAPF_CACHE
@@ -413,6 +509,59 @@ public:
 		return result1;
 	}
 
+	/**
+	 * Choose a track without reserving it, reusing the choice made for an
+	 * earlier train when a new search would come to the same result.
+	 */
+	static Trackdir stChooseRailTrackCached(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool *path_not_found, PBSTileInfo *target)
+	{
+		static CachedTrainPath cache[256];
+
+		CachedTrainPath key(v);
+		CachedTrainPath &cached = cache[key.Hash() >> 24];
+
+		if (cached.HasKey(key) && cached.IsValid(tracks)) {
+			if (target != NULL) target->tile = INVALID_TILE;
+			if (path_not_found != NULL) *path_not_found = cached.m_path_not_found;
+			return cached.m_result;
+		}
+
+		Tpf pf1;
+		bool not_found;
+		cached = key;
+		cached.m_state_counter = _rail_state_counter;
+		cached.m_result = pf1.ChooseRailTrack(v, tile, enterdir, tracks, &not_found, false, target);
+		cached.m_path_not_found = not_found;
+		cached.m_layout_counter = CSegmentCostCacheBase::s_rail_change_counter;
+		pf1.GetSearchedArea(cached);
+
+		if (path_not_found != NULL) *path_not_found = not_found;
+		return cached.m_result;
+	}
+
+	/**
+	 * Get the area the tiles of all nodes of the last search are in.
+	 * @param path the entry to store the area in
+	 */
+	void GetSearchedArea(CachedTrainPath &path)
+	{
+		path.m_min_x = path.m_min_y = UINT16_MAX;
+		path.m_max_x = path.m_max_y = 0;
+
+		for (int i = 0; i < Yapf().m_nodes.TotalCount(); i++) {
+			const Node &n = Yapf().m_nodes.ItemAt(i);
+			path.m_min_x = min<uint>(path.m_min_x, TileX(n.GetTile()));
+			path.m_min_y = min<uint>(path.m_min_y, TileY(n.GetTile()));
+			path.m_max_x = max<uint>(path.m_max_x, TileX(n.GetTile()));
+			path.m_max_y = max<uint>(path.m_max_y, TileY(n.GetTile()));
+			if (n.m_segment == NULL || n.m_segment->m_min_x > n.m_segment->m_max_x) continue;
+			path.m_min_x = min(path.m_min_x, n.m_segment->m_min_x);
+			path.m_min_y = min(path.m_min_y, n.m_segment->m_min_y);
+			path.m_max_x = max(path.m_max_x, n.m_segment->m_max_x);
+			path.m_max_y = max(path.m_max_y, n.m_segment->m_max_y);
+		}
+	}
+
 	FORCEINLINE Trackdir ChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool *path_not_found, bool reserve_track, PBSTileInfo *target)
 	{
 		if (target != NULL) target->tile = INVALID_TILE;
@@ -422,6 +571,12 @@ public:
 		Yapf().SetOrigin(origin.tile, origin.trackdir, INVALID_TILE, INVALID_TRACKDIR, 1, true);
 		Yapf().SetDestination(v);
 
+		/* don't search through the whole network for a destination that isn't connected to it */
+		if (!Yapf().MayReachDestination(origin.tile)) {
+			if (path_not_found != NULL) *path_not_found = true;
+			return INVALID_TRACKDIR;
+		}
+
 		/* find the best path */
 		bool path_found = Yapf().FindPath(v);
 		if (path_not_found != NULL) {
@@ -638,8 +793,19 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 
 /** if any track changes, this counter is incremented - that will invalidate segment cost cache */
 int CSegmentCostCacheBase::s_rail_change_counter = 0;
+TileIndex CSegmentCostCacheBase::s_changed_tiles[CSegmentCostCacheBase::C_CHANGE_LOG_SIZE];
+uint CSegmentCostCacheBase::s_cache_hits = 0;
+uint CSegmentCostCacheBase::s_cache_misses = 0;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	_yapf_rail_regions.MarkTileChanged(tile);
+}
+
+void YapfNotifySettingsChange()
+{
+	/* The segment costs and the remembered track choices depend on the penalties;
+	 * the connectivity of the regions does not. */
+	CSegmentCostCacheBase::NotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
 }
@@ -0,0 +1,301 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_region.cpp Connectivity of the regions of the map, to know early that a destination can't be reached. */
+
+#include "../../stdafx.h"
+#include "../../tile_cmd.h"
+#include "../../tunnelbridge_map.h"
+#include "../../core/alloc_func.hpp"
+#include "../../core/mem_func.hpp"
+#include "yapf_region.hpp"
+
+/** The regions connected by rail. */
+CYapfRegionGraph _yapf_rail_regions(TRANSPORT_RAIL, 0);
+
+/** The regions connected by water. */
+CYapfRegionGraph _yapf_water_regions(TRANSPORT_WATER, 0);
+
+/**
+ * Create an empty graph; it is built when it is used the first time.
+ * @param transport the transport type to make the graph for
+ * @param sub_mode  the sub mode for GetTileTrackStatus, e.g. the road types
+ */
+CYapfRegionGraph::CYapfRegionGraph(TransportType transport, uint sub_mode) :
+		m_transport(transport), m_sub_mode(sub_mode), m_size_x(0), m_size_y(0),
+		m_links(NULL), m_component(NULL), m_dirty(NULL), m_all_dirty(true), m_incremental(false)
+{
+}
+
+CYapfRegionGraph::~CYapfRegionGraph()
+{
+	free(m_links);
+	free(m_component);
+	free(m_dirty);
+}
+
+/**
+ * Notify the graph that the tracks of a tile changed.
+ * @param tile the changed tile, or INVALID_TILE when the whole map changed
+ */
+void CYapfRegionGraph::MarkTileChanged(TileIndex tile)
+{
+	if (m_all_dirty) return;
+
+	if (tile == INVALID_TILE) {
+		m_all_dirty = true;
+		return;
+	}
+
+	uint region = GetRegion(tile);
+	if (m_dirty[region]) return;
+	m_dirty[region] = true;
+	*m_dirty_list.Append() = region;
+}
+
+/**
+ * Might there be a route from a tile to a tile in the given area?
+ * A "no" changes what the pathfinders do, and must not depend on the changes
+ * that happened to be seen since the graph was built; e.g. a client that just
+ * joined builds it from scratch. So a "no" of an incrementally updated graph
+ * is checked again against a graph built from scratch.
+ * @param tile the tile to start at
+ * @param area the area to reach
+ * @return false if there is certainly no route
+ */
+bool CYapfRegionGraph::MayBeConnected(TileIndex tile, const TileArea &area)
+{
+	Update();
+	if (IsConnected(tile, area)) return true;
+	if (!m_incremental) return false;
+
+	m_all_dirty = true;
+	Update();
+	return IsConnected(tile, area);
+}
+
+/**
+ * Is a tile in the same connected component as a tile in the given area?
+ * @param tile the tile to start at
+ * @param area the area to reach
+ * @return whether the components are the same
+ * @pre the graph is up to date
+ */
+bool CYapfRegionGraph::IsConnected(TileIndex tile, const TileArea &area) const
+{
+	uint component = m_component[GetRegion(tile)];
+	uint x0 = TileX(area.tile) >> REGION_BITS;
+	uint y0 = TileY(area.tile) >> REGION_BITS;
+	uint x1 = (TileX(area.tile) + area.w - 1) >> REGION_BITS;
+	uint y1 = (TileY(area.tile) + area.h - 1) >> REGION_BITS;
+
+	for (uint y = y0; y <= y1; y++) {
+		for (uint x = x0; x <= x1; x++) {
+			if (m_component[y * m_size_x + x] == component) return true;
+		}
+	}
+	return false;
+}
+
+/** (Re)allocate the graph for the current map and make it empty. */
+void CYapfRegionGraph::Allocate()
+{
+	uint size_x = MapSizeX() >> REGION_BITS;
+	uint size_y = MapSizeY() >> REGION_BITS;
+	uint num_regions = size_x * size_y;
+
+	if (size_x != m_size_x || size_y != m_size_y) {
+		m_size_x = size_x;
+		m_size_y = size_y;
+		m_links = ReallocT(m_links, num_regions);
+		m_component = ReallocT(m_component, num_regions);
+		m_dirty = ReallocT(m_dirty, num_regions);
+	}
+
+	MemSetT(m_links, 0, num_regions);
+	MemSetT(m_dirty, false, num_regions);
+	m_dirty_list.Clear();
+	m_far_links.Clear();
+}
+
+/**
+ * Update whether a region is linked to its neighbour in the given direction.
+ * @param region the region
+ * @param dir    the direction of the neighbour
+ */
+void CYapfRegionGraph::UpdateLink(uint region, DiagDirection dir)
+{
+	uint rx = region % m_size_x;
+	uint ry = region / m_size_x;
+	uint region_size = 1 << REGION_BITS;
+
+	/* The neighbour, the first tile at the border and the direction along the border. */
+	uint neighbour;
+	TileIndex tile;
+	TileIndexDiff along;
+	switch (dir) {
+		case DIAGDIR_NE:
+			if (rx == 0) return;
+			neighbour = region - 1;
+			tile = TileXY(rx * region_size, ry * region_size);
+			along = TileDiffXY(0, 1);
+			break;
+
+		case DIAGDIR_SE:
+			if (ry == m_size_y - 1) return;
+			neighbour = region + m_size_x;
+			tile = TileXY(rx * region_size, (ry + 1) * region_size - 1);
+			along = TileDiffXY(1, 0);
+			break;
+
+		case DIAGDIR_SW:
+			if (rx == m_size_x - 1) return;
+			neighbour = region + 1;
+			tile = TileXY((rx + 1) * region_size - 1, ry * region_size);
+			along = TileDiffXY(0, 1);
+			break;
+
+		case DIAGDIR_NW:
+			if (ry == 0) return;
+			neighbour = region - m_size_x;
+			tile = TileXY(rx * region_size, ry * region_size);
+			along = TileDiffXY(1, 0);
+			break;
+
+		default: NOT_REACHED();
+	}
+
+	/* The trackdirs that leave a tile towards the neighbour and the ones that
+	 * can be entered from there; and the same for the other way around. */
+	DiagDirection back = ReverseDiagDir(dir);
+	TrackdirBits exit_there = TRACKDIR_BIT_NONE;
+	TrackdirBits exit_back = TRACKDIR_BIT_NONE;
+	for (uint i = 0; i < TRACKDIR_END; i++) {
+		Trackdir td = (Trackdir)i;
+		if (!IsValidTrackdir(td)) continue;
+		if (TrackdirToExitdir(td) == dir) exit_there |= TrackdirToTrackdirBits(td);
+		if (TrackdirToExitdir(td) == back) exit_back |= TrackdirToTrackdirBits(td);
+	}
+	TrackdirBits enter_there = DiagdirReachesTrackdirs(dir);
+	TrackdirBits enter_back = DiagdirReachesTrackdirs(back);
+
+	TileIndexDiff offset = TileOffsByDiagDir(dir);
+	bool linked = false;
+	for (uint i = 0; i < region_size && !linked; i++, tile += along) {
+		TrackdirBits here = TrackStatusToTrackdirBits(GetTileTrackStatus(tile, m_transport, m_sub_mode));
+		if (here == TRACKDIR_BIT_NONE) continue;
+		TrackdirBits there = TrackStatusToTrackdirBits(GetTileTrackStatus(tile + offset, m_transport, m_sub_mode));
+
+		linked = ((here & exit_there) != TRACKDIR_BIT_NONE && (there & enter_there) != TRACKDIR_BIT_NONE) ||
+				((there & exit_back) != TRACKDIR_BIT_NONE && (here & enter_back) != TRACKDIR_BIT_NONE);
+	}
+
+	SB(m_links[region], dir, 1, linked);
+	SB(m_links[neighbour], back, 1, linked);
+}
+
+/**
+ * Update the links of a region.
+ * @param region the region to update
+ * @param forget_far_links whether the tunnels and bridges of the region might be known already
+ */
+void CYapfRegionGraph::UpdateRegion(uint region, bool forget_far_links)
+{
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) UpdateLink(region, dir);
+
+	if (forget_far_links) {
+		for (uint i = 0; i < m_far_links.Length();) {
+			if (m_far_links[i].from == region) {
+				m_far_links.Erase(m_far_links.Get(i));
+			} else {
+				i++;
+			}
+		}
+	}
+
+	uint region_size = 1 << REGION_BITS;
+	TileArea ta(TileXY(region % m_size_x * region_size, region / m_size_x * region_size), region_size, region_size);
+	TILE_AREA_LOOP(tile, ta) {
+		if (!IsTileType(tile, MP_TUNNELBRIDGE) || GetTunnelBridgeTransportType(tile) != m_transport) continue;
+
+		uint other = GetRegion(GetOtherTunnelBridgeEnd(tile));
+		if (other == region) continue;
+
+		FarLink *link = m_far_links.Append();
+		link->from = region;
+		link->to = other;
+	}
+}
+
+/**
+ * Find the representative of the set of a region, halving the path to it.
+ * @param parent the parent of every region
+ * @param region the region
+ * @return the representative of the set
+ */
+static uint FindRegionSet(uint *parent, uint region)
+{
+	while (parent[region] != region) {
+		parent[region] = parent[parent[region]];
+		region = parent[region];
+	}
+	return region;
+}
+
+/**
+ * Put two regions in the same set.
+ * @param parent the parent of every region
+ * @param a      the first region
+ * @param b      the second region
+ */
+static void UniteRegionSets(uint *parent, uint a, uint b)
+{
+	a = FindRegionSet(parent, a);
+	b = FindRegionSet(parent, b);
+	parent[b] = a;
+}
+
+/** Find the connected components of the graph. */
+void CYapfRegionGraph::UpdateComponents()
+{
+	uint num_regions = m_size_x * m_size_y;
+	for (uint r = 0; r < num_regions; r++) m_component[r] = r;
+
+	for (uint r = 0; r < num_regions; r++) {
+		if (HasBit(m_links[r], DIAGDIR_SW)) UniteRegionSets(m_component, r, r + 1);
+		if (HasBit(m_links[r], DIAGDIR_SE)) UniteRegionSets(m_component, r, r + m_size_x);
+	}
+	for (const FarLink *link = m_far_links.Begin(); link != m_far_links.End(); link++) {
+		UniteRegionSets(m_component, link->from, link->to);
+	}
+
+	for (uint r = 0; r < num_regions; r++) m_component[r] = FindRegionSet(m_component, r);
+}
+
+/** Bring the graph up to date with the map. */
+void CYapfRegionGraph::Update()
+{
+	if (m_all_dirty) {
+		Allocate();
+		for (uint r = 0; r < m_size_x * m_size_y; r++) UpdateRegion(r, false);
+		m_all_dirty = false;
+		m_incremental = false;
+	} else if (m_dirty_list.Length() != 0) {
+		m_incremental = true;
+		for (const uint *r = m_dirty_list.Begin(); r != m_dirty_list.End(); r++) {
+			UpdateRegion(*r, true);
+			m_dirty[*r] = false;
+		}
+		m_dirty_list.Clear();
+	} else {
+		return;
+	}
+
+	UpdateComponents();
+}
@@ -0,0 +1,80 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_region.hpp Connectivity of the regions of the map, to know early that a destination can't be reached. */
+
+#ifndef  YAPF_REGION_HPP
+#define  YAPF_REGION_HPP
+
+#include "../../tilearea_type.h"
+#include "../../transport_type.h"
+#include "../../core/smallvec_type.hpp"
+
+/**
+ * Graph of square regions of the map. Two regions are linked when a track of
+ * the transport type leads over the border between them, or when a tunnel or
+ * bridge connects them. All tracks within one region are assumed to be
+ * connected, so the graph can only tell for sure that there is NO route
+ * between two tiles; when it says there might be one, there might be none.
+ *
+ * The regions are updated lazily: changed tiles only mark their region dirty
+ * and the dirty regions and the connected components are updated when the
+ * graph is asked for the next time.
+ */
+class CYapfRegionGraph {
+public:
+	static const uint REGION_BITS = 5; ///< log2 of the width and height of a region in tiles
+
+	CYapfRegionGraph(TransportType transport, uint sub_mode);
+	~CYapfRegionGraph();
+
+	void MarkTileChanged(TileIndex tile);
+	bool MayBeConnected(TileIndex tile, const TileArea &area);
+
+private:
+	/** A link between two regions that aren't neighbours, made by a tunnel or a bridge. */
+	struct FarLink {
+		uint from; ///< region the tunnel or bridge head is in
+		uint to;   ///< region the other end is in
+	};
+
+	TransportType m_transport;          ///< transport type the graph is made for
+	uint m_sub_mode;                    ///< sub mode for GetTileTrackStatus
+	uint m_size_x;                      ///< number of regions in x direction
+	uint m_size_y;                      ///< number of regions in y direction
+	byte *m_links;                      ///< per region the DiagDirections in which it is linked to the neighbour region
+	uint *m_component;                  ///< per region the connected component it belongs to
+	bool *m_dirty;                      ///< per region whether it must be updated
+	SmallVector<uint, 16> m_dirty_list; ///< the regions that must be updated
+	SmallVector<FarLink, 16> m_far_links; ///< the links made by tunnels and bridges
+	bool m_all_dirty;                   ///< whether the whole graph must be (re)built
+	bool m_incremental;                 ///< whether regions were updated since the whole graph was built
+
+	/**
+	 * Get the region a tile is in.
+	 * @param tile the tile
+	 * @return the index of the region
+	 */
+	FORCEINLINE uint GetRegion(TileIndex tile) const
+	{
+		return (TileY(tile) >> REGION_BITS) * m_size_x + (TileX(tile) >> REGION_BITS);
+	}
+
+	bool IsConnected(TileIndex tile, const TileArea &area) const;
+	void Allocate();
+	void UpdateRegion(uint region, bool forget_far_links);
+	void UpdateLink(uint region, DiagDirection dir);
+	void UpdateComponents();
+	void Update();
+};
+
+extern CYapfRegionGraph _yapf_rail_regions;
+extern CYapfRegionGraph _yapf_water_regions;
+
+#endif /* YAPF_REGION_HPP */
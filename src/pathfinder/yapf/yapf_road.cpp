@@ -318,14 +318,45 @@ public:
 		return 'r';
 	}
 
-	static Trackdir stChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir)
+	static Trackdir stChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, RoadVehPathCache &path_cache)
 	{
 		Tpf pf;
-		return pf.ChooseRoadTrack(v, tile, enterdir);
+		return pf.ChooseRoadTrack(v, tile, enterdir, path_cache);
 	}
 
-	FORCEINLINE Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir)
+	/**
+	 * Grow the area of a path cache so it contains a tile.
+	 * @param path_cache the path cache
+	 * @param tile       the tile to add
+	 */
+	static FORCEINLINE void AddToPathArea(RoadVehPathCache &path_cache, TileIndex tile)
 	{
+		path_cache.min_x = min<uint>(path_cache.min_x, TileX(tile));
+		path_cache.min_y = min<uint>(path_cache.min_y, TileY(tile));
+		path_cache.max_x = max<uint>(path_cache.max_x, TileX(tile));
+		path_cache.max_y = max<uint>(path_cache.max_y, TileY(tile));
+	}
+
+	/**
+	 * Is a tile within the given distance of a tile area?
+	 * @param tile the tile
+	 * @param area the area, may be empty
+	 * @param dist the distance in tiles
+	 * @return true if the tile is close to the area
+	 */
+	static FORCEINLINE bool IsNearArea(TileIndex tile, const TileArea &area, uint dist)
+	{
+		if (area.tile == INVALID_TILE) return false;
+		uint x = TileX(tile);
+		uint y = TileY(tile);
+		return x + dist >= TileX(area.tile) && x < TileX(area.tile) + area.w + dist &&
+				y + dist >= TileY(area.tile) && y < TileY(area.tile) + area.h + dist;
+	}
+
+	FORCEINLINE Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, RoadVehPathCache &path_cache)
+	{
+		path_cache.Clear();
+
 		/* Handle special case - when next tile is destination tile.
 		 * However, when going to a station the (initial) destination
 		 * tile might not be a station, but a junction, in which case
@@ -346,21 +377,56 @@ public:
 		Yapf().SetDestination(v);
 
 		/* find the best path */
-		Yapf().FindPath(v);
+		bool path_found = Yapf().FindPath(v);
+
+		/* Near a station the best bay depends on the other vehicles, so
+		 * don't remember the choices made close to the destination. */
+		const TileArea *dest_area = NULL;
+		if (v->current_order.IsType(OT_GOTO_STATION)) {
+			const Station *st = Station::Get(v->current_order.GetDestination());
+			dest_area = v->IsBus() ? &st->bus_station : &st->truck_station;
+		}
 
 		/* if path not found - return INVALID_TRACKDIR */
 		Trackdir next_trackdir = INVALID_TRACKDIR;
 		Node *pNode = Yapf().GetBestNode();
 		if (pNode != NULL) {
+			uint steps = 0;
+			for (Node *n = pNode; n->m_parent != NULL; n = n->m_parent) steps++;
+
 			/* path was found or at least suggested
-			 * walk through the path back to its origin */
+			 * walk through the path back to its origin,
+			 * remembering the junctions right after it */
+			TileIndex last_tiles[RV_PATH_CACHE_SIZE];
+			uint cache_size = path_found ? min<uint>(steps, RV_PATH_CACHE_SIZE) : 0;
 			while (pNode->m_parent != NULL) {
+				steps--;
+				if (pNode->GetTile() == v->dest_tile || (dest_area != NULL && IsNearArea(pNode->GetTile(), *dest_area, YAPF_ROADVEH_PATH_CACHE_DESTINATION_LIMIT))) {
+					cache_size = min(cache_size, steps);
+				}
+				if (steps < cache_size) {
+					path_cache.tile[steps] = pNode->GetTile();
+					path_cache.td[steps] = pNode->GetTrackdir();
+					last_tiles[steps] = pNode->m_segment_last_tile;
+				}
 				pNode = pNode->m_parent;
 			}
 			/* return trackdir from the best origin node (one of start nodes) */
 			Node& best_next_node = *pNode;
 			assert(best_next_node.GetTile() == tile);
 			next_trackdir = best_next_node.GetTrackdir();
+
+			if (cache_size > 0) {
+				path_cache.count = cache_size;
+				path_cache.dest_tile = v->dest_tile;
+				path_cache.min_x = path_cache.max_x = TileX(tile);
+				path_cache.min_y = path_cache.max_y = TileY(tile);
+				AddToPathArea(path_cache, best_next_node.m_segment_last_tile);
+				for (uint i = 0; i < cache_size; i++) {
+					AddToPathArea(path_cache, path_cache.tile[i]);
+					AddToPathArea(path_cache, last_tiles[i]);
+				}
+			}
 		}
 		return next_trackdir;
 	}
@@ -465,10 +531,10 @@ struct CYapfRoadAnyDepot1 : CYapfT<CYapfRoad_TypesT<CYapfRoadAnyDepot1, CRoadNod
 struct CYapfRoadAnyDepot2 : CYapfT<CYapfRoad_TypesT<CYapfRoadAnyDepot2, CRoadNodeListExitDir , CYapfDestinationAnyDepotRoadT> > {};
 
 
-Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs)
+Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, RoadVehPathCache &path_cache)
 {
 	/* default is YAPF type 2 */
-	typedef Trackdir (*PfnChooseRoadTrack)(const RoadVehicle*, TileIndex, DiagDirection);
+	typedef Trackdir (*PfnChooseRoadTrack)(const RoadVehicle*, TileIndex, DiagDirection, RoadVehPathCache&);
 	PfnChooseRoadTrack pfnChooseRoadTrack = &CYapfRoad2::stChooseRoadTrack; // default: ExitDir, allow 90-deg
 
 	/* check if non-default YAPF type should be used */
@@ -476,7 +542,7 @@ Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDi
 		pfnChooseRoadTrack = &CYapfRoad1::stChooseRoadTrack; // Trackdir, allow 90-deg
 	}
 
-	Trackdir td_ret = pfnChooseRoadTrack(v, tile, enterdir);
+	Trackdir td_ret = pfnChooseRoadTrack(v, tile, enterdir, path_cache);
 	return (td_ret != INVALID_TRACKDIR) ? td_ret : (Trackdir)FindFirstBit2x64(trackdirs);
 }
 
@@ -13,6 +13,7 @@
 #include "../../ship.h"
 
 #include "yapf.hpp"
+#include "yapf_region.hpp"
 
 /** Node Follower module of YAPF for ships */
 template <class Types>
@@ -185,3 +186,18 @@ Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir,
 	Trackdir td_ret = pfnChooseShipTrack(v, tile, enterdir, tracks);
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
 }
+
+bool YapfShipMayReachTile(TileIndex tile, TileIndex dest)
+{
+	/* The destination might be next to the water, e.g. a dock, so look around it too. */
+	uint x0 = max<uint>(TileX(dest), 1) - 1;
+	uint y0 = max<uint>(TileY(dest), 1) - 1;
+	uint x1 = min(TileX(dest) + 1, MapMaxX());
+	uint y1 = min(TileY(dest) + 1, MapMaxY());
+	return _yapf_water_regions.MayBeConnected(tile, TileArea(TileXY(x0, y0), x1 - x0 + 1, y1 - y0 + 1));
+}
+
+void YapfNotifyWaterLayoutChange(TileIndex tile)
+{
+	_yapf_water_regions.MarkTileChanged(tile);
+}
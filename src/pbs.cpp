@@ -13,6 +13,212 @@
 #include "functions.h"
 #include "vehicle_func.h"
 #include "pathfinder/follow_track.hpp"
+#include "core/alloc_func.hpp"
+#include "core/smallvec_type.hpp"
+#include "core/sort_func.hpp"
+
+/** The train the reservations are made for at the moment, or INVALID_VEHICLE when it isn't known. */
+VehicleID _reserving_train = INVALID_VEHICLE;
+
+/**
+ * Open addressed hash of the trains that made the reservations, keyed by
+ * tile and track. A slot without train is empty. The index is part of the
+ * game state and saved with it, as it decides which train a reservation is
+ * given back to when the track is changed. Reservations made when the
+ * train isn't known are not in the index and are followed instead.
+ */
+static ReservationOwner *_reservation_owners = NULL;
+static uint _reservation_owner_bits = 0;          ///< log2 of the number of slots, or 0 when there are no slots.
+static uint _reservation_owner_count = 0;         ///< Number of used slots.
+static SmallVector<uint, 64> _reservations_per_train; ///< Per train the number of reservations in the index.
+
+static const uint MIN_RESERVATION_OWNER_BITS = 10; ///< log2 of the initial number of slots.
+
+/**
+ * Get the slot a reservation would like to be in.
+ * @param tile  the tile with the reservation
+ * @param track the reserved track
+ * @return the first slot to look at
+ */
+static inline uint GetReservationOwnerSlot(TileIndex tile, Track track)
+{
+	return ((tile << 3 | track) * 0x9E3779B1U) >> (32 - _reservation_owner_bits);
+}
+
+/**
+ * Find the slot of a reservation.
+ * @param tile  the tile with the reservation
+ * @param track the reserved track
+ * @return the slot, or NULL when the reservation is not in the index
+ */
+static ReservationOwner *FindReservationOwner(TileIndex tile, Track track)
+{
+	if (_reservation_owner_count == 0) return NULL;
+
+	uint mask = (1 << _reservation_owner_bits) - 1;
+	for (uint i = GetReservationOwnerSlot(tile, track);; i = (i + 1) & mask) {
+		ReservationOwner *ro = &_reservation_owners[i];
+		if (ro->train == INVALID_VEHICLE) return NULL;
+		if (ro->tile == tile && ro->track == track) return ro;
+	}
+}
+
+/**
+ * Change the number of reservations of a train in the index.
+ * @param train the train
+ * @param diff  the number of reservations added (1) or removed (-1)
+ */
+static void CountReservationsOfTrain(VehicleID train, int diff)
+{
+	while (_reservations_per_train.Length() <= train) *_reservations_per_train.Append() = 0;
+	_reservations_per_train[train] += diff;
+}
+
+/**
+ * Put the owner of a reservation in the index.
+ * @param tile  the tile with the reservation
+ * @param track the reserved track
+ * @param train the train that made the reservation
+ */
+static void SetReservationOwner(TileIndex tile, Track track, VehicleID train)
+{
+	if ((_reservation_owner_count + 1) * 2 > (1U << _reservation_owner_bits)) {
+		/* Keep at least half of the slots empty. */
+		ReservationOwner *old_owners = _reservation_owners;
+		uint old_size = (_reservation_owner_bits == 0) ? 0 : 1 << _reservation_owner_bits;
+
+		_reservation_owner_bits = max(_reservation_owner_bits + 1, MIN_RESERVATION_OWNER_BITS);
+		_reservation_owners = MallocT<ReservationOwner>(1 << _reservation_owner_bits);
+		for (uint i = 0; i < (1U << _reservation_owner_bits); i++) _reservation_owners[i].train = INVALID_VEHICLE;
+
+		uint mask = (1 << _reservation_owner_bits) - 1;
+		for (uint i = 0; i < old_size; i++) {
+			if (old_owners[i].train == INVALID_VEHICLE) continue;
+			uint j = GetReservationOwnerSlot(old_owners[i].tile, (Track)old_owners[i].track);
+			while (_reservation_owners[j].train != INVALID_VEHICLE) j = (j + 1) & mask;
+			_reservation_owners[j] = old_owners[i];
+		}
+		free(old_owners);
+	}
+
+	uint mask = (1 << _reservation_owner_bits) - 1;
+	uint i = GetReservationOwnerSlot(tile, track);
+	for (;; i = (i + 1) & mask) {
+		ReservationOwner *ro = &_reservation_owners[i];
+		if (ro->train == INVALID_VEHICLE) {
+			ro->tile = tile;
+			ro->track = track;
+			_reservation_owner_count++;
+			break;
+		}
+		if (ro->tile == tile && ro->track == track) {
+			CountReservationsOfTrain(ro->train, -1);
+			break;
+		}
+	}
+	_reservation_owners[i].train = train;
+	CountReservationsOfTrain(train, 1);
+}
+
+/**
+ * Remove a reservation from the index.
+ * @param tile  the tile with the reservation
+ * @param track the reserved track
+ */
+static void RemoveReservationOwner(TileIndex tile, Track track)
+{
+	ReservationOwner *ro = FindReservationOwner(tile, track);
+	if (ro == NULL) return;
+
+	CountReservationsOfTrain(ro->train, -1);
+	_reservation_owner_count--;
+
+	/* Move the following entries of the cluster into the hole when that is not before their own slot. */
+	uint mask = (1 << _reservation_owner_bits) - 1;
+	uint hole = ro - _reservation_owners;
+	for (uint i = (hole + 1) & mask; _reservation_owners[i].train != INVALID_VEHICLE; i = (i + 1) & mask) {
+		uint slot = GetReservationOwnerSlot(_reservation_owners[i].tile, (Track)_reservation_owners[i].track);
+		if (((i - slot) & mask) >= ((i - hole) & mask)) {
+			_reservation_owners[hole] = _reservation_owners[i];
+			hole = i;
+		}
+	}
+	_reservation_owners[hole].train = INVALID_VEHICLE;
+}
+
+/**
+ * Update the index of the reservations after the reserved tracks of a tile changed.
+ * Newly reserved tracks get #_reserving_train as owner.
+ * @param tile         the tile
+ * @param old_reserved the tracks that were reserved before
+ * @param new_reserved the tracks that are reserved now
+ */
+void UpdateReservationOwner(TileIndex tile, TrackBits old_reserved, TrackBits new_reserved)
+{
+	Track track;
+	FOR_EACH_SET_TRACK(track, old_reserved & ~new_reserved) RemoveReservationOwner(tile, track);
+	FOR_EACH_SET_TRACK(track, new_reserved & ~old_reserved) {
+		if (_reserving_train == INVALID_VEHICLE) {
+			RemoveReservationOwner(tile, track);
+		} else {
+			SetReservationOwner(tile, track, _reserving_train);
+		}
+	}
+}
+
+/**
+ * Remove all reservations of a train from the index, e.g. because the train is deleted.
+ * @param train the train
+ */
+void ForgetReservationsOfTrain(VehicleID train)
+{
+	if (train >= _reservations_per_train.Length() || _reservations_per_train[train] == 0) return;
+
+	SmallVector<ReservationOwner, 16> owned;
+	for (uint i = 0; i < (1U << _reservation_owner_bits); i++) {
+		if (_reservation_owners[i].train == train) *owned.Append() = _reservation_owners[i];
+	}
+	for (const ReservationOwner *ro = owned.Begin(); ro != owned.End(); ro++) RemoveReservationOwner(ro->tile, (Track)ro->track);
+}
+
+/** Forget all owners of reservations, e.g. when a new game is started. */
+void ClearReservationOwners()
+{
+	free(_reservation_owners);
+	_reservation_owners = NULL;
+	_reservation_owner_bits = 0;
+	_reservation_owner_count = 0;
+	_reservations_per_train.Clear();
+}
+
+/** Order the owners of reservations by tile and track. */
+static int CDECL ReservationOwnerSorter(const ReservationOwner *a, const ReservationOwner *b)
+{
+	if (a->tile != b->tile) return (a->tile < b->tile) ? -1 : 1;
+	return a->track - b->track;
+}
+
+/**
+ * Get all owners of reservations in the index, sorted by tile and track.
+ * @param owners [out] the owners
+ */
+void GetReservationOwners(SmallVector<ReservationOwner, 64> &owners)
+{
+	owners.Clear();
+	for (uint i = 0; _reservation_owner_count != 0 && i < (1U << _reservation_owner_bits); i++) {
+		if (_reservation_owners[i].train != INVALID_VEHICLE) *owners.Append() = _reservation_owners[i];
+	}
+	if (owners.Length() != 0) QSortT(owners.Begin(), owners.Length(), &ReservationOwnerSorter);
+}
+
+/**
+ * Put a loaded owner of a reservation in the index.
+ * @param owner the owner
+ */
+void LoadReservationOwner(const ReservationOwner &owner)
+{
+	SetReservationOwner(owner.tile, (Track)owner.track, owner.train);
+}
 
 /**
  * Get the reserved trackbits for any tile, regardless of type.
@@ -306,6 +512,14 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 Train *GetTrainForReservation(TileIndex tile, Track track)
 {
 	assert(HasReservedTracks(tile, TrackToTrackBits(track)));
+
+	/* The index knows the train when the reservation was made for a known train. */
+	const ReservationOwner *ro = FindReservationOwner(tile, track);
+	if (ro != NULL) {
+		Train *owner = Train::GetIfValid(ro->train);
+		if (owner != NULL && owner->IsFrontEngine() && !(owner->vehstatus & VS_CRASHED)) return owner;
+	}
+
 	Trackdir  trackdir = TrackToTrackdir(track);
 
 	RailTypes rts = GetRailTypeInfo(GetTileRailType(tile))->compatible_railtypes;
@@ -24,6 +24,34 @@ void SetRailStationPlatformReservation(TileIndex start, DiagDirection dir, bool
 bool TryReserveRailTrack(TileIndex tile, Track t);
 void UnreserveRailTrack(TileIndex tile, Track t);
 
+extern VehicleID _reserving_train;
+
+/** The owner of the reservation of a track on a tile, as remembered by the index of the reservations. */
+struct ReservationOwner {
+	TileIndex tile;  ///< The tile with the reserved track.
+	byte track;      ///< The reserved track.
+	VehicleID train; ///< The train that made the reservation.
+};
+
+void UpdateReservationOwner(TileIndex tile, TrackBits old_reserved, TrackBits new_reserved);
+void ForgetReservationsOfTrain(VehicleID train);
+void ClearReservationOwners();
+
+/** Make all reservations during the lifetime of this object for the given train. */
+struct ReservationOwnerScope {
+	VehicleID old_train; ///< The train the reservations were made for before.
+
+	FORCEINLINE ReservationOwnerScope(VehicleID train) : old_train(_reserving_train)
+	{
+		_reserving_train = train;
+	}
+
+	FORCEINLINE ~ReservationOwnerScope()
+	{
+		_reserving_train = this->old_train;
+	}
+};
+
 /** This struct contains information about the end of a reserved path. */
 struct PBSTileInfo {
 	TileIndex tile;      ///< Tile the path ends, INVALID_TILE if no valid path was found.
@@ -15,6 +15,7 @@
 #include "rail_type.h"
 #include "depot_type.h"
 #include "signal_func.h"
+#include "pbs.h"
 #include "track_func.h"
 #include "tile_map.h"
 #include "signal_type.h"
@@ -212,9 +213,11 @@ static inline void SetTrackReservation(TileIndex t, TrackBits b)
 	assert(IsPlainRailTile(t));
 	assert(b != INVALID_TRACK_BIT);
 	assert(!TracksOverlap(b));
+	UpdateReservationOwner(t, GetRailReservationTrackBits(t), b);
 	Track track = RemoveFirstTrack(&b);
 	SB(_m[t].m2, 8, 3, track == INVALID_TRACK ? 0 : track + 1);
 	SB(_m[t].m2, 11, 1, (byte)(b != TRACK_BIT_NONE));
+	MarkRailStateChanged(t);
 }
 
 /**
@@ -271,7 +274,10 @@ static inline bool HasDepotReservation(TileIndex t)
 static inline void SetDepotReservation(TileIndex t, bool b)
 {
 	assert(IsRailDepot(t));
+	TrackBits track = TrackToTrackBits(GetRailDepotTrack(t));
+	UpdateReservationOwner(t, HasDepotReservation(t) ? track : TRACK_BIT_NONE, b ? track : TRACK_BIT_NONE);
 	SB(_m[t].m5, 4, 1, (byte)b);
+	MarkRailStateChanged(t);
 }
 
 /**
@@ -362,6 +368,7 @@ enum SignalState {
 static inline void SetSignalStates(TileIndex tile, uint state)
 {
 	SB(_m[tile].m4, 4, 4, state);
+	MarkRailStateChanged(tile);
 }
 
 /**
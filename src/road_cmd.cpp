@@ -342,6 +342,7 @@ static CommandCost RemoveRoad(TileIndex tile, DoCommandFlag flags, RoadBits piec
 					bool reserved = HasCrossingReservation(tile);
 					MakeRailNormal(tile, GetTileOwner(tile), tracks, GetRailType(tile));
 					if (reserved) SetTrackReservation(tile, tracks);
+					MarkRoadLayoutChanged(tile);
 				} else {
 					SetRoadTypes(tile, rts);
 					/* If we ever get HWAY and it is possible without road then we will need to promote ownership and invalidate town index here, too */
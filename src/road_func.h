@@ -172,4 +172,8 @@ RoadTypes GetCompanyRoadtypes(const CompanyID company);
 
 void UpdateLevelCrossing(TileIndex tile, bool sound = true);
 
+void MarkRoadLayoutChanged(TileIndex tile);
+void UpdateRoadVehPathCaches();
+void ForgetRoadLayoutChanges();
+
 #endif /* ROAD_FUNC_H */
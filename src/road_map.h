@@ -17,6 +17,8 @@
 #include "rail_type.h"
 #include "road_func.h"
 #include "tile_map.h"
+#include "signal_func.h"
+#include "pbs.h"
 
 
 enum RoadTileType {
@@ -102,6 +104,7 @@ static inline void SetRoadBits(TileIndex t, RoadBits r, RoadType rt)
 		case ROADTYPE_ROAD: SB(_m[t].m5, 0, 4, r); break;
 		case ROADTYPE_TRAM: SB(_m[t].m3, 0, 4, r); break;
 	}
+	MarkRoadLayoutChanged(t);
 }
 
 static inline RoadTypes GetRoadTypes(TileIndex t)
@@ -113,6 +116,7 @@ static inline void SetRoadTypes(TileIndex t, RoadTypes rt)
 {
 	assert(IsTileType(t, MP_ROAD) || IsTileType(t, MP_STATION) || IsTileType(t, MP_TUNNELBRIDGE));
 	SB(_me[t].m7, 6, 2, rt);
+	MarkRoadLayoutChanged(t);
 }
 
 static inline bool HasTileRoadType(TileIndex t, RoadType rt)
@@ -191,6 +195,7 @@ static inline void SetDisallowedRoadDirections(TileIndex t, DisallowedRoadDirect
 	assert(IsNormalRoad(t));
 	assert(drd < DRD_END);
 	SB(_m[t].m5, 4, 2, drd);
+	MarkRoadLayoutChanged(t);
 }
 
 static inline Axis GetCrossingRoadAxis(TileIndex t)
@@ -243,7 +248,10 @@ static inline bool HasCrossingReservation(TileIndex t)
 static inline void SetCrossingReservation(TileIndex t, bool b)
 {
 	assert(IsLevelCrossingTile(t));
+	TrackBits track = GetCrossingRailBits(t);
+	UpdateReservationOwner(t, HasCrossingReservation(t) ? track : TRACK_BIT_NONE, b ? track : TRACK_BIT_NONE);
 	SB(_m[t].m5, 4, 1, b ? 1 : 0);
+	MarkRailStateChanged(t);
 }
 
 /**
@@ -381,6 +389,7 @@ static inline void MakeRoadNormal(TileIndex t, RoadBits bits, RoadTypes rot, Tow
 	SB(_m[t].m6, 2, 4, 0);
 	_me[t].m7 = rot << 6;
 	SetRoadOwner(t, ROADTYPE_TRAM, tram);
+	MarkRoadLayoutChanged(t);
 }
 
 
@@ -395,6 +404,7 @@ static inline void MakeRoadCrossing(TileIndex t, Owner road, Owner tram, Owner r
 	SB(_m[t].m6, 2, 4, 0);
 	_me[t].m7 = rot << 6 | road;
 	SetRoadOwner(t, ROADTYPE_TRAM, tram);
+	MarkRoadLayoutChanged(t);
 }
 
 
@@ -409,6 +419,7 @@ static inline void MakeRoadDepot(TileIndex t, Owner owner, DepotID did, DiagDire
 	SB(_m[t].m6, 2, 4, 0);
 	_me[t].m7 = RoadTypeToRoadTypes(rt) << 6 | owner;
 	SetRoadOwner(t, ROADTYPE_TRAM, owner);
+	MarkRoadLayoutChanged(t);
 }
 
 #endif /* ROAD_MAP_H */
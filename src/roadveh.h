@@ -87,6 +87,51 @@ struct RoadVehicleCache {
 	EngineID first_engine;      ///< Cached EngineID of the front vehicle. INVALID_ENGINE for the front vehicle itself.
 };
 
+/** Number of junctions a road vehicle remembers the choice for. */
+static const uint RV_PATH_CACHE_SIZE = 8;
+
+/**
+ * The choices made at the next junctions by the last path search of a road
+ * vehicle, so it only has to search again when the path is used up, the
+ * destination changed or the roads near the path changed.
+ */
+struct RoadVehPathCache {
+	TileIndex tile[RV_PATH_CACHE_SIZE]; ///< The junctions, in the order the vehicle passes them.
+	byte td[RV_PATH_CACHE_SIZE];        ///< The trackdir to take at each of the junctions.
+	byte count;                         ///< The number of junctions still in the cache.
+	TileIndex dest_tile;                ///< The destination the path was searched for.
+	uint16 min_x;                       ///< The path lies within these tile coordinates.
+	uint16 min_y;                       ///< The path lies within these tile coordinates.
+	uint16 max_x;                       ///< The path lies within these tile coordinates.
+	uint16 max_y;                       ///< The path lies within these tile coordinates.
+
+	FORCEINLINE bool IsEmpty() const { return this->count == 0; }
+	FORCEINLINE void Clear() { this->count = 0; }
+
+	/** Forget the first junction, the vehicle passed it. */
+	FORCEINLINE void PopFront()
+	{
+		assert(this->count > 0);
+		this->count--;
+		for (uint i = 0; i < this->count; i++) {
+			this->tile[i] = this->tile[i + 1];
+			this->td[i] = this->td[i + 1];
+		}
+	}
+
+	/**
+	 * Might the path be changed by a change of the road at the given tile?
+	 * @param tile the changed tile
+	 * @return true if the tile is on or next to the area of the path
+	 */
+	FORCEINLINE bool IsAffectedBy(TileIndex tile) const
+	{
+		uint x = TileX(tile);
+		uint y = TileY(tile);
+		return x + 1 >= this->min_x && x <= this->max_x + 1u && y + 1 >= this->min_y && y <= this->max_y + 1u;
+	}
+};
+
 /**
  * Buses, trucks and trams belong to this class.
  */
@@ -103,6 +148,8 @@ struct RoadVehicle : public GroundVehicle<RoadVehicle, VEH_ROAD> {
 	RoadType roadtype;
 	RoadTypes compatible_roadtypes;
 
+	RoadVehPathCache path;  ///< The path the last path search found, valid only for the front vehicle.
+
 	/** We don't want GCC to zero our struct! It already is zeroed and has an index! */
 	RoadVehicle() : GroundVehicle<RoadVehicle, VEH_ROAD>() {}
 	/** We want to 'destruct' the right class. */
@@ -163,6 +210,9 @@ struct RoadVehicle : public GroundVehicle<RoadVehicle, VEH_ROAD> {
 
 protected: // These functions should not be called outside acceleration code.
 
+	/** Road vehicles have no properties that are cached for the acceleration code. */
+	FORCEINLINE void UpdatePartProperties() {}
+
 	/**
 	 * Allows to know the power value that this vehicle will use.
 	 * @return Power value from the engine in HP, or zero if the vehicle is not powered.
@@ -22,6 +22,8 @@
 #include "newgrf_engine.h"
 #include "newgrf_sound.h"
 #include "pathfinder/yapf/yapf.h"
+#include "pathfinder/pf_recorder.h"
+#include "pathfinder/pf_performance_timer.hpp"
 #include "strings_func.h"
 #include "tunnelbridge_map.h"
 #include "functions.h"
@@ -42,6 +44,7 @@
 #include "company_base.h"
 #include "engine_func.h"
 #include "core/backup_type.hpp"
+#include "timeline.h"
 
 #include "table/strings.h"
 #include "table/sprites.h"
@@ -295,13 +298,15 @@ CommandCost CmdBuildRoadVeh(TileIndex tile, DoCommandFlag flags, uint32 p1, uint
 		VehicleMove(v, false);
 
 		InvalidateWindowData(WC_VEHICLE_DEPOT, v->tile);
-		InvalidateWindowClassesData(WC_ROADVEH_LIST, 0);
+		InvalidateVehicleListsOfVehicle(v);
 		SetWindowDirty(WC_COMPANY, v->owner);
 		if (IsLocalCompany()) {
 			InvalidateAutoreplaceWindow(v->engine_type, v->group_id); // updates the replace Road window
 		}
 
-		Company::Get(_current_company)->num_engines[eid]++;
+		Company *c = Company::Get(_current_company);
+		c->num_engines[eid]++;
+		c->num_vehicles[v->type]++;
 
 		CheckConsistencyOfArticulatedVehicle(v);
 	}
@@ -705,10 +710,10 @@ static RoadVehicle *RoadVehFindCloseTo(RoadVehicle *v, int x, int y, Direction d
 	rvf.best_diff = UINT_MAX;
 
 	if (front->state == RVSB_WORMHOLE) {
-		FindVehicleOnPos(v->tile, &rvf, EnumCheckRoadVehClose);
-		FindVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), &rvf, EnumCheckRoadVehClose);
+		FindRoadVehicleOnPos(v->tile, &rvf, EnumCheckRoadVehClose);
+		FindRoadVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), &rvf, EnumCheckRoadVehClose);
 	} else {
-		FindVehicleOnPosXY(x, y, &rvf, EnumCheckRoadVehClose);
+		FindRoadVehicleOnPosXY(x, y, &rvf, EnumCheckRoadVehClose);
 	}
 
 	/* This code protects a roadvehicle from being blocked for ever
@@ -859,7 +864,7 @@ static bool CheckRoadBlockedForOvertaking(OvertakeData *od)
 	if (!HasBit(trackdirbits, od->trackdir) || (trackbits & ~TRACK_BIT_CROSS) || (red_signals != TRACKDIR_BIT_NONE)) return true;
 
 	/* Are there more vehicles on the tile except the two vehicles involved in overtaking */
-	return HasVehicleOnPos(od->tile, od, EnumFindVehBlockingOvertake);
+	return HasRoadVehicleOnPos(od->tile, od, EnumFindVehBlockingOvertake);
 }
 
 static void RoadVehCheckOvertake(RoadVehicle *v, RoadVehicle *u)
@@ -926,6 +931,68 @@ static void RoadZPosAffectSpeed(RoadVehicle *v, byte old_z)
 	}
 }
 
+/** Maximum number of changed road tiles remembered before all path caches are thrown away. */
+static const uint ROAD_LAYOUT_CHANGES_MAX = 256;
+
+static SmallVector<TileIndex, 16> _road_layout_changes; ///< The road tiles changed since the path caches were last checked.
+static bool _road_layout_changes_overflow;               ///< Too many road tiles changed to remember them all.
+
+/**
+ * Remember that the road on a tile changed, so the road vehicles that
+ * remember a path near it search again. The path caches are updated at the
+ * end of the command or the game tick, see #UpdateRoadVehPathCaches.
+ * @param tile the changed tile
+ */
+void MarkRoadLayoutChanged(TileIndex tile)
+{
+	if (_road_layout_changes_overflow) return;
+
+	if (_road_layout_changes.Length() >= ROAD_LAYOUT_CHANGES_MAX) {
+		_road_layout_changes_overflow = true;
+		_road_layout_changes.Clear();
+		return;
+	}
+	*_road_layout_changes.Append() = tile;
+}
+
+/**
+ * Forget the path caches of the road vehicles near changed road tiles.
+ * This must be called at the same moments on all clients, as the path
+ * caches are part of the game state.
+ */
+void UpdateRoadVehPathCaches()
+{
+	if (_road_layout_changes.Length() == 0 && !_road_layout_changes_overflow) return;
+
+	RoadVehicle *v;
+	FOR_ALL_ROADVEHICLES(v) {
+		if (v->path.IsEmpty()) continue;
+
+		if (_road_layout_changes_overflow) {
+			v->path.Clear();
+			continue;
+		}
+		for (const TileIndex *tile = _road_layout_changes.Begin(); tile != _road_layout_changes.End(); tile++) {
+			if (v->path.IsAffectedBy(*tile)) {
+				v->path.Clear();
+				break;
+			}
+		}
+	}
+
+	ForgetRoadLayoutChanges();
+}
+
+/**
+ * Forget the changed road tiles without touching the path caches, e.g.
+ * because the map was just loaded or made.
+ */
+void ForgetRoadLayoutChanges()
+{
+	_road_layout_changes.Clear();
+	_road_layout_changes_overflow = false;
+}
+
 static int PickRandomBit(uint bits)
 {
 	uint i;
@@ -935,6 +1002,36 @@ static int PickRandomBit(uint bits)
 	return i;
 }
 
+/**
+ * Ask the pathfinder of the road vehicles for the trackdir to take.
+ * @param v         the vehicle to do the pathfinding for
+ * @param tile      the tile the vehicle is about to enter
+ * @param enterdir  the direction the vehicle enters the tile in
+ * @param trackdirs the trackdirs to choose from
+ * @return the Trackdir to take
+ */
+static Trackdir DoRoadVehPathfind(RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs)
+{
+	TIMELINE_ZONE("road vehicle pathfinder");
+
+	CPerformanceTimer timer;
+	if (IsRecordingPathfinderQueries()) timer.Start();
+
+	Trackdir td;
+	switch (_settings_game.pf.pathfinder_for_roadvehs) {
+		case VPF_NPF: td = NPFRoadVehicleChooseTrack(v, tile, enterdir, trackdirs); break;
+		case VPF_YAPF: td = YapfRoadVehicleChooseTrack(v, tile, enterdir, trackdirs, v->path); break;
+
+		default: NOT_REACHED();
+	}
+
+	if (IsRecordingPathfinderQueries()) {
+		timer.Stop();
+		RecordPathfinderQuery(PFQ_ROADVEH, v, tile, enterdir, trackdirs, td, timer.m_acc);
+	}
+	return td;
+}
+
 /**
  * Returns direction to for a road vehicle to take or
  * INVALID_TRACKDIR if the direction is currently blocked
@@ -987,10 +1084,14 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 	 * stuff, probably even more arguments to GTTS.
 	 */
 
+	/* Handle the roads changed during this tick before looking at the path cache. */
+	UpdateRoadVehPathCaches();
+
 	/* Remove tracks unreachable from the enter dir */
 	trackdirs &= _road_enter_dir_to_reachable_trackdirs[enterdir];
 	if (trackdirs == TRACKDIR_BIT_NONE) {
 		/* No reachable tracks, so we'll reverse */
+		v->path.Clear();
 		return_track(_road_reverse_table[enterdir]);
 	}
 
@@ -1007,6 +1108,7 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 		if (reverse) {
 			v->reverse_ctr = 0;
 			if (v->tile != tile) {
+				v->path.Clear();
 				return_track(_road_reverse_table[enterdir]);
 			}
 		}
@@ -1020,16 +1122,30 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 
 	/* Only one track to choose between? */
 	if (KillFirstBit(trackdirs) == TRACKDIR_BIT_NONE) {
+		if (!v->path.IsEmpty() && v->path.tile[0] == tile) {
+			/* The path expected a junction here; if it doesn't lead this way any more, forget it. */
+			if (HasBit(trackdirs, v->path.td[0])) {
+				v->path.PopFront();
+			} else {
+				v->path.Clear();
+			}
+		}
 		return_track(FindFirstBit2x64(trackdirs));
 	}
 
-	switch (_settings_game.pf.pathfinder_for_roadvehs) {
-		case VPF_NPF: return_track(NPFRoadVehicleChooseTrack(v, tile, enterdir, trackdirs));
-		case VPF_YAPF: return_track(YapfRoadVehicleChooseTrack(v, tile, enterdir, trackdirs));
-
-		default: NOT_REACHED();
+	if (_settings_game.pf.pathfinder_for_roadvehs == VPF_YAPF) {
+		/* Follow the path of the last search while it still leads over this junction. */
+		RoadVehPathCache &path = v->path;
+		if (!path.IsEmpty() && path.tile[0] == tile && path.dest_tile == desttile && HasBit(trackdirs, path.td[0])) {
+			Trackdir td = (Trackdir)path.td[0];
+			/* When the crossing is closed the vehicle will come back to this junction. */
+			if (!HasBit(red_signals, td)) path.PopFront();
+			return_track(td);
+		}
 	}
 
+	return_track(DoRoadVehPathfind(v, tile, enterdir, trackdirs));
+
 found_best_track:;
 
 	if (HasBit(red_signals, best_track)) return INVALID_TRACKDIR;
@@ -1647,18 +1763,10 @@ Money RoadVehicle::GetRunningCost() const
 	return GetPrice(e->u.road.running_cost_class, cost_factor, e->grffile);
 }
 
-bool RoadVehicle::Tick()
-{
-	if (this->IsRoadVehFront()) {
-		if (!(this->vehstatus & VS_STOPPED)) this->running_ticks++;
-		return RoadVehController(this);
-	}
-
-	return true;
-}
-
 static void CheckIfRoadVehNeedsService(RoadVehicle *v)
 {
+	ClrBit(v->vehicle_flags, VF_SERVICE_CHECK_PENDING);
+
 	/* If we already got a slot at a stop, use that FIRST, and go to a depot later */
 	if (Company::Get(v->owner)->settings.vehicle.servint_roadveh == 0 || !v->NeedsAutomaticServicing()) return;
 	if (v->IsInDepot()) {
@@ -1666,6 +1774,8 @@ static void CheckIfRoadVehNeedsService(RoadVehicle *v)
 		return;
 	}
 
+	if (!MayStartServiceDepotSearch(v)) return;
+
 	uint max_penalty;
 	switch (_settings_game.pf.pathfinder_for_roadvehs) {
 		case VPF_NPF:  max_penalty = _settings_game.pf.npf.maximum_go_to_depot_penalty;  break;
@@ -1701,6 +1811,17 @@ static void CheckIfRoadVehNeedsService(RoadVehicle *v)
 	SetWindowWidgetDirty(WC_VEHICLE_VIEW, v->index, VVW_WIDGET_START_STOP_VEH);
 }
 
+bool RoadVehicle::Tick()
+{
+	if (this->IsRoadVehFront()) {
+		if (!(this->vehstatus & VS_STOPPED)) this->running_ticks++;
+		if (HasBit(this->vehicle_flags, VF_SERVICE_CHECK_PENDING)) CheckIfRoadVehNeedsService(this);
+		return RoadVehController(this);
+	}
+
+	return true;
+}
+
 void RoadVehicle::OnNewDay()
 {
 	if (!this->IsRoadVehFront()) return;
@@ -1709,7 +1830,8 @@ void RoadVehicle::OnNewDay()
 	if (this->blocked_ctr == 0) CheckVehicleBreakdown(this);
 
 	AgeVehicle(this);
-	CheckIfRoadVehNeedsService(this);
+	/* The depot search is done when it is the turn of this vehicle in a tick. */
+	SetBit(this->vehicle_flags, VF_SERVICE_CHECK_PENDING);
 
 	CheckOrders(this);
 
@@ -1785,7 +1907,7 @@ CommandCost CmdRefitRoadVeh(TileIndex tile, DoCommandFlag flags, uint32 p1, uint
 		if (_settings_game.vehicle.roadveh_acceleration_model != AM_ORIGINAL) front->CargoChanged();
 		InvalidateWindowData(WC_VEHICLE_DETAILS, front->index);
 		SetWindowDirty(WC_VEHICLE_DEPOT, front->tile);
-		InvalidateWindowClassesData(WC_ROADVEH_LIST, 0);
+		InvalidateVehicleListsOfVehicle(front);
 	} else {
 		v->InvalidateNewGRFCacheOfChain(); // always invalidate; querycost might have filled it
 	}
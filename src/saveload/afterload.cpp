@@ -28,6 +28,7 @@
 #include "../roadveh.h"
 #include "../train.h"
 #include "../station_base.h"
+#include "../station_func.h"
 #include "../waypoint_base.h"
 #include "../roadstop_base.h"
 #include "../tunnelbridge_map.h"
@@ -53,6 +54,9 @@
 #include "../engine_func.h"
 #include "../rail_gui.h"
 #include "../core/backup_type.hpp"
+#include "../core/smallvec_type.hpp"
+#include "../effectvehicle_base.h"
+#include "../effectvehicle_func.h"
 
 #include "table/strings.h"
 
@@ -426,6 +430,424 @@ static void FixOwnerOfRailTrack(TileIndex t)
 	MakeClear(t, CLEAR_GRASS, 0);
 }
 
+/** A conversion of a single tile of an old savegame. */
+typedef void TileConversionProc(TileIndex t);
+
+/** The tile conversions that still have to be done, in the order they were added. */
+static SmallVector<TileConversionProc *, 16> _tile_conversions;
+
+/**
+ * Add a conversion that has to be done for every tile of the map. It is
+ * done at the next #RunTileConversions, together with all other conversions
+ * that were added in the meantime, so the map only has to be walked once.
+ * Conversions must therefore only depend on the tile they convert, or on
+ * parts of the neighbouring tiles the other pending conversions don't change.
+ * @param proc the conversion
+ */
+static void AddTileConversion(TileConversionProc *proc)
+{
+	*_tile_conversions.Append() = proc;
+}
+
+/**
+ * Do all added tile conversions. Every tile is converted by all of them,
+ * in the order they were added, before the next tile is converted.
+ * Must be called before anything depends on the converted map.
+ */
+static void RunTileConversions()
+{
+	uint num = _tile_conversions.Length();
+	if (num == 0) return;
+
+	TileConversionProc * const *procs = _tile_conversions.Begin();
+	for (TileIndex t = 0; t < MapSize(); t++) {
+		for (uint i = 0; i < num; i++) procs[i](t);
+	}
+	_tile_conversions.Clear();
+}
+
+/**
+ * Swap the ground and signal type of plain rail and the track type of crossings.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion48(TileIndex t)
+{
+	switch (GetTileType(t)) {
+		case MP_RAILWAY:
+			if (IsPlainRail(t)) {
+				/* Swap ground type and signal type for plain rail tiles, so the
+				 * ground type uses the same bits as for depots and waypoints. */
+				uint tmp = GB(_m[t].m4, 0, 4);
+				SB(_m[t].m4, 0, 4, GB(_m[t].m2, 0, 4));
+				SB(_m[t].m2, 0, 4, tmp);
+			} else if (HasBit(_m[t].m5, 2)) {
+				/* Split waypoint and depot rail type and remove the subtype. */
+				ClrBit(_m[t].m5, 2);
+				ClrBit(_m[t].m5, 6);
+			}
+			break;
+
+		case MP_ROAD:
+			/* Swap m3 and m4, so the track type for rail crossings is the
+			 * same as for normal rail. */
+			Swap(_m[t].m3, _m[t].m4);
+			break;
+
+		default: break;
+	}
+}
+
+/**
+ * Add the road types to road, road stop and road tunnel/bridge tiles.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion61(TileIndex t)
+{
+	bool old_bridge = CheckSavegameVersion(42);
+
+	switch (GetTileType(t)) {
+		case MP_ROAD:
+			SB(_m[t].m5, 6, 2, GB(_m[t].m5, 4, 2));
+			switch (GetRoadTileType(t)) {
+				default: NOT_REACHED();
+				case ROAD_TILE_NORMAL:
+					SB(_m[t].m4, 0, 4, GB(_m[t].m5, 0, 4));
+					SB(_m[t].m4, 4, 4, 0);
+					SB(_m[t].m6, 2, 4, 0);
+					break;
+				case ROAD_TILE_CROSSING:
+					SB(_m[t].m4, 5, 2, GB(_m[t].m5, 2, 2));
+					break;
+				case ROAD_TILE_DEPOT:    break;
+			}
+			SetRoadTypes(t, ROADTYPES_ROAD);
+			break;
+
+		case MP_STATION:
+			if (IsRoadStop(t)) SetRoadTypes(t, ROADTYPES_ROAD);
+			break;
+
+		case MP_TUNNELBRIDGE:
+			/* Middle part of "old" bridges */
+			if (old_bridge && IsBridge(t) && HasBit(_m[t].m5, 6)) break;
+			if (((old_bridge && IsBridge(t)) ? (TransportType)GB(_m[t].m5, 1, 2) : GetTunnelBridgeTransportType(t)) == TRANSPORT_ROAD) {
+				SetRoadTypes(t, ROADTYPES_ROAD);
+			}
+			break;
+
+		default: break;
+	}
+}
+
+/**
+ * Move the road and tram owners and bits to their new place in the map array.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion114(TileIndex t)
+{
+	bool fix_roadtypes = !CheckSavegameVersion(61);
+	bool old_bridge = CheckSavegameVersion(42);
+
+	switch (GetTileType(t)) {
+		case MP_ROAD:
+			if (fix_roadtypes) SetRoadTypes(t, (RoadTypes)GB(_me[t].m7, 5, 3));
+			SB(_me[t].m7, 5, 1, GB(_m[t].m3, 7, 1)); // snow/desert
+			switch (GetRoadTileType(t)) {
+				default: NOT_REACHED();
+				case ROAD_TILE_NORMAL:
+					SB(_me[t].m7, 0, 4, GB(_m[t].m3, 0, 4)); // road works
+					SB(_m[t].m6, 3, 3, GB(_m[t].m3, 4, 3));  // ground
+					SB(_m[t].m3, 0, 4, GB(_m[t].m4, 4, 4));  // tram bits
+					SB(_m[t].m3, 4, 4, GB(_m[t].m5, 0, 4));  // tram owner
+					SB(_m[t].m5, 0, 4, GB(_m[t].m4, 0, 4));  // road bits
+					break;
+
+				case ROAD_TILE_CROSSING:
+					SB(_me[t].m7, 0, 5, GB(_m[t].m4, 0, 5)); // road owner
+					SB(_m[t].m6, 3, 3, GB(_m[t].m3, 4, 3));  // ground
+					SB(_m[t].m3, 4, 4, GB(_m[t].m5, 0, 4));  // tram owner
+					SB(_m[t].m5, 0, 1, GB(_m[t].m4, 6, 1));  // road axis
+					SB(_m[t].m5, 5, 1, GB(_m[t].m4, 5, 1));  // crossing state
+					break;
+
+				case ROAD_TILE_DEPOT:
+					break;
+			}
+			if (!IsRoadDepot(t) && !HasTownOwnedRoad(t)) {
+				const Town *town = CalcClosestTownFromTile(t);
+				if (town != NULL) SetTownIndex(t, town->index);
+			}
+			_m[t].m4 = 0;
+			break;
+
+		case MP_STATION:
+			if (!IsRoadStop(t)) break;
+
+			if (fix_roadtypes) SetRoadTypes(t, (RoadTypes)GB(_m[t].m3, 0, 3));
+			SB(_me[t].m7, 0, 5, HasBit(_m[t].m6, 2) ? OWNER_TOWN : GetTileOwner(t));
+			SB(_m[t].m3, 4, 4, _m[t].m1);
+			_m[t].m4 = 0;
+			break;
+
+		case MP_TUNNELBRIDGE:
+			if (old_bridge && IsBridge(t) && HasBit(_m[t].m5, 6)) break;
+			if (((old_bridge && IsBridge(t)) ? (TransportType)GB(_m[t].m5, 1, 2) : GetTunnelBridgeTransportType(t)) == TRANSPORT_ROAD) {
+				if (fix_roadtypes) SetRoadTypes(t, (RoadTypes)GB(_m[t].m3, 0, 3));
+
+				Owner o = GetTileOwner(t);
+				SB(_me[t].m7, 0, 5, o); // road owner
+				SB(_m[t].m3, 4, 4, o == OWNER_NONE ? OWNER_TOWN : o); // tram owner
+			}
+			SB(_m[t].m6, 2, 4, GB(_m[t].m2, 4, 4)); // bridge type
+			SB(_me[t].m7, 5, 1, GB(_m[t].m4, 7, 1)); // snow/desert
+
+			_m[t].m2 = 0;
+			_m[t].m4 = 0;
+			break;
+
+		default: break;
+	}
+}
+
+/**
+ * Move the animation state of the old animated industry tiles.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion43(TileIndex t)
+{
+	if (IsTileType(t, MP_INDUSTRY)) {
+		switch (GetIndustryGfx(t)) {
+			case GFX_POWERPLANT_SPARKS:
+				SetIndustryAnimationState(t, GB(_m[t].m1, 2, 5));
+				break;
+
+			case GFX_OILWELL_ANIMATED_1:
+			case GFX_OILWELL_ANIMATED_2:
+			case GFX_OILWELL_ANIMATED_3:
+				SetIndustryAnimationState(t, GB(_m[t].m1, 0, 2));
+				break;
+
+			case GFX_COAL_MINE_TOWER_ANIMATED:
+			case GFX_COPPER_MINE_TOWER_ANIMATED:
+			case GFX_GOLD_MINE_TOWER_ANIMATED:
+				 SetIndustryAnimationState(t, _m[t].m1);
+				 break;
+
+			default: // No animation states to change
+				break;
+		}
+	}
+}
+
+/**
+ * Store the town of statues in the map array.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion52(TileIndex t)
+{
+	if (IsStatueTile(t)) {
+		_m[t].m2 = CalcClosestTownFromTile(t)->index;
+	}
+}
+
+/**
+ * Copy the signal type and variant and move the signal states.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion64(TileIndex t)
+{
+	if (IsTileType(t, MP_RAILWAY) && HasSignals(t)) {
+		SetSignalStates(t, GB(_m[t].m2, 4, 4));
+		SetSignalVariant(t, INVALID_TRACK, GetSignalVariant(t, TRACK_X));
+		SetSignalType(t, INVALID_TRACK, GetSignalType(t, TRACK_X));
+		ClrBit(_m[t].m2, 7);
+	}
+}
+
+/**
+ * Replace the owner of old style canals above sea level by OWNER_NONE.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion82(TileIndex t)
+{
+	if (IsTileType(t, MP_WATER) &&
+			GetWaterTileType(t) == WATER_TILE_CLEAR &&
+			GetTileOwner(t) == OWNER_WATER &&
+			TileHeight(t) != 0) {
+		SetTileOwner(t, OWNER_NONE);
+	}
+}
+
+/**
+ * Store the previous owner of the water below ship depots.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion83(TileIndex t)
+{
+	if (IsTileType(t, MP_WATER) && IsShipDepot(t)) {
+		_m[t].m4 = (TileHeight(t) == 0) ? OWNER_WATER : OWNER_NONE;
+	}
+}
+
+/**
+ * Give grassy and rough land trees full density.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion81(TileIndex t)
+{
+	if (GetTileType(t) == MP_TREES) {
+		TreeGround groundType = (TreeGround)GB(_m[t].m2, 4, 2);
+		if (groundType != TREE_GROUND_SNOW_DESERT) SB(_m[t].m2, 6, 2, 3);
+	}
+}
+
+/**
+ * Increase the house animation frame from 5 to 7 bits.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion91(TileIndex t)
+{
+	if (IsTileType(t, MP_HOUSE) && GetHouseType(t) >= NEW_HOUSE_OFFSET) {
+		SetHouseAnimationFrame(t, GB(_m[t].m6, 3, 5));
+	}
+}
+
+/**
+ * Set the water class of industry tiles and replace the house construction year with its age.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion99(TileIndex t)
+{
+	/* Set newly introduced WaterClass of industry tiles */
+	if (IsTileType(t, MP_STATION) && IsOilRig(t)) {
+		SetWaterClassDependingOnSurroundings(t, true);
+	}
+	if (IsTileType(t, MP_INDUSTRY)) {
+		if ((GetIndustrySpec(GetIndustryType(t))->behaviour & INDUSTRYBEH_BUILT_ONWATER) != 0) {
+			SetWaterClassDependingOnSurroundings(t, true);
+		} else {
+			SetWaterClass(t, WATER_CLASS_INVALID);
+		}
+	}
+
+	/* Replace "house construction year" with "house age" */
+	if (IsTileType(t, MP_HOUSE) && IsHouseCompleted(t)) {
+		_m[t].m5 = Clamp(_cur_year - (_m[t].m5 + ORIGINAL_BASE_YEAR), 0, 0xFF);
+	}
+}
+
+/**
+ * Move the signal variant for PBS and clear all reservations.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion100(TileIndex t)
+{
+	switch (GetTileType(t)) {
+		case MP_RAILWAY:
+			if (HasSignals(t)) {
+				/* move the signal variant */
+				SetSignalVariant(t, TRACK_UPPER, HasBit(_m[t].m2, 2) ? SIG_SEMAPHORE : SIG_ELECTRIC);
+				SetSignalVariant(t, TRACK_LOWER, HasBit(_m[t].m2, 6) ? SIG_SEMAPHORE : SIG_ELECTRIC);
+				ClrBit(_m[t].m2, 2);
+				ClrBit(_m[t].m2, 6);
+			}
+
+			/* Clear PBS reservation on track */
+			if (IsRailDepot(t)) {
+				SetDepotReservation(t, false);
+			} else {
+				SetTrackReservation(t, TRACK_BIT_NONE);
+			}
+			break;
+
+		case MP_ROAD: // Clear PBS reservation on crossing
+			if (IsLevelCrossing(t)) SetCrossingReservation(t, false);
+			break;
+
+		case MP_STATION: // Clear PBS reservation on station
+			if (HasStationRail(t)) SetRailStationReservation(t, false);
+			break;
+
+		case MP_TUNNELBRIDGE: // Clear PBS reservation on tunnels/birdges
+			if (GetTunnelBridgeTransportType(t) == TRANSPORT_RAIL) SetTunnelBridgeReservation(t, false);
+			break;
+
+		default: break;
+	}
+}
+
+/**
+ * Swap the bits for the tree ground and tree density.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion135(TileIndex t)
+{
+	if (IsTileType(t, MP_CLEAR)) {
+		if (GetRawClearGround(t) == CLEAR_SNOW) {
+			SetClearGroundDensity(t, CLEAR_GRASS, GetClearDensity(t));
+			SetBit(_m[t].m3, 4);
+		} else {
+			ClrBit(_m[t].m3, 4);
+		}
+	}
+	if (IsTileType(t, MP_TREES)) {
+		uint density = GB(_m[t].m2, 6, 2);
+		uint ground = GB(_m[t].m2, 4, 2);
+		uint counter = GB(_m[t].m2, 0, 4);
+		_m[t].m2 = ground << 6 | density << 4 | counter;
+	}
+}
+
+/**
+ * Use the animation frame of airport tiles instead of their graphics.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion137(TileIndex t)
+{
+	struct AirportTileConversion {
+		byte old_start;
+		byte num_frames;
+	};
+	static const AirportTileConversion atc[] = {
+		{31,  12}, // APT_RADAR_GRASS_FENCE_SW
+		{50,   4}, // APT_GRASS_FENCE_NE_FLAG
+		{62,   2}, // 1 unused tile
+		{66,  12}, // APT_RADAR_FENCE_SW
+		{78,  12}, // APT_RADAR_FENCE_NE
+		{101, 10}, // 9 unused tiles
+		{111,  8}, // 7 unused tiles
+		{119, 15}, // 14 unused tiles (radar)
+		{140,  4}, // APT_GRASS_FENCE_NE_FLAG_2
+	};
+
+	if (IsAirportTile(t)) {
+		StationGfx old_gfx = GetStationGfx(t);
+		byte offset = 0;
+		for (uint i = 0; i < lengthof(atc); i++) {
+			if (old_gfx < atc[i].old_start) {
+				SetStationGfx(t, old_gfx - offset);
+				break;
+			}
+			if (old_gfx < atc[i].old_start + atc[i].num_frames) {
+				SetStationAnimationFrame(t, old_gfx - atc[i].old_start);
+				SetStationGfx(t, atc[i].old_start - offset);
+				break;
+			}
+			offset += atc[i].num_frames - 1;
+		}
+	}
+}
+
+/**
+ * Reset the tropic zone of void tiles.
+ * @param t the tile to convert
+ */
+static void ConvertTileToVersion141(TileIndex t)
+{
+	/* Reset tropic zone for VOID tiles, they shall not have any. */
+	if (IsTileType(t, MP_VOID)) SetTropicZone(t, TROPICZONE_NORMAL);
+}
+
 bool AfterLoadGame()
 {
 	SetSignalHandlers();
@@ -824,139 +1246,20 @@ bool AfterLoadGame()
 	}
 
 	if (CheckSavegameVersion(48)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			switch (GetTileType(t)) {
-				case MP_RAILWAY:
-					if (IsPlainRail(t)) {
-						/* Swap ground type and signal type for plain rail tiles, so the
-						 * ground type uses the same bits as for depots and waypoints. */
-						uint tmp = GB(_m[t].m4, 0, 4);
-						SB(_m[t].m4, 0, 4, GB(_m[t].m2, 0, 4));
-						SB(_m[t].m2, 0, 4, tmp);
-					} else if (HasBit(_m[t].m5, 2)) {
-						/* Split waypoint and depot rail type and remove the subtype. */
-						ClrBit(_m[t].m5, 2);
-						ClrBit(_m[t].m5, 6);
-					}
-					break;
-
-				case MP_ROAD:
-					/* Swap m3 and m4, so the track type for rail crossings is the
-					 * same as for normal rail. */
-					Swap(_m[t].m3, _m[t].m4);
-					break;
-
-				default: break;
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion48);
 	}
 
 	if (CheckSavegameVersion(61)) {
 		/* Added the RoadType */
-		bool old_bridge = CheckSavegameVersion(42);
-		for (TileIndex t = 0; t < map_size; t++) {
-			switch (GetTileType(t)) {
-				case MP_ROAD:
-					SB(_m[t].m5, 6, 2, GB(_m[t].m5, 4, 2));
-					switch (GetRoadTileType(t)) {
-						default: NOT_REACHED();
-						case ROAD_TILE_NORMAL:
-							SB(_m[t].m4, 0, 4, GB(_m[t].m5, 0, 4));
-							SB(_m[t].m4, 4, 4, 0);
-							SB(_m[t].m6, 2, 4, 0);
-							break;
-						case ROAD_TILE_CROSSING:
-							SB(_m[t].m4, 5, 2, GB(_m[t].m5, 2, 2));
-							break;
-						case ROAD_TILE_DEPOT:    break;
-					}
-					SetRoadTypes(t, ROADTYPES_ROAD);
-					break;
-
-				case MP_STATION:
-					if (IsRoadStop(t)) SetRoadTypes(t, ROADTYPES_ROAD);
-					break;
-
-				case MP_TUNNELBRIDGE:
-					/* Middle part of "old" bridges */
-					if (old_bridge && IsBridge(t) && HasBit(_m[t].m5, 6)) break;
-					if (((old_bridge && IsBridge(t)) ? (TransportType)GB(_m[t].m5, 1, 2) : GetTunnelBridgeTransportType(t)) == TRANSPORT_ROAD) {
-						SetRoadTypes(t, ROADTYPES_ROAD);
-					}
-					break;
-
-				default: break;
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion61);
 	}
 
 	if (CheckSavegameVersion(114)) {
-		bool fix_roadtypes = !CheckSavegameVersion(61);
-		bool old_bridge = CheckSavegameVersion(42);
-
-		for (TileIndex t = 0; t < map_size; t++) {
-			switch (GetTileType(t)) {
-				case MP_ROAD:
-					if (fix_roadtypes) SetRoadTypes(t, (RoadTypes)GB(_me[t].m7, 5, 3));
-					SB(_me[t].m7, 5, 1, GB(_m[t].m3, 7, 1)); // snow/desert
-					switch (GetRoadTileType(t)) {
-						default: NOT_REACHED();
-						case ROAD_TILE_NORMAL:
-							SB(_me[t].m7, 0, 4, GB(_m[t].m3, 0, 4)); // road works
-							SB(_m[t].m6, 3, 3, GB(_m[t].m3, 4, 3));  // ground
-							SB(_m[t].m3, 0, 4, GB(_m[t].m4, 4, 4));  // tram bits
-							SB(_m[t].m3, 4, 4, GB(_m[t].m5, 0, 4));  // tram owner
-							SB(_m[t].m5, 0, 4, GB(_m[t].m4, 0, 4));  // road bits
-							break;
-
-						case ROAD_TILE_CROSSING:
-							SB(_me[t].m7, 0, 5, GB(_m[t].m4, 0, 5)); // road owner
-							SB(_m[t].m6, 3, 3, GB(_m[t].m3, 4, 3));  // ground
-							SB(_m[t].m3, 4, 4, GB(_m[t].m5, 0, 4));  // tram owner
-							SB(_m[t].m5, 0, 1, GB(_m[t].m4, 6, 1));  // road axis
-							SB(_m[t].m5, 5, 1, GB(_m[t].m4, 5, 1));  // crossing state
-							break;
-
-						case ROAD_TILE_DEPOT:
-							break;
-					}
-					if (!IsRoadDepot(t) && !HasTownOwnedRoad(t)) {
-						const Town *town = CalcClosestTownFromTile(t);
-						if (town != NULL) SetTownIndex(t, town->index);
-					}
-					_m[t].m4 = 0;
-					break;
-
-				case MP_STATION:
-					if (!IsRoadStop(t)) break;
-
-					if (fix_roadtypes) SetRoadTypes(t, (RoadTypes)GB(_m[t].m3, 0, 3));
-					SB(_me[t].m7, 0, 5, HasBit(_m[t].m6, 2) ? OWNER_TOWN : GetTileOwner(t));
-					SB(_m[t].m3, 4, 4, _m[t].m1);
-					_m[t].m4 = 0;
-					break;
-
-				case MP_TUNNELBRIDGE:
-					if (old_bridge && IsBridge(t) && HasBit(_m[t].m5, 6)) break;
-					if (((old_bridge && IsBridge(t)) ? (TransportType)GB(_m[t].m5, 1, 2) : GetTunnelBridgeTransportType(t)) == TRANSPORT_ROAD) {
-						if (fix_roadtypes) SetRoadTypes(t, (RoadTypes)GB(_m[t].m3, 0, 3));
-
-						Owner o = GetTileOwner(t);
-						SB(_me[t].m7, 0, 5, o); // road owner
-						SB(_m[t].m3, 4, 4, o == OWNER_NONE ? OWNER_TOWN : o); // tram owner
-					}
-					SB(_m[t].m6, 2, 4, GB(_m[t].m2, 4, 4)); // bridge type
-					SB(_me[t].m7, 5, 1, GB(_m[t].m4, 7, 1)); // snow/desert
-
-					_m[t].m2 = 0;
-					_m[t].m4 = 0;
-					break;
-
-				default: break;
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion114);
 	}
 
+	RunTileConversions();
+
 	if (CheckSavegameVersion(42)) {
 		Vehicle *v;
 
@@ -1273,30 +1576,7 @@ bool AfterLoadGame()
 	UpdateHousesAndTowns();
 
 	if (CheckSavegameVersion(43)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (IsTileType(t, MP_INDUSTRY)) {
-				switch (GetIndustryGfx(t)) {
-					case GFX_POWERPLANT_SPARKS:
-						SetIndustryAnimationState(t, GB(_m[t].m1, 2, 5));
-						break;
-
-					case GFX_OILWELL_ANIMATED_1:
-					case GFX_OILWELL_ANIMATED_2:
-					case GFX_OILWELL_ANIMATED_3:
-						SetIndustryAnimationState(t, GB(_m[t].m1, 0, 2));
-						break;
-
-					case GFX_COAL_MINE_TOWER_ANIMATED:
-					case GFX_COPPER_MINE_TOWER_ANIMATED:
-					case GFX_GOLD_MINE_TOWER_ANIMATED:
-						 SetIndustryAnimationState(t, _m[t].m1);
-						 break;
-
-					default: // No animation states to change
-						break;
-				}
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion43);
 	}
 
 	if (CheckSavegameVersion(45)) {
@@ -1337,11 +1617,7 @@ bool AfterLoadGame()
 	if (CheckSavegameVersion(49)) FOR_ALL_COMPANIES(c) c->face = ConvertFromOldCompanyManagerFace(c->face);
 
 	if (CheckSavegameVersion(52)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (IsStatueTile(t)) {
-				_m[t].m2 = CalcClosestTownFromTile(t)->index;
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion52);
 	}
 
 	/* A setting containing the proportion of towns that grow twice as
@@ -1398,14 +1674,7 @@ bool AfterLoadGame()
 
 	if (CheckSavegameVersion(64)) {
 		/* copy the signal type/variant and move signal states bits */
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (IsTileType(t, MP_RAILWAY) && HasSignals(t)) {
-				SetSignalStates(t, GB(_m[t].m2, 4, 4));
-				SetSignalVariant(t, INVALID_TRACK, GetSignalVariant(t, TRACK_X));
-				SetSignalType(t, INVALID_TRACK, GetSignalType(t, TRACK_X));
-				ClrBit(_m[t].m2, 7);
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion64);
 	}
 
 	if (CheckSavegameVersion(69)) {
@@ -1427,14 +1696,7 @@ bool AfterLoadGame()
 	/* From version 82, old style canals (above sealevel (0), WATER owner) are no longer supported.
 	    Replace the owner for those by OWNER_NONE. */
 	if (CheckSavegameVersion(82)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (IsTileType(t, MP_WATER) &&
-					GetWaterTileType(t) == WATER_TILE_CLEAR &&
-					GetTileOwner(t) == OWNER_WATER &&
-					TileHeight(t) != 0) {
-				SetTileOwner(t, OWNER_NONE);
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion82);
 	}
 
 	/*
@@ -1444,11 +1706,7 @@ bool AfterLoadGame()
 	 * making floods using the removal of ship depots.
 	 */
 	if (CheckSavegameVersion(83)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (IsTileType(t, MP_WATER) && IsShipDepot(t)) {
-				_m[t].m4 = (TileHeight(t) == 0) ? OWNER_WATER : OWNER_NONE;
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion83);
 	}
 
 	if (CheckSavegameVersion(74)) {
@@ -1480,12 +1738,7 @@ bool AfterLoadGame()
 	 * land used to have zero density, now they have full density. Therefore,
 	 * make all grassy/rough land trees have a density of 3. */
 	if (CheckSavegameVersion(81)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (GetTileType(t) == MP_TREES) {
-				TreeGround groundType = (TreeGround)GB(_m[t].m2, 4, 2);
-				if (groundType != TREE_GROUND_SNOW_DESERT) SB(_m[t].m2, 6, 2, 3);
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion81);
 	}
 
 
@@ -1541,6 +1794,8 @@ bool AfterLoadGame()
 		}
 	}
 
+	RunTileConversions();
+
 	if (CheckSavegameVersion(86)) {
 		for (TileIndex t = 0; t < map_size; t++) {
 			/* Move river flag and update canals to use water class */
@@ -1641,11 +1896,7 @@ bool AfterLoadGame()
 
 	if (CheckSavegameVersion(91)) {
 		/* Increase HouseAnimationFrame from 5 to 7 bits */
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (IsTileType(t, MP_HOUSE) && GetHouseType(t) >= NEW_HOUSE_OFFSET) {
-				SetHouseAnimationFrame(t, GB(_m[t].m6, 3, 5));
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion91);
 	}
 
 	if (CheckSavegameVersion(62)) {
@@ -1663,66 +1914,18 @@ bool AfterLoadGame()
 	}
 
 	if (CheckSavegameVersion(99)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			/* Set newly introduced WaterClass of industry tiles */
-			if (IsTileType(t, MP_STATION) && IsOilRig(t)) {
-				SetWaterClassDependingOnSurroundings(t, true);
-			}
-			if (IsTileType(t, MP_INDUSTRY)) {
-				if ((GetIndustrySpec(GetIndustryType(t))->behaviour & INDUSTRYBEH_BUILT_ONWATER) != 0) {
-					SetWaterClassDependingOnSurroundings(t, true);
-				} else {
-					SetWaterClass(t, WATER_CLASS_INVALID);
-				}
-			}
-
-			/* Replace "house construction year" with "house age" */
-			if (IsTileType(t, MP_HOUSE) && IsHouseCompleted(t)) {
-				_m[t].m5 = Clamp(_cur_year - (_m[t].m5 + ORIGINAL_BASE_YEAR), 0, 0xFF);
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion99);
 	}
 
 	/* Move the signal variant back up one bit for PBS. We don't convert the old PBS
 	 * format here, as an old layout wouldn't work properly anyway. To be safe, we
 	 * clear any possible PBS reservations as well. */
 	if (CheckSavegameVersion(100)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			switch (GetTileType(t)) {
-				case MP_RAILWAY:
-					if (HasSignals(t)) {
-						/* move the signal variant */
-						SetSignalVariant(t, TRACK_UPPER, HasBit(_m[t].m2, 2) ? SIG_SEMAPHORE : SIG_ELECTRIC);
-						SetSignalVariant(t, TRACK_LOWER, HasBit(_m[t].m2, 6) ? SIG_SEMAPHORE : SIG_ELECTRIC);
-						ClrBit(_m[t].m2, 2);
-						ClrBit(_m[t].m2, 6);
-					}
-
-					/* Clear PBS reservation on track */
-					if (IsRailDepot(t)) {
-						SetDepotReservation(t, false);
-					} else {
-						SetTrackReservation(t, TRACK_BIT_NONE);
-					}
-					break;
-
-				case MP_ROAD: // Clear PBS reservation on crossing
-					if (IsLevelCrossing(t)) SetCrossingReservation(t, false);
-					break;
-
-				case MP_STATION: // Clear PBS reservation on station
-					if (HasStationRail(t)) SetRailStationReservation(t, false);
-					break;
-
-				case MP_TUNNELBRIDGE: // Clear PBS reservation on tunnels/birdges
-					if (GetTunnelBridgeTransportType(t) == TRANSPORT_RAIL) SetTunnelBridgeReservation(t, false);
-					break;
-
-				default: break;
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion100);
 	}
 
+	RunTileConversions();
+
 	/* Reserve all tracks trains are currently on. */
 	if (CheckSavegameVersion(101)) {
 		const Train *t;
@@ -1884,24 +2087,18 @@ bool AfterLoadGame()
 
 	if (CheckSavegameVersion(122)) {
 		/* Animated tiles would sometimes not be actually animated or
-		 * in case of old savegames duplicate. */
+		 * in case of old savegames duplicate. The duplicates are
+		 * already removed when loading the animated tile list. */
 
 		extern TileIndex *_animated_tile_list;
 		extern uint _animated_tile_count;
 
-		for (uint i = 0; i < _animated_tile_count; /* Nothing */) {
-			/* Remove if tile is not animated */
-			bool remove = _tile_type_procs[GetTileType(_animated_tile_list[i])]->animate_tile_proc == NULL;
+		for (uint i = 0; i < _animated_tile_count; i++) {
+			TileIndex tile = _animated_tile_list[i];
 
-			/* and remove if duplicate */
-			for (uint j = 0; !remove && j < i; j++) {
-				remove = _animated_tile_list[i] == _animated_tile_list[j];
-			}
-
-			if (remove) {
-				DeleteAnimatedTile(_animated_tile_list[i]);
-			} else {
-				i++;
+			/* Remove if tile is not animated; this only leaves a hole in the list */
+			if (tile != INVALID_TILE && _tile_type_procs[GetTileType(tile)]->animate_tile_proc == NULL) {
+				DeleteAnimatedTile(tile);
 			}
 		}
 	}
@@ -2027,22 +2224,7 @@ bool AfterLoadGame()
 	/* The bits for the tree ground and tree density have
 	 * been swapped (m2 bits 7..6 and 5..4. */
 	if (CheckSavegameVersion(135)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (IsTileType(t, MP_CLEAR)) {
-				if (GetRawClearGround(t) == CLEAR_SNOW) {
-					SetClearGroundDensity(t, CLEAR_GRASS, GetClearDensity(t));
-					SetBit(_m[t].m3, 4);
-				} else {
-					ClrBit(_m[t].m3, 4);
-				}
-			}
-			if (IsTileType(t, MP_TREES)) {
-				uint density = GB(_m[t].m2, 6, 2);
-				uint ground = GB(_m[t].m2, 4, 2);
-				uint counter = GB(_m[t].m2, 0, 4);
-				_m[t].m2 = ground << 6 | density << 4 | counter;
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion135);
 	}
 
 	/* Wait counter and load/unload ticks got split. */
@@ -2060,39 +2242,7 @@ bool AfterLoadGame()
 
 	/* Airport tile animation uses animation frame instead of other graphics id */
 	if (CheckSavegameVersion(137)) {
-		struct AirportTileConversion {
-			byte old_start;
-			byte num_frames;
-		};
-		static const AirportTileConversion atc[] = {
-			{31,  12}, // APT_RADAR_GRASS_FENCE_SW
-			{50,   4}, // APT_GRASS_FENCE_NE_FLAG
-			{62,   2}, // 1 unused tile
-			{66,  12}, // APT_RADAR_FENCE_SW
-			{78,  12}, // APT_RADAR_FENCE_NE
-			{101, 10}, // 9 unused tiles
-			{111,  8}, // 7 unused tiles
-			{119, 15}, // 14 unused tiles (radar)
-			{140,  4}, // APT_GRASS_FENCE_NE_FLAG_2
-		};
-		for (TileIndex t = 0; t < map_size; t++) {
-			if (IsAirportTile(t)) {
-				StationGfx old_gfx = GetStationGfx(t);
-				byte offset = 0;
-				for (uint i = 0; i < lengthof(atc); i++) {
-					if (old_gfx < atc[i].old_start) {
-						SetStationGfx(t, old_gfx - offset);
-						break;
-					}
-					if (old_gfx < atc[i].old_start + atc[i].num_frames) {
-						SetStationAnimationFrame(t, old_gfx - atc[i].old_start);
-						SetStationGfx(t, atc[i].old_start - offset);
-						break;
-					}
-					offset += atc[i].num_frames - 1;
-				}
-			}
-		}
+		AddTileConversion(&ConvertTileToVersion137);
 	}
 
 	if (CheckSavegameVersion(139)) {
@@ -2120,10 +2270,7 @@ bool AfterLoadGame()
 	}
 
 	if (CheckSavegameVersion(141)) {
-		for (TileIndex t = 0; t < map_size; t++) {
-			/* Reset tropic zone for VOID tiles, they shall not have any. */
-			if (IsTileType(t, MP_VOID)) SetTropicZone(t, TROPICZONE_NORMAL);
-		}
+		AddTileConversion(&ConvertTileToVersion141);
 
 		/* We need to properly number/name the depots.
 		 * The first step is making sure none of the depots uses the
@@ -2139,6 +2286,16 @@ bool AfterLoadGame()
 		FOR_ALL_DEPOTS(d) d->build_date = _date;
 	}
 
+	if (CheckSavegameVersion(149)) {
+		/* Smoke and sparks are particles outside of the game state now. */
+		EffectVehicle *v;
+		FOR_ALL_EFFECTVEHICLES(v) {
+			if (v->subtype < EV_END_PARTICLE) delete v;
+		}
+	}
+
+	RunTileConversions();
+
 	/* Road stops is 'only' updating some caches */
 	AfterLoadRoadStops();
 	AfterLoadLabelMaps();
@@ -2148,6 +2305,8 @@ bool AfterLoadGame()
 	InitializeWindowsAndCaches();
 	/* Restore the signals */
 	ResetSignalHandlers();
+	/* Converting the map didn't change any road vehicle its path. */
+	ForgetRoadLayoutChanges();
 	return true;
 }
 
@@ -2172,6 +2331,8 @@ void ReloadNewGRFData()
 	AfterLoadStations();
 	/* Check and update house and town values */
 	UpdateHousesAndTowns();
+	/* The acceptance of houses and industry tiles may have changed */
+	InvalidateAllCatchmentCaches();
 	/* Update livery selection windows */
 	for (CompanyID i = COMPANY_FIRST; i < MAX_COMPANIES; i++) InvalidateWindowData(WC_COMPANY_COLOUR, i);
 	/* redraw the whole screen */
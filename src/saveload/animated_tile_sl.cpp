@@ -18,12 +18,16 @@
 extern TileIndex *_animated_tile_list;
 extern uint _animated_tile_count;
 extern uint _animated_tile_allocated;
+extern void RebuildAnimatedTileList();
 
 /**
  * Save the ANIT chunk.
  */
 static void Save_ANIT()
 {
+	/* Do not save the holes left by removed tiles. */
+	RebuildAnimatedTileList();
+
 	SlSetLength(_animated_tile_count * sizeof(*_animated_tile_list));
 	SlArray(_animated_tile_list, _animated_tile_count, SLE_UINT32);
 }
@@ -41,6 +45,7 @@ static void Load_ANIT()
 		for (_animated_tile_count = 0; _animated_tile_count < 256; _animated_tile_count++) {
 			if (_animated_tile_list[_animated_tile_count] == 0) break;
 		}
+		RebuildAnimatedTileList();
 		return;
 	}
 
@@ -52,6 +57,7 @@ static void Load_ANIT()
 
 	_animated_tile_list = ReallocT<TileIndex>(_animated_tile_list, _animated_tile_allocated);
 	SlArray(_animated_tile_list, _animated_tile_count, SLE_UINT32);
+	RebuildAnimatedTileList();
 }
 
 /**
@@ -103,11 +103,15 @@ const SaveLoad *GetCargoPacketDesc()
 
 static void Save_CAPA()
 {
+	/* The packets in vehicles have to show their real age. */
+	Vehicle *v;
+	FOR_ALL_VEHICLES(v) v->cargo.ApplyAge();
+
 	CargoPacket *cp;
 
 	FOR_ALL_CARGOPACKETS(cp) {
 		SlSetArrayIndex(cp->index);
-		SlObject(cp, GetCargoPacketDesc());
+		SlCompiledObject(cp, GetCargoPacketDesc());
 	}
 }
 
@@ -117,7 +121,7 @@ static void Load_CAPA()
 
 	while ((index = SlIterateArray()) != -1) {
 		CargoPacket *cp = new (index) CargoPacket();
-		SlObject(cp, GetCargoPacketDesc());
+		SlCompiledObject(cp, GetCargoPacketDesc());
 	}
 }
 
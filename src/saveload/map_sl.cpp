@@ -48,153 +48,148 @@ static void Check_MAPS()
 
 static const uint MAP_SL_BUF_SIZE = 4096;
 
-static void Load_MAPT()
+#ifdef WITH_MAP_PLANES
+/** The field of the first tile and the distance in bytes to the same field of the next tile. */
+# define MAP_FIELD(field) _m.field, sizeof(*_m.field)
+#else
+/** The field of the first tile and the distance in bytes to the same field of the next tile. */
+# define MAP_FIELD(field) &_m[0].field, sizeof(Tile)
+#endif /* WITH_MAP_PLANES */
+
+/*
+ * Since savegame version 150 the fields of all tiles but those of the first
+ * row are stored XOR-ed with the field of the tile in the previous row. The
+ * map has large areas where a field is the same, like sea and farmland, so
+ * this makes for long runs of zeros that compress faster and better.
+ */
+
+/**
+ * Load a field of all tiles. When the field of every tile is stored next
+ * to the one of the previous tile it is loaded straight into the map,
+ * otherwise it is passed through a buffer.
+ * @param first  the field of the first tile
+ * @param stride the distance in bytes to the same field of the next tile
+ * @param conv   the type of the field in the savegame and in memory
+ */
+template <typename T>
+static void LoadMapField(T *first, size_t stride, VarType conv)
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
 
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].type_height = buf[j];
+	if (stride == sizeof(T)) {
+		SlArray(first, size, conv);
+	} else {
+		SmallStackSafeStackAlloc<T, MAP_SL_BUF_SIZE> buf;
+		byte *p = (byte *)first;
+		for (TileIndex i = 0; i != size; i += MAP_SL_BUF_SIZE) {
+			SlArray(buf, MAP_SL_BUF_SIZE, conv);
+			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++, p += stride) *(T *)p = buf[j];
+		}
 	}
+
+	if (CheckSavegameVersion(150)) return;
+
+	/* Undo the XOR with the previous row; that row has been restored already. */
+	size_t row = MapSizeX() * stride;
+	byte *end = (byte *)first + size * stride;
+	for (byte *p = (byte *)first + row; p != end; p += stride) *(T *)p ^= *(const T *)(p - row);
 }
 
-static void Save_MAPT()
+/**
+ * Save a field of all tiles, the counterpart of #LoadMapField.
+ * @param first  the field of the first tile
+ * @param stride the distance in bytes to the same field of the next tile
+ * @param conv   the type of the field in the savegame and in memory
+ */
+template <typename T>
+static void SaveMapField(T *first, size_t stride, VarType conv)
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
 
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].type_height;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
+	SlSetLength(size * sizeof(T));
+
+	/* The first row is stored as it is, all others XOR-ed with the previous row. */
+	size_t row = MapSizeX() * stride;
+	SmallStackSafeStackAlloc<T, MAP_SL_BUF_SIZE> buf;
+	const byte *p = (const byte *)first;
+	const byte *first_delta = p + row;
+	for (TileIndex i = 0; i != size; i += MAP_SL_BUF_SIZE) {
+		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++, p += stride) {
+			buf[j] = (p < first_delta) ? *(const T *)p : (T)(*(const T *)p ^ *(const T *)(p - row));
+		}
+		SlArray(buf, MAP_SL_BUF_SIZE, conv);
 	}
 }
 
-static void Load_MAP1()
+static void Load_MAPT()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
+	LoadMapField(MAP_FIELD(type_height), SLE_UINT8);
+}
 
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m1 = buf[j];
-	}
+static void Save_MAPT()
+{
+	SaveMapField(MAP_FIELD(type_height), SLE_UINT8);
 }
 
-static void Save_MAP1()
+static void Load_MAP1()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
+	LoadMapField(MAP_FIELD(m1), SLE_UINT8);
+}
 
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m1;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+static void Save_MAP1()
+{
+	SaveMapField(MAP_FIELD(m1), SLE_UINT8);
 }
 
 static void Load_MAP2()
 {
-	SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE,
-			/* In those versions the m2 was 8 bits */
-			CheckSavegameVersion(5) ? SLE_FILE_U8 | SLE_VAR_U16 : SLE_UINT16
-		);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m2 = buf[j];
-	}
+	LoadMapField(MAP_FIELD(m2),
+		/* In those versions the m2 was 8 bits */
+		CheckSavegameVersion(5) ? SLE_FILE_U8 | SLE_VAR_U16 : SLE_UINT16
+	);
 }
 
 static void Save_MAP2()
 {
-	SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size * sizeof(uint16));
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m2;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT16);
-	}
+	SaveMapField(MAP_FIELD(m2), SLE_UINT16);
 }
 
 static void Load_MAP3()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m3 = buf[j];
-	}
+	LoadMapField(MAP_FIELD(m3), SLE_UINT8);
 }
 
 static void Save_MAP3()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m3;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField(MAP_FIELD(m3), SLE_UINT8);
 }
 
 static void Load_MAP4()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m4 = buf[j];
-	}
+	LoadMapField(MAP_FIELD(m4), SLE_UINT8);
 }
 
 static void Save_MAP4()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m4;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField(MAP_FIELD(m4), SLE_UINT8);
 }
 
 static void Load_MAP5()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m5 = buf[j];
-	}
+	LoadMapField(MAP_FIELD(m5), SLE_UINT8);
 }
 
 static void Save_MAP5()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m5;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField(MAP_FIELD(m5), SLE_UINT8);
 }
 
 static void Load_MAP6()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
 	if (CheckSavegameVersion(42)) {
+		SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
+		TileIndex size = MapSize();
+
 		for (TileIndex i = 0; i != size;) {
 			/* 1024, otherwise we overflow on 64x64 maps! */
 			SlArray(buf, 1024, SLE_UINT8);
@@ -206,46 +201,23 @@ static void Load_MAP6()
 			}
 		}
 	} else {
-		for (TileIndex i = 0; i != size;) {
-			SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m6 = buf[j];
-		}
+		LoadMapField(MAP_FIELD(m6), SLE_UINT8);
 	}
 }
 
 static void Save_MAP6()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m6;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField(MAP_FIELD(m6), SLE_UINT8);
 }
 
 static void Load_MAP7()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _me[i++].m7 = buf[j];
-	}
+	LoadMapField(&_me[0].m7, sizeof(TileExtended), SLE_UINT8);
 }
 
 static void Save_MAP7()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _me[i++].m7;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField(&_me[0].m7, sizeof(TileExtended), SLE_UINT8);
 }
 
 extern const ChunkHandler _map_chunk_handlers[] = {
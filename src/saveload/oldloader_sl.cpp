@@ -45,7 +45,7 @@ void FixOldMapArray()
 {
 	/* TTO/TTD/TTDP savegames could have buoys at tile 0
 	 * (without assigned station struct) */
-	MemSetT(&_m[0], 0);
+	ClearTiles(0, 1);
 	SetTileType(0, MP_WATER);
 	SetTileOwner(0, OWNER_WATER);
 }
@@ -480,6 +480,7 @@ static inline uint RemapOrderIndex(uint x)
 
 extern TileIndex *_animated_tile_list;
 extern uint _animated_tile_count;
+extern void RebuildAnimatedTileList();
 extern char *_old_name_array;
 
 static byte   _old_vehicle_multiplier;
@@ -645,6 +646,7 @@ static bool LoadOldAnimTileList(LoadgameState *ls, int num)
 	for (_animated_tile_count = 0; _animated_tile_count < 256; _animated_tile_count++) {
 		if (_animated_tile_list[_animated_tile_count] == 0) break;
 	}
+	RebuildAnimatedTileList();
 
 	return true;
 }
@@ -1453,8 +1455,7 @@ static bool LoadOldGameDifficulty(LoadgameState *ls, int num)
 static bool LoadOldMapPart1(LoadgameState *ls, int num)
 {
 	if (_savegame_type == SGT_TTO) {
-		MemSetT(_m, 0, OLD_MAP_SIZE);
-		MemSetT(_me, 0, OLD_MAP_SIZE);
+		ClearTiles(0, OLD_MAP_SIZE);
 	}
 
 	for (uint i = 0; i < OLD_MAP_SIZE; i++) {
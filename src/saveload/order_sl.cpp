@@ -119,7 +119,7 @@ static void Save_ORDR()
 
 	FOR_ALL_ORDERS(order) {
 		SlSetArrayIndex(order->index);
-		SlObject(order, GetOrderDescription());
+		SlCompiledObject(order, GetOrderDescription());
 	}
 }
 
@@ -175,7 +175,7 @@ static void Load_ORDR()
 
 		while ((index = SlIterateArray()) != -1) {
 			Order *order = new (index) Order();
-			SlObject(order, GetOrderDescription());
+			SlCompiledObject(order, GetOrderDescription());
 		}
 	}
 }
@@ -208,7 +208,7 @@ static void Save_ORDL()
 
 	FOR_ALL_ORDER_LISTS(list) {
 		SlSetArrayIndex(list->index);
-		SlObject(list, GetOrderListDescription());
+		SlCompiledObject(list, GetOrderListDescription());
 	}
 }
 
@@ -219,7 +219,7 @@ static void Load_ORDL()
 	while ((index = SlIterateArray()) != -1) {
 		/* set num_orders to 0 so it's a valid OrderList */
 		OrderList *list = new (index) OrderList(0);
-		SlObject(list, GetOrderListDescription());
+		SlCompiledObject(list, GetOrderListDescription());
 	}
 
 }
@@ -0,0 +1,52 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pbs_sl.cpp Code handling saving and loading of the owners of the track reservations */
+
+#include "../stdafx.h"
+#include "../pbs.h"
+#include "../core/smallvec_type.hpp"
+
+#include "saveload.h"
+
+extern void GetReservationOwners(SmallVector<ReservationOwner, 64> &owners);
+extern void LoadReservationOwner(const ReservationOwner &owner);
+
+static const SaveLoad _reservation_owner_desc[] = {
+	SLE_VAR(ReservationOwner, tile,  SLE_UINT32),
+	SLE_VAR(ReservationOwner, track, SLE_UINT8),
+	SLE_VAR(ReservationOwner, train, SLE_UINT16),
+	SLE_END()
+};
+
+/** Save the trains that made the reservations. */
+static void Save_PBSO()
+{
+	SmallVector<ReservationOwner, 64> owners;
+	GetReservationOwners(owners);
+
+	for (uint i = 0; i < owners.Length(); i++) {
+		SlSetArrayIndex(i);
+		SlObject(&owners[i], _reservation_owner_desc);
+	}
+}
+
+/** Load the trains that made the reservations. */
+static void Load_PBSO()
+{
+	ReservationOwner owner;
+	while (SlIterateArray() != -1) {
+		SlObject(&owner, _reservation_owner_desc);
+		LoadReservationOwner(owner);
+	}
+}
+
+extern const ChunkHandler _pbs_chunk_handlers[] = {
+	{ 'PBSO', Save_PBSO, Load_PBSO, NULL, NULL, CH_ARRAY | CH_LAST},
+};
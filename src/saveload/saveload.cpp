@@ -16,7 +16,8 @@
  * <li>use their description array (SaveLoad) to know what elements to save and in what version
  *    of the game it was active (used when loading)
  * <li>write all data byte-by-byte to the temporary buffer so it is endian-safe
- * <li>when the buffer is full; flush it to the output (eg save to file) (_sl.buf, _sl.bufp, _sl.bufe)
+ * <li>when the buffer is full; flush it to the output (eg save to file) (_sl.buf, _sl.bufp, _sl.bufe);
+ *     when possible a separate thread compresses and writes the full buffers while the next ones are filled
  * <li>repeat this until everything is done, and flush any remaining output to file
  * </ol>
  */
@@ -41,12 +42,33 @@
 #include "../engine_base.h"
 #include "../company_base.h"
 #include "../fios.h"
+#include "../settings_type.h"
+#include "../console_func.h"
+#include "../pathfinder/pf_performance_timer.hpp"
+#include "../timeline.h"
+#include "../3rdparty/md5/md5.h"
 
 #include "table/strings.h"
 
 #include "saveload_internal.h"
 
-extern const uint16 SAVEGAME_VERSION = 143;
+#if defined(UNIX) && !defined(__MORPHOS__)
+/* Savegames are read from a mapping of the file into memory. */
+#	define WITH_MAPPED_LOAD
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
+#if defined(UNIX) && !defined(__MORPHOS__) && !defined(__APPLE__)
+/* Autosaves can be written by a copy of the process made with fork. */
+#	define WITH_SNAPSHOT_SAVE
+#	include <sys/types.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+#	include <errno.h>
+#endif
+
+extern const uint16 SAVEGAME_VERSION = 152;
 
 SavegameType _savegame_type; ///< type of savegame we are loading
 
@@ -131,14 +153,23 @@ extern const ChunkHandler _cargopacket_chunk_handlers[];
 extern const ChunkHandler _autoreplace_chunk_handlers[];
 extern const ChunkHandler _labelmaps_chunk_handlers[];
 extern const ChunkHandler _airport_chunk_handlers[];
+extern const ChunkHandler _pbs_chunk_handlers[];
 
+/**
+ * The chunk handlers in the order their chunks are saved. The chunks that
+ * are needed to check a savegame come first, so checking can stop before
+ * the big chunks like the map; see SlLoadCheckChunks. Loading doesn't
+ * depend on the order.
+ */
 static const ChunkHandler * const _chunk_handlers[] = {
 	_gamelog_chunk_handlers,
-	_map_chunk_handlers,
 	_misc_chunk_handlers,
+	_setting_chunk_handlers,
+	_company_chunk_handlers,
+	_newgrf_chunk_handlers,
+	_map_chunk_handlers,
 	_name_chunk_handlers,
 	_cheat_chunk_handlers,
-	_setting_chunk_handlers,
 	_veh_chunk_handlers,
 	_waypoint_chunk_handlers,
 	_depot_chunk_handlers,
@@ -150,15 +181,14 @@ static const ChunkHandler * const _chunk_handlers[] = {
 	_town_chunk_handlers,
 	_sign_chunk_handlers,
 	_station_chunk_handlers,
-	_company_chunk_handlers,
 	_ai_chunk_handlers,
 	_animated_tile_chunk_handlers,
-	_newgrf_chunk_handlers,
 	_group_chunk_handlers,
 	_cargopacket_chunk_handlers,
 	_autoreplace_chunk_handlers,
 	_labelmaps_chunk_handlers,
 	_airport_chunk_handlers,
+	_pbs_chunk_handlers,
 	NULL,
 };
 
@@ -217,6 +247,11 @@ static void NORETURN SlError(StringID string, const char *extra_msg = NULL)
 typedef void (*AsyncSaveFinishProc)();
 static AsyncSaveFinishProc _async_save_finish = NULL;
 static ThreadObject *_save_thread;
+static ThreadMutex *_save_queue_mutex; ///< Guards the chunks waiting for #_save_thread; NULL when saving without a save thread.
+
+#ifdef WITH_SNAPSHOT_SAVE
+static void FinishSnapshotSave(bool wait);
+#endif
 
 /**
  * Called by save thread to tell we finished saving.
@@ -234,6 +269,10 @@ static void SetAsyncSaveFinish(AsyncSaveFinishProc proc)
  */
 void ProcessAsyncSaveFinish()
 {
+#ifdef WITH_SNAPSHOT_SAVE
+	FinishSnapshotSave(false);
+#endif
+
 	if (_async_save_finish == NULL) return;
 
 	_async_save_finish();
@@ -244,6 +283,8 @@ void ProcessAsyncSaveFinish()
 		_save_thread->Join();
 		delete _save_thread;
 		_save_thread = NULL;
+		delete _save_queue_mutex;
+		_save_queue_mutex = NULL;
 	}
 }
 
@@ -471,6 +512,7 @@ void SlSetArrayIndex(uint index)
 }
 
 static size_t _next_offs;
+static uint _chunk_objects; ///< The number of objects saved or loaded of the current chunk, for the chunk statistics.
 
 /**
  * Iterate through the elements of an array and read the whole thing
@@ -502,7 +544,10 @@ int SlIterateArray()
 				return -1; // error
 		}
 
-		if (length != 0) return index;
+		if (length != 0) {
+			_chunk_objects++;
+			return index;
+		}
 	}
 }
 
@@ -537,12 +582,14 @@ void SlSetLength(size_t length)
 					SlWriteUint32((uint32)((length & 0xFFFFFF) | ((length >> 24) << 28)));
 					break;
 				case CH_ARRAY:
+					_chunk_objects++;
 					assert(_sl.last_array_index <= _sl.array_index);
 					while (++_sl.last_array_index <= _sl.array_index)
 						SlWriteArrayLength(1);
 					SlWriteArrayLength(length + 1);
 					break;
 				case CH_SPARSE_ARRAY:
+					_chunk_objects++;
 					SlWriteArrayLength(length + 1 + SlGetArrayLength(_sl.array_index)); // Also include length of sparse index.
 					SlWriteSparseIndex(_sl.array_index);
 					break;
@@ -568,13 +615,28 @@ static void SlCopyBytes(void *ptr, size_t length)
 {
 	byte *p = (byte *)ptr;
 
+	/* Copy as much as fits in the buffer at once, straight from or to the buffer. */
 	switch (_sl.action) {
 		case SLA_LOAD_CHECK:
 		case SLA_LOAD:
-			for (; length != 0; length--) { *p++ = SlReadByteInternal(); }
+			while (length != 0) {
+				if (_sl.bufp == _sl.bufe) SlReadFill();
+				size_t n = min<size_t>(length, _sl.bufe - _sl.bufp);
+				memcpy(p, _sl.bufp, n);
+				_sl.bufp += n;
+				p += n;
+				length -= n;
+			}
 			break;
 		case SLA_SAVE:
-			for (; length != 0; length--) { SlWriteByteInternal(*p++); }
+			while (length != 0) {
+				if (_sl.bufp == _sl.bufe) SlWriteFill();
+				size_t n = min<size_t>(length, _sl.bufe - _sl.bufp);
+				memcpy(_sl.bufp, p, n);
+				_sl.bufp += n;
+				p += n;
+				length -= n;
+			}
 			break;
 		default: NOT_REACHED();
 	}
@@ -843,6 +905,11 @@ void SlArray(void *array, size_t length, VarType conv)
 	 * conversion is needed, use specialized copy-copy function to speed up things */
 	if (conv == SLE_INT8 || conv == SLE_UINT8) {
 		SlCopyBytes(array, length);
+#if TTD_ENDIAN == TTD_BIG_ENDIAN
+	} else if (conv == SLE_INT16 || conv == SLE_UINT16 || conv == SLE_INT32 || conv == SLE_UINT32 || conv == SLE_INT64 || conv == SLE_UINT64) {
+		/* Savegames are big endian too, so these are the same in file and memory. */
+		SlCopyBytes(array, length * SlCalcConvMemLen(conv));
+#endif /* TTD_ENDIAN == TTD_BIG_ENDIAN */
 	} else {
 		byte *a = (byte*)array;
 		byte mem_size = SlCalcConvMemLen(conv);
@@ -861,11 +928,13 @@ static void *IntToReference(size_t index, SLRefType rt);
 
 /**
  * Return the size in bytes of a list
- * @param list The std::list to find the size of
+ * @tparam PtrList The kind of container, std::list or std::deque of pointers
+ * @param list The list to find the size of
  */
+template <typename PtrList>
 static inline size_t SlCalcListLen(const void *list)
 {
-	std::list<void *> *l = (std::list<void *> *) list;
+	const PtrList *l = (const PtrList *) list;
 
 	int type_size = CheckSavegameVersion(69) ? 2 : 4;
 	/* Each entry is saved as type_size bytes, plus type_size bytes are used for the length
@@ -875,27 +944,28 @@ static inline size_t SlCalcListLen(const void *list)
 
 
 /**
- * Save/Load a list.
+ * Save/Load a list. The std::list and std::deque variants are stored the same way.
+ * @tparam PtrList The kind of container, std::list or std::deque of pointers
  * @param list The list being manipulated
  * @param conv SLRefType type of the list (Vehicle *, Station *, etc)
  */
+template <typename PtrList>
 static void SlList(void *list, SLRefType conv)
 {
 	/* Automatically calculate the length? */
 	if (_sl.need_length != NL_NONE) {
-		SlSetLength(SlCalcListLen(list));
+		SlSetLength(SlCalcListLen<PtrList>(list));
 		/* Determine length only? */
 		if (_sl.need_length == NL_CALCLENGTH) return;
 	}
 
-	typedef std::list<void *> PtrList;
 	PtrList *l = (PtrList *)list;
 
 	switch (_sl.action) {
 		case SLA_SAVE: {
 			SlWriteUint32((uint32)l->size());
 
-			PtrList::iterator iter;
+			typename PtrList::iterator iter;
 			for (iter = l->begin(); iter != l->end(); ++iter) {
 				void *ptr = *iter;
 				SlWriteUint32((uint32)ReferenceToInt(ptr, conv));
@@ -917,7 +987,7 @@ static void SlList(void *list, SLRefType conv)
 			PtrList temp = *l;
 
 			l->clear();
-			PtrList::iterator iter;
+			typename PtrList::iterator iter;
 			for (iter = temp.begin(); iter != temp.end(); ++iter) {
 				void *ptr = IntToReference((size_t)*iter, conv);
 				l->push_back(ptr);
@@ -981,6 +1051,7 @@ size_t SlCalcObjMemberLength(const void *object, const SaveLoad *sld)
 		case SL_ARR:
 		case SL_STR:
 		case SL_LST:
+		case SL_DEQ:
 			/* CONDITIONAL saveload types depend on the savegame version */
 			if (!SlIsObjectValidInSavegame(sld)) break;
 
@@ -989,7 +1060,8 @@ size_t SlCalcObjMemberLength(const void *object, const SaveLoad *sld)
 				case SL_REF: return SlCalcRefLen();
 				case SL_ARR: return SlCalcArrayLen(sld->length, sld->conv);
 				case SL_STR: return SlCalcStringLen(GetVariableAddress(object, sld), sld->length, sld->conv);
-				case SL_LST: return SlCalcListLen(GetVariableAddress(object, sld));
+				case SL_LST: return SlCalcListLen<std::list<void *> >(GetVariableAddress(object, sld));
+				case SL_DEQ: return SlCalcListLen<std::deque<void *> >(GetVariableAddress(object, sld));
 				default: NOT_REACHED();
 			}
 			break;
@@ -1011,6 +1083,7 @@ bool SlObjectMember(void *ptr, const SaveLoad *sld)
 		case SL_ARR:
 		case SL_STR:
 		case SL_LST:
+		case SL_DEQ:
 			/* CONDITIONAL saveload types depend on the savegame version */
 			if (!SlIsObjectValidInSavegame(sld)) return false;
 			if (SlSkipVariableOnLoad(sld)) return false;
@@ -1037,7 +1110,8 @@ bool SlObjectMember(void *ptr, const SaveLoad *sld)
 					break;
 				case SL_ARR: SlArray(ptr, sld->length, conv); break;
 				case SL_STR: SlString(ptr, sld->length, conv); break;
-				case SL_LST: SlList(ptr, (SLRefType)conv); break;
+				case SL_LST: SlList<std::list<void *> >(ptr, (SLRefType)conv); break;
+				case SL_DEQ: SlList<std::deque<void *> >(ptr, (SLRefType)conv); break;
 				default: NOT_REACHED();
 			}
 			break;
@@ -1091,6 +1165,304 @@ void SlObject(void *object, const SaveLoad *sld)
 	}
 }
 
+/** Kinds of operations of a compiled SaveLoad description. */
+enum SlCompiledOpType {
+	SCO_RUN,    ///< A run of numeric variables of the same type.
+	SCO_MEMBER, ///< Any other member, which is handled by #SlObjectMember.
+};
+
+/** An operation of a compiled SaveLoad description. */
+struct SlCompiledOp {
+	SlCompiledOpType type; ///< The kind of operation.
+	VarType conv;          ///< For runs the type of the variables.
+	uint count;            ///< For runs the number of variables.
+	uint first;            ///< For runs the first offset in SlCompiledDesc::offsets, else the index in SlCompiledDesc::members.
+};
+
+/**
+ * A SaveLoad description resolved for the version and the action of the
+ * current save or load: members that aren't in the savegame are removed,
+ * the includes are expanded and consecutive numeric variables of the same
+ * type are merged into runs, which are saved and loaded in one go.
+ */
+struct SlCompiledDesc {
+	const SaveLoad *sld;                      ///< The description that is compiled.
+	SaveLoadAction action;                    ///< The action it is compiled for.
+	size_t length;                            ///< The length in the savegame of the members of which it doesn't depend on the object.
+	bool variable_length;                     ///< Whether there are strings or lists, of which the length depends on the object.
+	SmallVector<SlCompiledOp, 16> ops;        ///< The operations.
+	SmallVector<uint, 64> offsets;            ///< The offsets of the variables of the runs.
+	SmallVector<const SaveLoad *, 16> members; ///< The members that aren't in a run.
+};
+
+/** Maximum number of descriptions that are compiled during one save or load. */
+static const uint MAX_COMPILED_DESCS = 32;
+
+static SlCompiledDesc _sl_compiled[MAX_COMPILED_DESCS]; ///< The descriptions compiled during the current save or load.
+static uint _sl_compiled_count;                         ///< The number of used entries of #_sl_compiled.
+static SlCompiledDesc *_sl_compiled_last;               ///< The description that was used last.
+
+/** Forget the compiled descriptions; e.g. as the savegame version changes. */
+static void SlResetCompiledDescs()
+{
+	_sl_compiled_count = 0;
+	_sl_compiled_last = NULL;
+}
+
+/**
+ * Add the members of a description to a compiled description.
+ * @param desc the compiled description
+ * @param sld  the members to add
+ */
+static void SlCompileMembers(SlCompiledDesc *desc, const SaveLoad *sld)
+{
+	for (; sld->cmd != SL_END; sld++) {
+		switch (sld->cmd) {
+			case SL_VEH_INCLUDE: SlCompileMembers(desc, GetVehicleDescription(VEH_END)); continue;
+			case SL_ST_INCLUDE:  SlCompileMembers(desc, GetBaseStationDescription()); continue;
+			case SL_WRITEBYTE:   desc->length++; break;
+
+			default:
+				if (!SlIsObjectValidInSavegame(sld)) continue;
+				switch (sld->cmd) {
+					case SL_VAR: desc->length += SlCalcConvFileLen(sld->conv); break;
+					case SL_REF: desc->length += SlCalcRefLen(); break;
+					case SL_ARR: desc->length += SlCalcArrayLen(sld->length, sld->conv); break;
+					default:     desc->variable_length = true; break;
+				}
+				break;
+		}
+
+		VarType conv = GB(sld->conv, 0, 8);
+		bool runnable = sld->cmd == SL_VAR && !sld->global && (sld->conv & SLF_NETWORK_NO) == 0 &&
+				IsNumericType(conv) && GetVarFileType(conv) != SLE_FILE_STRINGID;
+
+		if (runnable) {
+			SlCompiledOp *last = desc->ops.Length() == 0 ? NULL : desc->ops.End() - 1;
+			if (last != NULL && last->type == SCO_RUN && last->conv == conv) {
+				last->count++;
+			} else {
+				SlCompiledOp *op = desc->ops.Append();
+				op->type = SCO_RUN;
+				op->conv = conv;
+				op->count = 1;
+				op->first = desc->offsets.Length();
+			}
+			*desc->offsets.Append() = (uint)(size_t)sld->address;
+		} else {
+			SlCompiledOp *op = desc->ops.Append();
+			op->type = SCO_MEMBER;
+			op->first = desc->members.Length();
+			*desc->members.Append() = sld;
+		}
+	}
+}
+
+/**
+ * Get the compiled version of a description, compiling it if needed.
+ * @param sld the description
+ * @return the compiled description, or NULL if it can't be compiled
+ */
+static const SlCompiledDesc *SlGetCompiledDesc(const SaveLoad *sld)
+{
+	if (_sl_compiled_last != NULL && _sl_compiled_last->sld == sld && _sl_compiled_last->action == _sl.action) return _sl_compiled_last;
+
+	for (uint i = 0; i < _sl_compiled_count; i++) {
+		if (_sl_compiled[i].sld == sld && _sl_compiled[i].action == _sl.action) {
+			_sl_compiled_last = &_sl_compiled[i];
+			return _sl_compiled_last;
+		}
+	}
+	if (_sl_compiled_count == MAX_COMPILED_DESCS) return NULL;
+
+	SlCompiledDesc *desc = &_sl_compiled[_sl_compiled_count++];
+	desc->sld = sld;
+	desc->action = _sl.action;
+	desc->length = 0;
+	desc->variable_length = false;
+	desc->ops.Clear();
+	desc->offsets.Clear();
+	desc->members.Clear();
+	SlCompileMembers(desc, sld);
+
+	_sl_compiled_last = desc;
+	return desc;
+}
+
+/**
+ * Check whether a value fits in the type it is saved as.
+ * @param x        the value
+ * @param filetype the type in the savegame
+ * @return true if the value fits
+ */
+static inline bool SlValueFits(int64 x, VarType filetype)
+{
+	switch (filetype) {
+		case SLE_FILE_I8:  return x >= -128 && x <= 127;
+		case SLE_FILE_U8:  return x >= 0 && x <= 255;
+		case SLE_FILE_I16: return x >= -32768 && x <= 32767;
+		case SLE_FILE_U16: return x >= 0 && x <= 65535;
+		default:           return true;
+	}
+}
+
+/**
+ * Write a run of variables straight into the savegame buffer.
+ * @param p        where to write to; there must be room for all variables
+ * @param object   the object the variables are part of
+ * @param offsets  the offsets of the variables in the object
+ * @param count    the number of variables
+ * @param filetype the type of the variables in the savegame
+ */
+template <typename T>
+static void SlSaveRun(byte *p, const byte *object, const uint *offsets, uint count, VarType filetype)
+{
+	for (uint i = 0; i < count; i++) {
+		T value = *(const T *)(object + offsets[i]);
+		assert(SlValueFits((int64)value, filetype));
+		uint64 x = (uint64)(int64)value;
+		switch (filetype) {
+			case SLE_FILE_I8:
+			case SLE_FILE_U8:
+				*p++ = (byte)x;
+				break;
+			case SLE_FILE_I16:
+			case SLE_FILE_U16:
+				p[0] = (byte)(x >> 8); p[1] = (byte)x;
+				p += 2;
+				break;
+			case SLE_FILE_I32:
+			case SLE_FILE_U32:
+				p[0] = (byte)(x >> 24); p[1] = (byte)(x >> 16); p[2] = (byte)(x >> 8); p[3] = (byte)x;
+				p += 4;
+				break;
+			case SLE_FILE_I64:
+			case SLE_FILE_U64:
+				for (uint j = 0; j < 8; j++) p[j] = (byte)(x >> (56 - 8 * j));
+				p += 8;
+				break;
+			default: NOT_REACHED();
+		}
+	}
+}
+
+/**
+ * Read a run of variables straight from the savegame buffer.
+ * @param p        where to read from; all variables must be in the buffer
+ * @param object   the object the variables are part of
+ * @param offsets  the offsets of the variables in the object
+ * @param count    the number of variables
+ * @param filetype the type of the variables in the savegame
+ */
+template <typename T>
+static void SlLoadRun(const byte *p, byte *object, const uint *offsets, uint count, VarType filetype)
+{
+	switch (filetype) {
+		case SLE_FILE_I8:  for (uint i = 0; i < count; i++, p += 1) *(T *)(object + offsets[i]) = (T)(int8)p[0]; break;
+		case SLE_FILE_U8:  for (uint i = 0; i < count; i++, p += 1) *(T *)(object + offsets[i]) = (T)p[0]; break;
+		case SLE_FILE_I16: for (uint i = 0; i < count; i++, p += 2) *(T *)(object + offsets[i]) = (T)(int16)(p[0] << 8 | p[1]); break;
+		case SLE_FILE_U16: for (uint i = 0; i < count; i++, p += 2) *(T *)(object + offsets[i]) = (T)(uint16)(p[0] << 8 | p[1]); break;
+		case SLE_FILE_I32: for (uint i = 0; i < count; i++, p += 4) *(T *)(object + offsets[i]) = (T)(int32)((uint32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]); break;
+		case SLE_FILE_U32: for (uint i = 0; i < count; i++, p += 4) *(T *)(object + offsets[i]) = (T)((uint32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]); break;
+		case SLE_FILE_I64:
+		case SLE_FILE_U64:
+			for (uint i = 0; i < count; i++, p += 8) {
+				uint64 x = 0;
+				for (uint j = 0; j < 8; j++) x = x << 8 | p[j];
+				*(T *)(object + offsets[i]) = (T)x;
+			}
+			break;
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Save or load a run of variables of the same type.
+ * @param object  the object the variables are part of
+ * @param offsets the offsets of the variables in the object
+ * @param count   the number of variables
+ * @param conv    the type of the variables
+ */
+static void SlSaveLoadRun(byte *object, const uint *offsets, uint count, VarType conv)
+{
+	size_t size = (size_t)SlCalcConvFileLen(conv) * count;
+
+	/* Runs that don't fit in the buffer at once go variable by variable. */
+	if ((size_t)(_sl.bufe - _sl.bufp) < size) {
+		for (uint i = 0; i < count; i++) SlSaveLoadConv(object + offsets[i], conv);
+		return;
+	}
+
+	VarType filetype = GetVarFileType(conv);
+	if (_sl.action == SLA_SAVE) {
+		switch (GetVarMemType(conv)) {
+			case SLE_VAR_BL:  SlSaveRun<bool  >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_I8:  SlSaveRun<int8  >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_U8:  SlSaveRun<uint8 >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_I16: SlSaveRun<int16 >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_U16: SlSaveRun<uint16>(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_I32: SlSaveRun<int32 >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_U32: SlSaveRun<uint32>(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_I64: SlSaveRun<int64 >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_U64: SlSaveRun<uint64>(_sl.bufp, object, offsets, count, filetype); break;
+			default: NOT_REACHED();
+		}
+	} else {
+		switch (GetVarMemType(conv)) {
+			case SLE_VAR_BL:  SlLoadRun<bool  >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_I8:  SlLoadRun<int8  >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_U8:  SlLoadRun<uint8 >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_I16: SlLoadRun<int16 >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_U16: SlLoadRun<uint16>(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_I32: SlLoadRun<int32 >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_U32: SlLoadRun<uint32>(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_I64: SlLoadRun<int64 >(_sl.bufp, object, offsets, count, filetype); break;
+			case SLE_VAR_U64: SlLoadRun<uint64>(_sl.bufp, object, offsets, count, filetype); break;
+			default: NOT_REACHED();
+		}
+	}
+	_sl.bufp += size;
+}
+
+/**
+ * Save or load an object like #SlObject, but with the description compiled
+ * for the current savegame version the first time it is used in a save or
+ * load. This is meant for the objects of the pools, of which there are many.
+ * @param object The object that is being saved or loaded
+ * @param sld The SaveLoad description of the object; it must not change during the save or load, like the static descriptions do
+ */
+void SlCompiledObject(void *object, const SaveLoad *sld)
+{
+	const SlCompiledDesc *desc = (_sl.action == SLA_SAVE || _sl.action == SLA_LOAD) ? SlGetCompiledDesc(sld) : NULL;
+	if (desc == NULL) {
+		SlObject(object, sld);
+		return;
+	}
+
+	/* Automatically calculate the length? */
+	if (_sl.need_length != NL_NONE) {
+		size_t length = desc->length;
+		if (desc->variable_length) {
+			for (const SlCompiledOp *op = desc->ops.Begin(); op != desc->ops.End(); op++) {
+				if (op->type != SCO_MEMBER) continue;
+				const SaveLoad *member = desc->members[op->first];
+				if (member->cmd == SL_STR || member->cmd == SL_LST || member->cmd == SL_DEQ) length += SlCalcObjMemberLength(object, member);
+			}
+		}
+		SlSetLength(length);
+		if (_sl.need_length == NL_CALCLENGTH) return;
+	}
+
+	for (const SlCompiledOp *op = desc->ops.Begin(); op != desc->ops.End(); op++) {
+		if (op->type == SCO_RUN) {
+			SlSaveLoadRun((byte *)object, desc->offsets.Get(op->first), op->count, op->conv);
+		} else {
+			const SaveLoad *member = desc->members[op->first];
+			SlObjectMember(member->global ? member->address : GetVariableAddress(object, member), member);
+		}
+	}
+}
+
 /**
  * Save or Load (a list of) global variables
  * @param sldg The global variable that is being loaded or saved
@@ -1128,12 +1500,17 @@ void SlAutolength(AutolengthProc *proc, void *arg)
 	if (offs != SlGetOffs()) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Invalid chunk size");
 }
 
+static const byte CH_REFERENCE = 3; ///< Type of a chunk of a differential savegame that is stored in its base savegame.
+static void SlLoadReferencedChunk(const ChunkHandler *ch, bool check);
+
 /**
  * Load a chunk of data (eg vehicles, stations, etc.)
  * @param ch The chunkhandler that will be used for the operation
  */
 static void SlLoadChunk(const ChunkHandler *ch)
 {
+	TIMELINE_ZONE_ARG("load chunk", ch->id);
+
 	byte m = SlReadByte();
 	size_t len;
 	size_t endoffs;
@@ -1149,6 +1526,9 @@ static void SlLoadChunk(const ChunkHandler *ch)
 		case CH_SPARSE_ARRAY:
 			ch->load_proc();
 			break;
+		case CH_REFERENCE:
+			SlLoadReferencedChunk(ch, false);
+			break;
 		default:
 			if ((m & 0xF) == CH_RIFF) {
 				/* Read length */
@@ -1195,6 +1575,9 @@ static void SlLoadCheckChunk(const ChunkHandler *ch)
 				SlSkipArray();
 			}
 			break;
+		case CH_REFERENCE:
+			SlLoadReferencedChunk(ch, true);
+			break;
 		default:
 			if ((m & 0xF) == CH_RIFF) {
 				/* Read length */
@@ -1215,6 +1598,91 @@ static void SlLoadCheckChunk(const ChunkHandler *ch)
 	}
 }
 
+/** The time, size and number of objects of a chunk in the last save or load. */
+struct ChunkStatistics {
+	uint32 id;     ///< The id of the chunk.
+	uint64 cycles; ///< The time spent on the chunk, in rdtsc cycles.
+	size_t bytes;  ///< The uncompressed size of the chunk.
+	uint objects;  ///< The number of objects in the chunk; 1 for RIFF chunks.
+};
+
+static SmallVector<ChunkStatistics, 64> _chunk_stats; ///< The statistics of the chunks of the last save or load.
+static bool _chunk_stats_save;                        ///< Whether #_chunk_stats are of a save, or of a load.
+static CPerformanceTimer _chunk_timer;                ///< Timer of the chunk being saved or loaded.
+static size_t _chunk_start;                           ///< Offset at which the chunk being saved or loaded starts.
+
+/** Get the number of bytes written to the savegame so far. */
+static inline size_t SlGetWriteOffs() {return _sl.offs_base + (_sl.bufp - _sl.buf);}
+
+/**
+ * Forget the chunk statistics of the previous save or load.
+ * @param save whether a save starts, or a load
+ */
+static void SlResetChunkStatistics(bool save)
+{
+	_chunk_stats.Clear();
+	_chunk_stats_save = save;
+}
+
+/** Start measuring the chunk that is saved or loaded next. */
+static void SlStartChunkStatistics()
+{
+	_chunk_objects = 0;
+	_chunk_start = _chunk_stats_save ? SlGetWriteOffs() : SlGetOffs();
+	_chunk_timer.m_acc = 0;
+	_chunk_timer.Start();
+}
+
+/**
+ * Add the measurements of the chunk that has just been saved or loaded to the statistics.
+ * @param id the id of the chunk
+ */
+static void SlStopChunkStatistics(uint32 id)
+{
+	_chunk_timer.Stop();
+
+	ChunkStatistics *stats = _chunk_stats.Append();
+	stats->id = id;
+	stats->cycles = _chunk_timer.m_acc;
+	stats->bytes = (_chunk_stats_save ? SlGetWriteOffs() : SlGetOffs()) - _chunk_start;
+	stats->objects = ((_sl.block_mode & 0xF) == CH_RIFF) ? 1 : _chunk_objects;
+}
+
+/**
+ * Print the statistics of the chunks of the last save or load.
+ * @param console whether to print to the console, or to the sl debug output
+ */
+void PrintChunkStatistics(bool console)
+{
+	char buf[128];
+	uint64 total_cycles = 0;
+	size_t total_bytes = 0;
+	for (const ChunkStatistics *stats = _chunk_stats.Begin(); stats != _chunk_stats.End(); stats++) {
+		total_cycles += stats->cycles;
+		total_bytes += stats->bytes;
+	}
+
+	for (int i = -2; i <= (int)_chunk_stats.Length(); i++) {
+		if (i == -2) {
+			snprintf(buf, lengthof(buf), "Chunk timings of the last %s in kilocycles:", _chunk_stats_save ? "save" : "load");
+		} else if (i == -1) {
+			snprintf(buf, lengthof(buf), "  %-5s %10s %10s %8s %6s", "chunk", "time", "bytes", "objects", "share");
+		} else if (i == (int)_chunk_stats.Length()) {
+			snprintf(buf, lengthof(buf), "  %-5s %10u %10u", "total", (uint)(total_cycles / 1000), (uint)total_bytes);
+		} else {
+			const ChunkStatistics *stats = _chunk_stats.Get(i);
+			snprintf(buf, lengthof(buf), "  %c%c%c%c  %10u %10u %8u %5u%%", stats->id >> 24, stats->id >> 16, stats->id >> 8, stats->id,
+					(uint)(stats->cycles / 1000), (uint)stats->bytes, stats->objects, total_cycles == 0 ? 0 : (uint)(stats->cycles * 100 / total_cycles));
+		}
+
+		if (console) {
+			IConsolePrint(CC_DEFAULT, buf);
+		} else {
+			DEBUG(sl, 0, "%s", buf);
+		}
+	}
+}
+
 /* Stub Chunk handlers to only calculate length and do nothing else */
 static ChunkSaveLoadProc *_tmp_proc_1;
 static inline void SlStubSaveProc2(void *arg) {_tmp_proc_1();}
@@ -1231,6 +1699,8 @@ static void SlSaveChunk(const ChunkHandler *ch)
 	/* Don't save any chunk information if there is no save handler. */
 	if (proc == NULL) return;
 
+	TIMELINE_ZONE_ARG("save chunk", ch->id);
+
 	SlWriteUint32(ch->id);
 	DEBUG(sl, 2, "Saving chunk %c%c%c%c", ch->id >> 24, ch->id >> 16, ch->id >> 8, ch->id);
 
@@ -1261,15 +1731,261 @@ static void SlSaveChunk(const ChunkHandler *ch)
 	}
 }
 
+/*
+ * A differential savegame only contains the chunks that differ from the
+ * ones in its base savegame, a normal savegame that was written before.
+ * Every other chunk is replaced by its id, #CH_REFERENCE and the MD5
+ * checksum of the chunk in the base savegame. The savegame starts with a
+ * 'DIFB' record with the name of the base savegame and its header is marked
+ * with #SL_HEADER_DIFFERENTIAL. When loading such a savegame it is read into
+ * memory together with its base savegame, and the referenced chunks are
+ * loaded from the base savegame.
+ */
+
+static const uint32 SL_HEADER_DIFFERENTIAL = 1; ///< Flag in the version in the header of a differential savegame.
+
+/** How the savegame is written with respect to differential savegames. */
+enum DiffSaveMode {
+	DSM_NONE,  ///< A normal savegame
+	DSM_BASE,  ///< A normal savegame that becomes the base of the next differential savegames
+	DSM_DELTA, ///< A differential savegame
+};
+
+/** A chunk of a base savegame. */
+struct DiffChunk {
+	uint32 id;         ///< The id of the chunk.
+	uint8 digest[16];  ///< The MD5 checksum of the chunk, including its id.
+	size_t start;      ///< When loading, the offset of the chunk in the base savegame.
+	size_t end;        ///< When loading, the offset of the end of the chunk in the base savegame.
+};
+
+/** A savegame that is read from memory. */
+struct DiffMemory {
+	byte *data;  ///< The uncompressed savegame.
+	size_t size; ///< The number of bytes of the savegame that are in memory.
+	size_t pos;  ///< The number of bytes that have been read.
+	size_t capacity; ///< When reading the savegame into memory, the number of bytes allocated.
+};
+
+typedef SmallVector<DiffChunk, 64> DiffChunkList;
+
+static DiffSaveMode _diff_mode;                ///< How the savegame is written.
+static char _diff_base[MAX_PATH];              ///< The base savegame of the next differential savegames; empty if there is none.
+static Subdirectory _diff_base_subdir;         ///< The directory #_diff_base is in.
+static DiffChunkList _diff_base_chunks;        ///< The chunks of #_diff_base.
+static uint _diff_count;                       ///< The number of differential savegames written since #_diff_base.
+static char _diff_new_base[MAX_PATH];          ///< When saving a new base savegame, its name.
+static Subdirectory _diff_new_base_subdir;     ///< When saving a new base savegame, its directory.
+static DiffChunkList _diff_new_base_chunks;    ///< When saving a new base savegame, its chunks.
+
+static byte *_diff_chunk;                      ///< When saving, the chunk being saved.
+static size_t _diff_chunk_size;                ///< The number of bytes in #_diff_chunk.
+static size_t _diff_chunk_capacity;            ///< The number of bytes allocated for #_diff_chunk.
+
+static DiffMemory _diff_delta;                 ///< When loading, the differential savegame.
+static DiffMemory _diff_base_data;             ///< When loading, the base savegame of #_diff_delta.
+static DiffChunkList _diff_load_chunks;        ///< When loading, the chunks of #_diff_base_data.
+static DiffMemory *_diff_read;                 ///< When loading, the savegame that is read from.
+
+/**
+ * Decide how the savegame is written: autosaves are written as differential
+ * savegames, except for every so many, which are written as new base.
+ * @param filename the name of the savegame
+ * @param sb       the directory of the savegame
+ */
+static void PrepareDifferentialSave(const char *filename, Subdirectory sb)
+{
+	/* A savegame can't be its own base, and the old base is gone once it's overwritten. */
+	bool overwrites_base = sb == _diff_base_subdir && strcmp(filename, _diff_base) == 0;
+	if (overwrites_base) _diff_base[0] = '\0';
+
+	if (!_do_autosave || _settings_client.gui.differential_autosaves == 0) {
+		_diff_mode = DSM_NONE;
+	} else if (StrEmpty(_diff_base) || _diff_count >= _settings_client.gui.differential_autosaves) {
+		_diff_mode = DSM_BASE;
+		strecpy(_diff_new_base, filename, lastof(_diff_new_base));
+		_diff_new_base_subdir = sb;
+		_diff_new_base_chunks.Clear();
+	} else {
+		_diff_mode = DSM_DELTA;
+		_diff_count++;
+	}
+}
+
+/** The new base savegame has been written; the next differential savegames refer to it. */
+static void AdoptDifferentialBase()
+{
+	strecpy(_diff_base, _diff_new_base, lastof(_diff_base));
+	_diff_base_subdir = _diff_new_base_subdir;
+	_diff_base_chunks.Clear();
+	for (const DiffChunk *c = _diff_new_base_chunks.Begin(); c != _diff_new_base_chunks.End(); c++) {
+		*_diff_base_chunks.Append() = *c;
+	}
+	_diff_count = 0;
+}
+
+/**
+ * Collect the bytes of the chunk being saved.
+ * @param len the number of bytes in the buffer
+ */
+static void CollectDiffChunk(size_t len)
+{
+	if (_diff_chunk_size + len > _diff_chunk_capacity) {
+		_diff_chunk_capacity = max(_diff_chunk_capacity * 2, _diff_chunk_size + len);
+		_diff_chunk = ReallocT(_diff_chunk, _diff_chunk_capacity);
+	}
+	memcpy(_diff_chunk + _diff_chunk_size, _sl.buf, len);
+	_diff_chunk_size += len;
+}
+
+/**
+ * Save a chunk of a base or differential savegame.
+ * The chunk is saved in memory first, to know whether it has changed.
+ * @param ch the chunk handler
+ */
+static void SlSaveDiffChunk(const ChunkHandler *ch)
+{
+	if (ch->save_proc == NULL) return;
+
+	SlWriteFill();
+	size_t offs = _sl.offs_base;
+	WriterProc *write_bytes = _sl.write_bytes;
+	_sl.write_bytes = CollectDiffChunk;
+	_diff_chunk_size = 0;
+
+	SlSaveChunk(ch);
+	SlWriteFill();
+
+	_sl.write_bytes = write_bytes;
+	_sl.offs_base = offs;
+
+	DiffChunk chunk;
+	chunk.id = ch->id;
+	Md5 checksum;
+	checksum.Append(_diff_chunk, _diff_chunk_size);
+	checksum.Finish(chunk.digest);
+
+	if (_diff_mode == DSM_BASE) {
+		*_diff_new_base_chunks.Append() = chunk;
+	} else {
+		for (const DiffChunk *c = _diff_base_chunks.Begin(); c != _diff_base_chunks.End(); c++) {
+			if (c->id != chunk.id || memcmp(c->digest, chunk.digest, sizeof(chunk.digest)) != 0) continue;
+
+			DEBUG(sl, 2, "Chunk %c%c%c%c is unchanged since the base savegame", ch->id >> 24, ch->id >> 16, ch->id >> 8, ch->id);
+			SlWriteUint32(ch->id);
+			SlWriteByte(CH_REFERENCE);
+			SlCopyBytes(chunk.digest, sizeof(chunk.digest));
+			return;
+		}
+	}
+
+	SlCopyBytes(_diff_chunk, _diff_chunk_size);
+}
+
 /** Save all chunks */
 static void SlSaveChunks()
 {
+	SlResetCompiledDescs();
+	if (_diff_mode == DSM_DELTA) {
+		size_t len = strlen(_diff_base);
+		SlWriteUint32('DIFB');
+		SlWriteUint16((uint16)len);
+		SlCopyBytes(_diff_base, len);
+	}
+
+	SlResetChunkStatistics(true);
 	FOR_ALL_CHUNK_HANDLERS(ch) {
-		SlSaveChunk(ch);
+		if (ch->save_proc == NULL) continue;
+
+		SlStartChunkStatistics();
+		if (_diff_mode == DSM_NONE) {
+			SlSaveChunk(ch);
+		} else {
+			SlSaveDiffChunk(ch);
+		}
+		SlStopChunkStatistics(ch->id);
 	}
 
 	/* Terminator */
 	SlWriteUint32(0);
+	if (_debug_sl_level >= 3) PrintChunkStatistics(false);
+
+	free(_diff_chunk);
+	_diff_chunk = NULL;
+	_diff_chunk_capacity = 0;
+}
+
+/**
+ * Skip a chunk of which the id has just been read.
+ */
+static void SlSkipChunk()
+{
+	byte m = SlReadByte();
+
+	_sl.block_mode = m;
+	_sl.obj_len = 0;
+
+	switch (m) {
+		case CH_ARRAY:
+			_sl.array_index = 0;
+			/* FALL THROUGH */
+		case CH_SPARSE_ARRAY:
+			SlSkipArray();
+			break;
+		case CH_REFERENCE:
+			SlSkipBytes(16);
+			break;
+		default:
+			if ((m & 0xF) == CH_RIFF) {
+				size_t len = (SlReadByte() << 16) | ((m >> 4) << 24);
+				len += SlReadUint16();
+				SlSkipBytes(len);
+			} else {
+				SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Invalid chunk type");
+			}
+			break;
+	}
+}
+
+/**
+ * Load a chunk of a differential savegame from its base savegame.
+ * @param ch    the chunk handler
+ * @param check whether the chunk is loaded for checking the savegame
+ */
+static void SlLoadReferencedChunk(const ChunkHandler *ch, bool check)
+{
+	uint8 digest[16];
+	SlCopyBytes(digest, sizeof(digest));
+
+	const DiffChunk *chunk = NULL;
+	if (_diff_read == &_diff_delta) {
+		for (const DiffChunk *c = _diff_load_chunks.Begin(); c != _diff_load_chunks.End(); c++) {
+			if (c->id == ch->id && memcmp(c->digest, digest, sizeof(digest)) == 0) chunk = c;
+		}
+	}
+	if (chunk == NULL) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Base savegame has changed");
+
+	/* Continue in the base savegame, right after the id of the chunk. */
+	byte *bufp = _sl.bufp;
+	byte *bufe = _sl.bufe;
+	size_t offs_base = _sl.offs_base;
+
+	DiffMemory base = { _diff_base_data.data, chunk->end, chunk->start + 4, 0 };
+	_diff_read = &base;
+	_sl.bufp = _sl.bufe = NULL;
+	_sl.offs_base = base.pos;
+
+	if (check) {
+		SlLoadCheckChunk(ch);
+	} else {
+		SlLoadChunk(ch);
+	}
+	if (SlGetOffs() != chunk->end) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Invalid chunk size");
+
+	_diff_read = &_diff_delta;
+	_sl.bufp = bufp;
+	_sl.bufe = bufe;
+	_sl.offs_base = offs_base;
 }
 
 /** Find the ChunkHandler that will be used for processing the found
@@ -1289,27 +2005,41 @@ static void SlLoadChunks()
 	uint32 id;
 	const ChunkHandler *ch;
 
+	SlResetCompiledDescs();
+	SlResetChunkStatistics(false);
 	for (id = SlReadUint32(); id != 0; id = SlReadUint32()) {
 		DEBUG(sl, 2, "Loading chunk %c%c%c%c", id >> 24, id >> 16, id >> 8, id);
 
 		ch = SlFindChunkHandler(id);
 		if (ch == NULL) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Unknown chunk type");
+		SlStartChunkStatistics();
 		SlLoadChunk(ch);
+		SlStopChunkStatistics(id);
 	}
+	if (_debug_sl_level >= 3) PrintChunkStatistics(false);
 }
 
-/** Load all chunks for savegame checking */
+/**
+ * Load all chunks for savegame checking. Once every chunk that has a
+ * load_check_proc has been loaded the rest of the savegame is of no
+ * interest, so it isn't read (and decompressed) at all.
+ */
 static void SlLoadCheckChunks()
 {
 	uint32 id;
 	const ChunkHandler *ch;
 
+	uint to_check = 0;
+	FOR_ALL_CHUNK_HANDLERS(ch) if (ch->load_check_proc != NULL) to_check++;
+
 	for (id = SlReadUint32(); id != 0; id = SlReadUint32()) {
 		DEBUG(sl, 2, "Loading chunk %c%c%c%c", id >> 24, id >> 16, id >> 8, id);
 
 		ch = SlFindChunkHandler(id);
 		if (ch == NULL) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Unknown chunk type");
 		SlLoadCheckChunk(ch);
+
+		if (ch->load_check_proc != NULL && --to_check == 0) break;
 	}
 }
 
@@ -1333,25 +2063,143 @@ static void SlFixPointers()
 }
 
 /*******************************************
- ********** START OF LZO CODE **************
+ ********** START OF FILE MAPPING CODE *****
  *******************************************/
 
-#ifdef WITH_LZO
-#include <lzo/lzo1x.h>
-
-/** Buffer size for the LZO compressor */
-static const uint LZO_BUFFER_SIZE = 8192;
+static byte *_sl_map = NULL; ///< The savegame file mapped into memory, or NULL when it is read with fread.
+static size_t _sl_map_size;  ///< The size of #_sl_map.
+static size_t _sl_map_pos;   ///< The position of the savegame in #_sl_map.
 
-static size_t ReadLZO()
+/**
+ * Map the savegame file into memory, so the loaders can use its
+ * contents without copying them to their own buffers first. When the
+ * file can't be mapped, it is read with fread instead.
+ * The savegame continues at the current position of the file.
+ */
+static void MapSavegameFile()
 {
-	/* Buffer size is from the LZO docs plus the chunk header size. */
+#ifdef WITH_MAPPED_LOAD
+	struct stat st;
+	long pos = ftell(_sl.fh);
+	if (pos < 0 || fstat(fileno(_sl.fh), &st) != 0 || st.st_size <= pos) return;
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(_sl.fh), 0);
+	if (map == MAP_FAILED) return;
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	_sl_map = (byte *)map;
+	_sl_map_size = st.st_size;
+	_sl_map_pos = pos;
+#endif /* WITH_MAPPED_LOAD */
+}
+
+/** Remove the mapping of the savegame file, if any. */
+static void UnmapSavegameFile()
+{
+#ifdef WITH_MAPPED_LOAD
+	if (_sl_map != NULL) munmap(_sl_map, _sl_map_size);
+#endif /* WITH_MAPPED_LOAD */
+	_sl_map = NULL;
+}
+
+/**
+ * Read bytes from the savegame file. When the file is mapped into memory
+ * they are used from the mapping instead of being copied.
+ * @param buf the buffer to read into when the file isn't mapped
+ * @param len the number of bytes to read
+ * @return the bytes; either \a buf or in the mapping, or NULL when the file hasn't got that many bytes left
+ */
+static const byte *SlReadFileInPlace(byte *buf, size_t len)
+{
+	if (_sl_map == NULL) return fread(buf, len, 1, _sl.fh) == 1 ? buf : NULL;
+
+	if (_sl_map_size - _sl_map_pos < len) return NULL;
+	const byte *data = _sl_map + _sl_map_pos;
+	_sl_map_pos += len;
+	return data;
+}
+
+/**
+ * Read bytes from the savegame file into a buffer.
+ * @param buf the buffer to read into
+ * @param len the number of bytes to read
+ * @return false when the file hasn't got that many bytes left
+ */
+static bool SlReadFile(void *buf, size_t len)
+{
+	if (_sl_map == NULL) return fread(buf, len, 1, _sl.fh) == 1;
+
+	const byte *data = SlReadFileInPlace(NULL, len);
+	if (data == NULL) return false;
+	memcpy(buf, data, len);
+	return true;
+}
+
+/**
+ * Get all bytes that are left in the mapping of the savegame file.
+ * @param len the maximum number of bytes to get; set to the number of bytes returned
+ * @return the bytes
+ */
+static byte *SlReadMappedBytes(size_t *len)
+{
+	assert(_sl_map != NULL);
+	*len = min(*len, _sl_map_size - _sl_map_pos);
+	byte *data = _sl_map + _sl_map_pos;
+	_sl_map_pos += *len;
+	return data;
+}
+
+static DiffMemory *_sl_write_memory = NULL; ///< When saving into memory, the savegame; otherwise it is written to #_sl.fh.
+
+/**
+ * Is there anything to write the savegame to? There isn't once saving has been aborted.
+ * @return true if #SlWriteFile can be used
+ */
+static inline bool SlHasOutput()
+{
+	return _sl.fh != NULL || _sl_write_memory != NULL;
+}
+
+/**
+ * Write bytes to the savegame file, or to memory when saving into memory.
+ * @param buf the bytes to write
+ * @param len the number of bytes to write
+ * @return false if the bytes couldn't be written
+ */
+static bool SlWriteFile(const void *buf, size_t len)
+{
+	if (_sl_write_memory == NULL) return len == 0 || fwrite(buf, len, 1, _sl.fh) == 1;
+
+	DiffMemory *mem = _sl_write_memory;
+	if (mem->size + len > mem->capacity) {
+		mem->capacity = max(mem->capacity * 2, mem->size + len);
+		mem->data = ReallocT(mem->data, mem->capacity);
+	}
+	memcpy(mem->data + mem->size, buf, len);
+	mem->size += len;
+	return true;
+}
+
+/*******************************************
+ ********** START OF LZO CODE **************
+ *******************************************/
+
+#ifdef WITH_LZO
+#include <lzo/lzo1x.h>
+
+/** Buffer size for the LZO compressor */
+static const uint LZO_BUFFER_SIZE = 8192;
+
+static size_t ReadLZO()
+{
+	/* Buffer size is from the LZO docs plus the chunk header size. */
 	byte out[LZO_BUFFER_SIZE + LZO_BUFFER_SIZE / 16 + 64 + 3 + sizeof(uint32) * 2];
 	uint32 tmp[2];
 	uint32 size;
 	lzo_uint len;
 
 	/* Read header*/
-	if (fread(tmp, sizeof(tmp), 1, _sl.fh) != 1) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "File read failed");
+	if (!SlReadFile(tmp, sizeof(tmp))) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "File read failed");
 
 	/* Check if size is bad */
 	((uint32*)out)[0] = size = tmp[1];
@@ -1363,20 +2211,21 @@ static size_t ReadLZO()
 
 	if (size >= sizeof(out)) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Inconsistent size");
 
-	/* Read block */
-	if (fread(out + sizeof(uint32), size, 1, _sl.fh) != 1) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+	/* Read block; when the file is mapped the size in front of it is in the mapping as well. */
+	const byte *block = SlReadFileInPlace(out + sizeof(uint32), size);
+	if (block == NULL) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
 
 	/* Verify checksum */
-	if (tmp[0] != lzo_adler32(0, out, size + sizeof(uint32))) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Bad checksum");
+	if (tmp[0] != lzo_adler32(0, block - sizeof(uint32), size + sizeof(uint32))) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Bad checksum");
 
 	/* Decompress */
-	lzo1x_decompress(out + sizeof(uint32) * 1, size, _sl.buf, &len, NULL);
+	lzo1x_decompress(block, size, _sl.buf, &len, NULL);
 	return len;
 }
 
-static void WriteLZO(size_t size)
+static void WriteLZO(byte *buf, size_t size)
 {
-	const lzo_bytep in = _sl.buf;
+	const lzo_bytep in = buf;
 	/* Buffer size is from the LZO docs plus the chunk header size. */
 	byte out[LZO_BUFFER_SIZE + LZO_BUFFER_SIZE / 16 + 64 + 3 + sizeof(uint32) * 2];
 	byte wrkmem[LZO1X_1_MEM_COMPRESS];
@@ -1388,7 +2237,7 @@ static void WriteLZO(size_t size)
 		lzo1x_1_compress(in, len, out + sizeof(uint32) * 2, &outlen, wrkmem);
 		((uint32*)out)[1] = TO_BE32((uint32)outlen);
 		((uint32*)out)[0] = TO_BE32(lzo_adler32(0, out + sizeof(uint32), outlen + sizeof(uint32)));
-		if (fwrite(out, outlen + sizeof(uint32) * 2, 1, _sl.fh) != 1) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
+		if (!SlWriteFile(out, outlen + sizeof(uint32) * 2)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
 
 		/* Move to next data chunk. */
 		size -= len;
@@ -1420,12 +2269,17 @@ static const uint NOCOMP_BUFFER_SIZE = 8192;
 
 static size_t ReadNoComp()
 {
-	return fread(_sl.buf, 1, NOCOMP_BUFFER_SIZE, _sl.fh);
+	if (_sl_map == NULL) return fread(_sl.buf, 1, NOCOMP_BUFFER_SIZE, _sl.fh);
+
+	/* Pass the rest of the mapped file on at once, without copying it. */
+	size_t len = _sl_map_size;
+	_sl.buf = SlReadMappedBytes(&len);
+	return len;
 }
 
-static void WriteNoComp(size_t size)
+static void WriteNoComp(byte *buf, size_t size)
 {
-	if (fwrite(_sl.buf, 1, size, _sl.fh) != size) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
+	if (!SlWriteFile(buf, size)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
 }
 
 static bool InitNoComp(byte compression)
@@ -1450,37 +2304,77 @@ struct ThreadedSave {
 	uint count;
 	byte ff_state;
 	bool saveinprogress;
+	bool aborted;        ///< Saving the game failed; the save thread must only throw away the chunks.
 	CursorID cursor;
 };
 
 /** Save in chunks of 128 KiB. */
 static const size_t MEMORY_CHUNK_SIZE = 128 * 1024;
-/** Memory allocation for storing savegames in memory. */
-static AutoFreeSmallVector<byte *, 16> _memory_savegame;
+/** Number of chunks that may wait for the save thread before saving the game waits for it. */
+static const uint MAX_QUEUED_CHUNKS = 8;
+
+/** A saved chunk of memory that has not been compressed and written to the file yet. */
+struct SaveChunk {
+	byte *buf;   ///< The data, or NULL for the end of the savegame.
+	size_t size; ///< The number of bytes in #buf.
+};
+
+static SaveChunk _save_queue[MAX_QUEUED_CHUNKS]; ///< The chunks waiting for the save thread, a ring buffer.
+static uint _save_queue_first;                   ///< The position of the oldest chunk in #_save_queue.
+static uint _save_queue_length;                  ///< The number of chunks in #_save_queue.
 
 static ThreadedSave _ts;
 
-static void WriteMem(size_t size)
+/**
+ * Hand a chunk of the savegame to the save thread; wait while
+ * #MAX_QUEUED_CHUNKS chunks are waiting for it already.
+ * @param buf  the data, which is freed by the save thread, or NULL for the end of the savegame
+ * @param size the number of bytes of data
+ */
+static void PushSaveChunk(byte *buf, size_t size)
 {
-	_ts.count += (uint)size;
+	_save_queue_mutex->BeginCritical();
+	while (_save_queue_length == MAX_QUEUED_CHUNKS) _save_queue_mutex->WaitForSignal();
 
-	_sl.buf = CallocT<byte>(MEMORY_CHUNK_SIZE);
-	*_memory_savegame.Append() = _sl.buf;
+	SaveChunk *chunk = &_save_queue[(_save_queue_first + _save_queue_length) % MAX_QUEUED_CHUNKS];
+	chunk->buf = buf;
+	chunk->size = size;
+	_save_queue_length++;
+
+	_save_queue_mutex->SendSignal();
+	_save_queue_mutex->EndCritical();
+}
+
+/**
+ * Take the oldest chunk of the savegame from the queue; wait while there is none.
+ * @param chunk the taken chunk
+ * @return false if the end of the savegame has been reached
+ */
+static bool PopSaveChunk(SaveChunk *chunk)
+{
+	_save_queue_mutex->BeginCritical();
+	while (_save_queue_length == 0) _save_queue_mutex->WaitForSignal();
+
+	*chunk = _save_queue[_save_queue_first];
+	_save_queue_first = (_save_queue_first + 1) % MAX_QUEUED_CHUNKS;
+	_save_queue_length--;
+
+	_save_queue_mutex->SendSignal();
+	_save_queue_mutex->EndCritical();
+	return chunk->buf != NULL;
 }
 
 static void UnInitMem()
 {
-	_memory_savegame.Clear();
+	free(_sl.buf);
+	_sl.buf = NULL;
 }
 
-static bool InitMem()
+static void InitMem()
 {
 	_ts.count = 0;
 	_sl.bufsize = MEMORY_CHUNK_SIZE;
-
-	UnInitMem();
-	WriteMem(0);
-	return true;
+	_sl.buf = MallocT<byte>(MEMORY_CHUNK_SIZE);
 }
 
 /********************************************
@@ -1515,7 +2409,14 @@ static size_t ReadZlib()
 	do {
 		/* read more bytes from the file? */
 		if (_z.avail_in == 0) {
-			_z.avail_in = (uint)fread(_z.next_in = _sl.buf + ZLIB_BUFFER_SIZE, 1, ZLIB_BUFFER_SIZE, _sl.fh);
+			if (_sl_map != NULL) {
+				/* Inflate straight from the mapped file. */
+				size_t len = UINT_MAX;
+				_z.next_in = SlReadMappedBytes(&len);
+				_z.avail_in = (uint)len;
+			} else {
+				_z.avail_in = (uint)fread(_z.next_in = _sl.buf + ZLIB_BUFFER_SIZE, 1, ZLIB_BUFFER_SIZE, _sl.fh);
+			}
 		}
 
 		/* inflate the data */
@@ -1567,7 +2468,7 @@ static void WriteZlibLoop(z_streamp z, byte *p, size_t len, int mode)
 
 		/* bytes were emitted? */
 		if ((n = sizeof(buf) - z->avail_out) != 0) {
-			if (fwrite(buf, n, 1, _sl.fh) != 1) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
+			if (!SlWriteFile(buf, n)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
 		}
 		if (r == Z_STREAM_END)
 			break;
@@ -1575,21 +2476,215 @@ static void WriteZlibLoop(z_streamp z, byte *p, size_t len, int mode)
 	} while (z->avail_in || !z->avail_out);
 }
 
-static void WriteZlib(size_t len)
+static void WriteZlib(byte *buf, size_t len)
 {
-	WriteZlibLoop(&_z, _sl.buf, len, 0);
+	WriteZlibLoop(&_z, buf, len, 0);
 }
 
 static void UninitWriteZlib()
 {
 	/* flush any pending output. */
-	if (_sl.fh) WriteZlibLoop(&_z, NULL, 0, Z_FINISH);
+	if (SlHasOutput()) WriteZlibLoop(&_z, NULL, 0, Z_FINISH);
 	deflateEnd(&_z);
 	free(_sl.buf_ori);
 }
 
 #endif /* WITH_ZLIB */
 
+/*******************************************
+ ********** START OF BLOCK ZLIB CODE *******
+ *******************************************/
+
+#if defined(WITH_ZLIB)
+
+/* A savegame in this format is a sequence of blocks that are compressed with
+ * zlib independently of each other, so several threads can compress or
+ * decompress them at the same time. Every block starts with its compressed
+ * and its uncompressed size as big endian uint32; a compressed size of 0
+ * marks the end of the savegame. */
+
+/** Maximum uncompressed size of a block. */
+static const uint PZLIB_BLOCK_SIZE = 128 * 1024;
+/** Maximum number of blocks that are compressed or decompressed at once. */
+static const uint MAX_PZLIB_THREADS = 16;
+
+/** A block of the savegame and the buffers to compress it with. */
+struct PZlibBlock {
+	byte *data;        ///< The uncompressed data, #PZLIB_BLOCK_SIZE bytes large.
+	byte *packed;      ///< The compressed data, compressBound(#PZLIB_BLOCK_SIZE) bytes large.
+	const byte *input; ///< When loading the compressed data; either #packed or in the mapped savegame file.
+	uLong size;        ///< The number of bytes in #data.
+	uLong packed_size; ///< The number of bytes in #packed.
+	bool ok;           ///< Whether the block could be compressed or decompressed.
+};
+
+static PZlibBlock _pzlib_blocks[MAX_PZLIB_THREADS]; ///< The blocks that are compressed or decompressed at once.
+static uint _pzlib_num_blocks; ///< The number of blocks in #_pzlib_blocks that are used.
+static uint _pzlib_filled;     ///< When saving the number of full blocks, when loading the number of decompressed blocks.
+static uint _pzlib_next;       ///< When loading the next decompressed block to pass on.
+static bool _pzlib_end;        ///< When loading whether the end of the savegame has been read.
+static int _pzlib_level;       ///< The compression level.
+
+/**
+ * Compress a block.
+ * @param arg the PZlibBlock
+ */
+static void CompressPZlibBlock(void *arg)
+{
+	PZlibBlock *block = (PZlibBlock *)arg;
+	block->packed_size = compressBound(PZLIB_BLOCK_SIZE);
+	block->ok = compress2(block->packed, &block->packed_size, block->data, block->size, _pzlib_level) == Z_OK;
+}
+
+/**
+ * Decompress a block.
+ * @param arg the PZlibBlock
+ */
+static void UncompressPZlibBlock(void *arg)
+{
+	PZlibBlock *block = (PZlibBlock *)arg;
+	uLongf size = PZLIB_BLOCK_SIZE;
+	block->ok = uncompress(block->data, &size, block->input, block->packed_size) == Z_OK && size == block->size;
+}
+
+/**
+ * Compress or decompress the first blocks, each in its own thread when possible.
+ * @param proc the function that (de)compresses a block
+ * @param num  the number of blocks
+ */
+static void ProcessPZlibBlocks(OTTDThreadFunc proc, uint num)
+{
+	ThreadObject *threads[MAX_PZLIB_THREADS];
+
+	/* This thread does the first block itself, once the others are started. */
+	for (uint i = 1; i < num; i++) {
+		if (!ThreadObject::New(proc, &_pzlib_blocks[i], &threads[i])) {
+			threads[i] = NULL;
+			proc(&_pzlib_blocks[i]);
+		}
+	}
+	if (num != 0) proc(&_pzlib_blocks[0]);
+
+	for (uint i = 1; i < num; i++) {
+		if (threads[i] == NULL) continue;
+		threads[i]->Join();
+		delete threads[i];
+	}
+}
+
+static bool InitPZlib(byte compression)
+{
+	_pzlib_level = compression;
+	_pzlib_num_blocks = Clamp(_settings_client.gui.savegame_threads, 1, MAX_PZLIB_THREADS);
+	_pzlib_filled = 0;
+	_pzlib_next = 0;
+	_pzlib_end = false;
+
+	for (uint i = 0; i < _pzlib_num_blocks; i++) {
+		_pzlib_blocks[i].data = MallocT<byte>(PZLIB_BLOCK_SIZE);
+		_pzlib_blocks[i].packed = MallocT<byte>(compressBound(PZLIB_BLOCK_SIZE));
+		_pzlib_blocks[i].size = 0;
+	}
+
+	_sl.bufsize = PZLIB_BLOCK_SIZE;
+	_sl.buf = _sl.buf_ori = NULL;
+	return true;
+}
+
+static void UninitPZlib()
+{
+	for (uint i = 0; i < _pzlib_num_blocks; i++) {
+		free(_pzlib_blocks[i].data);
+		free(_pzlib_blocks[i].packed);
+	}
+	_pzlib_num_blocks = 0;
+}
+
+static size_t ReadPZlib()
+{
+	if (_pzlib_next == _pzlib_filled) {
+		/* Read the next blocks and decompress them all at once. Don't
+		 * read beyond the end marker; there might be more in the file. */
+		_pzlib_next = 0;
+		_pzlib_filled = 0;
+		while (!_pzlib_end && _pzlib_filled < _pzlib_num_blocks) {
+			uint32 hdr[2];
+			if (!SlReadFile(hdr, sizeof(hdr))) break;
+
+			PZlibBlock *block = &_pzlib_blocks[_pzlib_filled];
+			block->packed_size = FROM_BE32(hdr[0]);
+			block->size = FROM_BE32(hdr[1]);
+			if (block->packed_size == 0) {
+				_pzlib_end = true;
+				break;
+			}
+			if (block->packed_size > compressBound(PZLIB_BLOCK_SIZE) || block->size > PZLIB_BLOCK_SIZE) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Invalid block size");
+			block->input = SlReadFileInPlace(block->packed, block->packed_size);
+			if (block->input == NULL) return 0;
+			_pzlib_filled++;
+		}
+
+		ProcessPZlibBlocks(UncompressPZlibBlock, _pzlib_filled);
+		for (uint i = 0; i < _pzlib_filled; i++) {
+			if (!_pzlib_blocks[i].ok) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Bad block");
+		}
+		if (_pzlib_filled == 0) return 0;
+	}
+
+	/* Pass the decompressed block on without copying it. */
+	PZlibBlock *block = &_pzlib_blocks[_pzlib_next++];
+	_sl.buf = block->data;
+	return block->size;
+}
+
+/** Compress the filled blocks and write them to the file. */
+static void FlushPZlibBlocks()
+{
+	uint num = _pzlib_filled;
+	if (num < _pzlib_num_blocks && _pzlib_blocks[num].size != 0) num++;
+
+	ProcessPZlibBlocks(CompressPZlibBlock, num);
+
+	for (uint i = 0; i < num; i++) {
+		PZlibBlock *block = &_pzlib_blocks[i];
+		if (!block->ok) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "zlib returned error code");
+
+		uint32 hdr[2] = { TO_BE32((uint32)block->packed_size), TO_BE32((uint32)block->size) };
+		if (!SlWriteFile(hdr, sizeof(hdr))) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
+		if (!SlWriteFile(block->packed, block->packed_size)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
+		block->size = 0;
+	}
+	_pzlib_filled = 0;
+}
+
+static void WritePZlib(byte *buf, size_t len)
+{
+	while (len > 0) {
+		PZlibBlock *block = &_pzlib_blocks[_pzlib_filled];
+		size_t n = min<size_t>(len, PZLIB_BLOCK_SIZE - block->size);
+		memcpy(block->data + block->size, buf, n);
+		block->size += n;
+		buf += n;
+		len -= n;
+
+		/* Compress once every block is full. */
+		if (block->size == PZLIB_BLOCK_SIZE && ++_pzlib_filled == _pzlib_num_blocks) FlushPZlibBlocks();
+	}
+}
+
+static void UninitWritePZlib()
+{
+	/* Write the remaining blocks and the end marker. */
+	if (SlHasOutput()) {
+		FlushPZlibBlocks();
+		uint32 hdr[2] = { 0, 0 };
+		if (!SlWriteFile(hdr, sizeof(hdr))) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
+	}
+	UninitPZlib();
+}
+
+#endif /* WITH_ZLIB */
+
 /*******************************************
  ************* END OF CODE *****************
  *******************************************/
@@ -1703,7 +2798,7 @@ struct SaveLoadFormat {
 	void (*uninit_read)();                ///< function executed when reading is finished
 
 	bool (*init_write)(byte compression); ///< function executed upon intialization of the saver
-	WriterProc *writer;                   ///< function that saves the data to the file
+	void (*writer)(byte *buf, size_t len); ///< function that compresses the data and saves it to the file
 	void (*uninit_write)();               ///< function executed when writing is done
 
 	byte min_compression;                 ///< the minimum compression level of this format
@@ -1719,8 +2814,10 @@ static const SaveLoadFormat _saveload_formats[] = {
 #endif
 	{"none",   TO_BE32X('OTTN'), InitNoComp,   ReadNoComp, UninitNoComp,   InitNoComp,    WriteNoComp, UninitNoComp,    0, 0, 0},
 #if defined(WITH_ZLIB)
+	{"pzlib",  TO_BE32X('OTTB'), InitPZlib,    ReadPZlib,  UninitPZlib,    InitPZlib,     WritePZlib,  UninitWritePZlib, 0, 6, 9},
 	{"zlib",   TO_BE32X('OTTZ'), InitReadZlib, ReadZlib,   UninitReadZlib, InitWriteZlib, WriteZlib,   UninitWriteZlib, 0, 6, 9},
 #else
+	{"pzlib",  TO_BE32X('OTTB'), NULL,         NULL,       NULL,           NULL,          NULL,        NULL,            0, 0, 0},
 	{"zlib",   TO_BE32X('OTTZ'), NULL,         NULL,       NULL,           NULL,          NULL,        NULL,            0, 0, 0},
 #endif
 };
@@ -1776,6 +2873,152 @@ static const SaveLoadFormat *GetSavegameFormat(char *s, byte *compression_level)
 	return def;
 }
 
+static const SaveLoadFormat *_diff_read_format; ///< When reading a savegame into memory, its format.
+
+/**
+ * Read from the savegame that is read into memory, and keep what is read.
+ * @return the number of bytes read
+ */
+static size_t ReadDiffCapture()
+{
+	size_t len = _diff_read_format->reader();
+	if (_diff_read->size + len > _diff_read->capacity) {
+		_diff_read->capacity = max(_diff_read->capacity * 2, _diff_read->size + len);
+		_diff_read->data = ReallocT(_diff_read->data, _diff_read->capacity);
+	}
+	memcpy(_diff_read->data + _diff_read->size, _sl.buf, len);
+	_diff_read->size += len;
+	return len;
+}
+
+/**
+ * Read the rest of a savegame that is in memory.
+ * @return the number of bytes read
+ */
+static size_t ReadDiffMemory()
+{
+	size_t len = _diff_read->size - _diff_read->pos;
+	_sl.buf = _diff_read->data + _diff_read->pos;
+	_diff_read->pos = _diff_read->size;
+	return len;
+}
+
+/** Free the savegames that have been read into memory. */
+static void UninitReadDiffMemory()
+{
+	if (_diff_read_format != NULL) _diff_read_format->uninit_read();
+	_diff_read_format = NULL;
+
+	free(_diff_delta.data);
+	free(_diff_base_data.data);
+	memset(&_diff_delta, 0, sizeof(_diff_delta));
+	memset(&_diff_base_data, 0, sizeof(_diff_base_data));
+	_diff_load_chunks.Clear();
+	_diff_read = NULL;
+}
+
+/**
+ * Start reading the rest of a savegame into memory.
+ * @param fmt the format of the savegame, of which the reader is initialized already
+ * @param mem the memory to read into
+ */
+static void StartDiffCapture(const SaveLoadFormat *fmt, DiffMemory *mem)
+{
+	_diff_read_format = fmt;
+	_diff_read = mem;
+	_sl.read_bytes = ReadDiffCapture;
+	_sl.bufp = _sl.bufe = NULL;
+	_sl.offs_base = 0;
+}
+
+/** Stop reading a savegame into memory and close its reader. */
+static void StopDiffCapture()
+{
+	_diff_read_format->uninit_read();
+	_diff_read_format = NULL;
+}
+
+/**
+ * Read a differential savegame and its base savegame into memory and prepare
+ * loading it from there. Afterwards the file of the base savegame is open.
+ * @param fmt      the format of the differential savegame, of which the reader is initialized already
+ * @param filename the name of the differential savegame
+ * @param sb       the directory of the differential savegame
+ */
+static void ReadDifferentialSavegame(const SaveLoadFormat *fmt, const char *filename, Subdirectory sb)
+{
+	_sl.excpt_uninit = UninitReadDiffMemory;
+
+	/* Read the differential savegame up to its terminator. */
+	StartDiffCapture(fmt, &_diff_delta);
+	if (SlReadUint32() != 'DIFB') SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "No base savegame");
+	char base_name[MAX_PATH];
+	uint len = SlReadUint16();
+	if (len >= lengthof(base_name)) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Invalid base savegame");
+	SlCopyBytes(base_name, len);
+	base_name[len] = '\0';
+	str_validate(base_name, lastof(base_name));
+
+	size_t first_chunk = SlGetOffs();
+	while (SlReadUint32() != 0) SlSkipChunk();
+	StopDiffCapture();
+
+	UnmapSavegameFile();
+	fclose(_sl.fh);
+	_sl.fh = NULL;
+
+	/* The base savegame is next to the differential savegame. */
+	char path[MAX_PATH];
+	strecpy(path, filename, lastof(path));
+	char *sep = strrchr(path, PATHSEPCHAR);
+	strecpy(sep == NULL ? path : sep + 1, base_name, lastof(path));
+	_sl.fh = FioFOpenFile(path, "rb", sb);
+	if (_sl.fh == NULL) _sl.fh = FioFOpenFile(base_name, "rb", AUTOSAVE_DIR);
+	if (_sl.fh == NULL) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "Base savegame not found");
+
+	uint32 hdr[2];
+	if (fread(hdr, sizeof(hdr), 1, _sl.fh) != 1) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+	const SaveLoadFormat *base_fmt = _saveload_formats;
+	while (base_fmt != endof(_saveload_formats) && base_fmt->tag != hdr[0]) base_fmt++;
+	/* The chunks of the base savegame are loaded as if they are of the version of the differential savegame. */
+	if (base_fmt == endof(_saveload_formats) || TO_BE32(hdr[1]) != (uint32)_sl_version << 16) {
+		SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Base savegame has changed");
+	}
+	if (base_fmt->init_read == NULL || !base_fmt->init_read(0)) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "Initializing loader of base savegame failed");
+	MapSavegameFile();
+
+	/* Read the whole base savegame and find its chunks. */
+	StartDiffCapture(base_fmt, &_diff_base_data);
+	for (;;) {
+		size_t start = SlGetOffs();
+		uint32 id = SlReadUint32();
+		if (id == 0) break;
+		SlSkipChunk();
+
+		DiffChunk *chunk = _diff_load_chunks.Append();
+		chunk->id = id;
+		chunk->start = start;
+		chunk->end = SlGetOffs();
+	}
+	StopDiffCapture();
+
+	for (DiffChunk *chunk = _diff_load_chunks.Begin(); chunk != _diff_load_chunks.End(); chunk++) {
+		Md5 checksum;
+		checksum.Append(_diff_base_data.data + chunk->start, chunk->end - chunk->start);
+		checksum.Finish(chunk->digest);
+	}
+
+	/* Continue with the first chunk of the differential savegame. */
+	_diff_delta.pos = first_chunk;
+	_diff_read = &_diff_delta;
+	_sl.read_bytes = ReadDiffMemory;
+	_sl.bufp = _sl.bufe = NULL;
+	_sl.offs_base = first_chunk;
+}
+
+/** The format of a differential savegame once it and its base savegame have been read into memory. */
+static const SaveLoadFormat _diff_memory_format = {"diff", 0, NULL, ReadDiffMemory, UninitReadDiffMemory, NULL, NULL, NULL, 0, 0, 0};
+
 /* actual loader/saver function */
 void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settings);
 extern bool AfterLoadGame();
@@ -1784,12 +3027,44 @@ extern bool LoadOldSaveGame(const char *file);
 /** Small helper function to close the to be loaded savegame an signal error */
 static inline SaveOrLoadResult AbortSaveLoad()
 {
+	UnmapSavegameFile();
 	if (_sl.fh != NULL) fclose(_sl.fh);
 
 	_sl.fh = NULL;
+	_sl_write_memory = NULL;
 	return SL_ERROR;
 }
 
+static const SaveLoadFormat *_save_format; ///< The format the savegame is written with, once its compressor is initialized.
+
+/**
+ * Compress a chunk of the savegame and write it to the file.
+ * @param buf  the data
+ * @param size the number of bytes of data
+ */
+static void WriteSaveChunk(byte *buf, size_t size)
+{
+	_ts.count += (uint)size;
+	_save_format->writer(buf, size);
+}
+
+/**
+ * Pass a full buffer to the compressor. With a save thread the buffer is
+ * queued for it and a new buffer is used, otherwise it is compressed
+ * right away and used again.
+ * @param size the number of bytes in the buffer
+ */
+static void WriteMem(size_t size)
+{
+	if (_save_queue_mutex == NULL) {
+		WriteSaveChunk(_sl.buf, size);
+		return;
+	}
+
+	PushSaveChunk(_sl.buf, size);
+	_sl.buf = MallocT<byte>(MEMORY_CHUNK_SIZE);
+}
+
 /** Update the gui accordingly when starting saving
  * and set locks on saveload. Also turn off fast-forward cause with that
  * saving takes Aaaaages */
@@ -1834,58 +3109,50 @@ const char *GetSaveLoadErrorString()
 /** Show a gui message when saving has failed */
 static void SaveFileError()
 {
+	/* The savegame might have overwritten the base savegame; start over with a new one. */
+	_diff_base[0] = '\0';
+
 	SetDParamStr(0, GetSaveLoadErrorString());
 	ShowErrorMessage(STR_JUST_RAW_STRING, INVALID_STRING_ID, WL_ERROR);
 	SaveFileDone();
 }
 
-/** We have written the whole game into memory, _memory_savegame, now find
- * and appropiate compressor and start writing to file.
+/**
+ * Write the chunks of the savegame to the file and close it at the end of the savegame.
+ * @param threaded whether this runs in the save thread, which gets the chunks from
+ *                 the queue; otherwise they have been written while saving already
+ * @return SL_OK when the whole savegame has been written
  */
 static SaveOrLoadResult SaveFileToDisk(bool threaded)
 {
-	_sl.excpt_uninit = NULL;
+	SaveChunk chunk = { NULL, 0 };
 	try {
-		byte compression;
-		const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression);
-
-		/* We have written our stuff to memory, now write it to file! */
-		uint32 hdr[2] = { fmt->tag, TO_BE32(SAVEGAME_VERSION << 16) };
-		if (fwrite(hdr, sizeof(hdr), 1, _sl.fh) != 1) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
-
-		if (!fmt->init_write(compression)) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize compressor");
-
-		uint i = 0;
-		size_t t = _ts.count;
-
-		if (_ts.count != _sl.offs_base) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Unexpected size of chunk");
-		while (t >= MEMORY_CHUNK_SIZE) {
-			_sl.buf = _memory_savegame[i++];
-			fmt->writer(MEMORY_CHUNK_SIZE);
-			t -= MEMORY_CHUNK_SIZE;
-		}
-
-		if (t != 0) {
-			/* The last block is (almost) always not fully filled, so only write away
-			 * as much data as it is in there */
-			_sl.buf = _memory_savegame[i];
-
-			assert(t == _ts.count % MEMORY_CHUNK_SIZE);
-			fmt->writer(t);
+		while (threaded && PopSaveChunk(&chunk)) {
+			WriteSaveChunk(chunk.buf, chunk.size);
+			free(chunk.buf);
+			chunk.buf = NULL;
 		}
+		/* The game thread cleans up; see AbortSaveFileToDisk. */
+		if (_ts.aborted) return SL_ERROR;
 
-		fmt->uninit_write();
 		if (_ts.count != _sl.offs_base) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "Unexpected size of chunk");
-		UnInitMem();
-		fclose(_sl.fh);
+
+		/* This must be the last thing that can fail; it only fails before it frees anything. */
+		_save_format->uninit_write();
+		if (_sl.fh != NULL) fclose(_sl.fh);
 
 		if (threaded) SetAsyncSaveFinish(SaveFileDone);
 
 		return SL_OK;
 	}
 	catch (...) {
+		/* Keep taking chunks, so the game thread doesn't wait for us forever. */
+		free(chunk.buf);
+		while (threaded && PopSaveChunk(&chunk)) free(chunk.buf);
+		if (_ts.aborted) return SL_ERROR;
+
 		AbortSaveLoad();
-		if (_sl.excpt_uninit != NULL) _sl.excpt_uninit();
+		_save_format->uninit_write();
 
 		/* Skip the "colour" character */
 		DEBUG(sl, 0, "%s", GetSaveLoadErrorString() + 3);
@@ -1906,11 +3173,238 @@ static void SaveFileToDiskThread(void *arg)
 
 void WaitTillSaved()
 {
+#ifdef WITH_SNAPSHOT_SAVE
+	FinishSnapshotSave(true);
+#endif
+
 	if (_save_thread == NULL) return;
 
 	_save_thread->Join();
 	delete _save_thread;
 	_save_thread = NULL;
+	delete _save_queue_mutex;
+	_save_queue_mutex = NULL;
+}
+
+/** Clean up when saving the game failed: stop the save thread and throw away the savegame. */
+static void AbortSaveFileToDisk()
+{
+	if (_save_queue_mutex != NULL) {
+		_ts.aborted = true;
+		PushSaveChunk(NULL, 0);
+		WaitTillSaved();
+	}
+
+	UnInitMem();
+	if (_sl.fh != NULL) fclose(_sl.fh);
+	_sl.fh = NULL;
+	_sl_write_memory = NULL;
+	if (_save_format != NULL) _save_format->uninit_write();
+	SaveFileError();
+}
+
+/**
+ * Write the header of the savegame, initialize the compressor and, when
+ * allowed, start the thread that compresses and writes the savegame
+ * while the game is still being saved.
+ * @param threaded whether a save thread may be used
+ */
+static void InitSaveFileToDisk(bool threaded)
+{
+	_sl.excpt_uninit = AbortSaveFileToDisk;
+	_ts.aborted = false;
+	_save_format = NULL;
+
+	byte compression;
+	const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression);
+
+	uint32 hdr[2] = { fmt->tag, TO_BE32(SAVEGAME_VERSION << 16 | (_diff_mode == DSM_DELTA ? SL_HEADER_DIFFERENTIAL : 0)) };
+	if (!SlWriteFile(hdr, sizeof(hdr))) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE);
+
+	if (!fmt->init_write(compression)) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize compressor");
+	_save_format = fmt;
+
+	/* The compressor might have set up its own buffer; we fill ours. */
+	_sl.write_bytes = WriteMem;
+	InitMem();
+
+	if (!threaded) return;
+
+	_save_queue_first = 0;
+	_save_queue_length = 0;
+	_save_queue_mutex = ThreadMutex::New();
+	if (!ThreadObject::New(&SaveFileToDiskThread, NULL, &_save_thread)) {
+		DEBUG(sl, 1, "Cannot create savegame thread, reverting to single-threaded mode...");
+		delete _save_queue_mutex;
+		_save_queue_mutex = NULL;
+	}
+}
+
+#ifdef WITH_SNAPSHOT_SAVE
+static pid_t _save_child = -1;    ///< The process that writes the snapshot save, or -1 when there is none.
+static int _save_child_pipe = -1; ///< The end of the pipe #_save_child reports why it failed through.
+
+/** Why the process writing the snapshot save failed. */
+struct SnapshotSaveError {
+	StringID error_str; ///< The translateable error message.
+	char extra_msg[256]; ///< The error message, empty if there's none.
+};
+
+/**
+ * Write the savegame in the copy of the process made for it and end that process.
+ * @param fd the pipe to report an error through
+ */
+static void NORETURN SaveSnapshot(int fd)
+{
+	SaveOrLoadResult result;
+	try {
+		InitSaveFileToDisk(false);
+		SlSaveChunks();
+		SlWriteFill(); // flush the save buffer
+		_sl.excpt_uninit = NULL;
+		UnInitMem();
+
+		result = SaveFileToDisk(false);
+	} catch (...) {
+		/* Nobody gets to see the error message windows of this process. */
+		UnInitMem();
+		if (_sl.fh != NULL) fclose(_sl.fh);
+		if (_save_format != NULL) _save_format->uninit_write();
+		result = SL_ERROR;
+	}
+
+	if (result == SL_OK && _diff_mode == DSM_BASE) {
+		/* Tell the game about the chunks of the new base savegame. */
+		uint num = _diff_new_base_chunks.Length();
+		size_t size = num * sizeof(DiffChunk);
+		if (write(fd, &num, sizeof(num)) != sizeof(num) || write(fd, _diff_new_base_chunks.Begin(), size) != (ssize_t)size) {
+			DEBUG(sl, 0, "Cannot report the chunks of the snapshot save");
+		}
+	}
+
+	if (result != SL_OK) {
+		SnapshotSaveError error;
+		error.error_str = _sl.error_str;
+		strecpy(error.extra_msg, _sl.extra_msg == NULL ? "" : _sl.extra_msg, lastof(error.extra_msg));
+		if (write(fd, &error, sizeof(error)) != sizeof(error)) DEBUG(sl, 0, "Cannot report the error of the snapshot save");
+	}
+
+	/* Don't run any of the clean up of the game; it belongs to the original process. */
+	_exit(result == SL_OK ? 0 : 1);
+}
+
+/**
+ * Start writing the savegame in a copy of the process, which sees the game
+ * as it is now while this process continues with the game.
+ * @return false if the process can't be copied and the game has to be saved here
+ */
+static bool StartSnapshotSave()
+{
+	int fds[2];
+	if (pipe(fds) != 0) {
+		DEBUG(sl, 1, "Cannot create pipe for snapshot save: %s", strerror(errno));
+		return false;
+	}
+
+	pid_t pid = fork();
+	switch (pid) {
+		case -1:
+			DEBUG(sl, 1, "Cannot fork for snapshot save, saving in the game process: %s", strerror(errno));
+			close(fds[0]);
+			close(fds[1]);
+			return false;
+
+		case 0:
+			/* The writer thread of the debug lines did not come along; do not DEBUG before this. */
+			DebugForgetWriter();
+			close(fds[0]);
+			SaveSnapshot(fds[1]);
+
+		default:
+			break;
+	}
+
+	/* The file is written by the child; nothing has been written to it here. */
+	close(fds[1]);
+	fclose(_sl.fh);
+	_sl.fh = NULL;
+
+	_save_child = pid;
+	_save_child_pipe = fds[0];
+	return true;
+}
+
+/**
+ * Handle the end of the process writing the snapshot save.
+ * @param wait whether to wait for it to end
+ */
+static void FinishSnapshotSave(bool wait)
+{
+	if (_save_child == -1) return;
+
+	int status;
+	pid_t pid;
+	do {
+		pid = waitpid(_save_child, &status, wait ? 0 : WNOHANG);
+	} while (pid == -1 && errno == EINTR);
+	if (pid == 0) return;
+
+	bool success = pid == _save_child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	if (!success) {
+		SnapshotSaveError error;
+		if (read(_save_child_pipe, &error, sizeof(error)) == sizeof(error)) {
+			error.extra_msg[lengthof(error.extra_msg) - 1] = '\0';
+			_sl.error_str = error.error_str;
+		} else {
+			_sl.error_str = STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR;
+			strecpy(error.extra_msg, "snapshot save process died", lastof(error.extra_msg));
+		}
+		free(_sl.extra_msg);
+		_sl.extra_msg = StrEmpty(error.extra_msg) ? NULL : strdup(error.extra_msg);
+		_sl.action = SLA_SAVE;
+	}
+
+	if (success && _diff_mode == DSM_BASE) {
+		/* The base savegame can only be used when it's known what chunks it has. */
+		uint num;
+		if (read(_save_child_pipe, &num, sizeof(num)) == sizeof(num)) {
+			_diff_new_base_chunks.Clear();
+			size_t size = num * sizeof(DiffChunk);
+			if (read(_save_child_pipe, _diff_new_base_chunks.Append(num), size) == (ssize_t)size) AdoptDifferentialBase();
+		}
+	}
+
+	close(_save_child_pipe);
+	_save_child_pipe = -1;
+	_save_child = -1;
+
+	if (success) {
+		SaveFileDone();
+	} else {
+		/* Skip the "colour" character */
+		DEBUG(sl, 0, "%s", GetSaveLoadErrorString() + 3);
+		SaveFileError();
+	}
+}
+#endif /* WITH_SNAPSHOT_SAVE */
+
+/**
+ * Get the memory used by the buffers of saving and loading. Most of it is
+ * only allocated while a savegame is written or read; the checksums of the
+ * chunks of the base of differential savegames are kept all the time.
+ * @return the number of bytes allocated for the buffers
+ */
+size_t GetSaveLoadMemoryUsage()
+{
+	size_t bytes = (_sl.buf_ori != NULL) ? _sl.bufsize : 0;
+	bytes += _diff_chunk_capacity;
+	if (_diff_delta.data != NULL) bytes += _diff_delta.capacity;
+	if (_diff_base_data.data != NULL) bytes += _diff_base_data.capacity;
+	bytes += (_diff_base_chunks.Length() + _diff_new_base_chunks.Length() + _diff_load_chunks.Length()) * sizeof(DiffChunk);
+#if defined(WITH_ZLIB)
+	bytes += _pzlib_num_blocks * (PZLIB_BLOCK_SIZE + compressBound(PZLIB_BLOCK_SIZE));
+#endif /* WITH_ZLIB */
+	return bytes;
 }
 
 /**
@@ -1926,8 +3420,8 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 {
 	uint32 hdr[2];
 
-	/* An instance of saving is already active, so don't go saving again */
-	if (_ts.saveinprogress && mode == SL_SAVE) {
+	/* An instance of saving is already active, so don't go saving again; saving into memory waits for it. */
+	if (_ts.saveinprogress && mode == SL_SAVE && _sl_write_memory == NULL) {
 		/* if not an autosave, but a user action, show error message */
 		if (!_do_autosave) ShowErrorMessage(STR_ERROR_SAVE_STILL_IN_PROGRESS, INVALID_STRING_ID, WL_ERROR);
 		return SL_OK;
@@ -1975,41 +3469,59 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 	}
 
 	try {
-		_sl.fh = (mode == SL_SAVE) ? FioFOpenFile(filename, "wb", sb) : FioFOpenFile(filename, "rb", sb);
+		if (mode == SL_SAVE && _sl_write_memory != NULL) {
+			_sl.fh = NULL;
+		} else {
+			_sl.fh = (mode == SL_SAVE) ? FioFOpenFile(filename, "wb", sb) : FioFOpenFile(filename, "rb", sb);
+		}
 
 		/* Make it a little easier to load savegames from the console */
 		if (_sl.fh == NULL && mode != SL_SAVE) _sl.fh = FioFOpenFile(filename, "rb", SAVE_DIR);
 		if (_sl.fh == NULL && mode != SL_SAVE) _sl.fh = FioFOpenFile(filename, "rb", BASE_DIR);
 
-		if (_sl.fh == NULL) {
+		if (!SlHasOutput()) {
 			SlError(mode == SL_SAVE ? STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE : STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
 		}
 
-		/* General tactic is to first save the game to memory, then use an available writer
-		 * to write it to file, either in threaded mode if possible, or single-threaded */
+		/* General tactic is to save the game to memory in chunks, and to use an available
+		 * writer to compress them and write them to file. In threaded mode a separate thread
+		 * does so while the next chunks are saved, otherwise every full chunk is written
+		 * right away. Either way only a few chunks are kept in memory. */
 		if (mode == SL_SAVE) { // SAVE game
-			DEBUG(desync, 1, "save: %08x; %02x; %s", _date, _date_fract, filename);
-
-			_sl.write_bytes = WriteMem;
-			_sl.excpt_uninit = UnInitMem;
-			InitMem();
+			DEBUG(desync, 1, "save: %08x; %02x; %s", _date, _date_fract, filename == NULL ? "(memory)" : filename);
 
 			_sl_version = SAVEGAME_VERSION;
 
 			SaveViewportBeforeSaveGame();
-			SlSaveChunks();
-			SlWriteFill(); // flush the save buffer
-
 			SaveFileStart();
+			if (_sl_write_memory == NULL) {
+				PrepareDifferentialSave(filename, sb);
+			} else {
+				_diff_mode = DSM_NONE;
+			}
+#ifdef WITH_SNAPSHOT_SAVE
+			/* Let a copy of the game save the autosave, so the game doesn't have to wait for it. */
+			if (_do_autosave && _sl_write_memory == NULL && _settings_client.gui.snapshot_autosaves && StartSnapshotSave()) return SL_OK;
+#endif
 			if (_network_server || !_settings_client.gui.threaded_saves) threaded = false;
-			if (!threaded || !ThreadObject::New(&SaveFileToDiskThread, NULL, &_save_thread)) {
-				if (threaded) DEBUG(sl, 1, "Cannot create savegame thread, reverting to single-threaded mode...");
-
-				SaveOrLoadResult result = SaveFileToDisk(false);
-				SaveFileDone();
+			InitSaveFileToDisk(threaded);
 
-				return result;
+			SlSaveChunks();
+			SlWriteFill(); // flush the save buffer
+			_sl.excpt_uninit = NULL;
+			UnInitMem();
+			if (_diff_mode == DSM_BASE) AdoptDifferentialBase();
+
+			if (_save_queue_mutex != NULL) {
+				/* The save thread writes the remaining chunks and closes the file. */
+				PushSaveChunk(NULL, 0);
+				return SL_OK;
 			}
+
+			SaveOrLoadResult result = SaveFileToDisk(false);
+			SaveFileDone();
+
+			return result;
 		} else { // LOAD game
 			assert(mode == SL_LOAD || mode == SL_LOAD_CHECK);
 			DEBUG(desync, 1, "load: %s", filename);
@@ -2020,6 +3532,7 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 
 			/* see if we have any loader for this type. */
 			const SaveLoadFormat *fmt = _saveload_formats;
+			bool differential = false;
 			for (;;) {
 				/* No loader found, treat as version 0 and use LZO format */
 				if (fmt == endof(_saveload_formats)) {
@@ -2055,6 +3568,7 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 
 					/* Is the version higher than the current? */
 					if (_sl_version > SAVEGAME_VERSION) SlError(STR_GAME_SAVELOAD_ERROR_TOO_NEW_SAVEGAME);
+					differential = !CheckSavegameVersion(146) && (TO_BE32(hdr[1]) & SL_HEADER_DIFFERENTIAL) != 0;
 					break;
 				}
 
@@ -2076,6 +3590,12 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 				snprintf(err_str, lengthof(err_str), "Initializing loader '%s' failed", fmt->name);
 				SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, err_str);
 			}
+			MapSavegameFile();
+
+			if (differential) {
+				ReadDifferentialSavegame(fmt, filename, sb);
+				fmt = &_diff_memory_format;
+			}
 
 			if (mode != SL_LOAD_CHECK) {
 				_engine_mngr.ResetToDefaultMapping();
@@ -2123,6 +3643,7 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 				SlFixPointers();
 			}
 			fmt->uninit_read();
+			UnmapSavegameFile();
 			fclose(_sl.fh);
 
 			_savegame_type = SGT_OTTD;
@@ -2147,11 +3668,11 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 		return SL_OK;
 	}
 	catch (...) {
-		AbortSaveLoad();
-
-		/* deinitialize compressor. */
+		/* deinitialize compressor; before closing the file, a save thread might still write to it. */
 		if (_sl.excpt_uninit != NULL) _sl.excpt_uninit();
 
+		AbortSaveLoad();
+
 		/* Skip the "colour" character */
 		if (mode != SL_LOAD_CHECK) DEBUG(sl, 0, "%s", GetSaveLoadErrorString() + 3);
 
@@ -2160,6 +3681,31 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 	}
 }
 
+/**
+ * Save the game into memory instead of into a file. The savegame is the
+ * same as the one that would be written to a file, so it can be loaded
+ * as a file again.
+ * @param[out] data is set to the savegame, which must be freed by the caller
+ * @param[out] size is set to the number of bytes of the savegame
+ * @return SL_OK when the game has been saved
+ */
+SaveOrLoadResult SaveToMemory(byte **data, size_t *size)
+{
+	DiffMemory mem = { NULL, 0, 0, 0 };
+	_sl_write_memory = &mem;
+	SaveOrLoadResult result = SaveOrLoad(NULL, SL_SAVE, NO_DIRECTORY, false);
+	_sl_write_memory = NULL;
+
+	if (result != SL_OK) {
+		free(mem.data);
+		mem.data = NULL;
+		mem.size = 0;
+	}
+	*data = mem.data;
+	*size = mem.size;
+	return result;
+}
+
 /** Do a save when exiting the game (_settings_client.gui.autosave_on_exit) */
 void DoExitSave()
 {
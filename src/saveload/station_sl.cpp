@@ -89,6 +89,9 @@ void MoveBuoysToWaypoints()
 
 void AfterLoadStations()
 {
+	/* The stations and their specs may be different ones now. */
+	InvalidateStationRelocationCache();
+
 	/* Update the speclists of all stations to point to the currently loaded custom stations. */
 	BaseStation *st;
 	FOR_ALL_BASE_STATIONS(st) {
@@ -238,7 +241,7 @@ const SaveLoad *GetGoodsDesc()
 		     SLE_VAR(GoodsEntry, last_age,            SLE_UINT8),
 		SLEG_CONDVAR(            _cargo_feeder_share, SLE_FILE_U32 | SLE_VAR_I64, 14, 64),
 		SLEG_CONDVAR(            _cargo_feeder_share, SLE_INT64,                  65, 67),
-		 SLE_CONDLST(GoodsEntry, cargo.packets,       REF_CARGO_PACKET,           68, SL_MAX_VERSION),
+		 SLE_CONDDEQ(GoodsEntry, cargo.packets,       REF_CARGO_PACKET,           68, SL_MAX_VERSION),
 
 		SLE_END()
 	};
@@ -374,17 +377,17 @@ const SaveLoad *GetBaseStationDescription()
 static void RealSave_STNN(BaseStation *bst)
 {
 	bool waypoint = (bst->facilities & FACIL_WAYPOINT) != 0;
-	SlObject(bst, waypoint ? _waypoint_desc : _station_desc);
+	SlCompiledObject(bst, waypoint ? _waypoint_desc : _station_desc);
 
 	if (!waypoint) {
 		Station *st = Station::From(bst);
 		for (CargoID i = 0; i < NUM_CARGO; i++) {
-			SlObject(&st->goods[i], GetGoodsDesc());
+			SlCompiledObject(&st->goods[i], GetGoodsDesc());
 		}
 	}
 
 	for (uint i = 0; i < bst->num_specs; i++) {
-		SlObject(&bst->speclist[i], _station_speclist_desc);
+		SlCompiledObject(&bst->speclist[i], _station_speclist_desc);
 	}
 }
 
@@ -406,12 +409,12 @@ static void Load_STNN()
 		bool waypoint = (SlReadByte() & FACIL_WAYPOINT) != 0;
 
 		BaseStation *bst = waypoint ? (BaseStation *)new (index) Waypoint() : new (index) Station();
-		SlObject(bst, waypoint ? _waypoint_desc : _station_desc);
+		SlCompiledObject(bst, waypoint ? _waypoint_desc : _station_desc);
 
 		if (!waypoint) {
 			Station *st = Station::From(bst);
 			for (CargoID i = 0; i < NUM_CARGO; i++) {
-				SlObject(&st->goods[i], GetGoodsDesc());
+				SlCompiledObject(&st->goods[i], GetGoodsDesc());
 			}
 		}
 
@@ -419,7 +422,7 @@ static void Load_STNN()
 			/* Allocate speclist memory when loading a game */
 			bst->speclist = CallocT<StationSpecList>(bst->num_specs);
 			for (uint i = 0; i < bst->num_specs; i++) {
-				SlObject(&bst->speclist[i], _station_speclist_desc);
+				SlCompiledObject(&bst->speclist[i], _station_speclist_desc);
 			}
 		}
 	}
@@ -451,7 +454,7 @@ static void Save_ROADSTOP()
 
 	FOR_ALL_ROADSTOPS(rs) {
 		SlSetArrayIndex(rs->index);
-		SlObject(rs, _roadstop_desc);
+		SlCompiledObject(rs, _roadstop_desc);
 	}
 }
 
@@ -462,7 +465,7 @@ static void Load_ROADSTOP()
 	while ((index = SlIterateArray()) != -1) {
 		RoadStop *rs = new (index) RoadStop(INVALID_TILE);
 
-		SlObject(rs, _roadstop_desc);
+		SlCompiledObject(rs, _roadstop_desc);
 	}
 }
 
@@ -248,6 +248,8 @@ void AfterLoadVehicles(bool part_of_load)
 		if (v->NextShared() != NULL) v->NextShared()->previous_shared = v;
 
 		v->UpdateDeltaXY(v->direction);
+		/* The NewGRFs might have changed, so anything cached from them is invalid */
+		v->InvalidateNewGRFCache();
 
 		if (part_of_load) v->fill_percent_te_id = INVALID_TE_ID;
 		v->first = NULL;
@@ -449,7 +451,7 @@ const SaveLoad *GetVehicleDescription(VehicleType vt)
 		SLEG_CONDVAR(         _cargo_source_xy,      SLE_UINT32,                  44,  67),
 		     SLE_VAR(Vehicle, cargo_cap,             SLE_UINT16),
 		SLEG_CONDVAR(         _cargo_count,          SLE_UINT16,                   0,  67),
-		 SLE_CONDLST(Vehicle, cargo.packets,         REF_CARGO_PACKET,            68, SL_MAX_VERSION),
+		 SLE_CONDDEQ(Vehicle, cargo.packets,         REF_CARGO_PACKET,            68, SL_MAX_VERSION),
 
 		     SLE_VAR(Vehicle, day_counter,           SLE_UINT8),
 		     SLE_VAR(Vehicle, tick_counter,          SLE_UINT8),
@@ -569,6 +571,14 @@ const SaveLoad *GetVehicleDescription(VehicleType vt)
 		 SLE_CONDVAR(RoadVehicle, gv_flags,             SLE_UINT16,                 139, SL_MAX_VERSION),
 		SLE_CONDNULL(4,                                                              69, 130),
 		SLE_CONDNULL(2,                                                               6, 130),
+		 SLE_CONDARR(RoadVehicle, path.tile,            SLE_UINT32, RV_PATH_CACHE_SIZE, 144, SL_MAX_VERSION),
+		 SLE_CONDARR(RoadVehicle, path.td,              SLE_UINT8,  RV_PATH_CACHE_SIZE, 144, SL_MAX_VERSION),
+		 SLE_CONDVAR(RoadVehicle, path.count,           SLE_UINT8,                  144, SL_MAX_VERSION),
+		 SLE_CONDVAR(RoadVehicle, path.dest_tile,       SLE_UINT32,                 144, SL_MAX_VERSION),
+		 SLE_CONDVAR(RoadVehicle, path.min_x,           SLE_UINT16,                 144, SL_MAX_VERSION),
+		 SLE_CONDVAR(RoadVehicle, path.min_y,           SLE_UINT16,                 144, SL_MAX_VERSION),
+		 SLE_CONDVAR(RoadVehicle, path.max_x,           SLE_UINT16,                 144, SL_MAX_VERSION),
+		 SLE_CONDVAR(RoadVehicle, path.max_y,           SLE_UINT16,                 144, SL_MAX_VERSION),
 		/* reserve extra space in savegame here. (currently 16 bytes) */
 		SLE_CONDNULL(16,                                                              2, SL_MAX_VERSION),
 
@@ -698,7 +708,7 @@ static void Save_VEHS()
 	/* Write the vehicles */
 	FOR_ALL_VEHICLES(v) {
 		SlSetArrayIndex(v->index);
-		SlObject(v, GetVehicleDescription(v->type));
+		SlCompiledObject(v, GetVehicleDescription(v->type));
 	}
 }
 
@@ -724,7 +734,7 @@ void Load_VEHS()
 			default: NOT_REACHED();
 		}
 
-		SlObject(v, GetVehicleDescription(vtype));
+		SlCompiledObject(v, GetVehicleDescription(vtype));
 
 		if (_cargo_count != 0 && IsCompanyBuildableVehicleType(v)) {
 			/* Don't construct the packet with station here, because that'll fail with old savegames */
@@ -23,6 +23,7 @@
 #include "company_func.h"
 #include "strings_func.h"
 #include "gui.h"
+#include "console_func.h"
 
 #include "table/strings.h"
 
@@ -568,17 +569,25 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	_screen_disable_anim = old_disable_anim;
 }
 
-static const char *MakeScreenshotName(const char *ext)
+/**
+ * Give the screenshot the default name, when it has no name yet.
+ * @return true when the name was generated
+ */
+static bool GenerateScreenshotName()
 {
-	bool generate = StrEmpty(_screenshot_name);
+	if (!StrEmpty(_screenshot_name)) return false;
 
-	if (generate) {
-		if (_game_mode == GM_EDITOR || _game_mode == GM_MENU || _local_company == COMPANY_SPECTATOR) {
-			strecpy(_screenshot_name, "screenshot", lastof(_screenshot_name));
-		} else {
-			GenerateDefaultSaveName(_screenshot_name, lastof(_screenshot_name));
-		}
+	if (_game_mode == GM_EDITOR || _game_mode == GM_MENU || _local_company == COMPANY_SPECTATOR) {
+		strecpy(_screenshot_name, "screenshot", lastof(_screenshot_name));
+	} else {
+		GenerateDefaultSaveName(_screenshot_name, lastof(_screenshot_name));
 	}
+	return true;
+}
+
+static const char *MakeScreenshotName(const char *ext)
+{
+	bool generate = GenerateScreenshotName();
 
 	/* Add extension to screenshot file */
 	size_t len = strlen(_screenshot_name);
@@ -624,6 +633,134 @@ static bool MakeWorldScreenshot()
 	return sf->proc(MakeScreenshotName(sf->extension), LargeWorldCallback, &vp, vp.width, vp.height, BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth(), _cur_palette);
 }
 
+static const uint SCREENSHOT_TILE_SIZE      = 256; ///< Width and height in pixels of the images of a tiles screenshot.
+static const uint SCREENSHOT_TILES_PER_LOOP =   8; ///< Number of images of a tiles screenshot that are made each game loop.
+
+/**
+ * A screenshot of the whole map as a pyramid of small images, one level
+ * for every zoom level, as web map viewers use them. The images are made
+ * a few at a time each game loop, so the game goes on while it is made.
+ * That also means vehicles may have moved between neighbouring images.
+ */
+struct TilesScreenshot {
+	bool active;             ///< Whether a tiles screenshot is being made.
+	char dir[MAX_PATH];      ///< The directory the images are written to, ending with a path separator.
+	const char *extension;   ///< The extension of the format the images are written in.
+	ZoomLevel zoom;          ///< The zoom level of the images that are being made.
+	uint columns;            ///< The number of images next to each other at this zoom level.
+	uint rows;               ///< The number of images below each other at this zoom level.
+	uint column;             ///< The column of the next image to make.
+	uint row;                ///< The row of the next image to make.
+	uint map_size;           ///< The size of the map the screenshot is of.
+	uint images;             ///< The number of images that have been made.
+};
+
+static TilesScreenshot _tiles_screenshot;
+
+/**
+ * Start on the images of the next zoom level of the tiles screenshot.
+ * @param zoom the zoom level
+ */
+static void SetTilesScreenshotZoom(ZoomLevel zoom)
+{
+	_tiles_screenshot.zoom = zoom;
+	_tiles_screenshot.columns = CeilDiv(UnScaleByZoom((MapMaxX() + MapMaxY()) * TILE_PIXELS, zoom), SCREENSHOT_TILE_SIZE);
+	_tiles_screenshot.rows = CeilDiv(UnScaleByZoom((MapMaxX() + MapMaxY()) * TILE_PIXELS >> 1, zoom), SCREENSHOT_TILE_SIZE);
+	_tiles_screenshot.column = 0;
+	_tiles_screenshot.row = 0;
+}
+
+/**
+ * Start making a tiles screenshot. The images are written to a directory
+ * named after the screenshot with "_tiles" appended, as
+ * "<zoom>_<column>_<row>.<extension>"; zoom 0 is the farthest zoom level.
+ * An existing directory is written over, so a web map can be refreshed.
+ * @return false if no images can be made with this blitter
+ */
+static bool StartTilesScreenshot()
+{
+	if (BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 0) return false;
+
+	GenerateScreenshotName();
+	if (snprintf(_tiles_screenshot.dir, lengthof(_tiles_screenshot.dir), "%s%s_tiles" PATHSEP, _personal_dir, _screenshot_name) >= (int)lengthof(_tiles_screenshot.dir)) return false;
+	FioCreateDirectory(_tiles_screenshot.dir);
+
+	_tiles_screenshot.active = true;
+	_tiles_screenshot.extension = _screenshot_formats[_cur_screenshot_format].extension;
+	_tiles_screenshot.map_size = MapSize();
+	_tiles_screenshot.images = 0;
+	SetTilesScreenshotZoom(ZOOM_LVL_MAX);
+
+	IConsolePrintF(CC_DEFAULT, "Making a tiles screenshot in '%s'", _tiles_screenshot.dir);
+	return true;
+}
+
+/**
+ * Make the next image of the tiles screenshot.
+ * @return false if it could not be written
+ */
+static bool MakeTilesScreenshotImage()
+{
+	ZoomLevel zoom = _tiles_screenshot.zoom;
+	uint x = _tiles_screenshot.column * SCREENSHOT_TILE_SIZE;
+	uint y = _tiles_screenshot.row * SCREENSHOT_TILE_SIZE;
+
+	ViewPort vp;
+	vp.zoom = zoom;
+	vp.left = 0;
+	vp.top = 0;
+	vp.width = min(SCREENSHOT_TILE_SIZE, UnScaleByZoom((MapMaxX() + MapMaxY()) * TILE_PIXELS, zoom) - x);
+	vp.height = min(SCREENSHOT_TILE_SIZE, UnScaleByZoom((MapMaxX() + MapMaxY()) * TILE_PIXELS >> 1, zoom) - y);
+	vp.virtual_left = -(int)MapMaxX() * TILE_PIXELS + ScaleByZoom(x, zoom);
+	vp.virtual_top = ScaleByZoom(y, zoom);
+	vp.virtual_width = ScaleByZoom(vp.width, zoom);
+	vp.virtual_height = ScaleByZoom(vp.height, zoom);
+
+	char name[MAX_PATH];
+	if (snprintf(name, lengthof(name), "%s%d_%u_%u.%s", _tiles_screenshot.dir, ZOOM_LVL_MAX - zoom, _tiles_screenshot.column, _tiles_screenshot.row, _tiles_screenshot.extension) >= (int)lengthof(name)) return false;
+
+	const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
+	return sf->proc(name, LargeWorldCallback, &vp, vp.width, vp.height, BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth(), _cur_palette);
+}
+
+/**
+ * Make the next few images of the tiles screenshot that is being made, if
+ * one is being made. Called every game loop.
+ */
+void ContinueTilesScreenshot()
+{
+	if (!_tiles_screenshot.active) return;
+
+	/* The map the screenshot was of is gone. */
+	if (_game_mode == GM_MENU || MapSize() != _tiles_screenshot.map_size) {
+		_tiles_screenshot.active = false;
+		ShowErrorMessage(STR_ERROR_SCREENSHOT_FAILED, INVALID_STRING_ID, WL_ERROR);
+		return;
+	}
+
+	for (uint i = 0; i < SCREENSHOT_TILES_PER_LOOP; i++) {
+		if (!MakeTilesScreenshotImage()) {
+			_tiles_screenshot.active = false;
+			ShowErrorMessage(STR_ERROR_SCREENSHOT_FAILED, INVALID_STRING_ID, WL_ERROR);
+			return;
+		}
+		_tiles_screenshot.images++;
+
+		if (++_tiles_screenshot.column < _tiles_screenshot.columns) continue;
+		_tiles_screenshot.column = 0;
+		if (++_tiles_screenshot.row < _tiles_screenshot.rows) continue;
+
+		if (_tiles_screenshot.zoom == ZOOM_LVL_MIN) {
+			_tiles_screenshot.active = false;
+			IConsolePrintF(CC_DEFAULT, "Tiles screenshot done; %u images", _tiles_screenshot.images);
+			SetDParamStr(0, _tiles_screenshot.dir);
+			ShowErrorMessage(STR_MESSAGE_SCREENSHOT_SUCCESSFULLY, INVALID_STRING_ID, WL_WARNING);
+			return;
+		}
+		SetTilesScreenshotZoom((ZoomLevel)(_tiles_screenshot.zoom - 1));
+	}
+}
+
 /**
  * Make an actual screenshot.
  * @param t    the type of screenshot to make.
@@ -655,6 +792,12 @@ bool MakeScreenshot(ScreenshotType t, const char *name)
 			ret = MakeWorldScreenshot();
 			break;
 
+		case SC_TILES:
+			/* Whether it succeeded is told once the last image is made. */
+			if (StartTilesScreenshot()) return true;
+			ret = false;
+			break;
+
 		default:
 			NOT_REACHED();
 	}
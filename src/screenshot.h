@@ -22,9 +22,11 @@ enum ScreenshotType {
 	SC_VIEWPORT, ///< Screenshot of viewport
 	SC_RAW,      ///< Raw screenshot from blitter buffer
 	SC_WORLD,    ///< World screenshot
+	SC_TILES,    ///< World screenshot as a pyramid of small images, made in the background
 };
 
 bool MakeScreenshot(ScreenshotType t, const char *name);
+void ContinueTilesScreenshot();
 
 extern char _screenshot_format_name[8];
 extern uint _num_screenshot_formats;
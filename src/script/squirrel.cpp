@@ -11,15 +11,26 @@
 
 #include <squirrel.h>
 #include <stdarg.h>
+#include <sys/stat.h>
 #include "../stdafx.h"
 #include "../debug.h"
 #include "squirrel.hpp"
 #include "squirrel_std.hpp"
 #include "../fileio_func.h"
+#include "../string_func.h"
+#include "../core/math_func.hpp"
+#include "../rev.h"
+#include "../3rdparty/md5/md5.h"
 #include <sqstdaux.h>
 #include <../squirrel/sqpcheader.h>
 #include <../squirrel/sqvm.h>
 
+/** The directory, relative to the personal directory, compiled scripts are cached in. */
+#define SCRIPT_CACHE_DIR "script_cache" PATHSEP
+
+/* Defined in sqmem.cpp; the counter the memory allocated by the VMs is accounted to. */
+extern SQInteger *_sq_vm_allocated;
+
 void Squirrel::CompileError(HSQUIRRELVM vm, const SQChar *desc, const SQChar *source, SQInteger line, SQInteger column)
 {
 	SQChar buf[1024];
@@ -187,9 +198,25 @@ bool Squirrel::MethodExists(HSQOBJECT instance, const char *method_name)
 	return true;
 }
 
+/** Add the operations a VM executed to a counter, also when the VM is left by an exception. */
+class SquirrelOpsCounter {
+	HSQUIRRELVM vm;  ///< The VM to count the operations of.
+	int suspend;     ///< The number of operations the VM was allowed to execute.
+	uint64 *counter; ///< The counter to add the executed operations to.
+
+public:
+	SquirrelOpsCounter(HSQUIRRELVM vm, int suspend, uint64 *counter) : vm(vm), suspend(suspend), counter(counter) {}
+
+	~SquirrelOpsCounter()
+	{
+		if (this->suspend >= 0 && this->vm->_ops_till_suspend < this->suspend) *this->counter += this->suspend - this->vm->_ops_till_suspend;
+	}
+};
+
 bool Squirrel::Resume(int suspend)
 {
 	assert(!this->crashed);
+	SquirrelOpsCounter counter(this->vm, suspend, &this->ops_executed);
 	this->crashed = !sq_resumecatch(this->vm, suspend);
 	return this->vm->_suspended != 0;
 }
@@ -200,9 +227,63 @@ void Squirrel::ResumeError()
 	sq_resumeerror(this->vm);
 }
 
-void Squirrel::CollectGarbage()
+/* static */ void Squirrel::ProfileHook(HSQUIRRELVM vm)
+{
+	SquirrelProfile *profile = ((Squirrel *)sq_getforeignptr(vm))->profile;
+	profile->samples++;
+
+	SQStackInfos si;
+	if (SQ_FAILED(sq_stackinfos(vm, 0, &si))) return;
+
+	/* SQ2OTTD may use a static buffer, so convert one string at a time. */
+	char line[16];
+	seprintf(line, lastof(line), ":%d)", (int)si.line);
+	std::string function(si.funcname == NULL ? "unknown" : SQ2OTTD(si.funcname));
+	function += " (";
+	function += si.source == NULL ? "unknown" : SQ2OTTD(si.source);
+	function += line;
+	profile->functions[function]++;
+
+	/* Walk up the call stack; keep the deepest calls when it is very deep. */
+	std::string stack;
+	for (SQInteger level = 0; level < 32 && SQ_SUCCEEDED(sq_stackinfos(vm, level, &si)); level++) {
+		std::string name(si.funcname == NULL ? "unknown" : SQ2OTTD(si.funcname));
+		stack = level == 0 ? name : name + ';' + stack;
+	}
+	profile->call_stacks[stack]++;
+}
+
+void Squirrel::StartProfile(uint interval)
+{
+	delete this->profile;
+	this->profile = new SquirrelProfile(max(interval, 1U));
+	this->vm->_profile_hook = &Squirrel::ProfileHook;
+	this->vm->_profile_interval = this->profile->interval;
+	this->vm->_profile_countdown = this->profile->interval;
+}
+
+void Squirrel::StopProfile()
 {
-	sq_collectgarbage(this->vm);
+	this->vm->_profile_hook = NULL;
+}
+
+bool Squirrel::IsProfiling() const
+{
+	return this->vm->_profile_hook != NULL;
+}
+
+int Squirrel::CollectGarbage()
+{
+	return sq_collectgarbage(this->vm);
+}
+
+uint Squirrel::GetCollectableObjectCount()
+{
+	uint count = 0;
+#ifndef NO_GARBAGE_COLLECTOR
+	for (SQCollectable *c = _ss(this->vm)->_gc_chain; c != NULL; c = c->_next) count++;
+#endif
+	return count;
 }
 
 bool Squirrel::CallMethod(HSQOBJECT instance, const char *method_name, HSQOBJECT *ret, int suspend)
@@ -225,6 +306,7 @@ bool Squirrel::CallMethod(HSQOBJECT instance, const char *method_name, HSQOBJECT
 	}
 	/* Call the method */
 	sq_pushobject(this->vm, instance);
+	SquirrelOpsCounter counter(this->vm, suspend, &this->ops_executed);
 	if (SQ_FAILED(sq_call(this->vm, 1, ret == NULL ? SQFalse : SQTrue, SQTrue, suspend))) return false;
 	if (ret != NULL) sq_getstackobj(vm, -1, ret);
 	/* Reset the top, but don't do so for the AI main function, as we need
@@ -308,6 +390,12 @@ bool Squirrel::CreateClassInstance(const char *class_name, void *real_instance,
 
 Squirrel::Squirrel()
 {
+	this->allocated_size = 0;
+	this->ops_executed = 0;
+	this->native_depth = 0;
+	this->profile = NULL;
+
+	SquirrelAccountingScope accounting(this);
 	this->vm = sq_open(1024);
 	this->print_func = NULL;
 	this->global_pointer = NULL;
@@ -414,6 +502,99 @@ static SQInteger _io_file_read(SQUserPointer file, SQUserPointer buf, SQInteger
 	return ret;
 }
 
+static SQInteger _io_file_write(SQUserPointer file, SQUserPointer buf, SQInteger size)
+{
+	return fwrite(buf, 1, size, (FILE *)file);
+}
+
+/**
+ * Get the name of the file the compiled form of a script is cached in. The
+ *  name is the MD5 sum of the name of the script, of the version of OpenTTD
+ *  and Squirrel, and of either the size and modification time of the file
+ *  (or tar) the script is in or, when those are unknown, its contents. So
+ *  changing any of them makes a new entry, while a script that did not
+ *  change does not even have to be read.
+ * @param file     The script, positioned at its start; the position is restored.
+ * @param size     The size of the script.
+ * @param filename The name of the script, as it is used in error messages.
+ * @param buf      The buffer for the name of the cache file.
+ * @param last     The last element of the buffer.
+ * @return False when the script could not be read.
+ */
+static bool GetScriptCacheFilename(FILE *file, size_t size, const char *filename, char *buf, const char *last)
+{
+	long start = ftell(file);
+	Md5 checksum;
+	checksum.Append(filename, strlen(filename) + 1);
+	checksum.Append(_openttd_revision, strlen(_openttd_revision) + 1);
+	checksum.Append(SQUIRREL_VERSION, sizeof(SQUIRREL_VERSION));
+
+	struct stat st;
+	if (fstat(fileno(file), &st) == 0) {
+		/* For a script in a tar these are of the tar, so add where in the tar the script is. */
+		uint64 stamp[4] = { (uint64)start, (uint64)size, (uint64)st.st_size, (uint64)st.st_mtime };
+		checksum.Append(stamp, sizeof(stamp));
+	} else {
+		uint8 buffer[4096];
+		while (size != 0) {
+			size_t len = fread(buffer, 1, min<size_t>(size, sizeof(buffer)), file);
+			if (len == 0) break;
+			checksum.Append(buffer, len);
+			size -= len;
+		}
+		if (size != 0 || fseek(file, start, SEEK_SET) != 0) return false;
+	}
+
+	uint8 md5sum[16];
+	checksum.Finish(md5sum);
+
+	char *p = buf + seprintf(buf, last, "%s" SCRIPT_CACHE_DIR, _personal_dir);
+	p = md5sumToString(p, last, md5sum);
+	seprintf(p, last, ".cnut");
+	return true;
+}
+
+/**
+ * Load the compiled form of a script from the cache, and push it on the stack.
+ * @param vm       The VM to load the script in.
+ * @param filename The name of the cache file.
+ * @return Whether the cache had a valid compiled form of the script.
+ */
+static bool LoadCachedScript(HSQUIRRELVM vm, const char *filename)
+{
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL) return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	SQFile f(file, size < 0 ? 0 : size);
+	bool ret = size > 0 && SQ_SUCCEEDED(sq_readclosure(vm, _io_file_read, &f));
+	fclose(file);
+	return ret;
+}
+
+/**
+ * Store the compiled script at the top of the stack in the cache.
+ * @param vm       The VM the script was compiled in.
+ * @param filename The name of the cache file.
+ */
+static void SaveCachedScript(HSQUIRRELVM vm, const char *filename)
+{
+	char dir[MAX_PATH];
+	seprintf(dir, lastof(dir), "%s" SCRIPT_CACHE_DIR, _personal_dir);
+	FioCreateDirectory(dir);
+
+	FILE *file = fopen(filename, "wb");
+	if (file == NULL) return;
+
+	bool ret = SQ_SUCCEEDED(sq_writeclosure(vm, _io_file_write, file));
+	fclose(file);
+	/* Never leave a half written entry behind. */
+	if (!ret) remove(filename);
+}
+
 /* static */ SQRESULT Squirrel::LoadFile(HSQUIRRELVM vm, const char *filename, SQBool printerror)
 {
 	size_t size;
@@ -424,6 +605,9 @@ static SQInteger _io_file_read(SQUserPointer file, SQUserPointer buf, SQInteger
 	SQLEXREADFUNC func;
 
 	if (file != NULL) {
+		char cache_file[MAX_PATH];
+		bool cacheable = GetScriptCacheFilename(file, size, filename, cache_file, lastof(cache_file));
+
 		SQFile f(file, size);
 		ret = fread(&us, 1, sizeof(us), file);
 		/* Most likely an empty file */
@@ -455,7 +639,14 @@ static SQInteger _io_file_read(SQUserPointer file, SQUserPointer buf, SQInteger
 			default: func = _io_file_lexfeed_ASCII; fseek(file, -2, SEEK_CUR); break; // ASCII
 		}
 
+		/* Use the compiled form of the script when it is cached, as compiling takes a while for big scripts. */
+		if (cacheable && LoadCachedScript(vm, cache_file)) {
+			FioFCloseFile(file);
+			return SQ_OK;
+		}
+
 		if (SQ_SUCCEEDED(sq_compile(vm, func, &f, OTTD2SQ(filename), printerror))) {
+			if (cacheable) SaveCachedScript(vm, cache_file);
 			FioFCloseFile(file);
 			return SQ_OK;
 		}
@@ -490,9 +681,16 @@ bool Squirrel::LoadScript(const char *script)
 
 Squirrel::~Squirrel()
 {
+	/* The memory freed by closing the VM must not be accounted to any engine. */
+	SQInteger *last = (_sq_vm_allocated == &this->allocated_size) ? NULL : _sq_vm_allocated;
+	_sq_vm_allocated = NULL;
+
 	/* Clean up the stuff */
 	sq_pop(this->vm, 1);
 	sq_close(this->vm);
+
+	_sq_vm_allocated = last;
+	delete this->profile;
 }
 
 void Squirrel::InsertResult(bool result)
@@ -538,3 +736,32 @@ bool Squirrel::CanSuspend()
 {
 	return sq_can_suspend(this->vm);
 }
+
+SquirrelAccountingScope::SquirrelAccountingScope(Squirrel *engine) : last(_sq_vm_allocated)
+{
+	_sq_vm_allocated = &engine->allocated_size;
+}
+
+SquirrelAccountingScope::~SquirrelAccountingScope()
+{
+	_sq_vm_allocated = this->last;
+}
+
+SquirrelNativeCallTimer::SquirrelNativeCallTimer(HSQUIRRELVM vm, const char *class_name) : engine((Squirrel *)sq_getforeignptr(vm))
+{
+	if (this->engine == NULL) return;
+	if (this->engine->native_depth++ == 0) this->engine->native_timer.Start();
+
+	SQStackInfos si;
+	if (this->engine->IsProfiling() && SQ_SUCCEEDED(sq_stackinfos(vm, 0, &si))) {
+		std::string name(class_name);
+		name += '.';
+		name += SQ2OTTD(si.funcname);
+		this->engine->profile->native_calls[name]++;
+	}
+}
+
+SquirrelNativeCallTimer::~SquirrelNativeCallTimer()
+{
+	if (this->engine != NULL && --this->engine->native_depth == 0) this->engine->native_timer.Stop();
+}
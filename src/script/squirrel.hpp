@@ -12,6 +12,23 @@
 #ifndef SQUIRREL_HPP
 #define SQUIRREL_HPP
 
+#include "../pathfinder/pf_performance_timer.hpp"
+#include <map>
+#include <string>
+
+/** What a profile of a Squirrel VM counted. */
+struct SquirrelProfile {
+	typedef std::map<std::string, uint> Counts; ///< Number of times each key was counted.
+
+	uint interval;       ///< Number of operations between two samples.
+	uint samples;        ///< Number of samples taken.
+	Counts functions;    ///< Samples per function and line, as "function (file:line)".
+	Counts call_stacks;  ///< Samples per call stack, as the names of the functions from the outermost to the innermost, separated by ';'.
+	Counts native_calls; ///< Calls per native function, as "class.function".
+
+	SquirrelProfile(uint interval) : interval(interval), samples(0) {}
+};
+
 class Squirrel {
 private:
 	typedef void (SQPrintFunc)(bool error_msg, const SQChar *message);
@@ -21,6 +38,17 @@ private:
 	SQPrintFunc *print_func; ///< Points to either NULL, or a custom print handler
 	bool crashed;            ///< True if the squirrel script made an error.
 
+	SQInteger allocated_size;       ///< Number of bytes allocated by the VM while it was accounted.
+	uint64 ops_executed;            ///< Number of operations the VM executed with a limit on them.
+	CPerformanceTimer native_timer; ///< Time spent in native functions called by the VM.
+	uint native_depth;              ///< Number of nested native function calls being timed.
+	SquirrelProfile *profile;       ///< The last profile of the VM, or NULL if it was never profiled.
+
+	/**
+	 * Take a sample for the profile; called by the VM every so many operations.
+	 */
+	static void ProfileHook(HSQUIRRELVM vm);
+
 	/**
 	 * The internal RunError handler. It looks up the real error and calls RunError with it.
 	 */
@@ -55,6 +83,8 @@ protected:
 public:
 	friend class AIScanner;
 	friend class AIInstance;
+	friend class SquirrelAccountingScope;
+	friend class SquirrelNativeCallTimer;
 	friend void squirrel_register_std(Squirrel *engine);
 
 	Squirrel();
@@ -121,8 +151,54 @@ public:
 
 	/**
 	 * Tell the VM to do a garbage collection run.
+	 * @return The number of objects that were freed.
+	 */
+	int CollectGarbage();
+
+	/**
+	 * Get the number of objects the garbage collector of the VM keeps track of.
+	 * @note This walks all these objects, so do not call it too often.
+	 */
+	uint GetCollectableObjectCount();
+
+	/**
+	 * Get the number of bytes the VM allocated while it was accounted.
+	 * @see SquirrelAccountingScope
 	 */
-	void CollectGarbage();
+	size_t GetAllocatedMemory() const { return this->allocated_size > 0 ? (size_t)this->allocated_size : 0; }
+
+	/**
+	 * Get the number of operations the VM executed in Resume and CallMethod
+	 *  with a limit on the number of operations.
+	 */
+	uint64 GetOpsExecuted() const { return this->ops_executed; }
+
+	/**
+	 * Get the time spent in native functions called by the VM.
+	 */
+	const CPerformanceTimer &GetNativeTimer() const { return this->native_timer; }
+
+	/**
+	 * Start recording a new profile of the functions the VM runs and the
+	 *  native functions it calls. Any earlier profile is discarded.
+	 * @param interval Number of operations between two samples of the running function.
+	 */
+	void StartProfile(uint interval);
+
+	/**
+	 * Stop recording the profile; what was recorded is kept.
+	 */
+	void StopProfile();
+
+	/**
+	 * Is a profile being recorded?
+	 */
+	bool IsProfiling() const;
+
+	/**
+	 * Get the last profile of the VM, or NULL if it was never profiled.
+	 */
+	const SquirrelProfile *GetProfile() const { return this->profile; }
 
 	void InsertResult(bool result);
 	void InsertResult(int result);
@@ -245,4 +321,28 @@ public:
 	bool CanSuspend();
 };
 
+/**
+ * Account the memory allocated by the Squirrel VMs to the given engine for
+ *  as long as this object lives.
+ */
+class SquirrelAccountingScope {
+	SQInteger *last; ///< The counter that was active before this scope.
+
+public:
+	SquirrelAccountingScope(Squirrel *engine);
+	~SquirrelAccountingScope();
+};
+
+/**
+ * Time a call from a Squirrel VM into a native function, and account it to
+ *  the engine of that VM. Nested calls are only counted once.
+ */
+class SquirrelNativeCallTimer {
+	Squirrel *engine; ///< The engine the call is accounted to.
+
+public:
+	SquirrelNativeCallTimer(HSQUIRRELVM vm, const char *class_name);
+	~SquirrelNativeCallTimer();
+};
+
 #endif /* SQUIRREL_HPP */
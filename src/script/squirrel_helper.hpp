@@ -777,6 +777,7 @@ namespace SQConvert {
 		/* Remove the userdata from the stack */
 		sq_pop(vm, 1);
 
+		SquirrelNativeCallTimer timer(vm, Tcls::GetClassName());
 		try {
 			/* Delegate it to a template that can handle this specific function */
 			return HelperT<Tmethod>::SQCall((Tcls *)real_instance, *(Tmethod *)ptr, vm);
@@ -820,6 +821,7 @@ namespace SQConvert {
 		sq_pop(vm, 1);
 
 		/* Call the function, which its only param is always the VM */
+		SquirrelNativeCallTimer timer(vm, Tcls::GetClassName());
 		return (SQInteger)(((Tcls *)real_instance)->*(*(Tmethod *)ptr))(vm);
 	}
 
@@ -838,6 +840,7 @@ namespace SQConvert {
 		/* Get the real function pointer */
 		sq_getuserdata(vm, nparam, &ptr, 0);
 
+		SquirrelNativeCallTimer timer(vm, Tcls::GetClassName());
 		try {
 			/* Delegate it to a template that can handle this specific function */
 			return HelperT<Tmethod>::SQCall((Tcls *)NULL, *(Tmethod *)ptr, vm);
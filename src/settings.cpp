@@ -31,6 +31,7 @@
 #include "command_func.h"
 #include "console_func.h"
 #include "pathfinder/pathfinder_type.h"
+#include "pathfinder/yapf/yapf_cache.h"
 #include "genworld.h"
 #include "train.h"
 #include "news_func.h"
@@ -43,6 +44,7 @@
 #ifdef WITH_FREETYPE
 #include "fontcache.h"
 #endif
+#include "spritecache_disk.h"
 #include "textbuf_gui.h"
 #include "rail_gui.h"
 #include "elrail_func.h"
@@ -1582,6 +1584,9 @@ CommandCost CmdChangeSetting(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 			return CommandCost();
 		}
 
+		/* The pathfinder caches hold what was found with the old penalties. */
+		if (strncmp(sd->desc.name, "pf.", 3) == 0) YapfNotifySettingsChange();
+
 		if (sd->desc.flags & SGF_NO_NETWORK) {
 			GamelogStartAction(GLAT_SETTING);
 			GamelogSetting(sd->desc.name, oldval, newval);
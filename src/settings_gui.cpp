@@ -1210,6 +1210,13 @@ SettingEntry *SettingsPage::FindEntry(uint row_num, uint *cur_row) const
 	SettingEntry *pe = NULL;
 
 	for (uint field = 0; field < this->num; field++) {
+		/* Do not search an entry whose rows all come before the requested row. */
+		uint length = this->entries[field].Length();
+		if (*cur_row + length <= row_num) {
+			*cur_row += length;
+			continue;
+		}
+
 		pe = this->entries[field].FindEntry(row_num, cur_row);
 		if (pe != NULL) {
 			break;
@@ -1240,6 +1247,13 @@ uint SettingsPage::Draw(GameSettings *settings_ptr, int left, int right, int bas
 	if (cur_row >= max_row) return cur_row;
 
 	for (uint i = 0; i < this->num; i++) {
+		/* Entries that end above the first row would draw nothing; only count their rows. */
+		uint length = this->entries[i].Length();
+		if (cur_row + length <= first_row) {
+			cur_row += length;
+			continue;
+		}
+
 		cur_row = this->entries[i].Draw(settings_ptr, left, right, base_y, first_row, max_row, cur_row, parent_last);
 		if (cur_row >= max_row) {
 			break;
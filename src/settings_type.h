@@ -58,6 +58,7 @@ struct GUISettings {
 	uint8  smallmap_land_colour;             ///< colour used for land and heightmap at the smallmap
 	bool   reverse_scroll;                   ///< right-Click-Scrolling scrolls in the opposite direction
 	bool   smooth_scroll;                    ///< smooth scroll viewports
+	uint16 refresh_rate;                     ///< how many times per second the screen is drawn, independent of the speed of the game
 	bool   measure_tooltip;                  ///< show a permanent tooltip when dragging tools
 	byte   liveries;                         ///< options for displaying company liveries, 0=none, 1=self, 2=all
 	bool   prefer_teamchat;                  ///< choose the chat message target with <ENTER>, true=all clients, false=your team
@@ -70,6 +71,11 @@ struct GUISettings {
 	bool   always_build_infrastructure;      ///< always allow building of infrastructure, even when you do not have the vehicles for it
 	byte   autosave;                         ///< how often should we do autosaves?
 	bool   threaded_saves;                   ///< should we do threaded saves?
+	bool   snapshot_autosaves;               ///< should autosaves be written by a copy of the game process, where possible?
+	uint8  vehicle_tick_threads;             ///< maximum number of threads used for the parts of the vehicle ticks that can run in parallel
+	uint8  savegame_threads;                 ///< maximum number of threads used to compress and decompress savegames in the 'pzlib' format
+	uint8  job_threads;                      ///< number of threads the job system runs its jobs on, including the main thread; 1 for no worker threads; only read at startup
+	uint8  differential_autosaves;           ///< number of autosaves written as difference to the last full autosave before the next full one; 0 to disable
 	bool   keep_all_autosave;                ///< name the autosave in a different way
 	bool   autosave_on_exit;                 ///< save an autosave when you quit the game, but do not ask "Do you really want to quit?"
 	uint8  date_format_in_default_names;     ///< should the default savegame/screenshot name use long dates (31th Dec 2008), short dates (31-12-2008) or ISO dates (2008-12-31)
@@ -86,6 +92,9 @@ struct GUISettings {
 	bool   timetable_in_ticks;               ///< whether to show the timetable in ticks rather than days
 	bool   quick_goto;                       ///< Allow quick access to 'goto button' in vehicle orders window
 	bool   bridge_pillars;                   ///< show bridge pillars for high bridges
+	bool   cache_tile_draw_lists;            ///< replay what was drawn of unchanged tiles instead of drawing them again
+	uint8  viewport_low_detail;              ///< the number of farthest zoom levels at which viewports are drawn with less detail; 0 for none
+	bool   minimal_presentation;             ///< skip sounds, text effects and news that are out of sight or about competitors
 	bool   auto_euro;                        ///< automatically switch to euro in 2002
 	byte   drag_signals_density;             ///< many signals density
 	Year   semaphore_build_before;           ///< build semaphore signals automatically before this year
@@ -153,6 +162,8 @@ struct NetworkSettings {
 	char   last_host[NETWORK_HOSTNAME_LENGTH];            ///< IP address of the last joined server
 	uint16 last_port;                                     ///< port of the last joined server
 	bool   no_http_content_downloads;                     ///< do not do content downloads over HTTP
+	bool   sync_state_hash;                               ///< add hashes of parts of the game state to the sync packets, to find desyncs
+	uint16 max_map_upload;                                ///< the most KiB per second all map downloads together may use; 0 for no limit
 #else /* ENABLE_NETWORK */
 #endif
 };
@@ -176,6 +187,7 @@ struct GameCreationSettings {
 	byte   water_borders;                    ///< bitset of the borders that are water
 	uint16 custom_town_number;               ///< manually entered number of towns
 	byte   variety;                          ///< variety level applied to TGP
+	bool   fast_landscape_settle;            ///< let the landscape settle after generation in linear map sweeps; faster, but makes another map for the same seed
 };
 
 /** Settings related to construction in-game */
@@ -200,6 +212,8 @@ struct AISettings {
 	bool   ai_disable_veh_aircraft;          ///< disable types for AI
 	bool   ai_disable_veh_ship;              ///< disable types for AI
 	uint32 ai_max_opcode_till_suspend;       ///< max opcode calls till AI will suspend
+	uint8  ai_max_running_per_tick;          ///< max number of AIs that run in a single tick, 0 for all of them
+	uint16 ai_max_memory;                    ///< max memory in MiB the VM of an AI may allocate, 0 for no limit
 };
 
 /** Settings related to the old pathfinder. */
@@ -338,12 +352,15 @@ struct EconomySettings {
 	bool   smooth_economy;                   ///< smooth economy
 	bool   allow_shares;                     ///< allow the buying/selling of shares
 	uint8  feeder_payment_share;             ///< percentage of leg payment to virtually pay in feeder systems
+	uint8  cargo_merge_days;                 ///< how much the days in transit of waiting cargo packets may differ when merging them each month, 0 to not merge them
 	byte   dist_local_authority;             ///< distance for town local authority, default 20
 	bool   exclusive_rights;                 ///< allow buying exclusive rights
 	bool   give_money;                       ///< allow giving other companies money
 	bool   mod_road_rebuild;                 ///< roadworks remove unneccesary RoadBits
 	bool   multiple_industry_per_town;       ///< allow many industries of the same type per town
 	uint8  town_growth_rate;                 ///< town growth rate
+	uint16 town_growth_budget;               ///< maximum number of towns that may grow in a single tick, 0 for no limit
+	bool   town_growth_frontier;             ///< towns start growing at a random road end or junction instead of walking from their centre
 	uint8  larger_towns;                     ///< the number of cities to build. These start off larger and grow twice as fast
 	uint8  initial_city_size;                ///< multiplier for the initial size of the cities compared to towns
 	TownLayoutByte town_layout;              ///< select town layout, @see TownLayout
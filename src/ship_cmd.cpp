@@ -35,10 +35,13 @@
 #include "effectvehicle_base.h"
 #include "ai/ai.hpp"
 #include "pathfinder/opf/opf_ship.h"
+#include "pathfinder/pf_recorder.h"
+#include "pathfinder/pf_performance_timer.hpp"
 #include "landscape_type.h"
 #include "engine_base.h"
 #include "engine_func.h"
 #include "company_base.h"
+#include "timeline.h"
 
 #include "table/strings.h"
 #include "table/sprites.h"
@@ -373,16 +376,59 @@ static void ShipArrivesAt(const Vehicle *v, Station *st)
 /** returns the track to choose on the next tile, or -1 when it's better to
  * reverse. The tile given is the tile we are about to enter, enterdir is the
  * direction in which we are entering the tile */
+/**
+ * Choose the track that leads closest to the destination as the crow flies.
+ * Used instead of a search when the destination can't be reached anyway.
+ * @param tile     the tile the ship is about to enter
+ * @param enterdir the direction the ship enters the tile from
+ * @param tracks   the tracks available on the tile
+ * @param dest     the destination of the ship
+ * @return the track to take
+ */
+static Track ChooseShipTrackTowards(TileIndex tile, DiagDirection enterdir, TrackBits tracks, TileIndex dest)
+{
+	Track best_track = INVALID_TRACK;
+	uint best_dist = UINT_MAX;
+
+	Track track;
+	FOR_EACH_SET_TRACK(track, tracks) {
+		DiagDirection exitdir = TrackdirToExitdir(TrackEnterdirToTrackdir(track, enterdir));
+		uint dist = DistanceManhattan(TILE_ADD(tile, TileOffsByDiagDir(exitdir)), dest);
+		if (dist < best_dist) {
+			best_dist = dist;
+			best_track = track;
+		}
+	}
+	return best_track;
+}
+
 static Track ChooseShipTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks)
 {
 	assert(IsValidDiagDirection(enterdir));
 
+	/* Searching for a destination that is not connected by water is a waste of time. */
+	if (v->dest_tile != 0 && !YapfShipMayReachTile(tile, v->dest_tile)) {
+		return ChooseShipTrackTowards(tile, enterdir, tracks, v->dest_tile);
+	}
+
+	TIMELINE_ZONE("ship pathfinder");
+
+	CPerformanceTimer timer;
+	if (IsRecordingPathfinderQueries()) timer.Start();
+
+	Track track;
 	switch (_settings_game.pf.pathfinder_for_ships) {
-		case VPF_OPF: return OPFShipChooseTrack(v, tile, enterdir, tracks);
-		case VPF_NPF: return NPFShipChooseTrack(v, tile, enterdir, tracks);
-		case VPF_YAPF: return YapfShipChooseTrack(v, tile, enterdir, tracks);
+		case VPF_OPF: track = OPFShipChooseTrack(v, tile, enterdir, tracks); break;
+		case VPF_NPF: track = NPFShipChooseTrack(v, tile, enterdir, tracks); break;
+		case VPF_YAPF: track = YapfShipChooseTrack(v, tile, enterdir, tracks); break;
 		default: NOT_REACHED();
 	}
+
+	if (IsRecordingPathfinderQueries()) {
+		timer.Stop();
+		RecordPathfinderQuery(PFQ_SHIP, v, tile, enterdir, tracks, track, timer.m_acc);
+	}
+	return track;
 }
 
 static const Direction _new_vehicle_direction_table[] = {
@@ -682,13 +728,15 @@ CommandCost CmdBuildShip(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 		VehicleMove(v, false);
 
 		InvalidateWindowData(WC_VEHICLE_DEPOT, v->tile);
-		InvalidateWindowClassesData(WC_SHIPS_LIST, 0);
+		InvalidateVehicleListsOfVehicle(v);
 		SetWindowDirty(WC_COMPANY, v->owner);
 		if (IsLocalCompany()) {
 			InvalidateAutoreplaceWindow(v->engine_type, v->group_id); // updates the replace Ship window
 		}
 
-		Company::Get(_current_company)->num_engines[eid]++;
+		Company *c = Company::Get(_current_company);
+		c->num_engines[eid]++;
+		c->num_vehicles[v->type]++;
 	}
 
 	return value;
@@ -796,7 +844,7 @@ CommandCost CmdRefitShip(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 		v->colourmap = PAL_NONE; // invalidate vehicle colour map
 		SetWindowDirty(WC_VEHICLE_DETAILS, v->index);
 		SetWindowDirty(WC_VEHICLE_DEPOT, v->tile);
-		InvalidateWindowClassesData(WC_SHIPS_LIST, 0);
+		InvalidateVehicleListsOfVehicle(v);
 	}
 	v->InvalidateNewGRFCacheOfChain(); // always invalidate; querycost might have filled it
 
@@ -10,22 +10,17 @@
 /** @file signal.cpp functions related to rail signals updating */
 
 #include "stdafx.h"
-#include "debug.h"
 #include "station_map.h"
 #include "tunnelbridge_map.h"
 #include "vehicle_func.h"
 #include "functions.h"
 #include "train.h"
 #include "company_base.h"
+#include "core/smallvec_type.hpp"
 
 
-/** these are the maximums used for updating signal blocks */
-static const uint SIG_TBU_SIZE    =  64; ///< number of signals entering to block
-static const uint SIG_TBD_SIZE    = 256; ///< number of intersections - open nodes in current block
-static const uint SIG_GLOB_SIZE   = 128; ///< number of open blocks (block can be opened more times until detected)
-static const uint SIG_GLOB_UPDATE =  64; ///< how many items need to be in _globset to force update
-
-assert_compile(SIG_GLOB_UPDATE <= SIG_GLOB_SIZE);
+uint _rail_state_counter = 0;                    ///< number of signal state and track reservation changes
+TileIndex _rail_state_log[RAIL_STATE_LOG_SIZE]; ///< the tiles of the last signal state and track reservation changes
 
 /** incidating trackbits with given enterdir */
 static const TrackBits _enterdir_to_trackbits[DIAGDIR_END] = {
@@ -44,87 +39,154 @@ static const TrackdirBits _enterdir_to_trackdirbits[DIAGDIR_END] = {
 };
 
 /**
- * Set containing 'items' items of 'tile and Tdir'
- * No tree structure is used because it would cause
- * slowdowns in most usual cases
+ * Set of 'tile and Tdir' items that grows as needed.
+ * Items are kept in a plain array, which keeps the order in which Get
+ * returns them, and are indexed by a small hash so finding or removing
+ * an item does not need to go through the whole set.
  */
-template <typename Tdir, uint items>
+template <typename Tdir>
 struct SmallSet {
 private:
-	uint n;           // actual number of units
-	bool overflowed;  // did we try to oveflow the set?
-	const char *name; // name, used for debugging purposes...
-
 	/** Element of set */
 	struct SSdata {
 		TileIndex tile;
 		Tdir dir;
-	} data[items];
+	};
 
-public:
-	/** Constructor - just set default values and 'name' */
-	SmallSet(const char *name) : n(0), overflowed(false), name(name) { }
+	SmallVector<SSdata, 64> data; ///< the items in the set
+	uint *index;                  ///< open addressing hash of positions in #data, UINT_MAX when free
+	uint index_bits;              ///< number of bits of the hash; the index has 1 << index_bits entries
 
-	/** Reset variables to default values */
-	void Reset()
+	/**
+	 * Get the preferred entry of an item in the index.
+	 * @param tile tile
+	 * @param dir and dir to get the entry of
+	 * @return the position in #index
+	 */
+	FORCEINLINE uint GetSlot(TileIndex tile, Tdir dir) const
 	{
-		this->n = 0;
-		this->overflowed = false;
+		return (uint32)(((tile << 4) | dir) * 0x9E3779B1U) >> (32 - this->index_bits);
 	}
 
 	/**
-	 * Returns value of 'oveflowed'
-	 * @return did we try to overflow the set?
+	 * Find the index entry of an item.
+	 * @param tile tile
+	 * @param dir and dir to find
+	 * @return the entry, or NULL if the item is not in the set
 	 */
-	bool Overflowed()
+	uint *FindEntry(TileIndex tile, Tdir dir) const
 	{
-		return this->overflowed;
+		uint mask = (1 << this->index_bits) - 1;
+		for (uint i = this->GetSlot(tile, dir);; i = (i + 1) & mask) {
+			uint pos = this->index[i];
+			if (pos == UINT_MAX) return NULL;
+			if (this->data[pos].tile == tile && this->data[pos].dir == dir) return &this->index[i];
+		}
 	}
 
 	/**
-	 * Checks for empty set
-	 * @return is the set empty?
+	 * Add an entry for the item at the given position to the index.
+	 * @param pos position of the item in #data
 	 */
-	bool IsEmpty()
+	void AddEntry(uint pos)
+	{
+		uint mask = (1 << this->index_bits) - 1;
+		uint i = this->GetSlot(this->data[pos].tile, this->data[pos].dir);
+		while (this->index[i] != UINT_MAX) i = (i + 1) & mask;
+		this->index[i] = pos;
+	}
+
+	/**
+	 * Remove an entry from the index, moving entries after
+	 * it back so no lookup chain gets broken.
+	 * @param entry the entry to remove
+	 */
+	void RemoveEntry(uint *entry)
+	{
+		uint mask = (1 << this->index_bits) - 1;
+		uint hole = entry - this->index;
+
+		for (uint i = (hole + 1) & mask; this->index[i] != UINT_MAX; i = (i + 1) & mask) {
+			/* Move the entry into the hole when its preferred slot is cyclically not within (hole, i]. */
+			const SSdata &item = this->data[this->index[i]];
+			uint slot = this->GetSlot(item.tile, item.dir);
+			if (((i - slot) & mask) >= ((i - hole) & mask)) {
+				this->index[hole] = this->index[i];
+				hole = i;
+			}
+		}
+		this->index[hole] = UINT_MAX;
+	}
+
+	/** Grow the index so it is at least twice as large as the number of items. */
+	void ResizeIndex()
+	{
+		uint bits = this->index_bits;
+		while ((1U << bits) < this->data.Length() * 2) bits++;
+		if (bits == this->index_bits) return;
+
+		this->index_bits = bits;
+		this->index = ReallocT(this->index, 1 << bits);
+		for (uint i = 0; i < (1U << bits); i++) this->index[i] = UINT_MAX;
+		for (uint pos = 0; pos < this->data.Length(); pos++) this->AddEntry(pos);
+	}
+
+public:
+	/** Constructor - start with an empty index */
+	SmallSet() : index(NULL), index_bits(6)
+	{
+		this->index = MallocT<uint>(1 << this->index_bits);
+		for (uint i = 0; i < (1U << this->index_bits); i++) this->index[i] = UINT_MAX;
+	}
+
+	/** Destructor - free the index */
+	~SmallSet()
 	{
-		return this->n == 0;
+		free(this->index);
 	}
 
 	/**
-	 * Checks for full set
-	 * @return is the set full?
+	 * Checks for empty set
+	 * @return is the set empty?
 	 */
-	bool IsFull()
+	bool IsEmpty() const
 	{
-		return this->n == lengthof(data);
+		return this->data.Length() == 0;
 	}
 
 	/**
 	 * Reads the number of items
 	 * @return current number of items
 	 */
-	uint Items()
+	uint Items() const
 	{
-		return this->n;
+		return this->data.Length();
 	}
 
 
 	/**
-	 * Tries to remove first instance of given tile and dir
+	 * Tries to remove given tile and dir
 	 * @param tile tile
 	 * @param dir and dir to remove
 	 * @return element was found and removed
 	 */
 	bool Remove(TileIndex tile, Tdir dir)
 	{
-		for (uint i = 0; i < this->n; i++) {
-			if (this->data[i].tile == tile && this->data[i].dir == dir) {
-				this->data[i] = this->data[--this->n];
-				return true;
-			}
+		uint *entry = this->FindEntry(tile, dir);
+		if (entry == NULL) return false;
+
+		/* Move the last item into the hole, like SmallVector::Erase does. */
+		uint pos = *entry;
+		this->RemoveEntry(entry);
+
+		uint last = this->data.Length() - 1;
+		if (pos != last) {
+			*this->FindEntry(this->data[last].tile, this->data[last].dir) = pos;
+			this->data[pos] = this->data[last];
 		}
+		this->data.Erase(this->data.End() - 1);
 
-		return false;
+		return true;
 	}
 
 	/**
@@ -133,35 +195,29 @@ public:
 	 * @param dir and dir to find
 	 * @return true iff the tile & dir elemnt was found
 	 */
-	bool IsIn(TileIndex tile, Tdir dir)
+	bool IsIn(TileIndex tile, Tdir dir) const
 	{
-		for (uint i = 0; i < this->n; i++) {
-			if (this->data[i].tile == tile && this->data[i].dir == dir) return true;
-		}
-
-		return false;
+		return this->FindEntry(tile, dir) != NULL;
 	}
 
 	/**
-	 * Adds tile & dir into the set, checks for full set
-	 * Sets the 'overflowed' flag if the set was full
+	 * Adds tile & dir into the set, unless it is in the set already
 	 * @param tile tile
 	 * @param dir and dir to add
-	 * @return true iff the item could be added (set wasn't full)
 	 */
-	bool Add(TileIndex tile, Tdir dir)
+	void Add(TileIndex tile, Tdir dir)
 	{
-		if (this->IsFull()) {
-			overflowed = true;
-			DEBUG(misc, 0, "SignalSegment too complex. Set %s is full (maximum %d)", name, items);
-			return false; // set is full
-		}
+		if (this->IsIn(tile, dir)) return;
 
-		this->data[this->n].tile = tile;
-		this->data[this->n].dir = dir;
-		this->n++;
+		SSdata *item = this->data.Append();
+		item->tile = tile;
+		item->dir = dir;
 
-		return true;
+		if (this->data.Length() * 2 > (1U << this->index_bits)) {
+			this->ResizeIndex();
+		} else {
+			this->AddEntry(this->data.Length() - 1);
+		}
 	}
 
 	/**
@@ -172,19 +228,21 @@ public:
 	 */
 	bool Get(TileIndex *tile, Tdir *dir)
 	{
-		if (this->n == 0) return false;
+		if (this->IsEmpty()) return false;
 
-		this->n--;
-		*tile = this->data[this->n].tile;
-		*dir = this->data[this->n].dir;
+		const SSdata &item = this->data[this->data.Length() - 1];
+		*tile = item.tile;
+		*dir = item.dir;
+		this->RemoveEntry(this->FindEntry(item.tile, item.dir));
+		this->data.Erase(this->data.End() - 1);
 
 		return true;
 	}
 };
 
-static SmallSet<Trackdir, SIG_TBU_SIZE> _tbuset("_tbuset");         ///< set of signals that will be updated
-static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of open nodes in current signal block
-static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
+static SmallSet<Trackdir> _tbuset;         ///< set of signals that will be updated
+static SmallSet<DiagDirection> _tbdset;    ///< set of open nodes in current signal block
+static SmallSet<DiagDirection> _globset;   ///< set of places to be updated in following runs
 
 
 /** Check whether there is a train on rail, not in a depot */
@@ -233,13 +291,10 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
- * @return false iff the Todo buffer would be overrun
  */
-static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline void MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
-	if (!CheckAddToTodoSet(t1, d1, t2, d2)) return true;
-
-	return _tbdset.Add(t1, d1);
+	if (CheckAddToTodoSet(t1, d1, t2, d2)) _tbdset.Add(t1, d1);
 }
 
 
@@ -251,8 +306,7 @@ enum SigFlags {
 	SF_EXIT2  = 1 << 2, ///< two or more exits found
 	SF_GREEN  = 1 << 3, ///< green exitsignal found
 	SF_GREEN2 = 1 << 4, ///< two or more green exits found
-	SF_FULL   = 1 << 5, ///< some of buffers was full, do not continue
-	SF_PBS    = 1 << 6, ///< pbs signal found
+	SF_PBS    = 1 << 5, ///< pbs signal found
 };
 
 DECLARE_ENUM_AS_BIT_SET(SigFlags)
@@ -318,8 +372,8 @@ static SigFlags ExploreSegment(Owner owner)
 						if (HasSignalOnTrackdir(tile, reversedir)) {
 							if (IsPbsSignal(sig)) {
 								flags |= SF_PBS;
-							} else if (!_tbuset.Add(tile, reversedir)) {
-								return flags | SF_FULL;
+							} else {
+								_tbuset.Add(tile, reversedir);
 							}
 						}
 						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) flags |= SF_PBS;
@@ -342,7 +396,7 @@ static SigFlags ExploreSegment(Owner owner)
 					if (dir != enterdir && (tracks & _enterdir_to_trackbits[dir])) { // any track incidating?
 						TileIndex newtile = tile + TileOffsByDiagDir(dir);  // new tile to check
 						DiagDirection newdir = ReverseDiagDir(dir); // direction we are entering from
-						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir)) return flags | SF_FULL;
+						MaybeAddToTodoSet(newtile, newdir, tile, dir);
 					}
 				}
 
@@ -392,7 +446,7 @@ static SigFlags ExploreSegment(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir)) return flags | SF_FULL;
+		MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir);
 	}
 
 	return flags;
@@ -440,7 +494,7 @@ static void UpdateSignalsAroundSegment(SigFlags flags)
 			if (IsPresignalExit(tile, TrackdirToTrack(trackdir))) {
 				/* for pre-signal exits, add block to the global set */
 				DiagDirection exitdir = TrackdirToExitdir(ReverseTrackdir(trackdir));
-				_globset.Add(tile, exitdir); // do not check for full global set, first update all signals
+				_globset.Add(tile, exitdir);
 			}
 			SetSignalStateByTrackdir(tile, trackdir, newstate);
 			MarkTileDirtyByTile(tile);
@@ -450,15 +504,6 @@ static void UpdateSignalsAroundSegment(SigFlags flags)
 }
 
 
-/** Reset all sets after one set overflowed */
-static inline void ResetSets()
-{
-	_tbuset.Reset();
-	_tbdset.Reset();
-	_globset.Reset();
-}
-
-
 /**
  * Updates blocks in _globset buffer
  *
@@ -523,7 +568,6 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
 		assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
 
 		SigFlags flags = ExploreSegment(owner);
@@ -533,17 +577,11 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 			/* SIGSEG_FREE is set by default */
 			if (flags & SF_PBS) {
 				state = SIGSEG_PBS;
-			} else if ((flags & SF_TRAIN) || ((flags & SF_EXIT) && !(flags & SF_GREEN)) || (flags & SF_FULL)) {
+			} else if ((flags & SF_TRAIN) || ((flags & SF_EXIT) && !(flags & SF_GREEN))) {
 				state = SIGSEG_FULL;
 			}
 		}
 
-		/* do not do anything when some buffer was full */
-		if (flags & SF_FULL) {
-			ResetSets(); // free all sets
-			break;
-		}
-
 		UpdateSignalsAroundSegment(flags);
 	}
 
@@ -584,18 +622,12 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 	};
 
 	/* do not allow signal updates for two companies in one run */
-	assert(_globset.IsEmpty() || owner == _last_owner);
+	if (!_globset.IsEmpty() && owner != _last_owner) UpdateSignalsInBuffer();
 
 	_last_owner = owner;
 
 	_globset.Add(tile, _search_dir_1[track]);
 	_globset.Add(tile, _search_dir_2[track]);
-
-	if (_globset.Items() >= SIG_GLOB_UPDATE) {
-		/* too many items, force update */
-		UpdateSignalsInBuffer(_last_owner);
-		_last_owner = INVALID_OWNER;
-	}
 }
 
 
@@ -609,17 +641,11 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 {
 	/* do not allow signal updates for two companies in one run */
-	assert(_globset.IsEmpty() || owner == _last_owner);
+	if (!_globset.IsEmpty() && owner != _last_owner) UpdateSignalsInBuffer();
 
 	_last_owner = owner;
 
 	_globset.Add(tile, side);
-
-	if (_globset.Items() >= SIG_GLOB_UPDATE) {
-		/* too many items, force update */
-		UpdateSignalsInBuffer(_last_owner);
-		_last_owner = INVALID_OWNER;
-	}
 }
 
 /**
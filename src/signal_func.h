@@ -47,6 +47,21 @@ static inline byte SignalOnTrack(Track track)
 	return _signal_on_track[track];
 }
 
+/** Number of signal state and track reservation changes that are remembered. */
+static const uint RAIL_STATE_LOG_SIZE = 4096;
+
+extern uint _rail_state_counter;
+extern TileIndex _rail_state_log[RAIL_STATE_LOG_SIZE];
+
+/**
+ * Remember that a signal state or a track reservation of a tile changed.
+ * @param tile the changed tile
+ */
+static inline void MarkRailStateChanged(TileIndex tile)
+{
+	_rail_state_log[_rail_state_counter++ % RAIL_STATE_LOG_SIZE] = tile;
+}
+
 /** State of the signal segment */
 enum SigSegState {
 	SIGSEG_FREE,    ///< Free and has no pre-signal exits or at least one green exit
@@ -13,6 +13,7 @@
 #include "landscape.h"
 #include "signs_base.h"
 #include "signs_func.h"
+#include "viewport_func.h"
 #include "strings_func.h"
 #include "core/pool_func.hpp"
 
@@ -33,6 +34,7 @@ Sign::~Sign()
 
 	if (CleaningPool()) return;
 
+	RemoveViewportSignFromIndex(VSK_SIGN, this->index, &this->sign);
 	DeleteRenameSignWindow(this->index);
 }
 
@@ -43,7 +45,9 @@ void Sign::UpdateVirtCoord()
 {
 	Point pt = RemapCoords(this->x, this->y, this->z);
 	SetDParam(0, this->index);
+	RemoveViewportSignFromIndex(VSK_SIGN, this->index, &this->sign);
 	this->sign.UpdatePosition(pt.x, pt.y - 6, STR_WHITE_SIGN);
+	AddViewportSignToIndex(VSK_SIGN, this->index, &this->sign);
 }
 
 /** Update the coordinates of all signs */
@@ -54,6 +54,24 @@ enum SmallMapWindowWidgets {
 
 static int _smallmap_industry_count; ///< Number of used industries
 
+static uint32 *_smallmap_tile_colours = NULL; ///< While the smallmap window is open: the colours of the tiles in its current map type; see #_smallmap_tile_cached.
+static uint32 *_smallmap_tile_cached = NULL;  ///< Bitmap of the tiles whose colours in #_smallmap_tile_colours are up to date.
+
+/** Forget the colours of all tiles, e.g. because the map type or the colours changed. */
+static void ResetSmallMapTileColours()
+{
+	if (_smallmap_tile_cached != NULL) memset(_smallmap_tile_cached, 0, CeilDiv(MapSize(), 32) * sizeof(*_smallmap_tile_cached));
+}
+
+/**
+ * Forget the colours of a tile in the smallmap, as the tile changed.
+ * @param tile the tile
+ */
+void InvalidateSmallMapTile(TileIndex tile)
+{
+	if (_smallmap_tile_cached != NULL) ClrBit(_smallmap_tile_cached[tile / 32], tile % 32);
+}
+
 /** Macro for ordinary entry of LegendAndColour */
 #define MK(a, b) {a, b, {INVALID_INDUSTRYTYPE}, true, false, false}
 
@@ -186,6 +204,8 @@ void BuildIndustriesLegend()
 
 	/* Store number of enabled industries */
 	_smallmap_industry_count = j;
+
+	ResetSmallMapTileColours();
 }
 
 static const LegendAndColour * const _legend_table[] = {
@@ -280,6 +300,8 @@ void BuildLandLegend()
 	for (LegendAndColour *lc = _legend_land_contours; lc->legend == STR_TINY_BLACK_HEIGHT; lc++) {
 		lc->colour = _heightmap_schemes[_settings_client.gui.smallmap_land_colour].height_colours[lc->u.height];
 	}
+
+	ResetSmallMapTileColours();
 }
 
 struct AndOr {
@@ -697,6 +719,24 @@ class SmallMapWindow : public Window {
 			}
 		}
 
+		/* The colours of the owners are as quickly looked up again as in the cache, and change with the company colours. */
+		if (this->map_type == SMT_OWNER) return GetSmallMapOwnerPixels(tile, et);
+
+		if (!HasBit(_smallmap_tile_cached[tile / 32], tile % 32)) {
+			_smallmap_tile_colours[tile] = this->GetTileColours(tile, et);
+			SetBit(_smallmap_tile_cached[tile / 32], tile % 32);
+		}
+		return _smallmap_tile_colours[tile];
+	}
+
+	/**
+	 * Get the colours of a tile in the current map type.
+	 * @param tile the tile
+	 * @param et   effective tile type of the tile (see #GetEffectiveTileType)
+	 * @return colours to display
+	 */
+	inline uint32 GetTileColours(TileIndex tile, TileType et) const
+	{
 		switch (this->map_type) {
 			case SMT_CONTOUR:
 				return GetSmallMapContoursPixels(tile, et);
@@ -967,8 +1007,19 @@ class SmallMapWindow : public Window {
 	}
 
 public:
+	~SmallMapWindow()
+	{
+		free(_smallmap_tile_colours);
+		_smallmap_tile_colours = NULL;
+		free(_smallmap_tile_cached);
+		_smallmap_tile_cached = NULL;
+	}
+
 	SmallMapWindow(const WindowDesc *desc, int window_number) : Window(), refresh(FORCE_REFRESH_PERIOD)
 	{
+		_smallmap_tile_colours = MallocT<uint32>(MapSize());
+		_smallmap_tile_cached = CallocT<uint32>(CeilDiv(MapSize(), 32));
+
 		this->InitNested(desc, window_number);
 		this->LowerWidget(this->map_type + SM_WIDGET_CONTOUR);
 
@@ -1176,6 +1227,7 @@ public:
 				/* Hide Enable all/Disable all buttons if is not industry type small map */
 				this->GetWidget<NWidgetStacked>(SM_WIDGET_SELECTINDUSTRIES)->SetDisplayedPlane(this->map_type != SMT_INDUSTRY);
 
+				ResetSmallMapTileColours();
 				this->SetDirty();
 				SndPlayFx(SND_15_BEEP);
 				break;
@@ -1232,6 +1284,7 @@ public:
 							_legend_from_industries[industry_pos].show_on_map = !_legend_from_industries[industry_pos].show_on_map;
 						}
 					}
+					ResetSmallMapTileColours();
 					this->SetDirty();
 				}
 				break;
@@ -1240,6 +1293,7 @@ public:
 				for (int i = 0; i != _smallmap_industry_count; i++) {
 					_legend_from_industries[i].show_on_map = true;
 				}
+				ResetSmallMapTileColours();
 				this->SetDirty();
 				break;
 
@@ -1247,12 +1301,14 @@ public:
 				for (int i = 0; i != _smallmap_industry_count; i++) {
 					_legend_from_industries[i].show_on_map = false;
 				}
+				ResetSmallMapTileColours();
 				this->SetDirty();
 				break;
 
 			case SM_WIDGET_SHOW_HEIGHT: // Enable/disable showing of heightmap.
 				_smallmap_industry_show_heightmap = !_smallmap_industry_show_heightmap;
 				this->SetWidgetLoweredState(SM_WIDGET_SHOW_HEIGHT, _smallmap_industry_show_heightmap);
+				ResetSmallMapTileColours();
 				this->SetDirty();
 				break;
 		}
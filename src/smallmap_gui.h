@@ -12,8 +12,11 @@
 #ifndef SMALLMAP_GUI_H
 #define SMALLMAP_GUI_H
 
+#include "tile_type.h"
+
 void BuildIndustriesLegend();
 void ShowSmallMap();
 void BuildLandLegend();
+void InvalidateSmallMapTile(TileIndex tile);
 
 #endif /* SMALLMAP_GUI_H */
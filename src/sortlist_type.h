@@ -300,6 +300,74 @@ public:
 		return this->Sort(this->sort_func_list[this->sort_type]);
 	}
 
+	/**
+	 * Remove an item from the list without disturbing
+	 *  the order of the other items.
+	 *
+	 * @param item The item to remove
+	 * @return true if the item was in the list
+	 */
+	bool RemoveItem(const T &item)
+	{
+		T *pos = this->Find(item);
+		if (pos == this->End()) return false;
+
+		MemMoveT(pos, pos + 1, this->End() - pos - 1);
+		this->items--;
+		return true;
+	}
+
+	/**
+	 * Put a single item at the place it belongs in the
+	 *  sorted list, adding it when it is not in the list yet.
+	 *  This saves resorting the whole list when only one
+	 *  item has changed. When a sort is pending anyway the
+	 *  item is only added; the sort puts it in place.
+	 *
+	 * @param item The item to (re)position
+	 * @param compare The function to compare two list items
+	 */
+	void SortItem(const T &item, SortFunction *compare)
+	{
+		const T value = item;
+		this->RemoveItem(value);
+
+		if (this->flags & (VL_RESORT | VL_REBUILD | VL_FIRST_SORT)) {
+			*this->Append() = value;
+			return;
+		}
+
+		/* Binary search for the first item that has to come after the new one. */
+		const bool desc = (this->flags & VL_DESC) != 0;
+		uint first = 0;
+		uint last = this->items;
+		while (first < last) {
+			uint mid = (first + last) / 2;
+			int diff = compare(&value, &this->data[mid]);
+			if (desc ? diff > 0 : diff < 0) {
+				last = mid;
+			} else {
+				first = mid + 1;
+			}
+		}
+
+		this->Append();
+		MemMoveT(this->data + first + 1, this->data + first, this->items - first - 1);
+		this->data[first] = value;
+	}
+
+	/**
+	 * Overload of #SortItem(const T &item, SortFunction *compare)
+	 *  using the current sort function.
+	 *
+	 * @param item The item to (re)position
+	 */
+	void SortItem(const T &item)
+	{
+		assert(this->sort_func_list != NULL);
+		this->SortItem(item, this->sort_func_list[this->sort_type]);
+	}
+
 	/**
 	 * Check if the filter is enabled
 	 *
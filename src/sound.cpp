@@ -16,10 +16,12 @@
 #include "fios.h"
 #include "window_gui.h"
 #include "vehicle_base.h"
+#include "company_func.h"
 
 /* The type of set we're replacing */
 #define SET_TYPE "sounds"
 #include "base_media_func.h"
+#include "network/network.h"
 
 static SoundEntry _original_sounds[ORIGINAL_SAMPLE_COUNT];
 MusicFileSettings msf;
@@ -218,16 +220,17 @@ void SndCopyToPool()
 }
 
 /**
- * Decide 'where' (between left and right speaker) to play the sound effect.
- * @param sound Sound effect to play
+ * Find the viewport a sound effect is heard in.
  * @param left   Left edge of virtual coordinates where the sound is produced
  * @param right  Right edge of virtual coordinates where the sound is produced
  * @param top    Top edge of virtual coordinates where the sound is produced
  * @param bottom Bottom edge of virtual coordinates where the sound is produced
+ * @return The first viewport, from the back, that shows where the sound is produced; NULL if none does or no effects can be heard.
  */
-static void SndPlayScreenCoordFx(SoundID sound, int left, int right, int top, int bottom)
+static const ViewPort *FindSoundViewport(int left, int right, int top, int bottom)
 {
-	if (msf.effect_vol == 0) return;
+	/* Nobody sees the frames we are catching up with. */
+	if (msf.effect_vol == 0 || _network_catching_up) return NULL;
 
 	const Window *w;
 	FOR_ALL_WINDOWS_FROM_BACK(w) {
@@ -236,18 +239,34 @@ static void SndPlayScreenCoordFx(SoundID sound, int left, int right, int top, in
 		if (vp != NULL &&
 				left < vp->virtual_left + vp->virtual_width && right > vp->virtual_left &&
 				top < vp->virtual_top + vp->virtual_height && bottom > vp->virtual_top) {
-			int screen_x = (left + right) / 2 - vp->virtual_left;
-			int width = (vp->virtual_width == 0 ? 1 : vp->virtual_width);
-			float panning = (float)screen_x / width;
-
-			StartSound(
-				sound,
-				panning,
-				(msf.effect_vol * _vol_factor_by_zoom[vp->zoom - ZOOM_LVL_BEGIN]) / 256
-			);
-			return;
+			return vp;
 		}
 	}
+	return NULL;
+}
+
+/**
+ * Decide 'where' (between left and right speaker) to play the sound effect.
+ * @param sound Sound effect to play
+ * @param left   Left edge of virtual coordinates where the sound is produced
+ * @param right  Right edge of virtual coordinates where the sound is produced
+ * @param top    Top edge of virtual coordinates where the sound is produced
+ * @param bottom Bottom edge of virtual coordinates where the sound is produced
+ */
+static void SndPlayScreenCoordFx(SoundID sound, int left, int right, int top, int bottom)
+{
+	const ViewPort *vp = FindSoundViewport(left, right, top, bottom);
+	if (vp == NULL) return;
+
+	int screen_x = (left + right) / 2 - vp->virtual_left;
+	int width = (vp->virtual_width == 0 ? 1 : vp->virtual_width);
+	float panning = (float)screen_x / width;
+
+	StartSound(
+		sound,
+		panning,
+		(msf.effect_vol * _vol_factor_by_zoom[vp->zoom - ZOOM_LVL_BEGIN]) / 256
+	);
 }
 
 void SndPlayTileFx(SoundID sound, TileIndex tile)
@@ -262,8 +281,23 @@ void SndPlayTileFx(SoundID sound, TileIndex tile)
 	SndPlayScreenCoordFx(sound, pt.x, pt2.x, pt.y, pt2.y);
 }
 
+/**
+ * Whether the sound effects of a vehicle can be heard, i.e. whether it is
+ * shown in a viewport, so the sounds of the others are never even chosen.
+ * @param v The vehicle.
+ * @return True iff a sound effect of the vehicle would be played.
+ */
+bool SndIsVehicleAudible(const Vehicle *v)
+{
+	/* In the minimal presentation mode only the own vehicles are heard. */
+	if (_settings_client.gui.minimal_presentation && v->owner != _local_company) return false;
+	return FindSoundViewport(v->coord.left, v->coord.right, v->coord.top, v->coord.bottom) != NULL;
+}
+
 void SndPlayVehicleFx(SoundID sound, const Vehicle *v)
 {
+	if (_settings_client.gui.minimal_presentation && v->owner != _local_company) return;
+
 	SndPlayScreenCoordFx(sound,
 		v->coord.left, v->coord.right,
 		v->coord.top, v->coord.bottom
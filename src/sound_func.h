@@ -20,6 +20,7 @@ extern MusicFileSettings msf;
 
 void SndPlayTileFx(SoundID sound, TileIndex tile);
 void SndPlayVehicleFx(SoundID sound, const Vehicle *v);
+bool SndIsVehicleAudible(const Vehicle *v);
 void SndPlayFx(SoundID sound);
 void SndCopyToPool();
 
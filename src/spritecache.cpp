@@ -16,13 +16,17 @@
 #ifdef WITH_PNG
 #include "spriteloader/png.hpp"
 #endif /* WITH_PNG */
+#include "spritecache_disk.h"
 #include "blitter/factory.hpp"
 #include "core/math_func.hpp"
+#include "core/bitmath_func.hpp"
+#include "core/smallvec_type.hpp"
+#include "timeline.h"
 
 #include "table/sprites.h"
 
-/* Default of 4MB spritecache */
-uint _sprite_cache_size = 4;
+/* The sprite cache may grow up to 16MB by default */
+uint _sprite_cache_size = 16;
 
 typedef SimpleTinyEnumT<SpriteType, byte> SpriteTypeByte;
 
@@ -31,7 +35,8 @@ struct SpriteCache {
 	size_t file_pos;
 	uint32 id;
 	uint16 file_slot;
-	int16 lru;
+	SpriteID lru_prev;   ///< The sprite that was used just after this one, if #ptr is set.
+	SpriteID lru_next;   ///< The sprite that was used just before this one, if #ptr is set.
 	SpriteTypeByte type; ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
 	bool warned;         ///< True iff the user has been warned about incorrect use of this sprite
 };
@@ -70,16 +75,20 @@ static SpriteCache *AllocateSpriteCache(uint index)
 }
 
 
+/**
+ * A block of memory of the sprite cache. Free blocks keep a pointer to the
+ * next free block of their size class in the place of their data.
+ */
 struct MemBlock {
-	size_t size;
-	byte data[];
+	size_t size; ///< The size of the block, including this header.
+	byte data[]; ///< The data of the block.
 };
 
-static uint _sprite_lru_counter;
-static MemBlock *_spritecache_ptr;
-static int _compact_cache_counter;
+/** The end of the list of recently used sprites. */
+static const SpriteID SPRITE_LRU_END = UINT_MAX;
 
-static void CompactSpriteCache();
+static SpriteID _sprite_lru_head = SPRITE_LRU_END; ///< The most recently used sprite that is in the cache.
+static SpriteID _sprite_lru_tail = SPRITE_LRU_END; ///< The least recently used sprite that is in the cache.
 
 /**
  * Skip the given amount of sprite graphics data.
@@ -140,6 +149,18 @@ bool SpriteExists(SpriteID id)
 	return !(GetSpriteCache(id)->file_pos == 0 && GetSpriteCache(id)->file_slot == 0);
 }
 
+/**
+ * Is a sprite in the cache, so getting it doesn't need loading it?
+ * @param id the sprite
+ * @return false if the sprite has to be read from its file first
+ */
+bool IsSpriteInCache(SpriteID id)
+{
+	/* A sprite that doesn't exist is replaced by a ?; it isn't worth waiting for. */
+	if (!SpriteExists(id)) return true;
+	return GetSpriteCache(id)->ptr != NULL;
+}
+
 /**
  * Get the sprite type of a given sprite.
  * @param sprite The sprite to look at.
@@ -176,8 +197,45 @@ uint GetMaxSpriteID()
 }
 
 static void *AllocSprite(size_t);
+static void FreeSprite(void *ptr);
+static void RemoveSpriteFromCache(SpriteID id);
+
+static size_t _encoded_sprite_size; ///< The size of the sprite the blitter encoded last.
 
-static void *ReadSprite(SpriteCache *sc, SpriteID id, SpriteType sprite_type)
+/**
+ * Allocate memory for a sprite the blitter encodes, and remember its size.
+ * @param mem_req the amount of memory
+ * @return the memory
+ */
+static void *AllocEncodedSprite(size_t mem_req)
+{
+	_encoded_sprite_size = mem_req;
+	return AllocSprite(mem_req);
+}
+
+/**
+ * Let the blitter encode a sprite, and keep the result in the sprite disk cache.
+ * @param sc          the sprite cache entry of the sprite
+ * @param sprite      the sprite as it is loaded
+ * @param sprite_type the type of the sprite
+ * @return the encoded sprite
+ */
+static void *EncodeSprite(SpriteCache *sc, SpriteLoader::Sprite *sprite, SpriteType sprite_type)
+{
+	sc->ptr = BlitterFactoryBase::GetCurrentBlitter()->Encode(sprite, &AllocEncodedSprite);
+	SpriteDiskCacheStore(sc->file_slot, sc->file_pos, sprite_type, sc->ptr, _encoded_sprite_size);
+	return sc->ptr;
+}
+
+/**
+ * Load a sprite from its file.
+ * @param sc          the sprite cache entry of the sprite
+ * @param id          the sprite
+ * @param sprite_type the type of the sprite
+ * @param try_png     whether to look for a 32bpp PNG of the sprite first, when drawing in 32bpp
+ * @return the loaded sprite
+ */
+static void *ReadSprite(SpriteCache *sc, SpriteID id, SpriteType sprite_type, bool try_png = true)
 {
 	uint8 file_slot = sc->file_slot;
 	size_t file_pos = sc->file_pos;
@@ -187,17 +245,26 @@ static void *ReadSprite(SpriteCache *sc, SpriteID id, SpriteType sprite_type)
 
 	DEBUG(sprite, 9, "Load sprite %d", id);
 
-	if (sprite_type == ST_NORMAL && BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 32) {
+	if (sprite_type == ST_NORMAL || sprite_type == ST_FONT) {
+		/* The blitter might have encoded it before already */
+		size_t size = SpriteDiskCacheFind(file_slot, file_pos, sprite_type);
+		if (size != 0) {
+			void *ptr = AllocSprite(size);
+			if (SpriteDiskCacheRead(ptr, size)) {
+				sc->ptr = ptr;
+				return sc->ptr;
+			}
+			FreeSprite(ptr);
+		}
+	}
+
+	if (try_png && sprite_type == ST_NORMAL && BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 32) {
 #ifdef WITH_PNG
 		/* Try loading 32bpp graphics in case we are 32bpp output */
 		SpriteLoaderPNG sprite_loader;
 		SpriteLoader::Sprite sprite;
 
-		if (sprite_loader.LoadSprite(&sprite, file_slot, sc->id, sprite_type)) {
-			sc->ptr = BlitterFactoryBase::GetCurrentBlitter()->Encode(&sprite, &AllocSprite);
-
-			return sc->ptr;
-		}
+		if (sprite_loader.LoadSprite(&sprite, file_slot, sc->id, sprite_type)) return EncodeSprite(sc, &sprite, sprite_type);
 		/* If the PNG couldn't be loaded, fall back to 8bpp grfs */
 #else
 		static bool show_once = true;
@@ -295,9 +362,8 @@ static void *ReadSprite(SpriteCache *sc, SpriteID id, SpriteType sprite_type)
 		if (id == SPR_IMG_QUERY) usererror("Okay... something went horribly wrong. I couldn't load the fallback sprite. What should I do?");
 		return (void*)GetRawSprite(SPR_IMG_QUERY, ST_NORMAL);
 	}
-	sc->ptr = BlitterFactoryBase::GetCurrentBlitter()->Encode(&sprite, &AllocSprite);
 
-	return sc->ptr;
+	return EncodeSprite(sc, &sprite, sprite_type);
 }
 
 
@@ -321,10 +387,10 @@ bool LoadNextSprite(int load_index, byte file_slot, uint file_sprite_id)
 	}
 
 	SpriteCache *sc = AllocateSpriteCache(load_index);
+	RemoveSpriteFromCache(load_index);
 	sc->file_slot = file_slot;
 	sc->file_pos = file_pos;
 	sc->ptr = NULL;
-	sc->lru = 0;
 	sc->id = file_sprite_id;
 	sc->type = type;
 	sc->warned = false;
@@ -338,6 +404,7 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	SpriteCache *scnew = AllocateSpriteCache(new_spr); // may reallocate: so put it first
 	SpriteCache *scold = GetSpriteCache(old_spr);
 
+	RemoveSpriteFromCache(new_spr);
 	scnew->file_slot = scold->file_slot;
 	scnew->file_pos = scold->file_pos;
 	scnew->ptr = NULL;
@@ -346,179 +413,258 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	scnew->warned = false;
 }
 
-/**
- * S_FREE_MASK is used to mask-out lower bits of MemBlock::size
- * If they are non-zero, the block is free.
- * S_FREE_MASK has to ensure MemBlock is correctly aligned -
- * it means 8B (S_FREE_MASK == 7) on 64bit systems!
- */
-static const size_t S_FREE_MASK = sizeof(size_t) - 1;
+static const uint SPRITE_CACHE_CHUNK_BITS = 20; ///< The log2 of the size of the chunks the memory of the sprite cache is taken from.
+static const uint SIZE_CLASS_MIN_BITS      = 5;  ///< The log2 of the size of the smallest blocks.
+static const uint SIZE_CLASS_STEPS         = 4;  ///< The number of size classes per doubling of the size.
+
+static const size_t SPRITE_CACHE_CHUNK_SIZE = 1 << SPRITE_CACHE_CHUNK_BITS; ///< The size of the chunks; larger blocks get their own memory.
+static const size_t SIZE_CLASS_MIN          = 1 << SIZE_CLASS_MIN_BITS;     ///< The size of the smallest blocks.
+/** The number of size classes; the largest one is as large as a chunk. */
+static const uint SIZE_CLASS_COUNT = (SPRITE_CACHE_CHUNK_BITS - SIZE_CLASS_MIN_BITS) * SIZE_CLASS_STEPS + 1;
 
-/* to make sure nobody adds things to MemBlock without checking S_FREE_MASK first */
-assert_compile(sizeof(MemBlock) == sizeof(size_t));
-/* make sure it's a power of two */
-assert_compile((sizeof(size_t) & (sizeof(size_t) - 1)) == 0);
+/* Every size class has to keep the blocks aligned and has to fit the pointer to the next free block. */
+assert_compile((SIZE_CLASS_MIN >> 2) % sizeof(size_t) == 0);
+assert_compile(SIZE_CLASS_MIN >= sizeof(MemBlock) + sizeof(MemBlock *));
 
-static inline MemBlock *NextBlock(MemBlock *block)
+static MemBlock *_spritecache_free[SIZE_CLASS_COUNT]; ///< The free blocks, per size class.
+static SmallVector<byte *, 16> _spritecache_chunks;   ///< The chunks the blocks are taken from.
+static byte *_spritecache_chunk_pos = NULL;           ///< The start of the part of the last chunk that is not used yet.
+static byte *_spritecache_chunk_end = NULL;           ///< The end of the last chunk.
+static size_t _spritecache_allocated = 0;             ///< The memory of the chunks and the large blocks, in bytes.
+static size_t _spritecache_inuse = 0;                 ///< The memory of the blocks that are in use, in bytes.
+
+/**
+ * Get the memory used by the sprite cache.
+ * @param allocated Is set to the number of bytes allocated for sprites, whether in use or free.
+ * @param in_use    Is set to the number of bytes of the sprites that are cached.
+ * @return the number of bytes of the table with the information about every sprite
+ */
+size_t GetSpriteCacheMemoryUsage(size_t *allocated, size_t *in_use)
 {
-	return (MemBlock*)((byte*)block + (block->size & ~S_FREE_MASK));
+	*allocated = _spritecache_allocated;
+	*in_use = _spritecache_inuse;
+	return _spritecache_items * sizeof(SpriteCache);
 }
 
-static size_t GetSpriteCacheUsage()
+/**
+ * Get the size class a block of a given size belongs to.
+ * @param size the size of the block, including its header
+ * @return the smallest size class the block fits in
+ */
+static inline uint GetSizeClass(size_t size)
 {
-	size_t tot_size = 0;
-	MemBlock *s;
+	assert(size <= SPRITE_CACHE_CHUNK_SIZE);
+	if (size <= SIZE_CLASS_MIN) return 0;
 
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (!(s->size & S_FREE_MASK)) tot_size += s->size;
-	}
+	uint bits = FindLastBit(size - 1);
+	uint step = ((size - 1) >> (bits - 2)) & (SIZE_CLASS_STEPS - 1);
+	return (bits - SIZE_CLASS_MIN_BITS) * SIZE_CLASS_STEPS + step + 1;
+}
+
+/**
+ * Get the size of the blocks of a size class.
+ * @param size_class the size class
+ * @return the size of its blocks, including their header
+ */
+static inline size_t GetSizeClassSize(uint size_class)
+{
+	assert(size_class < SIZE_CLASS_COUNT);
+	if (size_class == 0) return SIZE_CLASS_MIN;
 
-	return tot_size;
+	uint bits = (size_class - 1) / SIZE_CLASS_STEPS + SIZE_CLASS_MIN_BITS;
+	uint step = (size_class - 1) % SIZE_CLASS_STEPS;
+	return ((size_t)1 << bits) + ((size_t)(step + 1) << (bits - 2));
 }
 
+/**
+ * Add a block to the free blocks of its size class.
+ * @param block the block; its size has to be the size of a size class
+ */
+static inline void AddFreeBlock(MemBlock *block)
+{
+	uint size_class = GetSizeClass(block->size);
+	assert(GetSizeClassSize(size_class) == block->size);
+
+	*(MemBlock **)block->data = _spritecache_free[size_class];
+	_spritecache_free[size_class] = block;
+}
 
-void IncreaseSpriteLRU()
+/** Hand the part of the last chunk that isn't used yet out as free blocks. */
+static void FreeChunkRemainder()
 {
-	/* Increase all LRU values */
-	if (_sprite_lru_counter > 16384) {
-		SpriteID i;
-
-		DEBUG(sprite, 3, "Fixing lru %u, inuse=" PRINTF_SIZE, _sprite_lru_counter, GetSpriteCacheUsage());
-
-		for (i = 0; i != _spritecache_items; i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->ptr != NULL) {
-				if (sc->lru >= 0) {
-					sc->lru = -1;
-				} else if (sc->lru != -32768) {
-					sc->lru--;
-				}
-			}
+	for (uint size_class = SIZE_CLASS_COUNT; size_class-- > 0;) {
+		size_t size = GetSizeClassSize(size_class);
+		while (_spritecache_chunk_pos + size <= _spritecache_chunk_end) {
+			MemBlock *block = (MemBlock *)_spritecache_chunk_pos;
+			block->size = size;
+			AddFreeBlock(block);
+			_spritecache_chunk_pos += size;
 		}
-		_sprite_lru_counter = 0;
 	}
+}
+
+/**
+ * Free the memory of a sprite.
+ * @param ptr the data of the sprite, as returned by AllocSprite
+ */
+static void FreeSprite(void *ptr)
+{
+	MemBlock *block = (MemBlock *)ptr - 1;
+	_spritecache_inuse -= block->size;
 
-	/* Compact sprite cache every now and then. */
-	if (++_compact_cache_counter >= 740) {
-		CompactSpriteCache();
-		_compact_cache_counter = 0;
+	if (block->size > SPRITE_CACHE_CHUNK_SIZE) {
+		_spritecache_allocated -= block->size;
+		free(block);
+	} else {
+		AddFreeBlock(block);
 	}
 }
 
-/** Called when holes in the sprite cache should be removed.
- * That is accomplished by moving the cached data. */
-static void CompactSpriteCache()
+/**
+ * Make a sprite the most recently used one.
+ * @param id the sprite; it has to be in the cache, but not in the list of used sprites
+ */
+static void LinkSpriteLRU(SpriteID id)
 {
-	MemBlock *s;
-
-	DEBUG(sprite, 3, "Compacting sprite cache, inuse=" PRINTF_SIZE, GetSpriteCacheUsage());
+	SpriteCache *sc = GetSpriteCache(id);
+	sc->lru_prev = SPRITE_LRU_END;
+	sc->lru_next = _sprite_lru_head;
 
-	for (s = _spritecache_ptr; s->size != 0;) {
-		if (s->size & S_FREE_MASK) {
-			MemBlock *next = NextBlock(s);
-			MemBlock temp;
-			SpriteID i;
+	if (_sprite_lru_head != SPRITE_LRU_END) {
+		GetSpriteCache(_sprite_lru_head)->lru_prev = id;
+	} else {
+		_sprite_lru_tail = id;
+	}
+	_sprite_lru_head = id;
+}
 
-			/* Since free blocks are automatically coalesced, this should hold true. */
-			assert(!(next->size & S_FREE_MASK));
+/**
+ * Remove a sprite from the list of used sprites.
+ * @param id the sprite; it has to be in the cache
+ */
+static void UnlinkSpriteLRU(SpriteID id)
+{
+	SpriteCache *sc = GetSpriteCache(id);
 
-			/* If the next block is the sentinel block, we can safely return */
-			if (next->size == 0) break;
+	if (sc->lru_prev != SPRITE_LRU_END) {
+		GetSpriteCache(sc->lru_prev)->lru_next = sc->lru_next;
+	} else {
+		_sprite_lru_head = sc->lru_next;
+	}
 
-			/* Locate the sprite belonging to the next pointer. */
-			for (i = 0; GetSpriteCache(i)->ptr != next->data; i++) {
-				assert(i != _spritecache_items);
-			}
+	if (sc->lru_next != SPRITE_LRU_END) {
+		GetSpriteCache(sc->lru_next)->lru_prev = sc->lru_prev;
+	} else {
+		_sprite_lru_tail = sc->lru_prev;
+	}
+}
 
-			GetSpriteCache(i)->ptr = s->data; // Adjust sprite array entry
-			/* Swap this and the next block */
-			temp = *s;
-			memmove(s, next, next->size);
-			s = NextBlock(s);
-			*s = temp;
+/**
+ * Remove a sprite from the cache, if it is in there.
+ * @param id the sprite
+ */
+static void RemoveSpriteFromCache(SpriteID id)
+{
+	SpriteCache *sc = GetSpriteCache(id);
+	if (sc->ptr == NULL) return;
 
-			/* Coalesce free blocks */
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		} else {
-			s = NextBlock(s);
-		}
-	}
+	UnlinkSpriteLRU(id);
+	FreeSprite(sc->ptr);
+	sc->ptr = NULL;
 }
 
-static void DeleteEntryFromSpriteCache()
+/**
+ * Remove the least recently used sprite from the cache.
+ * @return false when there was no sprite in the cache
+ */
+static bool DeleteEntryFromSpriteCache()
 {
-	SpriteID i;
-	uint best = UINT_MAX;
-	MemBlock *s;
-	int cur_lru;
-
-	DEBUG(sprite, 3, "DeleteEntryFromSpriteCache, inuse=" PRINTF_SIZE, GetSpriteCacheUsage());
-
-	cur_lru = 0xffff;
-	for (i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->ptr != NULL && sc->lru < cur_lru) {
-			cur_lru = sc->lru;
-			best = i;
-		}
-	}
+	if (_sprite_lru_tail == SPRITE_LRU_END) return false;
 
-	/* Display an error message and die, in case we found no sprite at all.
-	 * This shouldn't really happen, unless all sprites are locked. */
-	if (best == UINT_MAX) error("Out of sprite memory");
-
-	/* Mark the block as free (the block must be in use) */
-	s = (MemBlock*)GetSpriteCache(best)->ptr - 1;
-	assert(!(s->size & S_FREE_MASK));
-	s->size |= S_FREE_MASK;
-	GetSpriteCache(best)->ptr = NULL;
-
-	/* And coalesce adjacent free blocks */
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (s->size & S_FREE_MASK) {
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		}
-	}
+	DEBUG(sprite, 4, "DeleteEntryFromSpriteCache, inuse=" PRINTF_SIZE, _spritecache_inuse);
+
+	RemoveSpriteFromCache(_sprite_lru_tail);
+	return true;
 }
 
+/** Free all memory of the sprite cache; there may not be any sprite in it. */
+static void FreeSpriteCacheMemory()
+{
+	assert(_sprite_lru_head == SPRITE_LRU_END);
+
+	for (byte **chunk = _spritecache_chunks.Begin(); chunk != _spritecache_chunks.End(); chunk++) free(*chunk);
+	_spritecache_chunks.Clear();
+	memset(_spritecache_free, 0, sizeof(_spritecache_free));
+	_spritecache_chunk_pos = NULL;
+	_spritecache_chunk_end = NULL;
+	_spritecache_allocated = 0;
+}
+
+/**
+ * Allocate memory for a sprite. The least recently used sprites are removed
+ * from the cache while there is no memory of the right size for it and the
+ * cache can't grow anymore.
+ * @param mem_req the amount of memory
+ * @return the memory
+ */
 static void *AllocSprite(size_t mem_req)
 {
-	mem_req += sizeof(MemBlock);
+	mem_req = Align(mem_req + sizeof(MemBlock), sizeof(size_t));
+	size_t max_size = _sprite_cache_size * 1024 * 1024;
+
+	if (mem_req > SPRITE_CACHE_CHUNK_SIZE) {
+		/* Too large for a chunk; it gets memory of its own. */
+		while (_spritecache_allocated + mem_req > max_size && DeleteEntryFromSpriteCache()) {}
+
+		MemBlock *block = (MemBlock *)MallocT<byte>(mem_req);
+		block->size = mem_req;
+		_spritecache_allocated += mem_req;
+		_spritecache_inuse += mem_req;
+		return block->data;
+	}
 
-	/* Align this to correct boundary. This also makes sure at least one
-	 * bit is not used, so we can use it for other things. */
-	mem_req = Align(mem_req, S_FREE_MASK + 1);
+	uint size_class = GetSizeClass(mem_req);
+	size_t size = GetSizeClassSize(size_class);
 
 	for (;;) {
-		MemBlock *s;
-
-		for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-			if (s->size & S_FREE_MASK) {
-				size_t cur_size = s->size & ~S_FREE_MASK;
-
-				/* Is the block exactly the size we need or
-				 * big enough for an additional free block? */
-				if (cur_size == mem_req ||
-						cur_size >= mem_req + sizeof(MemBlock)) {
-					/* Set size and in use */
-					s->size = mem_req;
-
-					/* Do we need to inject a free block too? */
-					if (cur_size != mem_req) {
-						NextBlock(s)->size = (cur_size - mem_req) | S_FREE_MASK;
-					}
-
-					return s->data;
-				}
-			}
+		/* A free block of the size class, or one of the size classes just above it. */
+		uint last = min(size_class + SIZE_CLASS_STEPS, SIZE_CLASS_COUNT);
+		for (uint i = size_class; i < last; i++) {
+			MemBlock *block = _spritecache_free[i];
+			if (block == NULL) continue;
+
+			_spritecache_free[i] = *(MemBlock **)block->data;
+			_spritecache_inuse += block->size;
+			return block->data;
 		}
 
-		/* Reached sentinel, but no block found yet. Delete some old entry. */
-		DeleteEntryFromSpriteCache();
+		/* A new block from the last chunk. */
+		if (_spritecache_chunk_pos + size <= _spritecache_chunk_end) {
+			MemBlock *block = (MemBlock *)_spritecache_chunk_pos;
+			block->size = size;
+			_spritecache_chunk_pos += size;
+			_spritecache_inuse += size;
+			return block->data;
+		}
+
+		/* A new chunk, as long as the cache may grow. */
+		if (_spritecache_allocated + SPRITE_CACHE_CHUNK_SIZE <= max_size || _spritecache_allocated == 0) {
+			FreeChunkRemainder();
+
+			byte *chunk = MallocT<byte>(SPRITE_CACHE_CHUNK_SIZE);
+			*_spritecache_chunks.Append() = chunk;
+			_spritecache_chunk_pos = chunk;
+			_spritecache_chunk_end = chunk + SPRITE_CACHE_CHUNK_SIZE;
+			_spritecache_allocated += SPRITE_CACHE_CHUNK_SIZE;
+
+			DEBUG(sprite, 3, "Increasing sprite cache memory to " PRINTF_SIZE " bytes, inuse=" PRINTF_SIZE, _spritecache_allocated, _spritecache_inuse);
+			continue;
+		}
+
+		/* Make room by removing the least recently used sprite. Once all
+		 * sprites are gone the memory is cut up in the wrong sizes, so
+		 * start all over again. */
+		if (!DeleteEntryFromSpriteCache()) FreeSpriteCacheMemory();
 	}
 }
 
@@ -581,34 +727,86 @@ void *GetRawSprite(SpriteID sprite, SpriteType type)
 
 	if (sc->type != type) return HandleInvalidSpriteRequest(sprite, type, sc);
 
-	/* Update LRU */
-	sc->lru = ++_sprite_lru_counter;
-
 	void *p = sc->ptr;
 
-	/* Load the sprite, if it is not loaded, yet */
-	if (p == NULL) p = ReadSprite(sc, sprite, type);
+	if (p == NULL) {
+		TIMELINE_ZONE_ARG("sprite cache miss", sprite);
+
+		/* Load the sprite, if it is not loaded, yet */
+		p = ReadSprite(sc, sprite, type);
+		/* The fallback for a sprite that can't be loaded is cached by itself. */
+		if (sc->ptr != NULL) LinkSpriteLRU(sprite);
+	} else if (_sprite_lru_head != sprite) {
+		/* Update LRU */
+		UnlinkSpriteLRU(sprite);
+		LinkSpriteLRU(sprite);
+	}
 
 	return p;
 }
 
+/**
+ * Load a number of normal sprites at once. When drawing in 32bpp, their
+ * PNGs are loaded by a few threads; the rest is loaded as GetRawSprite would.
+ * @param sprites the sprites
+ * @param count   the number of sprites
+ */
+void LoadSprites(const SpriteID *sprites, uint count)
+{
+#ifdef WITH_PNG
+	if (BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 32) {
+		PNGSpriteJob *jobs = new PNGSpriteJob[count];
+		SpriteID *job_sprites = MallocT<SpriteID>(count);
+		uint num = 0;
+
+		for (uint i = 0; i < count; i++) {
+			if (IsSpriteInCache(sprites[i])) continue;
+
+			SpriteCache *sc = GetSpriteCache(sprites[i]);
+			if (sc->type != ST_NORMAL || SpriteDiskCacheFind(sc->file_slot, sc->file_pos, ST_NORMAL) != 0) continue;
+
+			jobs[num].filename = FioGetFilename(sc->file_slot);
+			jobs[num].id = sc->id;
+			job_sprites[num] = sprites[i];
+			num++;
+		}
+
+		SpriteLoaderPNG::LoadSprites(jobs, num);
+
+		for (uint i = 0; i < num; i++) {
+			SpriteCache *sc = GetSpriteCache(job_sprites[i]);
+			if (sc->ptr != NULL) continue;
+
+			/* Without its PNG the sprite needn't look for it again. */
+			if (jobs[i].ok) {
+				EncodeSprite(sc, &jobs[i].sprite, ST_NORMAL);
+			} else {
+				ReadSprite(sc, job_sprites[i], ST_NORMAL, false);
+			}
+			if (sc->ptr != NULL) LinkSpriteLRU(job_sprites[i]);
+		}
+
+		free(job_sprites);
+		delete[] jobs;
+	}
+#endif /* WITH_PNG */
+
+	for (uint i = 0; i < count; i++) {
+		if (!IsSpriteInCache(sprites[i])) GetRawSprite(sprites[i], GetSpriteType(sprites[i]));
+	}
+}
+
 
 void GfxInitSpriteMem()
 {
-	/* initialize sprite cache heap */
-	if (_spritecache_ptr == NULL) _spritecache_ptr = (MemBlock*)MallocT<byte>(_sprite_cache_size * 1024 * 1024);
-
-	/* A big free block */
-	_spritecache_ptr->size = ((_sprite_cache_size * 1024 * 1024) - sizeof(MemBlock)) | S_FREE_MASK;
-	/* Sentinel block (identified by size == 0) */
-	NextBlock(_spritecache_ptr)->size = 0;
+	/* Empty the sprite cache heap */
+	while (DeleteEntryFromSpriteCache()) {}
+	FreeSpriteCacheMemory();
 
 	/* Reset the spritecache 'pool' */
 	free(_spritecache);
 	_spritecache_items = 0;
 	_spritecache = NULL;
-
-	_compact_cache_counter = 0;
 }
 
 /* static */ ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer;
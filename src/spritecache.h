@@ -27,10 +27,13 @@ extern uint _sprite_cache_size;
 
 void *GetRawSprite(SpriteID sprite, SpriteType type);
 bool SpriteExists(SpriteID sprite);
+bool IsSpriteInCache(SpriteID sprite);
+void LoadSprites(const SpriteID *sprites, uint count);
 
 SpriteType GetSpriteType(SpriteID sprite);
 uint GetOriginFileSlot(SpriteID sprite);
 uint GetMaxSpriteID();
+size_t GetSpriteCacheMemoryUsage(size_t *allocated, size_t *in_use);
 
 
 static inline const Sprite *GetSprite(SpriteID sprite, SpriteType type)
@@ -46,7 +49,6 @@ static inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 }
 
 void GfxInitSpriteMem();
-void IncreaseSpriteLRU();
 
 bool LoadNextSprite(int load_index, byte file_index, uint file_sprite_id);
 bool SkipSpriteData(byte type, uint16 num);
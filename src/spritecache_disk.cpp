@@ -0,0 +1,320 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file spritecache_disk.cpp Keeping the sprites, as encoded by the blitter, on disk.
+ *
+ * For every blitter there is a pack file in the personal directory with the
+ * sprites it has encoded, one after the other. A sprite is known by the
+ * stamp of the file it is read from, its position in that file, its type and
+ * whether its palette is remapped, so a changed file doesn't match its old
+ * sprites anymore. When the pack grows too large it is started all over.
+ */
+
+#include "stdafx.h"
+#include "debug.h"
+#include "fileio_func.h"
+#include "gfx_func.h"
+#include "string_func.h"
+#include "spritecache_disk.h"
+#include "blitter/factory.hpp"
+
+bool _sprite_disk_cache = false; ///< Whether to keep the encoded sprites on disk.
+
+static const uint32 SPRITE_DISK_CACHE_VERSION = 1;                   ///< The version of the format of the pack file.
+static const size_t SPRITE_DISK_CACHE_MAX_SIZE = 256 * 1024 * 1024;  ///< The size above which the pack file is started all over.
+static const uint SPRITE_DISK_CACHE_FLUSH_INTERVAL = 256;            ///< The number of sprites after which the pack file is flushed.
+static const uint SPRITE_DISK_CACHE_MIN_ENTRIES = 4096;              ///< The initial size of the hash table of the sprites.
+
+/** The start of the pack file. */
+struct SpriteDiskCacheHeader {
+	char magic[4];    ///< "OSPC".
+	uint32 version;   ///< The #SPRITE_DISK_CACHE_VERSION.
+	uint32 endian;    ///< The TTD_ENDIAN of the machine that wrote the pack.
+	char blitter[32]; ///< The name of the blitter that encoded the sprites.
+};
+
+/** What comes before every sprite in the pack file. */
+struct SpriteDiskCacheRecord {
+	uint32 stamp; ///< The stamp of the file the sprite was read from.
+	uint32 pos;   ///< The position of the sprite in that file.
+	uint32 flags; ///< The type of the sprite, and whether its palette was remapped.
+	uint32 size;  ///< The size of the encoded sprite.
+	uint32 check; ///< A check of the other members, to see where a partially written pack ends.
+};
+
+/** Where a sprite is in the pack file. */
+struct SpriteDiskCacheEntry {
+	uint32 stamp;  ///< The stamp of the file the sprite was read from.
+	uint32 pos;    ///< The position of the sprite in that file.
+	uint32 flags;  ///< The type of the sprite, and whether its palette was remapped.
+	uint32 size;   ///< The size of the encoded sprite.
+	uint32 offset; ///< The position of the encoded sprite in the pack; 0 for unused entries.
+};
+
+static FILE *_pack = NULL;                     ///< The pack file of the blitter.
+static char _pack_blitter[32];                 ///< The blitter the pack file was opened for; empty when none was.
+static size_t _pack_size = 0;                  ///< The size of the complete part of the pack file.
+static SpriteDiskCacheEntry *_pack_entries = NULL; ///< The hash table of the sprites in the pack file.
+static uint _pack_entries_mask = 0;            ///< The number of entries of the hash table minus one.
+static uint _pack_entries_count = 0;           ///< The number of used entries of the hash table.
+static uint _pack_unflushed = 0;               ///< The number of sprites written since the last flush.
+
+/**
+ * Get the check of the members of a record.
+ * @param r the record
+ * @return the check
+ */
+static inline uint32 GetRecordCheck(const SpriteDiskCacheRecord *r)
+{
+	return (r->stamp ^ (r->pos * 0x9E3779B1) ^ (r->flags << 24) ^ (r->size * 0x85EBCA6B)) + 0x4F535043;
+}
+
+/**
+ * Find the entry of a sprite in the hash table.
+ * @param stamp the stamp of the file of the sprite
+ * @param pos   the position of the sprite in its file
+ * @param flags the type of the sprite, and whether its palette is remapped
+ * @return the entry of the sprite, or the unused entry where it would go
+ */
+static SpriteDiskCacheEntry *FindEntry(uint32 stamp, uint32 pos, uint32 flags)
+{
+	uint i = (stamp ^ (pos * 0x9E3779B1) ^ flags) & _pack_entries_mask;
+	for (;;) {
+		SpriteDiskCacheEntry *e = &_pack_entries[i];
+		if (e->offset == 0 || (e->stamp == stamp && e->pos == pos && e->flags == flags)) return e;
+		i = (i + 1) & _pack_entries_mask;
+	}
+}
+
+/**
+ * Add a sprite to the hash table.
+ * @param r      the record of the sprite
+ * @param offset the position of the encoded sprite in the pack
+ */
+static void AddEntry(const SpriteDiskCacheRecord *r, uint32 offset)
+{
+	if (_pack_entries_count * 2 >= _pack_entries_mask) {
+		/* Keep the table at most half full, so the sprites are found fast. */
+		SpriteDiskCacheEntry *old_entries = _pack_entries;
+		uint old_size = _pack_entries_mask + 1;
+
+		_pack_entries_mask = old_size * 2 - 1;
+		_pack_entries = CallocT<SpriteDiskCacheEntry>(old_size * 2);
+		for (uint i = 0; i < old_size; i++) {
+			if (old_entries[i].offset != 0) *FindEntry(old_entries[i].stamp, old_entries[i].pos, old_entries[i].flags) = old_entries[i];
+		}
+		free(old_entries);
+	}
+
+	SpriteDiskCacheEntry *e = FindEntry(r->stamp, r->pos, r->flags);
+	if (e->offset == 0) _pack_entries_count++;
+	e->stamp = r->stamp;
+	e->pos = r->pos;
+	e->flags = r->flags;
+	e->size = r->size;
+	e->offset = offset;
+}
+
+/** Close the pack file, if any, and forget the sprites in it. */
+static void ForgetPack()
+{
+	if (_pack != NULL) fclose(_pack);
+	_pack = NULL;
+	_pack_size = 0;
+	_pack_unflushed = 0;
+
+	free(_pack_entries);
+	_pack_entries = NULL;
+	_pack_entries_mask = 0;
+	_pack_entries_count = 0;
+}
+
+/** Close the pack file, if any, and make an empty hash table for the next one. */
+static void ResetPack()
+{
+	ForgetPack();
+	_pack_entries_mask = SPRITE_DISK_CACHE_MIN_ENTRIES - 1;
+	_pack_entries = CallocT<SpriteDiskCacheEntry>(SPRITE_DISK_CACHE_MIN_ENTRIES);
+}
+
+/**
+ * Read the sprites of the pack file that is opened.
+ * @param header the header the pack file should have
+ * @return false when the pack file isn't of this version or blitter
+ */
+static bool ReadPack(const SpriteDiskCacheHeader *header)
+{
+	if (fseek(_pack, 0, SEEK_END) != 0) return false;
+	long file_size = ftell(_pack);
+	if (file_size < 0 || (size_t)file_size > SPRITE_DISK_CACHE_MAX_SIZE || fseek(_pack, 0, SEEK_SET) != 0) return false;
+
+	SpriteDiskCacheHeader h;
+	if (fread(&h, sizeof(h), 1, _pack) != 1 || memcmp(&h, header, sizeof(h)) != 0) return false;
+
+	_pack_size = sizeof(h);
+	for (;;) {
+		SpriteDiskCacheRecord r;
+		if (fread(&r, sizeof(r), 1, _pack) != 1 || r.check != GetRecordCheck(&r)) break;
+
+		/* A sprite of which only a part was written doesn't count; it is overwritten. */
+		size_t offset = _pack_size + sizeof(r);
+		if (offset + r.size > (size_t)file_size || fseek(_pack, (long)(offset + r.size), SEEK_SET) != 0) break;
+
+		AddEntry(&r, (uint32)offset);
+		_pack_size = offset + r.size;
+	}
+
+	DEBUG(sprite, 1, "Using %u sprites of the sprite disk cache of %s", _pack_entries_count, header->blitter);
+	return true;
+}
+
+/**
+ * Open the pack file of #_pack_blitter, or start it when there is none that
+ * can be used.
+ * @param start_over whether to start a new pack file, even when there is one
+ */
+static void OpenPack(bool start_over)
+{
+	SpriteDiskCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "OSPC", sizeof(header.magic));
+	header.version = SPRITE_DISK_CACHE_VERSION;
+	header.endian = TTD_ENDIAN;
+	strecpy(header.blitter, _pack_blitter, lastof(header.blitter));
+
+	char filename[MAX_PATH];
+	snprintf(filename, lengthof(filename), "%ssprites_%s.cache", _personal_dir, _pack_blitter);
+
+	if (!start_over) {
+		ResetPack();
+		_pack = fopen(filename, "r+b");
+		if (_pack != NULL && ReadPack(&header)) return;
+	}
+
+	ResetPack();
+	_pack = fopen(filename, "w+b");
+	if (_pack == NULL || fwrite(&header, sizeof(header), 1, _pack) != 1) {
+		/* Keep _pack_blitter, so it isn't tried again for every sprite. */
+		DEBUG(sprite, 0, "Could not write the sprite disk cache '%s'", filename);
+		ForgetPack();
+		return;
+	}
+	_pack_size = sizeof(header);
+}
+
+/**
+ * Make sure the pack file of the current blitter is opened, if the sprites
+ * are to be kept on disk.
+ * @return whether there is a pack file to use
+ */
+static bool PreparePack()
+{
+	if (!_sprite_disk_cache) return false;
+
+	const char *blitter = BlitterFactoryBase::GetCurrentBlitter()->GetName();
+	if (strcmp(blitter, _pack_blitter) != 0) {
+		strecpy(_pack_blitter, blitter, lastof(_pack_blitter));
+		OpenPack(false);
+	}
+
+	return _pack != NULL;
+}
+
+/**
+ * Get the flags of a sprite as they are kept in the pack file.
+ * @param file_slot the file slot of the sprite
+ * @param type      the type of the sprite
+ * @return the flags
+ */
+static inline uint32 GetSpriteFlags(uint8 file_slot, SpriteType type)
+{
+	return type | (_palette_remap_grf[file_slot] ? 0x100 : 0);
+}
+
+/**
+ * Find an encoded sprite in the sprite disk cache. When it is there, it has
+ * to be read with #SpriteDiskCacheRead before the sprite disk cache is used
+ * for anything else.
+ * @param file_slot the file slot of the sprite
+ * @param file_pos  the position of the sprite in its file
+ * @param type      the type of the sprite
+ * @return the size of the encoded sprite, or 0 if it isn't in the cache
+ */
+size_t SpriteDiskCacheFind(uint8 file_slot, size_t file_pos, SpriteType type)
+{
+	if (!PreparePack()) return 0;
+
+	const SpriteDiskCacheEntry *e = FindEntry(FioGetFileStamp(file_slot), (uint32)file_pos, GetSpriteFlags(file_slot, type));
+	if (e->offset == 0 || fseek(_pack, e->offset, SEEK_SET) != 0) return 0;
+
+	return e->size;
+}
+
+/**
+ * Read the encoded sprite that was found by #SpriteDiskCacheFind.
+ * @param buf  the memory for the encoded sprite
+ * @param size the size of the encoded sprite
+ * @return false if it could not be read
+ */
+bool SpriteDiskCacheRead(void *buf, size_t size)
+{
+	return fread(buf, 1, size, _pack) == size;
+}
+
+/**
+ * Add an encoded sprite to the sprite disk cache.
+ * @param file_slot the file slot of the sprite
+ * @param file_pos  the position of the sprite in its file
+ * @param type      the type of the sprite
+ * @param data      the encoded sprite
+ * @param size      the size of the encoded sprite
+ */
+void SpriteDiskCacheStore(uint8 file_slot, size_t file_pos, SpriteType type, const void *data, size_t size)
+{
+	if (!PreparePack()) return;
+
+	SpriteDiskCacheRecord r;
+	r.stamp = FioGetFileStamp(file_slot);
+	r.pos = (uint32)file_pos;
+	r.flags = GetSpriteFlags(file_slot, type);
+	r.size = (uint32)size;
+	r.check = GetRecordCheck(&r);
+
+	if (FindEntry(r.stamp, r.pos, r.flags)->offset != 0) return;
+
+	if (_pack_size + sizeof(r) + size > SPRITE_DISK_CACHE_MAX_SIZE) {
+		/* Start all over; most likely it's full of sprites of files that have changed since. */
+		OpenPack(true);
+		if (_pack == NULL) return;
+	}
+
+	if (fseek(_pack, (long)_pack_size, SEEK_SET) != 0 ||
+			fwrite(&r, sizeof(r), 1, _pack) != 1 ||
+			fwrite(data, 1, size, _pack) != size) {
+		DEBUG(sprite, 0, "Could not write to the sprite disk cache; not using it anymore");
+		ForgetPack();
+		return;
+	}
+
+	AddEntry(&r, (uint32)(_pack_size + sizeof(r)));
+	_pack_size += sizeof(r) + size;
+
+	if (++_pack_unflushed >= SPRITE_DISK_CACHE_FLUSH_INTERVAL) {
+		fflush(_pack);
+		_pack_unflushed = 0;
+	}
+}
+
+/** Close the pack file and forget what is in it. */
+void SpriteDiskCacheClose()
+{
+	ForgetPack();
+	_pack_blitter[0] = '\0';
+}
@@ -0,0 +1,24 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spritecache_disk.h Functions to keep the sprites, as encoded by the blitter, on disk. */
+
+#ifndef SPRITECACHE_DISK_H
+#define SPRITECACHE_DISK_H
+
+#include "gfx_type.h"
+
+extern bool _sprite_disk_cache;
+
+size_t SpriteDiskCacheFind(uint8 file_slot, size_t file_pos, SpriteType type);
+bool SpriteDiskCacheRead(void *buf, size_t size);
+void SpriteDiskCacheStore(uint8 file_slot, size_t file_pos, SpriteType type, const void *data, size_t size);
+void SpriteDiskCacheClose();
+
+#endif /* SPRITECACHE_DISK_H */
@@ -14,14 +14,16 @@
 #include "../stdafx.h"
 #include "../fileio_func.h"
 #include "../debug.h"
+#include "../thread/thread.h"
 #include "png.hpp"
 #include <png.h>
 
-#define PNG_SLOT 62
+/** The number of threads loading PNG sprites at once, including the main thread. */
+static const uint PNG_LOAD_THREADS = 4;
 
 static void PNGAPI png_my_read(png_structp png_ptr, png_bytep data, png_size_t length)
 {
-	FioReadBlock(data, length);
+	if (fread(data, 1, length, (FILE *)png_get_io_ptr(png_ptr)) != length) png_error(png_ptr, "Read error");
 }
 
 static void PNGAPI png_my_error(png_structp png_ptr, png_const_charp message)
@@ -35,23 +37,29 @@ static void PNGAPI png_my_warning(png_structp png_ptr, png_const_charp message)
 	DEBUG(sprite, 0, "WARNING (libpng): %s - %s", message, (char *)png_get_error_ptr(png_ptr));
 }
 
-static bool OpenPNGFile(const char *filename, uint32 id, bool mask)
+/**
+ * Open the PNG file of a sprite.
+ * @param filename the name of the file the sprite belongs to
+ * @param id       the number of the sprite
+ * @param mask     whether to open the mask of the sprite
+ * @param mutex    the mutex to hold while opening the file, when other threads open files too
+ * @return the file, or NULL if there is none
+ */
+static FILE *OpenPNGFile(const char *filename, uint32 id, bool mask, ThreadMutex *mutex)
 {
 	char png_file[MAX_PATH];
 
 	/* Add path separator after 'sprites' if not present */
 	const char *sep = (filename[0] == PATHSEPCHAR) ? "" : PATHSEP;
 	snprintf(png_file, sizeof(png_file), "sprites%s%s" PATHSEP "%d%s.png", sep, filename, id, mask ? "m" : "");
-	if (FioCheckFileExists(png_file)) {
-		FioOpenFile(PNG_SLOT, png_file);
-		return true;
-	}
 
-	/* TODO -- Add TAR support */
-	return false;
+	if (mutex != NULL) mutex->BeginCritical();
+	FILE *f = FioFOpenFile(png_file);
+	if (mutex != NULL) mutex->EndCritical();
+	return f;
 }
 
-static bool LoadPNG(SpriteLoader::Sprite *sprite, const char *filename, uint32 id, volatile bool mask)
+static bool LoadPNG(SpriteLoader::Sprite *sprite, const char *filename, uint32 id, volatile bool mask, ReusableBuffer<SpriteLoader::CommonPixel> *own_buffer = NULL, ThreadMutex *mutex = NULL)
 {
 	png_byte header[8];
 	png_structp png_ptr;
@@ -60,36 +68,45 @@ static bool LoadPNG(SpriteLoader::Sprite *sprite, const char *filename, uint32 i
 	uint i, pixelsize;
 	SpriteLoader::CommonPixel *dst;
 
-	if (!OpenPNGFile(filename, id, mask)) return mask; // If mask is true, and file not found, continue true anyway, as it isn't a show-stopper
+	FILE *f = OpenPNGFile(filename, id, mask, mutex);
+	if (f == NULL) return mask; // If mask is true, and file not found, continue true anyway, as it isn't a show-stopper
 
 	/* Check the header */
-	FioReadBlock(header, 8);
-	if (png_sig_cmp(header, 0, 8) != 0) return false;
+	if (fread(header, 1, 8, f) != 8 || png_sig_cmp(header, 0, 8) != 0) {
+		FioFCloseFile(f);
+		return false;
+	}
 
 	/* Create the reader */
 	png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, png_my_error, png_my_warning);
-	if (png_ptr == NULL) return false;
+	if (png_ptr == NULL) {
+		FioFCloseFile(f);
+		return false;
+	}
 
 	/* Create initial stuff */
 	info_ptr = png_create_info_struct(png_ptr);
 	if (info_ptr == NULL) {
 		png_destroy_read_struct(&png_ptr, (png_infopp)NULL, (png_infopp)NULL);
+		FioFCloseFile(f);
 		return false;
 	}
 	end_info = png_create_info_struct(png_ptr);
 	if (end_info == NULL) {
 		png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
+		FioFCloseFile(f);
 		return false;
 	}
 
 	/* Make sure that upon error, we can clean up graceful */
 	if (setjmp(png_jmpbuf(png_ptr))) {
 		png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+		FioFCloseFile(f);
 		return false;
 	}
 
 	/* Read the file */
-	png_set_read_fn(png_ptr, NULL, png_my_read);
+	png_set_read_fn(png_ptr, f, png_my_read);
 	png_set_sig_bytes(png_ptr, 8);
 
 	png_read_info(png_ptr, info_ptr);
@@ -108,7 +125,7 @@ static bool LoadPNG(SpriteLoader::Sprite *sprite, const char *filename, uint32 i
 
 		sprite->height = png_get_image_height(png_ptr, info_ptr);
 		sprite->width  = png_get_image_width(png_ptr, info_ptr);
-		sprite->AllocateData(sprite->width * sprite->height);
+		sprite->AllocateData(sprite->width * sprite->height, own_buffer);
 	}
 
 	bit_depth  = png_get_bit_depth(png_ptr, info_ptr);
@@ -116,6 +133,8 @@ static bool LoadPNG(SpriteLoader::Sprite *sprite, const char *filename, uint32 i
 
 	if (mask && (bit_depth != 8 || colour_type != PNG_COLOR_TYPE_PALETTE)) {
 		DEBUG(misc, 0, "Ignoring mask for SpriteID %d as it isn't a 8 bit palette image", id);
+		png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+		FioFCloseFile(f);
 		return true;
 	}
 
@@ -172,6 +191,7 @@ static bool LoadPNG(SpriteLoader::Sprite *sprite, const char *filename, uint32 i
 	}
 
 	png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+	FioFCloseFile(f);
 
 	return true;
 }
@@ -184,4 +204,59 @@ bool SpriteLoaderPNG::LoadSprite(SpriteLoader::Sprite *sprite, uint8 file_slot,
 	return true;
 }
 
+/** The sprites the threads of SpriteLoaderPNG::LoadSprites load. */
+struct PNGSpriteQueue {
+	PNGSpriteJob *jobs; ///< The sprites.
+	uint count;         ///< The number of sprites.
+	uint next;          ///< The next sprite a thread takes.
+	ThreadMutex *mutex; ///< The mutex for #next and for opening files.
+};
+
+/**
+ * Load the sprites in a queue until there are none left.
+ * @param data the PNGSpriteQueue
+ */
+static void LoadPNGSpritesThread(void *data)
+{
+	PNGSpriteQueue *queue = (PNGSpriteQueue *)data;
+
+	for (;;) {
+		queue->mutex->BeginCritical();
+		uint i = queue->next++;
+		queue->mutex->EndCritical();
+
+		if (i >= queue->count) return;
+
+		PNGSpriteJob *job = &queue->jobs[i];
+		job->ok = LoadPNG(&job->sprite, job->filename, job->id, false, &job->buffer, queue->mutex) &&
+				LoadPNG(&job->sprite, job->filename, job->id, true, &job->buffer, queue->mutex);
+	}
+}
+
+/**
+ * Load a number of sprites at once, with a few threads.
+ * @param jobs  the sprites to load; each gets the memory for its pixels from its own buffer
+ * @param count the number of sprites
+ */
+/* static */ void SpriteLoaderPNG::LoadSprites(PNGSpriteJob *jobs, uint count)
+{
+	PNGSpriteQueue queue;
+	queue.jobs = jobs;
+	queue.count = count;
+	queue.next = 0;
+	queue.mutex = ThreadMutex::New();
+
+	ThreadObject *threads[PNG_LOAD_THREADS - 1];
+	uint num_threads = 0;
+	while (num_threads < lengthof(threads) && num_threads + 1 < count && ThreadObject::New(&LoadPNGSpritesThread, &queue, &threads[num_threads])) num_threads++;
+
+	LoadPNGSpritesThread(&queue);
+
+	for (uint i = 0; i < num_threads; i++) {
+		threads[i]->Join();
+		delete threads[i];
+	}
+	delete queue.mutex;
+}
+
 #endif /* WITH_PNG */
@@ -14,12 +14,23 @@
 
 #include "spriteloader.hpp"
 
+/** A sprite for SpriteLoaderPNG::LoadSprites to load. */
+struct PNGSpriteJob {
+	const char *filename;                             ///< The name of the file the sprite belongs to.
+	uint32 id;                                        ///< The number of the sprite in that file.
+	SpriteLoader::Sprite sprite;                      ///< The loaded sprite.
+	ReusableBuffer<SpriteLoader::CommonPixel> buffer; ///< The memory for the pixels of the loaded sprite.
+	bool ok;                                          ///< Whether the sprite could be loaded.
+};
+
 class SpriteLoaderPNG : public SpriteLoader {
 public:
 	/**
 	 * Load a sprite from the disk and return a sprite struct which is the same for all loaders.
 	 */
 	bool LoadSprite(SpriteLoader::Sprite *sprite, uint8 file_slot, size_t file_pos, SpriteType sprite_type);
+
+	static void LoadSprites(PNGSpriteJob *jobs, uint count);
 };
 
 #endif /* SPRITELOADER_PNG_HPP */
@@ -41,8 +41,9 @@ public:
 		/**
 		 * Allocate the sprite data of this sprite.
 		 * @param size the minimum size of the data field.
+		 * @param own_buffer the memory to use instead of the memory shared by all sprites, e.g. when loading sprites in threads.
 		 */
-		void AllocateData(size_t size) { this->data = Sprite::buffer.ZeroAllocate(size); }
+		void AllocateData(size_t size, ReusableBuffer<SpriteLoader::CommonPixel> *own_buffer = NULL) { this->data = (own_buffer != NULL ? own_buffer : &Sprite::buffer)->ZeroAllocate(size); }
 	private:
 		/** Allocated memory to pass sprite data around */
 		static ReusableBuffer<SpriteLoader::CommonPixel> buffer;
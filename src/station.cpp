@@ -20,11 +20,14 @@
 #include "news_func.h"
 #include "aircraft.h"
 #include "vehicle_gui.h"
+#include "station_gui.h"
 #include "core/pool_func.hpp"
 #include "station_base.h"
 #include "roadstop_base.h"
 #include "industry.h"
 #include "core/random_func.hpp"
+#include "station_func.h"
+#include "viewport_func.h"
 
 #include "table/strings.h"
 
@@ -46,6 +49,7 @@ BaseStation::~BaseStation()
 	DeleteWindowById(WC_SHIPS_LIST, wno | (VEH_SHIP << 11));
 	DeleteWindowById(WC_AIRCRAFT_LIST, wno | (VEH_AIRCRAFT << 11));
 
+	RemoveViewportSignFromIndex(VSK_STATION, this->index, &this->sign);
 	this->sign.MarkDirty();
 }
 
@@ -57,9 +61,13 @@ Station::Station(TileIndex tile) :
 	indtype(IT_INVALID),
 	time_since_load(255),
 	time_since_unload(255),
-	last_vehicle_type(VEH_INVALID)
+	last_vehicle_type(VEH_INVALID),
+	catchment_area(INVALID_TILE, 0, 0)
 {
 	/* this->random_bits is set in Station::AddFacility() */
+
+	/* Stations that are loaded get their phase from the savegame. */
+	if (tile != INVALID_TILE) this->delete_ctr = GetQuietestStationRatingPhase(this->index);
 }
 
 /**
@@ -90,7 +98,7 @@ Station::~Station()
 		}
 	}
 
-	InvalidateWindowData(WC_STATION_LIST, this->owner, 0);
+	InvalidateStationListOfStation(this->owner, this->index, true);
 
 	DeleteWindowById(WC_STATION_VIEW, index);
 
@@ -260,6 +268,44 @@ Rect Station::GetCatchmentRect() const
 	return ret;
 }
 
+/**
+ * Record that cargo arrived at this station. Only the sources most cargo
+ * arrived from lately are kept.
+ * @param from the station the cargo was first loaded at
+ * @param cargo the cargo type
+ * @param amount the amount of cargo
+ */
+void Station::RecordFlowLink(StationID from, CargoID cargo, uint amount)
+{
+	if (from == INVALID_STATION || amount == 0) return;
+
+	/* Find the link, or else the least used one to replace. */
+	CargoFlowLink *replace = &this->flow_links[0];
+	for (CargoFlowLink *l = this->flow_links; l != endof(this->flow_links); l++) {
+		if (l->from == from && l->cargo == cargo) {
+			l->current += amount;
+			return;
+		}
+		if (l->current + l->last < replace->current + replace->last) replace = l;
+	}
+
+	replace->from    = from;
+	replace->cargo   = cargo;
+	replace->current = amount;
+	replace->last    = 0;
+}
+
+/** Start a new month for the cargo flow statistics of this station. */
+void Station::NewFlowMonth()
+{
+	for (CargoID c = 0; c < NUM_CARGO; c++) this->goods[c].flow.NewMonth();
+
+	for (CargoFlowLink *l = this->flow_links; l != endof(this->flow_links); l++) {
+		l->last = l->current;
+		l->current = 0;
+	}
+}
+
 /** Rect and pointer to IndustryVector */
 struct RectAndIndustryVector {
 	Rect rect;
@@ -309,6 +355,8 @@ static bool FindIndustryToDeliver(TileIndex ind_tile, void *user_data)
 void Station::RecomputeIndustriesNear()
 {
 	this->industries_near.Clear();
+	this->industries_near_accepts.Clear();
+	this->industries_near_cargo = 0;
 	if (this->rect.IsEmpty()) return;
 
 	RectAndIndustryVector riv = {
@@ -324,6 +372,16 @@ void Station::RecomputeIndustriesNear()
 	);
 
 	CircularTileSearch(&start_tile, 2 * max_radius + 1, &FindIndustryToDeliver, &riv);
+
+	/* Remember which cargo types each of the industries accepts */
+	for (const Industry * const *ip = this->industries_near.Begin(); ip != this->industries_near.End(); ip++) {
+		uint32 accepts = 0;
+		for (uint j = 0; j < lengthof((*ip)->accepts_cargo); j++) {
+			if ((*ip)->accepts_cargo[j] != CT_INVALID) SetBit(accepts, (*ip)->accepts_cargo[j]);
+		}
+		*this->industries_near_accepts.Append() = accepts;
+		this->industries_near_cargo |= accepts;
+	}
 }
 
 /**
@@ -508,6 +566,18 @@ StationRect& StationRect::operator = (const Rect &src)
 	return *this;
 }
 
+/**
+ * Tell the station list of a company that only a single station has been
+ * added, has changed or is about to be removed, so it only has to move that
+ * station instead of rebuilding and resorting all of its stations.
+ * @param owner The owner of the station.
+ * @param station The station that changed.
+ * @param removed Whether the station is about to be removed.
+ */
+void InvalidateStationListOfStation(Owner owner, StationID station, bool removed)
+{
+	InvalidateWindowData(WC_STATION_LIST, owner, (station << 16) | (1 << (removed ? SLI_STATION_REMOVED : SLI_STATION_CHANGED)));
+}
 
 void InitializeStations()
 {
@@ -17,12 +17,68 @@
 #include "newgrf_airport.h"
 #include "cargopacket.h"
 #include "industry_type.h"
+#include <list>
 
 typedef Pool<BaseStation, StationID, 32, 64000> StationPool;
 extern StationPool _station_pool;
 
 static const byte INITIAL_STATION_RATING = 175;
 
+/** Amounts of cargo that went through a goods entry in one month. */
+struct CargoFlowMonth {
+	uint32 loaded;      ///< Cargo loaded into vehicles
+	uint32 delivered;   ///< Cargo delivered to its final destination
+	uint32 transferred; ///< Cargo unloaded to wait at the station, by transfer or forced unload
+};
+
+/** The amounts of cargo that went through a goods entry during the last months. */
+struct CargoFlowStats {
+	static const uint NUM_MONTHS = 4; ///< Number of months that are kept, including the current one
+
+	CargoFlowMonth months[NUM_MONTHS]; ///< Ring buffer with the amounts per month
+	byte current;                      ///< The entry of the current month
+
+	CargoFlowStats() : current(0)
+	{
+		memset(this->months, 0, sizeof(this->months));
+	}
+
+	/**
+	 * Get the amounts of the current month, to update them.
+	 * @return the amounts of the current month.
+	 */
+	FORCEINLINE CargoFlowMonth &Current()
+	{
+		return this->months[this->current];
+	}
+
+	/**
+	 * Get the amounts of a month.
+	 * @param age how many months ago; 0 is the current month.
+	 * @return the amounts of that month.
+	 */
+	FORCEINLINE const CargoFlowMonth &Get(uint age) const
+	{
+		assert(age < NUM_MONTHS);
+		return this->months[(this->current + NUM_MONTHS - age) % NUM_MONTHS];
+	}
+
+	/** Start a new month, forgetting the oldest one. */
+	FORCEINLINE void NewMonth()
+	{
+		this->current = (this->current + 1) % NUM_MONTHS;
+		memset(&this->months[this->current], 0, sizeof(this->months[this->current]));
+	}
+};
+
+/** Amount of cargo that arrived at a station from a source station. */
+struct CargoFlowLink {
+	StationID from;    ///< The station the cargo was first loaded at
+	CargoID cargo;     ///< The cargo type
+	uint32 current;    ///< Amount that arrived this month
+	uint32 last;       ///< Amount that arrived last month
+};
+
 struct GoodsEntry {
 	enum AcceptancePickup {
 		ACCEPTANCE,
@@ -43,6 +99,7 @@ struct GoodsEntry {
 	byte last_speed;
 	byte last_age;
 	StationCargoList cargo; ///< The cargo packets of cargo waiting in this station
+	CargoFlowStats flow;    ///< NOSAVE: The amounts of cargo that went through this station
 };
 
 /** All airport-related information. Only valid if tile != INVALID_TILE. */
@@ -137,7 +194,18 @@ public:
 	GoodsEntry goods[NUM_CARGO];  ///< Goods at this station
 	uint32 always_accepted;       ///< Bitmask of always accepted cargo types (by houses, HQs, industry tiles when industry doesn't accept cargo)
 
+	static const uint NUM_FLOW_LINKS = 8;         ///< Number of source stations the flow is kept of
+	CargoFlowLink flow_links[NUM_FLOW_LINKS];     ///< NOSAVE: The source stations most cargo arrived from lately
+
 	IndustryVector industries_near; ///< Cached list of industries near the station that can accept cargo, @see DeliverGoodsToIndustry()
+	SmallVector<uint32, 2> industries_near_accepts; ///< Cached bitmask of the cargo types accepted by each of the industries_near
+	uint32 industries_near_cargo;   ///< Cached bitmask of the cargo types accepted by any of the industries_near
+
+	TileArea catchment_area;                      ///< Area the catchment cache has been made for, tile is INVALID_TILE when not made yet
+	uint32 catchment_stamp;                       ///< Catchment change counter at the time the catchment cache has been made
+	CargoArray catchment_acceptance;              ///< Cached acceptance of the tiles in the catchment area that do not use callbacks
+	uint32 catchment_always_accepted;             ///< Cached always accepted cargo of the tiles in the catchment area that do not use callbacks
+	SmallVector<TileIndex, 4> catchment_callbacks; ///< Tiles in the catchment area whose acceptance is determined by callbacks
 
 	Station(TileIndex tile = INVALID_TILE);
 	~Station();
@@ -155,6 +223,9 @@ public:
 
 	/* virtual */ uint GetPlatformLength(TileIndex tile, DiagDirection dir) const;
 	/* virtual */ uint GetPlatformLength(TileIndex tile) const;
+	void RecordFlowLink(StationID from, CargoID cargo, uint amount);
+	void NewFlowMonth();
+
 	void RecomputeIndustriesNear();
 	static void RecomputeIndustriesNearForAll();
 
@@ -417,7 +417,9 @@ void Station::UpdateVirtCoord()
 
 	SetDParam(0, this->index);
 	SetDParam(1, this->facilities);
+	RemoveViewportSignFromIndex(VSK_STATION, this->index, &this->sign);
 	this->sign.UpdatePosition(pt.x, pt.y, STR_VIEWPORT_STATION);
+	AddViewportSignToIndex(VSK_STATION, this->index, &this->sign);
 
 	SetWindowDirty(WC_STATION_VIEW, this->index);
 }
@@ -549,6 +551,129 @@ CargoArray GetAcceptanceAroundTiles(TileIndex tile, int w, int h, int rad, uint3
 	return acceptance;
 }
 
+/** Number of bits of the size of the blocks the catchment changes are tracked in. */
+static const uint CATCHMENT_BLOCK_BITS = 4;
+
+static uint32 _catchment_stamp = 0;          ///< Counter increased for every change of the acceptance of a tile.
+static uint32 *_catchment_block_stamps = NULL; ///< Per block of tiles the value of #_catchment_stamp at its last change.
+static uint _catchment_blocks_x = 0;         ///< Number of blocks in the x direction.
+static uint _catchment_blocks_size = 0;      ///< Number of blocks in #_catchment_block_stamps.
+
+/** (Re)allocate the block stamps when the map size changed. */
+static void AllocateCatchmentBlocks()
+{
+	uint size = MapSize() >> (2 * CATCHMENT_BLOCK_BITS);
+	if (size == _catchment_blocks_size) return;
+
+	free(_catchment_block_stamps);
+	_catchment_block_stamps = CallocT<uint32>(size);
+	_catchment_blocks_x = MapSizeX() >> CATCHMENT_BLOCK_BITS;
+	_catchment_blocks_size = size;
+}
+
+/**
+ * Tell the station catchment caches the acceptance of a tile may have
+ * changed, e.g. because a house or industry tile was built or removed.
+ * @param tile the changed tile
+ */
+void MarkCatchmentTileChanged(TileIndex tile)
+{
+	AllocateCatchmentBlocks();
+	uint block = (TileY(tile) >> CATCHMENT_BLOCK_BITS) * _catchment_blocks_x + (TileX(tile) >> CATCHMENT_BLOCK_BITS);
+	_catchment_block_stamps[block] = ++_catchment_stamp;
+}
+
+/** Make all station catchment caches invalid, e.g. because the NewGRFs have been reloaded. */
+void InvalidateAllCatchmentCaches()
+{
+	Station *st;
+	FOR_ALL_STATIONS(st) st->catchment_area.tile = INVALID_TILE;
+}
+
+/**
+ * Check whether a tile its acceptance is determined by a callback,
+ * i.e. whether it can change without the tile itself being changed.
+ * @param tile the tile to check
+ * @return true if the acceptance cannot be cached
+ */
+static bool AcceptanceUsesCallback(TileIndex tile)
+{
+	switch (GetTileType(tile)) {
+		case MP_HOUSE:
+			return (HouseSpec::Get(GetHouseType(tile))->callback_mask & ((1 << CBM_HOUSE_ACCEPT_CARGO) | (1 << CBM_HOUSE_CARGO_ACCEPTANCE))) != 0;
+
+		case MP_INDUSTRY:
+			return (GetIndustryTileSpec(GetIndustryGfx(tile))->callback_mask & ((1 << CBM_INDT_ACCEPT_CARGO) | (1 << CBM_INDT_CARGO_ACCEPTANCE))) != 0;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Check whether the catchment cache of a station is still valid for an area.
+ * @param st the station to check
+ * @param ta the catchment area of the station
+ * @return true if none of the tiles in the area changed since making the cache
+ */
+static bool IsCatchmentCacheValid(const Station *st, const TileArea &ta)
+{
+	if (st->catchment_area.tile != ta.tile || st->catchment_area.w != ta.w || st->catchment_area.h != ta.h) return false;
+
+	AllocateCatchmentBlocks();
+	uint x1 = TileX(ta.tile) >> CATCHMENT_BLOCK_BITS;
+	uint y1 = TileY(ta.tile) >> CATCHMENT_BLOCK_BITS;
+	uint x2 = (TileX(ta.tile) + ta.w - 1) >> CATCHMENT_BLOCK_BITS;
+	uint y2 = (TileY(ta.tile) + ta.h - 1) >> CATCHMENT_BLOCK_BITS;
+
+	for (uint y = y1; y <= y2; y++) {
+		for (uint x = x1; x <= x2; x++) {
+			if (_catchment_block_stamps[y * _catchment_blocks_x + x] > st->catchment_stamp) return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Get the acceptance of the catchment area of a station, using and
+ * updating its catchment cache. Only the tiles whose acceptance uses
+ * callbacks are asked for their acceptance each time.
+ * @param st the station to get the acceptance of
+ * @return the acceptance in 1/8
+ * @pre !st->rect.IsEmpty()
+ */
+static CargoArray GetStationCatchmentAcceptance(Station *st)
+{
+	int rad = st->GetCatchmentRadius();
+	TileArea ta(
+		TileXY(max<int>(st->rect.left - rad, 0), max<int>(st->rect.top - rad, 0)),
+		TileXY(min<int>(st->rect.right + rad, MapMaxX()), min<int>(st->rect.bottom + rad, MapMaxY()))
+	);
+
+	if (!IsCatchmentCacheValid(st, ta)) {
+		st->catchment_area = ta;
+		st->catchment_stamp = _catchment_stamp;
+		st->catchment_acceptance.Clear();
+		st->catchment_always_accepted = 0;
+		st->catchment_callbacks.Clear();
+
+		TILE_AREA_LOOP(tile, ta) {
+			if (AcceptanceUsesCallback(tile)) {
+				*st->catchment_callbacks.Append() = tile;
+			} else {
+				AddAcceptedCargo(tile, st->catchment_acceptance, &st->catchment_always_accepted);
+			}
+		}
+	}
+
+	CargoArray acceptance = st->catchment_acceptance;
+	st->always_accepted = st->catchment_always_accepted;
+	for (const TileIndex *tile = st->catchment_callbacks.Begin(); tile != st->catchment_callbacks.End(); tile++) {
+		AddAcceptedCargo(*tile, acceptance, &st->always_accepted);
+	}
+	return acceptance;
+}
+
 /** Update the acceptance for a station.
  * @param st Station to update
  * @param show_msg controls whether to display a message that acceptance was changed.
@@ -560,15 +685,7 @@ void UpdateStationAcceptance(Station *st, bool show_msg)
 
 	/* And retrieve the acceptance. */
 	CargoArray acceptance;
-	if (!st->rect.IsEmpty()) {
-		acceptance = GetAcceptanceAroundTiles(
-			TileXY(st->rect.left, st->rect.top),
-			st->rect.right  - st->rect.left + 1,
-			st->rect.bottom - st->rect.top  + 1,
-			st->GetCatchmentRadius(),
-			&st->always_accepted
-		);
-	}
+	if (!st->rect.IsEmpty()) acceptance = GetStationCatchmentAcceptance(st);
 
 	/* Adjust in case our station only accepts fewer kinds of goods */
 	for (CargoID i = 0; i < NUM_CARGO; i++) {
@@ -651,7 +768,7 @@ static void DeleteStationIfEmpty(BaseStation *st)
 {
 	if (!st->IsInUse()) {
 		st->delete_ctr = 0;
-		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
+		InvalidateStationListOfStation(st->owner, st->index);
 	}
 	/* station remains but it probably lost some parts - station sign should stay in the station boundaries */
 	UpdateStationSignCoord(st);
@@ -1269,16 +1386,17 @@ CommandCost CmdBuildRailStation(TileIndex tile_org, DoCommandFlag flags, uint32
 					StationAnimationTrigger(st, tile, STAT_ANIM_BUILT);
 				}
 
+				YapfNotifyTrackLayoutChange(tile, track);
 				tile += tile_delta;
 			} while (--w);
 			AddTrackToSignalBuffer(tile_org, track, _current_company);
-			YapfNotifyTrackLayoutChange(tile_org, track);
 			tile_org += tile_delta ^ TileDiffXY(1, 1); // perpendicular to tile_delta
 		} while (--numtracks);
 
 		for (uint i = 0; i < affected_vehicles.Length(); ++i) {
 			/* Restore reservations of trains. */
 			Train *v = affected_vehicles[i];
+			ReservationOwnerScope owner(v->index);
 			if (IsRailStationTile(v->tile)) SetRailStationPlatformReservation(v->tile, TrackdirToExitdir(v->GetVehicleTrackdir()), true);
 			TryPathReserve(v, true, true);
 			for (; v->Next() != NULL; v = v->Next()) { }
@@ -1290,7 +1408,7 @@ CommandCost CmdBuildRailStation(TileIndex tile_org, DoCommandFlag flags, uint32
 		UpdateStationAcceptance(st, false);
 		st->RecomputeIndustriesNear();
 		InvalidateWindowData(WC_SELECT_STATION, 0, 0);
-		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
+		InvalidateStationListOfStation(st->owner, st->index);
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, SVW_TRAINS);
 	}
 
@@ -1426,6 +1544,7 @@ CommandCost RemoveFromRailBaseStation(TileArea ta, SmallVector<T *, 4> &affected
 
 			if (v != NULL) {
 				/* Restore station reservation. */
+				ReservationOwnerScope owner(v->index);
 				if (IsRailStationTile(v->tile)) SetRailStationPlatformReservation(v->tile, TrackdirToExitdir(v->GetVehicleTrackdir()), true);
 				TryPathReserve(v, true, true);
 				for (; v->Next() != NULL; v = v->Next()) { }
@@ -1796,7 +1915,7 @@ CommandCost CmdBuildRoadStop(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 		UpdateStationAcceptance(st, false);
 		st->RecomputeIndustriesNear();
 		InvalidateWindowData(WC_SELECT_STATION, 0, 0);
-		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
+		InvalidateStationListOfStation(st->owner, st->index);
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, SVW_ROADVEHS);
 	}
 	return cost;
@@ -2221,7 +2340,7 @@ CommandCost CmdBuildAirport(TileIndex tile, DoCommandFlag flags, uint32 p1, uint
 		UpdateStationAcceptance(st, false);
 		st->RecomputeIndustriesNear();
 		InvalidateWindowData(WC_SELECT_STATION, 0, 0);
-		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
+		InvalidateStationListOfStation(st->owner, st->index);
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, SVW_PLANES);
 
 		if (_settings_game.economy.station_noise_level) {
@@ -2442,7 +2561,7 @@ CommandCost CmdBuildDock(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 		UpdateStationAcceptance(st, false);
 		st->RecomputeIndustriesNear();
 		InvalidateWindowData(WC_SELECT_STATION, 0, 0);
-		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
+		InvalidateStationListOfStation(st->owner, st->index);
 		SetWindowWidgetDirty(WC_STATION_VIEW, st->index, SVW_SHIPS);
 	}
 
@@ -3103,41 +3222,100 @@ static void UpdateStationRating(Station *st)
 	}
 }
 
-/* called for every station each tick */
-static void StationHandleSmallTick(BaseStation *st)
+/**
+ * Called for every station each tick.
+ * @param st the station to handle
+ * @return true if the rating of the station has been updated
+ */
+static bool StationHandleSmallTick(BaseStation *st)
 {
-	if ((st->facilities & FACIL_WAYPOINT) != 0 || !st->IsInUse()) return;
+	if ((st->facilities & FACIL_WAYPOINT) != 0 || !st->IsInUse()) return false;
 
 	byte b = st->delete_ctr + 1;
 	if (b >= 185) b = 0;
 	st->delete_ctr = b;
 
-	if (b == 0) UpdateStationRating(Station::From(st));
+	if (b != 0) return false;
+
+	UpdateStationRating(Station::From(st));
+	return true;
+}
+
+/**
+ * Find the phase of the rating updates that the fewest stations use, so
+ * new stations do not all update their ratings in the same tick.
+ * @param skip the station that is being built
+ * @return the value of Station::delete_ctr to use for the new station
+ */
+byte GetQuietestStationRatingPhase(StationID skip)
+{
+	/* The number of stations that update their rating in that many ticks. */
+	uint counts[185];
+	memset(counts, 0, sizeof(counts));
+
+	const Station *st;
+	FOR_ALL_STATIONS(st) {
+		if (st->index == skip || !st->IsInUse() || st->delete_ctr >= 185) continue;
+		counts[184 - st->delete_ctr]++;
+	}
+
+	/* Prefer the phase a station would get without this. */
+	uint best = 184;
+	for (uint t = 184; t-- > 0;) {
+		if (counts[t] < counts[best]) best = t;
+	}
+	return 184 - best;
 }
 
 void OnTick_Station()
 {
 	if (_game_mode == GM_EDITOR) return;
 
+	/* The work done for the stations during the current 250 ticks. */
+	static uint work_total = 0;
+	static uint work_max = 0;
+	uint work = 0;
+
+	uint position = 0;
 	BaseStation *st;
 	FOR_ALL_BASE_STATIONS(st) {
-		StationHandleSmallTick(st);
+		if (StationHandleSmallTick(st)) work++;
 
 		/* Run 250 tick interval trigger for station animation.
-		 * Station index is included so that triggers are not all done
-		 * at the same time. */
-		if ((_tick_counter + st->index) % 250 == 0) {
+		 * The position of the station in the pool is included so that
+		 * triggers are spread evenly over the ticks, even when the
+		 * station indices are not. */
+		if ((_tick_counter + position++) % 250 == 0) {
+			work++;
 			/* Stop processing this station if it was deleted */
 			if (!StationHandleBigTick(st)) continue;
 			StationAnimationTrigger(st, st->xy, STAT_ANIM_250_TICKS);
 			if (Station::IsExpected(st)) AirportAnimationTrigger(Station::From(st), AAT_STATION_250_ticks);
 		}
 	}
+
+	work_total += work;
+	work_max = max(work_max, work);
+	if (_tick_counter % 250 == 0) {
+		DEBUG(misc, 4, "[station] %u stations: %u rating updates and big ticks in 250 ticks, at most %u in one tick", position, work_total, work_max);
+		work_total = 0;
+		work_max = 0;
+	}
 }
 
 void StationMonthlyLoop()
 {
-	/* not used */
+	Station *st;
+	FOR_ALL_STATIONS(st) {
+		st->NewFlowMonth();
+
+		/* Merge the cargo that waits at the stations into fewer packets. */
+		if (_settings_game.economy.cargo_merge_days == 0) continue;
+
+		for (CargoID c = 0; c < NUM_CARGO; c++) {
+			st->goods[c].cargo.Compact(_settings_game.economy.cargo_merge_days);
+		}
+	}
 }
 
 
@@ -3210,7 +3388,7 @@ CommandCost CmdRenameStation(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 		st->name = reset ? NULL : strdup(text);
 
 		st->UpdateVirtCoord();
-		InvalidateWindowData(WC_STATION_LIST, st->owner, 1);
+		InvalidateStationListOfStation(st->owner, st->index);
 	}
 
 	return CommandCost();
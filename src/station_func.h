@@ -30,6 +30,9 @@ CargoArray GetProductionAroundTiles(TileIndex tile, int w, int h, int rad);
 CargoArray GetAcceptanceAroundTiles(TileIndex tile, int w, int h, int rad, uint32 *always_accepted = NULL);
 
 void UpdateStationAcceptance(Station *st, bool show_msg);
+byte GetQuietestStationRatingPhase(StationID skip);
+void MarkCatchmentTileChanged(TileIndex tile);
+void InvalidateAllCatchmentCaches();
 
 const DrawTileSprites *GetStationTileLayout(StationType st, byte gfx);
 void StationPickerDrawSprite(int x, int y, StationType st, RailType railtype, RoadType roadtype, int image);
@@ -49,4 +52,6 @@ bool IsStationTileElectrifiable(TileIndex tile);
 
 void UpdateAirportsNoise();
 
+void InvalidateStationListOfStation(Owner owner, StationID station, bool removed = false);
+
 #endif /* STATION_FUNC_H */
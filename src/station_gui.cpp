@@ -210,7 +210,7 @@ protected:
 	static bool include_empty;            // whether we should include stations without waiting cargo
 	static const uint32 cargo_filter_max;
 	static uint32 cargo_filter;           // bitmap of cargo types to include
-	static const Station *last_station;
+	static NameCache station_names;
 
 	/* Constants for sorting stations */
 	static const StringID sorter_names[];
@@ -219,6 +219,29 @@ protected:
 	GUIStationList stations;
 
 
+	/**
+	 * Check whether a station passes the filters of the list
+	 *
+	 * @param st the station to check
+	 * @param owner company whose stations are in the list
+	 * @return true if the station belongs in the list
+	 */
+	bool IsStationInList(const Station *st, const Owner owner) const
+	{
+		if (st->owner != owner && (st->owner != OWNER_NONE || !HasStationInUse(st->index, owner))) return false;
+		if (!(this->facilities & st->facilities)) return false; // only stations with selected facilities
+
+		int num_waiting_cargo = 0;
+		for (CargoID j = 0; j < NUM_CARGO; j++) {
+			if (!st->goods[j].cargo.Empty()) {
+				num_waiting_cargo++; // count number of waiting cargo
+				if (HasBit(this->cargo_filter, j)) return true;
+			}
+		}
+		/* stations without waiting cargo */
+		return num_waiting_cargo == 0 && this->include_empty;
+	}
+
 	/**
 	 * (Re)Build station list
 	 *
@@ -234,24 +257,7 @@ protected:
 
 		const Station *st;
 		FOR_ALL_STATIONS(st) {
-			if (st->owner == owner || (st->owner == OWNER_NONE && HasStationInUse(st->index, owner))) {
-				if (this->facilities & st->facilities) { // only stations with selected facilities
-					int num_waiting_cargo = 0;
-					for (CargoID j = 0; j < NUM_CARGO; j++) {
-						if (!st->goods[j].cargo.Empty()) {
-							num_waiting_cargo++; // count number of waiting cargo
-							if (HasBit(this->cargo_filter, j)) {
-								*this->stations.Append() = st;
-								break;
-							}
-						}
-					}
-					/* stations without waiting cargo */
-					if (num_waiting_cargo == 0 && this->include_empty) {
-						*this->stations.Append() = st;
-					}
-				}
-			}
+			if (this->IsStationInList(st, owner)) *this->stations.Append() = st;
 		}
 
 		this->stations.Compact();
@@ -263,19 +269,7 @@ protected:
 	/** Sort stations by their name */
 	static int CDECL StationNameSorter(const Station * const *a, const Station * const *b)
 	{
-		static char buf_cache[64];
-		char buf[64];
-
-		SetDParam(0, (*a)->index);
-		GetString(buf, STR_STATION_NAME, lastof(buf));
-
-		if (*b != last_station) {
-			last_station = *b;
-			SetDParam(0, (*b)->index);
-			GetString(buf_cache, STR_STATION_NAME, lastof(buf_cache));
-		}
-
-		return strcmp(buf, buf_cache);
+		return strcmp(station_names.Get((*a)->index), station_names.Get((*b)->index));
 	}
 
 	/** Sort stations by their type */
@@ -334,12 +328,40 @@ protected:
 		if (!this->stations.Sort()) return;
 
 		/* Reset name sorter sort cache */
-		this->last_station = NULL;
+		this->station_names.Clear();
 
 		/* Set the modified widget dirty */
 		this->SetWidgetDirty(SLW_LIST);
 	}
 
+	/**
+	 * Apply the change of a single station to the list, instead
+	 * of rebuilding and resorting the whole list.
+	 *
+	 * @param station the station that has been added or changed, or that is about to be removed
+	 * @param removed whether the station is about to be removed
+	 */
+	void UpdateStationInList(StationID station, bool removed)
+	{
+		/* The list is going to be built from scratch anyway. */
+		if (this->stations.NeedRebuild()) return;
+
+		/* Waypoints never are in the list. */
+		const BaseStation *bst = BaseStation::GetIfValid(station);
+		if (bst == NULL || !Station::IsExpected(bst)) return;
+
+		const Station *st = Station::From(bst);
+		if (removed || !this->IsStationInList(st, (Owner)this->window_number)) {
+			if (!this->stations.RemoveItem(st)) return;
+		} else {
+			this->stations.SortItem(st);
+			/* Reset name sorter sort cache, the station may be renamed later on */
+			this->station_names.Clear();
+		}
+
+		this->vscroll.SetCount(this->stations.Length());
+	}
+
 public:
 	CompanyStationsWindow(const WindowDesc *desc, WindowNumber window_number) : Window()
 	{
@@ -692,7 +714,9 @@ public:
 
 	virtual void OnInvalidateData(int data)
 	{
-		if (data == 0) {
+		if (HasBit(data, SLI_STATION_CHANGED) || HasBit(data, SLI_STATION_REMOVED)) {
+			this->UpdateStationInList(GB(data, 16, 16), HasBit(data, SLI_STATION_REMOVED));
+		} else if (data == 0) {
 			this->stations.ForceRebuild();
 		} else {
 			this->stations.ForceResort();
@@ -705,7 +729,7 @@ byte CompanyStationsWindow::facilities = FACIL_TRAIN | FACIL_TRUCK_STOP | FACIL_
 bool CompanyStationsWindow::include_empty = true;
 const uint32 CompanyStationsWindow::cargo_filter_max = UINT32_MAX;
 uint32 CompanyStationsWindow::cargo_filter = UINT32_MAX;
-const Station *CompanyStationsWindow::last_station = NULL;
+NameCache CompanyStationsWindow::station_names(STR_STATION_NAME);
 
 /* Availible station sorting functions */
 GUIStationList::SortFunction * const CompanyStationsWindow::sorter_funcs[] = {
@@ -1131,6 +1155,15 @@ struct StationViewWindow : public Window {
 			SetDParam(1, STR_CARGO_RATING_APPALLING + (ge->rating >> 5));
 			DrawString(r.left + WD_FRAMERECT_LEFT + 6, r.right - WD_FRAMERECT_RIGHT - 6, y, STR_STATION_VIEW_CARGO_RATING);
 			y += FONT_HEIGHT_NORMAL;
+
+			const CargoFlowMonth &flow = ge->flow.Get(1);
+			if (flow.loaded == 0 && flow.delivered == 0 && flow.transferred == 0) continue;
+
+			SetDParam(0, flow.loaded);
+			SetDParam(1, flow.delivered);
+			SetDParam(2, flow.transferred);
+			DrawString(r.left + WD_FRAMERECT_LEFT + 12, r.right - WD_FRAMERECT_RIGHT - 6, y, STR_STATION_VIEW_CARGO_FLOW);
+			y += FONT_HEIGHT_NORMAL;
 		}
 		return CeilDiv(y - r.top - WD_FRAMERECT_TOP, FONT_HEIGHT_NORMAL);
 	}
@@ -33,6 +33,15 @@ enum StationViewWidgets {
 	SVW_PLANES,          ///< List of scheduled planes button
 };
 
+/**
+ * Bits in the data of station list invalidations. When one of these is set
+ * the upper 16 bits hold the index of the station the invalidation is about.
+ */
+enum StationListInvalidationBits {
+	SLI_STATION_REMOVED = 13, ///< Only this station is about to be removed
+	SLI_STATION_CHANGED = 14, ///< Only this station has been added or changed
+};
+
 /** Types of cargo to display for station coverage. */
 enum StationCoverageType {
 	SCT_PASSENGERS_ONLY,     ///< Draw only passenger class cargos.
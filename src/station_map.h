@@ -432,7 +432,10 @@ static inline bool HasStationReservation(TileIndex t)
 static inline void SetRailStationReservation(TileIndex t, bool b)
 {
 	assert(HasStationRail(t));
+	TrackBits track = GetRailStationTrackBits(t);
+	UpdateReservationOwner(t, HasStationReservation(t) ? track : TRACK_BIT_NONE, b ? track : TRACK_BIT_NONE);
 	SB(_m[t].m6, 2, 1, b ? 1 : 0);
+	MarkRailStateChanged(t);
 }
 
 /**
@@ -659,6 +662,7 @@ static inline void MakeBuoy(TileIndex t, StationID sid, WaterClass wc)
 	 * original state when the buoy gets removed. */
 	MakeStation(t, GetTileOwner(t), sid, STATION_BUOY, 0);
 	SetWaterClass(t, wc);
+	YapfNotifyWaterLayoutChange(t);
 }
 
 /**
@@ -674,6 +678,8 @@ static inline void MakeDock(TileIndex t, Owner o, StationID sid, DiagDirection d
 	MakeStation(t, o, sid, STATION_DOCK, d);
 	MakeStation(t + TileOffsByDiagDir(d), o, sid, STATION_DOCK, GFX_DOCK_BASE_WATER_PART + DiagDirToAxis(d));
 	SetWaterClass(t + TileOffsByDiagDir(d), wc);
+	YapfNotifyWaterLayoutChange(t);
+	YapfNotifyWaterLayoutChange(t + TileOffsByDiagDir(d));
 }
 
 /**
@@ -686,6 +692,7 @@ static inline void MakeOilrig(TileIndex t, StationID sid, WaterClass wc)
 {
 	MakeStation(t, OWNER_NONE, sid, STATION_OILRIG, 0);
 	SetWaterClass(t, wc);
+	YapfNotifyWaterLayoutChange(t);
 }
 
 #endif /* STATION_MAP_H */
@@ -954,7 +954,7 @@ static void WriteStringsH(const char *filename)
 	fprintf(_output_file, "\nstatic const StringID STR_LAST_STRINGID = 0x%X;\n\n", next - 1);
 
 	fprintf(_output_file,
-		"static const uint LANGUAGE_PACK_IDENT = 0x474E414C; // Big Endian value for 'LANG' (LE is 0x 4C 41 4E 47)\n"
+		"static const uint LANGUAGE_PACK_IDENT = 0x324E414C; // Big Endian value for 'LAN2' (LE is 0x 4C 41 4E 32)\n"
 		"static const uint LANGUAGE_PACK_VERSION = 0x%X;\n\n", (uint)_hash
 	);
 
@@ -1049,22 +1049,10 @@ static void PutCommandString(const char *str)
 	}
 }
 
-static void WriteLength(FILE *f, uint length)
-{
-	if (length < 0xC0) {
-		fputc(length, f);
-	} else if (length < 0x4000) {
-		fputc((length >> 8) | 0xC0, f);
-		fputc(length & 0xFF, f);
-	} else {
-		error("string too long");
-	}
-}
-
-
 static void WriteLangfile(const char *filename)
 {
 	uint in_use[32];
+	uint num_strings = 0;
 	LanguagePackHeader hdr;
 
 	_output_filename = filename;
@@ -1076,11 +1064,12 @@ static void WriteLangfile(const char *filename)
 		uint n = CountInUse(i);
 
 		in_use[i] = n;
+		num_strings += n;
 		hdr.offsets[i] = TO_LE16(n);
 	}
 
-	/* see line 655: fprintf(..."\tLANGUAGE_PACK_IDENT = 0x474E414C,...) */
-	hdr.ident = TO_LE32(0x474E414C); // Big Endian value for 'LANG'
+	/* see WriteStringsH: "LANGUAGE_PACK_IDENT = 0x324E414C" */
+	hdr.ident = TO_LE32(0x324E414C); // Big Endian value for 'LAN2'
 	hdr.version = TO_LE32(_hash);
 	hdr.plural_form = _lang_pluralform;
 	hdr.text_dir = _lang_textdir;
@@ -1095,15 +1084,23 @@ static void WriteLangfile(const char *filename)
 
 	fwrite(&hdr, sizeof(hdr), 1, _output_file);
 
+	/* The offsets of the strings are only known after writing them, so
+	 * reserve the space for them now and fill them in afterwards. */
+	uint32 *string_offsets = CallocT<uint32>(num_strings);
+	fwrite(string_offsets, sizeof(*string_offsets), num_strings, _output_file);
+	uint32 *string_offset = string_offsets;
+
 	for (int i = 0; i != 32; i++) {
 		for (uint j = 0; j != in_use[i]; j++) {
 			const LangString *ls = _strings[(i << 11) + j];
 			const Case *casep;
 			const char *cmdp;
 
+			*string_offset++ = TO_LE32((uint32)ftell(_output_file));
+
 			/* For undefined strings, just set that it's an empty string */
 			if (ls == NULL) {
-				WriteLength(_output_file, 0);
+				fputc(0, _output_file);
 				continue;
 			}
 
@@ -1166,14 +1163,17 @@ static void WriteLangfile(const char *filename)
 			}
 
 			if (cmdp != NULL) PutCommandString(cmdp);
+			PutByte(0); // terminate with a zero
 
-			WriteLength(_output_file, _put_pos);
 			fwrite(_put_buf, 1, _put_pos, _output_file);
 			_put_pos = 0;
 		}
 	}
 
-	fputc(0, _output_file);
+	fseek(_output_file, sizeof(hdr), SEEK_SET);
+	fwrite(string_offsets, sizeof(*string_offsets), num_strings, _output_file);
+	free(string_offsets);
+
 	fclose(_output_file);
 
 	_output_file = NULL;
@@ -19,7 +19,7 @@ struct LanguagePackHeader {
 	char name[32];      ///< the international name of this language
 	char own_name[32];  ///< the localized name of this language
 	char isocode[16];   ///< the ISO code for the language (not country code)
-	uint16 offsets[32]; ///< the offsets
+	uint16 offsets[32]; ///< the number of strings in each of the 32 tabs
 
 	/** Thousand separator used for anything not currencies */
 	char digit_group_separator[8];
@@ -44,4 +44,11 @@ struct LanguagePackHeader {
 
 assert_compile(sizeof(LanguagePackHeader) % 4 == 0);
 
+/*
+ * The header is followed by the offsets, from the start of the file, of
+ * all strings as little endian 32 bits values, and then by the strings
+ * themselves, each terminated with a zero. This way the file can be used
+ * as it is stored, so it can be mapped into memory read-only.
+ */
+
 #endif /* STRGEN_H */
@@ -50,11 +50,11 @@ static char *GetSpecialNameString(char *buff, int ind, int64 *argv, const char *
 static char *FormatString(char *buff, const char *str, int64 *argv, uint casei, const char *last);
 
 struct LanguagePack : public LanguagePackHeader {
-	char data[]; // list of strings
+	uint32 string_offsets[]; ///< offsets of the strings from the start of the file, followed by the strings themselves
 };
 
-static char **_langpack_offs;
-static LanguagePack *_langpack;
+static const LanguagePack *_langpack; ///< the current language pack, as it is mapped from the file
+static size_t _langpack_len;          ///< size of the current language pack
 static uint _langtab_num[32];   // Offset into langpack offs
 static uint _langtab_start[32]; // Offset into langpack offs
 static bool _keep_gender_data = false;  ///< Should we retain the gender data in the current string?
@@ -90,7 +90,7 @@ const char *GetStringPtr(StringID string)
 		case 28: return GetGRFStringPtr(GB(string, 0, 11));
 		case 29: return GetGRFStringPtr(GB(string, 0, 11) + 0x0800);
 		case 30: return GetGRFStringPtr(GB(string, 0, 11) + 0x1000);
-		default: return _langpack_offs[_langtab_start[string >> 11] + (string & 0x7FF)];
+		default: return (const char *)_langpack + FROM_LE32(_langpack->string_offsets[_langtab_start[string >> 11] + (string & 0x7FF)]);
 	}
 }
 
@@ -192,7 +192,7 @@ static char *FormatNumber(char *buff, int64 number, const char *last, const char
 	uint64 divisor = 10000000000000000000ULL;
 
 	if (number < 0) {
-		buff += seprintf(buff, last, "-");
+		if (buff < last) *buff++ = '-';
 		number = -number;
 	}
 
@@ -205,7 +205,8 @@ static char *FormatNumber(char *buff, int64 number, const char *last, const char
 			num = num % divisor;
 		}
 		if (tot |= quot || i >= zerofill_from) {
-			buff += seprintf(buff, last, "%i", (int)quot);
+			/* The quotient is a single digit; no need for printf to write it. */
+			if (buff < last) *buff++ = '0' + (char)quot;
 			if ((i % 3) == 1 && i != 19) buff = strecpy(buff, separator, last);
 		}
 
@@ -569,7 +570,18 @@ static char *FormatString(char *buff, const char *str, int64 *argv, uint casei,
 	uint modifier = 0;
 	char *buf_start = buff;
 
-	while ((b = Utf8Consume(&str)) != '\0') {
+	for (;;) {
+		/* Plain ASCII text is copied as a whole; only the other characters can be control codes. */
+		const char *run = str;
+		while ((byte)*run - 1U < 0x7F) run++;
+		if (run != str && buff + (run - str) < last) {
+			memcpy(buff, str, run - str);
+			buff += run - str;
+			str = run;
+		}
+
+		if ((b = Utf8Consume(&str)) == '\0') break;
+
 		if (SCC_NEWGRF_FIRST <= b && b <= SCC_NEWGRF_LAST) {
 			/* We need to pass some stuff as it might be modified; oh boy. */
 			b = RemapNewGRFStringControlCode(b, buf_start, &buff, &str, argv);
@@ -1297,67 +1309,50 @@ static inline void SortNetworkLanguages() {}
 
 bool ReadLanguagePack(int lang_index)
 {
-	/* Current language pack */
+	/* Current language pack; the strings are used straight from the mapped file. */
 	size_t len;
-	LanguagePack *lang_pack = (LanguagePack *)ReadFileToMem(_dynlang.ent[lang_index].file, &len, 200000);
+	const LanguagePack *lang_pack = (const LanguagePack *)MapFileToMem(_dynlang.ent[lang_index].file, &len, 400000);
 	if (lang_pack == NULL) return false;
 
-	/* End of read data (+ terminating zero added in ReadFileToMem()) */
-	const char *end = (char *)lang_pack + len + 1;
-
-	/* We need at least one byte of lang_pack->data */
-	if (end <= lang_pack->data ||
+	/* The file has to end with the terminating zero of the last string */
+	if (len <= sizeof(LanguagePackHeader) ||
+			((const char *)lang_pack)[len - 1] != '\0' ||
 			lang_pack->ident != TO_LE32(LANGUAGE_PACK_IDENT) ||
 			lang_pack->version != TO_LE32(LANGUAGE_PACK_VERSION)) {
-		free(lang_pack);
+		UnmapFileFromMem(lang_pack, len);
 		return false;
 	}
 
-#if TTD_ENDIAN == TTD_BIG_ENDIAN
-	for (uint i = 0; i < 32; i++) {
-		lang_pack->offsets[i] = ReadLE16Aligned(&lang_pack->offsets[i]);
-	}
-#endif /* TTD_ENDIAN == TTD_BIG_ENDIAN */
-
+	uint langtab_num[32];
+	uint langtab_start[32];
 	uint count = 0;
 	for (uint i = 0; i < 32; i++) {
-		uint num = lang_pack->offsets[i];
-		_langtab_start[i] = count;
-		_langtab_num[i] = num;
+		uint num = FROM_LE16(lang_pack->offsets[i]);
+		langtab_start[i] = count;
+		langtab_num[i] = num;
 		count += num;
 	}
 
-	/* Allocate offsets */
-	char **langpack_offs = MallocT<char *>(count);
-
-	/* Fill offsets */
-	char *s = lang_pack->data;
-	len = (byte)*s++;
+	/* Make sure all strings start within the file; as the file ends with a
+	 * zero they are then terminated within the file too. */
+	size_t strings_start = sizeof(LanguagePackHeader) + count * sizeof(uint32);
+	if (strings_start >= len) {
+		UnmapFileFromMem(lang_pack, len);
+		return false;
+	}
 	for (uint i = 0; i < count; i++) {
-		if (s + len >= end) {
-			free(lang_pack);
-			free(langpack_offs);
+		uint32 offset = FROM_LE32(lang_pack->string_offsets[i]);
+		if (offset < strings_start || offset >= len) {
+			UnmapFileFromMem(lang_pack, len);
 			return false;
 		}
-		if (len >= 0xC0) {
-			len = ((len & 0x3F) << 8) + (byte)*s++;
-			if (s + len >= end) {
-				free(lang_pack);
-				free(langpack_offs);
-				return false;
-			}
-		}
-		langpack_offs[i] = s;
-		s += len;
-		len = (byte)*s;
-		*s++ = '\0'; // zero terminate the string
 	}
 
-	free(_langpack);
+	UnmapFileFromMem(_langpack, _langpack_len);
 	_langpack = lang_pack;
-
-	free(_langpack_offs);
-	_langpack_offs = langpack_offs;
+	_langpack_len = len;
+	memcpy(_langtab_num, langtab_num, sizeof(_langtab_num));
+	memcpy(_langtab_start, langtab_start, sizeof(_langtab_start));
 
 	const char *c_file = strrchr(_dynlang.ent[lang_index].file, PATHSEPCHAR) + 1;
 	strecpy(_dynlang.curr_file, c_file, lastof(_dynlang.curr_file));
@@ -1412,6 +1407,32 @@ int CDECL StringIDSorter(const StringID *a, const StringID *b)
 	return strcmp(stra, strb);
 }
 
+/**
+ * Get the name of an item, formatting it when it is not cached yet.
+ * @param index Index of the item.
+ * @return The name of the item.
+ */
+const char *NameCache::Get(uint index)
+{
+	while (this->names.Length() <= index) *this->names.Append() = NULL;
+
+	char **name = this->names.Get(index);
+	if (*name == NULL) {
+		char buf[512];
+		SetDParam(0, index);
+		GetString(buf, this->string, lastof(buf));
+		*name = strdup(buf);
+	}
+	return *name;
+}
+
+/** Forget all cached names. */
+void NameCache::Clear()
+{
+	for (char **name = this->names.Begin(); name != this->names.End(); name++) free(*name);
+	this->names.Clear();
+}
+
 /**
  * Checks whether the given language is already found.
  * @param langs    languages we've found so fa
@@ -1589,7 +1610,7 @@ void CheckForMissingGlyphsInLoadedLanguagePack()
 
 		for (uint i = 0; i != 32; i++) {
 			for (uint j = 0; j < _langtab_num[i]; j++) {
-				const char *string = _langpack_offs[_langtab_start[i] + j];
+				const char *string = (const char *)_langpack + FROM_LE32(_langpack->string_offsets[_langtab_start[i] + j]);
 				WChar c;
 				while ((c = Utf8Consume(&string)) != '\0') {
 					if (c == SCC_SETX) {
@@ -13,6 +13,7 @@
 #define STRINGS_FUNC_H
 
 #include "strings_type.h"
+#include "core/smallvec_type.hpp"
 
 char *InlineString(char *buf, StringID string);
 char *GetString(char *buffr, StringID string, const char *last);
@@ -109,6 +110,31 @@ struct StringIDCompare
 	bool operator()(StringID s1, StringID s2) const { return StringIDSorter(&s1, &s2) < 0; }
 };
 
+/**
+ * Names of the items of a list, formatted by item index on first use.
+ * Sorting a list by name then formats every name once, instead of twice per
+ * comparison. Clear the cache after sorting, as names may change afterwards.
+ */
+class NameCache {
+	StringID string;               ///< String showing the name of the item whose index is the first parameter.
+	SmallVector<char *, 16> names; ///< The names by item index; \c NULL if not formatted yet.
+
+public:
+	/**
+	 * Create a cache of names.
+	 * @param string String showing the name of the item whose index is the first parameter.
+	 */
+	NameCache(StringID string) : string(string) {}
+
+	~NameCache()
+	{
+		this->Clear();
+	}
+
+	const char *Get(uint index);
+	void Clear();
+};
+
 void CheckForMissingGlyphsInLoadedLanguagePack();
 
 #endif /* STRINGS_TYPE_H */
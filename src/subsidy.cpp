@@ -139,6 +139,47 @@ void RebuildSubsidisedSourceAndDestinationCache()
 	}
 }
 
+/**
+ * Recompute whether a town or industry is part of a subsidised route, after a subsidy with it is deleted.
+ * @param type is it a town or an industry?
+ * @param index index of town/industry
+ */
+static void UpdatePartOfSubsidyFlags(SourceType type, SourceID index)
+{
+	PartOfSubsidy flags = POS_NONE;
+
+	const Subsidy *s;
+	FOR_ALL_SUBSIDIES(s) {
+		if (s->src_type == type && s->src == index) flags |= POS_SRC;
+		if (s->dst_type == type && s->dst == index) flags |= POS_DST;
+	}
+
+	switch (type) {
+		case ST_INDUSTRY: Industry::Get(index)->part_of_subsidy = flags; return;
+		case ST_TOWN:         Town::Get(index)->part_of_subsidy = flags; return;
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Delete a subsidy, and update the flags of its source and destination.
+ * Only these two can change, so not all towns and industries need to be
+ * looked at again.
+ * @param s the subsidy to delete
+ */
+void DeleteSubsidy(Subsidy *s)
+{
+	SourceType src_type = s->src_type;
+	SourceType dst_type = s->dst_type;
+	SourceID src = s->src;
+	SourceID dst = s->dst;
+
+	delete s;
+
+	UpdatePartOfSubsidyFlags(src_type, src);
+	UpdatePartOfSubsidyFlags(dst_type, dst);
+}
+
 void DeleteSubsidyWith(SourceType type, SourceID index)
 {
 	bool dirty = false;
@@ -146,17 +187,53 @@ void DeleteSubsidyWith(SourceType type, SourceID index)
 	Subsidy *s;
 	FOR_ALL_SUBSIDIES(s) {
 		if ((s->src_type == type && s->src == index) || (s->dst_type == type && s->dst == index)) {
-			delete s;
+			DeleteSubsidy(s);
 			dirty = true;
 		}
 	}
 
-	if (dirty) {
-		InvalidateWindowData(WC_SUBSIDIES_LIST, 0);
-		RebuildSubsidisedSourceAndDestinationCache();
-	}
+	if (dirty) InvalidateWindowData(WC_SUBSIDIES_LIST, 0);
 }
 
+/**
+ * The towns and industries to pick subsidy candidates from. Picking a random
+ * item of a pool walks the pool up to that item, which becomes costly when a
+ * thousand candidates are tried on a map with thousands of towns or
+ * industries. These lists pick the very same items in constant time.
+ */
+struct SubsidyCandidates {
+	SmallVector<const Town *, 64> towns;          ///< All towns, in the order of their index.
+	SmallVector<const Industry *, 64> industries; ///< All industries, in the order of their index.
+
+	SubsidyCandidates()
+	{
+		const Town *t;
+		FOR_ALL_TOWNS(t) *this->towns.Append() = t;
+		const Industry *i;
+		FOR_ALL_INDUSTRIES(i) *this->industries.Append() = i;
+	}
+
+	/**
+	 * Get a random town, like Town::GetRandom.
+	 * @return the town, or NULL when there are none
+	 */
+	const Town *GetRandomTown() const
+	{
+		if (this->towns.Length() == 0) return NULL;
+		return this->towns[RandomRange((uint16)this->towns.Length())];
+	}
+
+	/**
+	 * Get a random industry, like Industry::GetRandom.
+	 * @return the industry, or NULL when there are none
+	 */
+	const Industry *GetRandomIndustry() const
+	{
+		if (this->industries.Length() == 0) return NULL;
+		return this->industries[RandomRange((uint16)this->industries.Length())];
+	}
+};
+
 static bool CheckSubsidyDuplicate(CargoID cargo, SourceType src_type, SourceID src, SourceType dst_type, SourceID dst)
 {
 	const Subsidy *s;
@@ -170,17 +247,17 @@ static bool CheckSubsidyDuplicate(CargoID cargo, SourceType src_type, SourceID s
 	return false;
 }
 
-static Subsidy *FindSubsidyPassengerRoute()
+static Subsidy *FindSubsidyPassengerRoute(const SubsidyCandidates &candidates)
 {
 	assert(Subsidy::CanAllocateItem());
 
-	const Town *src = Town::GetRandom();
+	const Town *src = candidates.GetRandomTown();
 	if (src->population < SUBSIDY_PAX_MIN_POPULATION ||
 			src->pct_pass_transported > SUBSIDY_MAX_PCT_TRANSPORTED) {
 		return NULL;
 	}
 
-	const Town *dst = Town::GetRandom();
+	const Town *dst = candidates.GetRandomTown();
 	if (dst->population < SUBSIDY_PAX_MIN_POPULATION || src == dst) {
 		return NULL;
 	}
@@ -197,11 +274,11 @@ static Subsidy *FindSubsidyPassengerRoute()
 	return s;
 }
 
-static Subsidy *FindSubsidyCargoRoute()
+static Subsidy *FindSubsidyCargoRoute(const SubsidyCandidates &candidates)
 {
 	assert(Subsidy::CanAllocateItem());
 
-	const Industry *i = Industry::GetRandom();
+	const Industry *i = candidates.GetRandomIndustry();
 	if (i == NULL) return NULL;
 
 	CargoID cargo;
@@ -232,7 +309,7 @@ static Subsidy *FindSubsidyCargoRoute()
 	if (cs->town_effect == TE_GOODS || cs->town_effect == TE_FOOD) {
 		/*  The destination is a town */
 		dst_type = ST_TOWN;
-		const Town *t = Town::GetRandom();
+		const Town *t = candidates.GetRandomTown();
 
 		/* Only want big towns */
 		if (t->population < SUBSIDY_CARGO_MIN_POPULATION) return NULL;
@@ -243,7 +320,7 @@ static Subsidy *FindSubsidyCargoRoute()
 	} else {
 		/* The destination is an industry */
 		dst_type = ST_INDUSTRY;
-		const Industry *i2 = Industry::GetRandom();
+		const Industry *i2 = candidates.GetRandomIndustry();
 
 		/* The industry must accept the cargo */
 		if (i2 == NULL || i == i2 ||
@@ -288,19 +365,18 @@ void SubsidyMonthlyLoop()
 				}
 				AI::BroadcastNewEvent(new AIEventSubsidyExpired(s->index));
 			}
-			delete s;
+			DeleteSubsidy(s);
 			modified = true;
 		}
 	}
 
-	if (modified) RebuildSubsidisedSourceAndDestinationCache();
-
 	/* 25% chance to go on */
 	if (Subsidy::CanAllocateItem() && Chance16(1, 4)) {
+		SubsidyCandidates candidates;
 		uint n = 1000;
 		do {
-			Subsidy *s = FindSubsidyPassengerRoute();
-			if (s == NULL) s = FindSubsidyCargoRoute();
+			Subsidy *s = FindSubsidyPassengerRoute(candidates);
+			if (s == NULL) s = FindSubsidyCargoRoute(candidates);
 			if (s != NULL) {
 				s->remaining = SUBSIDY_OFFER_MONTHS;
 				s->awarded = INVALID_COMPANY;
@@ -341,28 +417,31 @@ bool CheckSubsidised(CargoID cargo_type, CompanyID company, SourceType src_type,
 		default: return false;
 	}
 
-	/* Remember all towns near this station (at least one house in its catchment radius)
-	 * which are destination of subsidised path. Do that only if needed */
+	/* Remember the towns near this station (at least one house in its catchment radius)
+	 * which are destination of an applicable subsidy. Do that only if needed */
 	SmallVector<const Town *, 2> towns_near;
 	if (!st->rect.IsEmpty()) {
+		SmallVector<TownID, 2> towns_wanted;
 		Subsidy *s;
 		FOR_ALL_SUBSIDIES(s) {
-			/* Don't create the cache if there is no applicable subsidy with town as destination */
 			if (s->dst_type != ST_TOWN) continue;
 			if (s->cargo_type != cargo_type || s->src_type != src_type || s->src != src) continue;
 			if (s->IsAwarded() && s->awarded != company) continue;
+			towns_wanted.Include(s->dst);
+		}
 
+		if (towns_wanted.Length() != 0) {
 			Rect rect = st->GetCatchmentRect();
 
-			for (int y = rect.top; y <= rect.bottom; y++) {
+			/* Stop looking once all wanted towns are found. */
+			for (int y = rect.top; y <= rect.bottom && towns_near.Length() != towns_wanted.Length(); y++) {
 				for (int x = rect.left; x <= rect.right; x++) {
 					TileIndex tile = TileXY(x, y);
 					if (!IsTileType(tile, MP_HOUSE)) continue;
-					const Town *t = Town::GetByTile(tile);
-					if (t->part_of_subsidy & POS_DST) towns_near.Include(t);
+					TownID t = GetTownIndex(tile);
+					if (towns_wanted.Contains(t)) towns_near.Include(Town::Get(t));
 				}
 			}
-			break;
 		}
 	}
 
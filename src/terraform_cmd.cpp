@@ -17,41 +17,31 @@
 #include "functions.h"
 #include "economy_func.h"
 #include "genworld.h"
+#include "town.h"
 
 #include "table/strings.h"
 
-/*
- * In one terraforming command all four corners of a initial tile can be raised/lowered (though this is not available to the player).
- * The maximal amount of height modifications is archieved when raising a complete flat land from sea level to MAX_TILE_HEIGHT or vice versa.
- * This affects all corners with a manhatten distance smaller than MAX_TILE_HEIGHT to one of the initial 4 corners.
- * Their maximal amount is computed to 4 * \sum_{i=1}^{h_max} i  =  2 * h_max * (h_max + 1).
- */
-static const int TERRAFORMER_MODHEIGHT_SIZE = 2 * MAX_TILE_HEIGHT * (MAX_TILE_HEIGHT + 1);
-
-/*
- * The maximal amount of affected tiles (i.e. the tiles that incident with one of the corners above, is computed similiar to
- * 1 + 4 * \sum_{i=1}^{h_max} (i+1)  =  1 + 2 * h_max + (h_max + 3).
- */
-static const int TERRAFORMER_TILE_TABLE_SIZE = 1 + 2 * MAX_TILE_HEIGHT * (MAX_TILE_HEIGHT + 3);
+#include <map>
+#include <set>
 
-struct TerraformerHeightMod {
-	TileIndex tile;   ///< Referenced tile.
-	byte height;      ///< New TileHeight (height of north corner) of the tile.
-};
+typedef std::map<TileIndex, int> TileIndexToHeightMap; ///< Mapping of tiles to their new height.
+typedef std::set<TileIndex> TileIndexSet;              ///< Set of tiles.
 
+/**
+ * The landscape as it would be after terraforming. Tiles are looked up in
+ * logarithmic time, so terraforming many corners in one go, like towns,
+ * industries and the levelling of areas do, does not become quadratic.
+ */
 struct TerraformerState {
-	int modheight_count;  ///< amount of entries in "modheight".
-	int tile_table_count; ///< amount of entries in "tile_table".
-
 	/**
 	 * Dirty tiles, i.e.\ at least one corner changed.
 	 *
-	 * This array contains the tiles which are or will be marked as dirty.
+	 * This set contains the tiles which are or will be marked as dirty.
 	 *
 	 * @ingroup dirty
 	 */
-	TileIndex tile_table[TERRAFORMER_TILE_TABLE_SIZE];
-	TerraformerHeightMod modheight[TERRAFORMER_MODHEIGHT_SIZE];  ///< Height modifications.
+	TileIndexSet dirty_tiles;
+	TileIndexToHeightMap tile_to_new_height; ///< The tiles for which the height has changed.
 };
 
 TileIndex _terraform_err_tile; ///< first tile we couldn't terraform
@@ -65,11 +55,8 @@ TileIndex _terraform_err_tile; ///< first tile we couldn't terraform
  */
 static int TerraformGetHeightOfTile(const TerraformerState *ts, TileIndex tile)
 {
-	const TerraformerHeightMod *mod = ts->modheight;
-
-	for (int count = ts->modheight_count; count != 0; count--, mod++) {
-		if (mod->tile == tile) return mod->height;
-	}
+	TileIndexToHeightMap::const_iterator it = ts->tile_to_new_height.find(tile);
+	if (it != ts->tile_to_new_height.end()) return it->second;
 
 	/* TileHeight unchanged so far, read value from map. */
 	return TileHeight(tile);
@@ -84,30 +71,11 @@ static int TerraformGetHeightOfTile(const TerraformerState *ts, TileIndex tile)
  */
 static void TerraformSetHeightOfTile(TerraformerState *ts, TileIndex tile, int height)
 {
-	/* Find tile in the "modheight" table.
-	 * Note: In a normal user-terraform command the tile will not be found in the "modheight" table.
-	 *       But during house- or industry-construction multiple corners can be terraformed at once. */
-	TerraformerHeightMod *mod = ts->modheight;
-	int count = ts->modheight_count;
-
-	while ((count > 0) && (mod->tile != tile)) {
-		mod++;
-		count--;
-	}
-
-	/* New entry? */
-	if (count == 0) {
-		assert(ts->modheight_count < TERRAFORMER_MODHEIGHT_SIZE);
-		ts->modheight_count++;
-	}
-
-	/* Finally store the new value */
-	mod->tile = tile;
-	mod->height = (byte)height;
+	ts->tile_to_new_height[tile] = height;
 }
 
 /**
- * Adds a tile to the "tile_table" in a TerraformerState.
+ * Adds a tile to the "dirty_tiles" in a TerraformerState.
  *
  * @param ts TerraformerState.
  * @param tile Tile.
@@ -115,19 +83,11 @@ static void TerraformSetHeightOfTile(TerraformerState *ts, TileIndex tile, int h
  */
 static void TerraformAddDirtyTile(TerraformerState *ts, TileIndex tile)
 {
-	int count = ts->tile_table_count;
-
-	for (TileIndex *t = ts->tile_table; count != 0; count--, t++) {
-		if (*t == tile) return;
-	}
-
-	assert(ts->tile_table_count < TERRAFORMER_TILE_TABLE_SIZE);
-
-	ts->tile_table[ts->tile_table_count++] = tile;
+	ts->dirty_tiles.insert(tile);
 }
 
 /**
- * Adds all tiles that incident with the north corner of a specific tile to the "tile_table" in a TerraformerState.
+ * Adds all tiles that incident with the north corner of a specific tile to the "dirty_tiles" in a TerraformerState.
  *
  * @param ts TerraformerState.
  * @param tile Tile.
@@ -227,129 +187,153 @@ static CommandCost TerraformTileHeight(TerraformerState *ts, TileIndex tile, int
 	return total_cost;
 }
 
-/** Terraform land
- * @param tile tile to terraform
- * @param flags for this command type
- * @param p1 corners to terraform (SLOPE_xxx)
- * @param p2 direction; eg up (non-zero) or down (zero)
- * @param text unused
- * @return the cost of this operation or an error
+/**
+ * Compute the heights after terraforming some corners of a tile, and their costs.
+ * @param ts The state to store the new heights and the dirty tiles in.
+ * @param tile The tile to terraform.
+ * @param corners The corners to terraform (SLOPE_xxx).
+ * @param direction Up (1) or down (-1).
+ * @return The cost of changing the heights or an error.
  */
-CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32 p2, const char *text)
+static CommandCost TerraformCorners(TerraformerState *ts, TileIndex tile, uint32 corners, int direction)
 {
-	_terraform_err_tile = INVALID_TILE;
-
 	CommandCost total_cost(EXPENSES_CONSTRUCTION);
-	int direction = (p2 != 0 ? 1 : -1);
-	TerraformerState ts;
 
-	ts.modheight_count = ts.tile_table_count = 0;
-
-	/* Compute the costs and the terraforming result in a model of the landscape */
-	if ((p1 & SLOPE_W) != 0 && tile + TileDiffXY(1, 0) < MapSize()) {
+	if ((corners & SLOPE_W) != 0 && tile + TileDiffXY(1, 0) < MapSize()) {
 		TileIndex t = tile + TileDiffXY(1, 0);
-		CommandCost cost = TerraformTileHeight(&ts, t, TileHeight(t) + direction);
+		CommandCost cost = TerraformTileHeight(ts, t, TileHeight(t) + direction);
 		if (cost.Failed()) return cost;
 		total_cost.AddCost(cost);
 	}
 
-	if ((p1 & SLOPE_S) != 0 && tile + TileDiffXY(1, 1) < MapSize()) {
+	if ((corners & SLOPE_S) != 0 && tile + TileDiffXY(1, 1) < MapSize()) {
 		TileIndex t = tile + TileDiffXY(1, 1);
-		CommandCost cost = TerraformTileHeight(&ts, t, TileHeight(t) + direction);
+		CommandCost cost = TerraformTileHeight(ts, t, TileHeight(t) + direction);
 		if (cost.Failed()) return cost;
 		total_cost.AddCost(cost);
 	}
 
-	if ((p1 & SLOPE_E) != 0 && tile + TileDiffXY(0, 1) < MapSize()) {
+	if ((corners & SLOPE_E) != 0 && tile + TileDiffXY(0, 1) < MapSize()) {
 		TileIndex t = tile + TileDiffXY(0, 1);
-		CommandCost cost = TerraformTileHeight(&ts, t, TileHeight(t) + direction);
+		CommandCost cost = TerraformTileHeight(ts, t, TileHeight(t) + direction);
 		if (cost.Failed()) return cost;
 		total_cost.AddCost(cost);
 	}
 
-	if ((p1 & SLOPE_N) != 0) {
+	if ((corners & SLOPE_N) != 0) {
 		TileIndex t = tile + TileDiffXY(0, 0);
-		CommandCost cost = TerraformTileHeight(&ts, t, TileHeight(t) + direction);
+		CommandCost cost = TerraformTileHeight(ts, t, TileHeight(t) + direction);
 		if (cost.Failed()) return cost;
 		total_cost.AddCost(cost);
 	}
 
-	/* Check if the terraforming is valid wrt. tunnels, bridges and objects on the surface */
-	{
-		TileIndex *ti = ts.tile_table;
-
-		for (int count = ts.tile_table_count; count != 0; count--, ti++) {
-			TileIndex tile = *ti;
-
-			assert(tile < MapSize());
-			/* MP_VOID tiles can be terraformed but as tunnels and bridges
-			 * cannot go under / over these tiles they don't need checking. */
-			if (IsTileType(tile, MP_VOID)) continue;
-
-			/* Find new heights of tile corners */
-			uint z_N = TerraformGetHeightOfTile(&ts, tile + TileDiffXY(0, 0));
-			uint z_W = TerraformGetHeightOfTile(&ts, tile + TileDiffXY(1, 0));
-			uint z_S = TerraformGetHeightOfTile(&ts, tile + TileDiffXY(1, 1));
-			uint z_E = TerraformGetHeightOfTile(&ts, tile + TileDiffXY(0, 1));
-
-			/* Find min and max height of tile */
-			uint z_min = min(min(z_N, z_W), min(z_S, z_E));
-			uint z_max = max(max(z_N, z_W), max(z_S, z_E));
-
-			/* Compute tile slope */
-			Slope tileh = (z_max > z_min + 1 ? SLOPE_STEEP : SLOPE_FLAT);
-			if (z_W > z_min) tileh |= SLOPE_W;
-			if (z_S > z_min) tileh |= SLOPE_S;
-			if (z_E > z_min) tileh |= SLOPE_E;
-			if (z_N > z_min) tileh |= SLOPE_N;
-
-			/* Check if bridge would take damage */
-			if (direction == 1 && MayHaveBridgeAbove(tile) && IsBridgeAbove(tile) &&
-					GetBridgeHeight(GetSouthernBridgeEnd(tile)) <= z_max * TILE_HEIGHT) {
-				_terraform_err_tile = tile; // highlight the tile under the bridge
-				return_cmd_error(STR_ERROR_MUST_DEMOLISH_BRIDGE_FIRST);
-			}
-			/* Check if tunnel would take damage */
-			if (direction == -1 && IsTunnelInWay(tile, z_min * TILE_HEIGHT)) {
-				_terraform_err_tile = tile; // highlight the tile above the tunnel
-				return_cmd_error(STR_ERROR_EXCAVATION_WOULD_DAMAGE);
-			}
-			/* Check tiletype-specific things, and add extra-cost */
-			const bool curr_gen = _generating_world;
-			if (_game_mode == GM_EDITOR) _generating_world = true; // used to create green terraformed land
-			CommandCost cost = _tile_type_procs[GetTileType(tile)]->terraform_tile_proc(tile, flags | DC_AUTO, z_min * TILE_HEIGHT, tileh);
-			_generating_world = curr_gen;
-			if (cost.Failed()) {
-				_terraform_err_tile = tile;
-				return cost;
-			}
-			total_cost.AddCost(cost);
+	return total_cost;
+}
+
+/**
+ * Check whether the terraforming is valid wrt. tunnels, bridges and objects on the surface.
+ * With DC_EXEC the objects are changed for the new heights, e.g. trees are removed.
+ * @param ts The terraforming to check.
+ * @param flags For this command type.
+ * @param direction Up (1) or down (-1).
+ * @return The cost of changing the objects or an error.
+ */
+static CommandCost TerraformCheckTiles(const TerraformerState *ts, DoCommandFlag flags, int direction)
+{
+	CommandCost total_cost(EXPENSES_CONSTRUCTION);
+
+	for (TileIndexSet::const_iterator it = ts->dirty_tiles.begin(); it != ts->dirty_tiles.end(); it++) {
+		TileIndex tile = *it;
+
+		assert(tile < MapSize());
+		/* MP_VOID tiles can be terraformed but as tunnels and bridges
+		 * cannot go under / over these tiles they don't need checking. */
+		if (IsTileType(tile, MP_VOID)) continue;
+
+		/* Find new heights of tile corners */
+		uint z_N = TerraformGetHeightOfTile(ts, tile + TileDiffXY(0, 0));
+		uint z_W = TerraformGetHeightOfTile(ts, tile + TileDiffXY(1, 0));
+		uint z_S = TerraformGetHeightOfTile(ts, tile + TileDiffXY(1, 1));
+		uint z_E = TerraformGetHeightOfTile(ts, tile + TileDiffXY(0, 1));
+
+		/* Find min and max height of tile */
+		uint z_min = min(min(z_N, z_W), min(z_S, z_E));
+		uint z_max = max(max(z_N, z_W), max(z_S, z_E));
+
+		/* Compute tile slope */
+		Slope tileh = (z_max > z_min + 1 ? SLOPE_STEEP : SLOPE_FLAT);
+		if (z_W > z_min) tileh |= SLOPE_W;
+		if (z_S > z_min) tileh |= SLOPE_S;
+		if (z_E > z_min) tileh |= SLOPE_E;
+		if (z_N > z_min) tileh |= SLOPE_N;
+
+		/* Check if bridge would take damage */
+		if (direction == 1 && MayHaveBridgeAbove(tile) && IsBridgeAbove(tile) &&
+				GetBridgeHeight(GetSouthernBridgeEnd(tile)) <= z_max * TILE_HEIGHT) {
+			_terraform_err_tile = tile; // highlight the tile under the bridge
+			return_cmd_error(STR_ERROR_MUST_DEMOLISH_BRIDGE_FIRST);
+		}
+		/* Check if tunnel would take damage */
+		if (direction == -1 && IsTunnelInWay(tile, z_min * TILE_HEIGHT)) {
+			_terraform_err_tile = tile; // highlight the tile above the tunnel
+			return_cmd_error(STR_ERROR_EXCAVATION_WOULD_DAMAGE);
+		}
+		/* Check tiletype-specific things, and add extra-cost */
+		const bool curr_gen = _generating_world;
+		if (_game_mode == GM_EDITOR) _generating_world = true; // used to create green terraformed land
+		CommandCost cost = _tile_type_procs[GetTileType(tile)]->terraform_tile_proc(tile, flags | DC_AUTO, z_min * TILE_HEIGHT, tileh);
+		_generating_world = curr_gen;
+		if (cost.Failed()) {
+			_terraform_err_tile = tile;
+			return cost;
 		}
+		total_cost.AddCost(cost);
 	}
 
-	if (flags & DC_EXEC) {
-		/* change the height */
-		{
-			int count;
-			TerraformerHeightMod *mod;
-
-			mod = ts.modheight;
-			for (count = ts.modheight_count; count != 0; count--, mod++) {
-				TileIndex til = mod->tile;
+	return total_cost;
+}
 
-				SetTileHeight(til, mod->height);
-			}
-		}
+/**
+ * Change the heights of the landscape to the result of the terraforming.
+ * @param ts The terraforming to execute.
+ */
+static void TerraformExecute(const TerraformerState *ts)
+{
+	/* change the height */
+	for (TileIndexToHeightMap::const_iterator it = ts->tile_to_new_height.begin(); it != ts->tile_to_new_height.end(); it++) {
+		SetTileHeight(it->first, it->second);
+	}
 
-		/* finally mark the dirty tiles dirty */
-		{
-			int count;
-			TileIndex *ti = ts.tile_table;
-			for (count = ts.tile_table_count; count != 0; count--, ti++) {
-				MarkTileDirtyByTile(*ti);
-			}
-		}
+	/* finally mark the dirty tiles dirty */
+	for (TileIndexSet::const_iterator it = ts->dirty_tiles.begin(); it != ts->dirty_tiles.end(); it++) {
+		MarkTileDirtyByTile(*it);
 	}
+}
+
+/** Terraform land
+ * @param tile tile to terraform
+ * @param flags for this command type
+ * @param p1 corners to terraform (SLOPE_xxx)
+ * @param p2 direction; eg up (non-zero) or down (zero)
+ * @param text unused
+ * @return the cost of this operation or an error
+ */
+CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32 p2, const char *text)
+{
+	_terraform_err_tile = INVALID_TILE;
+
+	int direction = (p2 != 0 ? 1 : -1);
+	TerraformerState ts;
+
+	/* Compute the costs and the terraforming result in a model of the landscape */
+	CommandCost total_cost = TerraformCorners(&ts, tile, p1, direction);
+	if (total_cost.Failed()) return total_cost;
+
+	CommandCost cost = TerraformCheckTiles(&ts, flags, direction);
+	if (cost.Failed()) return cost;
+	total_cost.AddCost(cost);
+
+	if (flags & DC_EXEC) TerraformExecute(&ts);
 	return total_cost;
 }
 
@@ -382,11 +366,31 @@ CommandCost CmdLevelLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 	CommandCost last_error((p2 == 0) ? STR_ERROR_ALREADY_LEVELLED : INVALID_STRING_ID);
 	bool had_success = false;
 
+	/* Every step is the same as a CMD_TERRAFORM_LAND of the north corner,
+	 * but the new heights of a step are only computed once for both the
+	 * test and the execution. */
+	TerraformerState ts;
 	TileArea ta(tile, p1);
 	TILE_AREA_LOOP(tile, ta) {
 		uint curh = TileHeight(tile);
 		while (curh != h) {
-			CommandCost ret = DoCommand(tile, SLOPE_N, (curh > h) ? 0 : 1, flags & ~DC_EXEC, CMD_TERRAFORM_LAND);
+			int direction = (curh > h) ? -1 : 1;
+
+			_terraform_err_tile = INVALID_TILE;
+			ts.dirty_tiles.clear();
+			ts.tile_to_new_height.clear();
+
+			CommandCost ret = TerraformCorners(&ts, tile, SLOPE_N, direction);
+			if (ret.Succeeded()) {
+				SetTownRatingTestMode(true);
+				CommandCost check = TerraformCheckTiles(&ts, flags & ~DC_EXEC, direction);
+				SetTownRatingTestMode(false);
+				if (check.Failed()) {
+					ret = check;
+				} else {
+					ret.AddCost(check);
+				}
+			}
 			if (ret.Failed()) {
 				last_error = ret;
 				break;
@@ -398,11 +402,12 @@ CommandCost CmdLevelLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 					_additional_cash_required = ret.GetCost();
 					return cost;
 				}
-				DoCommand(tile, SLOPE_N, (curh > h) ? 0 : 1, flags, CMD_TERRAFORM_LAND);
+				TerraformCheckTiles(&ts, flags, direction);
+				TerraformExecute(&ts);
 			}
 
 			cost.AddCost(ret);
-			curh += (curh > h) ? -1 : 1;
+			curh += direction;
 			had_success = true;
 		}
 	}
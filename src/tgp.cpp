@@ -428,81 +428,106 @@ static int *HeightMapMakeHistogram(height_t h_min, height_t h_max, int *hist_buf
 	return hist;
 }
 
-/** Applies sine wave redistribution onto height map */
-static void HeightMapSineTransform(height_t h_min, height_t h_max)
+/**
+ * Apply the sine wave redistribution to a single height.
+ * @param height The height to transform, at least h_min.
+ * @param h_min  The lowest height to transform.
+ * @param h_max  The highest height the result may get.
+ * @return The transformed height.
+ */
+static height_t SineTransformHeight(height_t height, height_t h_min, height_t h_max)
 {
-	height_t *h;
-
-	FOR_ALL_TILES_IN_HEIGHT(h) {
-		double fheight;
-
-		if (*h < h_min) continue;
-
-		/* Transform height into 0..1 space */
-		fheight = (double)(*h - h_min) / (double)(h_max - h_min);
-		/* Apply sine transform depending on landscape type */
-		switch (_settings_game.game_creation.landscape) {
-			case LT_TOYLAND:
-			case LT_TEMPERATE:
-				/* Move and scale 0..1 into -1..+1 */
-				fheight = 2 * fheight - 1;
-				/* Sine transform */
-				fheight = sin(fheight * M_PI_2);
-				/* Transform it back from -1..1 into 0..1 space */
-				fheight = 0.5 * (fheight + 1);
-				break;
-
-			case LT_ARCTIC:
-				{
-					/* Arctic terrain needs special height distribution.
-					 * Redistribute heights to have more tiles at highest (75%..100%) range */
-					double sine_upper_limit = 0.75;
-					double linear_compression = 2;
-					if (fheight >= sine_upper_limit) {
-						/* Over the limit we do linear compression up */
-						fheight = 1.0 - (1.0 - fheight) / linear_compression;
-					} else {
-						double m = 1.0 - (1.0 - sine_upper_limit) / linear_compression;
-						/* Get 0..sine_upper_limit into -1..1 */
-						fheight = 2.0 * fheight / sine_upper_limit - 1.0;
-						/* Sine wave transform */
-						fheight = sin(fheight * M_PI_2);
-						/* Get -1..1 back to 0..(1 - (1 - sine_upper_limit) / linear_compression) == 0.0..m */
-						fheight = 0.5 * (fheight + 1.0) * m;
-					}
+	double fheight;
+
+	/* Transform height into 0..1 space */
+	fheight = (double)(height - h_min) / (double)(h_max - h_min);
+	/* Apply sine transform depending on landscape type */
+	switch (_settings_game.game_creation.landscape) {
+		case LT_TOYLAND:
+		case LT_TEMPERATE:
+			/* Move and scale 0..1 into -1..+1 */
+			fheight = 2 * fheight - 1;
+			/* Sine transform */
+			fheight = sin(fheight * M_PI_2);
+			/* Transform it back from -1..1 into 0..1 space */
+			fheight = 0.5 * (fheight + 1);
+			break;
+
+		case LT_ARCTIC:
+			{
+				/* Arctic terrain needs special height distribution.
+				 * Redistribute heights to have more tiles at highest (75%..100%) range */
+				double sine_upper_limit = 0.75;
+				double linear_compression = 2;
+				if (fheight >= sine_upper_limit) {
+					/* Over the limit we do linear compression up */
+					fheight = 1.0 - (1.0 - fheight) / linear_compression;
+				} else {
+					double m = 1.0 - (1.0 - sine_upper_limit) / linear_compression;
+					/* Get 0..sine_upper_limit into -1..1 */
+					fheight = 2.0 * fheight / sine_upper_limit - 1.0;
+					/* Sine wave transform */
+					fheight = sin(fheight * M_PI_2);
+					/* Get -1..1 back to 0..(1 - (1 - sine_upper_limit) / linear_compression) == 0.0..m */
+					fheight = 0.5 * (fheight + 1.0) * m;
 				}
-				break;
-
-			case LT_TROPIC:
-				{
-					/* Desert terrain needs special height distribution.
-					 * Half of tiles should be at lowest (0..25%) heights */
-					double sine_lower_limit = 0.5;
-					double linear_compression = 2;
-					if (fheight <= sine_lower_limit) {
-						/* Under the limit we do linear compression down */
-						fheight = fheight / linear_compression;
-					} else {
-						double m = sine_lower_limit / linear_compression;
-						/* Get sine_lower_limit..1 into -1..1 */
-						fheight = 2.0 * ((fheight - sine_lower_limit) / (1.0 - sine_lower_limit)) - 1.0;
-						/* Sine wave transform */
-						fheight = sin(fheight * M_PI_2);
-						/* Get -1..1 back to (sine_lower_limit / linear_compression)..1.0 */
-						fheight = 0.5 * ((1.0 - m) * fheight + (1.0 + m));
-					}
+			}
+			break;
+
+		case LT_TROPIC:
+			{
+				/* Desert terrain needs special height distribution.
+				 * Half of tiles should be at lowest (0..25%) heights */
+				double sine_lower_limit = 0.5;
+				double linear_compression = 2;
+				if (fheight <= sine_lower_limit) {
+					/* Under the limit we do linear compression down */
+					fheight = fheight / linear_compression;
+				} else {
+					double m = sine_lower_limit / linear_compression;
+					/* Get sine_lower_limit..1 into -1..1 */
+					fheight = 2.0 * ((fheight - sine_lower_limit) / (1.0 - sine_lower_limit)) - 1.0;
+					/* Sine wave transform */
+					fheight = sin(fheight * M_PI_2);
+					/* Get -1..1 back to (sine_lower_limit / linear_compression)..1.0 */
+					fheight = 0.5 * ((1.0 - m) * fheight + (1.0 + m));
 				}
-				break;
+			}
+			break;
 
-			default:
-				NOT_REACHED();
-				break;
-		}
-		/* Transform it back into h_min..h_max space */
-		*h = (height_t)(fheight * (h_max - h_min) + h_min);
-		if (*h < 0) *h = I2H(0);
-		if (*h >= h_max) *h = h_max - 1;
+		default:
+			NOT_REACHED();
+			break;
 	}
+	/* Transform it back into h_min..h_max space */
+	height_t h = (height_t)(fheight * (h_max - h_min) + h_min);
+	if (h < 0) h = I2H(0);
+	if (h >= h_max) h = h_max - 1;
+	return h;
+}
+
+/**
+ * Applies sine wave redistribution onto height map.
+ * The transformation only depends on the height itself, so it is
+ * computed once for every height in the map instead of for every tile.
+ */
+static void HeightMapSineTransform(height_t h_min, height_t h_max)
+{
+	height_t h_highest;
+	HeightMapGetMinMaxAvg(NULL, &h_highest, NULL);
+	if (h_highest < h_min) return;
+
+	height_t *transformed = MallocT<height_t>(h_highest - h_min + 1);
+	for (int i = h_min; i <= h_highest; i++) {
+		transformed[i - h_min] = SineTransformHeight(i, h_min, h_max);
+	}
+
+	height_t *h;
+	FOR_ALL_TILES_IN_HEIGHT(h) {
+		if (*h >= h_min) *h = transformed[*h - h_min];
+	}
+
+	free(transformed);
 }
 
 /* Additional map variety is provided by applying different curve maps
@@ -555,6 +580,13 @@ static const control_point_list_t _curve_maps[] = {
 	{ lengthof(_curve_map_4), _curve_map_4 },
 };
 
+/**
+ * Apply the curve maps to the height map.
+ * The result of a curve map only depends on the height, and the grid position and
+ * ratio only on the x respectively y coordinate, so these are computed up front
+ * instead of for every tile.
+ * @param level The resolution of the grid with curve maps.
+ */
 static void HeightMapCurves(uint level)
 {
 	height_t ht[lengthof(_curve_maps)];
@@ -568,10 +600,37 @@ static void HeightMapCurves(uint level)
 		c[i] = Random() % lengthof(_curve_maps);
 	}
 
-	/* Apply curves */
-	for (uint x = 0; x < _height_map.size_x; x++) {
+	/* Look up table of the curve map results for every height in the map;
+	 * _invalid_height when the height is not covered by the curve map. */
+	height_t h_min, h_max;
+	HeightMapGetMinMaxAvg(&h_min, &h_max, NULL);
+	uint num_heights = h_max - h_min + 1;
+	height_t *curves = MallocT<height_t>(lengthof(_curve_maps) * num_heights);
+
+	for (uint t = 0; t < lengthof(_curve_maps); t++) {
+		const control_point_t *cm = _curve_maps[t].list;
+		for (uint j = 0; j < num_heights; j++) {
+			int h = h_min + j;
+			height_t &result = curves[t * num_heights + j];
+			result = _invalid_height;
+
+			for (uint i = 0; i < _curve_maps[t].length - 1; i++) {
+				const control_point_t &p1 = cm[i];
+				const control_point_t &p2 = cm[i + 1];
+
+				if (h >= p1.x && h < p2.x) {
+					result = p1.y + (h - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
+					break;
+				}
+			}
+		}
+	}
 
-		/* Get our X grid positions and bi-linear ratio */
+	/* Get our X grid positions and bi-linear ratios */
+	uint *gx1 = MallocT<uint>(_height_map.size_x);
+	uint *gx2 = MallocT<uint>(_height_map.size_x);
+	float *gxr = MallocT<float>(_height_map.size_x);
+	for (uint x = 0; x < _height_map.size_x; x++) {
 		float fx = (float)(sx * x) / _height_map.size_x + 0.5f;
 		uint x1 = (uint)fx;
 		uint x2 = x1;
@@ -579,29 +638,40 @@ static void HeightMapCurves(uint level)
 		xr = sin(xr * M_PI_2);
 		xr = sin(xr * M_PI_2);
 		xr = 0.5f * (xr + 1.0f);
-		float xri = 1.0f - xr;
 
 		if (x1 > 0) {
 			x1--;
 			if (x2 >= sx) x2--;
 		}
 
-		for (uint y = 0; y < _height_map.size_y; y++) {
-
-			/* Get our Y grid position and bi-linear ratio */
-			float fy = (float)(sy * y) / _height_map.size_y + 0.5f;
-			uint y1 = (uint)fy;
-			uint y2 = y1;
-			float yr = 2.0f * (fy - y1) - 1.0f;
-			yr = sin(yr * M_PI_2);
-			yr = sin(yr * M_PI_2);
-			yr = 0.5f * (yr + 1.0f);
-			float yri = 1.0f - yr;
-
-			if (y1 > 0) {
-				y1--;
-				if (y2 >= sy) y2--;
-			}
+		gx1[x] = x1;
+		gx2[x] = x2;
+		gxr[x] = xr;
+	}
+
+	/* Apply curves */
+	for (uint y = 0; y < _height_map.size_y; y++) {
+
+		/* Get our Y grid position and bi-linear ratio */
+		float fy = (float)(sy * y) / _height_map.size_y + 0.5f;
+		uint y1 = (uint)fy;
+		uint y2 = y1;
+		float yr = 2.0f * (fy - y1) - 1.0f;
+		yr = sin(yr * M_PI_2);
+		yr = sin(yr * M_PI_2);
+		yr = 0.5f * (yr + 1.0f);
+		float yri = 1.0f - yr;
+
+		if (y1 > 0) {
+			y1--;
+			if (y2 >= sy) y2--;
+		}
+
+		for (uint x = 0; x < _height_map.size_x; x++) {
+			uint x1 = gx1[x];
+			uint x2 = gx2[x];
+			float xr = gxr[x];
+			float xri = 1.0f - xr;
 
 			uint corner_a = c[x1 + sx * y1];
 			uint corner_b = c[x1 + sx * y2];
@@ -622,22 +692,19 @@ static void HeightMapCurves(uint level)
 			for (uint t = 0; t < lengthof(_curve_maps); t++) {
 				if (!HasBit(corner_bits, t)) continue;
 
-				const control_point_t *cm = _curve_maps[t].list;
-				for (uint i = 0; i < _curve_maps[t].length - 1; i++) {
-					const control_point_t &p1 = cm[i];
-					const control_point_t &p2 = cm[i + 1];
-
-					if (*h >= p1.x && *h < p2.x) {
-						ht[t] = p1.y + (*h - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
-						break;
-					}
-				}
+				height_t result = curves[t * num_heights + (*h - h_min)];
+				if (result != _invalid_height) ht[t] = result;
 			}
 
 			/* Apply interpolation of curve map results. */
 			*h = (height_t)((ht[corner_a] * yri + ht[corner_b] * yr) * xri + (ht[corner_c] * yri + ht[corner_d] * yr) * xr);
 		}
 	}
+
+	free(gx1);
+	free(gx2);
+	free(gxr);
+	free(curves);
 }
 
 /** Adjusts heights in height map to contain required amount of water tiles */
@@ -0,0 +1,462 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file jobs.cpp Running independent jobs on a fixed set of worker threads. */
+
+#include "../stdafx.h"
+#include "../core/alloc_func.hpp"
+#include "../core/math_func.hpp"
+#include "thread.h"
+#include "jobs.h"
+
+/** The maximum number of threads of the job system, including the main thread. */
+static const uint MAX_JOB_THREADS = 16;
+
+/** A job that is waiting to be run. */
+struct Job {
+	JobProc proc;            ///< The procedure of a job that runs once, or NULL.
+	JobRangeProc range_proc; ///< The procedure of a job that handles a range, or NULL.
+	void *param;             ///< The parameter of the procedure.
+	uint first;              ///< The first index of the range.
+	uint last;               ///< The index after the last index of the range.
+	JobGroup *group;         ///< The group the job belongs to.
+
+	/**
+	 * Run the job and tell its group it is done.
+	 * @param arena The arena of the thread running the job.
+	 */
+	void Run(JobArena *arena) const
+	{
+		JobArena::Mark mark = arena->GetMark();
+		if (this->proc != NULL) {
+			this->proc(this->param, arena);
+		} else {
+			this->range_proc(this->param, this->first, this->last, arena);
+		}
+		arena->Release(mark);
+
+		this->group->Done();
+	}
+};
+
+/**
+ * The jobs of one thread. The thread itself adds and takes jobs at the
+ * back, so it works on the jobs it added last, of which the data is most
+ * likely still in its caches. Other threads that ran out of work steal
+ * from the front, so they take the oldest, and often largest, jobs.
+ */
+class JobQueue {
+	ThreadMutex *mutex; ///< Guards the queue.
+	Job *jobs;          ///< Ring buffer with the jobs.
+	uint capacity;      ///< The size of #jobs.
+	uint first;         ///< The position of the first job in #jobs.
+	uint count;         ///< The number of jobs in the queue.
+
+public:
+	JobQueue() : mutex(NULL), jobs(NULL), capacity(0), first(0), count(0) {}
+
+	~JobQueue()
+	{
+		free(this->jobs);
+		delete this->mutex;
+	}
+
+	/** Make the queue ready for use by more than one thread. */
+	void Initialize()
+	{
+		if (this->mutex == NULL) this->mutex = ThreadMutex::New();
+	}
+
+	/**
+	 * Add a job at the back of the queue.
+	 * @param job The job to add.
+	 */
+	void PushBack(const Job &job)
+	{
+		this->mutex->BeginCritical();
+		if (this->count == this->capacity) {
+			uint capacity = max<uint>(16, this->capacity * 2);
+			Job *jobs = MallocT<Job>(capacity);
+			for (uint i = 0; i < this->count; i++) jobs[i] = this->jobs[(this->first + i) % this->capacity];
+			free(this->jobs);
+			this->jobs = jobs;
+			this->capacity = capacity;
+			this->first = 0;
+		}
+		this->jobs[(this->first + this->count) % this->capacity] = job;
+		this->count++;
+		this->mutex->EndCritical();
+	}
+
+	/**
+	 * Take a job from the back or the front of the queue.
+	 * @param job  Place to store the job in.
+	 * @param back Whether to take the job from the back.
+	 * @return True iff there was a job.
+	 */
+	bool Pop(Job *job, bool back)
+	{
+		this->mutex->BeginCritical();
+		bool found = this->count != 0;
+		if (found) {
+			this->count--;
+			if (back) {
+				*job = this->jobs[(this->first + this->count) % this->capacity];
+			} else {
+				*job = this->jobs[this->first];
+				this->first = (this->first + 1) % this->capacity;
+			}
+		}
+		this->mutex->EndCritical();
+		return found;
+	}
+};
+
+/** A thread of the job system. */
+struct JobThread {
+	JobQueue queue;       ///< The jobs added by this thread.
+	JobArena arena;       ///< The scratch memory of this thread.
+	ThreadObject *thread; ///< The worker thread, or NULL for the main thread.
+
+	JobThread(uint slot) : arena(slot), thread(NULL) {}
+};
+
+static JobThread *_job_threads[MAX_JOB_THREADS]; ///< The threads of the job system; the first one is the main thread.
+static uint _job_thread_count = 0;               ///< The number of threads running jobs, including the main thread; 0 when not started.
+static JobArena _job_main_arena(0);              ///< The arena of the main thread when there are no workers.
+
+/*
+ * The number of jobs that are queued and not reserved by a thread that is
+ * going to take one. Threads that want to take a job first reserve one,
+ * under #_job_mutex, so a thread that found nothing to reserve can sleep
+ * without missing jobs that are added at the same time.
+ */
+static ThreadMutex *_job_mutex = NULL; ///< Guards #_jobs_queued and #_jobs_exit, and wakes sleeping workers.
+static uint _jobs_queued = 0;          ///< The number of queued jobs that are not reserved.
+static bool _jobs_exit = false;        ///< Whether the workers have to stop.
+
+/**
+ * Reserve one of the queued jobs and take it from the queues.
+ * @param slot  The thread that takes the job.
+ * @param job   Place to store the job in.
+ * @param sleep Whether to wait for a job when there is none.
+ * @return True iff a job was taken; false when there was none, or when
+ *         the workers have to stop.
+ */
+static bool TakeJob(uint slot, Job *job, bool sleep)
+{
+	_job_mutex->BeginCritical();
+	while (sleep && _jobs_queued == 0 && !_jobs_exit) _job_mutex->WaitForSignal();
+	bool reserved = _jobs_queued != 0 && !(sleep && _jobs_exit);
+	if (reserved) _jobs_queued--;
+	_job_mutex->EndCritical();
+	if (!reserved) return false;
+
+	/* There is a job for us in one of the queues, though another thread
+	 * might just be taking the one we first see; then try again. */
+	for (;;) {
+		if (_job_threads[slot]->queue.Pop(job, true)) return true;
+		for (uint i = 1; i < _job_thread_count; i++) {
+			if (_job_threads[(slot + i) % _job_thread_count]->queue.Pop(job, false)) return true;
+		}
+	}
+}
+
+/**
+ * The main procedure of the worker threads: run jobs till told to stop.
+ * @param data The JobThread of the worker.
+ */
+static void JobWorkerThread(void *data)
+{
+	JobThread *self = (JobThread *)data;
+	Job job;
+	while (TakeJob(self->arena.slot, &job, true)) job.Run(&self->arena);
+}
+
+/**
+ * Start the worker threads of the job system.
+ * @param threads The number of threads to run jobs on, including the main
+ *                thread; with 1, or without threads, every job runs on the
+ *                thread that adds it.
+ * @note The number of threads must not change the outcome of any job, as
+ *       the game state has to be the same on every computer.
+ */
+void StartJobWorkers(uint threads)
+{
+	assert(_job_thread_count == 0);
+	threads = Clamp(threads, 1, MAX_JOB_THREADS);
+	if (threads == 1) return;
+
+	_job_mutex = ThreadMutex::New();
+	_jobs_exit = false;
+	_jobs_queued = 0;
+
+	_job_threads[0] = new JobThread(0);
+	_job_threads[0]->queue.Initialize();
+	_job_thread_count = 1;
+
+	/* Workers only look at the queues that exist when they look, so the
+	 * count is raised after the queue of a worker is there. */
+	for (uint i = 1; i < threads; i++) {
+		JobThread *jt = new JobThread(i);
+		jt->queue.Initialize();
+		_job_threads[i] = jt;
+		if (!ThreadObject::New(&JobWorkerThread, jt, &jt->thread)) {
+			delete jt;
+			_job_threads[i] = NULL;
+			break;
+		}
+		_job_thread_count = i + 1;
+	}
+
+	if (_job_thread_count == 1) {
+		/* No threads available; run the jobs on the main thread. */
+		delete _job_threads[0];
+		_job_threads[0] = NULL;
+		_job_thread_count = 0;
+		delete _job_mutex;
+		_job_mutex = NULL;
+	}
+}
+
+/**
+ * Stop the worker threads of the job system.
+ * @pre No jobs are queued or running.
+ */
+void StopJobWorkers()
+{
+	if (_job_thread_count == 0) return;
+
+	_job_mutex->BeginCritical();
+	_jobs_exit = true;
+	for (uint i = 1; i < _job_thread_count; i++) _job_mutex->SendSignal();
+	_job_mutex->EndCritical();
+
+	for (uint i = 1; i < _job_thread_count; i++) {
+		_job_threads[i]->thread->Join();
+		delete _job_threads[i]->thread;
+		delete _job_threads[i];
+		_job_threads[i] = NULL;
+	}
+	delete _job_threads[0];
+	_job_threads[0] = NULL;
+	_job_thread_count = 0;
+
+	delete _job_mutex;
+	_job_mutex = NULL;
+}
+
+/**
+ * Get the number of threads jobs are run on.
+ * @return The number of threads, including the main thread.
+ */
+uint GetJobThreadCount()
+{
+	return max<uint>(_job_thread_count, 1);
+}
+
+JobArena::~JobArena()
+{
+	for (uint i = 0; i < this->blocks.Length(); i++) free(this->blocks[i].data);
+}
+
+/**
+ * Allocate memory from the arena.
+ * @param size The number of bytes to allocate.
+ * @return The memory, aligned to 8 bytes; it lives till the job using the arena is done.
+ */
+void *JobArena::Allocate(size_t size)
+{
+	size = Align(size, 8);
+
+	Block *last = this->blocks.Length() == 0 ? NULL : this->blocks.End() - 1;
+	if (last == NULL || this->used + size > last->size) {
+		size_t block_size = max<size_t>(size, last == NULL ? 4096 : last->size * 2);
+		last = this->blocks.Append();
+		last->data = MallocT<byte>(block_size);
+		last->size = block_size;
+		this->used = 0;
+	}
+
+	void *ret = last->data + this->used;
+	this->used += size;
+	return ret;
+}
+
+/**
+ * Get the amount of memory the arena uses now.
+ * @return Where to return to with #Release.
+ */
+JobArena::Mark JobArena::GetMark() const
+{
+	Mark mark = { this->blocks.Length(), this->used };
+	return mark;
+}
+
+/**
+ * Release everything that was allocated after a mark was taken.
+ * @param mark The mark to return to.
+ */
+void JobArena::Release(const Mark &mark)
+{
+	if (mark.blocks == 0) {
+		if (this->blocks.Length() > 1) {
+			/* Replace the blocks by one that is large enough for all of
+			 * them, so the next job does not have to allocate again. */
+			size_t total = 0;
+			for (uint i = 0; i < this->blocks.Length(); i++) {
+				total += this->blocks[i].size;
+				free(this->blocks[i].data);
+			}
+			this->blocks.Clear();
+			Block *block = this->blocks.Append();
+			block->data = MallocT<byte>(total);
+			block->size = total;
+		}
+		this->used = 0;
+		return;
+	}
+
+	while (this->blocks.Length() > mark.blocks) {
+		free(this->blocks[this->blocks.Length() - 1].data);
+		this->blocks.Erase(this->blocks.End() - 1);
+	}
+	this->used = mark.used;
+}
+
+/**
+ * Make a group of jobs.
+ * @param arena The arena of the job that makes the group, or NULL when the
+ *              group is made outside of a job, on the main thread.
+ */
+JobGroup::JobGroup(JobArena *arena) : mutex(NULL), pending(0)
+{
+	if (arena == NULL) arena = _job_thread_count == 0 ? &_job_main_arena : &_job_threads[0]->arena;
+	this->arena = arena;
+	if (_job_thread_count != 0) this->mutex = ThreadMutex::New();
+}
+
+/** Wait for the jobs that are not done yet, and free the group. */
+JobGroup::~JobGroup()
+{
+	this->Wait();
+	delete this->mutex;
+}
+
+/**
+ * Queue a job of the group, or run it directly when there are no workers.
+ * @param job The job.
+ */
+void JobGroup::Add(const Job &job)
+{
+	if (this->mutex == NULL) {
+		this->pending++;
+		job.Run(this->arena);
+		return;
+	}
+
+	this->mutex->BeginCritical();
+	this->pending++;
+	this->mutex->EndCritical();
+
+	_job_threads[this->arena->slot]->queue.PushBack(job);
+
+	_job_mutex->BeginCritical();
+	_jobs_queued++;
+	_job_mutex->SendSignal();
+	_job_mutex->EndCritical();
+}
+
+/** Tell the group one of its jobs is done. */
+void JobGroup::Done()
+{
+	if (this->mutex == NULL) {
+		this->pending--;
+		return;
+	}
+
+	this->mutex->BeginCritical();
+	this->pending--;
+	this->mutex->SendSignal();
+	this->mutex->EndCritical();
+}
+
+/**
+ * Add a job that runs once to the group.
+ * @param proc  The procedure of the job.
+ * @param param The parameter for the procedure.
+ */
+void JobGroup::Add(JobProc proc, void *param)
+{
+	Job job = { proc, NULL, param, 0, 0, this };
+	this->Add(job);
+}
+
+/**
+ * Add a job that handles a range of indices to the group.
+ * @param proc  The procedure of the job.
+ * @param param The parameter for the procedure.
+ * @param first The first index of the range.
+ * @param last  The index after the last index of the range.
+ */
+void JobGroup::Add(JobRangeProc proc, void *param, uint first, uint last)
+{
+	Job job = { NULL, proc, param, first, last, this };
+	this->Add(job);
+}
+
+/**
+ * Wait till all jobs of the group are done. While waiting the thread runs
+ * queued jobs itself, of this group or of any other.
+ */
+void JobGroup::Wait()
+{
+	if (this->mutex == NULL) return;
+
+	for (;;) {
+		this->mutex->BeginCritical();
+		bool done = this->pending == 0;
+		this->mutex->EndCritical();
+		if (done) return;
+
+		Job job;
+		if (TakeJob(this->arena->slot, &job, false)) {
+			job.Run(this->arena);
+			continue;
+		}
+
+		/* Nothing left to take, so the remaining jobs of the group are
+		 * running; sleep till one is done, as it might add more jobs. */
+		this->mutex->BeginCritical();
+		if (this->pending != 0) this->mutex->WaitForSignal();
+		this->mutex->EndCritical();
+	}
+}
+
+/**
+ * Handle a range of indices in chunks, spread over the threads of the job
+ * system, and wait till all chunks are done. The chunks only depend on
+ * \a count and \a chunk, never on the number of threads, so anything that
+ * is calculated per chunk is the same on every computer.
+ * @param count The number of indices.
+ * @param chunk The number of indices per chunk.
+ * @param proc  The procedure handling one chunk.
+ * @param param The parameter for the procedure.
+ * @param arena The arena of the job calling this, or NULL outside of a job.
+ */
+void ParallelFor(uint count, uint chunk, JobRangeProc proc, void *param, JobArena *arena)
+{
+	assert(chunk > 0);
+
+	JobGroup group(arena);
+	for (uint first = 0; first < count; first += chunk) {
+		group.Add(proc, param, first, min(first + chunk, count));
+	}
+	group.Wait();
+}
@@ -0,0 +1,112 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file jobs.h Running independent jobs on a fixed set of worker threads. */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "../core/smallvec_type.hpp"
+
+class ThreadMutex;
+struct Job;
+
+/**
+ * Scratch memory of one thread of the job system. Every job gets the
+ * arena of the thread that runs it; what the job allocates from it is
+ * released when the job is done, but the memory is kept for the next job,
+ * so jobs do not have to allocate and free their temporary buffers.
+ */
+class JobArena {
+	/** A piece of memory that is allocated from. */
+	struct Block {
+		byte *data;  ///< The memory of the block.
+		size_t size; ///< The size of the block.
+	};
+
+	SmallVector<Block, 4> blocks; ///< The blocks; the last one is allocated from.
+	size_t used;                  ///< The bytes used of the last block.
+
+public:
+	/** The amount of memory in use at some moment, to return to later. */
+	struct Mark {
+		uint blocks; ///< The number of blocks at that moment.
+		size_t used; ///< The bytes used of the last block at that moment.
+	};
+
+	const uint slot; ///< The thread of the job system this arena belongs to; 0 for the main thread.
+
+	JobArena(uint slot) : used(0), slot(slot) {}
+	~JobArena();
+
+	void *Allocate(size_t size);
+
+	/**
+	 * Allocate an array from the arena.
+	 * @param count The number of items of the array.
+	 * @return The uninitialised array; it lives till the job using the arena is done.
+	 */
+	template <typename T>
+	FORCEINLINE T *Allocate(size_t count)
+	{
+		return (T *)this->Allocate(count * sizeof(T));
+	}
+
+	Mark GetMark() const;
+	void Release(const Mark &mark);
+};
+
+/**
+ * A job that runs once.
+ * @param param The parameter given when the job was added.
+ * @param arena The scratch memory of the thread running the job.
+ */
+typedef void (*JobProc)(void *param, JobArena *arena);
+
+/**
+ * A job that handles a range of indices.
+ * @param param The parameter given when the job was added.
+ * @param first The first index of the range.
+ * @param last  The index after the last index of the range.
+ * @param arena The scratch memory of the thread running the job.
+ */
+typedef void (*JobRangeProc)(void *param, uint first, uint last, JobArena *arena);
+
+/**
+ * A group of jobs that can be waited for. The jobs of a group may run in
+ * any order and at the same time, so they must not depend on each other.
+ * Jobs themselves may make groups as well, as long as they pass their own
+ * arena to them.
+ */
+class JobGroup {
+	friend struct Job;
+
+	JobArena *arena;    ///< The arena of the thread that made the group.
+	ThreadMutex *mutex; ///< Guards #pending.
+	uint pending;       ///< The number of jobs that are not done yet.
+
+	void Add(const Job &job);
+	void Done();
+
+public:
+	JobGroup(JobArena *arena = NULL);
+	~JobGroup();
+
+	void Add(JobProc proc, void *param);
+	void Add(JobRangeProc proc, void *param, uint first, uint last);
+	void Wait();
+};
+
+void ParallelFor(uint count, uint chunk, JobRangeProc proc, void *param, JobArena *arena = NULL);
+
+void StartJobWorkers(uint threads);
+void StopJobWorkers();
+uint GetJobThreadCount();
+
+#endif /* JOBS_H */
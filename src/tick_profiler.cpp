@@ -0,0 +1,275 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_profiler.cpp Measuring the time spent in the different stages of the game loop. */
+
+#include "stdafx.h"
+#include "tick_profiler.h"
+#include "console_func.h"
+#include "core/alloc_func.hpp"
+#include "core/mem_func.hpp"
+#include "string_func.h"
+#include "timeline.h"
+
+#ifdef WITH_ALLOC_PROFILING
+#include <new>
+#endif
+
+/** Number of samples the rolling average and peak are calculated over. */
+static const uint TICK_PROFILER_SAMPLES = 128;
+
+/** Measurements of a single stage of the game loop. */
+struct TickProfilerData {
+	CPerformanceTimer timer;                ///< Timer of the currently running sample.
+	uint64 samples[TICK_PROFILER_SAMPLES];  ///< The last samples, in rdtsc cycles.
+	uint pos;                               ///< Position in #samples the next sample is written to.
+	uint count;                             ///< Total number of samples taken.
+	uint64 peak;                            ///< Highest sample ever taken.
+	uint64 total;                           ///< Sum of all samples ever taken.
+#ifdef WITH_TIMELINE
+	uint64 timeline_start;                  ///< Time the running sample started, for the timeline.
+#endif
+#ifdef WITH_ALLOC_PROFILING
+	TickProfilerElement alloc_parent;       ///< The element allocations were counted for before the running sample started.
+#endif
+	uint64 deferred;                        ///< Total amount of work that was postponed to a later tick.
+};
+
+#ifdef WITH_ALLOC_PROFILING
+/** Allocations done while an element was the innermost running one. */
+struct AllocProfilerData {
+	uint64 count; ///< Number of allocations.
+	uint64 bytes; ///< Number of bytes requested.
+};
+
+/** The allocations per element; the last one is for allocations outside of the game loop. */
+static AllocProfilerData _alloc_profiler[TPE_END + 1];
+/** The innermost running element, TPE_END when outside of the game loop. */
+static TickProfilerElement _alloc_profiler_elem = TPE_END;
+
+/**
+ * Count an allocation for the innermost running element of the game loop.
+ * Other threads are counted for the element the main thread is running.
+ * @param size The number of bytes that are allocated.
+ */
+void AllocProfilerCount(size_t size)
+{
+	_alloc_profiler[_alloc_profiler_elem].count++;
+	_alloc_profiler[_alloc_profiler_elem].bytes += size;
+}
+
+void *operator new(size_t size) throw(std::bad_alloc)
+{
+	AllocProfilerCount(size);
+	void *p = malloc(size);
+	if (p == NULL) MallocError(size);
+	return p;
+}
+
+void *operator new[](size_t size) throw(std::bad_alloc)
+{
+	AllocProfilerCount(size);
+	void *p = malloc(size);
+	if (p == NULL) MallocError(size);
+	return p;
+}
+
+void operator delete(void *p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+	free(p);
+}
+#endif /* WITH_ALLOC_PROFILING */
+
+/** Names of the elements, as shown in the console. */
+static const char * const _tick_profiler_names[] = {
+	"game loop",
+	"  animated tiles",
+	"  date",
+	"    daily loop",
+	"    monthly loop",
+	"    yearly loop",
+	"  tile loop",
+	"  vehicles",
+	"  landscape",
+	"    towns",
+	"    industries",
+	"  AI",
+	"  windows",
+	"  news",
+};
+assert_compile(lengthof(_tick_profiler_names) == TPE_END);
+
+static TickProfilerData _tick_profiler[TPE_END]; ///< The measurements of all elements.
+
+/**
+ * Start a sample of the given element.
+ * @param elem The element to start measuring.
+ */
+void TickProfilerStart(TickProfilerElement elem)
+{
+	_tick_profiler[elem].timer.Start();
+#ifdef WITH_TIMELINE
+	_tick_profiler[elem].timeline_start = _timeline_recording ? TimelineGetTime() : 0;
+#endif
+#ifdef WITH_ALLOC_PROFILING
+	_tick_profiler[elem].alloc_parent = _alloc_profiler_elem;
+	_alloc_profiler_elem = elem;
+#endif
+}
+
+/**
+ * Stop the sample of the given element and add it to the statistics.
+ * @param elem The element to stop measuring.
+ */
+void TickProfilerStop(TickProfilerElement elem)
+{
+	TickProfilerData *data = &_tick_profiler[elem];
+	data->timer.Stop();
+
+	uint64 sample = data->timer.m_acc;
+	data->timer.m_acc = 0;
+
+	data->samples[data->pos] = sample;
+	data->pos = (data->pos + 1) % TICK_PROFILER_SAMPLES;
+	data->count++;
+	data->peak = max(data->peak, sample);
+	data->total += sample;
+
+#ifdef WITH_TIMELINE
+	if (data->timeline_start != 0) {
+		/* Skip the indentation of the name. */
+		const char *name = _tick_profiler_names[elem];
+		while (*name == ' ') name++;
+		TimelineRecord(name, data->timeline_start, 0);
+	}
+#endif
+#ifdef WITH_ALLOC_PROFILING
+	_alloc_profiler_elem = data->alloc_parent;
+#endif
+}
+
+/**
+ * Record that some work of the given element was postponed to a later tick.
+ * @param elem   The element that postponed the work.
+ * @param amount The number of postponed work items.
+ */
+void TickProfilerAddDeferred(TickProfilerElement elem, uint amount)
+{
+	_tick_profiler[elem].deferred += amount;
+}
+
+/** Forget all measurements. */
+void TickProfilerReset()
+{
+	MemSetT(_tick_profiler, 0, lengthof(_tick_profiler));
+#ifdef WITH_ALLOC_PROFILING
+	MemSetT(_alloc_profiler, 0, lengthof(_alloc_profiler));
+#endif
+}
+
+/**
+ * Get the average and the peak over the last samples of an element.
+ * @param data    The element to get the statistics of.
+ * @param average Is set to the average of the last samples.
+ * @param peak    Is set to the highest of the last samples.
+ */
+static void GetRollingStatistics(const TickProfilerData *data, uint64 *average, uint64 *peak)
+{
+	uint num = min(data->count, TICK_PROFILER_SAMPLES);
+	uint64 sum = 0;
+	*peak = 0;
+	for (uint i = 0; i < num; i++) {
+		sum += data->samples[i];
+		*peak = max(*peak, data->samples[i]);
+	}
+	*average = (num == 0) ? 0 : sum / num;
+}
+
+/**
+ * Write the collected measurements as 'key=value' lines, one line per
+ * statistic, so they can be read by scripts.
+ * @param f The file to write to.
+ */
+void TickProfilerWrite(FILE *f)
+{
+	for (TickProfilerElement elem = TPE_GAMELOOP; elem < TPE_END; elem++) {
+		const TickProfilerData *data = &_tick_profiler[elem];
+
+		/* Turn the name into an identifier: no indentation and no spaces. */
+		char key[32];
+		const char *name = _tick_profiler_names[elem];
+		while (*name == ' ') name++;
+		strecpy(key, name, lastof(key));
+		for (char *c = key; *c != '\0'; c++) {
+			if (*c == ' ') *c = '_';
+		}
+
+		uint64 average = (data->count == 0) ? 0 : data->total / data->count;
+
+		fprintf(f, "stage.%s.samples=%u\n", key, data->count);
+		fprintf(f, "stage.%s.average_kcycles=%u\n", key, (uint)(average / 1000));
+		fprintf(f, "stage.%s.total_kcycles=" OTTD_PRINTF64 "\n", key, (int64)(data->total / 1000));
+		fprintf(f, "stage.%s.peak_kcycles=%u\n", key, (uint)(data->peak / 1000));
+		if (data->deferred != 0) fprintf(f, "stage.%s.deferred=%u\n", key, (uint)data->deferred);
+#ifdef WITH_ALLOC_PROFILING
+		fprintf(f, "stage.%s.allocations=" OTTD_PRINTF64 "\n", key, (int64)_alloc_profiler[elem].count);
+		fprintf(f, "stage.%s.allocated_bytes=" OTTD_PRINTF64 "\n", key, (int64)_alloc_profiler[elem].bytes);
+#endif
+	}
+}
+
+/** Print the collected measurements to the console. */
+void TickProfilerPrint()
+{
+	uint64 loop_average, loop_peak;
+	GetRollingStatistics(&_tick_profiler[TPE_GAMELOOP], &loop_average, &loop_peak);
+
+	IConsolePrintF(CC_DEFAULT, "Game loop timings in kilocycles; average and peak over the last %u samples:", TICK_PROFILER_SAMPLES);
+	IConsolePrintF(CC_DEFAULT, "  %-20s %10s %10s %10s %10s %6s", "stage", "average", "peak", "all-time", "samples", "share");
+
+	for (TickProfilerElement elem = TPE_GAMELOOP; elem < TPE_END; elem++) {
+		const TickProfilerData *data = &_tick_profiler[elem];
+
+		uint64 average, peak;
+		GetRollingStatistics(data, &average, &peak);
+
+		/* The share only makes sense for the stages that run every tick. */
+		bool per_tick = elem != TPE_DAILY_LOOP && elem != TPE_MONTHLY_LOOP && elem != TPE_YEARLY_LOOP;
+		uint share = (per_tick && loop_average != 0) ? (uint)(average * 100 / loop_average) : 0;
+
+		IConsolePrintF(elem == TPE_GAMELOOP ? CC_WHITE : CC_DEFAULT, "  %-20s %10u %10u %10u %10u %5u%%",
+				_tick_profiler_names[elem], (uint)(average / 1000), (uint)(peak / 1000), (uint)(data->peak / 1000), data->count, share);
+	}
+
+	for (TickProfilerElement elem = TPE_GAMELOOP; elem < TPE_END; elem++) {
+		const TickProfilerData *data = &_tick_profiler[elem];
+		if (data->deferred == 0) continue;
+
+		/* Skip the indentation of the name. */
+		const char *name = _tick_profiler_names[elem];
+		while (*name == ' ') name++;
+		IConsolePrintF(CC_DEFAULT, "  %s: %u work items deferred to later ticks", name, (uint)data->deferred);
+	}
+
+#ifdef WITH_ALLOC_PROFILING
+	uint ticks = max(_tick_profiler[TPE_GAMELOOP].count, 1U);
+	IConsolePrint(CC_DEFAULT, "Allocations per tick, counted for the innermost running stage:");
+	IConsolePrintF(CC_DEFAULT, "  %-20s %10s %10s %10s", "stage", "count", "bytes", "total");
+	for (uint i = TPE_GAMELOOP; i <= TPE_END; i++) {
+		const AllocProfilerData *alloc = &_alloc_profiler[i];
+		IConsolePrintF(CC_DEFAULT, "  %-20s %10u %10u %10u", i == TPE_END ? "outside game loop" : _tick_profiler_names[i],
+				(uint)(alloc->count / ticks), (uint)(alloc->bytes / ticks), (uint)alloc->count);
+	}
+#endif /* WITH_ALLOC_PROFILING */
+}
@@ -0,0 +1,60 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_profiler.h Measuring the time spent in the different stages of the game loop. */
+
+#ifndef TICK_PROFILER_H
+#define TICK_PROFILER_H
+
+#include "core/enum_type.hpp"
+#include "pathfinder/pf_performance_timer.hpp"
+
+/** The stages of the game loop that are measured. */
+enum TickProfilerElement {
+	TPE_GAMELOOP,        ///< The whole of StateGameLoop
+	TPE_ANIMATED_TILES,  ///< AnimateAnimatedTiles
+	TPE_DATE,            ///< IncreaseDate, including the daily, monthly and yearly loops
+	TPE_DAILY_LOOP,      ///< The handlers called when a new day starts
+	TPE_MONTHLY_LOOP,    ///< The handlers called when a new month starts
+	TPE_YEARLY_LOOP,     ///< The handlers called when a new year starts
+	TPE_TILE_LOOP,       ///< RunTileLoop
+	TPE_VEHICLES,        ///< CallVehicleTicks
+	TPE_LANDSCAPE,       ///< CallLandscapeTick, including towns and industries
+	TPE_TOWNS,           ///< OnTick_Town
+	TPE_INDUSTRIES,      ///< OnTick_Industry
+	TPE_AI,              ///< AI::GameLoop
+	TPE_WINDOWS,         ///< CallWindowTickEvent
+	TPE_NEWS,            ///< NewsLoop
+	TPE_END,             ///< End marker
+};
+DECLARE_POSTFIX_INCREMENT(TickProfilerElement)
+
+void TickProfilerStart(TickProfilerElement elem);
+void TickProfilerStop(TickProfilerElement elem);
+void TickProfilerAddDeferred(TickProfilerElement elem, uint amount);
+void TickProfilerReset();
+void TickProfilerPrint();
+void TickProfilerWrite(FILE *f);
+
+/** Measure the lifetime of this object as one sample of the given element. */
+struct TickProfilerScope {
+	TickProfilerElement elem; ///< The element this scope is measured in.
+
+	FORCEINLINE TickProfilerScope(TickProfilerElement elem) : elem(elem)
+	{
+		TickProfilerStart(this->elem);
+	}
+
+	FORCEINLINE ~TickProfilerScope()
+	{
+		TickProfilerStop(this->elem);
+	}
+};
+
+#endif /* TICK_PROFILER_H */
@@ -0,0 +1,135 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file timeline.cpp Recording when zones of code run, to see stalls of single frames in one timeline. */
+
+#include "stdafx.h"
+
+#ifdef WITH_TIMELINE
+
+#include "timeline.h"
+#include "fileio_func.h"
+#include "thread/thread.h"
+#include "debug.h"
+
+#if defined(WIN32)
+#	include <windows.h>
+#else
+#	if defined(UNIX) && !defined(__OS2__) && !defined(__MORPHOS__) && !defined(__AMIGA__)
+#		include <pthread.h>
+#		define TIMELINE_PTHREAD
+#	endif
+#endif
+
+/** Number of zones that are kept; when there are more the oldest are overwritten. */
+static const uint TIMELINE_EVENTS = 1 << 16;
+
+/** A zone that has been recorded. */
+struct TimelineEvent {
+	const char *name; ///< Name of the zone.
+	uint64 start;     ///< Start of the zone in microseconds.
+	uint32 duration;  ///< Duration of the zone in microseconds.
+	uint32 arg;       ///< Extra value shown with the zone.
+	uint thread;      ///< Identifier of the thread the zone ran in.
+};
+
+bool _timeline_recording = false;                     ///< Whether zones are recorded at the moment.
+static TimelineEvent _timeline_events[TIMELINE_EVENTS]; ///< The ring buffer with the recorded zones.
+static uint _timeline_pos;                            ///< Position in the ring buffer the next zone is written to.
+static bool _timeline_wrapped;                        ///< Whether the ring buffer has been filled once already.
+static ThreadMutex *_timeline_mutex = NULL;           ///< Serialises recording zones of different threads.
+
+/** @return The identifier of the current thread. */
+static uint GetThreadIdentifier()
+{
+#if defined(WIN32)
+	return GetCurrentThreadId();
+#elif defined(TIMELINE_PTHREAD)
+	return (uint)(size_t)pthread_self();
+#else
+	return 0;
+#endif
+}
+
+/** @return The current time in microseconds. */
+uint64 TimelineGetTime()
+{
+	return GetMonotonicTime() / 1000;
+}
+
+/**
+ * Record a zone that ends now.
+ * @param name  The name of the zone.
+ * @param start The time the zone started.
+ * @param arg   Extra value to show with the zone.
+ */
+void TimelineRecord(const char *name, uint64 start, uint32 arg)
+{
+	uint64 end = TimelineGetTime();
+
+	_timeline_mutex->BeginCritical();
+	TimelineEvent *ev = &_timeline_events[_timeline_pos];
+	ev->name = name;
+	ev->start = start;
+	ev->duration = (uint32)(end - start);
+	ev->arg = arg;
+	ev->thread = GetThreadIdentifier();
+
+	_timeline_pos++;
+	if (_timeline_pos == TIMELINE_EVENTS) {
+		_timeline_pos = 0;
+		_timeline_wrapped = true;
+	}
+	_timeline_mutex->EndCritical();
+}
+
+/** Forget the recorded zones and start recording new ones. */
+void TimelineStart()
+{
+	if (_timeline_mutex == NULL) _timeline_mutex = ThreadMutex::New();
+	_timeline_pos = 0;
+	_timeline_wrapped = false;
+	_timeline_recording = true;
+}
+
+/** Stop recording zones; the recorded ones are kept so they can be dumped. */
+void TimelineStop()
+{
+	_timeline_recording = false;
+}
+
+/**
+ * Write the recorded zones in the JSON format of Chrome's trace viewer.
+ * @param filename Name of the file in the autosave directory.
+ * @return True iff the file could be written.
+ * @pre Zones are not being recorded.
+ */
+bool TimelineDump(const char *filename)
+{
+	assert(!_timeline_recording);
+
+	FILE *f = FioFOpenFile(filename, "w", AUTOSAVE_DIR);
+	if (f == NULL) return false;
+
+	fprintf(f, "{\"traceEvents\":[\n");
+
+	uint first = _timeline_wrapped ? _timeline_pos : 0;
+	uint num = _timeline_wrapped ? TIMELINE_EVENTS : _timeline_pos;
+	for (uint i = 0; i < num; i++) {
+		const TimelineEvent *ev = &_timeline_events[(first + i) % TIMELINE_EVENTS];
+		fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":" OTTD_PRINTF64 ",\"dur\":%u,\"args\":{\"value\":%u}}\n",
+				i == 0 ? "" : ",", ev->name, ev->thread, (int64)ev->start, ev->duration, ev->arg);
+	}
+
+	fprintf(f, "]}\n");
+	FioFCloseFile(f);
+	return true;
+}
+
+#endif /* WITH_TIMELINE */
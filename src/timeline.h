@@ -0,0 +1,54 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file timeline.h Recording when zones of code run, to see stalls of single frames in one timeline. */
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#ifdef WITH_TIMELINE
+
+extern bool _timeline_recording;
+
+uint64 TimelineGetTime();
+void TimelineRecord(const char *name, uint64 start, uint32 arg);
+void TimelineStart();
+void TimelineStop();
+bool TimelineDump(const char *filename);
+
+/**
+ * Record the lifetime of this object as a zone in the timeline.
+ * @note \a name is not copied, so it should be a string literal.
+ */
+struct TimelineZone {
+	const char *name; ///< Name of the zone.
+	uint32 arg;       ///< Extra value shown with the zone, like a chunk ID.
+	uint64 start;     ///< Time the zone started, 0 when not recording.
+
+	FORCEINLINE TimelineZone(const char *name, uint32 arg = 0) : name(name), arg(arg), start(_timeline_recording ? TimelineGetTime() : 0) {}
+
+	FORCEINLINE ~TimelineZone()
+	{
+		if (this->start != 0) TimelineRecord(this->name, this->start, this->arg);
+	}
+};
+
+/** Record the rest of the current block as a zone with the given name. */
+#define TIMELINE_ZONE(name) TimelineZone _timeline_zone_(name)
+/** Record the rest of the current block as a zone with the given name and extra value. */
+#define TIMELINE_ZONE_ARG(name, arg) TimelineZone _timeline_zone_(name, arg)
+
+#else
+
+#define TIMELINE_ZONE(name)
+#define TIMELINE_ZONE_ARG(name, arg)
+
+#endif /* WITH_TIMELINE */
+
+#endif /* TIMELINE_H */
@@ -119,6 +119,25 @@ static void FillTimetableArrivalDepartureTable(const Vehicle *v, VehicleOrderID
 	VehicleOrderID i = start;
 	const Order *order = v->GetOrder(i);
 
+	const OrderList *list = v->orders.list;
+	if (list->IsCompleteTimetable() && !list->HasConditionalOrders()) {
+		/* The time taken by every order is known, so the times follow directly
+		 * from when the orders start in the timetable. */
+		Ticks total = list->GetTimetableDurationIncomplete();
+		Ticks start_offset = list->GetTimetableOffset(start);
+		/* When loading at the start order its travelling is already done. */
+		Ticks base = travelling ? offset : offset - order->travel_time;
+
+		VehicleOrderID j = 0;
+		for (const Order *o = list->GetFirstOrder(); o != NULL; o = o->next, j++) {
+			Ticks since_start = (list->GetTimetableOffset(j) - start_offset + total) % total;
+			table[j].arrival = base + since_start + o->travel_time;
+			table[j].departure = table[j].arrival + o->wait_time;
+		}
+		if (!travelling) table[start].arrival += total;
+		return;
+	}
+
 	/* Pre-initialize with unknown time */
 	for (int i = 0; i < v->GetNumOrders(); ++i) {
 		table[i].arrival = table[i].departure = INVALID_TICKS;
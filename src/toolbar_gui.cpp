@@ -563,11 +563,11 @@ static void MenuClickIndustry(int index)
 
 static void ToolbarVehicleClick(Window *w, VehicleType veh)
 {
-	const Vehicle *v;
+	const Company *c;
 	int dis = ~0;
 
-	FOR_ALL_VEHICLES(v) {
-		if (v->type == veh && v->IsPrimaryVehicle()) ClrBit(dis, v->owner);
+	FOR_ALL_COMPANIES(c) {
+		if (c->num_vehicles[veh] != 0) ClrBit(dis, c->index);
 	}
 	PopupMainCompanyToolbMenu(w, TBN_VEHICLESTART + veh, dis);
 }
@@ -758,7 +758,7 @@ static void MenuClickNewspaper(int index)
 
 static void ToolbarHelpClick(Window *w)
 {
-	PopupMainToolbMenu(w, TBN_HELP, STR_ABOUT_MENU_LAND_BLOCK_INFO, _settings_client.gui.newgrf_developer_tools ? 8 : 7);
+	PopupMainToolbMenu(w, TBN_HELP, STR_ABOUT_MENU_LAND_BLOCK_INFO, _settings_client.gui.newgrf_developer_tools ? 9 : 7);
 }
 
 static void MenuClickSmallScreenshot()
@@ -781,6 +781,7 @@ static void MenuClickHelp(int index)
 		case 5: MenuClickWorldScreenshot(); break;
 		case 6: ShowAboutWindow();          break;
 		case 7: ShowSpriteAlignerWindow();  break;
+		case 8: ShowNewGRFProfileWindow();  break;
 	}
 }
 
@@ -109,6 +109,10 @@ struct Town : TownPool::PoolItem<&_town_pool> {
 	/* NOSAVE: UpdateTownRadius updates this given the house count. */
 	uint32 squared_town_zone_radius[HZB_END];
 
+	/* NOSAVE: UpdateTownRadius updates this too; a tile is in at least zone i when
+	 * its squared distance to the town centre is below town_zone_limit[i]. */
+	uint32 town_zone_limit[HZB_END];
+
 	/* NOSAVE: The number of each type of building in the town. */
 	BuildingCounts<uint16> building_counts;
 
@@ -189,6 +193,7 @@ Town *CalcClosestTownFromTile(TileIndex tile, uint threshold = UINT_MAX);
 #define FOR_ALL_TOWNS(var) FOR_ALL_TOWNS_FROM(var, 0)
 
 void ResetHouses();
+void InvalidateHouseCandidates();
 
 void ClearTownHouse(Town *t, TileIndex tile);
 void UpdateTownMaxPass(Town *t);
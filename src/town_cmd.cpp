@@ -36,6 +36,7 @@
 #include "cheat_type.h"
 #include "functions.h"
 #include "animated_tile_func.h"
+#include "station_func.h"
 #include "date_func.h"
 #include "subsidy_func.h"
 #include "core/smallmap_type.hpp"
@@ -45,6 +46,7 @@
 #include "townname_type.h"
 #include "core/random_func.hpp"
 #include "core/backup_type.hpp"
+#include "tick_profiler.h"
 
 #include "table/strings.h"
 #include "table/town_land.h"
@@ -57,12 +59,104 @@ TownID _new_town_id;
 TownPool _town_pool("Town");
 INSTANTIATE_POOL_METHODS(Town)
 
+/*
+ * Spatial index of the towns, used to find the closest town without looking
+ * at every town. The map is divided in square cells and every cell has a list
+ * of the towns that have their centre in it. The cells are sized so there is
+ * about one town per cell; the index is rebuilt when the number of towns has
+ * changed too much for the current cell size.
+ */
+static const uint MIN_TOWN_INDEX_CELL_BITS = 3; ///< Cells are at least 8x8 tiles.
+
+static SmallVector<Town *, 2> *_town_index = NULL; ///< The cells with the towns in them.
+static bool _town_index_valid = false;            ///< Whether #_town_index is up to date.
+static uint _town_index_cell_bits;                ///< Size of the cells, as power of 2.
+static uint _town_index_size_x;                   ///< Number of cells along the X axis.
+static uint _town_index_size_y;                   ///< Number of cells along the Y axis.
+static uint _town_index_num_towns;                ///< Number of towns when the index was built.
+static uint _town_index_count;                    ///< Number of towns currently in the index.
+static uint _town_index_map_size;                 ///< Size of the map the index was built for.
+
+/** Make sure the town index is rebuilt before it is used next. */
+static void InvalidateTownIndex()
+{
+	_town_index_valid = false;
+}
+
+/**
+ * Get the cell of the town index a tile is in.
+ * @param tile The tile to get the cell for.
+ * @return The cell.
+ */
+static inline SmallVector<Town *, 2> *GetTownIndexCell(TileIndex tile)
+{
+	return &_town_index[(TileY(tile) >> _town_index_cell_bits) * _town_index_size_x + (TileX(tile) >> _town_index_cell_bits)];
+}
+
+/** Recreate the town index from scratch, choosing the cell size for the current number of towns. */
+static void RebuildTownIndex()
+{
+	delete[] _town_index;
+
+	uint num_towns = (uint)Town::GetNumItems();
+	uint tiles_per_town = MapSize() / max(num_towns, 1U);
+
+	/* Cells of about tiles_per_town tiles, but never larger than the map. */
+	_town_index_cell_bits = Clamp((FindLastBit(tiles_per_town) + 1) / 2, MIN_TOWN_INDEX_CELL_BITS, min(MapLogX(), MapLogY()));
+	_town_index_size_x = MapSizeX() >> _town_index_cell_bits;
+	_town_index_size_y = MapSizeY() >> _town_index_cell_bits;
+	_town_index = new SmallVector<Town *, 2>[_town_index_size_x * _town_index_size_y];
+
+	Town *t;
+	FOR_ALL_TOWNS(t) *GetTownIndexCell(t->xy)->Append() = t;
+
+	_town_index_count = num_towns;
+	_town_index_num_towns = max(num_towns, 1U);
+	_town_index_map_size = MapSize();
+	_town_index_valid = true;
+}
+
+/**
+ * Add a town to the town index.
+ * @param t The town to add; its location must be set.
+ */
+static void AddTownToIndex(Town *t)
+{
+	if (!_town_index_valid) return;
+
+	/* Too many towns per cell; start over with smaller cells. */
+	if (Town::GetNumItems() > 2 * _town_index_num_towns) {
+		InvalidateTownIndex();
+		return;
+	}
+
+	if (GetTownIndexCell(t->xy)->Include(t)) _town_index_count++;
+}
+
+/**
+ * Remove a town from the town index.
+ * @param t The town to remove.
+ */
+static void RemoveTownFromIndex(Town *t)
+{
+	if (!_town_index_valid || t->xy == INVALID_TILE) return;
+
+	SmallVector<Town *, 2> *cell = GetTownIndexCell(t->xy);
+	Town **entry = cell->Find(t);
+	if (entry != cell->End()) {
+		cell->Erase(entry);
+		_town_index_count--;
+	}
+}
+
 Town::~Town()
 {
 	free(this->name);
 
 	if (CleaningPool()) return;
 
+	RemoveViewportSignFromIndex(VSK_TOWN, this->index, &this->sign);
+
 	Industry *i;
 
 	/* Delete town authority window
@@ -101,6 +195,8 @@ Town::~Town()
 	DeleteNewGRFInspectWindow(GSF_FAKE_TOWNS, this->index);
 	CargoPacket::InvalidateAllFrom(ST_TOWN, this->index);
 	MarkWholeScreenDirty();
+
+	RemoveTownFromIndex(this);
 }
 
 
@@ -344,8 +440,10 @@ void Town::UpdateVirtCoord()
 	Point pt = RemapCoords2(TileX(this->xy) * TILE_SIZE, TileY(this->xy) * TILE_SIZE);
 	SetDParam(0, this->index);
 	SetDParam(1, this->population);
+	RemoveViewportSignFromIndex(VSK_TOWN, this->index, &this->sign);
 	this->sign.UpdatePosition(pt.x, pt.y - 24,
 		_settings_client.gui.population_in_label ? STR_VIEWPORT_TOWN_POP : STR_VIEWPORT_TOWN);
+	AddViewportSignToIndex(VSK_TOWN, this->index, &this->sign);
 
 	SetWindowDirty(WC_TOWN_VIEW, this->index);
 }
@@ -681,11 +779,26 @@ static void ChangeTileOwner_Town(TileIndex tile, Owner old_owner, Owner new_owne
 
 static bool GrowTown(Town *t);
 
+/** Number of towns that may still grow this tick, when economy.town_growth_budget limits it. */
+static uint _town_growth_budget_left;
+
 static void TownTickHandler(Town *t)
 {
 	if (HasBit(t->flags, TOWN_IS_FUNDED)) {
 		int i = t->grow_counter - 1;
 		if (i < 0) {
+			if (_settings_game.economy.town_growth_budget != 0) {
+				if (_town_growth_budget_left == 0) {
+					/* Out of budget; keep the counter expired so the
+					 * town grows the next time its handler is run. */
+					TickProfilerAddDeferred(TPE_TOWNS, 1);
+					t->grow_counter = 0;
+					UpdateTownRadius(t);
+					return;
+				}
+				_town_growth_budget_left--;
+			}
+
 			if (GrowTown(t)) {
 				i = t->growth_rate;
 			} else {
@@ -702,6 +815,8 @@ void OnTick_Town()
 {
 	if (_game_mode == GM_EDITOR) return;
 
+	_town_growth_budget_left = _settings_game.economy.town_growth_budget;
+
 	Town *t;
 	FOR_ALL_TOWNS(t) {
 		/* Run town tick at regular intervals, but not all at once. */
@@ -1258,6 +1373,51 @@ static int GrowTownAtRoad(Town *t, TileIndex tile)
 	return (_grow_town_result == -2);
 }
 
+/** Road tiles a town may start growing from; only kept to reuse the allocation. */
+static SmallVector<TileIndex, 64> _town_growth_frontier;
+
+/**
+ * Collect the tiles at the edge of the road network of a town: the road
+ * ends and junctions that have a neighbour a road or house could be built
+ * on. The result only depends on the map, so all clients find the same
+ * tiles in the same order.
+ * @param t the town to get the frontier of
+ * @param frontier is filled with the tiles, sorted by tile index
+ */
+static void GetTownGrowthFrontier(const Town *t, SmallVector<TileIndex, 64> *frontier)
+{
+	frontier->Clear();
+
+	/* Only look within the outer zone of the town. */
+	int r = 0;
+	while ((uint32)(r * r) < t->town_zone_limit[HZB_TOWN_EDGE]) r++;
+
+	int x0 = max((int)TileX(t->xy) - r, 1);
+	int y0 = max((int)TileY(t->xy) - r, 1);
+	int x1 = min((int)TileX(t->xy) + r, (int)MapMaxX() - 1);
+	int y1 = min((int)TileY(t->xy) + r, (int)MapMaxY() - 1);
+
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			TileIndex tile = TileXY(x, y);
+			if (!IsTileType(tile, MP_ROAD) || IsRoadDepot(tile) || GetTownIndex(tile) != t->index) continue;
+
+			RoadBits rb = GetTownRoadBits(tile);
+			if (rb == ROAD_NONE || CountBits(rb) == 2) continue;
+
+			for (DiagDirection dir = DIAGDIR_BEGIN; dir != DIAGDIR_END; dir++) {
+				if (rb & DiagDirToRoadBits(dir)) continue;
+
+				TileIndex neighbour = TileAddByDiagDir(tile, dir);
+				if (IsTileType(neighbour, MP_CLEAR) || IsTileType(neighbour, MP_TREES)) {
+					*frontier->Append() = tile;
+					break;
+				}
+			}
+		}
+	}
+}
+
 /**
  * Generate a random road block.
  * The probability of a straight road
@@ -1301,6 +1461,17 @@ static bool GrowTown(Town *t)
 
 	TileIndex tile = t->xy; // The tile we are working with ATM
 
+	/* Start at a random tile at the edge of the road network instead of
+	 * walking there from the centre of the town. */
+	if (_settings_game.economy.town_growth_frontier) {
+		GetTownGrowthFrontier(t, &_town_growth_frontier);
+		if (_town_growth_frontier.Length() != 0) {
+			int r = GrowTownAtRoad(t, _town_growth_frontier[RandomRange(_town_growth_frontier.Length())]);
+			cur_company.Restore();
+			return r != 0;
+		}
+	}
+
 	/* Find a road that we can base the construction on. */
 	const TileIndexDiffC *ptr;
 	for (ptr = _town_coord_mod; ptr != endof(_town_coord_mod); ++ptr) {
@@ -1374,6 +1545,14 @@ void UpdateTownRadius(Town *t)
 		t->squared_town_zone_radius[3] = mass * 5 - 5;
 		t->squared_town_zone_radius[4] = mass * 3 + 5;
 	}
+
+	/* The radii of the zones do not have to decrease with the zone, so
+	 * store the radius below which the tile is in the zone or a higher one. */
+	uint32 limit = 0;
+	for (int i = HZB_END - 1; i >= HZB_BEGIN; i--) {
+		limit = max(limit, t->squared_town_zone_radius[i]);
+		t->town_zone_limit[i] = limit;
+	}
 }
 
 void UpdateTownMaxPass(Town *t)
@@ -1396,6 +1575,7 @@ void UpdateTownMaxPass(Town *t)
 static void DoCreateTown(Town *t, TileIndex tile, uint32 townnameparts, TownSize size, bool city, TownLayout layout, bool manual)
 {
 	t->xy = tile;
+	AddTownToIndex(t);
 	t->num_houses = 0;
 	t->time_until_rebuild = 10;
 	UpdateTownRadius(t);
@@ -1772,6 +1952,10 @@ bool GenerateTowns(TownLayout layout)
 	uint difficulty = _settings_game.difficulty.number_towns;
 	uint n = (difficulty == (uint)CUSTOM_TOWN_NUMBER_DIFFICULTY) ? _settings_game.game_creation.custom_town_number : ScaleByMapSize(_num_initial_towns[difficulty] + (Random() & 7));
 	uint32 townnameparts;
+	/* Collect the names of the existing towns once, instead of rendering
+	 * all of them again for every name we try. */
+	TownNames town_names;
+	GetAllTownNames(&town_names);
 
 	SetGeneratingWorldProgress(GWP_TOWN, n);
 
@@ -1782,7 +1966,7 @@ bool GenerateTowns(TownLayout layout)
 		bool city = (_settings_game.economy.larger_towns != 0 && Chance16(1, _settings_game.economy.larger_towns));
 		IncreaseGeneratingWorldProgress(GWP_TOWN);
 		/* Get a unique name for the town. */
-		if (!GenerateTownName(&townnameparts)) continue;
+		if (!GenerateTownName(&townnameparts, &town_names)) continue;
 		/* try 20 times to create a random-sized town for the first loop. */
 		if (CreateRandomTown(20, townnameparts, TSZ_RANDOM, city, layout) != NULL) num++; // If creation was successful, raise a flag.
 	} while (--n);
@@ -1791,7 +1975,7 @@ bool GenerateTowns(TownLayout layout)
 
 	/* If num is still zero at this point, it means that not a single town has been created.
 	 * So give it a last try, but now more aggressive */
-	if (GenerateTownName(&townnameparts) &&
+	if (GenerateTownName(&townnameparts, &town_names) &&
 			CreateRandomTown(10000, townnameparts, TSZ_RANDOM, _settings_game.economy.larger_towns != 0, layout) != NULL) {
 		return true;
 	}
@@ -1817,12 +2001,11 @@ HouseZonesBits GetTownRadiusGroup(const Town *t, TileIndex tile)
 
 	if (t->fund_buildings_months && dist <= 25) return HZB_TOWN_CENTRE;
 
-	HouseZonesBits smallest = HZB_TOWN_EDGE;
-	for (HouseZonesBits i = HZB_BEGIN; i < HZB_END; i++) {
-		if (dist < t->squared_town_zone_radius[i]) smallest = i;
-	}
+	/* Most tiles are outside of the inner zones, so walk up from the edge. */
+	HouseZonesBits zone = HZB_TOWN_EDGE;
+	while (zone + 1 < HZB_END && dist < t->town_zone_limit[zone + 1]) zone++;
 
-	return smallest;
+	return zone;
 }
 
 /**
@@ -1844,6 +2027,7 @@ static inline void ClearMakeHouseTile(TileIndex tile, Town *t, byte counter, byt
 	IncreaseBuildingCount(t, type);
 	MakeHouseTile(tile, t->index, counter, stage, type, random_bits);
 	if (HouseSpec::Get(type)->building_flags & BUILDING_IS_ANIMATED) AddAnimatedTile(tile);
+	MarkCatchmentTileChanged(tile);
 
 	MarkTileDirtyByTile(tile);
 }
@@ -2060,6 +2244,62 @@ static bool CheckTownBuild2x2House(TileIndex *tile, Town *t, uint maxz, bool nos
  * @param tile where the house will be built
  * @return false iff no house can be built at this tile
  */
+/** A house that may be built in a town zone and climate. */
+struct HouseCandidate {
+	HouseID house;    ///< The house
+	uint probability; ///< Relative probability of the house being chosen
+};
+
+typedef SmallVector<HouseCandidate, 32> HouseCandidateList;
+
+/**
+ * The houses that may be built per town zone and climate, in the order of
+ * their IDs. The first climate index is for above the snow line in arctic.
+ */
+static HouseCandidateList _house_candidates[HZB_END][NUM_LANDSCAPE + 1];
+static bool _house_candidates_valid = false; ///< Whether #_house_candidates matches the current house specs.
+
+/** Mark the house candidates as outdated, e.g. because the house specs have changed. */
+void InvalidateHouseCandidates()
+{
+	_house_candidates_valid = false;
+}
+
+/**
+ * Get the houses that may be built in a town zone and climate, regardless
+ * of the town and the date. These only change when the house specs change.
+ * @param rad  The town zone.
+ * @param land The climate, or -1 for above the snow line in arctic.
+ * @return The list of candidate houses.
+ */
+static const HouseCandidateList &GetHouseCandidates(HouseZonesBits rad, int land)
+{
+	if (!_house_candidates_valid) {
+		for (HouseZonesBits z = HZB_BEGIN; z < HZB_END; z++) {
+			for (int l = -1; l < NUM_LANDSCAPE; l++) {
+				uint bitmask = (1 << z) + (1 << (l + 12));
+				HouseCandidateList &list = _house_candidates[z][l + 1];
+				list.Clear();
+
+				for (uint i = 0; i < HOUSE_MAX; i++) {
+					const HouseSpec *hs = HouseSpec::Get(i);
+
+					/* Verify that the candidate house spec matches the zone and climate */
+					if ((~hs->building_availability & bitmask) != 0 || !hs->enabled || hs->override != INVALID_HOUSE_ID) continue;
+
+					HouseCandidate *hc = list.Append();
+					hc->house = i;
+					/* Without NewHouses, all houses have probability '1' */
+					hc->probability = (_loaded_newgrf_features.has_newhouses ? hs->probability : 1);
+				}
+			}
+		}
+		_house_candidates_valid = true;
+	}
+
+	return _house_candidates[rad][land + 1];
+}
+
 static bool BuildTownHouse(Town *t, TileIndex tile)
 {
 	/* forbidden building here by town layout */
@@ -2079,22 +2319,15 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 	int land = _settings_game.game_creation.landscape;
 	if (land == LT_ARCTIC && z >= _settings_game.game_creation.snow_line) land = -1;
 
-	uint bitmask = (1 << rad) + (1 << (land + 12));
-
-	/* bits 0-4 are used
-	 * bits 11-15 are used
-	 * bits 5-10 are not used. */
 	HouseID houses[HOUSE_MAX];
 	uint num = 0;
 	uint probs[HOUSE_MAX];
 	uint probability_max = 0;
 
 	/* Generate a list of all possible houses that can be built. */
-	for (uint i = 0; i < HOUSE_MAX; i++) {
-		const HouseSpec *hs = HouseSpec::Get(i);
-
-		/* Verify that the candidate house spec matches the current tile status */
-		if ((~hs->building_availability & bitmask) != 0 || !hs->enabled || hs->override != INVALID_HOUSE_ID) continue;
+	const HouseCandidateList &candidates = GetHouseCandidates(rad, land);
+	for (const HouseCandidate *hc = candidates.Begin(); hc != candidates.End(); hc++) {
+		const HouseSpec *hs = HouseSpec::Get(hc->house);
 
 		/* Don't let these counters overflow. Global counters are 32bit, there will never be that many houses. */
 		if (hs->class_id != HOUSE_NO_CLASS) {
@@ -2102,14 +2335,12 @@ static bool BuildTownHouse(Town *t, TileIndex tile)
 			if (t->building_counts.class_count[hs->class_id] == UINT16_MAX) continue;
 		} else {
 			/* If the house has no class, check id_count instead */
-			if (t->building_counts.id_count[i] == UINT16_MAX) continue;
+			if (t->building_counts.id_count[hc->house] == UINT16_MAX) continue;
 		}
 
-		/* Without NewHouses, all houses have probability '1' */
-		uint cur_prob = (_loaded_newgrf_features.has_newhouses ? hs->probability : 1);
-		probability_max += cur_prob;
-		probs[num] = cur_prob;
-		houses[num++] = (HouseID)i;
+		probability_max += hc->probability;
+		probs[num] = hc->probability;
+		houses[num++] = hc->house;
 	}
 
 	uint maxz = GetTileMaxZ(tile);
@@ -2682,24 +2913,50 @@ CommandCost CheckIfAuthorityAllowsNewStation(TileIndex tile, DoCommandFlag flags
 	return_cmd_error(STR_ERROR_LOCAL_AUTHORITY_REFUSES_TO_ALLOW_THIS);
 }
 
-/** Return the town closest to the given tile within \a threshold.
- * @param tile      Starting point of the search.
- * @param threshold Biggest allowed distance to the town.
- * @return Closest town to \a tile withinh \a threshold, or \c NULL if there is no such town.
+/**
+ * Return the town closest to the given tile within \a threshold.
+ * When several towns are equally close, the one with the lowest index is
+ * returned, just like when going through all towns in order.
+ * @param tile      Tile to search from.
+ * @param threshold Only towns closer than this distance are returned.
+ * @return The closest town, or \c NULL if there is no town within \a threshold.
  *
  * @note This function only uses distance, the #ClosestTownFromTile function also takes town ownership into account.
  */
 Town *CalcClosestTownFromTile(TileIndex tile, uint threshold)
 {
-	Town *t;
+	if (Town::GetNumItems() == 0) return NULL;
+	if (!_town_index_valid || _town_index_map_size != MapSize() || _town_index_count != Town::GetNumItems()) RebuildTownIndex();
+
 	uint best = threshold;
 	Town *best_town = NULL;
 
-	FOR_ALL_TOWNS(t) {
-		uint dist = DistanceManhattan(tile, t->xy);
-		if (dist < best) {
-			best = dist;
-			best_town = t;
+	const int cx = TileX(tile) >> _town_index_cell_bits;
+	const int cy = TileY(tile) >> _town_index_cell_bits;
+	const int max_ring = max(max(cx, (int)_town_index_size_x - 1 - cx), max(cy, (int)_town_index_size_y - 1 - cy));
+
+	for (int r = 0; r <= max_ring; r++) {
+		/* All tiles in the cells of this ring are at least min_dist away. Towns
+		 * as far away as the best so far are still needed for the tie break. */
+		uint min_dist = (r == 0) ? 0 : ((r - 1) << _town_index_cell_bits) + 1;
+		if (min_dist > best || (best_town == NULL && min_dist >= best)) break;
+
+		for (int y = max(cy - r, 0); y <= min(cy + r, (int)_town_index_size_y - 1); y++) {
+			/* Only the edge of the ring; the inside has been done already. */
+			int step = (y == cy - r || y == cy + r) ? 1 : 2 * r;
+			for (int x = cx - r; x <= cx + r; x += step) {
+				if (x < 0 || x >= (int)_town_index_size_x) continue;
+
+				const SmallVector<Town *, 2> &cell = _town_index[y * _town_index_size_x + x];
+				for (Town * const *it = cell.Begin(); it != cell.End(); it++) {
+					Town *t = *it;
+					uint dist = DistanceManhattan(tile, t->xy);
+					if (dist < best || (dist == best && best_town != NULL && t->index < best_town->index)) {
+						best = dist;
+						best_town = t;
+					}
+				}
+			}
 		}
 	}
 
@@ -2871,6 +3128,7 @@ void TownsYearlyLoop()
 void InitializeTowns()
 {
 	_town_pool.CleanPool();
+	InvalidateTownIndex();
 }
 
 static CommandCost TerraformTile_Town(TileIndex tile, DoCommandFlag flags, uint z_new, Slope tileh_new)
@@ -2929,4 +3187,6 @@ void ResetHouses()
 
 	/* Reset any overrides that have been set. */
 	_house_mngr.ResetOverride();
+
+	InvalidateHouseCandidates();
 }
@@ -695,7 +695,7 @@ struct TownDirectoryWindow : public Window {
 private:
 	/* Runtime saved values */
 	static Listing last_sorting;
-	static const Town *last_town;
+	static NameCache town_names;
 
 	/* Constants for sorting towns */
 	static GUITownList::SortFunction * const sorter_funcs[];
@@ -717,31 +717,14 @@ private:
 			this->vscroll.SetCount(this->towns.Length()); // Update scrollbar as well.
 		}
 		/* Always sort the towns. */
-		this->last_town = NULL;
 		this->towns.Sort();
+		this->town_names.Clear();
 	}
 
 	/** Sort by town name */
 	static int CDECL TownNameSorter(const Town * const *a, const Town * const *b)
 	{
-		static char buf_cache[64];
-		const Town *ta = *a;
-		const Town *tb = *b;
-		char buf[64];
-
-		SetDParam(0, ta->index);
-		GetString(buf, STR_TOWN_NAME, lastof(buf));
-
-		/* If 'b' is the same town as in the last round, use the cached value
-		 * We do this to speed stuff up ('b' is called with the same value a lot of
-		 * times after eachother) */
-		if (tb != last_town) {
-			last_town = tb;
-			SetDParam(0, tb->index);
-			GetString(buf_cache, STR_TOWN_NAME, lastof(buf_cache));
-		}
-
-		return strcmp(buf, buf_cache);
+		return strcmp(town_names.Get((*a)->index), town_names.Get((*b)->index));
 	}
 
 	/** Sort by population */
@@ -894,17 +877,12 @@ public:
 		}
 	}
 
-	virtual void OnHundredthTick()
-	{
-		this->BuildSortTownList();
-		this->SetDirty();
-	}
-
 	virtual void OnResize()
 	{
 		this->vscroll.SetCapacityFromWidget(this, TDW_CENTERTOWN);
 	}
 
+	/** Changes of the towns' names and populations invalidate this window, so it needs no periodic rebuild. */
 	virtual void OnInvalidateData(int data)
 	{
 		if (data == 0) {
@@ -917,7 +895,7 @@ public:
 };
 
 Listing TownDirectoryWindow::last_sorting = {false, 0};
-const Town *TownDirectoryWindow::last_town = NULL;
+NameCache TownDirectoryWindow::town_names(STR_TOWN_NAME);
 
 /* Available town directory sorting functions */
 GUITownList::SortFunction * const TownDirectoryWindow::sorter_funcs[] = {
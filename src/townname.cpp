@@ -70,13 +70,33 @@ char *GetTownName(char *buff, const Town *t, const char *last)
 }
 
 
+/**
+ * Fills the set with the names of all existing towns.
+ * @param town_names the set to fill
+ */
+void GetAllTownNames(TownNames *town_names)
+{
+	char buf[MAX_LENGTH_TOWN_NAME_BYTES + MAX_CHAR_LENGTH];
+
+	const Town *t;
+	FOR_ALL_TOWNS(t) {
+		const char *name = t->name;
+		if (name == NULL) {
+			GetTownName(buf, t, lastof(buf));
+			name = buf;
+		}
+		town_names->insert(name);
+	}
+}
+
 /**
  * Verifies the town name is valid and unique.
  * @param r random bits
  * @param par town name parameters
+ * @param town_names if not NULL, the names of all existing towns; used instead of rendering the name of every town again
  * @return true iff name is valid and unique
  */
-bool VerifyTownName(uint32 r, const TownNameParams *par)
+bool VerifyTownName(uint32 r, const TownNameParams *par, TownNames *town_names)
 {
 	/* reserve space for extra unicode character and terminating '\0' */
 	char buf1[MAX_LENGTH_TOWN_NAME_BYTES + MAX_CHAR_LENGTH];
@@ -87,6 +107,8 @@ bool VerifyTownName(uint32 r, const TownNameParams *par)
 	/* Check size and width */
 	if (strlen(buf1) >= MAX_LENGTH_TOWN_NAME_BYTES) return false;
 
+	if (town_names != NULL) return town_names->find(buf1) == town_names->end();
+
 	const Town *t;
 	FOR_ALL_TOWNS(t) {
 		/* We can't just compare the numbers since
@@ -96,7 +118,7 @@ bool VerifyTownName(uint32 r, const TownNameParams *par)
 			GetTownName(buf2, t, lastof(buf2));
 			buf = buf2;
 		}
-		if (strcmp(buf1, buf2) == 0) return false;
+		if (strcmp(buf1, buf) == 0) return false;
 	}
 
 	return true;
@@ -106,9 +128,10 @@ bool VerifyTownName(uint32 r, const TownNameParams *par)
 /**
  * Generates valid town name.
  * @param townnameparts if a name is generated, it's stored there
+ * @param town_names if not NULL, the names of all existing towns; the generated name is added to it
  * @return true iff a name was generated
  */
-bool GenerateTownName(uint32 *townnameparts)
+bool GenerateTownName(uint32 *townnameparts, TownNames *town_names)
 {
 	/* Do not set too low tries, since when we run out of names, we loop
 	 * for #tries only one time anyway - then we stop generating more
@@ -119,9 +142,14 @@ bool GenerateTownName(uint32 *townnameparts)
 
 	for (int i = 1000; i != 0; i--) {
 		uint32 r = InteractiveRandom();
-		if (!VerifyTownName(r, &par)) continue;
+		if (!VerifyTownName(r, &par, town_names)) continue;
 
 		*townnameparts = r;
+		if (town_names != NULL) {
+			char buf[MAX_LENGTH_TOWN_NAME_BYTES + MAX_CHAR_LENGTH];
+			GetTownName(buf, &par, r, lastof(buf));
+			town_names->insert(buf);
+		}
 		return true;
 	}
 
@@ -12,10 +12,13 @@
 #ifndef TOWNNAME_FUNC_H
 #define TOWNNAME_FUNC_H
 
+#include "townname_type.h"
+
 char *GenerateTownNameString(char *buf, const char *last, size_t lang, uint32 seed);
 char *GetTownName(char *buff, const struct TownNameParams *par, uint32 townnameparts, const char *last);
 char *GetTownName(char *buff, const struct Town *t, const char *last);
-bool VerifyTownName(uint32 r, const struct TownNameParams *par);
-bool GenerateTownName(uint32 *townnameparts);
+bool VerifyTownName(uint32 r, const struct TownNameParams *par, TownNames *town_names = NULL);
+bool GenerateTownName(uint32 *townnameparts, TownNames *town_names = NULL);
+void GetAllTownNames(TownNames *town_names);
 
 #endif /* TOWNNAME_FUNC_H */
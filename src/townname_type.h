@@ -15,6 +15,10 @@
 #define TOWNNAME_TYPE_H
 
 #include "newgrf_townname.h"
+#include <set>
+#include <string>
+
+typedef std::set<std::string> TownNames; ///< Set of the names of all towns, used to speed up checking for duplicate names
 
 /**
  * Struct holding a parameters used to generate town name.
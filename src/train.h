@@ -79,6 +79,11 @@ struct TrainCache {
 	uint16 cached_max_speed;    ///< max speed of the consist. (minimum of the max speed of all vehicles in the consist)
 	int cached_max_curve_speed; ///< max consist speed limited by curves
 
+	/* cached (callback) properties of this vehicle, recalculated by Train::UpdatePartProperties each time the power or the cargo of the consist changes. */
+	uint16 cached_part_power;   ///< power of this vehicle when it has power on its rail type
+	uint16 cached_part_weight;  ///< weight of this vehicle without its cargo
+	byte cached_part_te;        ///< tractive effort coefficient of this vehicle
+
 	/**
 	 * Position/type of visual effect.
 	 * bit 0 - 3 = position of effect relative to vehicle. (0 = front, 8 = centre, 15 = rear)
@@ -372,19 +377,15 @@ struct Train : public GroundVehicle<Train, VEH_TRAIN> {
 
 protected: // These functions should not be called outside acceleration code.
 
+	void UpdatePartProperties();
+
 	/**
 	 * Allows to know the power value that this vehicle will use.
 	 * @return Power value from the engine in HP, or zero if the vehicle is not powered.
 	 */
 	FORCEINLINE uint16 GetPower() const
 	{
-		/* Power is not added for articulated parts */
-		if (!this->IsArticulatedPart() && HasPowerOnRail(this->railtype, GetRailType(this->tile))) {
-			uint16 power = GetVehicleProperty(this, PROP_TRAIN_POWER, RailVehInfo(this->engine_type)->power);
-			/* Halve power for multiheaded parts */
-			if (this->IsMultiheaded()) power /= 2;
-			return power;
-		}
+		if (HasPowerOnRail(this->railtype, GetRailType(this->tile))) return this->tcache.cached_part_power;
 
 		return 0;
 	}
@@ -410,17 +411,7 @@ protected: // These functions should not be called outside acceleration code.
 	{
 		uint16 weight = (CargoSpec::Get(this->cargo_type)->weight * this->cargo.Count() * FreightWagonMult(this->cargo_type)) / 16;
 
-		/* Vehicle weight is not added for articulated parts. */
-		if (!this->IsArticulatedPart()) {
-			weight += GetVehicleProperty(this, PROP_TRAIN_WEIGHT, RailVehInfo(this->engine_type)->weight);
-		}
-
-		/* Powered wagons have extra weight added. */
-		if (HasBit(this->flags, VRF_POWEREDWAGON)) {
-			weight += RailVehInfo(this->tcache.first_engine)->pow_wag_weight;
-		}
-
-		return weight;
+		return weight + this->tcache.cached_part_weight;
 	}
 
 	/**
@@ -429,7 +420,7 @@ protected: // These functions should not be called outside acceleration code.
 	 */
 	FORCEINLINE byte GetTractiveEffort() const
 	{
-		return GetVehicleProperty(this, PROP_TRAIN_TRACTIVE_EFFORT, RailVehInfo(this->engine_type)->tractive_effort);
+		return this->tcache.cached_part_te;
 	}
 
 	/**
@@ -15,6 +15,7 @@
 #include "command_func.h"
 #include "pathfinder/npf/npf_func.h"
 #include "pathfinder/yapf/yapf.hpp"
+#include "pathfinder/pf_recorder.h"
 #include "news_func.h"
 #include "company_func.h"
 #include "vehicle_gui.h"
@@ -41,6 +42,7 @@
 #include "engine_base.h"
 #include "engine_func.h"
 #include "newgrf.h"
+#include "timeline.h"
 
 #include "table/strings.h"
 #include "table/train_cmd.h"
@@ -49,7 +51,7 @@ static Track ChooseTrainTrack(Train *v, TileIndex tile, DiagDirection enterdir,
 static bool TrainCheckIfLineEnds(Train *v);
 static void TrainController(Train *v, Vehicle *nomove);
 static TileIndex TrainApproachingCrossingTile(const Train *v);
-static void CheckIfTrainNeedsService(Train *v);
+static void CheckIfTrainNeedsService(Train *v, bool budgeted);
 static void CheckNextTrainTile(Train *v);
 
 static const byte _vehicle_initial_x_fract[4] = {10, 8, 4,  8};
@@ -270,6 +272,30 @@ void Train::ConsistChanged(bool same_length)
 	}
 }
 
+/**
+ * Get the power, weight and tractive effort of all parts of the consist from
+ * their callbacks, for the acceleration code to use them more than once.
+ */
+void Train::UpdatePartProperties()
+{
+	for (Train *u = this; u != NULL; u = u->Next()) {
+		const RailVehicleInfo *rvi_u = RailVehInfo(u->engine_type);
+
+		u->tcache.cached_part_power = 0;
+		u->tcache.cached_part_weight = 0;
+		if (!u->IsArticulatedPart()) {
+			/* Power and weight are not added for articulated parts */
+			u->tcache.cached_part_power = GetVehicleProperty(u, PROP_TRAIN_POWER, rvi_u->power);
+			/* Halve power for multiheaded parts */
+			if (u->IsMultiheaded()) u->tcache.cached_part_power /= 2;
+			u->tcache.cached_part_weight = GetVehicleProperty(u, PROP_TRAIN_WEIGHT, rvi_u->weight);
+		}
+		/* Powered wagons have extra weight added. */
+		if (HasBit(u->flags, VRF_POWEREDWAGON)) u->tcache.cached_part_weight += RailVehInfo(u->tcache.first_engine)->pow_wag_weight;
+		u->tcache.cached_part_te = GetVehicleProperty(u, PROP_TRAIN_TRACTIVE_EFFORT, rvi_u->tractive_effort);
+	}
+}
+
 /**
  * Get the stop location of (the center) of the front vehicle of a train at
  * a platform of a station.
@@ -788,13 +814,15 @@ CommandCost CmdBuildRailVehicle(TileIndex tile, DoCommandFlag flags, uint32 p1,
 		}
 
 		InvalidateWindowData(WC_VEHICLE_DEPOT, v->tile);
-		InvalidateWindowClassesData(WC_TRAINS_LIST, 0);
+		InvalidateVehicleListsOfVehicle(v);
 		SetWindowDirty(WC_COMPANY, v->owner);
 		if (IsLocalCompany()) {
 			InvalidateAutoreplaceWindow(v->engine_type, v->group_id); // updates the replace Train window
 		}
 
-		Company::Get(_current_company)->num_engines[eid]++;
+		Company *c = Company::Get(_current_company);
+		c->num_engines[eid]++;
+		c->num_vehicles[VEH_TRAIN]++;
 
 		CheckConsistencyOfArticulatedVehicle(v);
 	}
@@ -945,17 +973,21 @@ static void NormaliseSubtypes(Train *chain)
 	/* We must be the first in the chain. */
 	assert(chain->Previous() == NULL);
 
+	uint16 &num_vehicles = Company::Get(chain->owner)->num_vehicles[VEH_TRAIN];
+
 	/* Set the appropirate bits for the first in the chain. */
 	if (chain->IsWagon()) {
 		chain->SetFreeWagon();
 	} else {
 		assert(chain->IsEngine());
+		if (!chain->IsFrontEngine()) num_vehicles++;
 		chain->SetFrontEngine();
 	}
 
 	/* Now clear the bits for the rest of the chain */
 	for (Train *t = chain->Next(); t != NULL; t = t->Next()) {
 		t->ClearFreeWagon();
+		if (t->IsFrontEngine()) num_vehicles--;
 		t->ClearFrontEngine();
 	}
 }
@@ -1600,12 +1632,12 @@ static bool TrainApproachingCrossing(TileIndex tile)
 	DiagDirection dir = AxisToDiagDir(GetCrossingRailAxis(tile));
 	TileIndex tile_from = tile + TileOffsByDiagDir(dir);
 
-	if (HasVehicleOnPos(tile_from, &tile, &TrainApproachingCrossingEnum)) return true;
+	if (HasTrainOnPos(tile_from, &tile, &TrainApproachingCrossingEnum)) return true;
 
 	dir = ReverseDiagDir(dir);
 	tile_from = tile + TileOffsByDiagDir(dir);
 
-	return HasVehicleOnPos(tile_from, &tile, &TrainApproachingCrossingEnum);
+	return HasTrainOnPos(tile_from, &tile, &TrainApproachingCrossingEnum);
 }
 
 
@@ -1619,8 +1651,11 @@ void UpdateLevelCrossing(TileIndex tile, bool sound)
 {
 	assert(IsLevelCrossingTile(tile));
 
-	/* train on crossing || train approaching crossing || reserved */
-	bool new_state = HasVehicleOnPos(tile, NULL, &TrainOnTileEnum) || TrainApproachingCrossing(tile) || HasCrossingReservation(tile);
+	/* reserved || train on crossing || train approaching crossing
+	 * The reservation is checked first as it is only a bit of the map.
+	 * Only the trains on the tiles are looked at, so the road vehicles
+	 * queueing at a busy crossing do not make this any slower. */
+	bool new_state = HasCrossingReservation(tile) || HasTrainOnPos(tile, NULL, &TrainOnTileEnum) || TrainApproachingCrossing(tile);
 
 	if (new_state != IsCrossingBarred(tile)) {
 		if (new_state && sound) {
@@ -1736,6 +1771,8 @@ static void AdvanceWagonsAfterSwap(Train *v)
 
 static void ReverseTrainDirection(Train *v)
 {
+	ReservationOwnerScope owner(v->index);
+
 	if (IsRailDepotTile(v->tile)) {
 		InvalidateWindowData(WC_VEHICLE_DEPOT, v->tile);
 	}
@@ -1952,7 +1989,7 @@ CommandCost CmdRefitRailVehicle(TileIndex tile, DoCommandFlag flags, uint32 p1,
 		front->ConsistChanged(false);
 		SetWindowDirty(WC_VEHICLE_DETAILS, front->index);
 		SetWindowDirty(WC_VEHICLE_DEPOT, front->tile);
-		InvalidateWindowClassesData(WC_TRAINS_LIST, 0);
+		InvalidateVehicleListsOfVehicle(front);
 	} else {
 		v->InvalidateNewGRFCacheOfChain(); // always invalidate; querycost might have filled it
 	}
@@ -2067,7 +2104,7 @@ static void HandleLocomotiveSmokeCloud(const Train *v)
 			case 0:
 				/* steam smoke. */
 				if (GB(v->tick_counter, 0, 4) == 0) {
-					CreateEffectVehicleRel(v, x, y, 10, EV_STEAM_SMOKE);
+					CreateEffectParticleRel(v, x, y, 10, EV_STEAM_SMOKE);
 					sound = true;
 				}
 				break;
@@ -2075,7 +2112,7 @@ static void HandleLocomotiveSmokeCloud(const Train *v)
 			case 1:
 				/* diesel smoke */
 				if (u->cur_speed <= 40 && Chance16(15, 128)) {
-					CreateEffectVehicleRel(v, 0, 0, 10, EV_DIESEL_SMOKE);
+					CreateEffectParticleRel(v, 0, 0, 10, EV_DIESEL_SMOKE);
 					sound = true;
 				}
 				break;
@@ -2083,7 +2120,7 @@ static void HandleLocomotiveSmokeCloud(const Train *v)
 			case 2:
 				/* blue spark */
 				if (GB(v->tick_counter, 0, 2) == 0 && Chance16(1, 45)) {
-					CreateEffectVehicleRel(v, 0, 0, 10, EV_ELECTRIC_SPARK);
+					CreateEffectParticleRel(v, 0, 0, 10, EV_ELECTRIC_SPARK);
 					sound = true;
 				}
 				break;
@@ -2351,12 +2388,24 @@ static const byte _initial_tile_subcoord[6][4][3] = {
  */
 static Track DoTrainPathfind(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool *path_not_found, bool do_track_reservation, PBSTileInfo *dest)
 {
+	TIMELINE_ZONE("train pathfinder");
+
+	CPerformanceTimer timer;
+	if (IsRecordingPathfinderQueries()) timer.Start();
+
+	Track track;
 	switch (_settings_game.pf.pathfinder_for_trains) {
-		case VPF_NPF: return NPFTrainChooseTrack(v, tile, enterdir, tracks, path_not_found, do_track_reservation, dest);
-		case VPF_YAPF: return YapfTrainChooseTrack(v, tile, enterdir, tracks, path_not_found, do_track_reservation, dest);
+		case VPF_NPF: track = NPFTrainChooseTrack(v, tile, enterdir, tracks, path_not_found, do_track_reservation, dest); break;
+		case VPF_YAPF: track = YapfTrainChooseTrack(v, tile, enterdir, tracks, path_not_found, do_track_reservation, dest); break;
 
 		default: NOT_REACHED();
 	}
+
+	if (IsRecordingPathfinderQueries()) {
+		timer.Stop();
+		RecordPathfinderQuery(PFQ_TRAIN, v, tile, enterdir, tracks, track, timer.m_acc);
+	}
+	return track;
 }
 
 /**
@@ -2581,7 +2630,7 @@ static Track ChooseTrainTrack(Train *v, TileIndex tile, DiagDirection enterdir,
 		/* Check if the train needs service here, so it has a chance to always find a depot.
 		 * Also check if the current order is a service order so we don't reserve a path to
 		 * the destination but instead to the next one if service isn't needed. */
-		CheckIfTrainNeedsService(v);
+		CheckIfTrainNeedsService(v, false);
 		if (v->current_order.IsType(OT_DUMMY) || v->current_order.IsType(OT_CONDITIONAL) || v->current_order.IsType(OT_GOTO_DEPOT)) ProcessOrders(v);
 
 		res_dest = ExtendTrainReservation(v, &tracks, &dest_enterdir);
@@ -2729,6 +2778,8 @@ bool TryPathReserve(Train *v, bool mark_as_stuck, bool first_tile_okay)
 {
 	assert(v->IsFrontEngine());
 
+	ReservationOwnerScope owner(v->index);
+
 	/* We have to handle depots specially as the track follower won't look
 	 * at the depot tile itself but starts from the next tile. If we are still
 	 * inside the depot, a depot reservation can never be ours. */
@@ -2958,6 +3009,8 @@ static bool TrainMovedChangeSignals(TileIndex tile, DiagDirection dir)
  */
 void Train::ReserveTrackUnderConsist() const
 {
+	ReservationOwnerScope owner(this->First()->index);
+
 	for (const Train *u = this; u != NULL; u = u->Next()) {
 		switch (u->track) {
 			case TRACK_BIT_WORMHOLE:
@@ -3955,6 +4008,10 @@ bool Train::Tick()
 
 		this->current_order_time++;
 
+		if (HasBit(this->vehicle_flags, VF_SERVICE_CHECK_PENDING)) CheckIfTrainNeedsService(this, true);
+
+		ReservationOwnerScope owner(this->index);
+
 		if (!TrainLocoHandler(this, false)) return false;
 
 		return TrainLocoHandler(this, true);
@@ -3969,14 +4026,23 @@ bool Train::Tick()
 	return true;
 }
 
-static void CheckIfTrainNeedsService(Train *v)
+/**
+ * Check whether a train should go to a depot to be serviced, and if so send it there.
+ * @param v        the train
+ * @param budgeted whether the depot search counts against the depot searches per tick
+ */
+static void CheckIfTrainNeedsService(Train *v, bool budgeted)
 {
+	ClrBit(v->vehicle_flags, VF_SERVICE_CHECK_PENDING);
+
 	if (Company::Get(v->owner)->settings.vehicle.servint_trains == 0 || !v->NeedsAutomaticServicing()) return;
 	if (v->IsInDepot()) {
 		VehicleServiceInDepot(v);
 		return;
 	}
 
+	if (budgeted && !MayStartServiceDepotSearch(v)) return;
+
 	uint max_penalty;
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF:  max_penalty = _settings_game.pf.npf.maximum_go_to_depot_penalty;  break;
@@ -4018,7 +4084,8 @@ void Train::OnNewDay()
 		CheckVehicleBreakdown(this);
 		AgeVehicle(this);
 
-		CheckIfTrainNeedsService(this);
+		/* The depot search is done when it is the turn of this train in a tick. */
+		SetBit(this->vehicle_flags, VF_SERVICE_CHECK_PENDING);
 
 		CheckOrders(this);
 
@@ -499,6 +499,12 @@ static void DrawTile_Trees(TileInfo *ti)
 		d++;
 	}
 
+	/* From far away one tree stands for all trees of the tile */
+	if (trees > 1 && IsViewportLowDetail()) {
+		te[0] = te[trees - 1];
+		trees = 1;
+	}
+
 	/* draw them in a sorted way */
 	byte z = ti->z + GetSlopeMaxZ(ti->tileh) / 2;
 
@@ -26,15 +26,25 @@ TileIndex GetOtherTunnelEnd(TileIndex tile)
 	uint z = GetTileZ(tile);
 
 	dir = ReverseDiagDir(dir);
+
+	/* Use the distance stored in the map when it points at the matching end. */
+	uint distance = GetTunnelBridgeEndDistance(tile);
+	if (distance != 0) {
+		TileIndex end = tile + delta * (int)distance;
+		if (end < MapSize() && IsTunnelTile(end) && GetTunnelBridgeDirection(end) == dir && GetTileZ(end) == z) return end;
+	}
+
+	TileIndex end = tile;
 	do {
-		tile += delta;
+		end += delta;
 	} while (
-		!IsTunnelTile(tile) ||
-		GetTunnelBridgeDirection(tile) != dir ||
-		GetTileZ(tile) != z
+		!IsTunnelTile(end) ||
+		GetTunnelBridgeDirection(end) != dir ||
+		GetTileZ(end) != z
 	);
 
-	return tile;
+	SetTunnelBridgeEnds(tile, end);
+	return end;
 }
 
 
@@ -445,6 +445,7 @@ CommandCost CmdBuildBridge(TileIndex end_tile, DoCommandFlag flags, uint32 p1, u
 			default:
 				NOT_REACHED();
 		}
+		SetTunnelBridgeEnds(tile_start, tile_end);
 
 		/* Mark all tiles dirty */
 		TileIndexDiff delta = (direction == AXIS_X ? TileDiffXY(1, 0) : TileDiffXY(0, 1));
@@ -457,6 +458,7 @@ CommandCost CmdBuildBridge(TileIndex end_tile, DoCommandFlag flags, uint32 p1, u
 		Track track = AxisToTrack(direction);
 		AddSideToSignalBuffer(tile_start, INVALID_DIAGDIR, _current_company);
 		YapfNotifyTrackLayoutChange(tile_start, track);
+		YapfNotifyTrackLayoutChange(tile_end, track);
 	}
 
 	/* for human player that builds the bridge he gets a selection to choose from bridges (DC_QUERY_COST)
@@ -614,10 +616,12 @@ CommandCost CmdBuildTunnel(TileIndex start_tile, DoCommandFlag flags, uint32 p1,
 			MakeRailTunnel(end_tile,   _current_company, ReverseDiagDir(direction), railtype);
 			AddSideToSignalBuffer(start_tile, INVALID_DIAGDIR, _current_company);
 			YapfNotifyTrackLayoutChange(start_tile, DiagDirToDiagTrack(direction));
+			YapfNotifyTrackLayoutChange(end_tile, DiagDirToDiagTrack(direction));
 		} else {
 			MakeRoadTunnel(start_tile, _current_company, direction,                 rts);
 			MakeRoadTunnel(end_tile,   _current_company, ReverseDiagDir(direction), rts);
 		}
+		SetTunnelBridgeEnds(start_tile, end_tile);
 	}
 
 	return cost;
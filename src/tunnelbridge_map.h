@@ -71,6 +71,44 @@ static inline void SetTunnelBridgeSnowOrDesert(TileIndex t, bool snow_or_desert)
 	SB(_me[t].m7, 5, 1, snow_or_desert);
 }
 
+/**
+ * Get the cached distance to the other end of the tunnel or bridge.
+ * @param t the tunnel entrance / bridge ramp tile
+ * @pre IsTileType(t, MP_TUNNELBRIDGE)
+ * @return the distance in tiles, or 0 when it is not known yet
+ */
+static inline uint GetTunnelBridgeEndDistance(TileIndex t)
+{
+	assert(IsTileType(t, MP_TUNNELBRIDGE));
+	return _m[t].m2;
+}
+
+/**
+ * Remember the distance to the other end of the tunnel or bridge.
+ * @param t the tunnel entrance / bridge ramp tile
+ * @param distance the distance in tiles, 0 when not known
+ * @pre IsTileType(t, MP_TUNNELBRIDGE)
+ */
+static inline void SetTunnelBridgeEndDistance(TileIndex t, uint distance)
+{
+	assert(IsTileType(t, MP_TUNNELBRIDGE));
+	_m[t].m2 = distance;
+}
+
+/**
+ * Link both ends of a tunnel or bridge, so finding the other end
+ * does not need to walk along it.
+ * @param begin one end
+ * @param end   the other end
+ * @pre IsTileType(begin, MP_TUNNELBRIDGE) && IsTileType(end, MP_TUNNELBRIDGE)
+ */
+static inline void SetTunnelBridgeEnds(TileIndex begin, TileIndex end)
+{
+	uint distance = DistanceManhattan(begin, end);
+	SetTunnelBridgeEndDistance(begin, distance);
+	SetTunnelBridgeEndDistance(end, distance);
+}
+
 /**
  * Determines type of the wormhole and returns its other end
  * @param t one end
@@ -107,7 +145,10 @@ static inline void SetTunnelBridgeReservation(TileIndex t, bool b)
 {
 	assert(IsTileType(t, MP_TUNNELBRIDGE));
 	assert(GetTunnelBridgeTransportType(t) == TRANSPORT_RAIL);
+	TrackBits track = DiagDirToDiagTrackBits(GetTunnelBridgeDirection(t));
+	UpdateReservationOwner(t, HasTunnelBridgeReservation(t) ? track : TRACK_BIT_NONE, b ? track : TRACK_BIT_NONE);
 	SB(_m[t].m5, 4, 1, b ? 1 : 0);
+	MarkRailStateChanged(t);
 }
 
 /**
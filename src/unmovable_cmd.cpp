@@ -30,6 +30,7 @@
 #include "sprite.h"
 #include "core/random_func.hpp"
 #include "unmovable_map.h"
+#include "station_func.h"
 
 #include "table/strings.h"
 #include "table/sprites.h"
@@ -90,7 +91,11 @@ void UpdateCompanyHQ(Company *c, uint score)
 	(val++, score < 720) ||
 	(val++, true);
 
-	EnlargeCompanyHQ(tile, val);
+	if (val > GetCompanyHQSize(tile)) {
+		EnlargeCompanyHQ(tile, val);
+
+		TILE_AREA_LOOP(t, TileArea(tile, 2, 2)) MarkCatchmentTileChanged(t);
+	}
 
 	MarkTileDirtyByTile(tile);
 	MarkTileDirtyByTile(tile + TileDiffXY(0, 1));
@@ -126,6 +131,7 @@ CommandCost CmdBuildCompanyHQ(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 		c->location_of_HQ = tile;
 
 		MakeCompanyHQ(tile, _current_company);
+		TILE_AREA_LOOP(t, TileArea(tile, 2, 2)) MarkCatchmentTileChanged(t);
 
 		UpdateCompanyHQ(c, score);
 		SetWindowDirty(WC_COMPANY, c->index);
@@ -47,10 +47,14 @@
 #include "economy_base.h"
 #include "articulated_vehicles.h"
 #include "roadstop_base.h"
+#include "effectvehicle_func.h"
 #include "core/random_func.hpp"
 #include "engine_base.h"
 #include "newgrf.h"
 #include "core/backup_type.hpp"
+#include "thread/thread.h"
+#include "pbs.h"
+#include "blitter/factory.hpp"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -68,6 +72,56 @@ byte _age_cargo_skip_counter; ///< Skip aging of cargo?
 VehiclePool _vehicle_pool("Vehicle");
 INSTANTIATE_POOL_METHODS(Vehicle)
 
+/**
+ * For every type of vehicle a bitmap with the indices of the vehicles of
+ * that type, so the vehicles can be ticked type by type without walking
+ * over the vehicles of the other types.
+ */
+static SmallVector<uint32, 64> _vehicle_type_indices[VEH_END];
+
+/**
+ * Add or remove a vehicle to the bitmap of its type.
+ * @param type  The type of the vehicle.
+ * @param index The index of the vehicle.
+ * @param used  Whether the vehicle is added or removed.
+ */
+static void SetVehicleTypeIndex(VehicleType type, VehicleID index, bool used)
+{
+	if (type >= VEH_END) return;
+
+	SmallVector<uint32, 64> &bits = _vehicle_type_indices[type];
+	uint word = index / 32;
+	if (word >= bits.Length()) {
+		if (!used) return;
+		uint old_length = bits.Length();
+		bits.Append(word + 1 - old_length);
+		MemSetT(bits.Get(old_length), 0, word + 1 - old_length);
+	}
+
+	if (used) {
+		SetBit(*bits.Get(word), index % 32);
+	} else {
+		ClrBit(*bits.Get(word), index % 32);
+	}
+}
+
+/**
+ * Get the first vehicle of the given type with an index of at least \a index.
+ * @param type  The type of the vehicle.
+ * @param index The index to start searching at.
+ * @return The index of the vehicle, or INVALID_VEHICLE if there is none.
+ */
+static VehicleID GetNextVehicleOfType(VehicleType type, uint index)
+{
+	const SmallVector<uint32, 64> &bits = _vehicle_type_indices[type];
+	while (index / 32 < bits.Length()) {
+		uint32 word = *bits.Get(index / 32) >> (index % 32);
+		if (word != 0) return index + FindFirstBit(word);
+		index = (index | 31) + 1;
+	}
+	return INVALID_VEHICLE;
+}
+
 /** Function to tell if a vehicle needs to be autorenewed
  * @param *c The vehicle owner
  * @return true if the vehicle is old enough for replacement
@@ -179,7 +233,7 @@ uint Vehicle::Crash(bool flooded)
 	}
 
 	/* Dirty some windows */
-	InvalidateWindowClassesData(GetWindowClassForVehicleType(this->type), 0);
+	InvalidateVehicleListsOfVehicle(this);
 	SetWindowWidgetDirty(WC_VEHICLE_VIEW, this->index, VVW_WIDGET_START_STOP_VEH);
 	SetWindowDirty(WC_VEHICLE_DETAILS, this->index);
 	SetWindowDirty(WC_VEHICLE_DEPOT, this->tile);
@@ -232,8 +286,11 @@ Vehicle::Vehicle(VehicleType type)
 	this->coord.left         = INVALID_COORD;
 	this->group_id           = DEFAULT_GROUP;
 	this->fill_percent_te_id = INVALID_TE_ID;
+	this->dirty_area         = INVALID_DIRTY_AREA;
 	this->first              = this;
 	this->colourmap          = PAL_NONE;
+
+	SetVehicleTypeIndex(type, this->index, true);
 }
 
 /**
@@ -245,26 +302,138 @@ byte VehicleRandomBits()
 	return GB(Random(), 0, 8);
 }
 
-/* Size of the hash, 6 = 64 x 64, 7 = 128 x 128. Larger sizes will (in theory) reduce hash
- * lookup times at the expense of memory usage. */
-const int HASH_BITS = 7;
-const int HASH_SIZE = 1 << HASH_BITS;
-const int HASH_MASK = HASH_SIZE - 1;
-const int TOTAL_HASH_SIZE = 1 << (HASH_BITS * 2);
-const int TOTAL_HASH_MASK = TOTAL_HASH_SIZE - 1;
+/* The hash of vehicles by the tile they are on. Its size depends on the size
+ * of the map and on the number of vehicles, so large maps with few vehicles
+ * do not waste memory and large maps with many vehicles do not end up with
+ * long chains of vehicles that are far away from each other. */
+static const uint MIN_HASH_BITS = 7;  ///< Minimum number of bits of the hash in each direction; 7 = 128 x 128.
+static const uint HASH_LOAD_BITS = 2; ///< The hash has at least 1 << HASH_LOAD_BITS buckets per vehicle.
 
-/* Resolution of the hash, 0 = 1*1 tile, 1 = 2*2 tiles, 2 = 4*4 tiles, etc.
- * Profiling results show that 0 is fastest. */
-const int HASH_RES = 0;
+static Vehicle **_new_vehicle_position_hash = NULL;  ///< The buckets of the hash.
+static Vehicle **_road_vehicle_position_hash = NULL; ///< The buckets of the hash of only the road vehicles, sized like #_new_vehicle_position_hash.
+static Vehicle **_train_position_hash = NULL;        ///< The buckets of the hash of only the trains, sized like #_new_vehicle_position_hash.
+static uint _vehicle_hash_bits_x;                   ///< Number of bits of the X coordinate used for the hash.
+static uint _vehicle_hash_bits_y;                   ///< Number of bits of the Y coordinate used for the hash.
+static uint _vehicle_hash_map_size;                 ///< Size of the map the hash was made for.
+static uint _vehicle_hash_grow_limit;               ///< Number of vehicles at which the hash is made larger.
 
-static Vehicle *_new_vehicle_position_hash[TOTAL_HASH_SIZE];
+/**
+ * Whether the vehicles of a type are also kept in a hash of only that type.
+ * @param type The type of the vehicles.
+ * @return True for road vehicles and trains.
+ */
+static FORCEINLINE bool HasTypedVehicleHash(VehicleType type)
+{
+	return type == VEH_ROAD || type == VEH_TRAIN;
+}
+
+/**
+ * Get the bucket of the hash for a hash position.
+ * @param x The X coordinate, already masked to the hash size.
+ * @param y The Y coordinate, already masked to the hash size.
+ * @param type The type of the vehicles of the hash, or VEH_INVALID for the hash of all vehicles.
+ * @return The bucket.
+ */
+static FORCEINLINE Vehicle **GetVehicleHashBucket(uint x, uint y, VehicleType type = VEH_INVALID)
+{
+	Vehicle **hash;
+	switch (type) {
+		case VEH_ROAD:  hash = _road_vehicle_position_hash; break;
+		case VEH_TRAIN: hash = _train_position_hash;        break;
+		default:        hash = _new_vehicle_position_hash;  break;
+	}
+	return &hash[(y << _vehicle_hash_bits_x) | x];
+}
+
+/**
+ * Get the bucket of the hash for a tile.
+ * @param tile The tile to get the bucket for.
+ * @param type The type of the vehicles of the hash, or VEH_INVALID for the hash of all vehicles.
+ * @return The bucket.
+ */
+static FORCEINLINE Vehicle **GetVehicleHashBucket(TileIndex tile, VehicleType type = VEH_INVALID)
+{
+	return GetVehicleHashBucket(GB(TileX(tile), 0, _vehicle_hash_bits_x), GB(TileY(tile), 0, _vehicle_hash_bits_y), type);
+}
+
+/**
+ * Get the next vehicle in the same bucket of a hash.
+ * @param v The vehicle to get the next one of.
+ * @param type The type of the vehicles of the hash, or VEH_INVALID for the hash of all vehicles.
+ * @return The next vehicle, or NULL at the end of the bucket.
+ */
+static FORCEINLINE Vehicle *GetNextVehicleInHash(const Vehicle *v, VehicleType type)
+{
+	return HasTypedVehicleHash(type) ? v->next_typed_hash : v->next_new_hash;
+}
+
+/**
+ * (Re)allocate the hash of vehicles by tile, so it fits the current map
+ * and number of vehicles. The vehicles that were in the old hash are put
+ * in the same buckets as they would have been put in the new one.
+ * @param num_vehicles The number of vehicles the hash has to be sized for.
+ */
+static void AllocateVehiclePosHash(uint num_vehicles)
+{
+	uint max_bits = MapLogX() + MapLogY();
+	uint bits = min<uint>(max<uint>(FindLastBit(max(num_vehicles, 1U)) + 1 + HASH_LOAD_BITS, 2 * MIN_HASH_BITS), max_bits);
+
+	/* Divide the bits over both directions, without exceeding the size of the map. */
+	uint bits_x = min((bits + 1) / 2, MapLogX());
+	uint bits_y = min(bits - bits_x, MapLogY());
+	bits_x = min(bits - bits_y, MapLogX());
+
+	Vehicle **old_hash = _new_vehicle_position_hash;
+	Vehicle **old_road_hash = _road_vehicle_position_hash;
+	Vehicle **old_train_hash = _train_position_hash;
+	bool resize = old_hash == NULL || bits_x != _vehicle_hash_bits_x || bits_y != _vehicle_hash_bits_y;
+
+	_vehicle_hash_map_size = MapSize();
+	_vehicle_hash_grow_limit = (bits_x + bits_y < max_bits) ? 1 << (bits_x + bits_y - HASH_LOAD_BITS) : UINT_MAX;
+	if (!resize) return;
+
+	_vehicle_hash_bits_x = bits_x;
+	_vehicle_hash_bits_y = bits_y;
+	_new_vehicle_position_hash = CallocT<Vehicle *>(1 << (bits_x + bits_y));
+	_road_vehicle_position_hash = CallocT<Vehicle *>(1 << (bits_x + bits_y));
+	_train_position_hash = CallocT<Vehicle *>(1 << (bits_x + bits_y));
+
+	if (old_hash != NULL) {
+		Vehicle *v;
+		FOR_ALL_VEHICLES(v) {
+			if (v->old_new_hash == NULL) continue;
+
+			Vehicle **new_hash = GetVehicleHashBucket(v->tile);
+			v->next_new_hash = *new_hash;
+			if (v->next_new_hash != NULL) v->next_new_hash->prev_new_hash = &v->next_new_hash;
+			v->prev_new_hash = new_hash;
+			v->old_new_hash = new_hash;
+			*new_hash = v;
+
+			if (v->old_typed_hash == NULL) continue;
+
+			Vehicle **typed_hash = GetVehicleHashBucket(v->tile, v->type);
+			v->next_typed_hash = *typed_hash;
+			if (v->next_typed_hash != NULL) v->next_typed_hash->prev_typed_hash = &v->next_typed_hash;
+			v->prev_typed_hash = typed_hash;
+			v->old_typed_hash = typed_hash;
+			*typed_hash = v;
+		}
+		free(old_hash);
+		free(old_road_hash);
+		free(old_train_hash);
+	}
+}
 
-static Vehicle *VehicleFromHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first)
+static Vehicle *VehicleFromHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first, VehicleType type = VEH_INVALID)
 {
-	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
-		for (int x = xl; ; x = (x + 1) & HASH_MASK) {
-			Vehicle *v = _new_vehicle_position_hash[(x + y) & TOTAL_HASH_MASK];
-			for (; v != NULL; v = v->next_new_hash) {
+	const int mask_x = (1 << _vehicle_hash_bits_x) - 1;
+	const int mask_y = (1 << _vehicle_hash_bits_y) - 1;
+
+	for (int y = yl; ; y = (y + 1) & mask_y) {
+		for (int x = xl; ; x = (x + 1) & mask_x) {
+			Vehicle *v = *GetVehicleHashBucket(x, y, type);
+			for (; v != NULL; v = GetNextVehicleInHash(v, type)) {
 				Vehicle *a = proc(v, data);
 				if (find_first && a != NULL) return a;
 			}
@@ -286,19 +455,20 @@ static Vehicle *VehicleFromHash(int xl, int yl, int xu, int yu, void *data, Vehi
  * @param proc The proc that determines whether a vehicle will be "found".
  * @param find_first Whether to return on the first found or iterate over
  *                   all vehicles
+ * @param type The type of the vehicles to look at, or VEH_INVALID to look at all.
  * @return the best matching or first vehicle (depending on find_first).
  */
-static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *proc, bool find_first)
+static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *proc, bool find_first, VehicleType type = VEH_INVALID)
 {
 	const int COLL_DIST = 6;
 
 	/* Hash area to scan is from xl,yl to xu,yu */
-	int xl = GB((x - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int xu = GB((x + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
-	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
+	int xl = GB((x - COLL_DIST) / TILE_SIZE, 0, _vehicle_hash_bits_x);
+	int xu = GB((x + COLL_DIST) / TILE_SIZE, 0, _vehicle_hash_bits_x);
+	int yl = GB((y - COLL_DIST) / TILE_SIZE, 0, _vehicle_hash_bits_y);
+	int yu = GB((y + COLL_DIST) / TILE_SIZE, 0, _vehicle_hash_bits_y);
 
-	return VehicleFromHash(xl, yl, xu, yu, data, proc, find_first);
+	return VehicleFromHash(xl, yl, xu, yu, data, proc, find_first, type);
 }
 
 /**
@@ -336,6 +506,20 @@ bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
 	return VehicleFromPosXY(x, y, data, proc, true) != NULL;
 }
 
+/**
+ * Find a road vehicle from a specific location, like #FindVehicleOnPosXY.
+ * Only road vehicles are passed to \a proc, so the trains and effects
+ * around do not need to be looked at.
+ * @param x    The X location on the map
+ * @param y    The Y location on the map
+ * @param data Arbitrary data passed to proc
+ * @param proc The proc that determines whether a vehicle will be "found".
+ */
+void FindRoadVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
+{
+	VehicleFromPosXY(x, y, data, proc, false, VEH_ROAD);
+}
+
 /**
  * Helper function for FindVehicleOnPos/HasVehicleOnPos.
  * @note Do not call this function directly!
@@ -344,15 +528,13 @@ bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
  * @param proc The proc that determines whether a vehicle will be "found".
  * @param find_first Whether to return on the first found or iterate over
  *                   all vehicles
+ * @param type The type of the vehicles to look at, or VEH_INVALID to look at all.
  * @return the best matching or first vehicle (depending on find_first).
  */
-static Vehicle *VehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
+static Vehicle *VehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first, VehicleType type = VEH_INVALID)
 {
-	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
-
-	Vehicle *v = _new_vehicle_position_hash[(x + y) & TOTAL_HASH_MASK];
-	for (; v != NULL; v = v->next_new_hash) {
+	Vehicle *v = *GetVehicleHashBucket(tile, type);
+	for (; v != NULL; v = GetNextVehicleInHash(v, type)) {
 		if (v->tile != tile) continue;
 
 		Vehicle *a = proc(v, data);
@@ -395,6 +577,44 @@ bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
 	return VehicleFromPos(tile, data, proc, true) != NULL;
 }
 
+/**
+ * Find a road vehicle from a specific location, like #FindVehicleOnPos,
+ * but only road vehicles are passed to \a proc.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found".
+ */
+void FindRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
+{
+	VehicleFromPos(tile, data, proc, false, VEH_ROAD);
+}
+
+/**
+ * Checks whether a road vehicle is on a specific location, like
+ * #HasVehicleOnPos, but only road vehicles are passed to \a proc.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The \a proc that determines whether a vehicle will be "found".
+ * @return True if proc returned non-NULL.
+ */
+bool HasRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
+{
+	return VehicleFromPos(tile, data, proc, true, VEH_ROAD) != NULL;
+}
+
+/**
+ * Checks whether a train is on a specific location, like #HasVehicleOnPos,
+ * but only the vehicles of trains are passed to \a proc.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The \a proc that determines whether a vehicle will be "found".
+ * @return True if proc returned non-NULL.
+ */
+bool HasTrainOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
+{
+	return VehicleFromPos(tile, data, proc, true, VEH_TRAIN) != NULL;
+}
+
 /** Callback that returns 'real' vehicles lower or at height \c *(byte*)data .
  * @param v Vehicle to examine.
  * @param data Pointer to height data.
@@ -490,17 +710,14 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits)
 
 static void UpdateNewVehiclePosHash(Vehicle *v, bool remove)
 {
-	Vehicle **old_hash = v->old_new_hash;
-	Vehicle **new_hash;
-
-	if (remove) {
-		new_hash = NULL;
-	} else {
-		int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-		int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-		new_hash = &_new_vehicle_position_hash[(x + y) & TOTAL_HASH_MASK];
+	/* Make the hash larger when there are too many vehicles, or when the map has changed. */
+	if (Vehicle::GetNumItems() > _vehicle_hash_grow_limit || MapSize() != _vehicle_hash_map_size) {
+		AllocateVehiclePosHash((uint)Vehicle::GetNumItems());
 	}
 
+	Vehicle **old_hash = v->old_new_hash;
+	Vehicle **new_hash = remove ? NULL : GetVehicleHashBucket(v->tile);
+
 	if (old_hash == new_hash) return;
 
 	/* Remove from the old position in the hash table */
@@ -519,6 +736,25 @@ static void UpdateNewVehiclePosHash(Vehicle *v, bool remove)
 
 	/* Remember current hash position */
 	v->old_new_hash = new_hash;
+
+	if (!HasTypedVehicleHash(v->type)) return;
+
+	/* Road vehicles and trains are in a hash of their type too, with the same buckets. */
+	Vehicle **typed_hash = remove ? NULL : GetVehicleHashBucket(v->tile, v->type);
+
+	if (v->old_typed_hash != NULL) {
+		if (v->next_typed_hash != NULL) v->next_typed_hash->prev_typed_hash = v->prev_typed_hash;
+		*v->prev_typed_hash = v->next_typed_hash;
+	}
+
+	if (typed_hash != NULL) {
+		v->next_typed_hash = *typed_hash;
+		if (v->next_typed_hash != NULL) v->next_typed_hash->prev_typed_hash = &v->next_typed_hash;
+		v->prev_typed_hash = typed_hash;
+		*typed_hash = v;
+	}
+
+	v->old_typed_hash = typed_hash;
 }
 
 static Vehicle *_vehicle_position_hash[0x1000];
@@ -554,9 +790,19 @@ static void UpdateVehiclePosHash(Vehicle *v, int x, int y)
 void ResetVehiclePosHash()
 {
 	Vehicle *v;
-	FOR_ALL_VEHICLES(v) { v->old_new_hash = NULL; }
+	FOR_ALL_VEHICLES(v) {
+		v->old_new_hash = NULL;
+		v->old_typed_hash = NULL;
+	}
 	memset(_vehicle_position_hash, 0, sizeof(_vehicle_position_hash));
-	memset(_new_vehicle_position_hash, 0, sizeof(_new_vehicle_position_hash));
+
+	free(_new_vehicle_position_hash);
+	free(_road_vehicle_position_hash);
+	free(_train_position_hash);
+	_new_vehicle_position_hash = NULL;
+	_road_vehicle_position_hash = NULL;
+	_train_position_hash = NULL;
+	AllocateVehiclePosHash((uint)Vehicle::GetNumItems());
 }
 
 void ResetVehicleColourMap()
@@ -569,18 +815,20 @@ void ResetVehicleColourMap()
  * List of vehicles that should check for autoreplace this tick.
  * Mapping of vehicle -> leave depot immediatelly after autoreplace.
  */
-typedef SmallMap<Vehicle *, bool, 4> AutoreplaceMap;
+typedef HashedSmallMap<Vehicle *, bool, 4> AutoreplaceMap;
 static AutoreplaceMap _vehicles_to_autoreplace;
 
 void InitializeVehicles()
 {
 	_vehicle_pool.CleanPool();
 	_cargo_payment_pool.CleanPool();
+	for (VehicleType type = VEH_TRAIN; type != VEH_END; type++) _vehicle_type_indices[type].Reset();
 
 	_age_cargo_skip_counter = 1;
 
 	_vehicles_to_autoreplace.Reset();
 	ResetVehiclePosHash();
+	ResetEffectParticles();
 }
 
 uint CountVehiclesInChain(const Vehicle *v)
@@ -624,7 +872,10 @@ void Vehicle::PreDestructor()
 
 		DeleteGroupHighlightOfVehicle(this);
 		if (Group::IsValidID(this->group_id)) Group::Get(this->group_id)->num_engines[this->engine_type]--;
-		if (this->IsPrimaryVehicle()) DecreaseGroupNumVehicle(this->group_id);
+		if (this->IsPrimaryVehicle()) {
+			Company::Get(this->owner)->num_vehicles[this->type]--;
+			DecreaseGroupNumVehicle(this->group_id);
+		}
 	}
 
 	if (this->type == VEH_AIRCRAFT && this->IsPrimaryVehicle()) {
@@ -637,6 +888,9 @@ void Vehicle::PreDestructor()
 	}
 
 
+	/* The index of the reservations mustn't give them to a new vehicle with this index. */
+	if (this->type == VEH_TRAIN) ForgetReservationsOfTrain(this->index);
+
 	if (this->type == VEH_ROAD && this->IsPrimaryVehicle()) {
 		RoadVehicle *v = RoadVehicle::From(this);
 		if (!(v->vehstatus & VS_CRASHED) && IsInsideMM(v->state, RVSB_IN_DT_ROAD_STOP, RVSB_IN_DT_ROAD_STOP_END)) {
@@ -657,7 +911,7 @@ void Vehicle::PreDestructor()
 		DeleteWindowById(WC_VEHICLE_TIMETABLE, this->index);
 		SetWindowDirty(WC_COMPANY, this->owner);
 	}
-	InvalidateWindowClassesData(GetWindowClassForVehicleType(this->type), 0);
+	InvalidateVehicleListsOfVehicle(this, true);
 
 	this->cargo.Truncate(0);
 	DeleteVehicleOrders(this);
@@ -675,6 +929,8 @@ Vehicle::~Vehicle()
 
 	if (CleaningPool()) return;
 
+	SetVehicleTypeIndex(this->type, this->index, false);
+
 	/* sometimes, eg. for disaster vehicles, when company bankrupts, when removing crashed/flooded vehicles,
 	 * it may happen that vehicle chain is deleted when visible */
 	if (!(this->vehstatus & VS_HIDDEN)) MarkSingleVehicleDirty(this);
@@ -705,6 +961,32 @@ void VehicleEnteredDepotThisTick(Vehicle *v)
 	v->vehstatus |= VS_STOPPED;
 }
 
+/** Maximum number of depot searches for servicing per tick; further vehicles wait for the next tick. */
+static const uint MAX_SERVICE_DEPOT_SEARCHES_PER_TICK = 8;
+
+/** Number of depot searches for servicing that may still be done in this tick. */
+static uint _service_depot_searches_left;
+
+/**
+ * Whether a vehicle that wants to be serviced may search for a depot now.
+ * Only a limited number of vehicles may search per tick; the others are
+ * marked with #VF_SERVICE_CHECK_PENDING and ask again in their next tick.
+ * As the vehicles tick in the same order on every client, the same
+ * vehicles get to search in the same tick everywhere.
+ * @param v the vehicle that wants to search
+ * @return true if the vehicle may search for a depot now
+ */
+bool MayStartServiceDepotSearch(Vehicle *v)
+{
+	if (_service_depot_searches_left == 0) {
+		SetBit(v->vehicle_flags, VF_SERVICE_CHECK_PENDING);
+		return false;
+	}
+
+	_service_depot_searches_left--;
+	return true;
+}
+
 /**
  * Increases the day counter for all vehicles and calls 1-day and 32-day handlers.
  * Each tick, it processes vehicles with "index % DAY_TICKS == _date_fract",
@@ -733,9 +1015,89 @@ static void RunVehicleDayProc()
 	}
 }
 
+/** Maximum number of threads the cargo of the vehicles is aged with. */
+static const uint MAX_VEHICLE_TICK_THREADS = 16;
+/** Minimum number of vehicles a thread has to age the cargo of to make starting it worth it. */
+static const uint MIN_VEHICLES_PER_THREAD = 512;
+
+/** A range of vehicles of which the cargo is aged by one thread. */
+struct AgeCargoRange {
+	Vehicle **first; ///< The first vehicle of the range.
+	Vehicle **last;  ///< One past the last vehicle of the range.
+};
+
+/**
+ * Age the cargo of a range of vehicles.
+ * This only touches the cargo lists of the vehicles in the range, so
+ * ranges that do not overlap can be aged at the same time.
+ * @param arg The AgeCargoRange to age.
+ */
+static void AgeCargoOfRange(void *arg)
+{
+	const AgeCargoRange *range = (const AgeCargoRange *)arg;
+	for (Vehicle **v = range->first; v != range->last; v++) (*v)->cargo.AgeCargo();
+}
+
+/**
+ * Age the cargo of all vehicles that can carry cargo.
+ * The vehicles are collected in pool order and split into consecutive
+ * ranges; when #GUISettings::vehicle_tick_threads allows it each range
+ * is aged by its own thread. As every vehicle only ages its own cargo
+ * the outcome does not depend on the number of threads used.
+ */
+static void AgeAllVehicleCargo()
+{
+	static SmallVector<Vehicle *, 64> vehicles;
+	vehicles.Clear();
+
+	Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		switch (v->type) {
+			case VEH_TRAIN:
+			case VEH_ROAD:
+			case VEH_AIRCRAFT:
+			case VEH_SHIP:
+				*vehicles.Append() = v;
+				break;
+
+			default: break;
+		}
+	}
+
+	uint num_threads = Clamp(_settings_client.gui.vehicle_tick_threads, 1, MAX_VEHICLE_TICK_THREADS);
+	num_threads = Clamp(vehicles.Length() / MIN_VEHICLES_PER_THREAD, 1, num_threads);
+
+	AgeCargoRange ranges[MAX_VEHICLE_TICK_THREADS];
+	ThreadObject *threads[MAX_VEHICLE_TICK_THREADS];
+	uint per_thread = CeilDiv(vehicles.Length(), num_threads);
+
+	for (uint i = 0; i < num_threads; i++) {
+		ranges[i].first = vehicles.Begin() + min(i * per_thread, vehicles.Length());
+		ranges[i].last  = vehicles.Begin() + min((i + 1) * per_thread, vehicles.Length());
+		threads[i] = NULL;
+
+		/* The main thread ages the first range itself, once the others are started. */
+		if (i == 0) continue;
+		if (!ThreadObject::New(&AgeCargoOfRange, &ranges[i], &threads[i])) {
+			/* No threads available; age this range in the main thread instead. */
+			threads[i] = NULL;
+			AgeCargoOfRange(&ranges[i]);
+		}
+	}
+
+	AgeCargoOfRange(&ranges[0]);
+
+	for (uint i = 1; i < num_threads; i++) {
+		if (threads[i] == NULL) continue;
+		threads[i]->Join();
+		delete threads[i];
+	}
+}
+
 void CallVehicleTicks()
 {
 	_vehicles_to_autoreplace.Clear();
+	_service_depot_searches_left = MAX_SERVICE_DEPOT_SEARCHES_PER_TICK;
 
 	_age_cargo_skip_counter = (_age_cargo_skip_counter == 0) ? 184 : (_age_cargo_skip_counter - 1);
 
@@ -744,39 +1106,60 @@ void CallVehicleTicks()
 	Station *st;
 	FOR_ALL_STATIONS(st) LoadUnloadStation(st);
 
+	/* The vehicles are ticked type by type, in the order of VehicleType, and
+	 * within a type in the order of their index. This order only depends on
+	 * the vehicles in the pool, so a client that just joined and loaded the
+	 * game ticks them in the same order as the server. Vehicles that are
+	 * made during the tick are ticked too when their type is not done yet
+	 * and their index is higher than that of the vehicle being ticked. */
 	Vehicle *v;
-	FOR_ALL_VEHICLES(v) {
-		/* Vehicle could be deleted in this tick */
-		if (!v->Tick()) {
-			assert(Vehicle::Get(vehicle_index) == NULL);
-			continue;
-		}
+	for (VehicleType type = VEH_TRAIN; type != VEH_END; type++) {
+		for (VehicleID vehicle_index = GetNextVehicleOfType(type, 0); vehicle_index != INVALID_VEHICLE; vehicle_index = GetNextVehicleOfType(type, vehicle_index + 1)) {
+			v = Vehicle::Get(vehicle_index);
+			assert(v != NULL && v->type == type);
+
+			/* Vehicle could be deleted in this tick */
+			if (!v->Tick()) {
+				assert(Vehicle::Get(vehicle_index) == NULL);
+				continue;
+			}
 
-		assert(Vehicle::Get(vehicle_index) == v);
+			assert(Vehicle::Get(vehicle_index) == v);
 
-		switch (v->type) {
-			default: break;
+			switch (type) {
+				default: break;
 
-			case VEH_TRAIN:
-			case VEH_ROAD:
-			case VEH_AIRCRAFT:
-			case VEH_SHIP:
-				if (_age_cargo_skip_counter == 0) v->cargo.AgeCargo();
+				case VEH_TRAIN:
+				case VEH_ROAD:
+				case VEH_AIRCRAFT:
+				case VEH_SHIP:
+					if (type == VEH_TRAIN && Train::From(v)->IsWagon()) continue;
+					if (type == VEH_AIRCRAFT && v->subtype != AIR_HELICOPTER) continue;
+					if (type == VEH_ROAD && !RoadVehicle::From(v)->IsRoadVehFront()) continue;
+
+					v->motion_counter += v->cur_speed;
 
-				if (v->type == VEH_TRAIN && Train::From(v)->IsWagon()) continue;
-				if (v->type == VEH_AIRCRAFT && v->subtype != AIR_HELICOPTER) continue;
-				if (v->type == VEH_ROAD && !RoadVehicle::From(v)->IsRoadVehFront()) continue;
+					/* Running sounds can't be followed while fast forwarding,
+					 * and asking the NewGRF for them takes a callback. */
+					if (_fast_forward && !_pause_mode) continue;
 
-				v->motion_counter += v->cur_speed;
-				/* Play a running sound if the motion counter passes 256 (Do we not skip sounds?) */
-				if (GB(v->motion_counter, 0, 8) < v->cur_speed) PlayVehicleSound(v, VSE_RUNNING);
+					/* Play a running sound if the motion counter passes 256 (Do we not skip sounds?) */
+					if (GB(v->motion_counter, 0, 8) < v->cur_speed) PlayVehicleSound(v, VSE_RUNNING);
 
-				/* Play an alterate running sound every 16 ticks */
-				if (GB(v->tick_counter, 0, 4) == 0) PlayVehicleSound(v, v->cur_speed > 0 ? VSE_RUNNING_16 : VSE_STOPPED_16);
+					/* Play an alterate running sound every 16 ticks */
+					if (GB(v->tick_counter, 0, 4) == 0) PlayVehicleSound(v, v->cur_speed > 0 ? VSE_RUNNING_16 : VSE_STOPPED_16);
+			}
 		}
 	}
 
+	CallEffectParticleTicks();
+
+	/* Cargo is aged after all vehicles moved, so the order in which the
+	 * vehicles are aged, and thus the number of threads, does not matter. */
+	if (_age_cargo_skip_counter == 0) AgeAllVehicleCargo();
+
 	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
+	StartAutoreplaceRound();
 	for (AutoreplaceMap::iterator it = _vehicles_to_autoreplace.Begin(); it != _vehicles_to_autoreplace.End(); it++) {
 		v = it->first;
 		/* Autoreplace needs the current company set as the vehicle owner */
@@ -820,12 +1203,21 @@ void CallVehicleTicks()
 		SetDParam(1, error_message);
 		AddVehicleNewsItem(message, NS_ADVICE, v->index);
 	}
+	EndAutoreplaceRound();
 
 	cur_company.Restore();
 }
 
 static void DoDrawVehicle(const Vehicle *v)
 {
+	if (IsViewportLowDetail()) {
+		/* From far away only the vehicles themselves are shown, as a dot in the colour of their owner. */
+		if (v->type == VEH_EFFECT || (v->vehstatus & VS_SHADOW) || (v->type == VEH_AIRCRAFT && !v->IsPrimaryVehicle())) return;
+
+		AddVehicleMarkerToDraw(v->x_pos, v->y_pos, v->z_pos, _colour_gradient[v->owner < MAX_COMPANIES ? _company_colours[v->owner] : COLOUR_WHITE][6]);
+		return;
+	}
+
 	SpriteID image = v->cur_image;
 	PaletteID pal = PAL_NONE;
 
@@ -1154,10 +1546,76 @@ void VehicleEnterDepot(Vehicle *v)
 }
 
 
+/** An area of the viewports to redraw because a vehicle moved from or to there. */
+struct VehicleDirtyArea {
+	VehicleID vehicle; ///< The vehicle that moved.
+	Rect area;         ///< The area, in virtual viewport coordinates.
+};
+
+/** Areas vehicles moved in that have not been passed to the viewports yet. */
+static SmallVector<VehicleDirtyArea, 64> _vehicle_dirty_areas;
+static const uint MAX_VEHICLE_DIRTY_AREAS = 1024; ///< Number of collected areas after which they are passed to the viewports right away.
+
+/**
+ * Pass the areas vehicles moved in to all viewports. Vehicles move a few
+ * pixels at a time, often several times before anything is drawn, so doing
+ * this once before drawing marks each vehicle's area once instead of once
+ * for every step.
+ * @ingroup dirty
+ */
+void FlushVehicleDirtyAreas()
+{
+	for (uint i = 0; i < _vehicle_dirty_areas.Length(); i++) {
+		const VehicleDirtyArea *d = _vehicle_dirty_areas.Get(i);
+		MarkAllViewportsDirty(d->area.left, d->area.top, d->area.right, d->area.bottom);
+
+		/* The vehicle may be gone, or its index may even be reused already. */
+		Vehicle *v = Vehicle::GetIfValid(d->vehicle);
+		if (v != NULL && v->dirty_area == i) v->dirty_area = INVALID_DIRTY_AREA;
+	}
+
+	_vehicle_dirty_areas.Clear();
+}
+
+/**
+ * Collect an area a vehicle moved in, to be marked dirty by #FlushVehicleDirtyAreas.
+ * It is merged with the previous area of the vehicle when their bounding box is
+ * not larger than both areas together, which is the case for small steps.
+ * @param v      The vehicle that moved.
+ * @param left   Left edge of the area.
+ * @param top    Top edge of the area.
+ * @param right  Right edge of the area.
+ * @param bottom Bottom edge of the area.
+ */
+static void AddVehicleDirtyArea(Vehicle *v, int left, int top, int right, int bottom)
+{
+	if (v->dirty_area != INVALID_DIRTY_AREA) {
+		Rect *last = &_vehicle_dirty_areas.Get(v->dirty_area)->area;
+		Rect merged = { min(last->left, left), min(last->top, top), max(last->right, right), max(last->bottom, bottom) };
+
+		int64 merged_area = (int64)(merged.right - merged.left) * (merged.bottom - merged.top);
+		int64 separate_area = (int64)(last->right - last->left) * (last->bottom - last->top) + (int64)(right - left) * (bottom - top);
+		if (merged_area <= separate_area) {
+			*last = merged;
+			return;
+		}
+	}
+
+	if (_vehicle_dirty_areas.Length() >= MAX_VEHICLE_DIRTY_AREAS) FlushVehicleDirtyAreas();
+
+	v->dirty_area = _vehicle_dirty_areas.Length();
+	VehicleDirtyArea *d = _vehicle_dirty_areas.Append();
+	d->vehicle     = v->index;
+	d->area.left   = left;
+	d->area.top    = top;
+	d->area.right  = right;
+	d->area.bottom = bottom;
+}
+
 /**
  * Move a vehicle in the game state; that is moving its position in
  * the position hashes and marking its location in the viewport dirty
- * if requested.
+ * if requested. The viewports are marked dirty by #FlushVehicleDirtyAreas.
  * @param v vehicle to move
  * @param update_viewport whether to dirty the viewport
  */
@@ -1165,6 +1623,15 @@ void VehicleMove(Vehicle *v, bool update_viewport)
 {
 	int img = v->cur_image;
 	Point pt = RemapCoords(v->x_pos + v->x_offs, v->y_pos + v->y_offs, v->z_pos);
+
+	if (BlitterFactoryBase::GetCurrentBlitter()->GetScreenDepth() == 0) {
+		/* Nothing is ever drawn, so do not read and cache the sprite just for its bounds. */
+		UpdateVehiclePosHash(v, pt.x, pt.y);
+		v->coord.left = v->coord.right  = pt.x;
+		v->coord.top  = v->coord.bottom = pt.y;
+		return;
+	}
+
 	const Sprite *spr = GetSprite(img, ST_NORMAL);
 
 	pt.x += spr->x_offs;
@@ -1179,7 +1646,7 @@ void VehicleMove(Vehicle *v, bool update_viewport)
 	v->coord.bottom = pt.y + spr->height + 2;
 
 	if (update_viewport) {
-		MarkAllViewportsDirty(
+		AddVehicleDirtyArea(v,
 			min(old_coord.left,   v->coord.left),
 			min(old_coord.top,    v->coord.top),
 			max(old_coord.right,  v->coord.right) + 1,
@@ -1804,13 +2271,25 @@ void Vehicle::RemoveFromShared()
 	} else if (were_first) {
 		/* If we were the first one, update to the new first one.
 		 * Note: FirstShared() is already the new first */
-		InvalidateWindowData(GetWindowClassForVehicleType(this->type), old_window_number, (this->FirstShared()->index << 16) | (1 << 15));
+		InvalidateWindowData(GetWindowClassForVehicleType(this->type), old_window_number, (this->FirstShared()->index << 16) | (1 << VLI_SHARED_ORDERS));
 	}
 
 	this->next_shared     = NULL;
 	this->previous_shared = NULL;
 }
 
+/**
+ * Tell the vehicle lists that only a single vehicle has been added, has
+ * changed or is about to be removed, so they only have to move that vehicle
+ * instead of rebuilding and resorting all of their vehicles.
+ * @param v The vehicle that changed.
+ * @param removed Whether the vehicle is about to be removed.
+ */
+void InvalidateVehicleListsOfVehicle(const Vehicle *v, bool removed)
+{
+	InvalidateWindowClassesData(GetWindowClassForVehicleType(v->type), (v->index << 16) | (1 << (removed ? VLI_VEHICLE_REMOVED : VLI_VEHICLE_CHANGED)));
+}
+
 void StopAllVehicles()
 {
 	Vehicle *v;
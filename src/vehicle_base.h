@@ -40,6 +40,7 @@ enum VehicleFlags {
 	VF_TIMETABLE_STARTED,       ///< Whether the vehicle has started running on the timetable yet.
 	VF_AUTOFILL_TIMETABLE,      ///< Whether the vehicle should fill in the timetable automatically.
 	VF_AUTOFILL_PRES_WAIT_TIME, ///< Whether non-destructive auto-fill should preserve waiting times
+	VF_SERVICE_CHECK_PENDING,   ///< Whether the vehicle waits for its turn to search for a depot to be serviced at.
 };
 
 /** Cached oftenly queried (NewGRF) values */
@@ -49,6 +50,21 @@ struct VehicleCache {
 	uint32 cached_var41; ///< Cache for NewGRF var 41
 	uint32 cached_var42; ///< Cache for NewGRF var 42
 	uint32 cached_var43; ///< Cache for NewGRF var 43
+
+	const struct SpriteGroup *cached_sprite_group; ///< Group the cached sprite was resolved from; the cached sprite is valid when bit 4 of cache_valid is set
+	uint64 cached_sprite_state; ///< State of the vehicle the cached sprite was resolved for, see GetCustomEngineSprite
+	SpriteID cached_sprite;     ///< First sprite of the set the vehicle resolved to
+	byte cached_sprite_num;     ///< Number of sprites in the set the vehicle resolved to
+};
+
+/** Cached capacity a loading vehicle chain has left per cargo type; only used for the front vehicle. */
+struct LoadReservationCache {
+	static const uint MAX_CARGO_TYPES = 4; ///< Chains with more cargo types than this are not cached
+
+	bool valid;                            ///< Whether the cached capacity is up to date
+	byte num_cargo;                        ///< Number of used entries, or more than MAX_CARGO_TYPES when there are too many cargo types
+	CargoID cargo[MAX_CARGO_TYPES];        ///< The cargo types with capacity left
+	uint cap_left[MAX_CARGO_TYPES];        ///< The capacity left for each of the cargo types
 };
 
 typedef Pool<Vehicle, VehicleID, 512, 64000> VehiclePool;
@@ -102,9 +118,12 @@ public:
 	/* Boundaries for the current position in the world and a next hash link.
 	 * NOSAVE: All of those can be updated with VehiclePositionChanged() */
 	Rect coord;
+	uint16 dirty_area; ///< Index in the collected dirty areas of where the vehicle moved last, or INVALID_DIRTY_AREA.
 	Vehicle *next_hash, **prev_hash;
 	Vehicle *next_new_hash, **prev_new_hash;
 	Vehicle **old_new_hash;
+	Vehicle *next_typed_hash, **prev_typed_hash; ///< Links in the hash by tile of only the vehicles of this type; for road vehicles and trains.
+	Vehicle **old_typed_hash;                    ///< The bucket of the hash of vehicles of this type this vehicle is in.
 
 	SpriteID colourmap; // NOSAVE: cached colour mapping
 
@@ -184,6 +203,7 @@ public:
 	byte subtype;                   ///< subtype (Filled with values from EffectVehicles/TrainSubTypes/AircraftSubTypes)
 
 	VehicleCache vcache;            ///< Cache of often used calculated values
+	LoadReservationCache lrcache;   ///< NOSAVE: Cache of the capacity left while loading
 
 	/** Create a new vehicle */
 	Vehicle(VehicleType type = VEH_INVALID);
@@ -755,5 +775,6 @@ struct FreeUnitIDGenerator {
 };
 
 static const int32 INVALID_COORD = 0x7fffffff;
+static const uint16 INVALID_DIRTY_AREA = 0xFFFF; ///< Vehicle::dirty_area of a vehicle that did not move since the areas were flushed.
 
 #endif /* VEHICLE_BASE_H */
@@ -34,6 +34,10 @@ void FindVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 void FindVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
 bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
+void FindRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
+void FindRoadVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
+bool HasRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
+bool HasTrainOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 void CallVehicleTicks();
 uint8 CalcPercentVehicleFilled(const Vehicle *v, StringID *colour);
 
@@ -53,9 +57,11 @@ void DecreaseVehicleValue(Vehicle *v);
 void CheckVehicleBreakdown(Vehicle *v);
 void AgeVehicle(Vehicle *v);
 void VehicleEnteredDepotThisTick(Vehicle *v);
+bool MayStartServiceDepotSearch(Vehicle *v);
 
 void VehicleMove(Vehicle *v, bool update_viewport);
 void MarkSingleVehicleDirty(const Vehicle *v);
+void FlushVehicleDirtyAreas();
 
 UnitID GetFreeUnitNumber(VehicleType type);
 
@@ -172,4 +178,6 @@ bool CanVehicleUseStation(const Vehicle *v, const struct Station *st);
 
 void ReleaseDisastersTargetingVehicle(VehicleID vehicle);
 
+void InvalidateVehicleListsOfVehicle(const Vehicle *v, bool removed = false);
+
 #endif /* VEHICLE_FUNC_H */
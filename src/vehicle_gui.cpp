@@ -104,6 +104,21 @@ const StringID BaseVehicleListWindow::vehicle_depot_name[] = {
 	STR_VEHICLE_LIST_SEND_AIRCRAFT_TO_HANGAR
 };
 
+/**
+ * Get the number of digits to reserve space for when drawing unit numbers.
+ * @param unitnumber The highest unit number to draw.
+ * @return The number of digits.
+ */
+static byte GetUnitNumberDigits(uint unitnumber)
+{
+	/* Because 111 is much less wide than e.g. 999 we use the
+	 * wider numbers to determine the width instead of just
+	 * the random number that it seems to be. */
+	if (unitnumber >= 1000) return 4;
+	if (unitnumber >= 100) return 3;
+	return 2;
+}
+
 void BaseVehicleListWindow::BuildVehicleList(Owner owner, uint16 index, uint16 window_type)
 {
 	if (!this->vehicles.NeedRebuild()) return;
@@ -117,16 +132,7 @@ void BaseVehicleListWindow::BuildVehicleList(Owner owner, uint16 index, uint16 w
 		unitnumber = max<uint>(unitnumber, (*v)->unitnumber);
 	}
 
-	/* Because 111 is much less wide than e.g. 999 we use the
-	 * wider numbers to determine the width instead of just
-	 * the random number that it seems to be. */
-	if (unitnumber >= 1000) {
-		this->unitnumber_digits = 4;
-	} else if (unitnumber >= 100) {
-		this->unitnumber_digits = 3;
-	} else {
-		this->unitnumber_digits = 2;
-	}
+	this->unitnumber_digits = GetUnitNumberDigits(unitnumber);
 
 	this->vehicles.RebuildDone();
 	this->vscroll.SetCount(this->vehicles.Length());
@@ -177,14 +183,44 @@ DropDownList *BaseVehicleListWindow::BuildActionDropdownList(bool show_autorepla
 }
 
 /* cached values for VehicleNameSorter to spare many GetString() calls */
-static const Vehicle *_last_vehicle[2] = { NULL, NULL };
+static NameCache _vehicle_names(STR_VEHICLE_NAME);
 
 void BaseVehicleListWindow::SortVehicleList()
 {
-	if (this->vehicles.Sort()) return;
+	if (!this->vehicles.Sort()) return;
 
 	/* invalidate cached values for name sorter - vehicle names could change */
-	_last_vehicle[0] = _last_vehicle[1] = NULL;
+	_vehicle_names.Clear();
+}
+
+/**
+ * Apply the change of a single vehicle to the list of vehicles. Only that
+ * vehicle is added, moved or removed, which is a lot cheaper than rebuilding
+ * and resorting the whole list.
+ * @param vehicle     The vehicle that has been added or changed, or that is about to be removed.
+ * @param removed     Whether the vehicle is about to be removed.
+ * @param owner       Company the list is shown for.
+ * @param index       Index of the list, see #GenerateVehicleSortList.
+ * @param window_type The type of window the list is for.
+ */
+void BaseVehicleListWindow::UpdateVehicleInList(VehicleID vehicle, bool removed, Owner owner, uint16 index, uint16 window_type)
+{
+	/* The list is going to be built from scratch anyway. */
+	if (this->vehicles.NeedRebuild()) return;
+
+	const Vehicle *v = Vehicle::GetIfValid(vehicle);
+	if (v == NULL) return;
+
+	if (removed || !IsVehicleInSortList(v, this->vehicle_type, owner, index, window_type)) {
+		if (!this->vehicles.RemoveItem(v)) return;
+	} else {
+		this->vehicles.SortItem(v);
+		/* invalidate cached values for name sorter - vehicle names could change */
+		_vehicle_names.Clear();
+		this->unitnumber_digits = max(this->unitnumber_digits, GetUnitNumberDigits(v->unitnumber));
+	}
+
+	this->vscroll.SetCount(this->vehicles.Length());
 }
 
 void DepotSortList(VehicleList *list)
@@ -668,21 +704,7 @@ static int CDECL VehicleNumberSorter(const Vehicle * const *a, const Vehicle * c
 /** Sort vehicles by their name */
 static int CDECL VehicleNameSorter(const Vehicle * const *a, const Vehicle * const *b)
 {
-	static char last_name[2][64];
-
-	if (*a != _last_vehicle[0]) {
-		_last_vehicle[0] = *a;
-		SetDParam(0, (*a)->index);
-		GetString(last_name[0], STR_VEHICLE_NAME, lastof(last_name[0]));
-	}
-
-	if (*b != _last_vehicle[1]) {
-		_last_vehicle[1] = *b;
-		SetDParam(0, (*b)->index);
-		GetString(last_name[1], STR_VEHICLE_NAME, lastof(last_name[1]));
-	}
-
-	int r = strcmp(last_name[0], last_name[1]);
+	int r = strcmp(_vehicle_names.Get((*a)->index), _vehicle_names.Get((*b)->index));
 	return (r != 0) ? r : VehicleNumberSorter(a, b);
 }
 
@@ -1294,12 +1316,17 @@ public:
 
 	virtual void OnInvalidateData(int data)
 	{
-		if (HasBit(data, 15) && (this->window_number & VLW_MASK) == VLW_SHARED_ORDERS) {
+		if (HasBit(data, VLI_SHARED_ORDERS) && (this->window_number & VLW_MASK) == VLW_SHARED_ORDERS) {
 			SB(this->window_number, 16, 16, GB(data, 16, 16));
 			this->vehicles.ForceRebuild();
 			return;
 		}
 
+		if (HasBit(data, VLI_VEHICLE_CHANGED) || HasBit(data, VLI_VEHICLE_REMOVED)) {
+			this->UpdateVehicleInList(GB(data, 16, 16), HasBit(data, VLI_VEHICLE_REMOVED), this->owner, GB(this->window_number, 16, 16), this->window_number & VLW_MASK);
+			return;
+		}
+
 		if (data == 0) {
 			this->vehicles.ForceRebuild();
 		} else {
@@ -1311,7 +1338,7 @@ public:
 static WindowDesc _vehicle_list_desc(
 	WDP_AUTO, 260, 246,
 	WC_INVALID, WC_NONE,
-	WDF_UNCLICK_BUTTONS,
+	WDF_UNCLICK_BUTTONS | WDF_IMMEDIATE_INVALIDATE,
 	_nested_vehicle_list, lengthof(_nested_vehicle_list)
 );
 
@@ -56,6 +56,18 @@ enum VehicleListWindowType {
 	VLW_MASK          = 0x700,
 };
 
+/**
+ * Bits in the data of vehicle list invalidations. When one of these is set
+ * the upper 16 bits hold the index of the vehicle the invalidation is about.
+ * They only make sense at the moment they are sent, so the vehicle lists
+ * get their invalidations immediately, see #WDF_IMMEDIATE_INVALIDATE.
+ */
+enum VehicleListInvalidationBits {
+	VLI_VEHICLE_REMOVED = 13, ///< Only this vehicle is about to be removed
+	VLI_VEHICLE_CHANGED = 14, ///< Only this vehicle has been added or changed
+	VLI_SHARED_ORDERS   = 15, ///< This vehicle is the new head of the shared orders
+};
+
 static inline bool ValidVLWFlags(uint16 flags)
 {
 	return (flags == VLW_STANDARD || flags == VLW_SHARED_ORDERS || flags == VLW_STATION_LIST || flags == VLW_DEPOT_LIST || flags == VLW_GROUP_LIST);
@@ -61,6 +61,54 @@ void BuildDepotVehicleList(VehicleType type, TileIndex tile, VehicleList *engine
 	if (wagons != NULL && wagons != engines) wagons->Compact();
 }
 
+/**
+ * Check whether a vehicle belongs in a list generated by #GenerateVehicleSortList.
+ * @param v           The vehicle to check
+ * @param type        Type of vehicle
+ * @param owner       Company the list is generated for
+ * @param index       This parameter has different meanings depending on window_type, see #GenerateVehicleSortList
+ * @param window_type The type of window the list is for, using the VLW_ flags in vehicle_gui.h
+ * @return true if the vehicle is part of the list
+ */
+bool IsVehicleInSortList(const Vehicle *v, VehicleType type, Owner owner, uint32 index, uint16 window_type)
+{
+	if (v->type != type || !v->IsPrimaryVehicle()) return false;
+
+	const Order *order;
+
+	switch (window_type) {
+		case VLW_STATION_LIST:
+			FOR_VEHICLE_ORDERS(v, order) {
+				if ((order->IsType(OT_GOTO_STATION) || order->IsType(OT_GOTO_WAYPOINT))
+						&& order->GetDestination() == index) {
+					return true;
+				}
+			}
+			return false;
+
+		case VLW_SHARED_ORDERS: {
+			const Vehicle *shared = Vehicle::GetIfValid(index);
+			return shared != NULL && shared->FirstShared() == v->FirstShared();
+		}
+
+		case VLW_STANDARD:
+			return v->owner == owner;
+
+		case VLW_DEPOT_LIST:
+			FOR_VEHICLE_ORDERS(v, order) {
+				if (order->IsType(OT_GOTO_DEPOT) && !(order->GetDepotActionType() & ODATFB_NEAREST_DEPOT) && order->GetDestination() == index) {
+					return true;
+				}
+			}
+			return false;
+
+		case VLW_GROUP_LIST:
+			return v->owner == owner && v->group_id == index;
+
+		default: return false;
+	}
+}
+
 /**
  * Generate a list of vehicles based on window type.
  * @param list        Pointer to list to add vehicles to
@@ -84,22 +132,6 @@ bool GenerateVehicleSortList(VehicleList *list, VehicleType type, Owner owner, u
 	const Vehicle *v;
 
 	switch (window_type) {
-		case VLW_STATION_LIST:
-			FOR_ALL_VEHICLES(v) {
-				if (v->type == type && v->IsPrimaryVehicle()) {
-					const Order *order;
-
-					FOR_VEHICLE_ORDERS(v, order) {
-						if ((order->IsType(OT_GOTO_STATION) || order->IsType(OT_GOTO_WAYPOINT))
-								&& order->GetDestination() == index) {
-							*list->Append() = v;
-							break;
-						}
-					}
-				}
-			}
-			break;
-
 		case VLW_SHARED_ORDERS:
 			/* Add all vehicles from this vehicle's shared order list */
 			v = Vehicle::GetIfValid(index);
@@ -110,35 +142,12 @@ bool GenerateVehicleSortList(VehicleList *list, VehicleType type, Owner owner, u
 			}
 			break;
 
+		case VLW_STATION_LIST:
 		case VLW_STANDARD:
-			FOR_ALL_VEHICLES(v) {
-				if (v->type == type && v->owner == owner && v->IsPrimaryVehicle()) {
-					*list->Append() = v;
-				}
-			}
-			break;
-
 		case VLW_DEPOT_LIST:
-			FOR_ALL_VEHICLES(v) {
-				if (v->type == type && v->IsPrimaryVehicle()) {
-					const Order *order;
-
-					FOR_VEHICLE_ORDERS(v, order) {
-						if (order->IsType(OT_GOTO_DEPOT) && !(order->GetDepotActionType() & ODATFB_NEAREST_DEPOT) && order->GetDestination() == index) {
-							*list->Append() = v;
-							break;
-						}
-					}
-				}
-			}
-			break;
-
 		case VLW_GROUP_LIST:
 			FOR_ALL_VEHICLES(v) {
-				if (v->type == type && v->IsPrimaryVehicle() &&
-						v->owner == owner && v->group_id == index) {
-					*list->Append() = v;
-				}
+				if (IsVehicleInSortList(v, type, owner, index, window_type)) *list->Append() = v;
 			}
 			break;
 
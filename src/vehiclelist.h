@@ -19,6 +19,7 @@
 
 typedef SmallVector<const Vehicle *, 32> VehicleList;
 
+bool IsVehicleInSortList(const Vehicle *v, VehicleType type, Owner owner, uint32 index, uint16 window_type);
 bool GenerateVehicleSortList(VehicleList *list, VehicleType type, Owner owner, uint32 index, uint16 window_type);
 void BuildDepotVehicleList(VehicleType type, TileIndex tile, VehicleList *engine_list, VehicleList *wagon_list, bool individual_wagons = false);
 
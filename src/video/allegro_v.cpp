@@ -24,6 +24,7 @@
 #include "../network/network.h"
 #include "../core/random_func.hpp"
 #include "../functions.h"
+#include "../debug.h"
 #include "allegro_v.h"
 #include <allegro.h>
 
@@ -450,33 +451,14 @@ void VideoDriver_Allegro::Stop()
 	if (--_allegro_instance_count == 0) allegro_exit();
 }
 
-#if defined(UNIX) || defined(__OS2__) || defined(PSP) || defined(DOS)
-# include <sys/time.h> /* gettimeofday */
-
-static uint32 GetTime()
-{
-	struct timeval tim;
-
-	gettimeofday(&tim, NULL);
-	return tim.tv_usec / 1000 + tim.tv_sec * 1000;
-}
-#else
-static uint32 GetTime()
-{
-	return GetTickCount();
-}
-#endif
-
-
 void VideoDriver_Allegro::MainLoop()
 {
-	uint32 cur_ticks = GetTime();
-	uint32 last_cur_ticks = cur_ticks;
-	uint32 next_tick = cur_ticks + 30;
+	uint64 cur_ticks = GetMonotonicMilliseconds();
+	uint64 last_cur_ticks = cur_ticks;
+	uint64 next_tick = cur_ticks + 30;
 	uint32 pal_tick = 0;
 
 	for (;;) {
-		uint32 prev_cur_ticks = cur_ticks; // to check for wrapping
 		InteractiveRandom(); // randomness
 
 		PollEvent();
@@ -495,9 +477,9 @@ void VideoDriver_Allegro::MainLoop()
 			_fast_forward = 0;
 		}
 
-		cur_ticks = GetTime();
-		if (cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks) {
-			_realtime_tick += cur_ticks - last_cur_ticks;
+		cur_ticks = GetMonotonicMilliseconds();
+		if (cur_ticks >= next_tick || (_fast_forward && !_pause_mode)) {
+			_realtime_tick += (uint32)(cur_ticks - last_cur_ticks);
 			last_cur_ticks = cur_ticks;
 			next_tick = cur_ticks + 30;
 
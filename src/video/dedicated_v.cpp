@@ -23,6 +23,7 @@
 #include "../blitter/factory.hpp"
 #include "../company_func.h"
 #include "../core/random_func.hpp"
+#include "../debug.h"
 #include "dedicated_v.h"
 
 #ifdef BEOS_NET_SERVER
@@ -30,7 +31,7 @@
 #endif
 
 #ifdef __OS2__
-#	include <sys/time.h> /* gettimeofday */
+#	include <sys/time.h> /* timeval */
 #	include <sys/types.h>
 #	include <unistd.h>
 #	include <conio.h>
@@ -56,7 +57,7 @@ static void OS2_SwitchToConsoleMode()
 #endif
 
 #if defined(UNIX) || defined(PSP)
-#	include <sys/time.h> /* gettimeofday */
+#	include <sys/time.h> /* timeval */
 #	include <sys/types.h>
 #	include <unistd.h>
 #	include <signal.h>
@@ -75,7 +76,7 @@ static void DedicatedSignalHandler(int sig)
 #endif
 
 #if defined(WIN32)
-# include <windows.h> /* GetTickCount */
+# include <windows.h>
 # if !defined(WINCE)
 #  include <conio.h>
 # endif
@@ -197,14 +198,6 @@ static bool InputWaiting()
 	return select(STDIN + 1, &readfds, NULL, NULL, &tv) > 0;
 }
 
-static uint32 GetTime()
-{
-	struct timeval tim;
-
-	gettimeofday(&tim, NULL);
-	return tim.tv_usec / 1000 + tim.tv_sec * 1000;
-}
-
 #else
 
 static bool InputWaiting()
@@ -212,11 +205,6 @@ static bool InputWaiting()
 	return WaitForSingleObject(_hInputReady, 1) == WAIT_OBJECT_0;
 }
 
-static uint32 GetTime()
-{
-	return GetTickCount();
-}
-
 #endif
 
 static void DedicatedHandleKeyInput()
@@ -250,10 +238,15 @@ static void DedicatedHandleKeyInput()
 	IConsoleCmdExec(input_line); // execute command
 }
 
+/** The time between two ticks, in milliseconds. */
+static const uint64 DEDICATED_TICK_LENGTH = 30;
+/** How far the ticks may get behind before the missed ones are skipped instead of caught up with, in milliseconds. */
+static const uint64 DEDICATED_MAX_CATCH_UP = 10 * DEDICATED_TICK_LENGTH;
+
 void VideoDriver_Dedicated::MainLoop()
 {
-	uint32 cur_ticks = GetTime();
-	uint32 next_tick = cur_ticks + 30;
+	uint64 cur_ticks = GetMonotonicMilliseconds();
+	uint64 next_tick = cur_ticks + DEDICATED_TICK_LENGTH;
 
 	/* Signal handlers */
 #if defined(UNIX) || defined(PSP)
@@ -263,12 +256,14 @@ void VideoDriver_Dedicated::MainLoop()
 #endif
 
 	/* Load the dedicated server stuff */
-	_is_network_server = true;
+	_is_network_server = !_network_relay;
 	_network_dedicated = true;
 	_current_company = _local_company = COMPANY_SPECTATOR;
 
-	/* If SwitchMode is SM_LOAD, it means that the user used the '-g' options */
-	if (_switch_mode != SM_LOAD) {
+	/* A relay gets its game from the server it is joining */
+	if (_network_relay) {
+		_switch_mode = SM_NONE;
+	} else if (_switch_mode != SM_LOAD) {
 		StartNewGameWithoutGUI(GENERATE_NEW_SEED);
 		SwitchToMode(_switch_mode);
 		_switch_mode = SM_NONE;
@@ -288,28 +283,36 @@ void VideoDriver_Dedicated::MainLoop()
 
 	/* Done loading, start game! */
 
-	if (!_networking) {
+	if (!_networking && !_network_relay) {
 		DEBUG(net, 0, "Dedicated server could not be started, aborting");
 		return;
 	}
 
+	/* The ticks are planned on a fixed timeline instead of relative to the
+	 * end of the previous tick, so a tick that takes long is made up for by
+	 * the next ones and the game runs at exactly its speed. There are no
+	 * windows to update, as nothing is drawn. */
 	while (!_exit_game) {
-		uint32 prev_cur_ticks = cur_ticks; // to check for wrapping
+		uint64 prev_cur_ticks = cur_ticks;
 		InteractiveRandom(); // randomness
 
 		if (!_dedicated_forks) DedicatedHandleKeyInput();
 
-		cur_ticks = GetTime();
-		_realtime_tick += cur_ticks - prev_cur_ticks;
-		if (cur_ticks >= next_tick || cur_ticks < prev_cur_ticks || _ddc_fastforward) {
-			next_tick = cur_ticks + 30;
+		cur_ticks = GetMonotonicMilliseconds();
+		_realtime_tick += (uint32)(cur_ticks - prev_cur_ticks);
+
+		if (cur_ticks >= next_tick || _ddc_fastforward) {
+			/* When far behind, e.g. after a slow save, skip the missed ticks. */
+			if (cur_ticks - next_tick > DEDICATED_MAX_CATCH_UP || _ddc_fastforward) next_tick = cur_ticks;
+			next_tick += DEDICATED_TICK_LENGTH;
 
 			GameLoop();
-			UpdateWindows();
+			continue;
 		}
 
-		/* Don't sleep when fast forwarding (for desync debugging) */
-		if (!_ddc_fastforward) CSleep(1);
+		/* Sleep till the next tick, but handle packets as soon as they come in. */
+		uint until_tick = (uint)(next_tick - cur_ticks);
+		if (!NetworkWaitForPackets(until_tick)) CSleep(until_tick);
 	}
 }
 
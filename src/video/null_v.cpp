@@ -12,13 +12,78 @@
 #include "../stdafx.h"
 #include "../gfx_func.h"
 #include "../blitter/factory.hpp"
+#include "../tick_profiler.h"
+#include "../vehicle_base.h"
+#include "../station_base.h"
+#include "../roadstop_base.h"
+#include "../town.h"
+#include "../industry.h"
+#include "../debug.h"
 #include "null_v.h"
 
+#if defined(WIN32)
+#	include <windows.h>
+
+/** @return The peak resident set size of the process in kilobytes, or 0 when unknown. */
+static uint GetPeakMemoryUsage()
+{
+	return 0;
+}
+
+#else
+#	if defined(UNIX) && !defined(__OS2__)
+#		include <sys/resource.h> /* getrusage */
+#	endif
+
+/** @return The peak resident set size of the process in kilobytes, or 0 when unknown. */
+static uint GetPeakMemoryUsage()
+{
+#if defined(UNIX) && !defined(__OS2__)
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#	if defined(__APPLE__)
+	/* OS X reports bytes instead of kilobytes. */
+	return usage.ru_maxrss / 1024;
+#	else
+	return usage.ru_maxrss;
+#	endif
+#else
+	return 0;
+#endif
+}
+
+#endif
+
 static FVideoDriver_Null iFVideoDriver_Null;
 
+/**
+ * Write the results of a benchmark run to the standard output
+ * as 'key=value' lines, so they can be compared by scripts.
+ * @param ticks   The number of ticks that were run.
+ * @param time_ms The time it took to run them, in milliseconds.
+ */
+static void WriteBenchmarkResults(uint ticks, uint32 time_ms)
+{
+	printf("ticks=%u\n", ticks);
+	printf("time_ms=%u\n", time_ms);
+	printf("ticks_per_second=%u\n", time_ms == 0 ? 0 : (uint)((uint64)ticks * 1000 / time_ms));
+	printf("peak_rss_kb=%u\n", GetPeakMemoryUsage());
+	TickProfilerWrite(stdout);
+	printf("pool.vehicles=%u\n", (uint)Vehicle::GetNumItems());
+	printf("pool.orders=%u\n", (uint)Order::GetNumItems());
+	printf("pool.orderlists=%u\n", (uint)OrderList::GetNumItems());
+	printf("pool.cargopackets=%u\n", (uint)CargoPacket::GetNumItems());
+	printf("pool.stations=%u\n", (uint)BaseStation::GetNumItems());
+	printf("pool.roadstops=%u\n", (uint)RoadStop::GetNumItems());
+	printf("pool.towns=%u\n", (uint)Town::GetNumItems());
+	printf("pool.industries=%u\n", (uint)Industry::GetNumItems());
+	fflush(stdout);
+}
+
 const char *VideoDriver_Null::Start(const char * const *parm)
 {
 	this->ticks = GetDriverParamInt(parm, "ticks", 1000);
+	this->benchmark = GetDriverParamBool(parm, "benchmark");
 	_screen.width  = _screen.pitch = _cur_resolution.width;
 	_screen.height = _cur_resolution.height;
 	_screen.dst_ptr = NULL;
@@ -38,10 +103,16 @@ void VideoDriver_Null::MainLoop()
 {
 	uint i;
 
+	/* Only measure running the game, not loading it. */
+	if (this->benchmark) TickProfilerReset();
+	uint64 start = GetMonotonicMilliseconds();
+
 	for (i = 0; i < this->ticks; i++) {
 		GameLoop();
 		UpdateWindows();
 	}
+
+	if (this->benchmark) WriteBenchmarkResults(this->ticks, (uint32)(GetMonotonicMilliseconds() - start));
 }
 
 bool VideoDriver_Null::ChangeResolution(int w, int h) { return false; }
@@ -16,7 +16,8 @@
 
 class VideoDriver_Null: public VideoDriver {
 private:
-	uint ticks;
+	uint ticks;      ///< Number of ticks to run before quitting.
+	bool benchmark;  ///< Whether to report the performance after running the ticks.
 
 public:
 	/* virtual */ const char *Start(const char * const *param);
@@ -22,6 +22,7 @@
 #include "../thread/thread.h"
 #include "../genworld.h"
 #include "../core/random_func.hpp"
+#include "../debug.h"
 #include "sdl_v.h"
 #include <SDL.h>
 
@@ -50,8 +51,20 @@ void VideoDriver_SDL::MakeDirty(int left, int top, int width, int height)
 		_dirty_rects[_num_dirty_rects].y = top;
 		_dirty_rects[_num_dirty_rects].w = width;
 		_dirty_rects[_num_dirty_rects].h = height;
+		_num_dirty_rects++;
+		return;
 	}
-	_num_dirty_rects++;
+
+	/* No room for another rectangle; grow the last one to cover this one
+	 * too. That is still far less to copy than the whole screen, e.g. for
+	 * many vehicles moving in a big window. */
+	SDL_Rect *r = &_dirty_rects[MAX_DIRTY_RECTS - 1];
+	int right = max(r->x + r->w, left + width);
+	int bottom = max(r->y + r->h, top + height);
+	r->x = min<int>(r->x, left);
+	r->y = min<int>(r->y, top);
+	r->w = right - r->x;
+	r->h = bottom - r->y;
 }
 
 static void UpdatePalette(uint start, uint count)
@@ -103,11 +116,7 @@ static void DrawSurfaceToScreen()
 	if (n == 0) return;
 
 	_num_dirty_rects = 0;
-	if (n > MAX_DIRTY_RECTS) {
-		SDL_CALL SDL_UpdateRect(_sdl_screen, 0, 0, 0, 0);
-	} else {
-		SDL_CALL SDL_UpdateRects(_sdl_screen, n, _dirty_rects);
-	}
+	SDL_CALL SDL_UpdateRects(_sdl_screen, n, _dirty_rects);
 }
 
 static void DrawSurfaceToScreenThread(void *)
@@ -366,11 +375,30 @@ static uint32 ConvertSdlKeyIntoMy(SDL_keysym *sym)
 	return (key << 16) + sym->unicode;
 }
 
+/** Whether the mouse moved since the mouse events were last handled. */
+static bool _mouse_moved = false;
+
+/**
+ * Handle the mouse movement that has been collected so far. Mouse motion is
+ * coalesced, so a fast polling mouse does not make the windows be searched
+ * and notified for every single position it reports.
+ */
+static void HandleMouseMotion()
+{
+	if (!_mouse_moved) return;
+
+	_mouse_moved = false;
+	HandleMouseEvents();
+}
+
 static int PollEvent()
 {
 	SDL_Event ev;
 
-	if (!SDL_CALL SDL_PollEvent(&ev)) return -2;
+	if (!SDL_CALL SDL_PollEvent(&ev)) {
+		HandleMouseMotion();
+		return -2;
+	}
 
 	switch (ev.type) {
 		case SDL_MOUSEMOTION:
@@ -378,21 +406,24 @@ static int PollEvent()
 				int dx = ev.motion.x - _cursor.pos.x;
 				int dy = ev.motion.y - _cursor.pos.y;
 				if (dx != 0 || dy != 0) {
-					_cursor.delta.x = dx;
-					_cursor.delta.y = dy;
+					_cursor.delta.x += dx;
+					_cursor.delta.y += dy;
 					SDL_CALL SDL_WarpMouse(_cursor.pos.x, _cursor.pos.y);
 				}
 			} else {
-				_cursor.delta.x = ev.motion.x - _cursor.pos.x;
-				_cursor.delta.y = ev.motion.y - _cursor.pos.y;
+				_cursor.delta.x += ev.motion.x - _cursor.pos.x;
+				_cursor.delta.y += ev.motion.y - _cursor.pos.y;
 				_cursor.pos.x = ev.motion.x;
 				_cursor.pos.y = ev.motion.y;
 				_cursor.dirty = true;
 			}
-			HandleMouseEvents();
+			_mouse_moved = true;
 			break;
 
 		case SDL_MOUSEBUTTONDOWN:
+			/* The movement made before the button changed belongs to the old state. */
+			HandleMouseMotion();
+
 			if (_rightclick_emulate && SDL_CALL SDL_GetModState() & KMOD_CTRL) {
 				ev.button.button = SDL_BUTTON_RIGHT;
 			}
@@ -416,6 +447,8 @@ static int PollEvent()
 			break;
 
 		case SDL_MOUSEBUTTONUP:
+			HandleMouseMotion();
+
 			if (_rightclick_emulate) {
 				_right_button_down = false;
 				_left_button_down = false;
@@ -445,6 +478,8 @@ static int PollEvent()
 			break;
 
 		case SDL_KEYDOWN: // Toggle full-screen on ALT + ENTER/F
+			HandleMouseMotion();
+
 			if ((ev.key.keysym.mod & (KMOD_ALT | KMOD_META)) &&
 					(ev.key.keysym.sym == SDLK_RETURN || ev.key.keysym.sym == SDLK_f)) {
 				ToggleFullScreen(!_fullscreen);
@@ -495,9 +530,11 @@ void VideoDriver_SDL::Stop()
 
 void VideoDriver_SDL::MainLoop()
 {
-	uint32 cur_ticks = SDL_CALL SDL_GetTicks();
-	uint32 last_cur_ticks = cur_ticks;
-	uint32 next_tick = cur_ticks + 30;
+	uint64 cur_ticks = GetMonotonicMilliseconds();
+	uint64 last_cur_ticks = cur_ticks;
+	uint64 next_tick = cur_ticks + 30;
+	uint64 next_draw = cur_ticks;
+	uint skipped_draws = 0;
 	uint32 pal_tick = 0;
 	uint32 mod;
 	int numkeys;
@@ -529,7 +566,6 @@ void VideoDriver_SDL::MainLoop()
 	DEBUG(driver, 1, "SDL: using %sthreads", _draw_threaded ? "" : "no ");
 
 	for (;;) {
-		uint32 prev_cur_ticks = cur_ticks; // to check for wrapping
 		InteractiveRandom(); // randomness
 
 		while (PollEvent() == -1) {}
@@ -550,9 +586,10 @@ void VideoDriver_SDL::MainLoop()
 			_fast_forward = 0;
 		}
 
-		cur_ticks = SDL_CALL SDL_GetTicks();
-		if (cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks) {
-			_realtime_tick += cur_ticks - last_cur_ticks;
+		cur_ticks = GetMonotonicMilliseconds();
+		bool tick = cur_ticks >= next_tick || (_fast_forward && !_pause_mode);
+		if (tick) {
+			_realtime_tick += (uint32)(cur_ticks - last_cur_ticks);
 			last_cur_ticks = cur_ticks;
 			next_tick = cur_ticks + 30;
 
@@ -578,12 +615,31 @@ void VideoDriver_SDL::MainLoop()
 
 			if (_draw_threaded) _draw_mutex->BeginCritical();
 
-			UpdateWindows();
+			TickWindows();
 			if (++pal_tick > 4) {
 				CheckPaletteAnim();
 				pal_tick = 1;
 			}
-		} else {
+		}
+
+		/* Draw at the refresh rate, whatever the speed of the game. */
+		bool drawn = false;
+		cur_ticks = GetMonotonicMilliseconds();
+		if (cur_ticks >= next_draw) {
+			if (tick && cur_ticks >= next_tick && skipped_draws < MAX_SKIPPED_DRAWS) {
+				/* The tick took so long the next one is due already; let the game catch up first. */
+				skipped_draws++;
+			} else {
+				next_draw += GetDrawInterval();
+				if (cur_ticks >= next_draw) next_draw = cur_ticks + GetDrawInterval();
+				skipped_draws = 0;
+
+				DrawWindows();
+				drawn = true;
+			}
+		}
+
+		if (!tick && !drawn) {
 			/* Release the thread while sleeping */
 			if (_draw_threaded) _draw_mutex->EndCritical();
 			CSleep(1);
@@ -19,6 +19,21 @@ class VideoDriver: public Driver {
 public:
 	virtual void MakeDirty(int left, int top, int width, int height) = 0;
 
+	/**
+	 * Move what is shown of an area of the screen, as it is moved in the
+	 * screen buffer right after this. What the screen buffer shows of the
+	 * area must be on the screen first. The uncovered parts are made dirty
+	 * by whoever draws them.
+	 * @param left   left edge of the area
+	 * @param top    top edge of the area
+	 * @param width  width of the area
+	 * @param height height of the area
+	 * @param xo     pixels to move to the right
+	 * @param yo     pixels to move down
+	 * @return false if the driver can't, and the whole area has to be made dirty
+	 */
+	virtual bool ScrollScreen(int left, int top, int width, int height, int xo, int yo) { return false; }
+
 	virtual void MainLoop() = 0;
 
 	virtual bool ChangeResolution(int w, int h) = 0;
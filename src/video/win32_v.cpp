@@ -20,6 +20,7 @@
 #include "../core/random_func.hpp"
 #include "../functions.h"
 #include "../texteff.hpp"
+#include "../debug.h"
 #include "win32_v.h"
 #include <windows.h>
 
@@ -820,6 +821,17 @@ void VideoDriver_Win32::MakeDirty(int left, int top, int width, int height)
 	InvalidateRect(_wnd.main_wnd, &r, FALSE);
 }
 
+bool VideoDriver_Win32::ScrollScreen(int left, int top, int width, int height, int xo, int yo)
+{
+	/* Paint what is dirty first, so the window shows what the buffer does before it is scrolled. */
+	UpdateWindow(_wnd.main_wnd);
+
+	/* Parts that can't be moved, e.g. as they are covered by other windows, are invalidated. */
+	RECT r = { left, top, left + width, top + height };
+	ScrollWindowEx(_wnd.main_wnd, xo, yo, &r, &r, NULL, NULL, SW_INVALIDATE);
+	return true;
+}
+
 static void CheckPaletteAnim()
 {
 	if (_pal_count_dirty == 0)
@@ -830,14 +842,15 @@ static void CheckPaletteAnim()
 void VideoDriver_Win32::MainLoop()
 {
 	MSG mesg;
-	uint32 cur_ticks = GetTickCount();
-	uint32 last_cur_ticks = cur_ticks;
-	uint32 next_tick = cur_ticks + 30;
+	uint64 cur_ticks = GetMonotonicMilliseconds();
+	uint64 last_cur_ticks = cur_ticks;
+	uint64 next_tick = cur_ticks + 30;
+	uint64 next_draw = cur_ticks;
+	uint skipped_draws = 0;
 
 	_wnd.running = true;
 
 	for (;;) {
-		uint32 prev_cur_ticks = cur_ticks; // to check for wrapping
 
 		while (PeekMessage(&mesg, NULL, 0, 0, PM_REMOVE)) {
 			InteractiveRandom(); // randomness
@@ -858,9 +871,10 @@ void VideoDriver_Win32::MainLoop()
 			_fast_forward = 0;
 		}
 
-		cur_ticks = GetTickCount();
-		if (cur_ticks >= next_tick || (_fast_forward && !_pause_mode) || cur_ticks < prev_cur_ticks) {
-			_realtime_tick += cur_ticks - last_cur_ticks;
+		cur_ticks = GetMonotonicMilliseconds();
+		bool tick = cur_ticks >= next_tick || (_fast_forward && !_pause_mode);
+		if (tick) {
+			_realtime_tick += (uint32)(cur_ticks - last_cur_ticks);
 			last_cur_ticks = cur_ticks;
 			next_tick = cur_ticks + 30;
 
@@ -890,9 +904,32 @@ void VideoDriver_Win32::MainLoop()
 			GdiFlush();
 #endif
 			_screen.dst_ptr = _wnd.buffer_bits;
-			UpdateWindows();
+			TickWindows();
 			CheckPaletteAnim();
-		} else {
+		}
+
+		/* Draw at the refresh rate, whatever the speed of the game. */
+		bool drawn = false;
+		cur_ticks = GetMonotonicMilliseconds();
+		if (cur_ticks >= next_draw) {
+			if (tick && cur_ticks >= next_tick && skipped_draws < MAX_SKIPPED_DRAWS) {
+				/* The tick took so long the next one is due already; let the game catch up first. */
+				skipped_draws++;
+			} else {
+				next_draw += GetDrawInterval();
+				if (cur_ticks >= next_draw) next_draw = cur_ticks + GetDrawInterval();
+				skipped_draws = 0;
+
+#if !defined(WINCE)
+				GdiFlush();
+#endif
+				_screen.dst_ptr = _wnd.buffer_bits;
+				DrawWindows();
+				drawn = true;
+			}
+		}
+
+		if (!tick && !drawn) {
 			Sleep(1);
 #if !defined(WINCE)
 			GdiFlush();
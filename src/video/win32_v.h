@@ -22,6 +22,8 @@ public:
 
 	/* virtual */ void MakeDirty(int left, int top, int width, int height);
 
+	/* virtual */ bool ScrollScreen(int left, int top, int width, int height, int xo, int yo);
+
 	/* virtual */ void MainLoop();
 
 	/* virtual */ bool ChangeResolution(int w, int h);
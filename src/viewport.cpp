@@ -44,6 +44,11 @@
 #include "window_func.h"
 #include "tilehighlight_func.h"
 #include "window_gui.h"
+#include "network/network.h"
+#include "core/sort_func.hpp"
+#include "smallmap_gui.h"
+#include "effectvehicle_func.h"
+#include "elrail_func.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -77,6 +82,13 @@ struct ChildScreenSpriteToDraw {
 	int next;                       ///< next child to draw (-1 at the end)
 };
 
+/** Vehicle that is drawn as just a dot, at the zoom levels with less detail. */
+struct VehicleMarkerToDraw {
+	int32 x;                        ///< screen X coordinate of the vehicle
+	int32 y;                        ///< screen Y coordinate of the vehicle
+	byte colour;                    ///< colour of the dot
+};
+
 /** Parent sprite that should be drawn */
 struct ParentSpriteToDraw {
 	SpriteID image;                 ///< sprite to draw
@@ -97,7 +109,7 @@ struct ParentSpriteToDraw {
 	int zmax;                       ///< maximal world Z coordinate of bounding box
 
 	int first_child;                ///< the first child to draw.
-	bool comparison_done;           ///< Used during sprite sorting: true if sprite has been compared with all other sprites
+	uint32 order;                   ///< Used during sprite sorting: the place of the sprite on the stack of sprites to sort, or whether it has been sorted
 };
 
 /** Enumeration of multi-part foundations */
@@ -122,6 +134,7 @@ typedef SmallVector<StringSpriteToDraw, 4> StringSpriteToDrawVector;
 typedef SmallVector<ParentSpriteToDraw, 64> ParentSpriteToDrawVector;
 typedef SmallVector<ParentSpriteToDraw*, 64> ParentSpriteToSortVector;
 typedef SmallVector<ChildScreenSpriteToDraw, 16> ChildScreenSpriteToDrawVector;
+typedef SmallVector<VehicleMarkerToDraw, 64> VehicleMarkerToDrawVector;
 
 /** Data structure storing rendering information */
 struct ViewportDrawer {
@@ -132,6 +145,7 @@ struct ViewportDrawer {
 	ParentSpriteToDrawVector parent_sprites_to_draw;
 	ParentSpriteToSortVector parent_sprites_to_sort; ///< Parent sprite pointer array used for sorting
 	ChildScreenSpriteToDrawVector child_screen_sprites_to_draw;
+	VehicleMarkerToDrawVector vehicle_markers_to_draw;
 
 	int *last_child;
 
@@ -141,10 +155,93 @@ struct ViewportDrawer {
 	FoundationPart foundation_part;                  ///< Currently active foundation for ground sprite drawing.
 	int *last_foundation_child[FOUNDATION_PART_END]; ///< Tail of ChildSprite list of the foundations. (index into child_screen_sprites_to_draw)
 	Point foundation_offset[FOUNDATION_PART_END];    ///< Pixel offset for ground sprites on the foundations.
+
+	bool defer_sprite_loading;                       ///< Whether sprites that aren't in the cache may be loaded later, when more than #MAX_VIEWPORT_SPRITE_LOADS are needed.
+	bool sprites_deferred;                           ///< Whether sprites were left out, so this part of the viewport needs drawing again.
 };
 
 static ViewportDrawer _vd;
 
+/** The number of sprites the viewports may load from their files per game loop; loading more is deferred to the next ones. */
+static const uint MAX_VIEWPORT_SPRITE_LOADS = 256;
+
+static uint _viewport_sprite_loads = 0;                      ///< The number of sprites loaded for the viewports during this game loop.
+static SmallVector<SpriteID, 256> _viewport_sprites_to_load; ///< The sprites the viewports are waiting for.
+static SmallVector<Rect, 16> _viewport_deferred_rects;       ///< The parts of the screen to draw again once the sprites are loaded.
+
+/**
+ * May a viewport use a sprite now? When too many sprites had to be loaded
+ * already, it is queued to be loaded later instead, and the part of the
+ * viewport that is being drawn is drawn again once it has been loaded.
+ * @param image the sprite
+ * @return false if the sprite has to be left out
+ */
+static bool ViewportSpriteAvailable(SpriteID image)
+{
+	if (!_vd.defer_sprite_loading || IsSpriteInCache(image & SPRITE_MASK)) return true;
+
+	if (_viewport_sprite_loads < MAX_VIEWPORT_SPRITE_LOADS) {
+		_viewport_sprite_loads++;
+		return true;
+	}
+
+	_viewport_sprites_to_load.Include(image & SPRITE_MASK);
+	_vd.sprites_deferred = true;
+	return false;
+}
+
+/** The viewport functions a DrawTile proc calls, as they are recorded for the tile draw cache. */
+enum TileDrawCallType {
+	TDC_GROUND_SPRITE,   ///< DrawGroundSpriteAt()
+	TDC_OFFSET_GROUND,   ///< OffsetGroundSprite()
+	TDC_SORTABLE_SPRITE, ///< AddSortableSpriteToDraw()
+	TDC_CHILD_SPRITE,    ///< AddChildSpriteScreen()
+	TDC_START_COMBINE,   ///< StartSpriteCombine()
+	TDC_END_COMBINE,     ///< EndSpriteCombine()
+};
+
+/** One call of a DrawTile proc to the viewport, with its arguments. */
+struct TileDrawCall {
+	TileDrawCallType type; ///< The function that was called.
+	SpriteID image;        ///< The sprite.
+	PaletteID pal;         ///< The palette of the sprite.
+	const SubSprite *sub;  ///< The part of the sprite to draw.
+	int x, y, z;           ///< The position of the sprite; the offset in pixels for child sprites and OffsetGroundSprite().
+	int w, h, dz;          ///< The extent of the bounding box; the extra pixel offset of ground sprites in w and h.
+	int bb_offset_x;       ///< The bounding box extent towards negative X.
+	int bb_offset_y;       ///< The bounding box extent towards negative Y.
+	int bb_offset_z;       ///< The bounding box extent towards negative Z.
+	bool transparent;      ///< Whether the sprite was asked to be drawn transparent.
+};
+
+typedef SmallVector<TileDrawCall, 8> TileDrawCallVector;
+
+/** What the DrawTile proc of a tile did the last time it drew the tile. */
+struct TileDrawCache {
+	TileIndex tile;           ///< The tile the calls are of; INVALID_TILE if they are of no tile.
+	ZoomLevel zoom;           ///< The zoom level the tile was drawn at.
+	TileDrawCallVector calls; ///< The calls, in order.
+
+	TileDrawCache() : tile(INVALID_TILE), zoom(ZOOM_LVL_NORMAL) {}
+};
+
+static const uint TILE_DRAW_CACHE_BITS = 7;                               ///< The tile draw cache holds a square of 2^bits tiles.
+static const uint TILE_DRAW_CACHE_MASK = (1 << TILE_DRAW_CACHE_BITS) - 1; ///< Mask of the coordinates of a tile in the tile draw cache.
+static TileDrawCache *_tile_draw_cache = NULL;                            ///< The tile draw cache; tiles with the same coordinates modulo 2^#TILE_DRAW_CACHE_BITS share an entry.
+static TileDrawCallVector *_tile_draw_record = NULL;                      ///< Where to record the calls of the DrawTile proc that is drawing, if to record them at all.
+
+/**
+ * Record a call of a DrawTile proc to the viewport.
+ * @param type the function that was called
+ * @return the record to fill the arguments into
+ */
+static TileDrawCall *RecordTileDrawCall(TileDrawCallType type)
+{
+	TileDrawCall *call = _tile_draw_record->Append();
+	call->type = type;
+	return call;
+}
+
 TileHighlightData _thd;
 static TileInfo *_cur_ti;
 bool _draw_bounding_boxes = false;
@@ -358,6 +455,28 @@ ViewPort *IsPtInWindowViewport(const Window *w, int x, int y)
 	return NULL;
 }
 
+/**
+ * Is a position in virtual coordinates shown by any viewport?
+ * @param x X coordinate of the position
+ * @param y Y coordinate of the position
+ * @return true iff at least one viewport shows the position.
+ */
+bool IsPtInAnyViewport(int x, int y)
+{
+	const Window *w;
+	FOR_ALL_WINDOWS_FROM_BACK(w) {
+		const ViewPort *vp = w->viewport;
+
+		if (vp != NULL &&
+				IsInsideBS(x, vp->virtual_left, vp->virtual_width) &&
+				IsInsideBS(y, vp->virtual_top, vp->virtual_height)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * Translate screen coordinate in a viewport to a tile coordinate
  * @param vp  Viewport that contains the (\a x, \a y) screen coordinate
@@ -479,6 +598,8 @@ static void AddTileSpriteToDraw(SpriteID image, PaletteID pal, int32 x, int32 y,
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (!ViewportSpriteAvailable(image)) return;
+
 	TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Append();
 	ts->image = image;
 	ts->pal = pal;
@@ -488,6 +609,8 @@ static void AddTileSpriteToDraw(SpriteID image, PaletteID pal, int32 x, int32 y,
 	ts->y = pt.y + extra_offs_y;
 }
 
+static void AddChildSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub);
+
 /**
  * Adds a child sprite to the active foundation.
  *
@@ -510,7 +633,7 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
 	int *old_child = _vd.last_child;
 	_vd.last_child = _vd.last_foundation_child[foundation_part];
 
-	AddChildSpriteScreen(image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub);
+	AddChildSpriteToDraw(image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub);
 
 	/* Switch back to last ChildSprite list */
 	_vd.last_child = old_child;
@@ -531,6 +654,18 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
  */
 void DrawGroundSpriteAt(SpriteID image, PaletteID pal, int32 x, int32 y, int z, const SubSprite *sub, int extra_offs_x, int extra_offs_y)
 {
+	if (_tile_draw_record != NULL) {
+		TileDrawCall *call = RecordTileDrawCall(TDC_GROUND_SPRITE);
+		call->image = image;
+		call->pal = pal;
+		call->sub = sub;
+		call->x = x;
+		call->y = y;
+		call->z = z;
+		call->w = extra_offs_x;
+		call->h = extra_offs_y;
+	}
+
 	/* Switch to first foundation part, if no foundation was drawn */
 	if (_vd.foundation_part == FOUNDATION_PART_NONE) _vd.foundation_part = FOUNDATION_PART_NORMAL;
 
@@ -566,6 +701,12 @@ void DrawGroundSprite(SpriteID image, PaletteID pal, const SubSprite *sub, int e
  */
 void OffsetGroundSprite(int x, int y)
 {
+	if (_tile_draw_record != NULL) {
+		TileDrawCall *call = RecordTileDrawCall(TDC_OFFSET_GROUND);
+		call->x = x;
+		call->y = y;
+	}
+
 	/* Switch to next foundation part */
 	switch (_vd.foundation_part) {
 		case FOUNDATION_PART_NONE:
@@ -598,6 +739,8 @@ void OffsetGroundSprite(int x, int y)
  */
 static void AddCombinedSprite(SpriteID image, PaletteID pal, int x, int y, byte z, const SubSprite *sub)
 {
+	if (!ViewportSpriteAvailable(image)) return;
+
 	Point pt = RemapCoords(x, y, z);
 	const Sprite *spr = GetSprite(image & SPRITE_MASK, ST_NORMAL);
 
@@ -608,7 +751,7 @@ static void AddCombinedSprite(SpriteID image, PaletteID pal, int x, int y, byte
 		return;
 
 	const ParentSpriteToDraw *pstd = _vd.parent_sprites_to_draw.End() - 1;
-	AddChildSpriteScreen(image, pal, pt.x - pstd->left, pt.y - pstd->top, false, sub);
+	AddChildSpriteToDraw(image, pal, pt.x - pstd->left, pt.y - pstd->top, false, sub);
 }
 
 /** Draw a (transparent) sprite at given coordinates with a given bounding box.
@@ -641,6 +784,23 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (_tile_draw_record != NULL) {
+		TileDrawCall *call = RecordTileDrawCall(TDC_SORTABLE_SPRITE);
+		call->image = image;
+		call->pal = pal;
+		call->sub = sub;
+		call->x = x;
+		call->y = y;
+		call->z = z;
+		call->w = w;
+		call->h = h;
+		call->dz = dz;
+		call->bb_offset_x = bb_offset_x;
+		call->bb_offset_y = bb_offset_y;
+		call->bb_offset_z = bb_offset_z;
+		call->transparent = transparent;
+	}
+
 	/* make the sprites transparent with the right palette */
 	if (transparent) {
 		SetBit(image, PALETTE_MODIFIER_TRANSPARENT);
@@ -654,6 +814,8 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 
 	_vd.last_child = NULL;
 
+	if (image != SPR_EMPTY_BOUNDING_BOX && !ViewportSpriteAvailable(image)) return;
+
 	Point pt = RemapCoords(x, y, z);
 	int tmp_left, tmp_top, tmp_x = pt.x, tmp_y = pt.y;
 
@@ -706,7 +868,6 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 	ps->zmin = z + bb_offset_z;
 	ps->zmax = z + max(bb_offset_z, dz) - 1;
 
-	ps->comparison_done = false;
 	ps->first_child = -1;
 
 	_vd.last_child = &ps->first_child;
@@ -734,6 +895,7 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
  */
 void StartSpriteCombine()
 {
+	if (_tile_draw_record != NULL) RecordTileDrawCall(TDC_START_COMBINE);
 	assert(_vd.combine_sprites == SPRITE_COMBINE_NONE);
 	_vd.combine_sprites = SPRITE_COMBINE_PENDING;
 }
@@ -744,12 +906,14 @@ void StartSpriteCombine()
  */
 void EndSpriteCombine()
 {
+	if (_tile_draw_record != NULL) RecordTileDrawCall(TDC_END_COMBINE);
 	assert(_vd.combine_sprites != SPRITE_COMBINE_NONE);
 	_vd.combine_sprites = SPRITE_COMBINE_NONE;
 }
 
 /**
- * Add a child sprite to a parent sprite.
+ * Add a child sprite to the active ChildSprite list, without recording it for the tile draw cache.
+ * @see AddChildSpriteScreen
  *
  * @param image the image to draw.
  * @param pal the provided palette.
@@ -758,13 +922,21 @@ void EndSpriteCombine()
  * @param transparent if true, switch the palette between the provided palette and the transparent palette,
  * @param sub Only draw a part of the sprite.
  */
-void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub)
+static void AddChildSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub)
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
 	/* If the ParentSprite was clipped by the viewport bounds, do not draw the ChildSprites either */
 	if (_vd.last_child == NULL) return;
 
+	if (!ViewportSpriteAvailable(image)) return;
+
+	/* Leave out the details that would hardly be a pixel at this zoom level */
+	if (IsViewportLowDetail()) {
+		const Sprite *spr = GetSprite(image & SPRITE_MASK, ST_NORMAL);
+		if (UnScaleByZoom(max<int>(spr->width, spr->height), _vd.dpi.zoom) < 2) return;
+	}
+
 	/* make the sprites transparent with the right palette */
 	if (transparent) {
 		SetBit(image, PALETTE_MODIFIER_TRANSPARENT);
@@ -789,6 +961,60 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 	_vd.last_child = &cs->next;
 }
 
+/**
+ * Add a child sprite to a parent sprite.
+ *
+ * @param image the image to draw.
+ * @param pal the provided palette.
+ * @param x sprite x-offset (screen coordinates) relative to parent sprite.
+ * @param y sprite y-offset (screen coordinates) relative to parent sprite.
+ * @param transparent if true, switch the palette between the provided palette and the transparent palette,
+ * @param sub Only draw a part of the sprite.
+ */
+void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub)
+{
+	if (_tile_draw_record != NULL) {
+		TileDrawCall *call = RecordTileDrawCall(TDC_CHILD_SPRITE);
+		call->image = image;
+		call->pal = pal;
+		call->sub = sub;
+		call->x = x;
+		call->y = y;
+		call->transparent = transparent;
+	}
+
+	AddChildSpriteToDraw(image, pal, x, y, transparent, sub);
+}
+
+/**
+ * Should the viewport that is being drawn be drawn with less detail?
+ * That is, is it at one of the farthest zoom levels gui.viewport_low_detail
+ * is set to? Then every tile draws just one of its trees, tiny child
+ * sprites are left out and vehicles are drawn as a dot.
+ * @return true for less detail
+ */
+bool IsViewportLowDetail()
+{
+	return _settings_client.gui.viewport_low_detail != 0 && _vd.dpi.zoom > ZOOM_LVL_MAX - _settings_client.gui.viewport_low_detail;
+}
+
+/**
+ * Schedules a vehicle for drawing as a dot, instead of its sprite.
+ * These dots are drawn over the landscape, after all sprites.
+ * @param x position x (world coordinates) of the vehicle.
+ * @param y position y (world coordinates) of the vehicle.
+ * @param z position z (world coordinates) of the vehicle.
+ * @param colour the colour of the dot.
+ */
+void AddVehicleMarkerToDraw(int x, int y, int z, byte colour)
+{
+	Point pt = RemapCoords(x, y, z);
+	VehicleMarkerToDraw *vm = _vd.vehicle_markers_to_draw.Append();
+	vm->x = pt.x;
+	vm->y = pt.y;
+	vm->colour = colour;
+}
+
 static void AddStringToDraw(int x, int y, StringID string, uint64 params_1, uint64 params_2, Colours colour, uint16 width)
 {
 	assert(width != 0);
@@ -990,6 +1216,122 @@ static void DrawTileSelection(const TileInfo *ti)
 	}
 }
 
+/**
+ * Get the entry of the tile draw cache a tile uses, making the cache when there is none yet.
+ * @param tile the tile
+ * @return the entry; it holds the calls of another tile when the tile isn't cached
+ */
+static TileDrawCache *GetTileDrawCache(TileIndex tile)
+{
+	if (_tile_draw_cache == NULL) _tile_draw_cache = new TileDrawCache[1 << (2 * TILE_DRAW_CACHE_BITS)];
+	return &_tile_draw_cache[(TileX(tile) & TILE_DRAW_CACHE_MASK) | (TileY(tile) & TILE_DRAW_CACHE_MASK) << TILE_DRAW_CACHE_BITS];
+}
+
+/**
+ * Forget how a tile and its neighbours were drawn. The neighbours are
+ * forgotten too as what is drawn of them, e.g. catenary and water borders,
+ * depends on the tile.
+ * @param tile the tile that changed
+ */
+static void InvalidateTileDrawCache(TileIndex tile)
+{
+	if (_tile_draw_cache == NULL) return;
+
+	uint x = TileX(tile);
+	uint y = TileY(tile);
+	for (uint cy = max(y, 1U) - 1; cy <= min(y + 1, MapMaxY()); cy++) {
+		for (uint cx = max(x, 1U) - 1; cx <= min(x + 1, MapMaxX()); cx++) {
+			TileDrawCache *cache = GetTileDrawCache(TileXY(cx, cy));
+			if (cache->tile == TileXY(cx, cy)) cache->tile = INVALID_TILE;
+		}
+	}
+}
+
+/**
+ * Forget how all tiles were drawn and where their catenary goes, e.g. because
+ * the transparency settings or the map changed. The memory of the tile draw
+ * cache is freed when it is disabled.
+ */
+void ResetTileDrawCache()
+{
+	ResetCatenaryCache();
+
+	if (_tile_draw_cache == NULL) return;
+
+	if (!_settings_client.gui.cache_tile_draw_lists) {
+		delete[] _tile_draw_cache;
+		_tile_draw_cache = NULL;
+		return;
+	}
+
+	for (uint i = 0; i < 1 << (2 * TILE_DRAW_CACHE_BITS); i++) _tile_draw_cache[i].tile = INVALID_TILE;
+}
+
+/**
+ * Do the calls a DrawTile proc did to the viewport again.
+ * @param calls the recorded calls
+ */
+static void ReplayTileDrawCalls(const TileDrawCallVector &calls)
+{
+	for (const TileDrawCall *call = calls.Begin(); call != calls.End(); call++) {
+		switch (call->type) {
+			case TDC_GROUND_SPRITE:
+				DrawGroundSpriteAt(call->image, call->pal, call->x, call->y, call->z, call->sub, call->w, call->h);
+				break;
+
+			case TDC_OFFSET_GROUND:
+				OffsetGroundSprite(call->x, call->y);
+				break;
+
+			case TDC_SORTABLE_SPRITE:
+				AddSortableSpriteToDraw(call->image, call->pal, call->x, call->y, call->w, call->h, call->dz, call->z, call->transparent, call->bb_offset_x, call->bb_offset_y, call->bb_offset_z, call->sub);
+				break;
+
+			case TDC_CHILD_SPRITE:
+				AddChildSpriteScreen(call->image, call->pal, call->x, call->y, call->transparent, call->sub);
+				break;
+
+			case TDC_START_COMBINE:
+				StartSpriteCombine();
+				break;
+
+			case TDC_END_COMBINE:
+				EndSpriteCombine();
+				break;
+
+			default: NOT_REACHED();
+		}
+	}
+}
+
+/**
+ * Draw a tile with its DrawTile proc, or by replaying what that did the last
+ * time when the tile didn't change since.
+ * @param ti the tile
+ * @param tt the type of the tile
+ */
+static void DrawTileCached(TileInfo *ti, TileType tt)
+{
+	if (!_settings_client.gui.cache_tile_draw_lists || ti->tile == INVALID_TILE) {
+		_tile_type_procs[tt]->draw_tile_proc(ti);
+		return;
+	}
+
+	TileDrawCache *cache = GetTileDrawCache(ti->tile);
+	if (cache->tile == ti->tile && cache->zoom == _vd.dpi.zoom) {
+		ReplayTileDrawCalls(cache->calls);
+		return;
+	}
+
+	cache->tile = ti->tile;
+	cache->zoom = _vd.dpi.zoom;
+	cache->calls.Clear();
+
+	_tile_draw_record = &cache->calls;
+	_tile_type_procs[tt]->draw_tile_proc(ti);
+	_tile_draw_record = NULL;
+}
+
 static void ViewportAddLandscape()
 {
 	int x, y, width, height;
@@ -1054,7 +1396,7 @@ static void ViewportAddLandscape()
 			_vd.last_foundation_child[0] = NULL;
 			_vd.last_foundation_child[1] = NULL;
 
-			_tile_type_procs[tt]->draw_tile_proc(&ti);
+			DrawTileCached(&ti, tt);
 
 			if ((x_cur == (int)MapMaxX() * TILE_SIZE && IsInsideMM(y_cur, 0, MapMaxY() * TILE_SIZE + 1)) ||
 				(y_cur == (int)MapMaxY() * TILE_SIZE && IsInsideMM(x_cur, 0, MapMaxX() * TILE_SIZE + 1))) {
@@ -1119,12 +1461,126 @@ void ViewportAddString(const DrawPixelInfo *dpi, ZoomLevel small_from, const Vie
 	}
 }
 
+/* The index of the viewport signs is a hash on the position of the sign,
+ * like the one of the vehicles. The hash wraps around, so every bucket
+ * can hold signs of several parts of the map. */
+static const uint VIEWPORT_SIGN_HASH_BITS    = 6;  ///< Number of bits of each coordinate in the hash of viewport signs.
+static const uint VIEWPORT_SIGN_HASH_SHIFT_X = 10; ///< The width of a bucket is 1 << this.
+static const uint VIEWPORT_SIGN_HASH_SHIFT_Y = 9;  ///< The height of a bucket is 1 << this.
+static const uint VIEWPORT_SIGN_HASH_MASK    = (1 << VIEWPORT_SIGN_HASH_BITS) - 1; ///< Mask of a coordinate in the hash.
+
+typedef SmallVector<uint16, 4> ViewportSignBucket; ///< The indices of the signs in a bucket.
+
+static ViewportSignBucket _viewport_sign_hash[VSK_END][1 << (2 * VIEWPORT_SIGN_HASH_BITS)]; ///< The buckets of the viewport signs of each kind.
+static uint16 _viewport_sign_max_width; ///< The widest sign that has been put into the index.
+
+/**
+ * Get the bucket of the index a sign at the given position belongs to.
+ * @param kind the kind of the sign
+ * @param center the center of the sign
+ * @param top the top of the sign
+ * @return the bucket
+ */
+static ViewportSignBucket *GetViewportSignBucket(ViewportSignKind kind, int center, int top)
+{
+	return &_viewport_sign_hash[kind][(GB(top, VIEWPORT_SIGN_HASH_SHIFT_Y, VIEWPORT_SIGN_HASH_BITS) << VIEWPORT_SIGN_HASH_BITS) + GB(center, VIEWPORT_SIGN_HASH_SHIFT_X, VIEWPORT_SIGN_HASH_BITS)];
+}
+
+/**
+ * Add a sign to the index of viewport signs, after its position has been updated.
+ * @param kind the kind of the sign
+ * @param index the index of the town, station or sign the sign belongs to
+ * @param sign the sign
+ */
+void AddViewportSignToIndex(ViewportSignKind kind, uint16 index, const ViewportSign *sign)
+{
+	*GetViewportSignBucket(kind, sign->center, sign->top)->Append() = index;
+	_viewport_sign_max_width = max(_viewport_sign_max_width, max(sign->width_normal, sign->width_small));
+}
+
+/**
+ * Remove a sign from the index of viewport signs, before its position gets updated.
+ * @param kind the kind of the sign
+ * @param index the index of the town, station or sign the sign belongs to
+ * @param sign the sign
+ */
+void RemoveViewportSignFromIndex(ViewportSignKind kind, uint16 index, const ViewportSign *sign)
+{
+	ViewportSignBucket *bucket = GetViewportSignBucket(kind, sign->center, sign->top);
+	uint16 *entry = bucket->Find(index);
+	if (entry != bucket->End()) bucket->Erase(entry);
+}
+
+/** Remove all signs from the index of viewport signs. */
+void ResetViewportSignIndex()
+{
+	for (uint kind = 0; kind < VSK_END; kind++) {
+		for (uint i = 0; i < lengthof(_viewport_sign_hash[kind]); i++) _viewport_sign_hash[kind][i].Clear();
+	}
+	_viewport_sign_max_width = 0;
+}
+
+/**
+ * Find the signs of a kind that might be (partly) within an area of the viewport.
+ * @param kind the kind of signs to look for
+ * @param left left of the area
+ * @param top top of the area
+ * @param right right of the area
+ * @param bottom bottom of the area
+ * @param zoom zoom level the signs are drawn at
+ * @param found the list to fill with the indices of the signs that might be within the area
+ */
+static void FindViewportSigns(ViewportSignKind kind, int left, int top, int right, int bottom, ZoomLevel zoom, SmallVector<uint16, 64> &found)
+{
+	found.Clear();
+
+	/* Signs are positioned by their top and center, so look for those a sign
+	 * can stick out of the area with. */
+	left   -= ScaleByZoom(_viewport_sign_max_width / 2 + 1, zoom);
+	right  += ScaleByZoom(_viewport_sign_max_width / 2 + 1, zoom);
+	top    -= ScaleByZoom(VPSM_TOP + FONT_HEIGHT_NORMAL + VPSM_BOTTOM + 1, zoom);
+
+	uint xl, xu, yl, yu;
+	if (right - left < (1 << (VIEWPORT_SIGN_HASH_SHIFT_X + VIEWPORT_SIGN_HASH_BITS))) {
+		xl = GB(left,  VIEWPORT_SIGN_HASH_SHIFT_X, VIEWPORT_SIGN_HASH_BITS);
+		xu = GB(right, VIEWPORT_SIGN_HASH_SHIFT_X, VIEWPORT_SIGN_HASH_BITS);
+	} else {
+		/* scan whole hash row */
+		xl = 0;
+		xu = VIEWPORT_SIGN_HASH_MASK;
+	}
+
+	if (bottom - top < (1 << (VIEWPORT_SIGN_HASH_SHIFT_Y + VIEWPORT_SIGN_HASH_BITS))) {
+		yl = GB(top,    VIEWPORT_SIGN_HASH_SHIFT_Y, VIEWPORT_SIGN_HASH_BITS);
+		yu = GB(bottom, VIEWPORT_SIGN_HASH_SHIFT_Y, VIEWPORT_SIGN_HASH_BITS);
+	} else {
+		/* scan whole column */
+		yl = 0;
+		yu = VIEWPORT_SIGN_HASH_MASK;
+	}
+
+	for (uint y = yl;; y = (y + 1) & VIEWPORT_SIGN_HASH_MASK) {
+		for (uint x = xl;; x = (x + 1) & VIEWPORT_SIGN_HASH_MASK) {
+			const ViewportSignBucket *bucket = &_viewport_sign_hash[kind][(y << VIEWPORT_SIGN_HASH_BITS) + x];
+			for (const uint16 *index = bucket->Begin(); index != bucket->End(); index++) *found.Append() = *index;
+
+			if (x == xu) break;
+		}
+
+		if (y == yu) break;
+	}
+}
+
+/** The signs found by the last FindViewportSigns. */
+static SmallVector<uint16, 64> _viewport_signs_found;
+
 static void ViewportAddTownNames(DrawPixelInfo *dpi)
 {
 	if (!HasBit(_display_opt, DO_SHOW_TOWN_NAMES) || _game_mode == GM_MENU) return;
 
-	const Town *t;
-	FOR_ALL_TOWNS(t) {
+	FindViewportSigns(VSK_TOWN, dpi->left, dpi->top, dpi->left + dpi->width, dpi->top + dpi->height, dpi->zoom, _viewport_signs_found);
+	for (const uint16 *index = _viewport_signs_found.Begin(); index != _viewport_signs_found.End(); index++) {
+		const Town *t = Town::Get(*index);
 		ViewportAddString(dpi, ZOOM_LVL_OUT_4X, &t->sign,
 				_settings_client.gui.population_in_label ? STR_VIEWPORT_TOWN_POP : STR_VIEWPORT_TOWN,
 				STR_VIEWPORT_TOWN_TINY_WHITE, STR_VIEWPORT_TOWN_TINY_BLACK,
@@ -1137,8 +1593,10 @@ static void ViewportAddStationNames(DrawPixelInfo *dpi)
 {
 	if (!(HasBit(_display_opt, DO_SHOW_STATION_NAMES) || HasBit(_display_opt, DO_SHOW_WAYPOINT_NAMES)) || _game_mode == GM_MENU) return;
 
-	const BaseStation *st;
-	FOR_ALL_BASE_STATIONS(st) {
+	FindViewportSigns(VSK_STATION, dpi->left, dpi->top, dpi->left + dpi->width, dpi->top + dpi->height, dpi->zoom, _viewport_signs_found);
+	for (const uint16 *index = _viewport_signs_found.Begin(); index != _viewport_signs_found.End(); index++) {
+		const BaseStation *st = BaseStation::Get(*index);
+
 		/* Check whether the base station is a station or a waypoint */
 		bool is_station = Station::IsExpected(st);
 
@@ -1158,8 +1616,9 @@ static void ViewportAddSigns(DrawPixelInfo *dpi)
 	/* Signs are turned off or are invisible */
 	if (!HasBit(_display_opt, DO_SHOW_SIGNS) || IsInvisibilitySet(TO_SIGNS)) return;
 
-	const Sign *si;
-	FOR_ALL_SIGNS(si) {
+	FindViewportSigns(VSK_SIGN, dpi->left, dpi->top, dpi->left + dpi->width, dpi->top + dpi->height, dpi->zoom, _viewport_signs_found);
+	for (const uint16 *index = _viewport_signs_found.Begin(); index != _viewport_signs_found.End(); index++) {
+		const Sign *si = Sign::Get(*index);
 		ViewportAddString(dpi, ZOOM_LVL_OUT_4X, &si->sign,
 				STR_WHITE_SIGN,
 				IsTransparencySet(TO_SIGNS) ? STR_VIEWPORT_SIGN_SMALL_WHITE : STR_VIEWPORT_SIGN_SMALL_BLACK, STR_NULL,
@@ -1217,62 +1676,154 @@ static void ViewportDrawTileSprites(const TileSpriteToDrawVector *tstdv)
 	}
 }
 
-/** Sort parent sprites pointer array */
-static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
+/** A parent sprite in the list of sprites to sort, which is ordered by the sum of their minimal world X and Y coordinates. */
+struct ParentSpriteSortNode {
+	int32 key;              ///< xmin + ymin of the sprite
+	ParentSpriteToDraw *ps; ///< the sprite
+	uint next;              ///< index of the next node in the list, #PARENT_SPRITE_SORT_END at the end
+};
+
+static const uint PARENT_SPRITE_SORT_END = UINT_MAX;                ///< End of a list of #ParentSpriteSortNode.
+static const uint32 PARENT_SPRITE_ORDER_COMPARED = UINT32_MAX;      ///< The sprite has been compared, but still has to be drawn.
+static const uint32 PARENT_SPRITE_ORDER_DRAWN    = UINT32_MAX - 1;  ///< The sprite has been put in its place in the drawing order.
+
+/** Sort the nodes by their key, so by the sum of the minimal world X and Y coordinates of their sprites. */
+static int CDECL ParentSpriteSortNodeSorter(const ParentSpriteSortNode *a, const ParentSpriteSortNode *b)
 {
-	ParentSpriteToDraw **psdvend = psdv->End();
-	ParentSpriteToDraw **psd = psdv->Begin();
-	while (psd != psdvend) {
-		ParentSpriteToDraw *ps = *psd;
+	return (a->key > b->key) - (a->key < b->key);
+}
 
-		if (ps->comparison_done) {
-			psd++;
+/** Sort sprites so the one that was put on the stack last, so with the highest order, comes first. */
+static int CDECL ParentSpriteOrderSorter(ParentSpriteToDraw * const *a, ParentSpriteToDraw * const *b)
+{
+	return ((*a)->order < (*b)->order) - ((*a)->order > (*b)->order);
+}
+
+/**
+ * Sort the parent sprites in the order they have to be drawn.
+ *
+ * A sprite goes in front of (is drawn before) another one when it is behind
+ * it by every coordinate, or when their bounding boxes overlap and its centre
+ * is further away. Only sprites that start no further than where a sprite
+ * ends in X, Y and Z can go in front of it, so the sprites are kept in a list
+ * ordered by the sum of their minimal X and Y coordinates and only the start
+ * of that list has to be looked at. The sprites are mostly in the right order
+ * already, so few have to be moved; the ones to be drawn next are kept on a
+ * stack, the sprites that have to go in front of a sprite are pushed on top of it.
+ * @param psdv the sprites to sort
+ */
+static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
+{
+	uint count = psdv->Length();
+	if (count < 2) return;
+
+	/* The first sprite goes on top of the stack, so it is looked at first. */
+	ParentSpriteToSortVector stack;
+	uint32 next_order = 0;
+	for (uint i = count; i-- > 0;) {
+		ParentSpriteToDraw *ps = (*psdv)[i];
+		*stack.Append() = ps;
+		ps->order = next_order++;
+	}
+
+	/* The sorted list of sprites; the first node only points to the start of it. */
+	SmallVector<ParentSpriteSortNode, 64> nodes;
+	nodes.Append(count + 1);
+	for (uint i = 0; i < count; i++) {
+		ParentSpriteSortNode *node = nodes.Get(i + 1);
+		node->ps = (*psdv)[i];
+		node->key = node->ps->xmin + node->ps->ymin;
+	}
+	QSortT(nodes.Get(1), count, &ParentSpriteSortNodeSorter);
+	for (uint i = 0; i < count; i++) nodes[i].next = i + 1;
+	nodes[count].next = PARENT_SPRITE_SORT_END;
+
+	ParentSpriteToSortVector preceding; ///< The sprites that have to go in front of the current one.
+	uint preceding_prev = 0;            ///< The node before the last of the preceding sprites.
+	ParentSpriteToDraw **out = psdv->Begin();
+
+	while (stack.Length() != 0) {
+		ParentSpriteToDraw *s = *(stack.End() - 1);
+		stack.Erase(stack.End() - 1);
+
+		/* Already in its place. */
+		if (s->order == PARENT_SPRITE_ORDER_DRAWN) continue;
+
+		/* The sprites in front of it are in their place now, so it can follow. */
+		if (s->order == PARENT_SPRITE_ORDER_COMPARED) {
+			*out++ = s;
+			s->order = PARENT_SPRITE_ORDER_DRAWN;
 			continue;
 		}
 
-		ps->comparison_done = true;
-
-		for (ParentSpriteToDraw **psd2 = psd + 1; psd2 != psdvend; psd2++) {
-			ParentSpriteToDraw *ps2 = *psd2;
+		/* Only the sprites with xmin + ymin <= s->xmax + s->ymax can go in front of it. */
+		preceding.Clear();
+		int32 ssum = s->xmax + s->ymax;
+		int32 scentre = s->xmin + s->xmax + s->ymin + s->ymax + s->zmin + s->zmax;
+		uint prev = 0;
+		for (uint x = nodes[0].next; x != PARENT_SPRITE_SORT_END && nodes[x].key <= ssum;) {
+			ParentSpriteToDraw *p = nodes[x].ps;
+			if (p == s) {
+				/* It is being put in its place; no need to look at it anymore. */
+				x = nodes[prev].next = nodes[x].next;
+				continue;
+			}
 
-			if (ps2->comparison_done) continue;
+			uint p_prev = prev;
+			prev = x;
+			x = nodes[x].next;
 
-			/* Decide which comparator to use, based on whether the bounding
-			 * boxes overlap
+			/* We only change the order, if it is definite.
+			 * I.e. every single order of X, Y, Z says p is behind s or they overlap.
+			 * That is: If one partial order says s behind p, do not change the order.
 			 */
-			if (ps->xmax >= ps2->xmin && ps->xmin <= ps2->xmax && // overlap in X?
-					ps->ymax >= ps2->ymin && ps->ymin <= ps2->ymax && // overlap in Y?
-					ps->zmax >= ps2->zmin && ps->zmin <= ps2->zmax) { // overlap in Z?
-				/* Use X+Y+Z as the sorting order, so sprites closer to the bottom of
-				 * the screen and with higher Z elevation, are drawn in front.
-				 * Here X,Y,Z are the coordinates of the "center of mass" of the sprite,
-				 * i.e. X=(left+right)/2, etc.
-				 * However, since we only care about order, don't actually divide / 2
-				 */
-				if (ps->xmin + ps->xmax + ps->ymin + ps->ymax + ps->zmin + ps->zmax <=
-						ps2->xmin + ps2->xmax + ps2->ymin + ps2->ymax + ps2->zmin + ps2->zmax) {
-					continue;
-				}
-			} else {
-				/* We only change the order, if it is definite.
-				 * I.e. every single order of X, Y, Z says ps2 is behind ps or they overlap.
-				 * That is: If one partial order says ps behind ps2, do not change the order.
-				 */
-				if (ps->xmax < ps2->xmin ||
-						ps->ymax < ps2->ymin ||
-						ps->zmax < ps2->zmin) {
-					continue;
-				}
+			if (s->xmax < p->xmin || s->ymax < p->ymin || s->zmax < p->zmin) continue;
+
+			/* When the bounding boxes overlap, use X+Y+Z of the "center of mass" as
+			 * the sorting order, so sprites closer to the bottom of the screen and
+			 * with higher Z elevation are drawn in front. Since we only care about
+			 * order, don't actually divide / 2. */
+			if (s->xmin <= p->xmax && s->ymin <= p->ymax && s->zmin <= p->zmax &&
+					scentre <= p->xmin + p->xmax + p->ymin + p->ymax + p->zmin + p->zmax) {
+				continue;
 			}
 
-			/* Move ps2 in front of ps */
-			ParentSpriteToDraw *temp = ps2;
-			for (ParentSpriteToDraw **psd3 = psd2; psd3 > psd; psd3--) {
-				*psd3 = *(psd3 - 1);
+			*preceding.Append() = p;
+			preceding_prev = p_prev;
+		}
+
+		if (preceding.Length() == 0) {
+			*out++ = s;
+			s->order = PARENT_SPRITE_ORDER_DRAWN;
+			continue;
+		}
+
+		/* A single sprite that ends before s can't have any other sprite that goes in front of it, so both can be put in place. */
+		if (preceding.Length() == 1) {
+			ParentSpriteToDraw *p = preceding[0];
+			if (p->xmax <= s->xmax && p->ymax <= s->ymax && p->zmax <= s->zmax) {
+				nodes[preceding_prev].next = nodes[nodes[preceding_prev].next].next;
+				*out++ = p;
+				*out++ = s;
+				p->order = PARENT_SPRITE_ORDER_DRAWN;
+				s->order = PARENT_SPRITE_ORDER_DRAWN;
+				continue;
 			}
-			*psd = temp;
+		}
+
+		/* Look at s again after the sprites in front of it; those keep the order
+		 * they had, as the sprite that was looked at last goes to the front. */
+		QSortT(preceding.Begin(), preceding.Length(), &ParentSpriteOrderSorter);
+
+		s->order = PARENT_SPRITE_ORDER_COMPARED;
+		*stack.Append() = s;
+		for (ParentSpriteToDraw **it = preceding.Begin(); it != preceding.End(); it++) {
+			(*it)->order = next_order++;
+			*stack.Append() = *it;
 		}
 	}
+
+	assert(out == psdv->End());
 }
 
 static void ViewportDrawParentSprites(const ParentSpriteToSortVector *psd, const ChildScreenSpriteToDrawVector *csstdv)
@@ -1312,6 +1863,29 @@ static void ViewportDrawBoundingBoxes(const ParentSpriteToSortVector *psd)
 	}
 }
 
+static void ViewportDrawVehicleMarkers(DrawPixelInfo *dpi, const VehicleMarkerToDrawVector *vmtdv)
+{
+	DrawPixelInfo dp = *dpi;
+	_cur_dpi = &dp;
+
+	ZoomLevel zoom = dp.zoom;
+	dp.zoom = ZOOM_LVL_NORMAL;
+
+	dp.left   = UnScaleByZoom(dp.left,   zoom);
+	dp.top    = UnScaleByZoom(dp.top,    zoom);
+	dp.width  = UnScaleByZoom(dp.width,  zoom);
+	dp.height = UnScaleByZoom(dp.height, zoom);
+
+	const VehicleMarkerToDraw *vmend = vmtdv->End();
+	for (const VehicleMarkerToDraw *vm = vmtdv->Begin(); vm != vmend; ++vm) {
+		int x = UnScaleByZoom(vm->x, zoom);
+		int y = UnScaleByZoom(vm->y, zoom);
+		GfxFillRect(x - 1, y - 1, x + 1, y + 1, vm->colour);
+	}
+
+	_cur_dpi = dpi;
+}
+
 static void ViewportDrawStrings(DrawPixelInfo *dpi, const StringSpriteToDrawVector *sstdv)
 {
 	DrawPixelInfo dp;
@@ -1388,8 +1962,23 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 
 	_vd.dpi.dst_ptr = BlitterFactoryBase::GetCurrentBlitter()->MoveTo(old_dpi->dst_ptr, x - old_dpi->left, y - old_dpi->top);
 
+	_vd.sprites_deferred = false;
+
 	ViewportAddLandscape();
 	ViewportAddVehicles(&_vd.dpi);
+	ViewportAddEffectParticles(&_vd.dpi);
+
+	if (_vd.sprites_deferred) {
+		/* Draw nothing rather than something incomplete, until the sprites are there. */
+		_cur_dpi = old_dpi;
+		GfxFillRect(x - old_dpi->left, y - old_dpi->top, x - old_dpi->left + UnScaleByZoom(_vd.dpi.width, vp->zoom) - 1, y - old_dpi->top + UnScaleByZoom(_vd.dpi.height, vp->zoom) - 1, 0);
+
+		_vd.tile_sprites_to_draw.Clear();
+		_vd.parent_sprites_to_draw.Clear();
+		_vd.child_screen_sprites_to_draw.Clear();
+		_vd.vehicle_markers_to_draw.Clear();
+		return;
+	}
 
 	ViewportAddTownNames(&_vd.dpi);
 	ViewportAddStationNames(&_vd.dpi);
@@ -1409,6 +1998,8 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 
 	if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
 
+	if (_vd.vehicle_markers_to_draw.Length() != 0) ViewportDrawVehicleMarkers(&_vd.dpi, &_vd.vehicle_markers_to_draw);
+
 	if (_vd.string_sprites_to_draw.Length() != 0) ViewportDrawStrings(&_vd.dpi, &_vd.string_sprites_to_draw);
 
 	_cur_dpi = old_dpi;
@@ -1418,6 +2009,7 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 	_vd.parent_sprites_to_draw.Clear();
 	_vd.parent_sprites_to_sort.Clear();
 	_vd.child_screen_sprites_to_draw.Clear();
+	_vd.vehicle_markers_to_draw.Clear();
 }
 
 /** Make sure we don't draw a too big area at a time.
@@ -1435,15 +2027,52 @@ static void ViewportDrawChk(const ViewPort *vp, int left, int top, int right, in
 			ViewportDrawChk(vp, t, top, right, bottom);
 		}
 	} else {
+		_vd.defer_sprite_loading = true;
 		ViewportDoDraw(vp,
 			ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
 			ScaleByZoom(top - vp->top, vp->zoom) + vp->virtual_top,
 			ScaleByZoom(right - vp->left, vp->zoom) + vp->virtual_left,
 			ScaleByZoom(bottom - vp->top, vp->zoom) + vp->virtual_top
 		);
+		_vd.defer_sprite_loading = false;
+
+		if (_vd.sprites_deferred) {
+			Rect *r = _viewport_deferred_rects.Append();
+			r->left = left;
+			r->top = top;
+			r->right = right;
+			r->bottom = bottom;
+		}
 	}
 }
 
+/**
+ * Load some of the sprites the viewports are waiting for, and draw the
+ * parts of the viewports that waited for them again once all are loaded.
+ */
+void ViewportLoadDeferredSprites()
+{
+	SpriteID sprites[MAX_VIEWPORT_SPRITE_LOADS];
+	uint count = 0;
+
+	while (_viewport_sprites_to_load.Length() != 0 && count < lengthof(sprites)) {
+		SpriteID *sprite = _viewport_sprites_to_load.End() - 1;
+		if (!IsSpriteInCache(*sprite)) sprites[count++] = *sprite;
+		_viewport_sprites_to_load.Erase(sprite);
+	}
+
+	/* Load them all at once, so their PNGs can be loaded side by side. */
+	LoadSprites(sprites, count);
+	_viewport_sprite_loads = count;
+
+	if (_viewport_sprites_to_load.Length() != 0) return;
+
+	for (const Rect *r = _viewport_deferred_rects.Begin(); r != _viewport_deferred_rects.End(); r++) {
+		SetDirtyBlocks(r->left, r->top, r->right, r->bottom);
+	}
+	_viewport_deferred_rects.Clear();
+}
+
 static inline void ViewportDraw(const ViewPort *vp, int left, int top, int right, int bottom)
 {
 	if (right <= vp->left || bottom <= vp->top) return;
@@ -1466,6 +2095,9 @@ static inline void ViewportDraw(const ViewPort *vp, int left, int top, int right
  */
 void Window::DrawViewport() const
 {
+	/* What is drawn would be outdated the next frame already. */
+	if (_network_catching_up) return;
+
 	DrawPixelInfo *dpi = _cur_dpi;
 
 	dpi->left += this->left;
@@ -1594,10 +2226,73 @@ void MarkAllViewportsDirty(int left, int top, int right, int bottom)
 	}
 }
 
+/** Areas, in virtual viewport coordinates, of the dirty tiles that have not been passed to the viewports yet. */
+static SmallVector<Rect, 32> _dirty_tile_areas;
+static const uint MAX_DIRTY_TILE_AREAS = 256; ///< Number of collected areas after which they are passed to the viewports right away.
+
+/**
+ * Pass the areas of the tiles that were marked dirty to all viewports.
+ * Doing this once before drawing means the windows are walked once per
+ * collected area, instead of once for every single dirty tile.
+ * @ingroup dirty
+ */
+void FlushDirtyTileAreas()
+{
+	if (_dirty_tile_areas.Length() == 0) return;
+
+	Window *w;
+	FOR_ALL_WINDOWS_FROM_BACK(w) {
+		const ViewPort *vp = w->viewport;
+		if (vp == NULL) continue;
+
+		for (const Rect *r = _dirty_tile_areas.Begin(); r != _dirty_tile_areas.End(); r++) {
+			MarkViewportDirty(vp, r->left, r->top, r->right, r->bottom);
+		}
+	}
+
+	_dirty_tile_areas.Clear();
+}
+
+/**
+ * Collect an area to be marked dirty in all viewports by #FlushDirtyTileAreas.
+ * The area is merged with the previously collected one when their bounding box
+ * is not larger than both areas together, which is the case for neighbouring tiles.
+ * @param left   Left edge of the area.
+ * @param top    Top edge of the area.
+ * @param right  Right edge of the area.
+ * @param bottom Bottom edge of the area.
+ */
+static void AddDirtyTileArea(int left, int top, int right, int bottom)
+{
+	if (_dirty_tile_areas.Length() != 0) {
+		Rect *last = _dirty_tile_areas.End() - 1;
+		Rect merged = { min(last->left, left), min(last->top, top), max(last->right, right), max(last->bottom, bottom) };
+
+		int64 merged_area = (int64)(merged.right - merged.left) * (merged.bottom - merged.top);
+		int64 separate_area = (int64)(last->right - last->left) * (last->bottom - last->top) + (int64)(right - left) * (bottom - top);
+		if (merged_area <= separate_area) {
+			*last = merged;
+			return;
+		}
+	}
+
+	if (_dirty_tile_areas.Length() >= MAX_DIRTY_TILE_AREAS) FlushDirtyTileAreas();
+
+	Rect *r = _dirty_tile_areas.Append();
+	r->left   = left;
+	r->top    = top;
+	r->right  = right;
+	r->bottom = bottom;
+}
+
 void MarkTileDirtyByTile(TileIndex tile)
 {
+	InvalidateTileDrawCache(tile);
+	InvalidateCatenaryCache(tile);
+	InvalidateSmallMapTile(tile);
+
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, GetTileZ(tile));
-	MarkAllViewportsDirty(
+	AddDirtyTileArea(
 		pt.x - 31,
 		pt.y - 122,
 		pt.x - 31 + 67,
@@ -1729,12 +2424,28 @@ static bool CheckClickOnViewportSign(const ViewPort *vp, int x, int y, const Vie
 			x <  sign->center + sign_half_width;
 }
 
+/**
+ * Find the signs of a kind that might be below the mouse.
+ * @param kind the kind of signs to look for
+ * @param vp the clicked viewport
+ * @param x X position of click
+ * @param y Y position of click
+ */
+static void FindViewportSignsAtClick(ViewportSignKind kind, const ViewPort *vp, int x, int y)
+{
+	x = ScaleByZoom(x - vp->left, vp->zoom) + vp->virtual_left;
+	y = ScaleByZoom(y - vp->top, vp->zoom) + vp->virtual_top;
+
+	FindViewportSigns(kind, x, y, x, y, vp->zoom, _viewport_signs_found);
+}
+
 static bool CheckClickOnTown(const ViewPort *vp, int x, int y)
 {
 	if (!HasBit(_display_opt, DO_SHOW_TOWN_NAMES)) return false;
 
-	const Town *t;
-	FOR_ALL_TOWNS(t) {
+	FindViewportSignsAtClick(VSK_TOWN, vp, x, y);
+	for (const uint16 *index = _viewport_signs_found.Begin(); index != _viewport_signs_found.End(); index++) {
+		const Town *t = Town::Get(*index);
 		if (CheckClickOnViewportSign(vp, x, y, &t->sign)) {
 			ShowTownViewWindow(t->index);
 			return true;
@@ -1748,8 +2459,10 @@ static bool CheckClickOnStation(const ViewPort *vp, int x, int y)
 {
 	if (!(HasBit(_display_opt, DO_SHOW_STATION_NAMES) || HasBit(_display_opt, DO_SHOW_WAYPOINT_NAMES)) || IsInvisibilitySet(TO_SIGNS)) return false;
 
-	const BaseStation *st;
-	FOR_ALL_BASE_STATIONS(st) {
+	FindViewportSignsAtClick(VSK_STATION, vp, x, y);
+	for (const uint16 *index = _viewport_signs_found.Begin(); index != _viewport_signs_found.End(); index++) {
+		const BaseStation *st = BaseStation::Get(*index);
+
 		/* Check whether the base station is a station or a waypoint */
 		bool is_station = Station::IsExpected(st);
 
@@ -1775,8 +2488,9 @@ static bool CheckClickOnSign(const ViewPort *vp, int x, int y)
 	/* Signs are turned off, or they are transparent and invisibility is ON, or company is a spectator */
 	if (!HasBit(_display_opt, DO_SHOW_SIGNS) || IsInvisibilitySet(TO_SIGNS) || _local_company == COMPANY_SPECTATOR) return false;
 
-	const Sign *si;
-	FOR_ALL_SIGNS(si) {
+	FindViewportSignsAtClick(VSK_SIGN, vp, x, y);
+	for (const uint16 *index = _viewport_signs_found.Begin(); index != _viewport_signs_found.End(); index++) {
+		const Sign *si = Sign::Get(*index);
 		if (CheckClickOnViewportSign(vp, x, y, &si->sign)) {
 			HandleClickOnSign(si);
 			return true;
@@ -25,6 +25,7 @@ void SetSelectionRed(bool);
 void DeleteWindowViewport(Window *w);
 void InitializeWindowViewport(Window *w, int x, int y, int width, int height, uint32 follow_flags, ZoomLevel zoom);
 ViewPort *IsPtInWindowViewport(const Window *w, int x, int y);
+bool IsPtInAnyViewport(int x, int y);
 Point GetTileBelowCursor();
 void UpdateViewportPosition(Window *w);
 
@@ -34,6 +35,9 @@ void UpdateViewportPosition(Window *w);
  * @ingroup dirty
  */
 void MarkAllViewportsDirty(int left, int top, int right, int bottom);
+void FlushDirtyTileAreas();
+void ResetTileDrawCache();
+void ViewportLoadDeferredSprites();
 
 bool DoZoomInOutWindow(ZoomStateChange how, Window *w);
 void ZoomInOrOutToCursorWindow(bool in, Window * w);
@@ -53,10 +57,17 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool transparent = false, const SubSprite *sub = NULL);
 void ViewportAddString(const DrawPixelInfo *dpi, ZoomLevel small_from, const ViewportSign *sign, StringID string_normal, StringID string_small, StringID string_small_shadow, uint64 params_1, uint64 params_2 = 0, Colours colour = INVALID_COLOUR);
 
+void AddViewportSignToIndex(ViewportSignKind kind, uint16 index, const ViewportSign *sign);
+void RemoveViewportSignFromIndex(ViewportSignKind kind, uint16 index, const ViewportSign *sign);
+void ResetViewportSignIndex();
+
 
 void StartSpriteCombine();
 void EndSpriteCombine();
 
+bool IsViewportLowDetail();
+void AddVehicleMarkerToDraw(int x, int y, int z, byte colour);
+
 bool HandleViewportClicked(const ViewPort *vp, int x, int y);
 void PlaceObject();
 void SetRedErrorSquare(TileIndex tile);
@@ -40,6 +40,14 @@ enum ViewportSignMargin {
 	VPSM_BOTTOM = 1, ///< Bottom margin
 };
 
+/** The kinds of viewport signs that are kept in the index of viewport signs. */
+enum ViewportSignKind {
+	VSK_TOWN,    ///< The name of a town.
+	VSK_STATION, ///< The name of a station or waypoint.
+	VSK_SIGN,    ///< A sign placed by a player.
+	VSK_END,     ///< End marker.
+};
+
 /** Location information about a sign as seen on the viewport */
 struct ViewportSign {
 	int32 center;        ///< The center position of the sign
@@ -976,6 +976,22 @@ static void DoDryUp(TileIndex tile)
 	cur_company.Restore();
 }
 
+/**
+ * Check whether all eight tiles around a tile are water tiles. Such a tile
+ * has nothing to flood, which is the case for nearly all tiles of the sea.
+ * @param tile The tile to check.
+ * @return true if the tile is not at the map border and only has water around it.
+ */
+static inline bool IsSurroundedByWater(TileIndex tile)
+{
+	if (TileX(tile) == 0 || TileX(tile) >= MapMaxX() || TileY(tile) == 0 || TileY(tile) >= MapMaxY()) return false;
+
+	const TileIndexDiff row = TileDiffXY(0, 1);
+	return IsTileType(tile - row - 1, MP_WATER) && IsTileType(tile - row, MP_WATER) && IsTileType(tile - row + 1, MP_WATER) &&
+			IsTileType(tile - 1, MP_WATER) && IsTileType(tile + 1, MP_WATER) &&
+			IsTileType(tile + row - 1, MP_WATER) && IsTileType(tile + row, MP_WATER) && IsTileType(tile + row + 1, MP_WATER);
+}
+
 /**
  * Let a water tile floods its diagonal adjoining tiles
  * called from tunnelbridge_cmd, and by TileLoop_Industry() and TileLoop_Track()
@@ -986,6 +1002,9 @@ void TileLoop_Water(TileIndex tile)
 {
 	switch (GetFloodingBehaviour(tile)) {
 		case FLOOD_ACTIVE:
+			/* Water tiles are never flooded, so do not bother looking at each neighbour. */
+			if (IsSurroundedByWater(tile)) break;
+
 			for (Direction dir = DIR_BEGIN; dir < DIR_END; dir++) {
 				TileIndex dest = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDir(dir));
 				if (dest == INVALID_TILE) continue;
@@ -15,6 +15,7 @@
 #include "core/math_func.hpp"
 #include "depot_type.h"
 #include "tile_map.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 /** Available water tile types. */
 enum WaterTileType {
@@ -239,6 +240,7 @@ static inline void MakeShore(TileIndex t)
 	_m[t].m5 = 1;
 	SB(_m[t].m6, 2, 4, 0);
 	_me[t].m7 = 0;
+	YapfNotifyWaterLayoutChange(t);
 }
 
 /**
@@ -258,6 +260,7 @@ static inline void MakeWater(TileIndex t, Owner o, WaterClass wc, uint8 random_b
 	_m[t].m5 = 0;
 	SB(_m[t].m6, 2, 4, 0);
 	_me[t].m7 = 0;
+	YapfNotifyWaterLayoutChange(t);
 }
 
 /**
@@ -310,6 +313,7 @@ static inline void MakeShipDepot(TileIndex t, Owner o, DepotID did, DepotPart ba
 	_m[t].m5 = base + a * 2;
 	SB(_m[t].m6, 2, 4, 0);
 	_me[t].m7 = 0;
+	YapfNotifyWaterLayoutChange(t);
 }
 
 /** Make a lock section.
@@ -329,6 +333,7 @@ static inline void MakeLockTile(TileIndex t, Owner o, byte section, WaterClass o
 	_m[t].m5 = section;
 	SB(_m[t].m6, 2, 4, 0);
 	_me[t].m7 = 0;
+	YapfNotifyWaterLayoutChange(t);
 }
 
 /**
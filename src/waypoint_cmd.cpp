@@ -21,6 +21,7 @@
 #include "strings_func.h"
 #include "functions.h"
 #include "window_func.h"
+#include "viewport_func.h"
 #include "date_func.h"
 #include "vehicle_func.h"
 #include "string_func.h"
@@ -38,7 +39,9 @@ void Waypoint::UpdateVirtCoord()
 {
 	Point pt = RemapCoords2(TileX(this->xy) * TILE_SIZE, TileY(this->xy) * TILE_SIZE);
 	SetDParam(0, this->index);
+	RemoveViewportSignFromIndex(VSK_STATION, this->index, &this->sign);
 	this->sign.UpdatePosition(pt.x, pt.y - 0x20, STR_VIEWPORT_WAYPOINT);
+	AddViewportSignToIndex(VSK_STATION, this->index, &this->sign);
 	/* Recenter viewport */
 	InvalidateWindowData(WC_WAYPOINT_VIEW, this->index);
 }
@@ -1666,6 +1666,7 @@ void NWidgetViewport::UpdateViewportCoordinates(Window *w)
 /** Reset the cached dimensions. */
 /* static */ void NWidgetLeaf::InvalidateDimensionCache()
 {
+	if (++dimension_cache_stamp == 0) dimension_cache_stamp = 1;
 	shadebox_dimension.width  = shadebox_dimension.height  = 0;
 	debugbox_dimension.width  = debugbox_dimension.height  = 0;
 	stickybox_dimension.width = stickybox_dimension.height = 0;
@@ -1673,6 +1674,7 @@ void NWidgetViewport::UpdateViewportCoordinates(Window *w)
 	closebox_dimension.width  = closebox_dimension.height  = 0;
 }
 
+uint NWidgetLeaf::dimension_cache_stamp = 1;
 Dimension NWidgetLeaf::shadebox_dimension  = {0, 0};
 Dimension NWidgetLeaf::debugbox_dimension  = {0, 0};
 Dimension NWidgetLeaf::stickybox_dimension = {0, 0};
@@ -1693,6 +1695,7 @@ NWidgetLeaf::NWidgetLeaf(WidgetType tp, Colours colour, int index, uint16 data,
 	if (index >= 0) this->SetIndex(index);
 	this->SetMinimalSize(0, 0);
 	this->SetResize(0, 0);
+	this->text_size_stamp = 0;
 
 	switch (tp) {
 		case WWT_EMPTY:
@@ -1782,6 +1785,28 @@ NWidgetLeaf::NWidgetLeaf(WidgetType tp, Colours colour, int index, uint16 data,
 	}
 }
 
+/**
+ * Get the size of the text of the widget.
+ * A widget without index cannot get string parameters from its window, so its
+ * text only changes size with the language or font; it is measured once and
+ * reused when the window is re-initialised.
+ * @param w Window owning the widget.
+ * @return Size of the text.
+ */
+Dimension NWidgetLeaf::GetTextSize(Window *w)
+{
+	if (this->index >= 0) {
+		w->SetStringParameters(this->index);
+		return GetStringBoundingBox(this->widget_data);
+	}
+
+	if (this->text_size_stamp != NWidgetLeaf::dimension_cache_stamp) {
+		this->text_size = GetStringBoundingBox(this->widget_data);
+		this->text_size_stamp = NWidgetLeaf::dimension_cache_stamp;
+	}
+	return this->text_size;
+}
+
 void NWidgetLeaf::SetupSmallestSize(Window *w, bool init_array)
 {
 	if (this->index >= 0 && init_array) { // Fill w->nested_array[]
@@ -1905,8 +1930,7 @@ void NWidgetLeaf::SetupSmallestSize(Window *w, bool init_array)
 		case WWT_TEXTBTN_2: {
 			static const Dimension extra = {WD_FRAMERECT_LEFT + WD_FRAMERECT_RIGHT,  WD_FRAMERECT_TOP + WD_FRAMERECT_BOTTOM};
 			padding = &extra;
-			if (this->index >= 0) w->SetStringParameters(this->index);
-			Dimension d2 = GetStringBoundingBox(this->widget_data);
+			Dimension d2 = this->GetTextSize(w);
 			d2.width += extra.width;
 			d2.height += extra.height;
 			size = maxdim(size, d2);
@@ -1916,15 +1940,13 @@ void NWidgetLeaf::SetupSmallestSize(Window *w, bool init_array)
 		case WWT_TEXT: {
 			static const Dimension extra = {0, 0};
 			padding = &extra;
-			if (this->index >= 0) w->SetStringParameters(this->index);
-			size = maxdim(size, GetStringBoundingBox(this->widget_data));
+			size = maxdim(size, this->GetTextSize(w));
 			break;
 		}
 		case WWT_CAPTION: {
 			static const Dimension extra = {WD_CAPTIONTEXT_LEFT + WD_CAPTIONTEXT_RIGHT, WD_CAPTIONTEXT_TOP + WD_CAPTIONTEXT_BOTTOM};
 			padding = &extra;
-			if (this->index >= 0) w->SetStringParameters(this->index);
-			Dimension d2 = GetStringBoundingBox(this->widget_data);
+			Dimension d2 = this->GetTextSize(w);
 			d2.width += extra.width;
 			d2.height += extra.height;
 			size = maxdim(size, d2);
@@ -1934,8 +1956,7 @@ void NWidgetLeaf::SetupSmallestSize(Window *w, bool init_array)
 		case NWID_BUTTON_DROPDOWN: {
 			static const Dimension extra = {WD_DROPDOWNTEXT_LEFT + WD_DROPDOWNTEXT_RIGHT, WD_DROPDOWNTEXT_TOP + WD_DROPDOWNTEXT_BOTTOM};
 			padding = &extra;
-			if (this->index >= 0) w->SetStringParameters(this->index);
-			Dimension d2 = GetStringBoundingBox(this->widget_data);
+			Dimension d2 = this->GetTextSize(w);
 			d2.width += extra.width;
 			d2.height += extra.height;
 			size = maxdim(size, d2);
@@ -499,6 +499,12 @@ public:
 
 	static void InvalidateDimensionCache();
 private:
+	Dimension text_size;  ///< Cached size of the text of a widget without index, if #text_size_stamp is current.
+	uint text_size_stamp; ///< Value of #dimension_cache_stamp when #text_size was measured, \c 0 if it never was.
+
+	Dimension GetTextSize(Window *w);
+
+	static uint dimension_cache_stamp;    ///< Changed by #InvalidateDimensionCache, making all cached text sizes outdated.
 	static Dimension shadebox_dimension;  ///< Cached size of a shadebox widget.
 	static Dimension debugbox_dimension;  ///< Cached size of a debugbox widget.
 	static Dimension stickybox_dimension; ///< Cached size of a stickybox widget.
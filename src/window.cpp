@@ -43,6 +43,34 @@ Window *_z_front_window = NULL;
 /** List of windows opened at the screen sorted from the back. */
 Window *_z_back_window  = NULL;
 
+typedef SmallVector<Window *, 4> WindowList; ///< Windows of one class, sorted from the back.
+/** Per window class the opened windows, so lookups need not walk the whole z-array. */
+static WindowList _windows_of_class[WC_END];
+/** Whether the z-array changed since #_windows_of_class was last built. */
+static bool _window_registry_dirty = true;
+
+/**
+ * Get the windows of a given class, rebuilding the registry when the z-array has changed.
+ * Windows that got deleted since then are still listed, so callers must check the class.
+ * @param cls Window class.
+ * @return The windows that had this class when the registry was built, sorted from the back.
+ */
+static const WindowList &GetWindowsOfClass(WindowClass cls)
+{
+	if (_window_registry_dirty) {
+		for (uint i = 0; i < lengthof(_windows_of_class); i++) _windows_of_class[i].Clear();
+
+		Window *w;
+		FOR_ALL_WINDOWS_FROM_BACK(w) {
+			if (w->window_class < WC_END) *_windows_of_class[w->window_class].Append() = w;
+		}
+		_window_registry_dirty = false;
+	}
+
+	static const WindowList _no_windows;
+	return cls < WC_END ? _windows_of_class[cls] : _no_windows;
+}
+
 /*
  * Window that currently has focus. - The main purpose is to generate
  * FocusLost events, not to give next window in z-order focus when a
@@ -666,9 +694,9 @@ Window::~Window()
  */
 Window *FindWindowById(WindowClass cls, WindowNumber number)
 {
-	Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls && w->window_number == number) return w;
+	const WindowList &list = GetWindowsOfClass(cls);
+	for (Window * const *w = list.Begin(); w != list.End(); w++) {
+		if ((*w)->window_class == cls && (*w)->window_number == number) return *w;
 	}
 
 	return NULL;
@@ -682,9 +710,9 @@ Window *FindWindowById(WindowClass cls, WindowNumber number)
  */
 Window *FindWindowByClass(WindowClass cls)
 {
-	Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls) return w;
+	const WindowList &list = GetWindowsOfClass(cls);
+	for (Window * const *w = list.Begin(); w != list.End(); w++) {
+		if ((*w)->window_class == cls) return *w;
 	}
 
 	return NULL;
@@ -711,6 +739,8 @@ void DeleteWindowById(WindowClass cls, WindowNumber number, bool force)
  */
 void DeleteWindowByClass(WindowClass cls)
 {
+	if (GetWindowsOfClass(cls).Length() == 0) return;
+
 	Window *w;
 
 restart_search:
@@ -850,6 +880,7 @@ static void BringWindowToFront(Window *w)
 		v->z_front->z_back = w;
 	}
 	v->z_front = w;
+	_window_registry_dirty = true;
 
 	w->SetDirty();
 }
@@ -933,6 +964,7 @@ void Window::InitializeData(const WindowDesc *desc, WindowNumber window_number)
 		}
 		_z_front_window = this;
 	}
+	_window_registry_dirty = true;
 }
 
 /**
@@ -1304,6 +1336,7 @@ void InitWindowSystem()
 
 	_z_back_window = NULL;
 	_z_front_window = NULL;
+	_window_registry_dirty = true;
 	_focused_window = NULL;
 	_mouseover_last_w = NULL;
 	_scrolling_viewport = false;
@@ -1328,6 +1361,7 @@ void UnInitWindowSystem()
 
 	_z_front_window = NULL;
 	_z_back_window = NULL;
+	_window_registry_dirty = true;
 }
 
 /**
@@ -1944,6 +1978,8 @@ void HandleKeypress(uint32 raw_key)
 	 * But there is no company related window open anyway, so _current_company is not used. */
 	assert(IsGeneratingWorld() || _local_company == _current_company);
 
+	ProcessScheduledInvalidations();
+
 	/* Setup event */
 	uint16 key     = GB(raw_key,  0, 16);
 	uint16 keycode = GB(raw_key, 16, 16);
@@ -2251,7 +2287,7 @@ void HandleMouseEvents()
 			hover_time = _realtime_tick;
 			_mouse_hovering = false;
 		} else {
-			if (hover_time != 0 && _realtime_tick > hover_time + _settings_client.gui.hover_delay * 1000) {
+			if (hover_time != 0 && _realtime_tick - hover_time > _settings_client.gui.hover_delay * 1000u) {
 				click = MC_HOVER;
 				_input_events_this_tick++;
 				_mouse_hovering = true;
@@ -2318,6 +2354,8 @@ void InputLoop()
 	 * But there is no company related window open anyway, so _current_company is not used. */
 	assert(IsGeneratingWorld() || _local_company == _current_company);
 
+	ProcessScheduledInvalidations();
+
 	CheckSoftLimit();
 	HandleKeyScrolling();
 
@@ -2343,6 +2381,7 @@ void InputLoop()
 			w->z_back->z_front = w->z_front;
 		}
 		free(w);
+		_window_registry_dirty = true;
 	}
 
 	DecreaseWindowCounters();
@@ -2359,15 +2398,55 @@ void InputLoop()
 	HandleAutoscroll();
 }
 
+/** Whether the windows missed their tick event because of fast forwarding; they get it when they are drawn. */
+static bool _window_tick_event_skipped = false;
+
 /**
- * Update the continuously changing contents of the windows, such as the viewports
+ * Dispatch WE_TICK event over all windows
  */
-void UpdateWindows()
+static void DispatchWindowTickEvent()
+{
+	if (_scroller_click_timeout > 3) {
+		_scroller_click_timeout -= 3;
+	} else {
+		_scroller_click_timeout = 0;
+	}
+
+	ProcessScheduledInvalidations();
+
+	Window *w;
+	FOR_ALL_WINDOWS_FROM_FRONT(w) {
+		w->OnTick();
+	}
+}
+
+/**
+ * Dispatch WE_TICK event over all windows, once per game tick. While fast
+ * forwarding the event is dispatched once per draw instead, as the windows
+ * tick far more often than anyone can see.
+ */
+void CallWindowTickEvent()
+{
+	if (_fast_forward && !_pause_mode) {
+		_window_tick_event_skipped = true;
+		return;
+	}
+
+	DispatchWindowTickEvent();
+}
+
+/**
+ * Update the windows for a tick of the game, such as their hundredth tick
+ * and their white borders. This runs at the speed of the game.
+ */
+void TickWindows()
 {
 	Window *w;
 	static int we4_timer = 0;
 	int t = we4_timer + 1;
 
+	ProcessScheduledInvalidations();
+
 	if (t >= 100) {
 		FOR_ALL_WINDOWS_FROM_FRONT(w) {
 			w->OnHundredthTick();
@@ -2383,18 +2462,43 @@ void UpdateWindows()
 			if (!(w->flags4 & WF_WHITE_BORDER_MASK)) w->SetDirty();
 		}
 	}
+}
 
-	DrawDirtyBlocks();
+/**
+ * Move the viewports to where they are scrolled to and draw what changed
+ * in the windows. This runs at the refresh rate of the screen, so
+ * scrolling is as smooth as the screen allows.
+ */
+void DrawWindows()
+{
+	if (_window_tick_event_skipped) {
+		_window_tick_event_skipped = false;
+		DispatchWindowTickEvent();
+	}
 
+	Window *w;
 	FOR_ALL_WINDOWS_FROM_BACK(w) {
 		/* Update viewport only if window is not shaded. */
 		if (w->viewport != NULL && !w->IsShaded()) UpdateViewportPosition(w);
 	}
+
+	DrawDirtyBlocks();
+
 	NetworkDrawChatMessage();
 	/* Redraw mouse cursor in case it was hidden */
 	DrawMouseCursor();
 }
 
+/**
+ * Update the continuously changing contents of the windows, such as the
+ * viewports, and draw them; for drivers that draw once every tick.
+ */
+void UpdateWindows()
+{
+	TickWindows();
+	DrawWindows();
+}
+
 /**
  * Mark window as dirty (in need of repainting)
  * @param cls Window class
@@ -2402,9 +2506,9 @@ void UpdateWindows()
  */
 void SetWindowDirty(WindowClass cls, WindowNumber number)
 {
-	const Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls && w->window_number == number) w->SetDirty();
+	const WindowList &list = GetWindowsOfClass(cls);
+	for (Window * const *w = list.Begin(); w != list.End(); w++) {
+		if ((*w)->window_class == cls && (*w)->window_number == number) (*w)->SetDirty();
 	}
 }
 
@@ -2416,10 +2520,10 @@ void SetWindowDirty(WindowClass cls, WindowNumber number)
  */
 void SetWindowWidgetDirty(WindowClass cls, WindowNumber number, byte widget_index)
 {
-	const Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls && w->window_number == number) {
-			w->SetWidgetDirty(widget_index);
+	const WindowList &list = GetWindowsOfClass(cls);
+	for (Window * const *w = list.Begin(); w != list.End(); w++) {
+		if ((*w)->window_class == cls && (*w)->window_number == number) {
+			(*w)->SetWidgetDirty(widget_index);
 		}
 	}
 }
@@ -2430,9 +2534,25 @@ void SetWindowWidgetDirty(WindowClass cls, WindowNumber number, byte widget_inde
  */
 void SetWindowClassesDirty(WindowClass cls)
 {
-	Window *w;
-	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls) w->SetDirty();
+	const WindowList &list = GetWindowsOfClass(cls);
+	for (Window * const *w = list.Begin(); w != list.End(); w++) {
+		if ((*w)->window_class == cls) (*w)->SetDirty();
+	}
+}
+
+uint _schedule_window_invalidations = 0; ///< Number of active ScheduleInvalidationsScope instances.
+
+/**
+ * Invalidate the data of a window, or schedule it when that is requested.
+ * @param w The window.
+ * @param data The data to invalidate with.
+ */
+static void InvalidateOrScheduleData(Window *w, int data)
+{
+	if (_schedule_window_invalidations == 0 || (w->desc_flags & WDF_IMMEDIATE_INVALIDATE) != 0) {
+		w->InvalidateData(data);
+	} else {
+		w->scheduled_invalidation_data.Include(data);
 	}
 }
 
@@ -2444,9 +2564,12 @@ void SetWindowClassesDirty(WindowClass cls)
  */
 void InvalidateWindowData(WindowClass cls, WindowNumber number, int data)
 {
+	/* The handlers may open or close windows, so only use the registry to bail out early. */
+	if (GetWindowsOfClass(cls).Length() == 0) return;
+
 	Window *w;
 	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls && w->window_number == number) w->InvalidateData(data);
+		if (w->window_class == cls && w->window_number == number) InvalidateOrScheduleData(w, data);
 	}
 }
 
@@ -2457,28 +2580,43 @@ void InvalidateWindowData(WindowClass cls, WindowNumber number, int data)
  */
 void InvalidateWindowClassesData(WindowClass cls, int data)
 {
+	if (GetWindowsOfClass(cls).Length() == 0) return;
+
 	Window *w;
 
 	FOR_ALL_WINDOWS_FROM_BACK(w) {
-		if (w->window_class == cls) w->InvalidateData(data);
+		if (w->window_class == cls) InvalidateOrScheduleData(w, data);
 	}
 }
 
-/**
- * Dispatch WE_TICK event over all windows
- */
-void CallWindowTickEvent()
+/** Deliver the scheduled invalidations of this window, in the order they were first scheduled. */
+void Window::ProcessScheduledInvalidations()
 {
-	if (_scroller_click_timeout > 3) {
-		_scroller_click_timeout -= 3;
-	} else {
-		_scroller_click_timeout = 0;
+	/* The window may delete itself while handling one. */
+	SmallVector<int, 4> data;
+	for (const int *d = this->scheduled_invalidation_data.Begin(); d != this->scheduled_invalidation_data.End(); d++) {
+		*data.Append() = *d;
+	}
+	this->scheduled_invalidation_data.Clear();
+
+	for (const int *d = data.Begin(); d != data.End() && this->window_class != WC_INVALID; d++) {
+		this->InvalidateData(*d);
 	}
+}
+
+/** Deliver the scheduled invalidations of all windows. */
+void ProcessScheduledInvalidations()
+{
+	/* This is done on behalf of the GUI, so whatever the windows invalidate now is delivered immediately. */
+	uint schedule = _schedule_window_invalidations;
+	_schedule_window_invalidations = 0;
 
 	Window *w;
-	FOR_ALL_WINDOWS_FROM_FRONT(w) {
-		w->OnTick();
+	FOR_ALL_WINDOWS_FROM_BACK(w) {
+		if (w->scheduled_invalidation_data.Length() != 0) w->ProcessScheduledInvalidations();
 	}
+
+	_schedule_window_invalidations = schedule;
 }
 
 /**
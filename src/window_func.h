@@ -33,6 +33,22 @@ void InputLoop();
 
 void InvalidateWindowData(WindowClass cls, WindowNumber number, int data = 0);
 void InvalidateWindowClassesData(WindowClass cls, int data = 0);
+void ProcessScheduledInvalidations();
+
+extern uint _schedule_window_invalidations;
+
+/**
+ * While an instance of this exists, invalidations of window data are only
+ * scheduled. They are delivered once, no matter how often the same data was
+ * invalidated, before the windows next handle input, tick or are drawn.
+ * This keeps the costs of the GUI out of the game logic, which often
+ * invalidates the same window many times in a tick.
+ * Windows with #WDF_IMMEDIATE_INVALIDATE still get them immediately.
+ */
+struct ScheduleInvalidationsScope {
+	ScheduleInvalidationsScope() { _schedule_window_invalidations++; }
+	~ScheduleInvalidationsScope() { _schedule_window_invalidations--; }
+};
 
 void DeleteNonVitalWindows();
 void DeleteAllNonVitalWindows();
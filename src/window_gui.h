@@ -13,6 +13,7 @@
 #define WINDOW_GUI_H
 
 #include "core/math_func.hpp"
+#include "core/smallvec_type.hpp"
 #include "vehicle_type.h"
 #include "viewport_type.h"
 #include "company_type.h"
@@ -181,6 +182,7 @@ enum WindowDefaultFlag {
 	WDF_UNCLICK_BUTTONS =   1 << 1, ///< Unclick buttons when the window event times out
 	WDF_MODAL           =   1 << 2, ///< The window is a modal child of some other window, meaning the parent is 'inactive'
 	WDF_NO_FOCUS        =   1 << 3, ///< This window won't get focus/make any other window lose focus when click
+	WDF_IMMEDIATE_INVALIDATE = 1 << 4, ///< Invalidations of the window data by the game logic are not scheduled, @see ScheduleInvalidationsScope
 };
 
 /**
@@ -398,6 +400,8 @@ public:
 
 	Window *parent;                  ///< Parent window.
 	Window *z_front;                 ///< The window in front of us in z-order.
+
+	SmallVector<int, 4> scheduled_invalidation_data; ///< Data of the scheduled invalidations that are not delivered yet, each value once.
 	Window *z_back;                  ///< The window behind us in z-order.
 
 	template <class NWID>
@@ -561,6 +565,8 @@ public:
 		this->OnInvalidateData(data);
 	}
 
+	void ProcessScheduledInvalidations();
+
 	/*** Event handling ***/
 
 	/**
@@ -108,8 +108,10 @@ enum WindowClass {
 	WC_AI_SETTINGS,
 	WC_NEWGRF_INSPECT,
 	WC_SPRITE_ALIGNER,
+	WC_NEWGRF_PROFILE,
 	WC_INDUSTRY_CARGOES,
 
+	WC_END,            ///< End of the valid window classes.
 	WC_INVALID = 0xFFFF
 };
 